@@ -100,13 +100,30 @@ let package = Package(
         // Low-level C hook library
         .target(
             name: "PrivarionHook",
-            dependencies: []
+            dependencies: [],
+            linkerSettings: [
+                .linkedFramework("CoreFoundation")
+            ]
+        ),
+        // Native hook microbenchmarks
+        .executableTarget(
+            name: "PrivarionHookBenchmarks",
+            dependencies: [
+                "PrivarionHook",
+                "PrivarionCore",
+                .product(name: "ArgumentParser", package: "swift-argument-parser")
+            ]
         ),
         // C wrapper for EndpointSecurity framework
         .systemLibrary(
             name: "CEndpointSecurity",
             path: "Sources/CEndpointSecurity"
         ),
+        // Native Endpoint Security AUTH fast path
+        .target(
+            name: "PrivarionESFastPath",
+            dependencies: ["CEndpointSecurity"]
+        ),
         // SwiftUI GUI application target
         .executableTarget(
             name: "PrivarionGUI",
@@ -163,6 +180,7 @@ let package = Package(
                 "PrivarionCore",
                 "PrivarionSharedModels",
                 "CEndpointSecurity",
+                "PrivarionESFastPath",
                 .product(name: "Logging", package: "swift-log"),
                 .product(name: "Collections", package: "swift-collections")
             ],
@@ -209,7 +227,7 @@ let package = Package(
         // Tests for System Extension
         .testTarget(
             name: "PrivarionSystemExtensionTests",
-            dependencies: ["PrivarionSystemExtension", "PrivarionSharedModels"]
+            dependencies: ["PrivarionSystemExtension", "PrivarionESFastPath", "PrivarionSharedModels"]
         ),
         // Tests for Network Extension
         .testTarget(
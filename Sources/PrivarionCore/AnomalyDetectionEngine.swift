@@ -675,6 +675,15 @@ public class AnomalyDetectionEngine {
     private var baselines: [String: BehavioralBaseline] = [:]
     private let baselinesQueue = DispatchQueue(label: "privarion.detection.baselines", attributes: .concurrent)
     
+    /// Streaming estimators per data point source and metric
+    private let streamingBaselines = StreamingBaselineStore()
+    
+    /// Samples a series needs before its baseline is trusted
+    private static let minimumBaselineSamples = 30
+    
+    /// Standard deviations from the baseline mean that count as anomalous
+    private static let baselineDeviationLimit = 3.0
+    
     /// Detection rules
     private var rules: [String: DetectionRule] = [:]
     private let rulesQueue = DispatchQueue(label: "privarion.detection.rules", attributes: .concurrent)
@@ -947,6 +956,7 @@ public class AnomalyDetectionEngine {
         baselinesQueue.async(flags: .barrier) {
             self.baselines.removeAll()
         }
+        streamingBaselines.removeAll()
         statsQueue.async(flags: .barrier) {
             self.detectionStats = InternalDetectionStatistics()
         }
@@ -955,28 +965,58 @@ public class AnomalyDetectionEngine {
     
     /// Analyze data point
     public func analyzeDataPoint(_ dataPoint: DataPoint) -> AnalysisResult {
+        return analyzeBatch([dataPoint])[0]
+    }
+    
+    /// Analyze batch of data points
+    /// Rules are read once per batch and every point is scored against the
+    /// streaming baseline of its source and metric as it stood before the
+    /// batch, so the cost per point does not grow with baseline history.
+    public func analyzeBatch(_ dataPoints: [DataPoint]) -> [AnalysisResult] {
+        guard !dataPoints.isEmpty else { return [] }
         let startTime = Date()
         
-        // Get applicable rules
-        let applicableRules = getRules().filter { rule in
-            rule.enabled && (rule.category == nil || rule.category == dataPoint.category)
+        let enabledRules = getRules().filter { $0.enabled }
+        let scores = streamingBaselines.scoreAndUpdate(dataPoints)
+        let results = zip(dataPoints, scores).map { dataPoint, score in
+            analyze(dataPoint, baseline: score, rules: enabledRules)
         }
         
+        // Update statistics once per batch
+        let anomalyCount = UInt64(results.filter { $0.isAnomaly }.count)
+        let analysisTime = Date().timeIntervalSince(startTime) * 1000 / Double(dataPoints.count)
+        statsQueue.async {
+            self.detectionStats.totalDataPointsAnalyzed += UInt64(dataPoints.count)
+            self.detectionStats.anomaliesDetected += anomalyCount
+            self.detectionStats.averageAnalysisTimeMs = (self.detectionStats.averageAnalysisTimeMs + analysisTime) / 2.0
+        }
+        
+        return results
+    }
+    
+    /// Analyze one data point against the rules and its baseline score
+    private func analyze(_ dataPoint: DataPoint, baseline: StreamingBaselineStore.Score, rules: [DetectionRule]) -> AnalysisResult {
         var triggeredRules: [String] = []
         var maxConfidence = 0.1
         var isAnomaly = false
         
         // Check against rules
-        for rule in applicableRules {
-            let ruleTriggered = evaluateDataPointAgainstRule(dataPoint, rule: rule)
-            if ruleTriggered {
-                triggeredRules.append(rule.id)
-                // Calculate confidence based on deviation from threshold
-                let deviationFactor = calculateDeviationFactor(dataPoint.value, threshold: rule.threshold)
-                let adjustedConfidence = min(1.0, rule.sensitivity + deviationFactor * 0.1)
-                maxConfidence = max(maxConfidence, adjustedConfidence)
-                isAnomaly = true
-            }
+        for rule in rules where rule.category == nil || rule.category == dataPoint.category {
+            guard evaluateDataPointAgainstRule(dataPoint, rule: rule, baseline: baseline) else { continue }
+            triggeredRules.append(rule.id)
+            // Calculate confidence based on deviation from threshold
+            let deviationFactor = calculateDeviationFactor(dataPoint.value, threshold: rule.threshold, baseline: baseline)
+            maxConfidence = max(maxConfidence, min(1.0, rule.sensitivity + deviationFactor * 0.1))
+            isAnomaly = true
+        }
+        
+        // Check against the learned baseline of this source and metric
+        var description = "Data point value outside normal range"
+        if !isAnomaly && baseline.sampleCount >= Self.minimumBaselineSamples
+            && baseline.zScore > Self.baselineDeviationLimit {
+            isAnomaly = true
+            maxConfidence = min(0.99, 1.0 - 1.0 / baseline.zScore)
+            description = "Data point deviates from learned baseline"
         }
         
         // Simple anomaly detection logic for testing (fallback)
@@ -985,34 +1025,31 @@ public class AnomalyDetectionEngine {
             maxConfidence = isAnomaly ? 0.9 : 0.1
         }
         
-        let severity: SeverityLevel = isAnomaly ? .high : .low
-        let description = isAnomaly ? "Data point value outside normal range" : "Data point within normal range"
-        
-        // Update statistics
-        statsQueue.async {
-            self.detectionStats.totalDataPointsAnalyzed += 1
-            if isAnomaly {
-                self.detectionStats.anomaliesDetected += 1
-            }
-        }
-        
-        let analysisTime = Date().timeIntervalSince(startTime) * 1000
-        statsQueue.async {
-            self.detectionStats.averageAnalysisTimeMs = (self.detectionStats.averageAnalysisTimeMs + analysisTime) / 2.0
-        }
-        
         return AnalysisResult(
             isAnomaly: isAnomaly,
             confidence: maxConfidence,
-            severity: severity,
-            description: description,
+            severity: isAnomaly ? .high : .low,
+            description: isAnomaly ? description : "Data point within normal range",
             suggestedActions: isAnomaly ? ["Investigate data source", "Check for errors"] : [],
             triggeredRules: triggeredRules
         )
     }
     
+    /// Baseline mean and standard deviation for deviation rules
+    /// Until a series has enough samples, the assumed constants are used.
+    private func baselineMoments(_ baseline: StreamingBaselineStore.Score) -> (mean: Double, standardDeviation: Double) {
+        guard baseline.sampleCount >= Self.minimumBaselineSamples, baseline.standardDeviation > 0 else {
+            return (50.0, 10.0) // Assume baseline mean is 50 and stddev is 10
+        }
+        return (baseline.mean, baseline.standardDeviation)
+    }
+    
     /// Evaluate data point against specific rule
-    private func evaluateDataPointAgainstRule(_ dataPoint: DataPoint, rule: DetectionRule) -> Bool {
+    private func evaluateDataPointAgainstRule(
+        _ dataPoint: DataPoint,
+        rule: DetectionRule,
+        baseline: StreamingBaselineStore.Score
+    ) -> Bool {
         // Simple evaluation based on threshold
         switch rule.threshold.thresholdOperator {
         case .greaterThan:
@@ -1024,14 +1061,17 @@ public class AnomalyDetectionEngine {
         case .notEqual:
             return abs(dataPoint.value - rule.threshold.value) >= 0.001
         case .deviationFromMean(let factor):
-            // Simple implementation - in real world this would use actual baseline
-            let deviation = abs(dataPoint.value - 50.0) // Assume baseline mean is 50
-            return deviation > (factor * 10.0) // Assume baseline stddev is 10
+            let moments = baselineMoments(baseline)
+            return abs(dataPoint.value - moments.mean) > factor * moments.standardDeviation
         }
     }
     
     /// Calculate deviation factor for confidence adjustment
-    private func calculateDeviationFactor(_ value: Double, threshold: DetectionRule.Threshold) -> Double {
+    private func calculateDeviationFactor(
+        _ value: Double,
+        threshold: DetectionRule.Threshold,
+        baseline: StreamingBaselineStore.Score
+    ) -> Double {
         switch threshold.thresholdOperator {
         case .greaterThan:
             return max(0.0, (value - threshold.value) / threshold.value)
@@ -1042,16 +1082,11 @@ public class AnomalyDetectionEngine {
         case .notEqual:
             return abs(value - threshold.value) / max(abs(threshold.value), 1.0)
         case .deviationFromMean(let factor):
-            let deviation = abs(value - 50.0) // Using assumed baseline mean
-            return deviation / (factor * 10.0)
+            let moments = baselineMoments(baseline)
+            return abs(value - moments.mean) / (factor * moments.standardDeviation)
         }
     }
     
-    /// Analyze batch of data points
-    public func analyzeBatch(_ dataPoints: [DataPoint]) -> [AnalysisResult] {
-        return dataPoints.map { analyzeDataPoint($0) }
-    }
-    
     /// Get detection statistics with detailed structure
     public func getDetectionStatistics() -> DetectionStatistics {
         let activeRulesCount = getRules().filter { $0.enabled }.count
@@ -1363,10 +1398,27 @@ public class AnomalyDetectionEngine {
     }
     
     private func buildBaseline(entityId: String, entityType: BehavioralBaseline.EntityType) {
-        // This would implement actual baseline building from historical data
-        // For now, create a simple baseline
+        // Patterns come from the streaming estimators, so no history is rescanned
+        var patterns = BehavioralBaseline.BehavioralPatterns()
+        var frequencies: [String: BehavioralBaseline.BehavioralPatterns.FrequencyPattern] = [:]
+        for (metric, snapshot) in streamingBaselines.snapshots(source: entityId) where snapshot.sampleCount > 0 {
+            frequencies[metric] = BehavioralBaseline.BehavioralPatterns.FrequencyPattern(
+                mean: snapshot.mean,
+                standardDeviation: snapshot.standardDeviation,
+                minimum: snapshot.minimum,
+                maximum: snapshot.maximum,
+                sampleCount: snapshot.sampleCount
+            )
+        }
+        switch entityType {
+        case .network:
+            patterns.networkConnections = frequencies
+        case .user:
+            patterns.fileAccess = frequencies
+        case .process, .system:
+            patterns.syscallFrequency = frequencies
+        }
         
-        let patterns = BehavioralBaseline.BehavioralPatterns()
         let baseline = BehavioralBaseline(
             entityId: entityId,
             entityType: entityType,
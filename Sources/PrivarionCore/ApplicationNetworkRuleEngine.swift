@@ -18,6 +18,9 @@ internal class ApplicationNetworkRuleEngine {
     /// Application rules cache
     private var rulesCache: [String: ApplicationNetworkRule] = [:]
     
+    /// IP, CIDR and range entries of each rule's lists, compiled for lookup
+    private var addressRules: [String: ApplicationAddressRules] = [:]
+    
     /// Process information cache
     private var processCache: [Int32: ProcessInfo] = [:]
     
@@ -75,11 +78,45 @@ internal class ApplicationNetworkRuleEngine {
         }
     }
     
+    /// Evaluate if a connection to an address should be blocked for a specific client
+    /// Rules apply through the addresses, CIDR prefixes and ranges listed
+    /// among their domains; rules without any are skipped.
+    /// - Parameters:
+    ///   - address: Destination address in binary form
+    ///   - clientConnection: The client connection making the request
+    /// - Returns: True if the connection should be blocked, false otherwise
+    internal func shouldBlockConnection(to address: IPPrefixTree.Address, from clientConnection: NWConnection) -> Bool {
+        return evaluationQueue.sync {
+            do {
+                guard let processInfo = try getProcessInfo(for: clientConnection) else {
+                    return false
+                }
+                
+                let applicableRules = findApplicableRules(for: processInfo)
+                let compiled = cacheQueue.sync { addressRules }
+                
+                for rule in applicableRules.sorted(by: { $0.priority > $1.priority }) {
+                    if let blockDecision = compiled[rule.applicationId]?.evaluate(address, ruleType: rule.ruleType) {
+                        logger.debug("Rule \(rule.applicationId) decided: \(blockDecision ? "BLOCK" : "ALLOW") for address")
+                        return blockDecision
+                    }
+                }
+                return false
+                
+            } catch {
+                logger.error("Error evaluating network rule: \(error)")
+                return false
+            }
+        }
+    }
+    
     /// Add or update an application network rule
     /// - Parameter rule: The rule to add or update
     internal func addRule(_ rule: ApplicationNetworkRule) throws {
+        let compiled = ApplicationAddressRules(rule)
         cacheQueue.async(flags: .barrier) {
             self.rulesCache[rule.applicationId] = rule
+            self.addressRules[rule.applicationId] = compiled
         }
         
         // Persist to configuration
@@ -93,6 +130,7 @@ internal class ApplicationNetworkRuleEngine {
     internal func removeRule(for applicationId: String) throws {
         cacheQueue.async(flags: .barrier) {
             self.rulesCache.removeValue(forKey: applicationId)
+            self.addressRules.removeValue(forKey: applicationId)
         }
         
         // Persist to configuration
@@ -113,9 +151,11 @@ internal class ApplicationNetworkRuleEngine {
     
     private func loadRulesFromConfiguration() {
         let config = configManager.getCurrentConfiguration().modules.networkFilter
+        let compiled = config.applicationRules.compactMapValues { ApplicationAddressRules($0) }
         
         cacheQueue.async(flags: .barrier) {
             self.rulesCache = config.applicationRules
+            self.addressRules = compiled
         }
         
         logger.debug("Loaded \(config.applicationRules.count) application network rules from configuration")
@@ -315,6 +355,36 @@ internal struct ProcessInfo {
     let executablePath: String
 }
 
+/// Address entries of one application rule
+/// Entries that parse as an address, CIDR prefix or range are compiled;
+/// domain entries are left to `shouldBlockQuery`.
+internal struct ApplicationAddressRules {
+    let blocked: IPPrefixTree
+    let allowed: IPPrefixTree
+    
+    init?(_ rule: ApplicationNetworkRule) {
+        let blocked = IPPrefixTree(rules: rule.blockedDomains)
+        let allowed = IPPrefixTree(rules: rule.allowedDomains)
+        guard blocked.prefixCount > 0 || allowed.prefixCount > 0 else {
+            return nil
+        }
+        self.blocked = blocked
+        self.allowed = allowed
+    }
+    
+    /// Block decision for the address, nil if this rule has no say
+    func evaluate(_ address: IPPrefixTree.Address, ruleType: NetworkRuleType) -> Bool? {
+        switch ruleType {
+        case .blocklist:
+            return blocked.contains(address) ? true : nil
+        case .allowlist:
+            return allowed.prefixCount > 0 ? !allowed.contains(address) : nil
+        case .monitor:
+            return nil
+        }
+    }
+}
+
 /// Application network rule engine errors
 internal enum ApplicationNetworkRuleEngineError: Error, LocalizedError {
     case failedToGetProcessInfo(String)
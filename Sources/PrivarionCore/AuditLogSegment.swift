@@ -0,0 +1,911 @@
+import Foundation
+import Logging
+
+// MARK: - Segment Format
+
+/// Binary layout of an audit log segment
+/// A segment is a 64-byte header followed by length-prefixed records. The
+/// header doubles as the segment's index: it holds the span of timestamps
+/// and the event types and severities present, and is rewritten after every
+/// group commit, so a search rules a segment out from its first page.
+/// Records past `indexedLength` were appended after the last header update
+/// (the writer stopped in between) and are scanned without the index.
+///
+/// Header, little-endian: magic "PVAS", version, indexed length, record
+/// count, earliest and latest timestamp, type mask, severity mask, creation
+/// time, then reserved bytes.
+internal enum AuditSegmentFormat {
+    static let magic: UInt32 = 0x5341_5650  // "PVAS"
+    static let version: UInt32 = 1
+    static let headerSize = 64
+    static let fileExtension = "pvas"
+
+    /// Records larger than this are treated as corrupt when reading
+    static let maxRecordSize = 16 << 20
+
+    /// Digits of the zero-padded sequence number in segment names
+    private static let sequenceDigits = 12
+
+    /// File name of a segment: `audit_<sequence>_<UTC time>.pvas`
+    /// The sequence comes first and is zero-padded, so names sort in the
+    /// order segments were opened whatever the clock or time zone did.
+    static func segmentName(sequence: UInt64, createdAt date: Date) -> String {
+        let formatter = DateFormatter()
+        formatter.dateFormat = "yyyyMMdd'T'HHmmss'Z'"
+        formatter.locale = Locale(identifier: "en_US_POSIX")
+        formatter.timeZone = TimeZone(secondsFromGMT: 0)
+        let digits = String(sequence)
+        let padded = String(repeating: "0", count: max(sequenceDigits - digits.count, 0)) + digits
+        return "audit_\(padded)_\(formatter.string(from: date)).\(fileExtension)"
+    }
+
+    /// Sequence number of a segment name, nil for other files
+    static func sequence(ofSegmentNamed name: String) -> UInt64? {
+        let parts = name.split(separator: "_")
+        guard parts.count == 3, parts[0] == "audit", name.hasSuffix(".\(fileExtension)") else {
+            return nil
+        }
+        return UInt64(parts[1])
+    }
+}
+
+// MARK: - Segment Index
+
+/// What a segment holds, as recorded in its header
+internal struct AuditSegmentIndex: Equatable {
+    var recordCount: UInt64 = 0
+    /// Seconds since 1970 of the oldest and newest record
+    var earliest: Double = .infinity
+    var latest: Double = -.infinity
+    /// Bit per `EventType` and `Severity` code present in the segment
+    var typeMask: UInt32 = 0
+    var severityMask: UInt32 = 0
+
+    mutating func add(_ event: AuditLogger.AuditEvent) {
+        let time = event.timestamp.timeIntervalSince1970
+        recordCount += 1
+        earliest = min(earliest, time)
+        latest = max(latest, time)
+        typeMask |= 1 << AuditRecordCodec.code(for: event.eventType)
+        severityMask |= 1 << AuditRecordCodec.code(for: event.severity)
+    }
+
+    /// Whether any record in the segment can match the query
+    func mayContain(_ query: AuditSegmentQuery) -> Bool {
+        return recordCount > 0 && earliest <= query.end && latest >= query.start
+            && typeMask & query.typeMask != 0 && severityMask & query.severityMask != 0
+    }
+}
+
+// MARK: - Query
+
+/// Search criteria, checked against a segment's index, then each record's
+/// fixed prefix, and only then against the decoded event
+internal struct AuditSegmentQuery {
+    let start: Double
+    let end: Double
+    let typeMask: UInt32
+    let severityMask: UInt32
+    let sources: Set<String>
+    let correlationId: String?
+
+    /// Empty type, severity and source lists match everything
+    init(
+        from startDate: Date,
+        to endDate: Date,
+        eventTypes: [AuditLogger.AuditEvent.EventType] = [],
+        severities: [AuditLogger.AuditEvent.Severity] = [],
+        sources: [String] = [],
+        correlationId: String? = nil
+    ) {
+        self.start = startDate.timeIntervalSince1970
+        self.end = endDate.timeIntervalSince1970
+        self.typeMask = eventTypes.isEmpty
+            ? .max
+            : eventTypes.reduce(UInt32(0)) { $0 | 1 << AuditRecordCodec.code(for: $1) }
+        self.severityMask = severities.isEmpty
+            ? .max
+            : severities.reduce(UInt32(0)) { $0 | 1 << AuditRecordCodec.code(for: $1) }
+        self.sources = Set(sources)
+        self.correlationId = correlationId
+    }
+
+    func matchesPrefix(timestamp: Double, typeCode: UInt8, severityCode: UInt8) -> Bool {
+        return timestamp >= start && timestamp <= end
+            && typeMask & (1 << typeCode) != 0 && severityMask & (1 << severityCode) != 0
+    }
+
+    func matches(_ event: AuditLogger.AuditEvent) -> Bool {
+        if !sources.isEmpty && !sources.contains(event.source) {
+            return false
+        }
+        if let correlationId = correlationId, event.correlationId != correlationId {
+            return false
+        }
+        return true
+    }
+}
+
+// MARK: - Record Codec
+
+/// Length-prefixed binary encoding of `AuditEvent`
+/// Record layout: UInt32 payload length, then timestamp (Float64 bits),
+/// type, severity and outcome codes, a presence byte for the optional
+/// parts, the event ID, and the variable fields. Strings are a UInt32 byte
+/// count and UTF-8; an absent optional string has count UInt32.max. The
+/// fixed 12-byte prefix is enough to filter on time, type and severity.
+/// Codes are positions in `allCases`, so enum cases may only be appended.
+internal enum AuditRecordCodec {
+
+    private typealias Event = AuditLogger.AuditEvent
+
+    private static let eventTypes = Event.EventType.allCases
+    private static let severities = Event.Severity.allCases
+    private static let outcomes = Event.Outcome.allCases
+    private static let eventTypeCodes = Dictionary(uniqueKeysWithValues: eventTypes.enumerated().map { ($1, UInt8($0)) })
+    private static let severityCodes = Dictionary(uniqueKeysWithValues: severities.enumerated().map { ($1, UInt8($0)) })
+    private static let outcomeCodes = Dictionary(uniqueKeysWithValues: outcomes.enumerated().map { ($1, UInt8($0)) })
+
+    private static let hasResource: UInt8 = 1 << 0
+    private static let hasUser: UInt8 = 1 << 1
+    private static let hasProcess: UInt8 = 1 << 2
+    private static let hasNetwork: UInt8 = 1 << 3
+    private static let hasCorrelation: UInt8 = 1 << 4
+
+    static let prefixSize = 12
+
+    static func code(for type: AuditLogger.AuditEvent.EventType) -> UInt8 {
+        return eventTypeCodes[type] ?? 0
+    }
+
+    static func code(for severity: AuditLogger.AuditEvent.Severity) -> UInt8 {
+        return severityCodes[severity] ?? 0
+    }
+
+    // MARK: Encoding
+
+    /// Append one record, length prefix included
+    static func appendRecord(_ event: AuditLogger.AuditEvent, to bytes: inout [UInt8]) {
+        let lengthOffset = bytes.count
+        append(UInt32(0), to: &bytes)
+
+        var flags: UInt8 = 0
+        if event.resource != nil { flags |= hasResource }
+        if event.user != nil { flags |= hasUser }
+        if event.process != nil { flags |= hasProcess }
+        if event.network != nil { flags |= hasNetwork }
+        if event.correlationId != nil { flags |= hasCorrelation }
+
+        append(event.timestamp.timeIntervalSince1970.bitPattern, to: &bytes)
+        bytes.append(code(for: event.eventType))
+        bytes.append(code(for: event.severity))
+        bytes.append(outcomeCodes[event.outcome] ?? 0)
+        bytes.append(flags)
+        withUnsafeBytes(of: event.id.uuid) { bytes.append(contentsOf: $0) }
+
+        append(event.source, to: &bytes)
+        append(event.action, to: &bytes)
+        if let resource = event.resource {
+            append(resource, to: &bytes)
+        }
+        if let user = event.user {
+            append(user.uid, to: &bytes)
+            append(user.gid, to: &bytes)
+            appendOptional(user.username, to: &bytes)
+            appendOptional(user.sessionId, to: &bytes)
+        }
+        if let process = event.process {
+            append(UInt32(bitPattern: process.pid), to: &bytes)
+            append(UInt32(bitPattern: process.ppid), to: &bytes)
+            append(process.name, to: &bytes)
+            appendOptional(process.path, to: &bytes)
+            append(UInt32(process.arguments.count), to: &bytes)
+            for argument in process.arguments {
+                append(argument, to: &bytes)
+            }
+            if let environment = process.environment {
+                append(UInt32(environment.count), to: &bytes)
+                appendPairs(environment, to: &bytes)
+            } else {
+                append(UInt32.max, to: &bytes)
+            }
+        }
+        if let network = event.network {
+            append(network.localAddress, to: &bytes)
+            append(network.remoteAddress, to: &bytes)
+            append(UInt64(bitPattern: Int64(network.localPort)), to: &bytes)
+            append(UInt64(bitPattern: Int64(network.remotePort)), to: &bytes)
+            append(network.networkProtocol, to: &bytes)
+            bytes.append(network.dataSize != nil ? 1 : 0)
+            append(network.dataSize ?? 0, to: &bytes)
+        }
+        append(UInt32(event.details.count), to: &bytes)
+        appendPairs(event.details, to: &bytes)
+        if let correlationId = event.correlationId {
+            append(correlationId, to: &bytes)
+        }
+
+        let length = UInt32(bytes.count - lengthOffset - 4).littleEndian
+        withUnsafeBytes(of: length) { length in
+            for index in 0..<4 {
+                bytes[lengthOffset + index] = length[index]
+            }
+        }
+    }
+
+    private static func append<T: FixedWidthInteger>(_ value: T, to bytes: inout [UInt8]) {
+        withUnsafeBytes(of: value.littleEndian) { bytes.append(contentsOf: $0) }
+    }
+
+    private static func append(_ string: String, to bytes: inout [UInt8]) {
+        let lengthOffset = bytes.count
+        append(UInt32(0), to: &bytes)
+        bytes.append(contentsOf: string.utf8)
+        let length = UInt32(bytes.count - lengthOffset - 4).littleEndian
+        withUnsafeBytes(of: length) { length in
+            for index in 0..<4 {
+                bytes[lengthOffset + index] = length[index]
+            }
+        }
+    }
+
+    private static func appendOptional(_ string: String?, to bytes: inout [UInt8]) {
+        if let string = string {
+            append(string, to: &bytes)
+        } else {
+            append(UInt32.max, to: &bytes)
+        }
+    }
+
+    private static func appendPairs(_ pairs: [String: String], to bytes: inout [UInt8]) {
+        for (key, value) in pairs {
+            append(key, to: &bytes)
+            append(value, to: &bytes)
+        }
+    }
+
+    // MARK: Decoding
+
+    /// Reads one record payload; every read is bounds-checked
+    struct Cursor {
+        let bytes: UnsafeRawBufferPointer
+        var offset: Int
+        let end: Int
+
+        init(_ bytes: UnsafeRawBufferPointer, from offset: Int, to end: Int) {
+            self.bytes = bytes
+            self.offset = offset
+            self.end = end
+        }
+
+        mutating func read<T: FixedWidthInteger>(_ type: T.Type) throws -> T {
+            let size = MemoryLayout<T>.size
+            guard end - offset >= size else {
+                throw AuditLogger.AuditError.storageError("Truncated audit record at byte \(offset)")
+            }
+            let value = T(littleEndian: bytes.loadUnaligned(fromByteOffset: offset, as: T.self))
+            offset += size
+            return value
+        }
+
+        mutating func readOptionalString() throws -> String? {
+            let length = try read(UInt32.self)
+            if length == .max {
+                return nil
+            }
+            guard end - offset >= Int(length) else {
+                throw AuditLogger.AuditError.storageError("Truncated audit string at byte \(offset)")
+            }
+            let string = String(decoding: UnsafeRawBufferPointer(rebasing: bytes[offset..<offset + Int(length)]), as: UTF8.self)
+            offset += Int(length)
+            return string
+        }
+
+        mutating func readString() throws -> String {
+            guard let string = try readOptionalString() else {
+                throw AuditLogger.AuditError.storageError("Missing audit string at byte \(offset)")
+            }
+            return string
+        }
+
+        mutating func readUUID() throws -> UUID {
+            guard end - offset >= 16 else {
+                throw AuditLogger.AuditError.storageError("Truncated audit event ID at byte \(offset)")
+            }
+            var uuid: uuid_t = (0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0)
+            withUnsafeMutableBytes(of: &uuid) { target in
+                target.copyMemory(from: UnsafeRawBufferPointer(rebasing: bytes[offset..<offset + 16]))
+            }
+            offset += 16
+            return UUID(uuid: uuid)
+        }
+
+        mutating func readPairs(_ count: UInt32) throws -> [String: String] {
+            var pairs: [String: String] = [:]
+            pairs.reserveCapacity(Int(min(count, 1024)))
+            for _ in 0..<count {
+                let key = try readString()
+                pairs[key] = try readString()
+            }
+            return pairs
+        }
+    }
+
+    /// Decode a record payload starting at its fixed prefix
+    static func decode(_ cursor: inout Cursor) throws -> AuditLogger.AuditEvent {
+        let timestamp = Double(bitPattern: try cursor.read(UInt64.self))
+        let typeCode = Int(try cursor.read(UInt8.self))
+        let severityCode = Int(try cursor.read(UInt8.self))
+        let outcomeCode = Int(try cursor.read(UInt8.self))
+        let flags = try cursor.read(UInt8.self)
+        guard typeCode < eventTypes.count, severityCode < severities.count, outcomeCode < outcomes.count else {
+            throw AuditLogger.AuditError.storageError("Unknown audit record code at byte \(cursor.offset)")
+        }
+
+        let id = try cursor.readUUID()
+        let source = try cursor.readString()
+        let action = try cursor.readString()
+        let resource = try flags & hasResource != 0 ? cursor.readString() : nil
+
+        var user: Event.UserContext?
+        if flags & hasUser != 0 {
+            user = Event.UserContext(
+                uid: try cursor.read(UInt32.self),
+                gid: try cursor.read(UInt32.self),
+                username: try cursor.readOptionalString(),
+                sessionId: try cursor.readOptionalString()
+            )
+        }
+
+        var process: Event.ProcessContext?
+        if flags & hasProcess != 0 {
+            let pid = Int32(bitPattern: try cursor.read(UInt32.self))
+            let ppid = Int32(bitPattern: try cursor.read(UInt32.self))
+            let name = try cursor.readString()
+            let path = try cursor.readOptionalString()
+            let argumentCount = try cursor.read(UInt32.self)
+            var arguments: [String] = []
+            arguments.reserveCapacity(Int(min(argumentCount, 1024)))
+            for _ in 0..<argumentCount {
+                arguments.append(try cursor.readString())
+            }
+            let environmentCount = try cursor.read(UInt32.self)
+            let environment = try environmentCount == .max ? nil : cursor.readPairs(environmentCount)
+            process = Event.ProcessContext(pid: pid, ppid: ppid, name: name, path: path,
+                                           arguments: arguments, environment: environment)
+        }
+
+        var network: Event.NetworkContext?
+        if flags & hasNetwork != 0 {
+            let localAddress = try cursor.readString()
+            let remoteAddress = try cursor.readString()
+            let localPort = Int(Int64(bitPattern: try cursor.read(UInt64.self)))
+            let remotePort = Int(Int64(bitPattern: try cursor.read(UInt64.self)))
+            let networkProtocol = try cursor.readString()
+            let hasDataSize = try cursor.read(UInt8.self) != 0
+            let dataSize = try cursor.read(UInt64.self)
+            network = Event.NetworkContext(localAddress: localAddress, remoteAddress: remoteAddress,
+                                           localPort: localPort, remotePort: remotePort,
+                                           networkProtocol: networkProtocol,
+                                           dataSize: hasDataSize ? dataSize : nil)
+        }
+
+        let detailCount = try cursor.read(UInt32.self)
+        let details = try cursor.readPairs(detailCount)
+        let correlationId = try flags & hasCorrelation != 0 ? cursor.readString() : nil
+
+        return Event(
+            id: id,
+            timestamp: Date(timeIntervalSince1970: timestamp),
+            eventType: eventTypes[typeCode],
+            severity: severities[severityCode],
+            source: source,
+            action: action,
+            resource: resource,
+            user: user,
+            process: process,
+            network: network,
+            outcome: outcomes[outcomeCode],
+            details: details,
+            correlationId: correlationId
+        )
+    }
+}
+
+// MARK: - Segment Writer
+
+/// Appends audit events to binary segments from a dedicated writer thread
+/// Producers hand events to a bounded queue and only block while it is
+/// full. The writer thread takes everything queued at once, encodes it into
+/// one buffer and commits it with a single write, header update and fsync,
+/// so the cost of a commit is shared by every event that arrived while the
+/// previous one was in flight.
+internal final class AuditSegmentWriter: @unchecked Sendable {
+
+    private let directory: URL
+    private let maxSegmentBytes: Int
+    private let queueCapacity: Int
+    private let logger = Logger(label: "privarion.audit.segments")
+
+    // Shared with producers, guarded by condition
+    private let condition = NSCondition()
+    private var pending: [AuditLogger.AuditEvent] = []
+    private var appendedCount: UInt64 = 0
+    private var committedCount: UInt64 = 0
+    private var droppedCount: UInt64 = 0
+    private var rotationRequested = false
+    private var rotationCount: UInt64 = 0
+    private var stopping = false
+    private var stopped = false
+    private var segmentURL: URL?
+
+    // Owned by the writer thread once it runs
+    private var descriptor: Int32 = -1
+    private var segmentLength = 0
+    private var index = AuditSegmentIndex()
+    private var createdAt: Double = 0
+    private var buffer: [UInt8] = []
+    private var nextSequence: UInt64
+
+    /// Open a new segment in `directory` and start the writer thread
+    /// - Parameters:
+    ///   - maxSegmentBytes: Size after which the writer continues in a new segment
+    ///   - queueCapacity: Events queued before producers block
+    init(directory: URL, maxSegmentBytes: Int, queueCapacity: Int = 4096) throws {
+        self.directory = directory
+        self.maxSegmentBytes = max(maxSegmentBytes, AuditSegmentFormat.headerSize + 1)
+        self.queueCapacity = max(queueCapacity, 1)
+        self.nextSequence = Self.sequence(after: directory)
+        try openSegment()
+
+        let thread = Thread { [self] in
+            self.run()
+        }
+        thread.name = "privarion.audit.writer"
+        thread.qualityOfService = .utility
+        thread.start()
+    }
+
+    /// Segment currently being written
+    var currentSegmentURL: URL? {
+        condition.lock()
+        defer { condition.unlock() }
+        return segmentURL
+    }
+
+    /// Queue an event, blocking while the queue is full
+    /// - Returns: false if the writer has been closed
+    @discardableResult
+    func append(_ event: AuditLogger.AuditEvent) -> Bool {
+        condition.lock()
+        defer { condition.unlock() }
+
+        while pending.count >= queueCapacity && !stopping {
+            condition.wait()
+        }
+        guard !stopping else { return false }
+        pending.append(event)
+        appendedCount += 1
+        condition.broadcast()
+        return true
+    }
+
+    /// Block until every event appended so far has been committed
+    /// - Throws: `AuditError.storageError` if events were dropped because a
+    ///   commit failed since the last call reported it
+    func sync() throws {
+        condition.lock()
+        defer { condition.unlock() }
+
+        let target = appendedCount
+        while committedCount < target && !stopped {
+            condition.wait()
+        }
+        guard droppedCount == 0 else {
+            let dropped = droppedCount
+            droppedCount = 0
+            throw AuditLogger.AuditError.storageError("\(dropped) audit events could not be written")
+        }
+    }
+
+    /// Seal the current segment and continue in a new one
+    /// Returns once the new segment is open; events appended before the
+    /// call may land in either segment.
+    func rotate() {
+        condition.lock()
+        defer { condition.unlock() }
+
+        guard !stopping else { return }
+        let target = rotationCount + 1
+        rotationRequested = true
+        condition.broadcast()
+        while rotationCount < target && !stopped {
+            condition.wait()
+        }
+    }
+
+    /// Commit everything queued, seal the segment and stop the writer thread
+    func close() {
+        condition.lock()
+        defer { condition.unlock() }
+
+        stopping = true
+        condition.broadcast()
+        while !stopped {
+            condition.wait()
+        }
+    }
+
+    // MARK: Writer Thread
+
+    private func run() {
+        condition.lock()
+        while true {
+            while pending.isEmpty && !rotationRequested && !stopping {
+                condition.wait()
+            }
+
+            let batch = pending
+            pending.removeAll(keepingCapacity: true)
+            let target = appendedCount
+            let rotate = rotationRequested
+            let stop = stopping
+            rotationRequested = false
+            // Producers waiting on a full queue refill it while this batch is written
+            condition.broadcast()
+            condition.unlock()
+
+            let committed = batch.isEmpty || commit(batch)
+            if stop {
+                closeSegment()
+            } else if rotate || segmentLength >= maxSegmentBytes {
+                rotateSegment()
+            }
+
+            condition.lock()
+            committedCount = target
+            if !committed {
+                droppedCount += UInt64(batch.count)
+            }
+            if rotate {
+                rotationCount += 1
+            }
+            if stop {
+                stopped = true
+                condition.broadcast()
+                condition.unlock()
+                return
+            }
+            condition.broadcast()
+        }
+    }
+
+    /// Write a batch to the current segment
+    /// - Returns: false if the batch was dropped
+    private func commit(_ batch: [AuditLogger.AuditEvent]) -> Bool {
+        guard descriptor >= 0 else {
+            logger.error("Dropping audit events without an open segment", metadata: ["count": "\(batch.count)"])
+            return false
+        }
+
+        buffer.removeAll(keepingCapacity: true)
+        var batchIndex = index
+        for event in batch {
+            AuditRecordCodec.appendRecord(event, to: &buffer)
+            batchIndex.add(event)
+        }
+
+        guard write(buffer, at: segmentLength) else {
+            logger.error("Failed to write audit events", metadata: [
+                "count": "\(batch.count)",
+                "error": "\(String(cString: strerror(errno)))"
+            ])
+            return false
+        }
+        segmentLength += buffer.count
+        index = batchIndex
+        // Readers scan records past a stale index, so the batch still counts
+        if !writeHeader() {
+            logger.error("Failed to update audit segment index", metadata: ["error": "\(String(cString: strerror(errno)))"])
+        }
+        // Written but not durable is as lost as not written for an audit trail
+        guard fsync(descriptor) == 0 else {
+            logger.error("Failed to sync audit events", metadata: [
+                "count": "\(batch.count)",
+                "error": "\(String(cString: strerror(errno)))"
+            ])
+            return false
+        }
+        return true
+    }
+
+    private func rotateSegment() {
+        closeSegment()
+        do {
+            try openSegment()
+        } catch {
+            logger.error("Failed to rotate audit segment", metadata: ["error": "\(error.localizedDescription)"])
+        }
+    }
+
+    private func openSegment() throws {
+        let now = Date()
+        var url = directory.appendingPathComponent(AuditSegmentFormat.segmentName(sequence: nextSequence, createdAt: now))
+        var fd = open(url.path, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0o600)
+        // Another writer took the number; the directory is the authority
+        if fd < 0 && errno == EEXIST {
+            nextSequence = max(nextSequence + 1, Self.sequence(after: directory))
+            url = directory.appendingPathComponent(AuditSegmentFormat.segmentName(sequence: nextSequence, createdAt: now))
+            fd = open(url.path, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0o600)
+        }
+        guard fd >= 0 else {
+            throw AuditLogger.AuditError.storageError(
+                "Failed to create audit segment \(url.lastPathComponent): \(String(cString: strerror(errno)))")
+        }
+
+        descriptor = fd
+        nextSequence += 1
+        segmentLength = AuditSegmentFormat.headerSize
+        index = AuditSegmentIndex()
+        createdAt = now.timeIntervalSince1970
+        guard writeHeader() else {
+            let reason = String(cString: strerror(errno))
+            Darwin.close(fd)
+            descriptor = -1
+            throw AuditLogger.AuditError.storageError("Failed to write audit segment header: \(reason)")
+        }
+
+        condition.lock()
+        segmentURL = url
+        condition.unlock()
+    }
+
+    private func closeSegment() {
+        guard descriptor >= 0 else { return }
+        fsync(descriptor)
+        Darwin.close(descriptor)
+        descriptor = -1
+    }
+
+    private func writeHeader() -> Bool {
+        var header: [UInt8] = []
+        header.reserveCapacity(AuditSegmentFormat.headerSize)
+
+        func append<T: FixedWidthInteger>(_ value: T) {
+            withUnsafeBytes(of: value.littleEndian) { header.append(contentsOf: $0) }
+        }
+
+        append(AuditSegmentFormat.magic)
+        append(AuditSegmentFormat.version)
+        append(UInt64(segmentLength))
+        append(index.recordCount)
+        append(index.earliest.bitPattern)
+        append(index.latest.bitPattern)
+        append(index.typeMask)
+        append(index.severityMask)
+        append(createdAt.bitPattern)
+        header.append(contentsOf: repeatElement(0, count: AuditSegmentFormat.headerSize - header.count))
+        return write(header, at: 0)
+    }
+
+    private func write(_ bytes: [UInt8], at offset: Int) -> Bool {
+        return bytes.withUnsafeBytes { buffer in
+            guard let base = buffer.baseAddress else { return true }
+            var written = 0
+            while written < buffer.count {
+                let result = pwrite(descriptor, base + written, buffer.count - written, off_t(offset + written))
+                if result < 0 {
+                    if errno == EINTR {
+                        continue
+                    }
+                    return false
+                }
+                written += result
+            }
+            return true
+        }
+    }
+
+    /// Sequence number following every segment already in `directory`
+    private static func sequence(after directory: URL) -> UInt64 {
+        let names: [String]
+        do {
+            names = try FileManager.default.contentsOfDirectory(atPath: directory.path)
+        } catch {
+            // Opening the segment reports the unusable directory
+            return 0
+        }
+        return names.compactMap(AuditSegmentFormat.sequence(ofSegmentNamed:)).max().map { $0 + 1 } ?? 0
+    }
+}
+
+// MARK: - Segment Reader
+
+/// Memory-mapped view of one audit segment
+internal struct AuditSegmentReader {
+
+    let url: URL
+    let index: AuditSegmentIndex
+    /// End of the records covered by the index
+    let indexedLength: Int
+    private let data: Data
+    private static let logger = Logger(label: "privarion.audit.segments")
+
+    init(contentsOf url: URL) throws {
+        let data: Data
+        do {
+            data = try Data(contentsOf: url, options: .alwaysMapped)
+        } catch {
+            throw AuditLogger.AuditError.storageError("Cannot read audit segment \(url.lastPathComponent): \(error.localizedDescription)")
+        }
+        guard data.count >= AuditSegmentFormat.headerSize else {
+            throw AuditLogger.AuditError.storageError("Audit segment \(url.lastPathComponent) is shorter than its header")
+        }
+
+        let header = try data.withUnsafeBytes { bytes -> (Int, AuditSegmentIndex) in
+            var cursor = AuditRecordCodec.Cursor(bytes, from: 0, to: AuditSegmentFormat.headerSize)
+            guard try cursor.read(UInt32.self) == AuditSegmentFormat.magic else {
+                throw AuditLogger.AuditError.storageError("Audit segment \(url.lastPathComponent) has a bad magic")
+            }
+            let version = try cursor.read(UInt32.self)
+            guard version == AuditSegmentFormat.version else {
+                throw AuditLogger.AuditError.storageError("Unsupported audit segment version \(version)")
+            }
+            let indexedLength = try cursor.read(UInt64.self)
+            var index = AuditSegmentIndex()
+            index.recordCount = try cursor.read(UInt64.self)
+            index.earliest = Double(bitPattern: try cursor.read(UInt64.self))
+            index.latest = Double(bitPattern: try cursor.read(UInt64.self))
+            index.typeMask = try cursor.read(UInt32.self)
+            index.severityMask = try cursor.read(UInt32.self)
+            return (Int(clamping: indexedLength), index)
+        }
+
+        self.url = url
+        self.data = data
+        // A header written ahead of its records never points past the file
+        self.indexedLength = min(max(header.0, AuditSegmentFormat.headerSize), data.count)
+        self.index = header.1
+    }
+
+    /// Whether records were appended after the header was last updated
+    var hasUnindexedRecords: Bool {
+        return data.count > indexedLength
+    }
+
+    /// Whether the segment needs to be read for the query at all
+    func mayContain(_ query: AuditSegmentQuery) -> Bool {
+        return hasUnindexedRecords || index.mayContain(query)
+    }
+
+    /// Call `body` with each matching event in append order, until it returns false
+    /// Records are filtered on their fixed prefix before being decoded; a
+    /// truncated or corrupt record ends the scan, keeping the events before it.
+    /// - Returns: false if `body` stopped the scan
+    @discardableResult
+    func forEachEvent(matching query: AuditSegmentQuery, _ body: (AuditLogger.AuditEvent) -> Bool) -> Bool {
+        // Indexed records cannot match if the index rules them out
+        let start = index.mayContain(query) ? AuditSegmentFormat.headerSize : indexedLength
+
+        return data.withUnsafeBytes { bytes -> Bool in
+            var offset = start
+            while bytes.count - offset >= 4 {
+                let length = Int(UInt32(littleEndian: bytes.loadUnaligned(fromByteOffset: offset, as: UInt32.self)))
+                let payload = offset + 4
+                guard length >= AuditRecordCodec.prefixSize,
+                      length <= AuditSegmentFormat.maxRecordSize,
+                      bytes.count - payload >= length else {
+                    break
+                }
+                offset = payload + length
+
+                let timestamp = Double(bitPattern: UInt64(littleEndian: bytes.loadUnaligned(fromByteOffset: payload, as: UInt64.self)))
+                let typeCode = bytes[payload + 8]
+                let severityCode = bytes[payload + 9]
+                guard query.matchesPrefix(timestamp: timestamp, typeCode: typeCode, severityCode: severityCode) else {
+                    continue
+                }
+
+                var cursor = AuditRecordCodec.Cursor(bytes, from: payload, to: payload + length)
+                let event: AuditLogger.AuditEvent
+                do {
+                    event = try AuditRecordCodec.decode(&cursor)
+                } catch {
+                    Self.logger.warning("Audit segment scan stopped at a corrupt record", metadata: [
+                        "file": "\(url.lastPathComponent)",
+                        "offset": "\(payload - 4)",
+                        "error": "\(error.localizedDescription)"
+                    ])
+                    break
+                }
+                if query.matches(event) && !body(event) {
+                    return false
+                }
+            }
+            return true
+        }
+    }
+}
+
+// MARK: - Export
+
+/// Renders decoded audit events for export; the only place records become text
+internal enum AuditEventExporter {
+
+    static func export(_ events: [AuditLogger.AuditEvent], format: AuditLogger.AuditConfiguration.ExportFormat) throws -> Data {
+        switch format {
+        case .json:
+            let encoder = JSONEncoder()
+            encoder.dateEncodingStrategy = .iso8601
+            encoder.outputFormatting = [.sortedKeys]
+            return try encoder.encode(events)
+        case .csv:
+            return Data(csv(events).utf8)
+        case .xml:
+            return Data(xml(events).utf8)
+        }
+    }
+
+    private static let columns = ["id", "timestamp", "eventType", "severity", "source", "action",
+                                  "resource", "outcome", "correlationId", "details"]
+
+    private static func csv(_ events: [AuditLogger.AuditEvent]) -> String {
+        let formatter = ISO8601DateFormatter()
+        var output = columns.joined(separator: ",") + "\n"
+        for event in events {
+            let details = event.details.sorted { $0.key < $1.key }.map { "\($0.key)=\($0.value)" }.joined(separator: ";")
+            let fields = [
+                event.id.uuidString,
+                formatter.string(from: event.timestamp),
+                event.eventType.rawValue,
+                event.severity.rawValue,
+                event.source,
+                event.action,
+                event.resource ?? "",
+                event.outcome.rawValue,
+                event.correlationId ?? "",
+                details
+            ]
+            output += fields.map(csvField).joined(separator: ",") + "\n"
+        }
+        return output
+    }
+
+    private static func csvField(_ field: String) -> String {
+        guard field.contains(where: { $0 == "," || $0 == "\"" || $0 == "\n" || $0 == "\r" }) else {
+            return field
+        }
+        return "\"" + field.replacingOccurrences(of: "\"", with: "\"\"") + "\""
+    }
+
+    private static func xml(_ events: [AuditLogger.AuditEvent]) -> String {
+        let formatter = ISO8601DateFormatter()
+        var output = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<auditEvents>\n"
+        for event in events {
+            output += "  <event id=\"\(event.id.uuidString)\" timestamp=\"\(formatter.string(from: event.timestamp))\""
+            output += " type=\"\(event.eventType.rawValue)\" severity=\"\(event.severity.rawValue)\""
+            output += " outcome=\"\(event.outcome.rawValue)\">\n"
+            output += "    <source>\(xmlEscaped(event.source))</source>\n"
+            output += "    <action>\(xmlEscaped(event.action))</action>\n"
+            if let resource = event.resource {
+                output += "    <resource>\(xmlEscaped(resource))</resource>\n"
+            }
+            if let correlationId = event.correlationId {
+                output += "    <correlationId>\(xmlEscaped(correlationId))</correlationId>\n"
+            }
+            for (key, value) in event.details.sorted(by: { $0.key < $1.key }) {
+                output += "    <detail key=\"\(xmlEscaped(key))\">\(xmlEscaped(value))</detail>\n"
+            }
+            output += "  </event>\n"
+        }
+        return output + "</auditEvents>\n"
+    }
+
+    private static func xmlEscaped(_ text: String) -> String {
+        return text
+            .replacingOccurrences(of: "&", with: "&amp;")
+            .replacingOccurrences(of: "<", with: "&lt;")
+            .replacingOccurrences(of: ">", with: "&gt;")
+            .replacingOccurrences(of: "\"", with: "&quot;")
+    }
+}
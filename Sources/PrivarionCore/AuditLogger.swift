@@ -137,8 +137,41 @@ public class AuditLogger {
             details: [String: String] = [:],
             correlationId: String? = nil
         ) {
-            self.id = UUID()
-            self.timestamp = Date()
+            self.init(
+                id: UUID(),
+                timestamp: Date(),
+                eventType: eventType,
+                severity: severity,
+                source: source,
+                action: action,
+                resource: resource,
+                user: user,
+                process: process,
+                network: network,
+                outcome: outcome,
+                details: details,
+                correlationId: correlationId
+            )
+        }
+        
+        /// Rebuild a stored event with its original identity and time
+        internal init(
+            id: UUID,
+            timestamp: Date,
+            eventType: EventType,
+            severity: Severity,
+            source: String,
+            action: String,
+            resource: String?,
+            user: UserContext?,
+            process: ProcessContext?,
+            network: NetworkContext?,
+            outcome: Outcome,
+            details: [String: String],
+            correlationId: String?
+        ) {
+            self.id = id
+            self.timestamp = timestamp
             self.eventType = eventType
             self.severity = severity
             self.source = source
@@ -248,11 +281,10 @@ public class AuditLogger {
     /// Event queue for async processing
     private let eventQueue = DispatchQueue(label: "privarion.audit.events", qos: .utility)
     
-    /// File handling
+    /// File handling; the segment writer is only swapped on eventQueue
     private let fileManager = FileManager.default
     private let auditDirectoryURL: URL
-    private var currentLogFileURL: URL?
-    private var currentFileHandle: FileHandle?
+    private var segmentWriter: AuditSegmentWriter?
     
     /// Event correlation
     private var correlationMap: [String: [UUID]] = [:]
@@ -310,8 +342,8 @@ public class AuditLogger {
     public func configure(_ config: AuditConfiguration) throws {
         self.configuration = config
         
-        // Restart file logging if needed
-        if config.destinations.contains(.file) {
+        // Restart file logging, or stop it if files are no longer a destination
+        try eventQueue.sync {
             try setupFileLogging()
         }
         
@@ -488,17 +520,56 @@ public class AuditLogger {
         correlationId: String? = nil,
         limit: Int = 1000
     ) throws -> [AuditEvent] {
+        guard limit > 0 else { return [] }
+        
+        // Events logged before this call reach the writer in order on
+        // eventQueue; wait until they are committed so the search sees them
+        let writer = eventQueue.sync { segmentWriter }
+        try writer?.sync()
+        
+        let query = AuditSegmentQuery(
+            from: startDate,
+            to: endDate,
+            eventTypes: eventTypes,
+            severities: severities,
+            sources: sources,
+            correlationId: correlationId
+        )
+        
+        var results: [AuditEvent] = []
+        var skippedSegments = 0
+        for url in try segmentURLs() {
+            do {
+                let segment = try AuditSegmentReader(contentsOf: url)
+                // The header index rules most segments out without reading a record
+                guard segment.mayContain(query) else {
+                    skippedSegments += 1
+                    continue
+                }
+                segment.forEachEvent(matching: query) { event in
+                    results.append(event)
+                    return results.count < limit
+                }
+            } catch {
+                logger.warning("Skipping unreadable audit segment", metadata: [
+                    "file": "\(url.lastPathComponent)",
+                    "error": "\(error.localizedDescription)"
+                ])
+            }
+            if results.count >= limit {
+                break
+            }
+        }
         
-        // This would implement actual search functionality
-        // For now, return empty array as placeholder
-        logger.info("Searching audit events", metadata: [
+        logger.debug("Searched audit events", metadata: [
             "start_date": "\(startDate)",
             "end_date": "\(endDate)",
             "types": "\(eventTypes.map { $0.rawValue })",
-            "limit": "\(limit)"
+            "skipped_segments": "\(skippedSegments)",
+            "results": "\(results.count)"
         ])
         
-        return []
+        return results
     }
     
     /// Export audit events to file
@@ -516,7 +587,14 @@ public class AuditLogger {
             "destination": "\(destination.path)"
         ])
         
-        // Implementation would go here
+        // Records stay binary on disk; text is only produced here
+        let events = try searchEvents(from: startDate, to: endDate, limit: .max)
+        do {
+            let data = try AuditEventExporter.export(events, format: format)
+            try data.write(to: destination, options: .atomic)
+        } catch {
+            throw AuditError.storageError("Failed to export audit events: \(error.localizedDescription)")
+        }
     }
     
     /// Force flush cached events
@@ -554,44 +632,36 @@ public class AuditLogger {
     }
     
     private func setupFileLogging() throws {
-        guard configuration.destinations.contains(.file) else { return }
-        
-        // Close current file handle if open
-        currentFileHandle?.closeFile()
+        // Seal the segment being written, committing what is queued
+        segmentWriter?.close()
+        segmentWriter = nil
         
-        // Create new log file
-        let dateFormatter = DateFormatter()
-        dateFormatter.dateFormat = "yyyyMMdd_HHmmss"
-        let timestamp = dateFormatter.string(from: Date())
-        
-        let filename = "audit_\(timestamp).log"
-        let fileURL = auditDirectoryURL.appendingPathComponent(filename)
-        
-        // Create file with secure permissions
-        let success = fileManager.createFile(
-            atPath: fileURL.path,
-            contents: nil,
-            attributes: [.posixPermissions: 0o600]
-        )
+        guard configuration.destinations.contains(.file) else { return }
         
-        guard success else {
-            throw AuditError.storageError("Failed to create audit log file")
+        let writer = try AuditSegmentWriter(directory: auditDirectoryURL, maxSegmentBytes: maxSegmentBytes)
+        segmentWriter = writer
+        logger.debug("Opened audit log segment", metadata: [
+            "file": "\(writer.currentSegmentURL?.lastPathComponent ?? "")"
+        ])
+    }
+    
+    /// Size at which the writer continues in a new segment
+    private var maxSegmentBytes: Int {
+        if case .size(let maxSizeMB) = configuration.rotationPolicy {
+            return max(maxSizeMB, 1) << 20
         }
-        
-        // Open file handle
+        return max(configuration.maxFileSizeMB, 1) << 20
+    }
+    
+    /// Every segment in the audit directory, oldest first
+    private func segmentURLs() throws -> [URL] {
         do {
-            currentFileHandle = try FileHandle(forWritingTo: fileURL)
-            currentLogFileURL = fileURL
-            
-            // Write header
-            let header = "# Privarion Audit Log\n# Started: \(Date())\n# Format: JSON Lines\n\n"
-            if let headerData = header.data(using: .utf8) {
-                currentFileHandle?.write(headerData)
-            }
-            
-            logger.debug("Opened audit log file", metadata: ["file": "\(filename)"])
+            return try fileManager
+                .contentsOfDirectory(at: auditDirectoryURL, includingPropertiesForKeys: nil)
+                .filter { $0.pathExtension == AuditSegmentFormat.fileExtension }
+                .sorted { $0.lastPathComponent < $1.lastPathComponent }
         } catch {
-            throw AuditError.storageError("Failed to open audit log file: \(error.localizedDescription)")
+            throw AuditError.storageError("Failed to list audit segments: \(error.localizedDescription)")
         }
     }
     
@@ -663,13 +733,18 @@ public class AuditLogger {
             handleCorrelation(event: event, correlationId: correlationId)
         }
         
-        // Add to cache for batching
+        // The segment writer batches file writes itself; blocks only while its queue is full
+        segmentWriter?.append(event)
+        
+        // Add to cache for batching to the other destinations
         cacheQueue.async(flags: .barrier) {
             self.eventCache.append(event)
             
-            // Flush if cache is full
+            // Flush if cache is full; flushing takes the cache queue itself
             if self.eventCache.count >= 100 {
-                self.flushEventCache()
+                self.eventQueue.async {
+                    self.flushEventCache()
+                }
             }
         }
         
@@ -717,7 +792,8 @@ public class AuditLogger {
     private func writeEvents(_ events: [AuditEvent], to destination: AuditConfiguration.LogDestination) {
         switch destination {
         case .file:
-            writeEventsToFile(events)
+            // Appended to the segment writer as each event is processed
+            break
         case .system:
             writeEventsToSystem(events)
         case .syslog:
@@ -729,19 +805,6 @@ public class AuditLogger {
         }
     }
     
-    private func writeEventsToFile(_ events: [AuditEvent]) {
-        guard let fileHandle = currentFileHandle else { return }
-        
-        for event in events {
-            if let jsonData = encodeEventToJSON(event) {
-                fileHandle.write(jsonData)
-                fileHandle.write("\n".data(using: .utf8) ?? Data())
-            }
-        }
-        
-        fileHandle.synchronizeFile()
-    }
-    
     private func writeEventsToSystem(_ events: [AuditEvent]) {
         for event in events {
             let logLevel: OSLogType = {
@@ -778,21 +841,6 @@ public class AuditLogger {
         logger.debug("Writing \(events.count) events to database")
     }
     
-    private func encodeEventToJSON(_ event: AuditEvent) -> Data? {
-        let encoder = JSONEncoder()
-        encoder.dateEncodingStrategy = .iso8601
-        
-        do {
-            return try encoder.encode(event)
-        } catch {
-            logger.error("Failed to encode audit event", metadata: [
-                "event_id": "\(event.id)",
-                "error": "\(error.localizedDescription)"
-            ])
-            return nil
-        }
-    }
-    
     private func updateStatistics(for event: AuditEvent) {
         statisticsQueue.async {
             self.statistics.totalEvents += 1
@@ -804,41 +852,20 @@ public class AuditLogger {
     
     private func checkRotation() {
         switch configuration.rotationPolicy {
-        case .size(let maxSizeMB):
-            checkSizeBasedRotation(maxSizeMB: maxSizeMB)
+        case .size:
+            // The segment writer rotates once a segment reaches maxSegmentBytes
+            break
         default:
             // Time-based rotation handled by timer
             rotateLogFile()
         }
     }
     
-    private func checkSizeBasedRotation(maxSizeMB: Int) {
-        guard let fileURL = currentLogFileURL else { return }
-        
-        do {
-            let attributes = try fileManager.attributesOfItem(atPath: fileURL.path)
-            if let fileSize = attributes[.size] as? UInt64 {
-                let fileSizeMB = Double(fileSize) / (1024 * 1024)
-                
-                if fileSizeMB >= Double(maxSizeMB) {
-                    rotateLogFile()
-                }
-            }
-        } catch {
-            logger.error("Failed to check log file size", metadata: ["error": "\(error.localizedDescription)"])
-        }
-    }
-    
     private func rotateLogFile() {
-        guard configuration.destinations.contains(.file) else { return }
-        
-        logger.info("Rotating audit log file")
+        guard let writer = segmentWriter else { return }
         
-        do {
-            try setupFileLogging()
-        } catch {
-            logger.error("Failed to rotate audit log file", metadata: ["error": "\(error.localizedDescription)"])
-        }
+        logger.info("Rotating audit log segment")
+        writer.rotate()
     }
     
     private func cleanupOldLogs() throws {
@@ -0,0 +1,383 @@
+import Foundation
+
+// MARK: - Errors
+
+/// Blocklist image and patch errors
+internal enum BlocklistImageError: Error, LocalizedError {
+    case unreadable(String, String)
+    case invalidImage(String)
+    case unsupportedVersion(UInt32)
+    case invalidPatch(String)
+    case patchMismatch(expected: UInt64, found: UInt64)
+
+    var errorDescription: String? {
+        switch self {
+        case .unreadable(let path, let reason):
+            return "Cannot read blocklist file \(path): \(reason)"
+        case .invalidImage(let details):
+            return "Invalid blocklist image: \(details)"
+        case .unsupportedVersion(let version):
+            return "Unsupported blocklist image version: \(version)"
+        case .invalidPatch(let details):
+            return "Invalid blocklist patch: \(details)"
+        case .patchMismatch(let expected, let found):
+            return "Blocklist patch targets image \(String(found, radix: 16)), loaded image is \(String(expected, radix: 16))"
+        }
+    }
+}
+
+// MARK: - Feed Parser
+
+/// Byte-level parser for blocklist feeds
+/// Accepts one domain per line or hosts-file lines (`0.0.0.0 example.com`),
+/// with `#` comments. Lines are validated and lowercased without building
+/// intermediate strings, so only accepted domains are allocated.
+internal enum BlocklistFeedParser {
+
+    /// Call `body` with each valid, lowercased domain in the feed
+    static func forEachDomain(in data: Data, _ body: (String) -> Void) {
+        data.withUnsafeBytes { (buffer: UnsafeRawBufferPointer) in
+            let bytes = buffer.bindMemory(to: UInt8.self)
+            var lineStart = 0
+            while lineStart < bytes.count {
+                var lineEnd = lineStart
+                while lineEnd < bytes.count && bytes[lineEnd] != UInt8(ascii: "\n") {
+                    lineEnd += 1
+                }
+                if let domain = domain(in: bytes, lineStart, lineEnd) {
+                    body(domain)
+                }
+                lineStart = lineEnd + 1
+            }
+        }
+    }
+
+    /// Every valid domain in the feed, in file order
+    static func domains(in data: Data) -> [String] {
+        var domains: [String] = []
+        forEachDomain(in: data) { domains.append($0) }
+        return domains
+    }
+
+    /// Domain named by one line, nil for comments, blanks and invalid entries
+    private static func domain(in bytes: UnsafeBufferPointer<UInt8>, _ start: Int, _ end: Int) -> String? {
+        var end = end
+        if let hash = bytes[start..<end].firstIndex(of: UInt8(ascii: "#")) {
+            end = hash
+        }
+
+        // Split into at most two whitespace separated fields
+        var fields: [(Int, Int)] = []
+        var cursor = start
+        while cursor < end {
+            while cursor < end && isSpace(bytes[cursor]) { cursor += 1 }
+            guard cursor < end else { break }
+            let fieldStart = cursor
+            while cursor < end && !isSpace(bytes[cursor]) { cursor += 1 }
+            fields.append((fieldStart, cursor))
+            if fields.count > 2 {
+                return nil
+            }
+        }
+
+        let field: (Int, Int)
+        switch fields.count {
+        case 1:
+            field = fields[0]
+        case 2 where isHostsAddress(bytes, fields[0].0, fields[0].1):
+            field = fields[1]
+        default:
+            return nil
+        }
+
+        let domainStart = field.0
+        var domainEnd = field.1
+        // Fully qualified names may end in a dot
+        if domainEnd > domainStart && bytes[domainEnd - 1] == UInt8(ascii: ".") {
+            domainEnd -= 1
+        }
+        guard isValidDomain(bytes, domainStart, domainEnd) else {
+            return nil
+        }
+
+        let lowered = bytes[domainStart..<domainEnd].map { $0 &- 0x41 < 26 ? $0 | 0x20 : $0 }
+        return String(decoding: lowered, as: UTF8.self)
+    }
+
+    /// Whether the first field of a hosts line is a sink address
+    private static func isHostsAddress(_ bytes: UnsafeBufferPointer<UInt8>, _ start: Int, _ end: Int) -> Bool {
+        let field = bytes[start..<end]
+        return field.elementsEqual("0.0.0.0".utf8) || field.elementsEqual("127.0.0.1".utf8)
+            || field.elementsEqual("::".utf8) || field.elementsEqual("::1".utf8)
+    }
+
+    /// Hostname with at least two labels of letters, digits and inner hyphens,
+    /// up to 63 bytes each, and an alphabetic top-level domain
+    private static func isValidDomain(_ bytes: UnsafeBufferPointer<UInt8>, _ start: Int, _ end: Int) -> Bool {
+        guard end - start >= 4 && end - start <= 253 else {
+            return false
+        }
+
+        var labels = 0
+        var labelStart = start
+        var labelAlphabetic = true
+        var lastLabelLength = 0
+        var lastLabelAlphabetic = false
+        for index in start...end {
+            if index == end || bytes[index] == UInt8(ascii: ".") {
+                let length = index - labelStart
+                guard length > 0 && length <= 63,
+                      bytes[labelStart] != UInt8(ascii: "-"),
+                      bytes[index - 1] != UInt8(ascii: "-") else {
+                    return false
+                }
+                labels += 1
+                lastLabelLength = length
+                lastLabelAlphabetic = labelAlphabetic
+                labelAlphabetic = true
+                labelStart = index + 1
+                continue
+            }
+
+            let byte = bytes[index]
+            let isLetter = (byte | 0x20) >= UInt8(ascii: "a") && (byte | 0x20) <= UInt8(ascii: "z")
+            let isDigit = byte >= UInt8(ascii: "0") && byte <= UInt8(ascii: "9")
+            guard isLetter || isDigit || byte == UInt8(ascii: "-") else {
+                return false
+            }
+            if !isLetter {
+                labelAlphabetic = false
+            }
+        }
+        return labels >= 2 && lastLabelAlphabetic && lastLabelLength >= 2
+    }
+
+    private static func isSpace(_ byte: UInt8) -> Bool {
+        return byte == 0x20 || (byte >= 0x09 && byte <= 0x0D)
+    }
+}
+
+// MARK: - Image Compiler
+
+/// Compiles blocklist feeds into the shared, memory-mapped rule image
+/// Every process that filters DNS maps the same file, so a feed is parsed
+/// once when the image is built rather than at each process start.
+internal enum BlocklistImageCompiler {
+
+    /// Image location shared by the agent, network extension and DNS proxy
+    static let sharedImageURL = URL(fileURLWithPath: "/Library/Application Support/Privarion/blocklist.pvbl")
+
+    /// Feed file and the category its domains are blocked under
+    typealias Feed = (url: URL, category: BlocklistCategory)
+
+    /// Category used for a bundled `Resources/NetworkFilters` feed
+    static func category(forFeedNamed name: String) -> BlocklistCategory {
+        switch name {
+        case "tracking-domains", "analytics-endpoints":
+            return .tracking
+        case "telemetry-hosts":
+            // Telemetry is kept with advertising, as in the configuration
+            return .advertising
+        default:
+            return .custom
+        }
+    }
+
+    /// Every `.txt` feed in a directory such as `Resources/NetworkFilters`
+    static func feeds(in directory: URL) throws -> [Feed] {
+        return try FileManager.default
+            .contentsOfDirectory(at: directory, includingPropertiesForKeys: nil)
+            .filter { $0.pathExtension == "txt" }
+            .sorted { $0.lastPathComponent < $1.lastPathComponent }
+            .map { (url: $0, category: category(forFeedNamed: $0.deletingPathExtension().lastPathComponent)) }
+    }
+
+    /// Parse feeds into tagged rules; a domain listed twice keeps its lowest tag
+    static func rules(from feeds: [Feed]) throws -> [DomainRuleTrie.Rule] {
+        var tags: [String: UInt8] = [:]
+        for feed in feeds {
+            let data: Data
+            do {
+                data = try Data(contentsOf: feed.url, options: .alwaysMapped)
+            } catch {
+                throw BlocklistImageError.unreadable(feed.url.path, error.localizedDescription)
+            }
+            let tag = CompiledBlocklist.tag(for: feed.category)
+            BlocklistFeedParser.forEachDomain(in: data) { domain in
+                tags[domain] = min(tags[domain] ?? tag, tag)
+            }
+        }
+        return tags.map { DomainRuleTrie.Rule(pattern: $0.key, tag: $0.value) }
+    }
+
+    /// Compile rules into an image and write it to `url`
+    /// The file is replaced atomically; processes holding the old mapping keep it.
+    @discardableResult
+    static func compile(_ rules: [DomainRuleTrie.Rule], to url: URL) throws -> DomainRuleTrie {
+        let trie = DomainRuleTrie(rules: rules.lazy.map { (pattern: $0.pattern, tag: $0.tag) })
+        try FileManager.default.createDirectory(at: url.deletingLastPathComponent(), withIntermediateDirectories: true)
+        try trie.writeImage(to: url)
+        return trie
+    }
+
+    /// Parse and compile feeds into an image at `url`
+    @discardableResult
+    static func compile(feeds: [Feed], to url: URL) throws -> DomainRuleTrie {
+        return try compile(rules(from: feeds), to: url)
+    }
+}
+
+// MARK: - Patches
+
+/// Incremental update to a compiled blocklist image
+/// A patch names the checksum of the image it was made against and is
+/// applied in memory with `DomainRuleTrie.applying(_:)`, so a feed update
+/// ships as the changed rules instead of a rebuilt image.
+internal struct BlocklistPatch {
+    static let magic: UInt32 = 0x5042_5650  // "PVBP"
+    static let version: UInt32 = 1
+
+    let baseChecksum: UInt64
+    let added: [DomainRuleTrie.Rule]
+    let removed: [DomainRuleTrie.Rule]
+
+    init(baseChecksum: UInt64, added: [DomainRuleTrie.Rule], removed: [DomainRuleTrie.Rule]) {
+        self.baseChecksum = baseChecksum
+        self.added = added
+        self.removed = removed
+    }
+
+    /// Changes turning `old` into `new`, for an image compiled from `old`
+    /// Removing `example.com` also drops the subdomain slot `*.example.com`
+    /// compiled to, and the reverse, so a surviving sibling is removed and
+    /// re-added with it.
+    static func diff(from old: [DomainRuleTrie.Rule], to new: [DomainRuleTrie.Rule], baseChecksum: UInt64) -> BlocklistPatch {
+        let oldTags = Dictionary(old.map { ($0.pattern, $0.tag) }, uniquingKeysWith: min)
+        let newTags = Dictionary(new.map { ($0.pattern, $0.tag) }, uniquingKeysWith: min)
+
+        var removed: [DomainRuleTrie.Rule] = []
+        var added: [DomainRuleTrie.Rule] = []
+        for (pattern, tag) in oldTags where newTags[pattern] != tag {
+            removed.append(DomainRuleTrie.Rule(pattern: pattern, tag: tag))
+        }
+        for (pattern, tag) in newTags where oldTags[pattern] != tag {
+            added.append(DomainRuleTrie.Rule(pattern: pattern, tag: tag))
+        }
+
+        let addedPatterns = Set(added.map { $0.pattern })
+        for rule in removed where !rule.pattern.contains("*") || rule.pattern.hasPrefix("*.") {
+            let sibling = rule.pattern.hasPrefix("*.") ? String(rule.pattern.dropFirst(2)) : "*." + rule.pattern
+            if let tag = newTags[sibling], oldTags[sibling] == tag, !addedPatterns.contains(sibling) {
+                removed.append(DomainRuleTrie.Rule(pattern: sibling, tag: tag))
+                added.append(DomainRuleTrie.Rule(pattern: sibling, tag: tag))
+            }
+        }
+
+        return BlocklistPatch(
+            baseChecksum: baseChecksum,
+            added: added.sorted { $0.pattern < $1.pattern },
+            removed: removed.sorted { $0.pattern < $1.pattern }
+        )
+    }
+
+    // MARK: - Serialization
+
+    /// Read a patch file
+    init(contentsOf url: URL) throws {
+        let data: Data
+        do {
+            data = try Data(contentsOf: url)
+        } catch {
+            throw BlocklistImageError.unreadable(url.path, error.localizedDescription)
+        }
+        try self.init(serialized: data)
+    }
+
+    /// Decode a patch
+    /// Layout: magic "PVBP", version, base image checksum, added and removed
+    /// counts, then one record per rule: tag, UInt16 length, pattern bytes.
+    init(serialized data: Data) throws {
+        let bytes = [UInt8](data)
+        var offset = 0
+
+        func read<T: FixedWidthInteger>(_ type: T.Type) throws -> T {
+            let size = MemoryLayout<T>.size
+            guard offset + size <= bytes.count else {
+                throw BlocklistImageError.invalidPatch("Truncated at byte \(offset)")
+            }
+            var value: T = 0
+            for index in 0..<size {
+                value |= T(bytes[offset + index]) << (index * 8)
+            }
+            offset += size
+            return value
+        }
+
+        func readRules(_ count: UInt32) throws -> [DomainRuleTrie.Rule] {
+            var rules: [DomainRuleTrie.Rule] = []
+            rules.reserveCapacity(Int(min(count, 1 << 20)))
+            for _ in 0..<count {
+                let tag = try read(UInt8.self)
+                let length = Int(try read(UInt16.self))
+                guard offset + length <= bytes.count else {
+                    throw BlocklistImageError.invalidPatch("Truncated rule at byte \(offset)")
+                }
+                let pattern = String(decoding: bytes[offset..<offset + length], as: UTF8.self)
+                offset += length
+                rules.append(DomainRuleTrie.Rule(pattern: pattern, tag: tag))
+            }
+            return rules
+        }
+
+        guard try read(UInt32.self) == Self.magic else {
+            throw BlocklistImageError.invalidPatch("Bad magic")
+        }
+        let version = try read(UInt32.self)
+        guard version == Self.version else {
+            throw BlocklistImageError.unsupportedVersion(version)
+        }
+        let baseChecksum = try read(UInt64.self)
+        let addedCount = try read(UInt32.self)
+        let removedCount = try read(UInt32.self)
+
+        self.baseChecksum = baseChecksum
+        self.added = try readRules(addedCount)
+        self.removed = try readRules(removedCount)
+
+        guard offset == bytes.count else {
+            throw BlocklistImageError.invalidPatch("Trailing bytes after rules")
+        }
+    }
+
+    /// Encode the patch; little-endian regardless of host
+    func serialized() -> Data {
+        var data = Data()
+
+        func append<T: FixedWidthInteger>(_ value: T) {
+            withUnsafeBytes(of: value.littleEndian) { data.append(contentsOf: $0) }
+        }
+
+        func appendRules(_ rules: [DomainRuleTrie.Rule]) {
+            for rule in rules {
+                let bytes = Array(rule.pattern.utf8.prefix(Int(UInt16.max)))
+                append(rule.tag)
+                append(UInt16(bytes.count))
+                data.append(contentsOf: bytes)
+            }
+        }
+
+        append(Self.magic)
+        append(Self.version)
+        append(baseChecksum)
+        append(UInt32(added.count))
+        append(UInt32(removed.count))
+        appendRules(added)
+        appendRules(removed)
+        return data
+    }
+
+    /// Write the patch file atomically
+    func write(to url: URL) throws {
+        try serialized().write(to: url, options: .atomic)
+    }
+}
@@ -18,7 +18,7 @@ internal class BlocklistManager: @unchecked Sendable {
     /// Domain blocklist cache
     private var domainBlocklist: Set<String> = []
     
-    /// IP address blocklist cache
+    /// IP address blocklist cache; addresses, CIDR prefixes and ranges
     private var ipBlocklist: Set<String> = []
     
     /// Category-based blocklist
@@ -27,15 +27,31 @@ internal class BlocklistManager: @unchecked Sendable {
     /// Whitelist (domains that should never be blocked)
     private var whitelist: Set<String> = []
     
+    /// Precompiled feed rules, usually mapped from the shared image
+    private var feedRules = DomainRuleTrie()
+    
     /// Cache access queue
     private let cacheQueue = DispatchQueue(label: "privarion.blocklist.cache", attributes: .concurrent)
     
     /// Update queue for blocklist modifications
     private let updateQueue = DispatchQueue(label: "privarion.blocklist.update", qos: .utility)
     
+    /// Compiled domain rules; replaced wholesale, never mutated
+    private var compiledRules = CompiledBlocklist()
+    
+    /// Compiles rule snapshots off the lookup and update paths
+    private let rebuildQueue = DispatchQueue(label: "privarion.blocklist.rebuild", qos: .utility)
+    
+    /// Whether a rebuild is queued but has not taken its snapshot yet
+    private var rebuildRequested = false
+    private let rebuildLock = NSLock()
+    
     /// Blocklist statistics
     private var statistics: BlocklistStatistics = BlocklistStatistics()
     
+    /// Guards statistics, which lookups update concurrently
+    private let statisticsLock = NSLock()
+    
     // MARK: - Initialization
     
     internal init() {
@@ -44,6 +60,13 @@ internal class BlocklistManager: @unchecked Sendable {
         
         loadBlocklistsFromConfiguration()
         loadBuiltInBlocklists()
+        loadSharedBlocklistImage()
+        
+        // Lookups made right after init must see the initial lists
+        let initial = compileRules()
+        cacheQueue.sync(flags: .barrier) {
+            self.compiledRules = initial
+        }
     }
     
     // MARK: - Public Interface
@@ -52,45 +75,53 @@ internal class BlocklistManager: @unchecked Sendable {
     /// - Parameter domain: The domain to check
     /// - Returns: True if the domain should be blocked
     internal func shouldBlockDomain(_ domain: String) -> Bool {
-        let normalizedDomain = normalizeDomain(domain)
+        let compiled = cacheQueue.sync { compiledRules }
         
-        return cacheQueue.sync {
-            // Check whitelist first
-            if isWhitelisted(normalizedDomain) {
-                statistics.whitelistHits += 1
-                return false
-            }
-            
-            // Check domain blocklist
-            if domainBlocklist.contains(normalizedDomain) || isSubdomainBlocked(normalizedDomain) {
-                statistics.domainBlocks += 1
-                return true
-            }
-            
-            // Check category blocklists with pattern matching
-            for (category, blocklist) in categoryBlocklists {
-                if matchesDomainPattern(normalizedDomain, in: blocklist) {
-                    statistics.categoryBlocks[category, default: 0] += 1
-                    return true
-                }
-            }
-            
-            statistics.allowedQueries += 1
+        // Check whitelist first
+        if compiled.whitelist.contains(domain) {
+            recordStatistics { $0.whitelistHits += 1 }
+            return false
+        }
+        
+        // One walk covers the domain blocklist and every category
+        return recordVerdict(tag: min(compiled.blocklist.match(domain), compiled.feeds.match(domain)))
+    }
+    
+    /// Check a lowercase dotted name straight from a DNS packet
+    /// - Parameter name: Canonical name bytes, as produced by `DNSWireFormat.withCanonicalName`
+    /// - Returns: True if the domain should be blocked
+    internal func shouldBlockDomain(canonicalName name: UnsafeBufferPointer<UInt8>) -> Bool {
+        let compiled = cacheQueue.sync { compiledRules }
+        
+        if compiled.whitelist.match(canonical: name) != DomainRuleTrie.noMatch {
+            recordStatistics { $0.whitelistHits += 1 }
             return false
         }
+        
+        return recordVerdict(tag: min(compiled.blocklist.match(canonical: name), compiled.feeds.match(canonical: name)))
     }
     
     /// Check if an IP address should be blocked
     /// - Parameter ipAddress: The IP address to check
     /// - Returns: True if the IP should be blocked
     internal func shouldBlockIP(_ ipAddress: String) -> Bool {
-        return cacheQueue.sync {
-            let blocked = ipBlocklist.contains(ipAddress) || isIPRangeBlocked(ipAddress)
-            if blocked {
-                statistics.ipBlocks += 1
-            }
-            return blocked
+        guard let address = IPPrefixTree.Address(ipAddress) else {
+            return false
         }
+        return shouldBlockAddress(address)
+    }
+    
+    /// Check if an address in binary form should be blocked
+    /// Packet paths call this directly so no address is formatted per packet.
+    /// - Parameter address: Destination address
+    /// - Returns: True if a blocked address or range covers it
+    internal func shouldBlockAddress(_ address: IPPrefixTree.Address) -> Bool {
+        let compiled = cacheQueue.sync { compiledRules }
+        guard compiled.ipRules.contains(address) else {
+            return false
+        }
+        recordStatistics { $0.ipBlocks += 1 }
+        return true
     }
     
     /// Add domain to blocklist
@@ -109,19 +140,27 @@ internal class BlocklistManager: @unchecked Sendable {
                 }
             }
             
+            self.scheduleRebuild()
             self.persistBlocklists()
             self.logger.info("Added domain to blocklist: \(normalizedDomain)")
         }
     }
     
     /// Add IP address to blocklist
-    /// - Parameter ipAddress: IP address to block
+    /// - Parameter ipAddress: IPv4 or IPv6 address, CIDR prefix (`10.0.0.0/8`)
+    ///   or range (`192.0.2.10-192.0.2.20`) to block
     internal func addBlockedIP(_ ipAddress: String) {
+        guard IPPrefixTree.Prefix.parse(ipAddress) != nil else {
+            logger.warning("Ignoring invalid IP blocklist entry: \(ipAddress)")
+            return
+        }
+        
         updateQueue.async {
             self.cacheQueue.async(flags: .barrier) {
                 self.ipBlocklist.insert(ipAddress)
             }
             
+            self.scheduleRebuild()
             self.persistBlocklists()
             self.logger.info("Added IP to blocklist: \(ipAddress)")
         }
@@ -137,6 +176,7 @@ internal class BlocklistManager: @unchecked Sendable {
                 self.whitelist.insert(normalizedDomain)
             }
             
+            self.scheduleRebuild()
             self.persistBlocklists()
             self.logger.info("Added domain to whitelist: \(normalizedDomain)")
         }
@@ -162,6 +202,7 @@ internal class BlocklistManager: @unchecked Sendable {
                 }
             }
             
+            self.scheduleRebuild()
             self.persistBlocklists()
             self.logger.info("Removed domain from blocklist: \(normalizedDomain)")
         }
@@ -170,14 +211,16 @@ internal class BlocklistManager: @unchecked Sendable {
     /// Get current blocklist statistics
     /// - Returns: Current statistics
     internal func getStatistics() -> BlocklistStatistics {
-        return cacheQueue.sync { statistics }
+        statisticsLock.lock()
+        defer { statisticsLock.unlock() }
+        return statistics
     }
     
     /// Reset statistics
     internal func resetStatistics() {
-        cacheQueue.async(flags: .barrier) {
-            self.statistics = BlocklistStatistics()
-        }
+        statisticsLock.lock()
+        statistics = BlocklistStatistics()
+        statisticsLock.unlock()
     }
     
     /// Load blocklist from external source
@@ -188,9 +231,7 @@ internal class BlocklistManager: @unchecked Sendable {
         logger.info("Loading blocklist from URL: \(url)")
         
         let data = try Data(contentsOf: url)
-        let content = String(data: data, encoding: .utf8) ?? ""
-        
-        let domains = parseBlocklistContent(content)
+        let domains = BlocklistFeedParser.domains(in: data)
         
         updateQueue.async { [weak self] in
             guard let self = self else { return }
@@ -201,13 +242,114 @@ internal class BlocklistManager: @unchecked Sendable {
                 }
             }
             
+            self.scheduleRebuild()
             self.persistBlocklists()
             self.logger.info("Loaded \(domains.count) domains from URL for category: \(category)")
         }
     }
     
+    /// Serve feed rules from a compiled blocklist image
+    /// The image is mapped read-only, so processes loading the same file
+    /// share its pages. It replaces any image or patches loaded before.
+    /// - Parameter url: Image written by `BlocklistImageCompiler`
+    internal func loadBlocklistImage(at url: URL) throws {
+        let rules = try DomainRuleTrie(contentsOf: url)
+        
+        cacheQueue.sync(flags: .barrier) {
+            self.feedRules = rules
+            self.compiledRules = self.compiledRules.replacingFeeds(rules)
+        }
+        logger.info("Mapped blocklist image with \(rules.ruleCount) rules from \(url.path)")
+    }
+    
+    /// Apply a delta patch to the loaded blocklist image
+    /// - Parameter url: Patch made against the loaded image
+    /// - Throws: `BlocklistImageError.patchMismatch` if it was made for another image
+    internal func applyBlocklistPatch(at url: URL) throws {
+        let patch = try BlocklistPatch(contentsOf: url)
+        
+        let rules = try cacheQueue.sync(flags: .barrier) { () -> DomainRuleTrie in
+            let patched = try self.feedRules.applying(patch)
+            self.feedRules = patched
+            self.compiledRules = self.compiledRules.replacingFeeds(patched)
+            return patched
+        }
+        logger.info("Applied blocklist patch: +\(patch.added.count) -\(patch.removed.count), \(rules.ruleCount) feed rules")
+    }
+    
     // MARK: - Private Methods
     
+    /// Count a lookup by the tag it matched; returns whether it blocks
+    private func recordVerdict(tag: UInt8) -> Bool {
+        if tag == CompiledBlocklist.domainBlocklistTag {
+            recordStatistics { $0.domainBlocks += 1 }
+            return true
+        }
+        if let category = CompiledBlocklist.category(for: tag) {
+            recordStatistics { $0.categoryBlocks[category, default: 0] += 1 }
+            return true
+        }
+        
+        recordStatistics { $0.allowedQueries += 1 }
+        return false
+    }
+    
+    private func recordStatistics(_ update: (inout BlocklistStatistics) -> Void) {
+        statisticsLock.lock()
+        update(&statistics)
+        statisticsLock.unlock()
+    }
+    
+    /// Queue a rebuild unless one that will see this update is pending
+    /// Must be called after the update's cache barrier has been queued.
+    private func scheduleRebuild() {
+        rebuildLock.lock()
+        let alreadyQueued = rebuildRequested
+        rebuildRequested = true
+        rebuildLock.unlock()
+        guard !alreadyQueued else { return }
+        
+        rebuildQueue.async {
+            self.rebuildLock.lock()
+            self.rebuildRequested = false
+            self.rebuildLock.unlock()
+            
+            let compiled = self.compileRules()
+            self.cacheQueue.async(flags: .barrier) {
+                // Feed images are published directly and may be newer
+                self.compiledRules = compiled.replacingFeeds(self.feedRules)
+            }
+            self.logger.debug("Compiled \(compiled.blocklist.ruleCount) blocklist rules")
+        }
+    }
+    
+    /// Snapshot the lists under the cache lock and compile them without it
+    private func compileRules() -> CompiledBlocklist {
+        let sources = cacheQueue.sync { (domainBlocklist, categoryBlocklists, whitelist, ipBlocklist, feedRules) }
+        return CompiledBlocklist(
+            domainBlocklist: sources.0,
+            categoryBlocklists: sources.1,
+            whitelist: sources.2,
+            ipBlocklist: sources.3,
+            feeds: sources.4
+        )
+    }
+    
+    /// Map the shared image if one has been compiled
+    private func loadSharedBlocklistImage() {
+        let url = BlocklistImageCompiler.sharedImageURL
+        guard FileManager.default.fileExists(atPath: url.path) else { return }
+        
+        do {
+            let rules = try DomainRuleTrie(contentsOf: url)
+            cacheQueue.sync(flags: .barrier) {
+                self.feedRules = rules
+            }
+        } catch {
+            logger.warning("Ignoring blocklist image at \(url.path): \(error.localizedDescription)")
+        }
+    }
+    
     private func loadBlocklistsFromConfiguration() {
         // Load from SystemExtensionConfiguration
         guard let systemConfig = try? configManager.loadConfiguration() else {
@@ -346,110 +488,89 @@ internal class BlocklistManager: @unchecked Sendable {
     private func normalizeDomain(_ domain: String) -> String {
         return domain.lowercased().trimmingCharacters(in: .whitespacesAndNewlines)
     }
-    
-    private func isWhitelisted(_ domain: String) -> Bool {
-        return whitelist.contains(domain) || 
-               whitelist.contains(where: { domain.hasSuffix(".\($0)") })
+}
+
+// MARK: - Supporting Types
+
+/// Domain lists compiled for lookup
+/// The blocklist trie tags custom domains 0 and each category with a fixed
+/// tag from 1, so custom domains win when a name matches both. Feed images
+/// store the same tags, so a category keeps its tag once assigned.
+internal struct CompiledBlocklist {
+    static let domainBlocklistTag: UInt8 = 0
+    
+    let blocklist: DomainRuleTrie
+    let whitelist: DomainRuleTrie
+    let feeds: DomainRuleTrie
+    let ipRules: IPPrefixTree
+    
+    init() {
+        self.blocklist = DomainRuleTrie()
+        self.whitelist = DomainRuleTrie()
+        self.feeds = DomainRuleTrie()
+        self.ipRules = IPPrefixTree()
     }
     
-    private func isSubdomainBlocked(_ domain: String) -> Bool {
-        // Check if any parent domain is blocked
-        let components = domain.components(separatedBy: ".")
-        for i in 1..<components.count {
-            let parentDomain = components[i...].joined(separator: ".")
-            if domainBlocklist.contains(parentDomain) {
-                return true
-            }
+    init(
+        domainBlocklist: Set<String>,
+        categoryBlocklists: [BlocklistCategory: Set<String>],
+        whitelist: Set<String>,
+        ipBlocklist: Set<String> = [],
+        feeds: DomainRuleTrie = DomainRuleTrie()
+    ) {
+        var rules = domainBlocklist.map { (pattern: $0, tag: Self.domainBlocklistTag) }
+        for (category, domains) in categoryBlocklists {
+            let tag = Self.tag(for: category)
+            rules.append(contentsOf: domains.map { (pattern: $0, tag: tag) })
         }
-        return false
+        self.blocklist = DomainRuleTrie(rules: rules)
+        self.whitelist = DomainRuleTrie(rules: whitelist.map { (pattern: $0, tag: UInt8(0)) })
+        self.feeds = feeds
+        self.ipRules = IPPrefixTree(rules: ipBlocklist)
     }
     
-    private func isIPRangeBlocked(_ ipAddress: String) -> Bool {
-        // TODO: Implement IP range blocking (CIDR notation support)
-        // This would check if the IP falls within any blocked IP ranges
-        return false
+    private init(blocklist: DomainRuleTrie, whitelist: DomainRuleTrie, feeds: DomainRuleTrie, ipRules: IPPrefixTree) {
+        self.blocklist = blocklist
+        self.whitelist = whitelist
+        self.feeds = feeds
+        self.ipRules = ipRules
     }
     
-    private func parseBlocklistContent(_ content: String) -> [String] {
-        return content
-            .components(separatedBy: .newlines)
-            .map { line in
-                // Remove comments and trim whitespace
-                let cleanLine = line.components(separatedBy: "#").first?.trimmingCharacters(in: .whitespacesAndNewlines) ?? ""
-                return cleanLine
-            }
-            .filter { !$0.isEmpty && isValidDomain($0) }
+    /// Same configured rules over different feed rules
+    func replacingFeeds(_ feeds: DomainRuleTrie) -> CompiledBlocklist {
+        return CompiledBlocklist(blocklist: blocklist, whitelist: whitelist, feeds: feeds, ipRules: ipRules)
     }
     
-    private func isValidDomain(_ domain: String) -> Bool {
-        // Basic domain validation
-        let domainRegex = "^[a-zA-Z0-9][a-zA-Z0-9\\-]{0,61}[a-zA-Z0-9]?\\.[a-zA-Z]{2,}$"
-        let predicate = NSPredicate(format: "SELF MATCHES %@", domainRegex)
-        return predicate.evaluate(with: domain)
+    static func tag(for category: BlocklistCategory) -> UInt8 {
+        switch category {
+        case .advertising: return 1
+        case .tracking: return 2
+        case .malware: return 3
+        case .phishing: return 4
+        case .cryptomining: return 5
+        case .socialMedia: return 6
+        case .gaming: return 7
+        case .adult: return 8
+        case .news: return 9
+        case .gambling: return 10
+        case .custom: return 11
+        }
     }
     
-    /// Match domain against patterns in blocklist (supports wildcards)
-    /// Supports patterns like: *.analytics.*, *.telemetry.*, *.tracking.*
-    /// - Parameters:
-    ///   - domain: The domain to check
-    ///   - blocklist: Set of domain patterns to match against
-    /// - Returns: True if domain matches any pattern
-    private func matchesDomainPattern(_ domain: String, in blocklist: Set<String>) -> Bool {
-        for pattern in blocklist {
-            // Exact match
-            if pattern == domain {
-                return true
-            }
-            
-            // Subdomain match (pattern: example.com matches sub.example.com)
-            if domain.hasSuffix(".\(pattern)") {
-                return true
-            }
-            
-            // Wildcard pattern matching (*.analytics.*, *.telemetry.*, etc.)
-            if pattern.contains("*") {
-                if matchesWildcardPattern(domain, pattern: pattern) {
-                    return true
-                }
-            }
-        }
-        
-        return false
+    static func category(for tag: UInt8) -> BlocklistCategory? {
+        return categoriesByTag[Int(tag)]
     }
     
-    /// Match domain against wildcard pattern
-    /// - Parameters:
-    ///   - domain: The domain to check
-    ///   - pattern: The wildcard pattern (e.g., *.analytics.*)
-    /// - Returns: True if domain matches the pattern
-    private func matchesWildcardPattern(_ domain: String, pattern: String) -> Bool {
-        // Convert wildcard pattern to regex
-        // *.analytics.* becomes ^.*\.analytics\..*$
-        var regexPattern = pattern
-            .replacingOccurrences(of: ".", with: "\\.")  // Escape dots
-            .replacingOccurrences(of: "*", with: ".*")   // Convert * to .*
-        
-        // Ensure pattern matches full domain
-        if !regexPattern.hasPrefix("^") {
-            regexPattern = "^" + regexPattern
-        }
-        if !regexPattern.hasSuffix("$") {
-            regexPattern = regexPattern + "$"
-        }
-        
-        // Test against regex
-        guard let regex = try? NSRegularExpression(pattern: regexPattern, options: .caseInsensitive) else {
-            logger.warning("Invalid wildcard pattern: \(pattern)")
-            return false
+    /// Inverse of `tag(for:)`, indexed by tag
+    private static let categoriesByTag: [BlocklistCategory?] = {
+        var table = [BlocklistCategory?](repeating: nil, count: 256)
+        for category in BlocklistCategory.allCases {
+            table[Int(tag(for: category))] = category
         }
-        
-        let range = NSRange(domain.startIndex..., in: domain)
-        return regex.firstMatch(in: domain, options: [], range: range) != nil
-    }
+        return table
+    }()
 }
 
-// MARK: - Supporting Types
-
 /// Blocklist categories for organization
 internal enum BlocklistCategory: String, CaseIterable, Codable {
     case advertising = "advertising"
@@ -0,0 +1,479 @@
+import Foundation
+
+/// Sharded cache of upstream DNS answers kept in wire format
+/// Entries are keyed by question (name hash, type, class) and the EDNS shape
+/// of the exchange, and hold the bytes upstream sent; a hit patches the ID and ages every TTL, so it is served
+/// without re-encoding. NXDOMAIN and NODATA answers are cached for their
+/// RFC 2308 negative TTL. Popular names are flagged for refresh shortly
+/// before they expire, so hot lookups keep hitting.
+///
+/// Each shard evicts with S3-FIFO under a byte budget: new entries enter a
+/// small probationary queue and only those hit again move to the main queue,
+/// so a burst of one-off names cannot flush the working set.
+internal final class DNSAnswerCache: @unchecked Sendable {
+
+    /// Question a cached response answers
+    /// The EDNS bits keep OPT records and DNSSEC data fetched for one
+    /// client from being served to a client that did not ask for them
+    /// (RFC 6891, RFC 3225); upstream echoes them, so a response is keyed
+    /// exactly like the query that produced it.
+    struct Key: Hashable {
+        let nameHash: UInt64
+        let type: UInt16
+        let dnsClass: UInt16
+        let edns: EDNSBits
+
+        init(_ question: DNSQueryView, ednsFlags: UInt32?) {
+            var edns: EDNSBits = []
+            if let flags = ednsFlags {
+                edns.insert(.present)
+                if flags & DNSWireFormat.ednsFlagDNSSECOK != 0 {
+                    edns.insert(.dnssecOK)
+                }
+            }
+            if question.flags & DNSWireFormat.flagCheckingDisabled != 0 {
+                edns.insert(.checkingDisabled)
+            }
+            self.nameHash = question.nameHash
+            self.type = question.queryType
+            self.dnsClass = question.queryClass
+            self.edns = edns
+        }
+
+        /// Key of a client query
+        init(query: DNSQueryView) {
+            self.init(query, ednsFlags: query.ednsPayloadSize != nil ? query.ednsFlags : nil)
+        }
+    }
+
+    /// What a query asked of EDNS and DNSSEC
+    struct EDNSBits: OptionSet, Hashable {
+        let rawValue: UInt8
+
+        /// An OPT record was sent
+        static let present = EDNSBits(rawValue: 1 << 0)
+        /// DO: DNSSEC records wanted
+        static let dnssecOK = EDNSBits(rawValue: 1 << 1)
+        /// CD: unvalidated data wanted
+        static let checkingDisabled = EDNSBits(rawValue: 1 << 2)
+    }
+
+    /// Cached response ready to send
+    struct Answer {
+        /// Response with the query's ID and aged TTLs
+        let response: [UInt8]
+        /// Whether the caller should refresh this name from upstream now
+        let shouldPrefetch: Bool
+        let isNegative: Bool
+    }
+
+    /// Cache counters, summed over all shards
+    struct Statistics {
+        var hits: Int = 0
+        var negativeHits: Int = 0
+        var misses: Int = 0
+        var insertions: Int = 0
+        var evictions: Int = 0
+        var prefetches: Int = 0
+        var entryCount: Int = 0
+        var byteCount: Int = 0
+
+        var hitRate: Double {
+            let lookups = hits + misses
+            return lookups > 0 ? Double(hits) / Double(lookups) : 0.0
+        }
+    }
+
+    /// Bytes charged per entry on top of the response itself
+    private static let entryOverhead = 96
+    /// Bytes budgeted per response when sizing from a response count
+    private static let bytesPerResponse = 512
+
+    private let shards: [Shard]
+    private let shardMask: Int
+    private let maximumTTL: UInt32
+    private let prefetchFraction: Double
+    private let clock: () -> UInt64
+
+    /// - Parameters:
+    ///   - capacityBytes: Byte budget across all shards
+    ///   - maximumTTL: Longest time, in seconds, any response is kept
+    ///   - shardCount: Rounded up to a power of two
+    ///   - prefetchFraction: Share of the TTL left when a popular name is refreshed
+    ///   - clock: Monotonic nanoseconds; overridable for tests
+    init(
+        capacityBytes: Int,
+        maximumTTL: UInt32,
+        shardCount: Int = 16,
+        prefetchFraction: Double = 0.1,
+        clock: @escaping () -> UInt64 = { DispatchTime.now().uptimeNanoseconds }
+    ) {
+        var count = 1
+        while count < max(shardCount, 1) {
+            count <<= 1
+        }
+        let shardCapacity = max(capacityBytes / count, 1)
+        self.shards = (0..<count).map { _ in Shard(capacity: shardCapacity) }
+        self.shardMask = count - 1
+        self.maximumTTL = maximumTTL
+        self.prefetchFraction = prefetchFraction
+        self.clock = clock
+    }
+
+    /// Cache sized from the profile's DNS proxy settings
+    /// `maxCacheSize` counts responses; it is budgeted at 512 bytes each.
+    convenience init(configuration: DNSProxyConfig) {
+        self.init(
+            capacityBytes: max(configuration.maxCacheSize, 0) * Self.bytesPerResponse,
+            maximumTTL: UInt32(clamping: configuration.cacheTTL)
+        )
+    }
+
+    // MARK: - Public Interface
+
+    /// Cached response for a query, nil on a miss or after expiry
+    func answer(for query: DNSQueryView, in message: UnsafeRawBufferPointer) -> Answer? {
+        let key = Key(query: query)
+        let now = clock()
+        let lookup = DNSWireFormat.withCanonicalName(of: query, in: message) { name in
+            shard(for: key).lookup(key, name: name, now: now, prefetchFraction: prefetchFraction)
+        }
+        guard let hit = lookup else {
+            return nil
+        }
+
+        var response = hit.entry.response
+        response.withUnsafeMutableBytes { bytes in
+            DNSWireFormat.setID(query.id, in: bytes)
+            DNSWireFormat.ageTTLs(in: bytes, at: hit.entry.ttlOffsets, by: hit.elapsed)
+        }
+        return Answer(response: response, shouldPrefetch: hit.shouldPrefetch, isNegative: hit.entry.isNegative)
+    }
+
+    /// Cache an upstream response if it is cacheable
+    /// Truncated answers, errors other than NXDOMAIN and negative answers
+    /// without an SOA are ignored.
+    /// - Returns: Whether the response was stored
+    @discardableResult
+    func store(response message: UnsafeRawBufferPointer) -> Bool {
+        guard let summary = DNSWireFormat.summarizeResponse(message),
+              !summary.isTruncated,
+              let upstreamTTL = summary.cacheTTL else {
+            return false
+        }
+        let ttl = min(upstreamTTL, maximumTTL)
+        guard ttl > 0 else { return false }
+
+        let question = summary.question
+        var response = [UInt8](message)
+        // Served TTLs must never outlive the entry
+        response.withUnsafeMutableBytes { bytes in
+            DNSWireFormat.ageTTLs(in: bytes, at: summary.ttlOffsets, by: 0, ceiling: ttl)
+        }
+        let name = DNSWireFormat.withCanonicalName(of: question, in: message) { [UInt8]($0) }
+
+        let entry = Entry(
+            response: response,
+            name: name,
+            ttlOffsets: summary.ttlOffsets,
+            storedAt: clock(),
+            ttl: ttl,
+            isNegative: summary.isNegative,
+            cost: response.count + name.count + summary.ttlOffsets.count * MemoryLayout<Int>.size + Self.entryOverhead
+        )
+        let key = Key(question, ednsFlags: summary.ednsFlags)
+        return shard(for: key).insert(key, entry)
+    }
+
+    /// Allow a later hit to request a refresh again, after a prefetch failed
+    func prefetchFailed(for query: DNSQueryView) {
+        let key = Key(query: query)
+        shard(for: key).clearPrefetch(key)
+    }
+
+    /// Drop every entry
+    func removeAll() {
+        for shard in shards {
+            shard.removeAll()
+        }
+    }
+
+    var statistics: Statistics {
+        var total = Statistics()
+        for shard in shards {
+            let counters = shard.statistics
+            total.hits += counters.hits
+            total.negativeHits += counters.negativeHits
+            total.misses += counters.misses
+            total.insertions += counters.insertions
+            total.evictions += counters.evictions
+            total.prefetches += counters.prefetches
+            total.entryCount += counters.entryCount
+            total.byteCount += counters.byteCount
+        }
+        return total
+    }
+
+    // MARK: - Private Methods
+
+    private func shard(for key: Key) -> Shard {
+        // The dictionaries hash the low bits; pick shards with the high ones
+        return shards[Int(truncatingIfNeeded: key.nameHash >> 48) & shardMask]
+    }
+}
+
+// MARK: - Storage
+
+/// One cached response
+private struct Entry {
+    let response: [UInt8]
+    /// Canonical question name, to rule out hash collisions
+    let name: [UInt8]
+    let ttlOffsets: [Int]
+    let storedAt: UInt64
+    let ttl: UInt32
+    let isNegative: Bool
+    let cost: Int
+
+    /// S3-FIFO access count, saturating at 3
+    var frequency: UInt8 = 0
+    var inMainQueue = false
+    /// Matches the queue slot that currently owns this entry
+    var generation: UInt64 = 0
+    var hits: UInt32 = 0
+    var prefetching = false
+}
+
+/// Live entry found by a lookup
+private struct Hit {
+    let entry: Entry
+    /// Whole seconds since the entry was stored
+    let elapsed: UInt32
+    let shouldPrefetch: Bool
+}
+
+/// FIFO of keys with O(1) amortised pops
+private struct KeyQueue<Element> {
+    private var storage: [Element] = []
+    private var head = 0
+
+    var isEmpty: Bool {
+        return head == storage.count
+    }
+
+    var count: Int {
+        return storage.count - head
+    }
+
+    mutating func push(_ element: Element) {
+        storage.append(element)
+    }
+
+    mutating func pop() -> Element? {
+        guard head < storage.count else { return nil }
+        let element = storage[head]
+        head += 1
+        // Reclaim the consumed prefix once it dominates the buffer
+        if head >= 1024 && head * 2 >= storage.count {
+            storage.removeFirst(head)
+            head = 0
+        }
+        return element
+    }
+
+    mutating func removeAll() {
+        storage.removeAll()
+        head = 0
+    }
+}
+
+/// Lock-protected slice of the cache with its own S3-FIFO queues
+private final class Shard {
+    private typealias Key = DNSAnswerCache.Key
+
+    private let lock = NSLock()
+    private let capacity: Int
+    /// The small queue's share of the budget, per S3-FIFO
+    private let smallCapacity: Int
+
+    private var entries: [Key: Entry] = [:]
+    private var small = KeyQueue<(key: Key, generation: UInt64)>()
+    private var main = KeyQueue<(key: Key, generation: UInt64)>()
+    private var ghosts = KeyQueue<Key>()
+    private var ghostKeys: Set<Key> = []
+    private var smallBytes = 0
+    private var mainBytes = 0
+    private var nextGeneration: UInt64 = 1
+    private var counters = DNSAnswerCache.Statistics()
+
+    init(capacity: Int) {
+        self.capacity = capacity
+        self.smallCapacity = max(capacity / 10, 1)
+    }
+
+    var statistics: DNSAnswerCache.Statistics {
+        lock.lock()
+        defer { lock.unlock() }
+        var snapshot = counters
+        snapshot.entryCount = entries.count
+        snapshot.byteCount = smallBytes + mainBytes
+        return snapshot
+    }
+
+    func lookup(_ key: Key, name: UnsafeBufferPointer<UInt8>, now: UInt64, prefetchFraction: Double) -> Hit? {
+        lock.lock()
+        defer { lock.unlock() }
+
+        guard var entry = entries[key], entry.name.elementsEqual(name) else {
+            counters.misses += 1
+            return nil
+        }
+        let elapsed = UInt32(clamping: (now &- entry.storedAt) / 1_000_000_000)
+        guard elapsed < entry.ttl else {
+            remove(key, entry)
+            counters.misses += 1
+            return nil
+        }
+
+        entry.frequency = min(entry.frequency + 1, 3)
+        entry.hits &+= 1
+        // Refresh names hit more than once within the last stretch of their TTL
+        let remaining = entry.ttl - elapsed
+        let shouldPrefetch = !entry.isNegative && !entry.prefetching && entry.hits >= 2
+            && Double(remaining) <= Double(entry.ttl) * prefetchFraction
+        if shouldPrefetch {
+            entry.prefetching = true
+            counters.prefetches += 1
+        }
+        entries[key] = entry
+
+        counters.hits += 1
+        if entry.isNegative {
+            counters.negativeHits += 1
+        }
+        return Hit(entry: entry, elapsed: elapsed, shouldPrefetch: shouldPrefetch)
+    }
+
+    func insert(_ key: Key, _ newEntry: Entry) -> Bool {
+        guard newEntry.cost <= capacity else { return false }
+        lock.lock()
+        defer { lock.unlock() }
+
+        var entry = newEntry
+        if let existing = entries[key] {
+            // A refresh keeps the old entry's place and standing
+            entry.frequency = existing.frequency
+            entry.inMainQueue = existing.inMainQueue
+            entry.generation = existing.generation
+            adjustBytes(existing.inMainQueue, by: entry.cost - existing.cost)
+            entries[key] = entry
+        } else {
+            // Recently evicted names skip probation
+            entry.inMainQueue = ghostKeys.remove(key) != nil
+            entry.generation = takeGeneration()
+            if entry.inMainQueue {
+                main.push((key, entry.generation))
+            } else {
+                small.push((key, entry.generation))
+            }
+            adjustBytes(entry.inMainQueue, by: entry.cost)
+            entries[key] = entry
+        }
+        counters.insertions += 1
+
+        while smallBytes + mainBytes > capacity && !(small.isEmpty && main.isEmpty) {
+            if smallBytes > smallCapacity || main.isEmpty {
+                evictFromSmall()
+            } else {
+                evictFromMain()
+            }
+        }
+        return entries[key] != nil
+    }
+
+    func clearPrefetch(_ key: Key) {
+        lock.lock()
+        entries[key]?.prefetching = false
+        lock.unlock()
+    }
+
+    func removeAll() {
+        lock.lock()
+        entries.removeAll()
+        small.removeAll()
+        main.removeAll()
+        ghosts.removeAll()
+        ghostKeys.removeAll()
+        smallBytes = 0
+        mainBytes = 0
+        lock.unlock()
+    }
+
+    // MARK: - S3-FIFO
+
+    /// Promote the oldest small-queue entry if it was hit, else evict it to the ghosts
+    private func evictFromSmall() {
+        guard let slot = small.pop(), var entry = entries[slot.key], entry.generation == slot.generation else {
+            return
+        }
+        let key = slot.key
+        if entry.frequency > 0 {
+            entry.frequency = 0
+            entry.inMainQueue = true
+            entry.generation = takeGeneration()
+            smallBytes -= entry.cost
+            mainBytes += entry.cost
+            main.push((key, entry.generation))
+            entries[key] = entry
+        } else {
+            remove(key, entry)
+            counters.evictions += 1
+            remember(key)
+        }
+    }
+
+    /// Give the oldest main-queue entry another lap if it was hit, else evict it
+    private func evictFromMain() {
+        guard let slot = main.pop(), var entry = entries[slot.key], entry.generation == slot.generation else {
+            return
+        }
+        let key = slot.key
+        if entry.frequency > 0 {
+            entry.frequency -= 1
+            entry.generation = takeGeneration()
+            main.push((key, entry.generation))
+            entries[key] = entry
+        } else {
+            remove(key, entry)
+            counters.evictions += 1
+        }
+    }
+
+    /// Track an evicted key, bounded by the number of live entries
+    private func remember(_ key: Key) {
+        if ghostKeys.insert(key).inserted {
+            ghosts.push(key)
+        }
+        while ghosts.count > max(entries.count, 64), let oldest = ghosts.pop() {
+            ghostKeys.remove(oldest)
+        }
+    }
+
+    private func remove(_ key: Key, _ entry: Entry) {
+        entries.removeValue(forKey: key)
+        adjustBytes(entry.inMainQueue, by: -entry.cost)
+    }
+
+    private func adjustBytes(_ inMainQueue: Bool, by delta: Int) {
+        if inMainQueue {
+            mainBytes += delta
+        } else {
+            smallBytes += delta
+        }
+    }
+
+    private func takeGeneration() -> UInt64 {
+        defer { nextGeneration += 1 }
+        return nextGeneration
+    }
+}
@@ -31,6 +31,9 @@ internal class DNSProxyServer: DNSProxyServerProtocol {
     private let connectionPool: DNSConnectionPool
     private let enableDoH: Bool
     
+    // Wire-format answer cache sized by the profile's dnsProxy settings
+    private let answerCache: DNSAnswerCache
+    
     weak var delegate: DNSProxyServerDelegate?
     
     internal init(port: Int, upstreamServers: [String], queryTimeout: Double, enableDoH: Bool = false) {
@@ -44,6 +47,7 @@ internal class DNSProxyServer: DNSProxyServerProtocol {
         self.ruleEngine = ApplicationNetworkRuleEngine()
         self.blocklistManager = BlocklistManager()
         self.trafficMonitor = TrafficMonitoringService()
+        self.answerCache = DNSAnswerCache(configuration: configuration.dnsProxy)
         
         // Initialize DoH client if enabled (Requirement 4.8)
         if enableDoH {
@@ -119,6 +123,11 @@ internal class DNSProxyServer: DNSProxyServerProtocol {
         return blocklistManager
     }
     
+    /// Get access to the DNS answer cache
+    internal var answers: DNSAnswerCache {
+        return answerCache
+    }
+    
     /// Get access to the traffic monitoring service
     internal var monitoring: TrafficMonitoringService {
         return trafficMonitor
@@ -194,7 +203,7 @@ internal class DNSProxyServer: DNSProxyServerProtocol {
                 queryType: dnsQuery.id
             )
             
-            sendBlockedResponse(dnsQuery, connection: connection)
+            sendBlockedResponse(dnsQuery, request: data, connection: connection)
         }
         
         // Check advanced blocklist (domains, categories, IPs) if not already blocked
@@ -215,7 +224,7 @@ internal class DNSProxyServer: DNSProxyServerProtocol {
                     queryType: dnsQuery.id
                 )
                 
-                sendBlockedResponse(dnsQuery, connection: connection)
+                sendBlockedResponse(dnsQuery, request: data, connection: connection)
             }
         }
         
@@ -237,7 +246,7 @@ internal class DNSProxyServer: DNSProxyServerProtocol {
                     queryType: dnsQuery.id
                 )
                 
-                sendBlockedResponse(dnsQuery, connection: connection)
+                sendBlockedResponse(dnsQuery, request: data, connection: connection)
             }
         }
         
@@ -256,8 +265,24 @@ internal class DNSProxyServer: DNSProxyServerProtocol {
         // Notify delegate
         delegate?.dnsProxy(self, didProcessQuery: dnsQuery.domain, blocked: blocked, latency: latency)
         
-        // Forward to upstream DNS server if not blocked
+        // Answer from the cache, or forward to upstream DNS server, if not blocked
         if !blocked {
+            if let cached = data.withUnsafeBytes({ answerCache.answer(for: dnsQuery.view, in: $0) }) {
+                fileLogger.logDNSQuery(
+                    domain: dnsQuery.domain,
+                    action: "allowed",
+                    reason: "answered from cache",
+                    processInfo: processInfo,
+                    queryType: dnsQuery.id
+                )
+                
+                connection.send(content: Data(cached.response), completion: .contentProcessed { _ in })
+                if cached.shouldPrefetch {
+                    prefetchDNSAnswer(data, query: dnsQuery)
+                }
+                return
+            }
+            
             // Log allowed query (Requirement 4.10, 17.5)
             fileLogger.logDNSQuery(
                 domain: dnsQuery.domain,
@@ -272,45 +297,16 @@ internal class DNSProxyServer: DNSProxyServerProtocol {
     }
     
     private func parseDNSQuery(_ data: Data) -> DNSQuery? {
-        // Simplified DNS parsing - in production would use more robust parsing
-        guard data.count >= 12 else { return nil }
-        
-        let questionStart = 12
-        var offset = questionStart
-        var domain = ""
-        
-        // Parse domain name from DNS query
-        while offset < data.count {
-            let length = Int(data[offset])
-            if length == 0 { break }
-            
-            offset += 1
-            if offset + length > data.count { return nil }
-            
-            let label = String(data: data[offset..<offset + length], encoding: .utf8) ?? ""
-            domain += domain.isEmpty ? label : ".\(label)"
-            offset += length
+        return data.withUnsafeBytes { message -> DNSQuery? in
+            guard let view = DNSWireFormat.parseQuery(message) else { return nil }
+            return DNSQuery(view: view, domain: DNSWireFormat.name(of: view, in: message))
         }
-        
-        return DNSQuery(id: UInt16(data[0]) << 8 | UInt16(data[1]), domain: domain)
     }
     
-    private func sendBlockedResponse(_ query: DNSQuery, connection: NWConnection) {
-        // Create DNS response indicating domain is blocked (NXDOMAIN)
-        var response = Data()
-        
-        // DNS Header (12 bytes)
-        response.append(UInt16(query.id).bigEndianData) // Transaction ID
-        response.append(Data([0x81, 0x83])) // Flags: Response, NXDOMAIN
-        response.append(Data([0x00, 0x01])) // Questions: 1
-        response.append(Data([0x00, 0x00])) // Answer RRs: 0
-        response.append(Data([0x00, 0x00])) // Authority RRs: 0
-        response.append(Data([0x00, 0x00])) // Additional RRs: 0
-        
-        // Question section (copy from original query)
-        response.append(encodeDomainName(query.domain))
-        response.append(Data([0x00, 0x01])) // Type A
-        response.append(Data([0x00, 0x01])) // Class IN
+    private func sendBlockedResponse(_ query: DNSQuery, request: Data, connection: NWConnection) {
+        // Answer NXDOMAIN by rewriting the query, keeping its question and EDNS
+        var response = request
+        DNSWireFormat.makeBlockedResponse(&response, for: query.view, answer: .nameError)
         
         connection.send(content: response, completion: .contentProcessed { error in
             if let error = error {
@@ -320,18 +316,40 @@ internal class DNSProxyServer: DNSProxyServerProtocol {
     }
     
     private func forwardDNSQuery(_ data: Data, originalConnection: NWConnection, domain: String, startTime: Date) {
+        resolveUpstream(data, domain: domain) { [weak self] responseData in
+            guard let self = self, let responseData = responseData else { return }
+            
+            // Forward response back to original client
+            originalConnection.send(content: responseData, completion: .contentProcessed { _ in })
+            responseData.withUnsafeBytes { _ = self.answerCache.store(response: $0) }
+            
+            // Report latency to delegate
+            let latency = Date().timeIntervalSince(startTime)
+            self.delegate?.dnsProxy(self, didProcessQuery: domain, blocked: false, latency: latency)
+        }
+    }
+    
+    /// Refresh a popular cached name before it expires, without a waiting client
+    private func prefetchDNSAnswer(_ data: Data, query: DNSQuery) {
+        logger.debug("Prefetching DNS answer for: \(query.domain)")
+        resolveUpstream(data, domain: query.domain) { [weak self] responseData in
+            guard let self = self else { return }
+            let stored = responseData?.withUnsafeBytes { self.answerCache.store(response: $0) } ?? false
+            if !stored {
+                self.answerCache.prefetchFailed(for: query.view)
+            }
+        }
+    }
+    
+    /// Send a query upstream and hand the raw response to `completion`, nil on failure
+    private func resolveUpstream(_ data: Data, domain: String, completion: @escaping (Data?) -> Void) {
         // Try DoH first if enabled (Requirement 4.8)
         if enableDoH, let dohClient = dohClient {
             Task {
                 do {
                     let responseData = try await dohClient.queryRaw(data)
-                    
-                    originalConnection.send(content: responseData, completion: .contentProcessed { _ in })
-                    
-                    let latency = Date().timeIntervalSince(startTime)
-                    self.logger.info("Forwarded query via DoH for \(domain), latency: \(String(format: "%.3f", latency * 1000))ms")
-                    self.delegate?.dnsProxy(self, didProcessQuery: domain, blocked: false, latency: latency)
-                    
+                    self.logger.info("Resolved query via DoH for \(domain)")
+                    completion(responseData)
                     return
                 } catch {
                     self.logger.warning("DoH query failed for \(domain), falling back to UDP: \(error)")
@@ -339,15 +357,15 @@ internal class DNSProxyServer: DNSProxyServerProtocol {
                 }
                 
                 // Fallback to UDP if DoH fails
-                self.forwardDNSQueryUDP(data, originalConnection: originalConnection, domain: domain, startTime: startTime)
+                self.resolveUpstreamUDP(data, completion: completion)
             }
         } else {
             // Use UDP directly
-            forwardDNSQueryUDP(data, originalConnection: originalConnection, domain: domain, startTime: startTime)
+            resolveUpstreamUDP(data, completion: completion)
         }
     }
     
-    private func forwardDNSQueryUDP(_ data: Data, originalConnection: NWConnection, domain: String, startTime: Date) {
+    private func resolveUpstreamUDP(_ data: Data, completion: @escaping (Data?) -> Void) {
         let upstreamServer = upstreamServers.first ?? "8.8.8.8"
         
         // Try to get connection from pool (Requirement 18.8)
@@ -378,6 +396,7 @@ internal class DNSProxyServer: DNSProxyServerProtocol {
                 if let pooled = pooledConnection {
                     self?.connectionPool.closeConnection(pooled)
                 }
+                completion(nil)
                 return
             }
             
@@ -393,41 +412,24 @@ internal class DNSProxyServer: DNSProxyServerProtocol {
                 
                 if let error = error {
                     self?.logger.error("Failed to receive DNS response: \(error)")
+                    completion(nil)
                     return
                 }
                 
-                if let responseData = responseData {
-                    // Forward response back to original client
-                    originalConnection.send(content: responseData, completion: .contentProcessed { _ in })
-                    
-                    // Report latency to delegate
-                    let latency = Date().timeIntervalSince(startTime)
-                    self?.delegate?.dnsProxy(self!, didProcessQuery: domain, blocked: false, latency: latency)
-                }
+                completion(responseData)
             }
         })
     }
-    
-    private func encodeDomainName(_ domain: String) -> Data {
-        var data = Data()
-        let components = domain.components(separatedBy: ".")
-        
-        for component in components {
-            let componentData = component.data(using: .utf8) ?? Data()
-            data.append(UInt8(componentData.count))
-            data.append(componentData)
-        }
-        
-        data.append(0) // Null terminator
-        return data
-    }
 }
 
 // MARK: - Supporting Types
 
 internal struct DNSQuery {
-    let id: UInt16
+    /// Wire-format position of the question in the request
+    let view: DNSQueryView
     let domain: String
+    
+    var id: UInt16 { view.id }
 }
 
 /// DNS Proxy Server Delegate
@@ -435,10 +437,3 @@ internal protocol DNSProxyServerDelegate: AnyObject {
     func dnsProxy(_ proxy: DNSProxyServer, shouldBlockDomain domain: String, for applicationId: String?) -> Bool
     func dnsProxy(_ proxy: DNSProxyServer, didProcessQuery domain: String, blocked: Bool, latency: TimeInterval)
 }
-
-private extension UInt16 {
-    var bigEndianData: Data {
-        var value = self.bigEndian
-        return Data(bytes: &value, count: MemoryLayout<UInt16>.size)
-    }
-}
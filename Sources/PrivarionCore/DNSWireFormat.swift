@@ -0,0 +1,479 @@
+import Foundation
+
+/// In-place view of a DNS query message
+/// Offsets index the message the view was parsed from; nothing is copied,
+/// so a view is only meaningful next to that message.
+internal struct DNSQueryView {
+    let id: UInt16
+    let flags: UInt16
+    let questionCount: UInt16
+    let additionalCount: UInt16
+
+    /// Offset of the question name's first length byte
+    let nameOffset: Int
+    /// Offset just past the first question, QTYPE and QCLASS included
+    let questionEnd: Int
+    let queryType: UInt16
+    let queryClass: UInt16
+
+    /// Number of labels in the question name
+    let labelCount: Int
+    /// Length of the name in dotted form, without a trailing dot
+    let nameLength: Int
+    /// FNV-1a of the lowercase dotted name; see `DNSWireFormat.nameHash(_:)`
+    let nameHash: UInt64
+
+    /// UDP payload size advertised by an EDNS(0) OPT record, if present
+    let ednsPayloadSize: UInt16?
+    /// Extended flags of that OPT record (its TTL field)
+    let ednsFlags: UInt32
+}
+
+/// What caching needs to know about an upstream response
+internal struct DNSResponseSummary {
+    /// The response's question; `flags` are the response flags
+    let question: DNSQueryView
+    let rcode: UInt16
+    let isTruncated: Bool
+    /// NXDOMAIN or NODATA
+    let isNegative: Bool
+    /// Offsets of every TTL field outside the OPT record
+    let ttlOffsets: [Int]
+    /// Extended flags of the response's OPT record, nil without one
+    let ednsFlags: UInt32?
+    /// Seconds the response may be cached, nil if it must not be
+    let cacheTTL: UInt32?
+}
+
+/// DNS wire-format parsing and in-place response construction (RFC 1035, 6891)
+/// The parser reads the question straight from the packet, following
+/// compression pointers, and hashes the canonical name as it goes. Blocked
+/// answers are built by rewriting the query buffer, so refusing a query
+/// costs no allocation.
+internal enum DNSWireFormat {
+
+    static let headerSize = 12
+    /// Longest name in dotted form
+    static let maxNameLength = 253
+
+    static let typeA: UInt16 = 1
+    static let typeAAAA: UInt16 = 28
+    static let typeSOA: UInt16 = 6
+    static let typeOPT: UInt16 = 41
+    static let classIN: UInt16 = 1
+
+    /// CD header bit: the client does its own DNSSEC validation (RFC 4035)
+    static let flagCheckingDisabled: UInt16 = 0x0010
+    /// DO bit of the OPT extended flags: DNSSEC records wanted (RFC 3225)
+    static let ednsFlagDNSSECOK: UInt32 = 0x8000
+
+    static let rcodeNoError: UInt16 = 0
+    static let rcodeServerFailure: UInt16 = 2
+    static let rcodeNameError: UInt16 = 3
+
+    /// Size of the OPT record written into responses, with no options
+    private static let optRecordSize = 11
+    /// Pointer hops allowed while reading one name
+    private static let maxPointerHops = 16
+
+    /// How a blocked query is answered
+    enum BlockedAnswer {
+        /// NXDOMAIN for every query type
+        case nameError
+        /// `0.0.0.0` / `::` for A and AAAA, an empty NOERROR answer otherwise
+        case sinkhole(ttl: UInt32)
+    }
+
+    // MARK: - Parsing
+
+    /// Parse the header and first question of a query
+    /// - Returns: nil for responses, truncated messages and malformed names
+    static func parseQuery(_ message: UnsafeRawBufferPointer) -> DNSQueryView? {
+        return parseQuestion(message, isResponse: false)
+    }
+
+    /// Walk an upstream response to decide whether and how long it may be cached
+    /// Positive answers live for their lowest answer TTL; NXDOMAIN and NODATA
+    /// live for the SOA-derived negative TTL of RFC 2308 and are not cached
+    /// without an SOA.
+    /// - Returns: nil for queries and malformed messages
+    static func summarizeResponse(_ message: UnsafeRawBufferPointer) -> DNSResponseSummary? {
+        guard let question = parseQuestion(message, isResponse: true), question.questionCount == 1 else {
+            return nil
+        }
+
+        var ttlOffsets: [Int] = []
+        var answerTTL: UInt32?
+        var negativeTTL: UInt32?
+        var ednsFlags: UInt32?
+        var offset = question.questionEnd
+        for section in 0..<3 {
+            let count = readUInt16(message, 6 + section * 2)
+            for _ in 0..<count {
+                guard let owner = scanName(message, at: offset, hashing: false), owner.end + 10 <= message.count else {
+                    return nil
+                }
+                let type = readUInt16(message, owner.end)
+                let ttl = readUInt32(message, owner.end + 4)
+                let dataStart = owner.end + 10
+                let dataEnd = dataStart + Int(readUInt16(message, owner.end + 8))
+                guard dataEnd <= message.count else { return nil }
+
+                if type != typeOPT {
+                    ttlOffsets.append(owner.end + 4)
+                } else if section == 2 {
+                    ednsFlags = ttl
+                }
+                if section == 0 {
+                    answerTTL = min(answerTTL ?? ttl, ttl)
+                } else if section == 1 && type == typeSOA && dataEnd - dataStart >= 22 {
+                    // The negative TTL is the lesser of the SOA's TTL and MINIMUM
+                    negativeTTL = min(ttl, readUInt32(message, dataEnd - 4))
+                }
+                offset = dataEnd
+            }
+        }
+
+        let rcode = question.flags & 0x000F
+        let cacheTTL: UInt32?
+        if rcode == rcodeNameError || (rcode == rcodeNoError && answerTTL == nil) {
+            cacheTTL = negativeTTL
+        } else if rcode == rcodeNoError {
+            cacheTTL = answerTTL
+        } else {
+            cacheTTL = nil
+        }
+
+        return DNSResponseSummary(
+            question: question,
+            rcode: rcode,
+            isTruncated: question.flags & 0x0200 != 0,
+            isNegative: rcode != rcodeNoError || answerTTL == nil,
+            ttlOffsets: ttlOffsets,
+            ednsFlags: ednsFlags,
+            cacheTTL: cacheTTL
+        )
+    }
+
+    private static func parseQuestion(_ message: UnsafeRawBufferPointer, isResponse: Bool) -> DNSQueryView? {
+        guard message.count >= headerSize else { return nil }
+
+        let flags = readUInt16(message, 2)
+        let questionCount = readUInt16(message, 4)
+        let answerCount = readUInt16(message, 6)
+        let authorityCount = readUInt16(message, 8)
+        let additionalCount = readUInt16(message, 10)
+        // QR must match and there must be a question to answer
+        guard (flags & 0x8000 != 0) == isResponse, questionCount > 0 else { return nil }
+
+        guard let name = scanName(message, at: headerSize, hashing: true),
+              name.end + 4 <= message.count else {
+            return nil
+        }
+        let questionEnd = name.end + 4
+
+        // EDNS(0) only matters for plain queries: one question, no answers
+        var ednsPayloadSize: UInt16?
+        var ednsFlags: UInt32 = 0
+        if questionCount == 1 && answerCount == 0 && authorityCount == 0 {
+            var offset = questionEnd
+            for _ in 0..<additionalCount {
+                guard let owner = scanName(message, at: offset, hashing: false), owner.end + 10 <= message.count else {
+                    break
+                }
+                let type = readUInt16(message, owner.end)
+                let dataLength = Int(readUInt16(message, owner.end + 8))
+                if type == typeOPT {
+                    ednsPayloadSize = readUInt16(message, owner.end + 2)
+                    ednsFlags = readUInt32(message, owner.end + 4)
+                    break
+                }
+                offset = owner.end + 10 + dataLength
+            }
+        }
+
+        return DNSQueryView(
+            id: readUInt16(message, 0),
+            flags: flags,
+            questionCount: questionCount,
+            additionalCount: additionalCount,
+            nameOffset: headerSize,
+            questionEnd: questionEnd,
+            queryType: readUInt16(message, name.end),
+            queryClass: readUInt16(message, name.end + 2),
+            labelCount: name.labels,
+            nameLength: name.length,
+            nameHash: name.hash,
+            ednsPayloadSize: ednsPayloadSize,
+            ednsFlags: ednsFlags
+        )
+    }
+
+    /// Offsets and lengths of the question's labels, in order, pointers followed
+    static func forEachLabel(of query: DNSQueryView, in message: UnsafeRawBufferPointer, _ body: (_ offset: Int, _ length: Int) -> Void) {
+        var offset = query.nameOffset
+        var hops = 0
+        while offset < message.count {
+            let length = Int(message[offset])
+            if length & 0xC0 == 0xC0 {
+                guard offset + 1 < message.count, hops < maxPointerHops else { return }
+                offset = (length & 0x3F) << 8 | Int(message[offset + 1])
+                hops += 1
+                continue
+            }
+            guard length != 0 else { return }
+            body(offset + 1, length)
+            offset += 1 + length
+        }
+    }
+
+    /// Call `body` with the question name in lowercase dotted form
+    /// The name is assembled in temporary stack storage, ready for
+    /// `DomainRuleTrie.match(canonical:)`.
+    static func withCanonicalName<R>(of query: DNSQueryView, in message: UnsafeRawBufferPointer, _ body: (UnsafeBufferPointer<UInt8>) -> R) -> R {
+        return withUnsafeTemporaryAllocation(of: UInt8.self, capacity: maxNameLength + 1) { storage in
+            var written = 0
+            forEachLabel(of: query, in: message) { offset, length in
+                if written > 0 {
+                    storage[written] = UInt8(ascii: ".")
+                    written += 1
+                }
+                for index in 0..<length where written < storage.count {
+                    storage[written] = fold(message[offset + index])
+                    written += 1
+                }
+            }
+            return body(UnsafeBufferPointer(rebasing: storage[0..<written]))
+        }
+    }
+
+    /// Question name as a lowercase string, for logging and slow paths
+    static func name(of query: DNSQueryView, in message: UnsafeRawBufferPointer) -> String {
+        return withCanonicalName(of: query, in: message) { String(decoding: $0, as: UTF8.self) }
+    }
+
+    /// Hash of a lowercase dotted name, as computed into `DNSQueryView.nameHash`
+    static func nameHash(_ name: String) -> UInt64 {
+        var hash = fnvOffset
+        for byte in name.utf8 {
+            hash = (hash ^ UInt64(fold(byte))) &* fnvPrime
+        }
+        return hash
+    }
+
+    // MARK: - Responses
+
+    /// Bytes needed to rewrite the query as a blocked response
+    static func blockedResponseLength(for query: DNSQueryView, answer: BlockedAnswer) -> Int {
+        var length = query.questionEnd
+        if let record = sinkholeRecordLength(for: query, answer: answer) {
+            length += record
+        }
+        if query.ednsPayloadSize != nil {
+            length += optRecordSize
+        }
+        return length
+    }
+
+    /// Rewrite a query, in place, into the response for a blocked name
+    /// Keeps the ID, opcode, RD and CD bits and the first question, answers
+    /// with `answer`, and echoes EDNS(0) without options. Anything after the
+    /// first question is overwritten.
+    /// - Parameter message: The query; at least `blockedResponseLength` bytes
+    /// - Returns: Length of the response
+    @discardableResult
+    static func writeBlockedResponse(into message: UnsafeMutableRawBufferPointer, for query: DNSQueryView, answer: BlockedAnswer) -> Int {
+        let length = blockedResponseLength(for: query, answer: answer)
+        precondition(message.count >= length, "Buffer too small for DNS response")
+
+        let record = sinkholeRecordLength(for: query, answer: answer)
+        let rcode: UInt16
+        switch answer {
+        case .nameError: rcode = rcodeNameError
+        case .sinkhole: rcode = rcodeNoError
+        }
+
+        writeResponseHeader(message, query: query, rcode: rcode, answers: record == nil ? 0 : 1)
+        var offset = query.questionEnd
+
+        if let record = record, case .sinkhole(let ttl) = answer {
+            let addressLength = record - 12
+            writeUInt16(message, offset, 0xC000 | UInt16(query.nameOffset))
+            writeUInt16(message, offset + 2, query.queryType)
+            writeUInt16(message, offset + 4, classIN)
+            writeUInt32(message, offset + 6, ttl)
+            writeUInt16(message, offset + 10, UInt16(addressLength))
+            for index in 0..<addressLength {
+                message[offset + 12 + index] = 0
+            }
+            offset += record
+        }
+
+        if let payloadSize = query.ednsPayloadSize {
+            writeOPTRecord(message, offset, payloadSize: payloadSize, flags: query.ednsFlags)
+            offset += optRecordSize
+        }
+        return offset
+    }
+
+    /// Rewrite a query, in place, into an empty response with `rcode`
+    /// Used for SERVFAIL when no upstream answers.
+    /// - Returns: Length of the response
+    @discardableResult
+    static func writeErrorResponse(into message: UnsafeMutableRawBufferPointer, for query: DNSQueryView, rcode: UInt16) -> Int {
+        precondition(message.count >= query.questionEnd, "Buffer too small for DNS response")
+        writeResponseHeader(message, query: query, rcode: rcode, answers: 0, keepsEDNS: false)
+        return query.questionEnd
+    }
+
+    /// Build a blocked response from a query held in `Data`
+    /// The bytes are rewritten in place when the buffer is uniquely owned.
+    static func makeBlockedResponse(_ message: inout Data, for query: DNSQueryView, answer: BlockedAnswer) {
+        let length = blockedResponseLength(for: query, answer: answer)
+        if message.count < length {
+            message.count = length
+        }
+        message.withUnsafeMutableBytes { _ = writeBlockedResponse(into: $0, for: query, answer: answer) }
+        message.count = length
+    }
+
+    /// Set the message ID, as when serving a cached response to a new query
+    static func setID(_ id: UInt16, in message: UnsafeMutableRawBufferPointer) {
+        writeUInt16(message, 0, id)
+    }
+
+    /// Cap every TTL at `ceiling`, then age it by `elapsed` seconds
+    /// - Parameter offsets: TTL field offsets from `DNSResponseSummary`
+    static func ageTTLs(in message: UnsafeMutableRawBufferPointer, at offsets: [Int], by elapsed: UInt32, ceiling: UInt32 = .max) {
+        for offset in offsets {
+            let ttl = min(readUInt32(UnsafeRawBufferPointer(message), offset), ceiling)
+            writeUInt32(message, offset, ttl > elapsed ? ttl - elapsed : 0)
+        }
+    }
+
+    // MARK: - Private Helpers
+
+    private static let fnvOffset: UInt64 = 14695981039346656037
+    private static let fnvPrime: UInt64 = 1099511628211
+
+    /// Result of walking one encoded name
+    private struct ScannedName {
+        /// Offset just past the name where it starts, before any pointer target
+        let end: Int
+        let labels: Int
+        let length: Int
+        let hash: UInt64
+    }
+
+    /// Walk a name, validating labels and pointers
+    /// Pointers must point backwards, which rules out loops on their own;
+    /// the hop limit bounds the work for long chains.
+    private static func scanName(_ message: UnsafeRawBufferPointer, at start: Int, hashing: Bool) -> ScannedName? {
+        var offset = start
+        var end: Int?
+        var labels = 0
+        var length = 0
+        var hash = fnvOffset
+        var hops = 0
+
+        while true {
+            guard offset < message.count else { return nil }
+            let byte = Int(message[offset])
+
+            switch byte & 0xC0 {
+            case 0xC0:
+                guard offset + 1 < message.count, hops < maxPointerHops else { return nil }
+                let target = (byte & 0x3F) << 8 | Int(message[offset + 1])
+                guard target < offset else { return nil }
+                if end == nil {
+                    end = offset + 2
+                }
+                offset = target
+                hops += 1
+            case 0:
+                if byte == 0 {
+                    return ScannedName(end: end ?? offset + 1, labels: labels, length: length, hash: hash)
+                }
+                guard offset + 1 + byte <= message.count else { return nil }
+                let separator = labels > 0 ? 1 : 0
+                guard length + separator + byte <= maxNameLength else { return nil }
+                if hashing {
+                    if separator == 1 {
+                        hash = (hash ^ UInt64(UInt8(ascii: "."))) &* fnvPrime
+                    }
+                    for index in 1...byte {
+                        hash = (hash ^ UInt64(fold(message[offset + index]))) &* fnvPrime
+                    }
+                }
+                labels += 1
+                length += separator + byte
+                offset += 1 + byte
+            default:
+                // 0x40 and 0x80 label types are obsolete or unassigned
+                return nil
+            }
+        }
+    }
+
+    /// Size of the A/AAAA record a sinkhole answer adds, nil if none
+    private static func sinkholeRecordLength(for query: DNSQueryView, answer: BlockedAnswer) -> Int? {
+        guard case .sinkhole = answer, query.queryClass == classIN else { return nil }
+        switch query.queryType {
+        case typeA: return 12 + 4
+        case typeAAAA: return 12 + 16
+        default: return nil
+        }
+    }
+
+    private static func writeResponseHeader(
+        _ message: UnsafeMutableRawBufferPointer,
+        query: DNSQueryView,
+        rcode: UInt16,
+        answers: UInt16,
+        keepsEDNS: Bool = true
+    ) {
+        // QR and RA set; opcode, RD and CD kept from the query
+        let flags = 0x8000 | (query.flags & 0x7900) | 0x0080 | (query.flags & 0x0010) | (rcode & 0x000F)
+        writeUInt16(message, 2, flags)
+        writeUInt16(message, 4, 1)
+        writeUInt16(message, 6, answers)
+        writeUInt16(message, 8, 0)
+        writeUInt16(message, 10, keepsEDNS && query.ednsPayloadSize != nil ? 1 : 0)
+    }
+
+    private static func writeOPTRecord(_ message: UnsafeMutableRawBufferPointer, _ offset: Int, payloadSize: UInt16, flags: UInt32) {
+        message[offset] = 0
+        writeUInt16(message, offset + 1, typeOPT)
+        writeUInt16(message, offset + 3, payloadSize)
+        // Extended RCODE and version are ours to set; keep only the DO bit
+        writeUInt32(message, offset + 5, flags & 0x0000_8000)
+        writeUInt16(message, offset + 9, 0)
+    }
+
+    @inline(__always)
+    private static func fold(_ byte: UInt8) -> UInt8 {
+        return byte &- 0x41 < 26 ? byte | 0x20 : byte
+    }
+
+    @inline(__always)
+    private static func readUInt16(_ message: UnsafeRawBufferPointer, _ offset: Int) -> UInt16 {
+        return UInt16(message[offset]) << 8 | UInt16(message[offset + 1])
+    }
+
+    @inline(__always)
+    private static func readUInt32(_ message: UnsafeRawBufferPointer, _ offset: Int) -> UInt32 {
+        return UInt32(readUInt16(message, offset)) << 16 | UInt32(readUInt16(message, offset + 2))
+    }
+
+    @inline(__always)
+    private static func writeUInt16(_ message: UnsafeMutableRawBufferPointer, _ offset: Int, _ value: UInt16) {
+        message[offset] = UInt8(value >> 8)
+        message[offset + 1] = UInt8(value & 0xFF)
+    }
+
+    @inline(__always)
+    private static func writeUInt32(_ message: UnsafeMutableRawBufferPointer, _ offset: Int, _ value: UInt32) {
+        writeUInt16(message, offset, UInt16(value >> 16))
+        writeUInt16(message, offset + 2, UInt16(value & 0xFFFF))
+    }
+}
@@ -44,6 +44,10 @@ public class DYLDInjectionManager {
         return systemPath
     }
     
+    /// Spoofed hardware identifiers, generated once so every launched
+    /// application reports the same machine
+    private lazy var identifierTable = HardwareIdentifierEngine().makeIdentifierTable()
+    
     public init(configuration: ConfigurationManager) {
         self.configuration = configuration
     }
@@ -136,13 +140,38 @@ public class DYLDInjectionManager {
         // Setup environment for injection
         var injectionEnvironment = environment
         
-        // Add DYLD_INSERT_LIBRARIES
+        // Add DYLD_INSERT_LIBRARIES; the library passes it and the
+        // PRIVARION_HOOK_* variables below on to every process the target spawns
         if let existingLibraries = injectionEnvironment["DYLD_INSERT_LIBRARIES"] {
             injectionEnvironment["DYLD_INSERT_LIBRARIES"] = "\(existingLibraries):\(hookLibraryPath)"
         } else {
             injectionEnvironment["DYLD_INSERT_LIBRARIES"] = hookLibraryPath
         }
         
+        // Hand the resolved hook profiles to the library constructor
+        if let profileTableURL = writeProfileTable() {
+            injectionEnvironment[HookProfileTable.pathEnvironmentKey] = profileTableURL.path
+            if let bundleId = bundleIdentifier(forApplicationAt: applicationPath) {
+                injectionEnvironment[HookProfileTable.bundleEnvironmentKey] = bundleId
+            }
+        }
+        
+        // Identifiers for the sysctlbyname and I/O Registry hooks
+        if let identifierTableURL = writeIdentifierTable() {
+            injectionEnvironment[HardwareIdentifierTable.pathEnvironmentKey] = identifierTableURL.path
+        }
+        
+        // Export hook statistics so the injected process can be measured
+        // without calling into it
+        injectionEnvironment["PRIVARION_HOOK_STATS"] = "1"
+        
+        // Publish hooked calls for SyscallMonitoringEngine.attachEventStream
+        injectionEnvironment[HookEventStream.environmentKey] = "1"
+        
+        // Resolve originals on first call, so a cold start only pays for
+        // the hooks the target actually uses
+        injectionEnvironment[SyscallHookManager.lazyActivationEnvironmentKey] = "1"
+        
         // Enable debug logging if configured (check log level)
         let currentConfig = configuration.getCurrentConfiguration()
         if currentConfig.global.logLevel == .debug {
@@ -199,6 +228,54 @@ public class DYLDInjectionManager {
         return task.isRunning
     }
     
+    /// Location of the profile table handed to injected processes
+    private var profileTableURL: URL {
+        return FileManager.default.temporaryDirectory.appendingPathComponent("privarion-hook-profiles.bin")
+    }
+    
+    /// Resolve the hook profiles of every configured bundle into the binary table
+    private func writeProfileTable() -> URL? {
+        do {
+            let hookConfiguration = try SyscallHookConfigurationManager(configurationManager: configuration).loadConfiguration()
+            let table = HookProfileTable(configuration: hookConfiguration)
+            try table.write(to: profileTableURL)
+            logger.debug("Wrote \(table.count) hook profiles to \(self.profileTableURL.path)")
+            return profileTableURL
+        } catch {
+            logger.error("Failed to write hook profile table: \(error.localizedDescription)")
+            return nil
+        }
+    }
+    
+    /// Location of the identifier table handed to injected processes
+    private var identifierTableURL: URL {
+        return FileManager.default.temporaryDirectory.appendingPathComponent("privarion-hook-identifiers.bin")
+    }
+    
+    /// Write this session's spoofed hardware identifiers
+    private func writeIdentifierTable() -> URL? {
+        do {
+            try identifierTable.write(to: identifierTableURL)
+            logger.debug("Wrote \(self.identifierTable.count) hardware identifiers to \(self.identifierTableURL.path)")
+            return identifierTableURL
+        } catch {
+            logger.error("Failed to write hardware identifier table: \(error.localizedDescription)")
+            return nil
+        }
+    }
+    
+    /// Bundle identifier of the application bundle containing an executable
+    private func bundleIdentifier(forApplicationAt applicationPath: String) -> String? {
+        var url = URL(fileURLWithPath: applicationPath)
+        while url.pathComponents.count > 1 {
+            if url.pathExtension == "app" {
+                return Bundle(url: url)?.bundleIdentifier
+            }
+            url.deleteLastPathComponent()
+        }
+        return nil
+    }
+    
     /// Check if an application is currently running
     private func isApplicationRunning(_ applicationPath: String) -> Bool {
         let task = Process()
@@ -235,7 +312,7 @@ public class DYLDInjectionManager {
             return "# Error: Hook library not found at \(hookLibraryPath)"
         }
         
-        var command = "DYLD_INSERT_LIBRARIES=\(hookLibraryPath) "
+        var command = "DYLD_INSERT_LIBRARIES=\(hookLibraryPath) PRIVARION_HOOK_STATS=1 \(HookEventStream.environmentKey)=1 \(SyscallHookManager.lazyActivationEnvironmentKey)=1 "
         
         if configuration.getCurrentConfiguration().global.logLevel == .debug {
             command += "PRIVARION_DEBUG=1 "
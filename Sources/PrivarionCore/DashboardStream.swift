@@ -0,0 +1,681 @@
+import Foundation
+import NIOCore
+import NIOWebSocket
+import Logging
+
+// MARK: - Frame Format
+
+/// Wire format a dashboard client asked for when it connected
+internal enum DashboardFrameFormat: String, Sendable {
+    /// One JSON `DashboardMessage` per text frame
+    case json
+    /// Compact `DashboardBinaryFrame`s, with dashboard state sent as deltas
+    case binary
+
+    /// Format from the upgrade request, e.g. `/dashboard?format=binary`
+    init(uri: String) {
+        let query = uri.split(separator: "?", maxSplits: 1).dropFirst().first ?? ""
+        let binary = query.split(separator: "&").contains { $0 == "format=binary" }
+        self = binary ? .binary : .json
+    }
+}
+
+// MARK: - Dashboard State
+
+/// Dashboard state as versioned key/value pairs
+/// Every change bumps the table version and stamps the changed keys with it,
+/// so the state a client lacks is whatever changed after the version it last
+/// acknowledged. Removed keys are remembered up to `maxRemovals`; a client
+/// whose version predates the forgotten removals gets a full snapshot.
+internal struct DashboardStateTable {
+
+    /// Changes a client needs to move from `baseVersion` to `version`
+    internal struct Delta: Equatable {
+        /// Version the delta applies to; 0 for a snapshot
+        let baseVersion: UInt64
+        let version: UInt64
+        /// A snapshot replaces the client state instead of patching it
+        let isSnapshot: Bool
+        /// Changed keys and values, sorted by key
+        let changes: [Change]
+        /// Removed keys, sorted
+        let removals: [String]
+
+        internal struct Change: Equatable {
+            let key: String
+            let value: Double
+        }
+
+        var isEmpty: Bool {
+            return !isSnapshot && changes.isEmpty && removals.isEmpty
+        }
+    }
+
+    private struct Entry {
+        var value: Double
+        var version: UInt64
+    }
+
+    private(set) var version: UInt64 = 0
+    private var entries: [String: Entry] = [:]
+    private var removals: [String: UInt64] = [:]
+
+    /// Removals at or below this version have been forgotten
+    private(set) var removalHorizon: UInt64 = 0
+
+    let maxRemovals: Int
+
+    init(maxRemovals: Int = 1024) {
+        self.maxRemovals = max(maxRemovals, 0)
+    }
+
+    var values: [String: Double] {
+        return entries.mapValues { $0.value }
+    }
+
+    /// Replace the whole state
+    /// - Returns: Whether anything changed; the version only advances if so
+    @discardableResult
+    mutating func replace(with values: [String: Double]) -> Bool {
+        let next = version + 1
+        var changed = false
+
+        for (key, value) in values where entries[key]?.value.bitPattern != value.bitPattern {
+            entries[key] = Entry(value: value, version: next)
+            removals.removeValue(forKey: key)
+            changed = true
+        }
+        for key in entries.keys.filter({ values[$0] == nil }) {
+            entries.removeValue(forKey: key)
+            removals[key] = next
+            changed = true
+        }
+
+        guard changed else { return false }
+        version = next
+        pruneRemovals()
+        return true
+    }
+
+    /// Changes after `base`, or a snapshot if `base` cannot be patched
+    func delta(since base: UInt64) -> Delta {
+        if base == 0 || base < removalHorizon || base > version {
+            let changes = entries.map { Delta.Change(key: $0.key, value: $0.value.value) }
+            return Delta(
+                baseVersion: 0,
+                version: version,
+                isSnapshot: true,
+                changes: changes.sorted { $0.key < $1.key },
+                removals: []
+            )
+        }
+
+        let changes = entries.filter { $0.value.version > base }.map { Delta.Change(key: $0.key, value: $0.value.value) }
+        let removed = removals.filter { $0.value > base }.map { $0.key }
+        return Delta(
+            baseVersion: base,
+            version: version,
+            isSnapshot: false,
+            changes: changes.sorted { $0.key < $1.key },
+            removals: removed.sorted()
+        )
+    }
+
+    private mutating func pruneRemovals() {
+        guard removals.count > maxRemovals else { return }
+        let forgotten = removals.sorted { $0.value < $1.value }.prefix(removals.count - maxRemovals)
+        for (key, _) in forgotten {
+            removals.removeValue(forKey: key)
+        }
+        removalHorizon = max(removalHorizon, forgotten.last?.value ?? 0)
+    }
+}
+
+// MARK: - Binary Frames
+
+/// Compact binary dashboard frames
+///
+/// Every frame starts with a format version byte and a kind byte. Integers
+/// are little-endian, values are IEEE 754 bit patterns, and strings are a
+/// UInt16 byte length followed by UTF-8.
+///
+/// - `networkEvents`: UInt64 timestamp in milliseconds, UInt8 entry count,
+///   then per entry a UInt8 event code and a UInt32 count.
+/// - `stateDelta`: UInt8 flags (bit 0: snapshot), UInt64 base version,
+///   UInt64 version, UInt32 change count, changes as key and UInt64 value,
+///   UInt32 removal count, removed keys.
+/// - `acknowledge` (client to server): UInt64 version the client applied.
+internal enum DashboardBinaryFrame {
+
+    static let formatVersion: UInt8 = 1
+
+    internal enum Kind: UInt8 {
+        case networkEvents = 1
+        case stateDelta = 2
+        case acknowledge = 0x80
+    }
+
+    private static let snapshotFlag: UInt8 = 0x01
+
+    static func networkEvents(
+        _ counts: [(eventType: DashboardEventType, count: Int)],
+        timestamp: Date,
+        allocator: ByteBufferAllocator = ByteBufferAllocator()
+    ) -> ByteBuffer {
+        let entries = counts.prefix(Int(UInt8.max))
+        var buffer = allocator.buffer(capacity: 11 + entries.count * 5)
+        writeHeader(.networkEvents, to: &buffer)
+        buffer.writeInteger(UInt64(max(timestamp.timeIntervalSince1970 * 1000, 0)), endianness: .little)
+        buffer.writeInteger(UInt8(entries.count))
+        for entry in entries {
+            buffer.writeInteger(entry.eventType.binaryCode)
+            buffer.writeInteger(UInt32(clamping: entry.count), endianness: .little)
+        }
+        return buffer
+    }
+
+    static func stateDelta(
+        _ delta: DashboardStateTable.Delta,
+        allocator: ByteBufferAllocator = ByteBufferAllocator()
+    ) -> ByteBuffer {
+        var buffer = allocator.buffer(capacity: 27 + delta.changes.count * 24 + delta.removals.count * 16)
+        writeHeader(.stateDelta, to: &buffer)
+        buffer.writeInteger(delta.isSnapshot ? snapshotFlag : 0)
+        buffer.writeInteger(delta.baseVersion, endianness: .little)
+        buffer.writeInteger(delta.version, endianness: .little)
+        buffer.writeInteger(UInt32(delta.changes.count), endianness: .little)
+        for change in delta.changes {
+            writeString(change.key, to: &buffer)
+            buffer.writeInteger(change.value.bitPattern, endianness: .little)
+        }
+        buffer.writeInteger(UInt32(delta.removals.count), endianness: .little)
+        for key in delta.removals {
+            writeString(key, to: &buffer)
+        }
+        return buffer
+    }
+
+    static func acknowledge(version: UInt64, allocator: ByteBufferAllocator = ByteBufferAllocator()) -> ByteBuffer {
+        var buffer = allocator.buffer(capacity: 10)
+        writeHeader(.acknowledge, to: &buffer)
+        buffer.writeInteger(version, endianness: .little)
+        return buffer
+    }
+
+    /// Version acknowledged by a client frame, nil if it is not an acknowledgement
+    static func acknowledgedVersion(in frame: ByteBuffer) -> UInt64? {
+        var buffer = frame
+        guard readHeader(from: &buffer) == .acknowledge else { return nil }
+        return buffer.readInteger(endianness: .little, as: UInt64.self)
+    }
+
+    /// Decode a state delta frame, nil if it is malformed or of another kind
+    static func decodeStateDelta(_ frame: ByteBuffer) -> DashboardStateTable.Delta? {
+        var buffer = frame
+        guard readHeader(from: &buffer) == .stateDelta,
+              let flags = buffer.readInteger(as: UInt8.self),
+              let baseVersion = buffer.readInteger(endianness: .little, as: UInt64.self),
+              let version = buffer.readInteger(endianness: .little, as: UInt64.self),
+              let changeCount = buffer.readInteger(endianness: .little, as: UInt32.self) else {
+            return nil
+        }
+
+        var changes: [DashboardStateTable.Delta.Change] = []
+        for _ in 0..<changeCount {
+            guard let key = readString(from: &buffer),
+                  let bits = buffer.readInteger(endianness: .little, as: UInt64.self) else {
+                return nil
+            }
+            changes.append(DashboardStateTable.Delta.Change(key: key, value: Double(bitPattern: bits)))
+        }
+
+        guard let removalCount = buffer.readInteger(endianness: .little, as: UInt32.self) else { return nil }
+        var removals: [String] = []
+        for _ in 0..<removalCount {
+            guard let key = readString(from: &buffer) else { return nil }
+            removals.append(key)
+        }
+
+        return DashboardStateTable.Delta(
+            baseVersion: baseVersion,
+            version: version,
+            isSnapshot: flags & snapshotFlag != 0,
+            changes: changes,
+            removals: removals
+        )
+    }
+
+    /// Decode a network events frame into per-type counts
+    static func decodeNetworkEvents(_ frame: ByteBuffer) -> [DashboardEventType: Int]? {
+        var buffer = frame
+        guard readHeader(from: &buffer) == .networkEvents,
+              buffer.readInteger(endianness: .little, as: UInt64.self) != nil,
+              let entryCount = buffer.readInteger(as: UInt8.self) else {
+            return nil
+        }
+
+        var counts: [DashboardEventType: Int] = [:]
+        for _ in 0..<entryCount {
+            guard let code = buffer.readInteger(as: UInt8.self),
+                  let count = buffer.readInteger(endianness: .little, as: UInt32.self),
+                  let eventType = DashboardEventType(binaryCode: code) else {
+                return nil
+            }
+            counts[eventType, default: 0] += Int(count)
+        }
+        return counts
+    }
+
+    private static func writeHeader(_ kind: Kind, to buffer: inout ByteBuffer) {
+        buffer.writeInteger(formatVersion)
+        buffer.writeInteger(kind.rawValue)
+    }
+
+    private static func readHeader(from buffer: inout ByteBuffer) -> Kind? {
+        guard buffer.readInteger(as: UInt8.self) == formatVersion,
+              let kind = buffer.readInteger(as: UInt8.self) else {
+            return nil
+        }
+        return Kind(rawValue: kind)
+    }
+
+    private static func writeString(_ string: String, to buffer: inout ByteBuffer) {
+        let bytes = Array(string.utf8.prefix(Int(UInt16.max)))
+        buffer.writeInteger(UInt16(bytes.count), endianness: .little)
+        buffer.writeBytes(bytes)
+    }
+
+    private static func readString(from buffer: inout ByteBuffer) -> String? {
+        guard let length = buffer.readInteger(endianness: .little, as: UInt16.self) else { return nil }
+        return buffer.readString(length: Int(length))
+    }
+}
+
+extension DashboardEventType {
+
+    /// Stable code used in binary frames
+    var binaryCode: UInt8 {
+        switch self {
+        case .connectionEstablished: return 1
+        case .connectionClosed: return 2
+        case .dataTransferred: return 3
+        case .dnsQuery: return 4
+        case .performanceMetric: return 5
+        case .error: return 6
+        }
+    }
+
+    init?(binaryCode: UInt8) {
+        switch binaryCode {
+        case 1: self = .connectionEstablished
+        case 2: self = .connectionClosed
+        case 3: self = .dataTransferred
+        case 4: self = .dnsQuery
+        case 5: self = .performanceMetric
+        case 6: self = .error
+        default: return nil
+        }
+    }
+
+    /// Subscription a client needs to receive this event
+    var subscription: WebSocketDashboardServer.DashboardClient.EventSubscription {
+        switch self {
+        case .connectionEstablished, .connectionClosed:
+            return .connectionEvents
+        case .dataTransferred:
+            return .trafficEvents
+        case .dnsQuery:
+            return .dnsEvents
+        case .performanceMetric:
+            return .performanceMetrics
+        case .error:
+            return .errorEvents
+        }
+    }
+}
+
+// MARK: - Broadcast Coalescer
+
+/// Per-tick coalescing stage between dashboard producers and clients
+///
+/// Producers only enqueue. Once per tick every pending update is encoded
+/// once into a shared `ByteBuffer`, and each client gets frames that point
+/// at those buffers, written and flushed in one event loop hop. Binary clients
+/// receive state as deltas against the version they last acknowledged.
+/// Clients whose channel is not writable skip the tick's network events and
+/// state updates; state catches up on the next writable tick, because deltas
+/// are cumulative and a JSON client that skipped a package gets the latest one.
+internal final class DashboardBroadcastCoalescer: @unchecked Sendable {
+
+    typealias EventSubscription = WebSocketDashboardServer.DashboardClient.EventSubscription
+
+    /// Broadcast delivery counters
+    internal struct Statistics: Sendable {
+        var ticks = 0
+        var framesEncoded = 0
+        var framesWritten = 0
+        /// Times a client was not writable and skipped a tick's updates
+        var backpressureSkips = 0
+        var eventsDropped = 0
+    }
+
+    private struct Subscriber {
+        let channel: Channel
+        let format: DashboardFrameFormat
+        let subscriptions: Set<EventSubscription>
+        var acknowledgedVersion: UInt64 = 0
+        var sentVersion: UInt64 = 0
+        /// A JSON client skipped a state package while not writable
+        var packageBehind = false
+
+        func isSubscribed(to subscription: EventSubscription?) -> Bool {
+            guard let subscription = subscription else { return true }
+            return subscriptions.contains(.all) || subscriptions.contains(subscription)
+        }
+    }
+
+    private struct PendingMessage {
+        let message: DashboardMessage
+        let subscription: EventSubscription?
+    }
+
+    /// Frames encoded once for the tick, shared by every client
+    private struct TickFrames {
+        var messages: [(buffer: ByteBuffer, subscription: EventSubscription?)] = []
+        var package: ByteBuffer?
+        var events: [DashboardEventType] = []
+        var binaryEvents: [Set<EventSubscription>: ByteBuffer] = [:]
+        var deltas: [UInt64: ByteBuffer] = [:]
+    }
+
+    private let logger = Logger(label: "privarion.dashboard.broadcast")
+    private let queue = DispatchQueue(label: "privarion.dashboard.broadcast", qos: .userInitiated)
+    private let allocator = ByteBufferAllocator()
+    private let encoder: JSONEncoder
+    private let interval: TimeInterval
+    private let maxPendingEvents: Int
+
+    private var timer: DispatchSourceTimer?
+    private var subscribers: [String: Subscriber] = [:]
+    private var pendingEvents: [DashboardEventType] = []
+    private var pendingMessages: [PendingMessage] = []
+    private var pendingPackage: DashboardMessage?
+    /// Last encoded state package, resent to JSON clients that skipped it
+    private var latestPackage: ByteBuffer?
+    private var state: DashboardStateTable
+    private var stateChanged = false
+    /// A client skipped state it still needs; tick again even if idle
+    private var stateBehind = false
+    private var statistics = Statistics()
+
+    /// JSON frames for network events never change, so they are encoded once
+    private var eventFrames: [DashboardEventType: ByteBuffer] = [:]
+
+    /// - Parameters:
+    ///   - interval: Seconds between broadcast ticks
+    ///   - maxPendingEvents: Network events kept per tick; later ones are dropped
+    ///   - maxStateRemovals: Removed state keys remembered for deltas
+    init(interval: TimeInterval = 0.1, maxPendingEvents: Int = 1000, maxStateRemovals: Int = 1024) {
+        self.interval = max(interval, 0.001)
+        self.maxPendingEvents = max(maxPendingEvents, 1)
+        self.state = DashboardStateTable(maxRemovals: maxStateRemovals)
+        self.encoder = JSONEncoder()
+        self.encoder.dateEncodingStrategy = .iso8601
+    }
+
+    deinit {
+        timer?.cancel()
+    }
+
+    // MARK: - Lifecycle
+
+    func start() {
+        queue.async {
+            guard self.timer == nil else { return }
+            let timer = DispatchSource.makeTimerSource(queue: self.queue)
+            timer.schedule(deadline: .now() + self.interval, repeating: self.interval)
+            timer.setEventHandler { [weak self] in
+                self?.tick()
+            }
+            timer.resume()
+            self.timer = timer
+        }
+    }
+
+    /// Stop ticking after sending whatever is still pending
+    func stop() {
+        queue.async {
+            self.timer?.cancel()
+            self.timer = nil
+            self.tick()
+        }
+    }
+
+    /// Run a tick now and wait for it
+    func flush() {
+        queue.sync {
+            tick()
+        }
+    }
+
+    var currentStatistics: Statistics {
+        return queue.sync { statistics }
+    }
+
+    var stateVersion: UInt64 {
+        return queue.sync { state.version }
+    }
+
+    // MARK: - Clients
+
+    func register(
+        clientId: String,
+        channel: Channel,
+        format: DashboardFrameFormat,
+        subscriptions: Set<EventSubscription>
+    ) {
+        queue.async {
+            self.subscribers[clientId] = Subscriber(channel: channel, format: format, subscriptions: subscriptions)
+            self.stateChanged = self.stateChanged || format == .binary
+        }
+    }
+
+    func unregister(clientId: String) {
+        queue.async {
+            self.subscribers.removeValue(forKey: clientId)
+        }
+    }
+
+    /// Record the state version a binary client has applied
+    func acknowledge(clientId: String, version: UInt64) {
+        queue.async {
+            guard var subscriber = self.subscribers[clientId] else { return }
+            subscriber.acknowledgedVersion = min(max(subscriber.acknowledgedVersion, version), self.state.version)
+            self.subscribers[clientId] = subscriber
+        }
+    }
+
+    // MARK: - Producers
+
+    func enqueue(_ eventType: DashboardEventType) {
+        queue.async {
+            guard self.pendingEvents.count < self.maxPendingEvents else {
+                self.statistics.eventsDropped += 1
+                return
+            }
+            self.pendingEvents.append(eventType)
+        }
+    }
+
+    /// Queue a message for every client subscribed to `subscription`, nil for all
+    func enqueue(_ message: DashboardMessage, subscription: EventSubscription? = nil) {
+        queue.async {
+            self.pendingMessages.append(PendingMessage(message: message, subscription: subscription))
+        }
+    }
+
+    /// Replace the dashboard state
+    /// JSON clients get `package` with the latest state of the tick; binary
+    /// clients get `values` as a delta.
+    func updateState(_ values: [String: Double], package: DashboardMessage) {
+        queue.async {
+            self.pendingPackage = package
+            if self.state.replace(with: values) {
+                self.stateChanged = true
+            }
+        }
+    }
+
+    // MARK: - Tick
+
+    private func tick() {
+        guard !subscribers.isEmpty else {
+            discardPending()
+            return
+        }
+        guard !pendingEvents.isEmpty || !pendingMessages.isEmpty || pendingPackage != nil || stateChanged else {
+            return
+        }
+        statistics.ticks += 1
+
+        var frames = encodeSharedFrames()
+        stateBehind = false
+        for (clientId, subscriber) in subscribers {
+            let outgoing = outgoingFrames(for: clientId, subscriber: subscriber, shared: &frames)
+            write(outgoing, to: subscriber.channel)
+        }
+        discardPending()
+    }
+
+    private func discardPending() {
+        pendingEvents.removeAll(keepingCapacity: true)
+        pendingMessages.removeAll(keepingCapacity: true)
+        pendingPackage = nil
+        stateChanged = stateBehind
+    }
+
+    /// Encode the tick's JSON messages once
+    private func encodeSharedFrames() -> TickFrames {
+        var frames = TickFrames()
+        frames.events = pendingEvents
+        frames.messages = pendingMessages.compactMap { pending in
+            encodeJSON(pending.message).map { (buffer: $0, subscription: pending.subscription) }
+        }
+        frames.package = pendingPackage.flatMap(encodeJSON)
+        if let package = frames.package {
+            latestPackage = package
+        }
+        return frames
+    }
+
+    private func outgoingFrames(for clientId: String, subscriber: Subscriber, shared: inout TickFrames) -> [WebSocketFrame] {
+        var outgoing = shared.messages
+            .filter { subscriber.isSubscribed(to: $0.subscription) }
+            .map { WebSocketFrame(fin: true, opcode: .text, data: $0.buffer) }
+
+        // Backpressure: a slow client skips intermediate events and state
+        guard subscriber.channel.isWritable else {
+            statistics.backpressureSkips += 1
+            statistics.eventsDropped += shared.events.count
+            switch subscriber.format {
+            case .json:
+                let behind = subscriber.packageBehind || shared.package != nil
+                subscribers[clientId]?.packageBehind = behind
+                stateBehind = stateBehind || behind
+            case .binary:
+                stateBehind = stateBehind || subscriber.sentVersion != state.version
+            }
+            return outgoing
+        }
+
+        switch subscriber.format {
+        case .json:
+            for eventType in shared.events where subscriber.isSubscribed(to: eventType.subscription) {
+                if let buffer = jsonFrame(for: eventType) {
+                    outgoing.append(WebSocketFrame(fin: true, opcode: .text, data: buffer))
+                }
+            }
+            if let package = shared.package ?? (subscriber.packageBehind ? latestPackage : nil) {
+                outgoing.append(WebSocketFrame(fin: true, opcode: .text, data: package))
+            }
+            subscribers[clientId]?.packageBehind = false
+
+        case .binary:
+            if let events = binaryEventsFrame(for: subscriber.subscriptions, shared: &shared) {
+                outgoing.append(WebSocketFrame(fin: true, opcode: .binary, data: events))
+            }
+            if subscriber.sentVersion != state.version {
+                if let delta = deltaFrame(since: subscriber.acknowledgedVersion, shared: &shared) {
+                    outgoing.append(WebSocketFrame(fin: true, opcode: .binary, data: delta))
+                }
+                subscribers[clientId]?.sentVersion = state.version
+            }
+        }
+        return outgoing
+    }
+
+    private func binaryEventsFrame(for subscriptions: Set<EventSubscription>, shared: inout TickFrames) -> ByteBuffer? {
+        if let cached = shared.binaryEvents[subscriptions] {
+            return cached
+        }
+
+        var counts: [DashboardEventType: Int] = [:]
+        for eventType in shared.events where subscriptions.contains(.all) || subscriptions.contains(eventType.subscription) {
+            counts[eventType, default: 0] += 1
+        }
+        guard !counts.isEmpty else { return nil }
+
+        let entries = counts.sorted { $0.key.binaryCode < $1.key.binaryCode }.map { (eventType: $0.key, count: $0.value) }
+        let buffer = DashboardBinaryFrame.networkEvents(entries, timestamp: Date(), allocator: allocator)
+        shared.binaryEvents[subscriptions] = buffer
+        statistics.framesEncoded += 1
+        return buffer
+    }
+
+    /// Delta frames are shared by every client at the same acknowledged version
+    private func deltaFrame(since base: UInt64, shared: inout TickFrames) -> ByteBuffer? {
+        let delta = state.delta(since: base)
+        guard !delta.isEmpty else { return nil }
+        if let cached = shared.deltas[delta.baseVersion] {
+            return cached
+        }
+        let buffer = DashboardBinaryFrame.stateDelta(delta, allocator: allocator)
+        shared.deltas[delta.baseVersion] = buffer
+        statistics.framesEncoded += 1
+        return buffer
+    }
+
+    private func jsonFrame(for eventType: DashboardEventType) -> ByteBuffer? {
+        if let cached = eventFrames[eventType] {
+            return cached
+        }
+        let buffer = encodeJSON(.networkEvent(eventType: eventType))
+        eventFrames[eventType] = buffer
+        return buffer
+    }
+
+    private func encodeJSON(_ message: DashboardMessage) -> ByteBuffer? {
+        do {
+            let data = try encoder.encode(message)
+            var buffer = allocator.buffer(capacity: data.count)
+            buffer.writeBytes(data)
+            statistics.framesEncoded += 1
+            return buffer
+        } catch {
+            logger.error("Failed to encode dashboard message: \(error)")
+            return nil
+        }
+    }
+
+    /// Write a client's frames in one event loop hop with a single flush
+    private func write(_ frames: [WebSocketFrame], to channel: Channel) {
+        guard !frames.isEmpty else { return }
+        statistics.framesWritten += frames.count
+        channel.eventLoop.execute {
+            for frame in frames {
+                channel.write(frame, promise: nil)
+            }
+            channel.flush()
+        }
+    }
+}
@@ -0,0 +1,803 @@
+import Foundation
+
+/// Immutable, compiled set of domain rules matched by walking labels right to left
+/// Each rule carries a small tag; a lookup returns the lowest tag of any rule
+/// that matches. Supported rule shapes, all case-insensitive:
+/// - `example.com` matches the domain and every subdomain
+/// - `*.example.com` matches subdomains only
+/// - `*.analytics.*` matches the labels anywhere with at least one label on either side
+/// - any other pattern containing `*` is a glob over the whole name
+/// The first three share one reverse-label trie, so a lookup is a single walk
+/// over the name with a binary search per label and no allocation.
+///
+/// The trie lives in a flat image (see `Image`) that is either built in
+/// memory or mapped read-only from a file, so processes loading the same
+/// image share its pages. Patches are layered on top without rebuilding it.
+internal final class DomainRuleTrie: @unchecked Sendable {
+
+    /// Reported by `match` when no rule applies
+    internal static let noMatch: UInt8 = .max
+
+    /// One rule as compiled into a trie or carried by a patch
+    internal struct Rule: Hashable {
+        let pattern: String
+        let tag: UInt8
+    }
+
+    private static let suffixRoot = 0
+    private static let infixRoot = 1
+
+    private let image: Image
+
+    /// Rules layered over the image by patches
+    private let overlay: Overlay?
+
+    /// Number of rules compiled in, patches included
+    internal let ruleCount: Int
+
+    /// Compile rules; patterns are expected lowercased and trimmed
+    /// Duplicate patterns keep the lowest tag.
+    internal convenience init<S: Sequence>(rules: S) where S.Element == (pattern: String, tag: UInt8) {
+        self.init(compiling: rules.map { Rule(pattern: $0.pattern, tag: $0.tag) })
+    }
+
+    /// An empty rule set
+    internal convenience init() {
+        self.init(compiling: [])
+    }
+
+    /// Map a compiled image read-only
+    /// - Throws: `BlocklistImageError` if the file is not a valid image
+    internal convenience init(contentsOf url: URL) throws {
+        self.init(image: try Image(mapping: url), overlay: nil)
+    }
+
+    private convenience init(compiling rules: [Rule]) {
+        let builder = Builder()
+        for rule in rules where !rule.pattern.isEmpty {
+            builder.insert(rule)
+        }
+        self.init(image: builder.makeImage(), overlay: nil)
+    }
+
+    private init(image: Image, overlay: Overlay?) {
+        self.image = image
+        self.overlay = overlay
+        self.ruleCount = Int(image.ruleCount) + (overlay.map { $0.additions.ruleCount - $0.removedPatterns.count } ?? 0)
+    }
+
+    /// Checksum of the underlying image; patches name the image they apply to
+    internal var imageChecksum: UInt64 {
+        return image.checksum
+    }
+
+    /// Write the underlying image, replacing any file atomically so
+    /// processes that mapped the previous version keep a consistent view
+    /// Patches applied on top are not included.
+    internal func writeImage(to url: URL) throws {
+        let data = Data(bytes: image.base, count: image.length)
+        try data.write(to: url, options: .atomic)
+    }
+
+    /// Lowest tag of any rule matching the domain, `noMatch` if none
+    /// ASCII letters are folded and surrounding whitespace ignored on the fly;
+    /// names with other non-ASCII bytes are normalised first.
+    internal func match(_ domain: String) -> UInt8 {
+        if let tag = domain.utf8.withContiguousStorageIfAvailable({ match(bytes: $0, normalized: false) }),
+           let tag = tag {
+            return tag
+        }
+        let normalized = domain.lowercased().trimmingCharacters(in: .whitespacesAndNewlines)
+        return match(bytes: Array(normalized.utf8), normalized: true) ?? Self.noMatch
+    }
+
+    /// Match a name that is already lowercase, dotted and trimmed
+    /// Used by wire-format parsers that canonicalise while reading.
+    internal func match(canonical name: UnsafeBufferPointer<UInt8>) -> UInt8 {
+        return match(bytes: name, normalized: true) ?? Self.noMatch
+    }
+
+    /// Whether any rule matches the domain
+    internal func contains(_ domain: String) -> Bool {
+        return match(domain) != Self.noMatch
+    }
+
+    // MARK: - Patches
+
+    /// Layer a patch over this trie without rebuilding the image
+    /// Removing a pattern suppresses the image slot it compiled to, whatever
+    /// its tag. Patches compose, so a patch may undo an earlier one.
+    /// - Throws: `BlocklistImageError.patchMismatch` if the patch was made for another image
+    internal func applying(_ patch: BlocklistPatch) throws -> DomainRuleTrie {
+        guard patch.baseChecksum == image.checksum else {
+            throw BlocklistImageError.patchMismatch(expected: image.checksum, found: patch.baseChecksum)
+        }
+
+        let dropped = Set(patch.removed.map { $0.pattern })
+        var added = (overlay?.addedRules ?? []).filter { !dropped.contains($0.pattern) }
+        added.append(contentsOf: patch.added)
+
+        var removed = overlay?.removed ?? []
+        var removedPatterns = overlay?.removedPatterns ?? []
+        for rule in patch.removed {
+            let slots = image.slots(for: rule.pattern)
+            if !slots.isEmpty {
+                removed.formUnion(slots)
+                removedPatterns.insert(rule.pattern)
+            }
+        }
+        // A removed pattern added back is served by the additions, so a
+        // changed tag replaces the old one instead of competing with it
+
+        let overlay = Overlay(
+            addedRules: added,
+            additions: DomainRuleTrie(compiling: added),
+            removed: removed,
+            removedPatterns: removedPatterns
+        )
+        return DomainRuleTrie(image: image, overlay: overlay)
+    }
+
+    // MARK: - Lookup
+
+    /// Match raw name bytes; nil if they need Unicode normalisation first
+    private func match<C: RandomAccessCollection>(bytes: C, normalized: Bool) -> UInt8? where C.Element == UInt8, C.Index == Int {
+        var begin = bytes.startIndex
+        var end = bytes.endIndex
+        while begin < end && Self.isSpace(bytes[begin]) { begin += 1 }
+        while end > begin && Self.isSpace(bytes[end - 1]) { end -= 1 }
+        if begin == end {
+            return Self.noMatch
+        }
+        if !normalized && bytes[begin..<end].contains(where: { $0 >= 0x80 }) {
+            return nil
+        }
+
+        let removed = overlay?.removed
+        var best = walkSuffixes(bytes, begin, end, removed)
+        if image.edgeCount(Self.infixRoot) > 0 {
+            best = min(best, walkInfixes(bytes, begin, end, removed))
+        }
+        for index in 0..<image.globCount where image.globTag(index) < best {
+            if image.globMatches(index, bytes, begin, end) && !Self.isRemoved(removed, Slot.glob(index)) {
+                best = image.globTag(index)
+            }
+        }
+        if let additions = overlay?.additions {
+            best = min(best, additions.match(bytes: bytes, normalized: true) ?? Self.noMatch)
+        }
+        return best
+    }
+
+    /// Walk labels from the top-level domain down through the suffix trie
+    private func walkSuffixes<C: RandomAccessCollection>(_ bytes: C, _ begin: Int, _ end: Int, _ removed: Set<UInt64>?) -> UInt8
+        where C.Element == UInt8, C.Index == Int {
+        var best = Self.noMatch
+        var node = Self.suffixRoot
+        var labelEnd = end
+
+        while true {
+            var labelStart = labelEnd
+            while labelStart > begin && bytes[labelStart - 1] != UInt8(ascii: ".") {
+                labelStart -= 1
+            }
+            guard let child = image.child(of: node, bytes, labelStart, labelEnd) else {
+                return best
+            }
+            node = child
+            if labelStart == begin {
+                let tag = image.exactTag(node)
+                return tag < best && !Self.isRemoved(removed, Slot.exact(node)) ? tag : best
+            }
+            let tag = image.subdomainTag(node)
+            if tag < best && !Self.isRemoved(removed, Slot.subdomain(node)) {
+                best = tag
+            }
+            labelEnd = labelStart - 1
+        }
+    }
+
+    /// Try the infix trie ending at every interior dot
+    private func walkInfixes<C: RandomAccessCollection>(_ bytes: C, _ begin: Int, _ end: Int, _ removed: Set<UInt64>?) -> UInt8
+        where C.Element == UInt8, C.Index == Int {
+        var best = Self.noMatch
+        var dot = end - 1
+
+        while dot > begin {
+            if bytes[dot] == UInt8(ascii: ".") {
+                var node = Self.infixRoot
+                var labelEnd = dot
+                while labelEnd > begin {
+                    var labelStart = labelEnd
+                    while labelStart > begin && bytes[labelStart - 1] != UInt8(ascii: ".") {
+                        labelStart -= 1
+                    }
+                    // An infix needs a label in front of it
+                    guard labelStart > begin, let child = image.child(of: node, bytes, labelStart, labelEnd) else {
+                        break
+                    }
+                    node = child
+                    let tag = image.infixTag(node)
+                    if tag < best && !Self.isRemoved(removed, Slot.infix(node)) {
+                        best = tag
+                    }
+                    labelEnd = labelStart - 1
+                }
+            }
+            dot -= 1
+        }
+        return best
+    }
+
+    @inline(__always)
+    private static func isRemoved(_ removed: Set<UInt64>?, _ slot: UInt64) -> Bool {
+        guard let removed = removed, !removed.isEmpty else {
+            return false
+        }
+        return removed.contains(slot)
+    }
+
+    @inline(__always)
+    fileprivate static func fold(_ byte: UInt8) -> UInt8 {
+        return byte &- 0x41 < 26 ? byte | 0x20 : byte
+    }
+
+    @inline(__always)
+    private static func isSpace(_ byte: UInt8) -> Bool {
+        return byte == 0x20 || (byte >= 0x09 && byte <= 0x0D)
+    }
+
+    fileprivate static func hash<C: Collection>(_ label: C) -> UInt64 where C.Element == UInt8 {
+        var hash: UInt64 = 14695981039346656037
+        for byte in label {
+            hash = (hash ^ UInt64(fold(byte))) &* 1099511628211
+        }
+        return hash
+    }
+
+    // MARK: - Rule Shapes
+
+    fileprivate enum Shape {
+        case domainAndSubdomains(Substring)
+        case subdomainsOnly(Substring)
+        case infix(Substring)
+        case glob
+    }
+
+    fileprivate static func shape(of pattern: String) -> Shape {
+        guard pattern.contains("*") else {
+            return .domainAndSubdomains(pattern[...])
+        }
+        if pattern.hasPrefix("*.") {
+            let rest = pattern.dropFirst(2)
+            if !rest.isEmpty && !rest.contains("*") {
+                return .subdomainsOnly(rest)
+            }
+            if rest.hasSuffix(".*") {
+                let infix = rest.dropLast(2)
+                if !infix.isEmpty && !infix.contains("*") {
+                    return .infix(infix)
+                }
+            }
+        }
+        return .glob
+    }
+
+    /// Identifies one tag slot of the image, for removals
+    fileprivate enum Slot {
+        static func exact(_ node: Int) -> UInt64 { return UInt64(node) << 2 }
+        static func subdomain(_ node: Int) -> UInt64 { return UInt64(node) << 2 | 1 }
+        static func infix(_ node: Int) -> UInt64 { return UInt64(node) << 2 | 2 }
+        static func glob(_ index: Int) -> UInt64 { return UInt64(index) << 2 | 3 }
+    }
+
+    private struct Overlay {
+        let addedRules: [Rule]
+        let additions: DomainRuleTrie
+        /// Image slots suppressed by removals
+        let removed: Set<UInt64>
+        /// Image patterns those slots came from
+        let removedPatterns: Set<String>
+    }
+}
+
+// MARK: - Image
+
+extension DomainRuleTrie {
+
+    /// Flat, position-independent trie image
+    /// Layout, native little-endian, every section 8-byte aligned:
+    /// - header (64 bytes): magic "PVBL", version, node/edge/glob counts,
+    ///   label and glob byte sizes, rule count, FNV-1a checksum of everything
+    ///   after the header, and the four section offsets
+    /// - nodes (16 bytes each): first edge, edge count, exact, subdomain and
+    ///   infix tags. Nodes 0 and 1 are the suffix and infix roots
+    /// - edges (24 bytes each): label hash, label offset and length, child,
+    ///   sorted by hash within each node
+    /// - label bytes, then glob records (8 bytes each: tag, length, offset)
+    ///   and glob bytes
+    fileprivate final class Image {
+        static let magic: UInt32 = 0x4C42_5650  // "PVBL"
+        static let version: UInt32 = 1
+        static let headerSize = 64
+        static let nodeSize = 16
+        static let edgeSize = 24
+        static let globSize = 8
+
+        let base: UnsafeRawPointer
+        let length: Int
+        let nodeCount: Int
+        let globCount: Int
+        let ruleCount: UInt32
+        let checksum: UInt64
+
+        private let nodes: UnsafeRawPointer
+        private let edges: UnsafeRawPointer
+        private let labels: UnsafeRawPointer
+        private let globs: UnsafeRawPointer
+        private let release: () -> Void
+
+        /// Section positions read from a header or known to the builder
+        struct Layout {
+            let nodeCount: Int
+            let globCount: Int
+            let ruleCount: UInt32
+            let checksum: UInt64
+            let nodesOffset: Int
+            let edgesOffset: Int
+            let labelsOffset: Int
+            let globsOffset: Int
+        }
+
+        /// Adopt an in-memory image built by `Builder`
+        /// The builder wrote the sections itself, so its layout is taken as
+        /// is rather than read back from the header.
+        convenience init(owning base: UnsafeMutableRawPointer, length: Int, layout: Layout) {
+            self.init(base: UnsafeRawPointer(base), length: length, layout: layout) {
+                base.deallocate()
+            }
+        }
+
+        /// Map an image file read-only and validate it
+        convenience init(mapping url: URL) throws {
+            let fd = open(url.path, O_RDONLY)
+            guard fd >= 0 else {
+                throw BlocklistImageError.unreadable(url.path, String(cString: strerror(errno)))
+            }
+            defer { close(fd) }
+
+            var info = stat()
+            guard fstat(fd, &info) == 0, info.st_size >= Image.headerSize else {
+                throw BlocklistImageError.invalidImage("File too small")
+            }
+            let length = Int(info.st_size)
+            guard let mapping = mmap(nil, length, PROT_READ, MAP_SHARED, fd, 0), mapping != MAP_FAILED else {
+                throw BlocklistImageError.unreadable(url.path, String(cString: strerror(errno)))
+            }
+
+            let layout: Layout
+            do {
+                layout = try Image.layout(of: UnsafeRawPointer(mapping), length: length)
+            } catch {
+                munmap(mapping, length)
+                throw error
+            }
+            self.init(base: UnsafeRawPointer(mapping), length: length, layout: layout) {
+                munmap(mapping, length)
+            }
+        }
+
+        private init(base: UnsafeRawPointer, length: Int, layout: Layout, release: @escaping () -> Void) {
+            self.base = base
+            self.length = length
+            self.nodeCount = layout.nodeCount
+            self.globCount = layout.globCount
+            self.ruleCount = layout.ruleCount
+            self.checksum = layout.checksum
+            self.nodes = base + layout.nodesOffset
+            self.edges = base + layout.edgesOffset
+            self.labels = base + layout.labelsOffset
+            self.globs = base + layout.globsOffset
+            self.release = release
+        }
+
+        /// Read the header, checking every section and reference
+        private static func layout(of base: UnsafeRawPointer, length: Int) throws -> Layout {
+            func field<T: FixedWidthInteger>(_ offset: Int, _ type: T.Type) -> T {
+                return base.load(fromByteOffset: offset, as: T.self)
+            }
+
+            guard field(0, UInt32.self) == magic else {
+                throw BlocklistImageError.invalidImage("Bad magic")
+            }
+            guard field(4, UInt32.self) == version else {
+                throw BlocklistImageError.unsupportedVersion(field(4, UInt32.self))
+            }
+
+            let layout = Layout(
+                nodeCount: Int(field(8, UInt32.self)),
+                globCount: Int(field(20, UInt32.self)),
+                ruleCount: field(28, UInt32.self),
+                checksum: field(32, UInt64.self),
+                nodesOffset: Int(field(40, UInt32.self)),
+                edgesOffset: Int(field(44, UInt32.self)),
+                labelsOffset: Int(field(48, UInt32.self)),
+                globsOffset: Int(field(52, UInt32.self))
+            )
+            let edgeCount = Int(field(12, UInt32.self))
+            let labelSize = Int(field(16, UInt32.self))
+            let globBytes = Int(field(24, UInt32.self))
+
+            guard layout.nodeCount >= 2,
+                  layout.nodesOffset >= headerSize, layout.nodesOffset % 8 == 0,
+                  layout.edgesOffset >= layout.nodesOffset + layout.nodeCount * nodeSize, layout.edgesOffset % 8 == 0,
+                  layout.labelsOffset >= layout.edgesOffset + edgeCount * edgeSize,
+                  layout.globsOffset >= layout.labelsOffset + labelSize, layout.globsOffset % 8 == 0,
+                  layout.globsOffset + layout.globCount * globSize + globBytes <= length else {
+                throw BlocklistImageError.invalidImage("Section table out of bounds")
+            }
+
+            guard fnv1a(base + headerSize, length - headerSize) == layout.checksum else {
+                throw BlocklistImageError.invalidImage("Checksum mismatch")
+            }
+            // Every reference must stay inside its section
+            for node in 0..<layout.nodeCount {
+                let record = base + layout.nodesOffset + node * nodeSize
+                let edgeEnd = Int(record.load(as: UInt32.self)) + Int(record.load(fromByteOffset: 4, as: UInt32.self))
+                guard edgeEnd <= edgeCount else {
+                    throw BlocklistImageError.invalidImage("Node \(node) edges out of bounds")
+                }
+            }
+            for edge in 0..<edgeCount {
+                let record = base + layout.edgesOffset + edge * edgeSize
+                let labelEnd = Int(record.load(fromByteOffset: 8, as: UInt32.self)) + Int(record.load(fromByteOffset: 12, as: UInt32.self))
+                guard Int(record.load(fromByteOffset: 16, as: UInt32.self)) < layout.nodeCount, labelEnd <= labelSize else {
+                    throw BlocklistImageError.invalidImage("Edge \(edge) out of bounds")
+                }
+            }
+            for glob in 0..<layout.globCount {
+                let record = base + layout.globsOffset + glob * globSize
+                let globEnd = Int(record.load(fromByteOffset: 4, as: UInt32.self)) + Int(record.load(fromByteOffset: 2, as: UInt16.self))
+                guard globEnd <= globBytes else {
+                    throw BlocklistImageError.invalidImage("Glob \(glob) out of bounds")
+                }
+            }
+            return layout
+        }
+
+        deinit {
+            release()
+        }
+
+        static func fnv1a(_ bytes: UnsafeRawPointer, _ count: Int) -> UInt64 {
+            var hash: UInt64 = 14695981039346656037
+            let buffer = UnsafeRawBufferPointer(start: bytes, count: count)
+            for byte in buffer {
+                hash = (hash ^ UInt64(byte)) &* 1099511628211
+            }
+            return hash
+        }
+
+        // MARK: Records
+
+        @inline(__always) func firstEdge(_ node: Int) -> UInt32 {
+            return nodes.load(fromByteOffset: node * Image.nodeSize, as: UInt32.self)
+        }
+
+        @inline(__always) func edgeCount(_ node: Int) -> UInt32 {
+            return nodes.load(fromByteOffset: node * Image.nodeSize + 4, as: UInt32.self)
+        }
+
+        @inline(__always) func exactTag(_ node: Int) -> UInt8 {
+            return nodes.load(fromByteOffset: node * Image.nodeSize + 8, as: UInt8.self)
+        }
+
+        @inline(__always) func subdomainTag(_ node: Int) -> UInt8 {
+            return nodes.load(fromByteOffset: node * Image.nodeSize + 9, as: UInt8.self)
+        }
+
+        @inline(__always) func infixTag(_ node: Int) -> UInt8 {
+            return nodes.load(fromByteOffset: node * Image.nodeSize + 10, as: UInt8.self)
+        }
+
+        @inline(__always) func globTag(_ index: Int) -> UInt8 {
+            return globs.load(fromByteOffset: index * Image.globSize, as: UInt8.self)
+        }
+
+        /// Child of `node` whose edge label equals `bytes[start..<end]`, folded
+        func child<C: RandomAccessCollection>(of node: Int, _ bytes: C, _ start: Int, _ end: Int) -> Int?
+            where C.Element == UInt8, C.Index == Int {
+            let hash = DomainRuleTrie.hash(bytes[start..<end])
+
+            var low = Int(firstEdge(node))
+            let last = low + Int(edgeCount(node))
+            var high = last
+            while low < high {
+                let mid = (low + high) >> 1
+                if edges.load(fromByteOffset: mid * Image.edgeSize, as: UInt64.self) < hash {
+                    low = mid + 1
+                } else {
+                    high = mid
+                }
+            }
+
+            while low < last {
+                let record = edges + low * Image.edgeSize
+                guard record.load(as: UInt64.self) == hash else {
+                    break
+                }
+                let labelStart = Int(record.load(fromByteOffset: 8, as: UInt32.self))
+                let labelLength = Int(record.load(fromByteOffset: 12, as: UInt32.self))
+                if labelLength == end - start {
+                    var equal = true
+                    for offset in 0..<labelLength where DomainRuleTrie.fold(bytes[start + offset]) != labels.load(fromByteOffset: labelStart + offset, as: UInt8.self) {
+                        equal = false
+                        break
+                    }
+                    if equal {
+                        return Int(record.load(fromByteOffset: 16, as: UInt32.self))
+                    }
+                }
+                low += 1
+            }
+            return nil
+        }
+
+        /// Glob match where `*` spans any run of bytes, dots included
+        func globMatches<C: RandomAccessCollection>(_ index: Int, _ bytes: C, _ begin: Int, _ end: Int) -> Bool
+            where C.Element == UInt8, C.Index == Int {
+            let record = globs + index * Image.globSize
+            let count = Int(record.load(fromByteOffset: 2, as: UInt16.self))
+            let pattern = globs + globCount * Image.globSize + Int(record.load(fromByteOffset: 4, as: UInt32.self))
+            let star = UInt8(ascii: "*")
+
+            var p = 0
+            var s = begin
+            var starP = -1
+            var starS = 0
+            while s < end {
+                let byte = p < count ? pattern.load(fromByteOffset: p, as: UInt8.self) : 0
+                if p < count && byte == star {
+                    starP = p
+                    starS = s
+                    p += 1
+                } else if p < count && byte == DomainRuleTrie.fold(bytes[s]) {
+                    p += 1
+                    s += 1
+                } else if starP >= 0 {
+                    p = starP + 1
+                    starS += 1
+                    s = starS
+                } else {
+                    return false
+                }
+            }
+            while p < count && pattern.load(fromByteOffset: p, as: UInt8.self) == star {
+                p += 1
+            }
+            return p == count
+        }
+
+        /// Image slots a pattern compiled to, if it is present
+        func slots(for pattern: String) -> [UInt64] {
+            let path: (Substring, Int)
+            switch DomainRuleTrie.shape(of: pattern) {
+            case .domainAndSubdomains(let labels):
+                path = (labels, DomainRuleTrie.suffixRoot)
+            case .subdomainsOnly(let labels):
+                path = (labels, DomainRuleTrie.suffixRoot)
+            case .infix(let labels):
+                path = (labels, DomainRuleTrie.infixRoot)
+            case .glob:
+                let bytes = Array(pattern.utf8)
+                return (0..<globCount).filter { index in
+                    let record = globs + index * Image.globSize
+                    let count = Int(record.load(fromByteOffset: 2, as: UInt16.self))
+                    let start = globs + globCount * Image.globSize + Int(record.load(fromByteOffset: 4, as: UInt32.self))
+                    return count == bytes.count && memcmp(start, bytes, count) == 0
+                }.map { DomainRuleTrie.Slot.glob($0) }
+            }
+
+            let bytes = Array(path.0.utf8)
+            var node = path.1
+            var labelEnd = bytes.count
+            while true {
+                var labelStart = labelEnd
+                while labelStart > 0 && bytes[labelStart - 1] != UInt8(ascii: ".") {
+                    labelStart -= 1
+                }
+                guard let next = child(of: node, bytes, labelStart, labelEnd) else {
+                    return []
+                }
+                node = next
+                if labelStart == 0 {
+                    break
+                }
+                labelEnd = labelStart - 1
+            }
+
+            switch DomainRuleTrie.shape(of: pattern) {
+            case .domainAndSubdomains:
+                return [DomainRuleTrie.Slot.exact(node), DomainRuleTrie.Slot.subdomain(node)]
+            case .subdomainsOnly:
+                return [DomainRuleTrie.Slot.subdomain(node)]
+            default:
+                return [DomainRuleTrie.Slot.infix(node)]
+            }
+        }
+    }
+}
+
+// MARK: - Builder
+
+extension DomainRuleTrie {
+
+    /// Mutable trie used only while compiling
+    fileprivate final class Builder {
+        private struct Node {
+            var exactTag = DomainRuleTrie.noMatch
+            var subdomainTag = DomainRuleTrie.noMatch
+            var infixTag = DomainRuleTrie.noMatch
+        }
+
+        private var children: [[Substring: Int]] = [[:], [:]]
+        private var nodes: [Node] = [Node(), Node()]
+        private var globs: [String: UInt8] = [:]
+        private var ruleCount = 0
+
+        func insert(_ rule: Rule) {
+            ruleCount += 1
+            switch DomainRuleTrie.shape(of: rule.pattern) {
+            case .domainAndSubdomains(let labels):
+                let node = insert(labels: labels, root: DomainRuleTrie.suffixRoot)
+                nodes[node].exactTag = min(nodes[node].exactTag, rule.tag)
+                nodes[node].subdomainTag = min(nodes[node].subdomainTag, rule.tag)
+            case .subdomainsOnly(let labels):
+                let node = insert(labels: labels, root: DomainRuleTrie.suffixRoot)
+                nodes[node].subdomainTag = min(nodes[node].subdomainTag, rule.tag)
+            case .infix(let labels):
+                let node = insert(labels: labels, root: DomainRuleTrie.infixRoot)
+                nodes[node].infixTag = min(nodes[node].infixTag, rule.tag)
+            case .glob:
+                globs[rule.pattern] = min(globs[rule.pattern] ?? DomainRuleTrie.noMatch, rule.tag)
+            }
+        }
+
+        private func insert(labels pattern: Substring, root: Int) -> Int {
+            var node = root
+            for label in pattern.split(separator: ".", omittingEmptySubsequences: false).reversed() {
+                if let child = children[node][label] {
+                    node = child
+                } else {
+                    let child = nodes.count
+                    nodes.append(Node())
+                    children.append([:])
+                    children[node][label] = child
+                    node = child
+                }
+            }
+            return node
+        }
+
+        /// Lay nodes out breadth first with each node's edges sorted by hash
+        func makeImage() -> Image {
+            struct FlatEdge {
+                let hash: UInt64
+                let labelStart: UInt32
+                let labelLength: UInt32
+                let child: UInt32
+            }
+
+            var flatNodes: [(first: UInt32, count: UInt32, node: Node)] = Array(repeating: (0, 0, Node()), count: nodes.count)
+            var edges: [FlatEdge] = []
+            edges.reserveCapacity(nodes.count)
+            var labelBytes: [UInt8] = []
+            var labelOffsets: [Substring: UInt32] = [:]
+
+            // Both roots keep their positions
+            var order = [DomainRuleTrie.suffixRoot, DomainRuleTrie.infixRoot]
+            var newIndex = [Int](repeating: -1, count: nodes.count)
+            newIndex[DomainRuleTrie.suffixRoot] = DomainRuleTrie.suffixRoot
+            newIndex[DomainRuleTrie.infixRoot] = DomainRuleTrie.infixRoot
+
+            var cursor = 0
+            while cursor < order.count {
+                let old = order[cursor]
+                cursor += 1
+
+                let sorted = children[old]
+                    .map { (hash: DomainRuleTrie.hash($0.key.utf8), label: $0.key, child: $0.value) }
+                    .sorted { $0.hash == $1.hash ? $0.label < $1.label : $0.hash < $1.hash }
+                flatNodes[newIndex[old]] = (UInt32(edges.count), UInt32(sorted.count), nodes[old])
+
+                for entry in sorted {
+                    let offset: UInt32
+                    if let existing = labelOffsets[entry.label] {
+                        offset = existing
+                    } else {
+                        offset = UInt32(labelBytes.count)
+                        labelBytes.append(contentsOf: entry.label.utf8)
+                        labelOffsets[entry.label] = offset
+                    }
+
+                    newIndex[entry.child] = order.count
+                    order.append(entry.child)
+                    edges.append(FlatEdge(hash: entry.hash, labelStart: offset, labelLength: UInt32(entry.label.utf8.count), child: UInt32(newIndex[entry.child])))
+                }
+            }
+
+            let sortedGlobs = globs.sorted { $0.key < $1.key }
+            let globBytes = sortedGlobs.reduce(0) { $0 + $1.key.utf8.count }
+
+            func aligned(_ offset: Int) -> Int { return (offset + 7) & ~7 }
+            let nodesOffset = Image.headerSize
+            let edgesOffset = nodesOffset + flatNodes.count * Image.nodeSize
+            let labelsOffset = edgesOffset + edges.count * Image.edgeSize
+            let globsOffset = aligned(labelsOffset + labelBytes.count)
+            let length = globsOffset + sortedGlobs.count * Image.globSize + globBytes
+
+            let byteCount = max(length, Image.headerSize)
+            let base = UnsafeMutableRawPointer.allocate(byteCount: byteCount, alignment: 16)
+            base.initializeMemory(as: UInt8.self, repeating: 0, count: byteCount)
+
+            for (index, entry) in flatNodes.enumerated() {
+                let record = base + nodesOffset + index * Image.nodeSize
+                record.storeBytes(of: entry.first, as: UInt32.self)
+                record.storeBytes(of: entry.count, toByteOffset: 4, as: UInt32.self)
+                record.storeBytes(of: entry.node.exactTag, toByteOffset: 8, as: UInt8.self)
+                record.storeBytes(of: entry.node.subdomainTag, toByteOffset: 9, as: UInt8.self)
+                record.storeBytes(of: entry.node.infixTag, toByteOffset: 10, as: UInt8.self)
+            }
+            for (index, edge) in edges.enumerated() {
+                let record = base + edgesOffset + index * Image.edgeSize
+                record.storeBytes(of: edge.hash, as: UInt64.self)
+                record.storeBytes(of: edge.labelStart, toByteOffset: 8, as: UInt32.self)
+                record.storeBytes(of: edge.labelLength, toByteOffset: 12, as: UInt32.self)
+                record.storeBytes(of: edge.child, toByteOffset: 16, as: UInt32.self)
+            }
+            labelBytes.withUnsafeBytes { bytes in
+                if let source = bytes.baseAddress {
+                    (base + labelsOffset).copyMemory(from: source, byteCount: bytes.count)
+                }
+            }
+            var globOffset = 0
+            let globData = base + globsOffset + sortedGlobs.count * Image.globSize
+            for (index, glob) in sortedGlobs.enumerated() {
+                let bytes = Array(glob.key.utf8)
+                let record = base + globsOffset + index * Image.globSize
+                record.storeBytes(of: glob.value, as: UInt8.self)
+                record.storeBytes(of: UInt16(bytes.count), toByteOffset: 2, as: UInt16.self)
+                record.storeBytes(of: UInt32(globOffset), toByteOffset: 4, as: UInt32.self)
+                (globData + globOffset).copyMemory(from: bytes, byteCount: bytes.count)
+                globOffset += bytes.count
+            }
+
+            base.storeBytes(of: Image.magic, as: UInt32.self)
+            base.storeBytes(of: Image.version, toByteOffset: 4, as: UInt32.self)
+            base.storeBytes(of: UInt32(flatNodes.count), toByteOffset: 8, as: UInt32.self)
+            base.storeBytes(of: UInt32(edges.count), toByteOffset: 12, as: UInt32.self)
+            base.storeBytes(of: UInt32(labelBytes.count), toByteOffset: 16, as: UInt32.self)
+            base.storeBytes(of: UInt32(sortedGlobs.count), toByteOffset: 20, as: UInt32.self)
+            base.storeBytes(of: UInt32(globBytes), toByteOffset: 24, as: UInt32.self)
+            base.storeBytes(of: UInt32(ruleCount), toByteOffset: 28, as: UInt32.self)
+            base.storeBytes(of: UInt32(nodesOffset), toByteOffset: 40, as: UInt32.self)
+            base.storeBytes(of: UInt32(edgesOffset), toByteOffset: 44, as: UInt32.self)
+            base.storeBytes(of: UInt32(labelsOffset), toByteOffset: 48, as: UInt32.self)
+            base.storeBytes(of: UInt32(globsOffset), toByteOffset: 52, as: UInt32.self)
+            let checksum = Image.fnv1a(base + Image.headerSize, length - Image.headerSize)
+            base.storeBytes(of: checksum, toByteOffset: 32, as: UInt64.self)
+
+            let layout = Image.Layout(
+                nodeCount: flatNodes.count,
+                globCount: sortedGlobs.count,
+                ruleCount: UInt32(ruleCount),
+                checksum: checksum,
+                nodesOffset: nodesOffset,
+                edgesOffset: edgesOffset,
+                labelsOffset: labelsOffset,
+                globsOffset: globsOffset
+            )
+            return Image(owning: base, length: byteCount, layout: layout)
+        }
+    }
+}
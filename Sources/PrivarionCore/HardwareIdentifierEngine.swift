@@ -132,6 +132,51 @@ public class HardwareIdentifierEngine {
         }
     }
     
+    /// Generate Mac model identifier (e.g., "MacBookPro18,3")
+    public func generateModelIdentifier(strategy: GenerationStrategy = .realistic) -> String {
+        let models = [
+            "MacBookPro18,3", "MacBookPro18,1", "MacBookAir10,1",
+            "Mac14,2", "Mac14,7", "Macmini9,1", "iMac21,1"
+        ]
+
+        switch strategy {
+        case .random:
+            return models.randomElement() ?? "MacBookPro18,3"
+        case .realistic, .vendorBased:
+            return models.prefix(4).randomElement() ?? "MacBookPro18,3"
+        default:
+            return "MacBookPro18,3"
+        }
+    }
+
+    /// Generate the identifier table the hook library answers
+    /// `sysctlbyname` and I/O Registry lookups from
+    /// Call once per session: every process launched with the same table
+    /// reports the same machine.
+    public func makeIdentifierTable(strategy: GenerationStrategy = .realistic) -> HardwareIdentifierTable {
+        let serialNumber = generateSerialNumber(strategy: strategy)
+        let platformUUID = UUID().uuidString
+        let model = generateModelIdentifier(strategy: strategy)
+        let macBytes = generateMACAddress(strategy: strategy)
+            .split(whereSeparator: { $0 == ":" || $0 == "-" })
+            .compactMap { UInt8($0, radix: 16) }
+
+        // The registry reports these as a NUL-terminated CFData
+        let modelData = Array(model.utf8) + [0]
+
+        var entries: [HardwareIdentifierTable.Entry] = [
+            .init(source: .sysctl, key: "hw.model", value: .string(model)),
+            .init(source: .sysctl, key: "kern.uuid", value: .string(platformUUID)),
+            .init(source: .ioRegistry, key: "IOPlatformSerialNumber", value: .string(serialNumber)),
+            .init(source: .ioRegistry, key: "IOPlatformUUID", value: .string(platformUUID)),
+            .init(source: .ioRegistry, key: "model", value: .data(modelData))
+        ]
+        if macBytes.count == 6 {
+            entries.append(.init(source: .ioRegistry, key: "IOMACAddress", value: .data(macBytes)))
+        }
+        return HardwareIdentifierTable(entries: entries)
+    }
+
     /// Validate generated MAC address
     public func validateMACAddress(_ mac: String) -> Bool {
         // Support both colon (:) and dash (-) separated MAC address formats
@@ -0,0 +1,160 @@
+import PrivarionHook
+import Foundation
+
+// MARK: - Hardware Identifier Table
+
+/// Spoofed machine identifiers answered by the hook library's sysctlbyname
+/// and IORegistryEntryCreateCFProperty replacements
+/// The values are generated once per session; the library copies them into
+/// a sorted table, so a hooked call never calls back into Swift.
+public struct HardwareIdentifierTable {
+
+    /// Environment variable carrying the table path into the target
+    public static let pathEnvironmentKey = PH_IDENTIFIERS_PATH_ENV
+
+    /// API an identifier is answered from
+    public enum Source {
+        /// `sysctlbyname()` name, such as "hw.model"
+        case sysctl
+        /// I/O Registry property key, such as "IOPlatformSerialNumber"
+        case ioRegistry
+
+        fileprivate var librarySource: PHIdentifierSource {
+            switch self {
+            case .sysctl:
+                return PH_IDENTIFIER_SYSCTL
+            case .ioRegistry:
+                return PH_IDENTIFIER_IOREGISTRY
+            }
+        }
+    }
+
+    public enum Value: Equatable {
+        /// NUL-terminated for sysctl callers, a CFString for registry callers
+        case string(String)
+        /// Raw bytes, a CFData for registry callers
+        case data([UInt8])
+
+        fileprivate var kind: PHIdentifierKind {
+            switch self {
+            case .string:
+                return PH_IDENTIFIER_STRING
+            case .data:
+                return PH_IDENTIFIER_DATA
+            }
+        }
+
+        fileprivate var bytes: [UInt8] {
+            switch self {
+            case .string(let string):
+                return Array(string.utf8)
+            case .data(let data):
+                return data
+            }
+        }
+    }
+
+    public struct Entry {
+        public let source: Source
+        public let key: String
+        public let value: Value
+
+        public init(source: Source, key: String, value: Value) {
+            self.source = source
+            self.key = key
+            self.value = value
+        }
+    }
+
+    public let entries: [Entry]
+
+    public init(entries: [Entry]) {
+        self.entries = entries
+    }
+
+    /// Number of identifiers
+    public var count: Int {
+        return entries.count
+    }
+
+    /// Spoofed value of a key, nil if the key passes through
+    public func value(for key: String, source: Source) -> Value? {
+        return entries.first { $0.source == source && $0.key == key }?.value
+    }
+
+    /// Encode the table in the layout described in privarion_hook.h
+    public func encoded() -> Data {
+        let headerSize = MemoryLayout<PHIdentifierHeader>.size
+        let recordSize = MemoryLayout<PHIdentifierRecord>.stride
+        let byteTableOffset = headerSize + entries.count * recordSize
+
+        var records: [PHIdentifierRecord] = []
+        var bytes: [UInt8] = []
+        for entry in entries {
+            let keyOffset = bytes.count
+            bytes.append(contentsOf: entry.key.utf8)
+            let valueOffset = bytes.count
+            bytes.append(contentsOf: entry.value.bytes)
+            records.append(PHIdentifierRecord(
+                source: entry.source.librarySource.rawValue,
+                kind: entry.value.kind.rawValue,
+                key_offset: UInt32(keyOffset),
+                key_length: UInt32(valueOffset - keyOffset),
+                value_offset: UInt32(valueOffset),
+                value_length: UInt32(bytes.count - valueOffset)
+            ))
+        }
+
+        var header = PHIdentifierHeader(
+            magic: UInt32(PH_IDENTIFIERS_MAGIC),
+            format_version: UInt32(PH_IDENTIFIERS_FORMAT_VERSION),
+            entry_count: UInt32(entries.count),
+            record_size: UInt32(recordSize),
+            byte_table_offset: UInt32(byteTableOffset),
+            byte_table_size: UInt32(bytes.count),
+            reserved: (0, 0)
+        )
+
+        var data = Data(capacity: byteTableOffset + bytes.count)
+        withUnsafeBytes(of: &header) { data.append(contentsOf: $0) }
+        records.withUnsafeBytes { data.append(contentsOf: $0) }
+        data.append(contentsOf: bytes)
+        return data
+    }
+
+    /// Write the table atomically, so processes mapping an older copy keep a valid file
+    public func write(to url: URL) throws {
+        try encoded().write(to: url, options: .atomic)
+    }
+
+    /// Call `body` with library specs pointing into this table's storage
+    internal func withSpecs<R>(_ body: (UnsafeBufferPointer<PHIdentifierSpec>) -> R) -> R {
+        // One buffer holds every terminated key followed by its value
+        var storage: [UInt8] = []
+        var layout: [(key: Int, value: Int, length: Int)] = []
+        for entry in entries {
+            let key = storage.count
+            storage.append(contentsOf: entry.key.utf8)
+            storage.append(0)
+            let value = entry.value.bytes
+            layout.append((key: key, value: storage.count, length: value.count))
+            storage.append(contentsOf: value)
+        }
+
+        return storage.withUnsafeBytes { buffer in
+            guard let base = buffer.baseAddress else {
+                return body(UnsafeBufferPointer(start: nil, count: 0))
+            }
+            let specs = zip(entries, layout).map { entry, offsets in
+                PHIdentifierSpec(
+                    source: entry.source.librarySource,
+                    kind: entry.value.kind,
+                    key: base.advanced(by: offsets.key).assumingMemoryBound(to: CChar.self),
+                    value: base.advanced(by: offsets.value),
+                    value_length: offsets.length
+                )
+            }
+            return specs.withUnsafeBufferPointer(body)
+        }
+    }
+}
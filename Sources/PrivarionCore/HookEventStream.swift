@@ -0,0 +1,279 @@
+import PrivarionHook
+import Foundation
+import Darwin
+
+// MARK: - Hook Event Stream
+
+/// Consumer side of the event region a hooked process publishes
+/// Records are moved straight out of the shared lanes; draining never
+/// calls into the target process. Only one stream per process may drain
+/// at a time, and a stream must not be drained from two threads at once.
+public final class HookEventStream {
+
+    public enum StreamError: Error, LocalizedError {
+        case eventsUnavailable(pid_t)
+        case mappingFailed(pid_t, String)
+        case filterRejected(pid_t, String)
+
+        public var errorDescription: String? {
+            switch self {
+            case .eventsUnavailable(let pid):
+                return "Process \(pid) does not publish hook events"
+            case .mappingFailed(let pid, let reason):
+                return "Failed to map hook events of process \(pid): \(reason)"
+            case .filterRejected(let pid, let reason):
+                return "Failed to install event filter for process \(pid): \(reason)"
+            }
+        }
+    }
+
+    /// One published call, as drained from the event region
+    public struct Event {
+        /// Monotonic timestamp in nanoseconds
+        public let timestampNanoseconds: UInt64
+        public let threadID: UInt64
+        public let returnValue: Int64
+        /// `HookHandle.id` of the hook that ran
+        public let hookID: UInt32
+        /// Path or first string argument of the call, nil if it has neither;
+        /// at most `maxArgumentLength` bytes
+        public let argument: String?
+        /// Whether `argument` is the path the native filter evaluated
+        public let argumentIsPath: Bool
+        /// Whether `argument` was cut to fit the record
+        public let argumentTruncated: Bool
+
+        internal init(_ record: PHEventRecord) {
+            self.timestampNanoseconds = record.timestamp_ns
+            self.threadID = record.thread_id
+            self.returnValue = record.return_value
+            self.hookID = record.hook_id
+            self.argumentIsPath = record.flags & UInt8(PH_EVENT_ARGUMENT_IS_PATH) != 0
+            self.argumentTruncated = record.flags & UInt8(PH_EVENT_ARGUMENT_TRUNCATED) != 0
+
+            var storage = record.argument
+            let length = min(Int(record.argument_length), Event.maxArgumentLength)
+            let argument = withUnsafeBytes(of: &storage) { bytes in
+                String(decoding: bytes.prefix(length), as: UTF8.self)
+            }
+            self.argument = argument.isEmpty && !argumentIsPath ? nil : argument
+        }
+
+        internal init(
+            timestampNanoseconds: UInt64 = 0,
+            threadID: UInt64 = 0,
+            returnValue: Int64,
+            hookID: UInt32,
+            argument: String?,
+            argumentIsPath: Bool,
+            argumentTruncated: Bool = false
+        ) {
+            self.timestampNanoseconds = timestampNanoseconds
+            self.threadID = threadID
+            self.returnValue = returnValue
+            self.hookID = hookID
+            self.argument = argument
+            self.argumentIsPath = argumentIsPath
+            self.argumentTruncated = argumentTruncated
+        }
+
+        /// Longest argument a record carries
+        public static let maxArgumentLength = Int(PH_EVENTS_ARGUMENT_SIZE) - 1
+    }
+
+    /// Environment variable that makes an injected process publish events
+    public static let environmentKey = PH_EVENTS_ENV
+
+    public let processID: pid_t
+    /// Short process name as reported by the kernel
+    public let processName: String
+    /// Real credentials of the process, read when the stream was opened
+    public let userID: UInt32
+    public let groupID: UInt32
+
+    private let view: OpaquePointer
+    private var hookNames: [UInt32: String] = [:]
+    private var buffer: [PHEventRecord]
+
+    public init(processID: pid_t, batchSize: Int = 1024) throws {
+        var view: OpaquePointer?
+        let result = ph_events_open(processID, &view)
+
+        switch result {
+        case PH_SUCCESS:
+            guard let view = view else {
+                throw StreamError.mappingFailed(processID, "No view returned")
+            }
+            self.view = view
+        case PH_ERROR_NOT_HOOKED:
+            throw StreamError.eventsUnavailable(processID)
+        default:
+            throw StreamError.mappingFailed(processID, String(cString: ph_get_error_message(result)))
+        }
+
+        var info = proc_bsdinfo()
+        let size = Int32(MemoryLayout<proc_bsdinfo>.size)
+        if proc_pidinfo(processID, PROC_PIDTBSDINFO, 0, &info, size) == size {
+            self.processName = withUnsafePointer(to: info.pbi_comm) { ptr in
+                String(cString: UnsafeRawPointer(ptr).assumingMemoryBound(to: CChar.self))
+            }
+            self.userID = info.pbi_ruid
+            self.groupID = info.pbi_rgid
+        } else {
+            self.processName = "pid \(processID)"
+            self.userID = 0
+            self.groupID = 0
+        }
+
+        self.processID = processID
+        self.buffer = [PHEventRecord](repeating: PHEventRecord(), count: max(batchSize, 1))
+    }
+
+    deinit {
+        ph_events_close(view)
+    }
+
+    /// Records the process dropped because a lane was full or none was free
+    public var droppedCount: UInt64 {
+        return ph_events_dropped_count(view)
+    }
+
+    /// Drain one batch of pending records and pass each to `handler` with
+    /// its hook's function name; returns the number of records drained
+    @discardableResult
+    public func drain(_ handler: (String, Event) -> Void) -> Int {
+        let count = buffer.withUnsafeMutableBufferPointer { pointer in
+            ph_events_drain(view, pointer.baseAddress, pointer.count)
+        }
+
+        for index in 0..<count {
+            let record = Event(buffer[index])
+            if let name = hookName(for: record.hookID) {
+                handler(name, record)
+            }
+        }
+        return count
+    }
+
+    // MARK: - Filtering
+
+    /// One rule of the filter the hooked process applies before publishing
+    public struct FilterRule {
+        public let syscalls: Set<String>
+        /// Calls carrying a path must start with one of these, if any are given
+        public let allowedPathPrefixes: [String]
+        public let blockedPathPrefixes: [String]
+
+        public init(syscalls: Set<String>, allowedPathPrefixes: [String] = [], blockedPathPrefixes: [String] = []) {
+            self.syscalls = syscalls
+            self.allowedPathPrefixes = allowedPathPrefixes
+            self.blockedPathPrefixes = blockedPathPrefixes
+        }
+    }
+
+    /// System call names the hook library can filter on
+    public static let filterableSyscalls: [String: PHSyscallId] = [
+        "getuid": PH_SYSCALL_GETUID,
+        "getgid": PH_SYSCALL_GETGID,
+        "gethostname": PH_SYSCALL_GETHOSTNAME,
+        "uname": PH_SYSCALL_UNAME,
+        "connect": PH_SYSCALL_CONNECT,
+        "bind": PH_SYSCALL_BIND,
+        "listen": PH_SYSCALL_LISTEN,
+        "open": PH_SYSCALL_OPEN,
+        "read": PH_SYSCALL_READ,
+        "write": PH_SYSCALL_WRITE,
+        "sysctlbyname": PH_SYSCALL_SYSCTLBYNAME,
+        "IORegistryEntryCreateCFProperty": PH_SYSCALL_IOREGISTRY,
+        "posix_spawn": PH_SYSCALL_POSIX_SPAWN,
+        "posix_spawnp": PH_SYSCALL_POSIX_SPAWN,
+        "execve": PH_SYSCALL_EXECVE
+    ]
+
+    /// Maximum number of rules one filter can hold
+    public static let maxFilterRules = Int(PH_EVENTS_FILTER_MAX_RULES)
+
+    /// Make the hooked process publish only calls one of the rules passes
+    /// Syscall names the library does not know are ignored. Fails if there
+    /// are more than `maxFilterRules` rules or too many path prefixes.
+    public func setFilter(_ rules: [FilterRule]) throws {
+        var cRules: [PHEventFilterRule] = []
+        var cStrings: [UnsafeMutablePointer<CChar>?] = []
+        defer { cStrings.forEach { free($0) } }
+
+        // Each rule's prefix pointers live in one shared array, sliced per rule
+        var prefixes: [UnsafePointer<CChar>?] = []
+        var ranges: [(allowed: Range<Int>, blocked: Range<Int>)] = []
+        for rule in rules {
+            let allowedStart = prefixes.count
+            for prefix in rule.allowedPathPrefixes {
+                let copy = strdup(prefix)
+                cStrings.append(copy)
+                prefixes.append(UnsafePointer(copy))
+            }
+            let blockedStart = prefixes.count
+            for prefix in rule.blockedPathPrefixes {
+                let copy = strdup(prefix)
+                cStrings.append(copy)
+                prefixes.append(UnsafePointer(copy))
+            }
+            ranges.append((allowedStart..<blockedStart, blockedStart..<prefixes.count))
+        }
+
+        let result: PHResult = prefixes.withUnsafeBufferPointer { pointers in
+            for (rule, range) in zip(rules, ranges) {
+                var mask: UInt64 = 0
+                for name in rule.syscalls {
+                    if let id = Self.filterableSyscalls[name] {
+                        mask |= 1 << UInt64(id.rawValue)
+                    }
+                }
+                cRules.append(PHEventFilterRule(
+                    syscall_mask: mask,
+                    allowed_prefixes: pointers.baseAddress.map { $0 + range.allowed.lowerBound },
+                    allowed_count: range.allowed.count,
+                    blocked_prefixes: pointers.baseAddress.map { $0 + range.blocked.lowerBound },
+                    blocked_count: range.blocked.count
+                ))
+            }
+            return cRules.withUnsafeBufferPointer { buffer in
+                ph_events_set_filter(view, buffer.baseAddress, buffer.count)
+            }
+        }
+
+        guard result == PH_SUCCESS else {
+            throw StreamError.filterRejected(processID, String(cString: ph_get_error_message(result)))
+        }
+    }
+
+    /// Make the hooked process publish every hooked call again
+    public func clearFilter() {
+        ph_events_clear_filter(view)
+    }
+
+    /// Whether the installed filter lets a call through
+    public func filterMatches(syscall: String, path: String? = nil) -> Bool {
+        guard let id = Self.filterableSyscalls[syscall] else {
+            return false
+        }
+        if let path = path {
+            return ph_events_filter_matches(view, id, path)
+        }
+        return ph_events_filter_matches(view, id, nil)
+    }
+
+    /// Hook IDs are never reused with a different name, so resolved names are cached
+    private func hookName(for hookID: UInt32) -> String? {
+        if let name = hookNames[hookID] {
+            return name
+        }
+
+        var name = [CChar](repeating: 0, count: 64)
+        guard ph_events_hook_name(view, hookID, &name, name.count) else {
+            return nil
+        }
+        let resolved = String(cString: name)
+        hookNames[hookID] = resolved
+        return resolved
+    }
+}
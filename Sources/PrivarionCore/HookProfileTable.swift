@@ -0,0 +1,98 @@
+import PrivarionHook
+import Foundation
+
+// MARK: - Hook Profile Table
+
+/// Binary per-bundle hook profiles for the injected hook library
+/// The table is resolved from a `SyscallHookConfiguration` ahead of launch;
+/// the library maps it in its constructor and installs the host bundle's
+/// hooks without parsing any configuration format.
+public struct HookProfileTable {
+
+    /// Environment variable carrying the table path into the target
+    public static let pathEnvironmentKey = PH_PROFILE_PATH_ENV
+
+    /// Environment variable carrying the host bundle identifier into the target
+    public static let bundleEnvironmentKey = PH_PROFILE_BUNDLE_ENV
+
+    private struct Profile {
+        let bundleId: [UInt8]
+        let hookMask: UInt32
+    }
+
+    private let profiles: [Profile]
+    private let configData: PHookConfigData
+
+    /// Resolve the default profile and one profile per application rule set
+    public init(configuration: SyscallHookConfiguration) {
+        var profiles = [Profile(bundleId: [], hookMask: Self.hookMask(for: configuration.hooks))]
+        for bundleId in configuration.hooks.applicationRules.keys {
+            profiles.append(Profile(
+                bundleId: Array(bundleId.utf8),
+                hookMask: Self.hookMask(for: configuration.effectiveRules(for: bundleId))
+            ))
+        }
+
+        // The library binary-searches identifiers in byte order
+        self.profiles = profiles.sorted { $0.bundleId.lexicographicallyPrecedes($1.bundleId) }
+        self.configData = configuration.fakeData.hookConfigData
+    }
+
+    /// Number of profiles, including the default one
+    public var count: Int {
+        return profiles.count
+    }
+
+    /// Encode the table in the layout described in privarion_hook.h
+    public func encoded() -> Data {
+        let headerSize = MemoryLayout<PHProfileHeader>.size
+        let recordSize = MemoryLayout<PHProfileRecord>.stride
+        let stringTableOffset = headerSize + profiles.count * recordSize
+
+        var records: [PHProfileRecord] = []
+        var strings: [UInt8] = []
+        for profile in profiles {
+            records.append(PHProfileRecord(
+                bundle_id_offset: UInt32(strings.count),
+                bundle_id_length: UInt32(profile.bundleId.count),
+                hook_mask: profile.hookMask,
+                reserved: 0,
+                config: configData
+            ))
+            strings.append(contentsOf: profile.bundleId)
+        }
+
+        var header = PHProfileHeader(
+            magic: UInt32(PH_PROFILE_MAGIC),
+            format_version: UInt32(PH_PROFILE_FORMAT_VERSION),
+            profile_count: UInt32(profiles.count),
+            record_size: UInt32(recordSize),
+            string_table_offset: UInt32(stringTableOffset),
+            string_table_size: UInt32(strings.count),
+            reserved: (0, 0)
+        )
+
+        var data = Data(capacity: stringTableOffset + strings.count)
+        withUnsafeBytes(of: &header) { data.append(contentsOf: $0) }
+        records.withUnsafeBytes { data.append(contentsOf: $0) }
+        data.append(contentsOf: strings)
+        return data
+    }
+
+    /// Write the table atomically, so processes mapping an older copy keep a valid file
+    public func write(to url: URL) throws {
+        try encoded().write(to: url, options: .atomic)
+    }
+
+    private static func hookMask(for rules: HookRules) -> UInt32 {
+        var mask: UInt32 = 0
+        if rules.getuid { mask |= UInt32(PH_PROFILE_HOOK_GETUID) }
+        if rules.getgid { mask |= UInt32(PH_PROFILE_HOOK_GETGID) }
+        if rules.gethostname { mask |= UInt32(PH_PROFILE_HOOK_GETHOSTNAME) }
+        if rules.uname { mask |= UInt32(PH_PROFILE_HOOK_UNAME) }
+        if rules.hardwareIdentifiers {
+            mask |= UInt32(PH_PROFILE_HOOK_SYSCTLBYNAME) | UInt32(PH_PROFILE_HOOK_IOREGISTRY)
+        }
+        return mask
+    }
+}
@@ -0,0 +1,125 @@
+import PrivarionHook
+import Foundation
+
+// MARK: - Hook Statistics
+
+/// Counters of one installed hook, as exported by a hooked process
+public struct HookStatistics: Codable {
+
+    /// Calls whose latency fell into one histogram bucket
+    public struct LatencyBucket: Codable {
+        public let lowerBoundNanoseconds: UInt64
+        public let count: UInt64
+    }
+
+    public let hookID: UInt32
+    public let functionName: String
+    public let calls: UInt64
+    public let spoofedCalls: UInt64
+    public let passthroughCalls: UInt64
+    public let totalNanoseconds: UInt64
+    /// Non-empty histogram buckets in ascending latency order
+    public let latencyHistogram: [LatencyBucket]
+
+    internal init(_ stats: PHHookStats) {
+        self.hookID = stats.hook_id
+        self.functionName = withUnsafePointer(to: stats.function_name) { ptr in
+            String(cString: UnsafeRawPointer(ptr).assumingMemoryBound(to: CChar.self))
+        }
+        self.calls = stats.calls
+        self.spoofedCalls = stats.spoofed
+        self.passthroughCalls = stats.passthrough
+        self.totalNanoseconds = stats.total_ns
+
+        var buckets: [LatencyBucket] = []
+        withUnsafeBytes(of: stats.histogram) { raw in
+            for (index, count) in raw.bindMemory(to: UInt64.self).enumerated() where count > 0 {
+                buckets.append(LatencyBucket(
+                    lowerBoundNanoseconds: ph_stats_bucket_lower_bound(UInt32(index)),
+                    count: count
+                ))
+            }
+        }
+        self.latencyHistogram = buckets
+    }
+
+    /// Mean time spent inside the replacement function
+    public var averageLatencyNanoseconds: Double {
+        return calls > 0 ? Double(totalNanoseconds) / Double(calls) : 0
+    }
+
+    /// Lower bound of the histogram bucket holding the given percentile (0...100)
+    public func latencyPercentile(_ percentile: Double) -> UInt64 {
+        let total = latencyHistogram.reduce(UInt64(0)) { $0 + $1.count }
+        guard total > 0 else {
+            return 0
+        }
+
+        let rank = UInt64((min(max(percentile, 0), 100) / 100 * Double(total)).rounded(.up))
+        var seen: UInt64 = 0
+        for bucket in latencyHistogram {
+            seen += bucket.count
+            if seen >= rank {
+                return bucket.lowerBoundNanoseconds
+            }
+        }
+        return latencyHistogram.last?.lowerBoundNanoseconds ?? 0
+    }
+}
+
+// MARK: - Hook Statistics Reader
+
+/// Read-only view of the statistics region a hooked process exports
+/// Reading never calls into the target process; counters are aggregated
+/// straight from the shared mapping.
+public final class HookStatisticsReader {
+
+    public enum ReaderError: Error, LocalizedError {
+        case statisticsUnavailable(pid_t)
+        case mappingFailed(pid_t, String)
+
+        public var errorDescription: String? {
+            switch self {
+            case .statisticsUnavailable(let pid):
+                return "Process \(pid) does not export hook statistics"
+            case .mappingFailed(let pid, let reason):
+                return "Failed to map hook statistics of process \(pid): \(reason)"
+            }
+        }
+    }
+
+    public let processID: pid_t
+    private let view: OpaquePointer
+
+    public init(processID: pid_t) throws {
+        var view: OpaquePointer?
+        let result = ph_stats_open(processID, &view)
+
+        switch result {
+        case PH_SUCCESS:
+            guard let view = view else {
+                throw ReaderError.mappingFailed(processID, "No view returned")
+            }
+            self.processID = processID
+            self.view = view
+        case PH_ERROR_NOT_HOOKED:
+            throw ReaderError.statisticsUnavailable(processID)
+        default:
+            throw ReaderError.mappingFailed(processID, String(cString: ph_get_error_message(result)))
+        }
+    }
+
+    deinit {
+        ph_stats_close(view)
+    }
+
+    /// Current counters of every hook installed in the process
+    public func readAll() -> [HookStatistics] {
+        var statistics: [HookStatistics] = []
+        var raw = PHHookStats()
+        for slot in 0..<UInt32(PH_STATS_MAX_HOOKS) where ph_stats_read(view, slot, &raw) {
+            statistics.append(HookStatistics(raw))
+        }
+        return statistics
+    }
+}
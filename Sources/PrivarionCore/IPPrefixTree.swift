@@ -0,0 +1,342 @@
+import Foundation
+
+/// Immutable, path-compressed binary radix (Patricia) tree over IP prefixes
+/// IPv4 and IPv6 share one 128-bit key space: IPv4 prefixes are stored as
+/// IPv4-mapped IPv6 (`::ffff:a.b.c.d`), so `1.2.3.0/24` is `::ffff:1.2.3.0/120`.
+/// A lookup walks at most one node per distinct prefix length on the
+/// address's path and returns the tag of the longest matching prefix.
+/// Addresses are matched in binary form, so packet paths never format strings.
+public final class IPPrefixTree: @unchecked Sendable {
+
+    /// Reported by `match` when no prefix covers the address
+    public static let noMatch: UInt8 = .max
+
+    /// 128-bit address, most significant bits first
+    public struct Address: Hashable, Sendable {
+        public let high: UInt64
+        public let low: UInt64
+
+        public init(high: UInt64, low: UInt64) {
+            self.high = high
+            self.low = low
+        }
+
+        /// IPv4 address in host byte order, mapped into IPv6
+        public init(ipv4: UInt32) {
+            self.init(high: 0, low: 0xFFFF_0000_0000 | UInt64(ipv4))
+        }
+
+        /// Address from 4 (IPv4) or 16 (IPv6) network-order bytes
+        public init?<C: Collection>(bytes: C) where C.Element == UInt8 {
+            var high: UInt64 = 0
+            var low: UInt64 = 0
+            switch bytes.count {
+            case 4:
+                let ipv4 = bytes.reduce(UInt32(0)) { $0 << 8 | UInt32($1) }
+                self.init(ipv4: ipv4)
+                return
+            case 16:
+                for (index, byte) in bytes.enumerated() {
+                    if index < 8 {
+                        high = high << 8 | UInt64(byte)
+                    } else {
+                        low = low << 8 | UInt64(byte)
+                    }
+                }
+                self.init(high: high, low: low)
+            default:
+                return nil
+            }
+        }
+
+        /// Parse a textual IPv4 or IPv6 address
+        public init?(_ string: String) {
+            let trimmed = string.trimmingCharacters(in: .whitespaces)
+            var ipv4 = in_addr()
+            if inet_pton(AF_INET, trimmed, &ipv4) == 1 {
+                self.init(ipv4: UInt32(bigEndian: ipv4.s_addr))
+                return
+            }
+            var ipv6 = in6_addr()
+            guard inet_pton(AF_INET6, trimmed, &ipv6) == 1 else {
+                return nil
+            }
+            self.init(bytes: withUnsafeBytes(of: ipv6) { Array($0) })
+        }
+
+        /// Whether this is an IPv4-mapped address
+        public var isIPv4: Bool {
+            return high == 0 && low >> 32 == 0xFFFF
+        }
+
+        /// Bit at `index`, counting from the most significant
+        @inline(__always)
+        func bit(_ index: Int) -> Int {
+            return index < 64 ? Int(high >> (63 - index) & 1) : Int(low >> (127 - index) & 1)
+        }
+
+        /// Address with every bit from `length` on cleared
+        @inline(__always)
+        func masked(to length: Int) -> Address {
+            return Address(high: high & Self.mask(length), low: low & Self.mask(length - 64))
+        }
+
+        /// Whether the first `length` bits equal those of `other`
+        @inline(__always)
+        func sharesPrefix(with other: Address, length: Int) -> Bool {
+            return (high ^ other.high) & Self.mask(length) == 0 && (low ^ other.low) & Self.mask(length - 64) == 0
+        }
+
+        /// Number of leading bits shared with `other`
+        func commonPrefixLength(with other: Address) -> Int {
+            let high = self.high ^ other.high
+            if high != 0 {
+                return high.leadingZeroBitCount
+            }
+            return 64 + (self.low ^ other.low).leadingZeroBitCount
+        }
+
+        /// Mask of the top `bits` bits of one 64-bit half
+        @inline(__always)
+        private static func mask(_ bits: Int) -> UInt64 {
+            if bits <= 0 { return 0 }
+            if bits >= 64 { return .max }
+            return ~(UInt64.max >> bits)
+        }
+    }
+
+    /// Prefix rule: an address and the number of leading bits that count
+    public struct Prefix: Hashable, Sendable {
+        public let address: Address
+        /// Prefix length in the 128-bit key space
+        public let length: Int
+
+        public init(address: Address, length: Int) {
+            self.length = min(max(length, 0), 128)
+            self.address = address.masked(to: self.length)
+        }
+
+        /// Parse `a.b.c.d`, `a.b.c.d/len`, IPv6 with optional `/len`, or a
+        /// range `first-last`; a range becomes the fewest covering prefixes
+        /// - Returns: nil if the rule is not a valid address, CIDR or range
+        public static func parse(_ rule: String) -> [Prefix]? {
+            let trimmed = rule.trimmingCharacters(in: .whitespaces)
+
+            if let dash = trimmed.firstIndex(of: "-") {
+                guard let first = Address(String(trimmed[..<dash])),
+                      let last = Address(String(trimmed[trimmed.index(after: dash)...])),
+                      first.isIPv4 == last.isIPv4,
+                      (first.high, first.low) <= (last.high, last.low) else {
+                    return nil
+                }
+                return covering(from: first, through: last)
+            }
+
+            let parts = trimmed.split(separator: "/", omittingEmptySubsequences: false)
+            guard parts.count <= 2, let address = Address(String(parts[0])) else {
+                return nil
+            }
+            let width = address.isIPv4 && !parts[0].contains(":") ? 32 : 128
+            var length = width
+            if parts.count == 2 {
+                guard let parsed = Int(parts[1]), parsed >= 0, parsed <= width else {
+                    return nil
+                }
+                length = parsed
+            }
+            return [Prefix(address: address, length: length + (128 - width))]
+        }
+
+        /// Fewest prefixes exactly covering `first...last`
+        private static func covering(from first: Address, through last: Address) -> [Prefix] {
+            var prefixes: [Prefix] = []
+            var start = first
+            while true {
+                // Largest aligned block starting here that does not pass `last`
+                var size = start.low == 0 ? 64 + (start.high == 0 ? 64 : start.high.trailingZeroBitCount) : start.low.trailingZeroBitCount
+                while size > 0 && !fits(start, size, last) {
+                    size -= 1
+                }
+                prefixes.append(Prefix(address: start, length: 128 - size))
+
+                // Advance past the block, stopping at the end of the space
+                guard let next = advance(start, by: size), (next.high, next.low) <= (last.high, last.low) else {
+                    return prefixes
+                }
+                start = next
+            }
+        }
+
+        /// Whether the block of 2^size addresses at `start` ends at or before `last`
+        private static func fits(_ start: Address, _ size: Int, _ last: Address) -> Bool {
+            guard size < 128 else {
+                return last.high == .max && last.low == .max
+            }
+            let end = blockEnd(start, size)
+            return (end.high, end.low) <= (last.high, last.low)
+        }
+
+        private static func blockEnd(_ start: Address, _ size: Int) -> Address {
+            if size >= 64 {
+                let span: UInt64 = size == 64 ? 0 : (UInt64.max >> (128 - size))
+                return Address(high: start.high | span, low: .max)
+            }
+            return Address(high: start.high, low: start.low | (size == 0 ? 0 : UInt64.max >> (64 - size)))
+        }
+
+        private static func advance(_ start: Address, by size: Int) -> Address? {
+            guard size < 128 else { return nil }
+            let end = blockEnd(start, size)
+            if end.low == .max {
+                guard end.high != .max else { return nil }
+                return Address(high: end.high + 1, low: 0)
+            }
+            return Address(high: end.high, low: end.low + 1)
+        }
+    }
+
+    /// Flattened node; children index `nodes`, -1 for none
+    private struct Node {
+        var prefix: Address
+        var length: UInt8
+        var tag: UInt8
+        var left: Int32
+        var right: Int32
+    }
+
+    private let nodes: ContiguousArray<Node>
+
+    /// Number of distinct prefixes stored
+    public let prefixCount: Int
+
+    /// Build a tree; a prefix listed twice keeps its lowest tag
+    public init<S: Sequence>(prefixes: S) where S.Element == (prefix: Prefix, tag: UInt8) {
+        var nodes = ContiguousArray<Node>()
+        nodes.append(Node(prefix: Address(high: 0, low: 0), length: 0, tag: Self.noMatch, left: -1, right: -1))
+        var count = 0
+
+        for (prefix, tag) in prefixes where tag != Self.noMatch {
+            if Self.insert(prefix, tag: tag, into: &nodes) {
+                count += 1
+            }
+        }
+
+        self.nodes = nodes
+        self.prefixCount = count
+    }
+
+    /// An empty tree
+    public convenience init() {
+        self.init(prefixes: [])
+    }
+
+    /// Build a tree from textual rules; unparseable rules are skipped
+    public convenience init<S: Sequence>(rules: S, tag: UInt8 = 0) where S.Element == String {
+        self.init(prefixes: rules.lazy
+            .compactMap { Prefix.parse($0) }
+            .joined()
+            .map { (prefix: $0, tag: tag) })
+    }
+
+    // MARK: - Lookup
+
+    /// Tag of the longest prefix covering the address, `noMatch` if none
+    public func match(_ address: Address) -> UInt8 {
+        return nodes.withUnsafeBufferPointer { nodes -> UInt8 in
+            var best = Self.noMatch
+            var index = 0
+            while true {
+                let node = nodes[index]
+                guard address.sharesPrefix(with: node.prefix, length: Int(node.length)) else {
+                    return best
+                }
+                if node.tag != Self.noMatch {
+                    best = node.tag
+                }
+                guard node.length < 128 else {
+                    return best
+                }
+                let next = address.bit(Int(node.length)) == 0 ? node.left : node.right
+                guard next >= 0 else {
+                    return best
+                }
+                index = Int(next)
+            }
+        }
+    }
+
+    /// Match an IPv4 address in host byte order
+    public func match(ipv4: UInt32) -> UInt8 {
+        return match(Address(ipv4: ipv4))
+    }
+
+    /// Match a textual address; unparseable addresses never match
+    public func match(_ address: String) -> UInt8 {
+        guard let parsed = Address(address) else {
+            return Self.noMatch
+        }
+        return match(parsed)
+    }
+
+    /// Whether any prefix covers the address
+    public func contains(_ address: Address) -> Bool {
+        return match(address) != Self.noMatch
+    }
+
+    // MARK: - Construction
+
+    /// Insert a prefix; returns false if it was already present
+    private static func insert(_ prefix: Prefix, tag: UInt8, into nodes: inout ContiguousArray<Node>) -> Bool {
+        let key = prefix.address
+        let length = prefix.length
+        var index = 0
+
+        while true {
+            let node = nodes[index]
+            let nodeLength = Int(node.length)
+            if nodeLength == length {
+                let isNew = node.tag == noMatch
+                nodes[index].tag = min(node.tag, tag)
+                return isNew
+            }
+
+            let goesRight = key.bit(nodeLength) == 1
+            let childIndex = goesRight ? node.right : node.left
+            guard childIndex >= 0 else {
+                setChild(of: index, right: goesRight, to: append(key, length, tag, into: &nodes), in: &nodes)
+                return true
+            }
+
+            let child = nodes[Int(childIndex)]
+            let common = min(key.commonPrefixLength(with: child.prefix), length, Int(child.length))
+            if common == Int(child.length) {
+                index = Int(childIndex)
+                continue
+            }
+
+            // Split the edge at the first differing bit
+            let split = append(key.masked(to: common), common, noMatch, into: &nodes)
+            setChild(of: index, right: goesRight, to: split, in: &nodes)
+            setChild(of: Int(split), right: child.prefix.bit(common) == 1, to: childIndex, in: &nodes)
+            if common == length {
+                nodes[Int(split)].tag = tag
+            } else {
+                setChild(of: Int(split), right: key.bit(common) == 1, to: append(key, length, tag, into: &nodes), in: &nodes)
+            }
+            return true
+        }
+    }
+
+    private static func append(_ prefix: Address, _ length: Int, _ tag: UInt8, into nodes: inout ContiguousArray<Node>) -> Int32 {
+        nodes.append(Node(prefix: prefix, length: UInt8(length), tag: tag, left: -1, right: -1))
+        return Int32(nodes.count - 1)
+    }
+
+    private static func setChild(of parent: Int, right: Bool, to child: Int32, in nodes: inout ContiguousArray<Node>) {
+        if right {
+            nodes[parent].right = child
+        } else {
+            nodes[parent].left = child
+        }
+    }
+}
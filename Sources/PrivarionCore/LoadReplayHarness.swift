@@ -0,0 +1,396 @@
+// MARK: - Load Replay Harness
+// Open-loop replay of recorded traffic through the production decision paths
+
+import Foundation
+import NIOCore
+import os.log
+
+// MARK: - Workloads
+
+/// Recorded operations the harness can replay
+/// `perform` runs operation `index` of the trace; the harness wraps around
+/// when a run has more operations than the trace.
+public protocol LoadWorkload: Sendable {
+    /// Name the results are recorded under, e.g. `dns_proxy`
+    var name: String { get }
+    /// Operations in the trace
+    var operationCount: Int { get }
+    func perform(_ index: Int) async
+}
+
+/// Open-loop load profile
+/// Arrivals follow a fixed schedule whether or not earlier operations have
+/// finished, and latency is measured from the scheduled arrival. A stalled
+/// path therefore shows up as queueing in the tail instead of quietly
+/// lowering the offered rate.
+public struct LoadProfile: Sendable {
+    public let requestsPerSecond: Double
+    public let operations: Int
+    /// Operations run one at a time before measuring, to warm caches
+    public let warmupOperations: Int
+    /// Operations in flight before new arrivals are shed
+    public let maxInFlight: Int
+
+    public init(requestsPerSecond: Double, operations: Int, warmupOperations: Int = 100, maxInFlight: Int = 10_000) {
+        self.requestsPerSecond = max(requestsPerSecond, 1)
+        self.operations = max(operations, 1)
+        self.warmupOperations = max(warmupOperations, 0)
+        self.maxInFlight = max(maxInFlight, 1)
+    }
+}
+
+/// Latency and heap figures of one replay run
+public struct LoadReport: Sendable {
+    public let workload: String
+    public let profile: LoadProfile
+    public let completedOperations: Int
+    /// Arrivals dropped because `maxInFlight` operations were outstanding
+    public let shedOperations: Int
+    public let wallTime: TimeInterval
+    public let meanLatencyMs: Double
+    public let p50LatencyMs: Double
+    public let p99LatencyMs: Double
+    public let p999LatencyMs: Double
+    public let maxLatencyMs: Double
+    /// Heap blocks still allocated after the run, per operation
+    public let retainedBlocksPerOperation: Double
+    /// Heap bytes still allocated after the run, per operation
+    public let retainedBytesPerOperation: Double
+    public let allocations: AllocationMetrics
+
+    public var achievedRate: Double {
+        return wallTime > 0 ? Double(completedOperations) / wallTime : 0
+    }
+
+    /// Result for `BenchmarkBaselineManager`
+    /// `duration` is the 99th percentile and `metrics.tailLatencyMs` the
+    /// 99.9th, both in milliseconds, so duration and tail thresholds both
+    /// gate on tail latency.
+    public var benchmarkResult: BenchmarkResult {
+        return BenchmarkResult(
+            testName: "load_\(workload)",
+            duration: p99LatencyMs,
+            metrics: PerformanceMetrics(
+                cpuUsage: 0,
+                memoryUsageMB: 0,
+                operationName: workload,
+                interactive: false,
+                tailLatencyMs: p999LatencyMs
+            ),
+            status: shedOperations > 0 ? .failed : .passed,
+            iterations: completedOperations
+        )
+    }
+}
+
+// MARK: - Harness
+
+/// Replays workloads at a fixed arrival rate and records tail latency
+public final class LoadReplayHarness {
+    private let logger = os.Logger(subsystem: "com.privarion.core", category: "load")
+    private let allocationTracker: AllocationTracker
+    private let baselineManager: BenchmarkBaselineManager
+
+    public init(
+        allocationTracker: AllocationTracker = AllocationTracker(),
+        baselineManager: BenchmarkBaselineManager = .shared
+    ) {
+        self.allocationTracker = allocationTracker
+        self.baselineManager = baselineManager
+    }
+
+    /// Replay `workload` under `profile`
+    public func run(_ workload: LoadWorkload, profile: LoadProfile) async -> LoadReport {
+        let traceLength = max(workload.operationCount, 1)
+        logger.info("Starting load run \(workload.name): \(profile.operations) operations at \(profile.requestsPerSecond)/s")
+
+        for index in 0..<profile.warmupOperations {
+            await workload.perform(index % traceLength)
+        }
+
+        allocationTracker.reset()
+        let heapBefore = HeapSnapshot.current()
+        let state = LoadRunState(maxInFlight: profile.maxInFlight)
+        let start = DispatchTime.now().uptimeNanoseconds
+        let interval = 1_000_000_000 / profile.requestsPerSecond
+
+        for index in 0..<profile.operations {
+            let scheduled = start + UInt64(Double(index) * interval)
+            await sleep(until: scheduled)
+            guard state.begin() else { continue }
+
+            let operation = (profile.warmupOperations + index) % traceLength
+            Task {
+                await workload.perform(operation)
+                let finished = DispatchTime.now().uptimeNanoseconds
+                state.finish(latencyNanoseconds: finished > scheduled ? finished - scheduled : 0)
+            }
+        }
+        await state.drain()
+
+        let wallTime = Double(DispatchTime.now().uptimeNanoseconds - start) / 1_000_000_000
+        let report = makeReport(workload: workload.name, profile: profile, state: state,
+                                wallTime: wallTime, heapBefore: heapBefore)
+        logger.info("Load run \(workload.name): p50 \(report.p50LatencyMs)ms, p99 \(report.p99LatencyMs)ms, p99.9 \(report.p999LatencyMs)ms, shed \(report.shedOperations)")
+        return report
+    }
+
+    /// Compare a run with its stored baseline
+    /// - Returns: Whether tail latency regressed beyond the thresholds
+    public func checkRegression(
+        _ report: LoadReport,
+        maxTailLatencyIncreasePercent: Double = 20.0
+    ) -> (hasRegression: Bool, baseline: BenchmarkResult?) {
+        let thresholds = RegressionDetector.RegressionThresholds(
+            maxDurationIncreasePercent: maxTailLatencyIncreasePercent,
+            maxTailLatencyIncreasePercent: maxTailLatencyIncreasePercent
+        )
+        let result = report.benchmarkResult
+        BenchmarkFramework.shared.recordResult(result)
+        return baselineManager.detectRegression(for: result, thresholds: thresholds)
+    }
+
+    /// Store a run as the baseline later runs are gated against
+    public func saveBaseline(_ report: LoadReport) {
+        baselineManager.saveBaseline(report.benchmarkResult)
+    }
+
+    private func sleep(until deadline: UInt64) async {
+        let now = DispatchTime.now().uptimeNanoseconds
+        guard deadline > now else { return }
+        do {
+            try await Task.sleep(nanoseconds: deadline - now)
+        } catch {
+            // Cancelled; carry on with the schedule
+        }
+    }
+
+    private func makeReport(
+        workload: String,
+        profile: LoadProfile,
+        state: LoadRunState,
+        wallTime: TimeInterval,
+        heapBefore: HeapSnapshot
+    ) -> LoadReport {
+        let summary = state.summary()
+        let heapAfter = HeapSnapshot.current()
+        let retainedBlocks = heapAfter.blocks - heapBefore.blocks
+        let retainedBytes = heapAfter.bytes - heapBefore.bytes
+        allocationTracker.recordAllocations(count: retainedBlocks, bytes: retainedBytes)
+
+        let operations = Double(max(summary.completed, 1))
+        return LoadReport(
+            workload: workload,
+            profile: profile,
+            completedOperations: summary.completed,
+            shedOperations: summary.shed,
+            wallTime: wallTime,
+            meanLatencyMs: summary.meanNanoseconds / 1_000_000,
+            p50LatencyMs: summary.p50Nanoseconds / 1_000_000,
+            p99LatencyMs: summary.p99Nanoseconds / 1_000_000,
+            p999LatencyMs: summary.p999Nanoseconds / 1_000_000,
+            maxLatencyMs: summary.maxNanoseconds / 1_000_000,
+            retainedBlocksPerOperation: Double(retainedBlocks) / operations,
+            retainedBytesPerOperation: Double(retainedBytes) / operations,
+            allocations: allocationTracker.getCurrentMetrics()
+        )
+    }
+}
+
+// MARK: - Run State
+
+/// Latencies and in-flight count shared by a run's operations
+private final class LoadRunState: @unchecked Sendable {
+
+    struct Summary {
+        let completed: Int
+        let shed: Int
+        let meanNanoseconds: Double
+        let p50Nanoseconds: Double
+        let p99Nanoseconds: Double
+        let p999Nanoseconds: Double
+        let maxNanoseconds: Double
+    }
+
+    private let lock = NSLock()
+    private let maxInFlight: Int
+    private var sketch = QuantileSketch(relativeAccuracy: 0.005, maxBuckets: 4096)
+    private var inFlight = 0
+    private var completed = 0
+    private var shed = 0
+    private var totalNanoseconds = 0.0
+    private var maxNanoseconds: UInt64 = 0
+    private var drained: CheckedContinuation<Void, Never>?
+
+    init(maxInFlight: Int) {
+        self.maxInFlight = maxInFlight
+    }
+
+    /// Admit an arrival, or count it as shed
+    func begin() -> Bool {
+        lock.lock()
+        defer { lock.unlock() }
+        guard inFlight < maxInFlight else {
+            shed += 1
+            return false
+        }
+        inFlight += 1
+        return true
+    }
+
+    func finish(latencyNanoseconds: UInt64) {
+        lock.lock()
+        sketch.add(Double(latencyNanoseconds))
+        completed += 1
+        totalNanoseconds += Double(latencyNanoseconds)
+        maxNanoseconds = max(maxNanoseconds, latencyNanoseconds)
+        inFlight -= 1
+        let waiter = inFlight == 0 ? drained : nil
+        if waiter != nil {
+            drained = nil
+        }
+        lock.unlock()
+        waiter?.resume()
+    }
+
+    /// Wait until every admitted operation has finished
+    func drain() async {
+        await withCheckedContinuation { (continuation: CheckedContinuation<Void, Never>) in
+            lock.lock()
+            guard inFlight > 0 else {
+                lock.unlock()
+                continuation.resume()
+                return
+            }
+            drained = continuation
+            lock.unlock()
+        }
+    }
+
+    func summary() -> Summary {
+        lock.lock()
+        defer { lock.unlock() }
+        return Summary(
+            completed: completed,
+            shed: shed,
+            meanNanoseconds: completed > 0 ? totalNanoseconds / Double(completed) : 0,
+            p50Nanoseconds: sketch.quantile(0.5) ?? 0,
+            p99Nanoseconds: sketch.quantile(0.99) ?? 0,
+            p999Nanoseconds: sketch.quantile(0.999) ?? 0,
+            maxNanoseconds: Double(maxNanoseconds)
+        )
+    }
+}
+
+/// Blocks and bytes in use across all malloc zones
+/// Darwin only exposes what is allocated at a point in time, so the
+/// harness reports what a run leaves behind rather than every allocation.
+private struct HeapSnapshot {
+    let blocks: Int
+    let bytes: Int
+
+    static func current() -> HeapSnapshot {
+        var statistics = malloc_statistics_t()
+        malloc_zone_statistics(nil, &statistics)
+        return HeapSnapshot(blocks: Int(statistics.blocks_in_use), bytes: Int(statistics.size_in_use))
+    }
+}
+
+// MARK: - DNS Replay
+
+/// Captured DNS queries, in DNS-over-TCP framing
+/// A capture is a sequence of messages, each preceded by its length as a
+/// big-endian UInt16, as written by `tcpdump`-to-stream tools and TCP DNS.
+internal enum DNSQueryCapture {
+
+    static func load(from url: URL) throws -> [Data] {
+        return try parse(Data(contentsOf: url))
+    }
+
+    static func parse(_ capture: Data) throws -> [Data] {
+        var queries: [Data] = []
+        var offset = capture.startIndex
+        while offset < capture.endIndex {
+            guard capture.endIndex - offset >= 2 else {
+                throw DNSProxyError.invalidQuery
+            }
+            let length = Int(capture[offset]) << 8 | Int(capture[offset + 1])
+            let start = offset + 2
+            guard capture.endIndex - start >= length else {
+                throw DNSProxyError.invalidQuery
+            }
+            queries.append(capture.subdata(in: start..<start + length))
+            offset = start + length
+        }
+        return queries
+    }
+
+    static func serialize(_ queries: [Data]) -> Data {
+        var capture = Data()
+        for query in queries where query.count <= Int(UInt16.max) {
+            capture.append(UInt8(query.count >> 8))
+            capture.append(UInt8(query.count & 0xFF))
+            capture.append(query)
+        }
+        return capture
+    }
+
+    /// A recursive A query for `domain`, for synthesizing captures
+    static func query(for domain: String, id: UInt16) -> Data {
+        var message = Data([UInt8(id >> 8), UInt8(id & 0xFF), 0x01, 0x00, 0x00, 0x01, 0, 0, 0, 0, 0, 0])
+        for label in domain.split(separator: ".") {
+            let bytes = Array(label.utf8.prefix(63))
+            message.append(UInt8(bytes.count))
+            message.append(contentsOf: bytes)
+        }
+        message.append(contentsOf: [0x00, 0x00, 0x01, 0x00, 0x01])
+        return message
+    }
+}
+
+/// Replays captured queries through the proxy's local decision path
+/// Parsing, blocklist matching and the answer cache run as in production;
+/// queries that would be forwarded stop there, so no upstream is needed.
+@available(macOS 10.15, *)
+internal struct DNSQueryReplayWorkload: LoadWorkload, @unchecked Sendable {
+    let name: String
+    private let queries: [ByteBuffer]
+    private let server: SwiftNIODNSProxyServer
+
+    init(name: String = "dns_proxy", queries: [Data], server: SwiftNIODNSProxyServer) {
+        self.name = name
+        self.queries = queries.map { ByteBuffer(bytes: $0) }
+        self.server = server
+    }
+
+    var operationCount: Int {
+        return queries.count
+    }
+
+    func perform(_ index: Int) async {
+        _ = server.resolveLocally(queries[index], applicationId: nil)
+    }
+}
+
+// MARK: - Blocklist Replay
+
+/// Replays a domain set through `BlocklistManager.shouldBlockDomain`
+internal struct DomainSetReplayWorkload: LoadWorkload, @unchecked Sendable {
+    let name: String
+    private let domains: [String]
+    private let blocklistManager: BlocklistManager
+
+    init(name: String = "blocklist", domains: [String], blocklistManager: BlocklistManager) {
+        self.name = name
+        self.domains = domains
+        self.blocklistManager = blocklistManager
+    }
+
+    var operationCount: Int {
+        return domains.count
+    }
+
+    func perform(_ index: Int) async {
+        _ = blocklistManager.shouldBlockDomain(domains[index])
+    }
+}
@@ -98,6 +98,13 @@ public class MetricsCollector {
         }
     }
     
+    /// Get per-hook call counters and latency of a hooked process
+    /// Reads the statistics region the process exports; never calls into it
+    public func getHookMetrics(for processID: pid_t) throws -> HookMetrics {
+        let reader = try HookStatisticsReader(processID: processID)
+        return HookMetrics(processID: processID, hooks: reader.readAll(), collectedAt: Date())
+    }
+    
     /// Aggregate all current metrics
     public func aggregateMetrics() throws -> AggregatedMetrics {
         return metricsQueue.sync {
@@ -282,6 +289,18 @@ public struct ApplicationMetrics: Codable {
     public var lastUpdated: Date = Date()
 }
 
+/// Hook statistics of one hooked process
+public struct HookMetrics: Codable {
+    public let processID: Int32
+    public let hooks: [HookStatistics]
+    public let collectedAt: Date
+    
+    /// Total hooked calls across all hooks
+    public var totalCalls: UInt64 {
+        return hooks.reduce(0) { $0 + $1.calls }
+    }
+}
+
 /// Individual application metric
 public struct ApplicationMetric: Codable {
     public let name: String
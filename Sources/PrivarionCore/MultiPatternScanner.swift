@@ -0,0 +1,205 @@
+import Foundation
+
+/// Aho-Corasick automaton over a set of byte literals, ASCII case-insensitive
+/// The goto and failure links are flattened into a dense DFA over byte
+/// classes, so a scan costs one table load per input byte and reports every
+/// occurrence of every literal in a single pass. While the automaton sits in
+/// its root state a 16-byte SIMD prefilter skips input that cannot start any
+/// literal, which is most of a typical upload body.
+internal final class MultiPatternScanner {
+
+    /// Number of literals, including empty ones that never match
+    let patternCount: Int
+
+    /// Byte to alphabet class; class 0 is every byte no literal contains
+    private let classes: [UInt8]
+    private let classCount: Int
+    /// `state * classCount + class` to next state
+    private let transitions: [Int32]
+    /// Literals ending in each state, failure chain included
+    private let outputStarts: [Int32]
+    private let outputs: [Int32]
+    private let lengths: [Int]
+    /// Folded first bytes of all literals, splatted; empty when too many to test
+    private let startBytes: [SIMD16<UInt8>]
+
+    /// Largest first-byte set the prefilter tests lane-parallel
+    private static let maxPrefilterBytes = 16
+
+    /// - Parameter patterns: Literals to find; letters match either case
+    init(patterns: [[UInt8]]) {
+        var classes = [UInt8](repeating: 0, count: 256)
+        var classCount = 1
+        for pattern in patterns {
+            for byte in pattern where classes[Int(Self.fold(byte))] == 0 {
+                classes[Int(Self.fold(byte))] = UInt8(classCount)
+                classCount += 1
+            }
+        }
+        for upper in UInt8(ascii: "A")...UInt8(ascii: "Z") {
+            classes[Int(upper)] = classes[Int(upper | 0x20)]
+        }
+
+        // Trie, one dense row per state, -1 for no edge
+        var transitions = [Int32](repeating: -1, count: classCount)
+        var ownOutputs: [[Int32]] = [[]]
+        for (index, pattern) in patterns.enumerated() where !pattern.isEmpty {
+            var state = 0
+            for byte in pattern {
+                let slot = state * classCount + Int(classes[Int(byte)])
+                if transitions[slot] < 0 {
+                    transitions[slot] = Int32(ownOutputs.count)
+                    transitions.append(contentsOf: repeatElement(-1, count: classCount))
+                    ownOutputs.append([])
+                }
+                state = Int(transitions[slot])
+            }
+            ownOutputs[state].append(Int32(index))
+        }
+
+        // Breadth-first: fill missing edges from the failure state, which is
+        // shallower and therefore already complete
+        let stateCount = ownOutputs.count
+        var failure = [Int](repeating: 0, count: stateCount)
+        var outputSets = ownOutputs
+        var queue: [Int] = []
+        for symbol in 0..<classCount {
+            let child = transitions[symbol]
+            if child < 0 {
+                transitions[symbol] = 0
+            } else {
+                queue.append(Int(child))
+            }
+        }
+        var head = 0
+        while head < queue.count {
+            let state = queue[head]
+            head += 1
+            outputSets[state] += outputSets[failure[state]]
+            for symbol in 0..<classCount {
+                let slot = state * classCount + symbol
+                let fallback = transitions[failure[state] * classCount + symbol]
+                if transitions[slot] < 0 {
+                    transitions[slot] = fallback
+                } else {
+                    let child = Int(transitions[slot])
+                    failure[child] = Int(fallback)
+                    queue.append(child)
+                }
+            }
+        }
+
+        var outputStarts: [Int32] = [0]
+        var outputs: [Int32] = []
+        for set in outputSets {
+            outputs += set
+            outputStarts.append(Int32(outputs.count))
+        }
+
+        var firstBytes = Set<UInt8>()
+        for pattern in patterns {
+            if let first = pattern.first {
+                firstBytes.insert(Self.fold(first))
+            }
+        }
+
+        self.patternCount = patterns.count
+        self.classes = classes
+        self.classCount = classCount
+        self.transitions = transitions
+        self.outputStarts = outputStarts
+        self.outputs = outputs
+        self.lengths = patterns.map { $0.count }
+        self.startBytes = firstBytes.count <= Self.maxPrefilterBytes
+            ? firstBytes.sorted().map { SIMD16(repeating: $0) }
+            : []
+    }
+
+    convenience init(literals: [String]) {
+        self.init(patterns: literals.map { Array($0.utf8) })
+    }
+
+    // MARK: - Scanning
+
+    /// Report every occurrence, in order of where it ends
+    /// - Parameter body: Called with the literal's index and byte range;
+    ///   return false to stop scanning
+    func scan(_ bytes: UnsafeRawBufferPointer, _ body: (_ pattern: Int, _ range: Range<Int>) -> Bool) {
+        guard let base = bytes.baseAddress, patternCount > 0 else { return }
+        let count = bytes.count
+
+        transitions.withUnsafeBufferPointer { transitions in
+            var state = 0
+            var index = 0
+            while index < count {
+                if state == 0 && !startBytes.isEmpty {
+                    index = nextCandidate(in: base, from: index, count: count)
+                    guard index < count else { return }
+                }
+
+                let byte = base.load(fromByteOffset: index, as: UInt8.self)
+                state = Int(transitions[state * classCount + Int(classes[Int(byte)])])
+                index += 1
+
+                let first = Int(outputStarts[state])
+                let last = Int(outputStarts[state + 1])
+                for slot in first..<last {
+                    let pattern = Int(outputs[slot])
+                    if !body(pattern, (index - lengths[pattern])..<index) {
+                        return
+                    }
+                }
+            }
+        }
+    }
+
+    /// Whether any literal occurs
+    func containsMatch(in bytes: UnsafeRawBufferPointer) -> Bool {
+        var found = false
+        scan(bytes) { _, _ in
+            found = true
+            return false
+        }
+        return found
+    }
+
+    // MARK: - Private Helpers
+
+    /// First offset at or after `index` holding a possible literal start
+    private func nextCandidate(in base: UnsafeRawPointer, from start: Int, count: Int) -> Int {
+        let upperA = SIMD16<UInt8>(repeating: UInt8(ascii: "A"))
+        let upperZ = SIMD16<UInt8>(repeating: UInt8(ascii: "Z"))
+        let caseBit = SIMD16<UInt8>(repeating: 0x20)
+
+        var index = start
+        while index + 16 <= count {
+            let chunk = base.loadUnaligned(fromByteOffset: index, as: SIMD16<UInt8>.self)
+            let folded = chunk.replacing(with: chunk | caseBit, where: (chunk .>= upperA) .& (chunk .<= upperZ))
+            var hits = folded .== startBytes[0]
+            for candidate in startBytes.dropFirst() {
+                hits = hits .| (folded .== candidate)
+            }
+            if any(hits) {
+                for lane in 0..<16 where hits[lane] {
+                    return index + lane
+                }
+            }
+            index += 16
+        }
+
+        // Tail shorter than a vector
+        while index < count {
+            let byte = Self.fold(base.load(fromByteOffset: index, as: UInt8.self))
+            if startBytes.contains(where: { $0[0] == byte }) {
+                return index
+            }
+            index += 1
+        }
+        return count
+    }
+
+    @inline(__always)
+    private static func fold(_ byte: UInt8) -> UInt8 {
+        return byte &- 0x41 < 26 ? byte | 0x20 : byte
+    }
+}
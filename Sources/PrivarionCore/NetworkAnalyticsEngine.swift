@@ -111,6 +111,7 @@ public class NetworkAnalyticsEngine {
         // Stop components
         metricsCollector.stop()
         eventProcessor.stop()
+        timeSeriesStorage.flush()
         
         // Clear subscriptions
         cancellables.removeAll()
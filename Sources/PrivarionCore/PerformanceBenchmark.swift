@@ -17,6 +17,12 @@ public struct PerformanceMetrics: Codable {
     public let renderTimeMs: Double?
     public let operationName: String
     public let interactive: Bool
+    /// Time spent installing hooks and resolving their originals
+    public let hookActivationTimeMs: Double?
+    /// Hooks whose original was resolved; with lazy activation, the hooks actually called
+    public let hooksActivated: Int?
+    /// Tail percentile of a latency benchmark, e.g. p99.9 under replayed load
+    public let tailLatencyMs: Double?
     
     public init(
         reportId: UUID = UUID(),
@@ -26,7 +32,10 @@ public struct PerformanceMetrics: Codable {
         startupTimeMs: Double? = nil,
         renderTimeMs: Double? = nil,
         operationName: String,
-        interactive: Bool = true
+        interactive: Bool = true,
+        hookActivationTimeMs: Double? = nil,
+        hooksActivated: Int? = nil,
+        tailLatencyMs: Double? = nil
     ) {
         self.reportId = reportId
         self.timestamp = timestamp
@@ -36,6 +45,9 @@ public struct PerformanceMetrics: Codable {
         self.renderTimeMs = renderTimeMs
         self.operationName = operationName
         self.interactive = interactive
+        self.hookActivationTimeMs = hookActivationTimeMs
+        self.hooksActivated = hooksActivated
+        self.tailLatencyMs = tailLatencyMs
     }
 }
 
@@ -52,6 +64,20 @@ public struct BenchmarkResult: Codable {
         case timeout = "TIMEOUT"
         case regression = "REGRESSION"
     }
+    
+    public init(
+        testName: String,
+        duration: TimeInterval,
+        metrics: PerformanceMetrics,
+        status: BenchmarkStatus,
+        iterations: Int
+    ) {
+        self.testName = testName
+        self.duration = duration
+        self.metrics = metrics
+        self.status = status
+        self.iterations = iterations
+    }
 }
 
 // MARK: - Performance Monitor
@@ -302,6 +328,40 @@ public class BenchmarkFramework {
         return result
     }
     
+    /// Record a result measured outside the framework, e.g. by a native benchmark
+    public func recordResult(_ result: BenchmarkResult) {
+        results.append(result)
+        logger.info("Recorded benchmark \(result.testName): \(result.status.rawValue), avg duration: \(result.duration)ms")
+    }
+    
+    // MARK: - Hook Overhead
+    
+    /// Record the in-process cost of the hooks installed in a process
+    /// One result per hook: `duration` is the mean latency and
+    /// `metrics.renderTimeMs` the 99th percentile, both in milliseconds.
+    public func recordHookOverhead(processID: pid_t) throws -> [BenchmarkResult] {
+        let reader = try HookStatisticsReader(processID: processID)
+        let hookResults = reader.readAll().filter { $0.calls > 0 }.map { hook in
+            BenchmarkResult(
+                testName: "hook_\(hook.functionName)",
+                duration: hook.averageLatencyNanoseconds / 1_000_000,
+                metrics: PerformanceMetrics(
+                    cpuUsage: 0,
+                    memoryUsageMB: 0,
+                    renderTimeMs: Double(hook.latencyPercentile(99)) / 1_000_000,
+                    operationName: hook.functionName,
+                    interactive: false
+                ),
+                status: .passed,
+                iterations: Int(clamping: hook.calls)
+            )
+        }
+        
+        results.append(contentsOf: hookResults)
+        logger.info("Recorded hook overhead for \(hookResults.count) hooks in process \(processID)")
+        return hookResults
+    }
+    
     // MARK: - Reporting
     
     public func getAllResults() -> [BenchmarkResult] {
@@ -327,6 +387,7 @@ public class BenchmarkFramework {
                         "memoryUsageMB": result.metrics.memoryUsageMB,
                         "startupTimeMs": result.metrics.startupTimeMs as Any,
                         "renderTimeMs": result.metrics.renderTimeMs as Any,
+                        "tailLatencyMs": result.metrics.tailLatencyMs as Any,
                         "operationName": result.metrics.operationName,
                         "interactive": result.metrics.interactive
                     ]
@@ -431,14 +492,23 @@ public class StartupPerformanceTracker {
         let endTime = DispatchTime.now()
         let startupTime = Double(endTime.uptimeNanoseconds - startTime.uptimeNanoseconds) / 1_000_000 // ms
         
+        // Share of the startup spent on hooks; reported only when any were installed
+        let activation = SyscallHookManager.ActivationStatistics.current
+        let hooked = activation.hooksInstalled > 0
+        
         let metrics = PerformanceMetrics(
             cpuUsage: shared.monitor.getCurrentCPUUsage(),
             memoryUsageMB: shared.monitor.getCurrentMemoryUsage(),
             startupTimeMs: startupTime,
-            operationName: "app_startup"
+            operationName: "app_startup",
+            hookActivationTimeMs: hooked ? activation.activationTimeMs : nil,
+            hooksActivated: hooked ? activation.originalsResolved : nil
         )
         
         shared.logger.info("App startup completed in \(startupTime)ms")
+        if hooked {
+            shared.logger.info("Hook activation took \(activation.activationTimeMs)ms for \(activation.originalsResolved) of \(activation.hooksInstalled) hooks")
+        }
         return metrics
     }
 }
@@ -453,15 +523,19 @@ public class RegressionDetector {
         public let maxDurationIncreasePercent: Double
         public let maxMemoryIncreasePercent: Double
         public let maxCPUIncreasePercent: Double
+        /// Allowed increase of `metrics.tailLatencyMs`; nil skips the check
+        public let maxTailLatencyIncreasePercent: Double?
         
         public init(
             maxDurationIncreasePercent: Double = 20.0,
             maxMemoryIncreasePercent: Double = 15.0,
-            maxCPUIncreasePercent: Double = 25.0
+            maxCPUIncreasePercent: Double = 25.0,
+            maxTailLatencyIncreasePercent: Double? = nil
         ) {
             self.maxDurationIncreasePercent = maxDurationIncreasePercent
             self.maxMemoryIncreasePercent = maxMemoryIncreasePercent
             self.maxCPUIncreasePercent = maxCPUIncreasePercent
+            self.maxTailLatencyIncreasePercent = maxTailLatencyIncreasePercent
         }
     }
     
@@ -477,12 +551,19 @@ public class RegressionDetector {
         let memoryIncrease = (current.metrics.memoryUsageMB - baseline.metrics.memoryUsageMB) / baseline.metrics.memoryUsageMB * 100
         let cpuIncrease = (current.metrics.cpuUsage - baseline.metrics.cpuUsage) / baseline.metrics.cpuUsage * 100
         
+        var tailIncrease = 0.0
+        if let baselineTail = baseline.metrics.tailLatencyMs, let currentTail = current.metrics.tailLatencyMs, baselineTail > 0 {
+            tailIncrease = (currentTail - baselineTail) / baselineTail * 100
+        }
+        let tailRegression = thresholds.maxTailLatencyIncreasePercent.map { tailIncrease > $0 } ?? false
+        
         let hasRegression = durationIncrease > thresholds.maxDurationIncreasePercent ||
                            memoryIncrease > thresholds.maxMemoryIncreasePercent ||
-                           cpuIncrease > thresholds.maxCPUIncreasePercent
+                           cpuIncrease > thresholds.maxCPUIncreasePercent ||
+                           tailRegression
         
         if hasRegression {
-            logger.warning("Performance regression detected for \(current.testName): Duration +\(durationIncrease)%, Memory +\(memoryIncrease)%, CPU +\(cpuIncrease)%")
+            logger.warning("Performance regression detected for \(current.testName): Duration +\(durationIncrease)%, Memory +\(memoryIncrease)%, CPU +\(cpuIncrease)%, Tail +\(tailIncrease)%")
         }
         
         return hasRegression
@@ -572,7 +653,8 @@ public class BenchmarkBaselineManager {
                     "timestamp": value.metrics.timestamp,
                     "cpuUsage": value.metrics.cpuUsage,
                     "memoryUsageMB": value.metrics.memoryUsageMB,
-                    "renderTimeMs": value.metrics.renderTimeMs as Any
+                    "renderTimeMs": value.metrics.renderTimeMs as Any,
+                    "tailLatencyMs": value.metrics.tailLatencyMs as Any
                 ]
             }
         }
@@ -603,7 +685,8 @@ public class BenchmarkBaselineManager {
                     cpuUsage: cpuUsage,
                     memoryUsageMB: memoryUsageMB,
                     renderTimeMs: item["renderTimeMs"] as? Double,
-                    operationName: testName
+                    operationName: testName,
+                    tailLatencyMs: item["tailLatencyMs"] as? Double
                 )
                 
                 let result = BenchmarkResult(
@@ -778,6 +861,14 @@ public final class AllocationTracker: @unchecked Sendable {
         remainingCount.withLock { $0 -= 1 }
     }
     
+    /// Record allocations measured in bulk, e.g. from heap statistics
+    public func recordAllocations(count: Int, bytes: Int) {
+        guard count > 0 else { return }
+        totalAllocations.withLock { $0 += count }
+        totalBytes.withLock { $0 += max(bytes, 0) }
+        remainingCount.withLock { $0 += count }
+    }
+    
     public func getCurrentMetrics() -> AllocationMetrics {
         let total = totalAllocations.withLock { $0 }
         let bytes = totalBytes.withLock { $0 }
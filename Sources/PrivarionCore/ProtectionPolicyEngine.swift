@@ -11,6 +11,9 @@ public class ProtectionPolicyEngine {
     /// Thread-safe access to policies
     private let queue = DispatchQueue(label: "com.privarion.policyengine", attributes: .concurrent)
     
+    /// Closures notified whenever the policy database changes
+    private var changeObservers: [() -> Void] = []
+    
     /// Initialize with default policy
     public init(defaultPolicy: ProtectionPolicy = .defaultPolicy()) {
         self.defaultPolicy = defaultPolicy
@@ -52,6 +55,7 @@ public class ProtectionPolicyEngine {
     public func addPolicy(_ policy: ProtectionPolicy) {
         queue.async(flags: .barrier) {
             self.policies[policy.identifier] = policy
+            self.notifyChangeObservers()
         }
     }
     
@@ -60,6 +64,7 @@ public class ProtectionPolicyEngine {
     public func removePolicy(identifier: String) {
         queue.async(flags: .barrier) {
             self.policies.removeValue(forKey: identifier)
+            self.notifyChangeObservers()
         }
     }
     
@@ -75,6 +80,17 @@ public class ProtectionPolicyEngine {
             for policy in loadedPolicies {
                 self.policies[policy.identifier] = policy
             }
+            self.notifyChangeObservers()
+        }
+    }
+    
+    /// Register a closure called after policies are added, removed or loaded
+    /// The closure runs inside the update barrier, before any evaluation can
+    /// see the new policies, so it must not call back into the engine.
+    /// - Parameter observer: Closure to call on every change
+    public func addChangeObserver(_ observer: @escaping () -> Void) {
+        queue.sync(flags: .barrier) {
+            changeObservers.append(observer)
         }
     }
     
@@ -143,6 +159,13 @@ public class ProtectionPolicyEngine {
     
     // MARK: - Private Methods
     
+    /// Notify change observers; called on the queue with the barrier held
+    private func notifyChangeObservers() {
+        for observer in changeObservers {
+            observer()
+        }
+    }
+    
     /// Validate bundle ID format
     private func validateBundleID(_ bundleID: String) throws {
         // Bundle ID should be reverse domain notation (e.g., com.example.app)
@@ -0,0 +1,464 @@
+import Foundation
+
+// MARK: - Quantile Sketch
+
+/// DDSketch quantile estimator with bounded relative error
+/// Values fall into logarithmic buckets, so every quantile is within
+/// `relativeAccuracy` of a value that was added, whatever the sample count.
+/// When the buckets would exceed `maxBuckets`, the lowest ones are merged,
+/// which only costs accuracy on the smallest values.
+internal struct QuantileSketch {
+
+    /// Magnitudes below this are counted as zero
+    static let minimumIndexableValue = 1e-9
+
+    let relativeAccuracy: Double
+    let maxBuckets: Int
+    private let gamma: Double
+    private let logGamma: Double
+
+    private var positive = Buckets()
+    private var negative = Buckets()
+    private var zeroCount: UInt64 = 0
+    private(set) var count: UInt64 = 0
+
+    init(relativeAccuracy: Double = 0.01, maxBuckets: Int = 512) {
+        self.relativeAccuracy = relativeAccuracy
+        self.maxBuckets = max(maxBuckets, 2)
+        self.gamma = (1 + relativeAccuracy) / (1 - relativeAccuracy)
+        self.logGamma = log(gamma)
+    }
+
+    mutating func add(_ value: Double) {
+        guard value.isFinite else { return }
+        count += 1
+        if value > Self.minimumIndexableValue {
+            positive.add(index: index(of: value), maxBuckets: maxBuckets)
+        } else if value < -Self.minimumIndexableValue {
+            negative.add(index: index(of: -value), maxBuckets: maxBuckets)
+        } else {
+            zeroCount += 1
+        }
+    }
+
+    /// Estimated value at quantile `q` in 0...1, nil while empty
+    func quantile(_ q: Double) -> Double? {
+        guard count > 0 else { return nil }
+        let rank = UInt64((min(max(q, 0), 1) * Double(count - 1)).rounded(.down))
+
+        // Negative values order by descending magnitude, then zeros, then positives
+        if rank < negative.total {
+            return -value(at: negative.index(atRank: negative.total - 1 - rank))
+        }
+        if rank < negative.total + zeroCount {
+            return 0
+        }
+        return value(at: positive.index(atRank: rank - negative.total - zeroCount))
+    }
+
+    private func index(of magnitude: Double) -> Int {
+        return Int((log(magnitude) / logGamma).rounded(.up))
+    }
+
+    private func value(at index: Int) -> Double {
+        return 2 * pow(gamma, Double(index)) / (gamma + 1)
+    }
+
+    /// Contiguous bucket counts starting at bucket `offset`
+    private struct Buckets {
+        var counts: [UInt64] = []
+        var offset = 0
+        var total: UInt64 = 0
+
+        mutating func add(index: Int, maxBuckets: Int) {
+            total += 1
+            guard !counts.isEmpty else {
+                counts = [1]
+                offset = index
+                return
+            }
+
+            if index < offset {
+                // Never grow downwards past the bucket limit; clamp instead
+                let lowest = max(index, offset + counts.count - maxBuckets)
+                if lowest < offset {
+                    counts.insert(contentsOf: repeatElement(0, count: offset - lowest), at: 0)
+                    offset = lowest
+                }
+                counts[max(index, offset) - offset] += 1
+            } else {
+                if index >= offset + counts.count {
+                    counts.append(contentsOf: repeatElement(0, count: index - offset - counts.count + 1))
+                }
+                counts[index - offset] += 1
+                collapseLowest(maxBuckets: maxBuckets)
+            }
+        }
+
+        /// Bucket holding the value of the given ascending rank
+        func index(atRank rank: UInt64) -> Int {
+            var seen: UInt64 = 0
+            for (position, count) in counts.enumerated() {
+                seen += count
+                if seen > rank {
+                    return offset + position
+                }
+            }
+            return offset + counts.count - 1
+        }
+
+        private mutating func collapseLowest(maxBuckets: Int) {
+            let excess = counts.count - maxBuckets
+            guard excess > 0 else { return }
+            counts[excess] += counts[0..<excess].reduce(0, +)
+            counts.removeFirst(excess)
+            offset += excess
+        }
+    }
+}
+
+// MARK: - Streaming Baselines
+
+/// Online baseline estimators per (source, metric) series
+/// Series statistics are kept as parallel arrays (structure of arrays), so
+/// a batch is scored by gathering a few columns into SIMD lanes, one series
+/// per lane. Each point costs a Welford update, an EWMA update and a sketch
+/// insertion, which is O(1) however long the series has run.
+internal final class StreamingBaselineStore {
+
+    /// Series identity; the data point source is the entity
+    struct SeriesKey: Hashable {
+        let source: String
+        let metric: String
+    }
+
+    /// Deviation of one point from its series baseline before the point was added
+    struct Score {
+        /// Samples in the baseline the point was scored against
+        let sampleCount: Int
+        let mean: Double
+        let standardDeviation: Double
+        /// Distance from the mean in standard deviations; 0 below two samples
+        let zScore: Double
+        /// Distance from the exponentially weighted mean, in weighted deviations
+        let ewmaScore: Double
+    }
+
+    /// Current estimates of one series
+    struct Snapshot {
+        let sampleCount: Int
+        let mean: Double
+        let standardDeviation: Double
+        let ewma: Double
+        let ewmStandardDeviation: Double
+        let minimum: Double
+        let maximum: Double
+        let lastUpdated: Date
+    }
+
+    /// Deviations are cut off here, so a constant series scores finitely
+    private static let maximumScore = 1e6
+
+    private static let lanes = 4
+
+    let ewmaAlpha: Double
+    let maxSeries: Int
+
+    private var indices: [SeriesKey: Int] = [:]
+    private var keys: [SeriesKey] = []
+    private var counts: [Double] = []
+    private var means: [Double] = []
+    private var m2s: [Double] = []
+    private var ewmas: [Double] = []
+    private var ewmVariances: [Double] = []
+    private var minimums: [Double] = []
+    private var maximums: [Double] = []
+    private var lastUpdated: [TimeInterval] = []
+    private var sketches: [QuantileSketch] = []
+
+    /// Slots from most to least recently used, as a doubly linked list
+    /// threaded through the slot arrays, so eviction takes the tail in O(1)
+    private var moreRecent: [Int] = []
+    private var lessRecent: [Int] = []
+    private var mostRecent = -1
+    private var leastRecent = -1
+
+    private let lock = NSLock()
+
+    /// - Parameters:
+    ///   - ewmaAlpha: Weight of each new point in the exponentially weighted estimates
+    ///   - maxSeries: Series tracked before the least recently used is replaced
+    init(ewmaAlpha: Double = 0.05, maxSeries: Int = 10_000) {
+        self.ewmaAlpha = ewmaAlpha
+        self.maxSeries = max(maxSeries, 1)
+    }
+
+    var seriesCount: Int {
+        lock.lock()
+        defer { lock.unlock() }
+        return keys.count
+    }
+
+    /// Score a batch against the current baselines, then fold it in
+    /// Every point is scored against the state before the batch, so the
+    /// order of points within a batch does not change their scores.
+    func scoreAndUpdate(_ points: [AnomalyDetectionEngine.DataPoint]) -> [Score] {
+        lock.lock()
+        defer { lock.unlock() }
+
+        // Never evict a series while a batch still refers to it
+        var scores: [Score] = []
+        scores.reserveCapacity(points.count)
+        var start = 0
+        while start < points.count {
+            let end = min(start + maxSeries, points.count)
+            scores += scoreAndUpdateLocked(points[start..<end])
+            start = end
+        }
+        return scores
+    }
+
+    func snapshot(source: String, metric: String) -> Snapshot? {
+        lock.lock()
+        defer { lock.unlock() }
+        return indices[SeriesKey(source: source, metric: metric)].map(snapshot(at:))
+    }
+
+    /// Snapshots of every series of one source, keyed by metric
+    func snapshots(source: String) -> [String: Snapshot] {
+        lock.lock()
+        defer { lock.unlock() }
+        var result: [String: Snapshot] = [:]
+        for (slot, key) in keys.enumerated() where key.source == source {
+            result[key.metric] = snapshot(at: slot)
+        }
+        return result
+    }
+
+    /// Estimated quantile of a series, nil if it has no samples
+    func quantile(_ q: Double, source: String, metric: String) -> Double? {
+        lock.lock()
+        defer { lock.unlock() }
+        return indices[SeriesKey(source: source, metric: metric)].flatMap { sketches[$0].quantile(q) }
+    }
+
+    func removeAll() {
+        lock.lock()
+        defer { lock.unlock() }
+        indices.removeAll()
+        keys.removeAll()
+        counts.removeAll()
+        means.removeAll()
+        m2s.removeAll()
+        ewmas.removeAll()
+        ewmVariances.removeAll()
+        minimums.removeAll()
+        maximums.removeAll()
+        lastUpdated.removeAll()
+        sketches.removeAll()
+        moreRecent.removeAll()
+        lessRecent.removeAll()
+        mostRecent = -1
+        leastRecent = -1
+    }
+
+    // MARK: - Scoring
+
+    private func scoreAndUpdateLocked(_ points: ArraySlice<AnomalyDetectionEngine.DataPoint>) -> [Score] {
+        let slots = points.map { slot(for: SeriesKey(source: $0.source, metric: $0.metric)) }
+        let scores = score(points.map { $0.value }, slots: slots)
+
+        for (slot, point) in zip(slots, points) {
+            update(slot, with: point.value, at: point.timestamp)
+        }
+        return scores
+    }
+
+    private func score(_ values: [Double], slots: [Int]) -> [Score] {
+        var zScores = [Double](repeating: 0, count: values.count)
+        var ewmaScores = [Double](repeating: 0, count: values.count)
+
+        var start = 0
+        while start + Self.lanes <= values.count {
+            scoreLanes(values, slots: slots, start: start, zScores: &zScores, ewmaScores: &ewmaScores)
+            start += Self.lanes
+        }
+        if start < values.count {
+            // Pad the tail with copies of its first point
+            let tail = Array(start..<values.count)
+            let padded = tail + Array(repeating: start, count: Self.lanes - tail.count)
+            var tailZ = [Double](repeating: 0, count: Self.lanes)
+            var tailEWMA = [Double](repeating: 0, count: Self.lanes)
+            scoreLanes(padded.map { values[$0] }, slots: padded.map { slots[$0] }, start: 0,
+                       zScores: &tailZ, ewmaScores: &tailEWMA)
+            for (lane, index) in tail.enumerated() {
+                zScores[index] = tailZ[lane]
+                ewmaScores[index] = tailEWMA[lane]
+            }
+        }
+
+        return values.indices.map { index in
+            let slot = slots[index]
+            return Score(
+                sampleCount: Int(counts[slot]),
+                mean: means[slot],
+                standardDeviation: standardDeviation(at: slot),
+                zScore: zScores[index],
+                ewmaScore: ewmaScores[index]
+            )
+        }
+    }
+
+    /// Score four points, one series per lane
+    private func scoreLanes(
+        _ values: [Double],
+        slots: [Int],
+        start: Int,
+        zScores: inout [Double],
+        ewmaScores: inout [Double]
+    ) {
+        func gather(_ column: [Double]) -> SIMD4<Double> {
+            return SIMD4(column[slots[start]], column[slots[start + 1]], column[slots[start + 2]], column[slots[start + 3]])
+        }
+
+        let x = SIMD4(values[start], values[start + 1], values[start + 2], values[start + 3])
+        let count = gather(counts)
+        let cold = count .< 2
+
+        let variance = gather(m2s) / pointwiseMax(count - 1, SIMD4(repeating: 1))
+        let z = deviations(x, from: gather(means), variance: variance).replacing(with: 0, where: cold)
+        let ewm = deviations(x, from: gather(ewmas), variance: gather(ewmVariances)).replacing(with: 0, where: cold)
+
+        for lane in 0..<Self.lanes {
+            zScores[start + lane] = z[lane]
+            ewmaScores[start + lane] = ewm[lane]
+        }
+    }
+
+    /// |x - mean| / sqrt(variance), capped at `maximumScore`
+    private func deviations(_ x: SIMD4<Double>, from mean: SIMD4<Double>, variance: SIMD4<Double>) -> SIMD4<Double> {
+        let difference = x - mean
+        let distance = pointwiseMax(difference, -difference)
+        let spread = pointwiseMax(variance, SIMD4(repeating: 0)).squareRoot()
+        let scaled = distance / pointwiseMax(spread, SIMD4(repeating: 1 / Self.maximumScore))
+        return pointwiseMin(scaled, SIMD4(repeating: Self.maximumScore))
+    }
+
+    // MARK: - Updates
+
+    private func slot(for key: SeriesKey) -> Int {
+        if let slot = indices[key] {
+            markUsed(slot)
+            return slot
+        }
+        guard keys.count >= maxSeries else {
+            appendSeries(key)
+            return keys.count - 1
+        }
+
+        // Replace the least recently used series; batches are split so
+        // that one not seen in the current batch always exists
+        let slot = leastRecent
+        markUsed(slot)
+        indices.removeValue(forKey: keys[slot])
+        indices[key] = slot
+        keys[slot] = key
+        resetSeries(at: slot)
+        return slot
+    }
+
+    private func appendSeries(_ key: SeriesKey) {
+        indices[key] = keys.count
+        keys.append(key)
+        counts.append(0)
+        means.append(0)
+        m2s.append(0)
+        ewmas.append(0)
+        ewmVariances.append(0)
+        minimums.append(.infinity)
+        maximums.append(-.infinity)
+        lastUpdated.append(0)
+        sketches.append(QuantileSketch())
+        moreRecent.append(-1)
+        lessRecent.append(-1)
+        pushMostRecent(keys.count - 1)
+    }
+
+    /// Move a slot to the front of the use list
+    private func markUsed(_ slot: Int) {
+        guard slot != mostRecent else { return }
+        let newer = moreRecent[slot]
+        let older = lessRecent[slot]
+        lessRecent[newer] = older
+        if older >= 0 {
+            moreRecent[older] = newer
+        } else {
+            leastRecent = newer
+        }
+        pushMostRecent(slot)
+    }
+
+    private func pushMostRecent(_ slot: Int) {
+        moreRecent[slot] = -1
+        lessRecent[slot] = mostRecent
+        if mostRecent >= 0 {
+            moreRecent[mostRecent] = slot
+        } else {
+            leastRecent = slot
+        }
+        mostRecent = slot
+    }
+
+    private func resetSeries(at slot: Int) {
+        counts[slot] = 0
+        means[slot] = 0
+        m2s[slot] = 0
+        ewmas[slot] = 0
+        ewmVariances[slot] = 0
+        minimums[slot] = .infinity
+        maximums[slot] = -.infinity
+        lastUpdated[slot] = 0
+        sketches[slot] = QuantileSketch()
+    }
+
+    private func update(_ slot: Int, with value: Double, at timestamp: Date) {
+        guard value.isFinite else { return }
+
+        // Welford's running mean and sum of squared differences
+        counts[slot] += 1
+        let delta = value - means[slot]
+        means[slot] += delta / counts[slot]
+        m2s[slot] += delta * (value - means[slot])
+
+        if counts[slot] == 1 {
+            ewmas[slot] = value
+            ewmVariances[slot] = 0
+        } else {
+            let ewmDelta = value - ewmas[slot]
+            ewmas[slot] += ewmaAlpha * ewmDelta
+            ewmVariances[slot] = (1 - ewmaAlpha) * (ewmVariances[slot] + ewmaAlpha * ewmDelta * ewmDelta)
+        }
+
+        minimums[slot] = min(minimums[slot], value)
+        maximums[slot] = max(maximums[slot], value)
+        lastUpdated[slot] = max(lastUpdated[slot], timestamp.timeIntervalSince1970)
+        sketches[slot].add(value)
+    }
+
+    private func standardDeviation(at slot: Int) -> Double {
+        return counts[slot] < 2 ? 0 : (m2s[slot] / (counts[slot] - 1)).squareRoot()
+    }
+
+    private func snapshot(at slot: Int) -> Snapshot {
+        return Snapshot(
+            sampleCount: Int(counts[slot]),
+            mean: means[slot],
+            standardDeviation: standardDeviation(at: slot),
+            ewma: ewmas[slot],
+            ewmStandardDeviation: max(ewmVariances[slot], 0).squareRoot(),
+            minimum: minimums[slot],
+            maximum: maximums[slot],
+            lastUpdated: Date(timeIntervalSince1970: lastUpdated[slot])
+        )
+    }
+}
@@ -29,6 +29,9 @@ internal class SwiftNIODNSProxyServer {
     private let connectionPool: DNSConnectionPool
     private let enableDoH: Bool
     
+    // MARK: - Answer Cache
+    private let answerCache: DNSAnswerCache
+    
     // MARK: - Async Channel Management (PATTERN-2025-067: SwiftNIO Async Channel Pattern)
     private var asyncChannel: NIOAsyncChannel<AddressedEnvelope<ByteBuffer>, AddressedEnvelope<ByteBuffer>>?
     
@@ -50,6 +53,7 @@ internal class SwiftNIODNSProxyServer {
         self.ruleEngine = ApplicationNetworkRuleEngine()
         self.blocklistManager = BlocklistManager()
         self.trafficMonitor = TrafficMonitoringService()
+        self.answerCache = DNSAnswerCache(configuration: configuration.dnsProxy)
         
         // Initialize DoH client if enabled (Requirement 4.8)
         if enableDoH {
@@ -192,57 +196,91 @@ internal class SwiftNIODNSProxyServer {
         }
     }
     
+    /// Outcome of the part of a query answered without the network
+    internal enum LocalResolution {
+        /// Not a query this proxy can parse; dropped
+        case malformed
+        /// Rewritten in place into an NXDOMAIN response
+        case blocked(response: ByteBuffer)
+        /// Served from the answer cache; `prefetch` is set when it is due for a refresh
+        case cached(response: ByteBuffer, prefetch: DNSQueryView?)
+        /// Needs an upstream answer
+        case forward(DNSQuery)
+    }
+    
     private func handleDNSRequest(
         _ request: AddressedEnvelope<ByteBuffer>,
         outbound: NIOAsyncChannelOutboundWriter<AddressedEnvelope<ByteBuffer>>,
         startTime: Date
     ) async {
         let clientAddress = request.remoteAddress
-        var requestBuffer = request.data
+        let requestBuffer = request.data
         
-        // Parse DNS query
-        guard let dnsQuery = parseDNSQuery(from: &requestBuffer) else {
+        switch resolveLocally(requestBuffer, applicationId: extractApplicationId(from: clientAddress)) {
+        case .malformed:
             logger.warning("Failed to parse DNS query from \(clientAddress)")
-            return
+            
+        case .blocked(let response):
+            await send(response, to: clientAddress, via: outbound, startTime: startTime, kind: "blocked")
+            
+        case .cached(let response, let prefetch):
+            if let query = prefetch {
+                prefetchDNSAnswer(for: query, requestBuffer: requestBuffer)
+            }
+            await send(response, to: clientAddress, via: outbound, startTime: startTime, kind: "cached")
+            
+        case .forward(let dnsQuery):
+            logger.debug("Processing DNS query for domain: \(dnsQuery.domain) from \(clientAddress)")
+            await forwardDNSQuery(dnsQuery, requestBuffer: requestBuffer, to: clientAddress, via: outbound, startTime: startTime)
+        }
+    }
+    
+    /// Parse, filter and cache-check a query without touching the network
+    /// This is the per-query decision path; the load harness replays
+    /// captured queries through it.
+    internal func resolveLocally(_ request: ByteBuffer, applicationId: String?) -> LocalResolution {
+        var requestBuffer = request
+        
+        // Parse the question in place; the reader index is left untouched
+        guard let view = requestBuffer.withUnsafeReadableBytes({ DNSWireFormat.parseQuery($0) }) else {
+            return .malformed
         }
-        
-        logger.debug("Processing DNS query for domain: \(dnsQuery.domain) from \(clientAddress)")
         
         // Check if domain should be blocked
-        let applicationId = extractApplicationId(from: clientAddress)
-        let shouldBlock = shouldBlockDomain(dnsQuery.domain, for: applicationId)
+        if shouldBlockQuery(view, in: requestBuffer, for: applicationId) {
+            // Rewrite the query into an NXDOMAIN response (domain not found)
+            let length = DNSWireFormat.blockedResponseLength(for: view, answer: .nameError)
+            rewriteAsResponse(&requestBuffer, length: length) {
+                DNSWireFormat.writeBlockedResponse(into: $0, for: view, answer: .nameError)
+            }
+            return .blocked(response: requestBuffer)
+        }
         
-        if shouldBlock {
-            // Send blocked response
-            await sendBlockedResponse(for: dnsQuery, to: clientAddress, via: outbound, startTime: startTime)
-            logger.info("Blocked DNS query for domain: \(dnsQuery.domain)")
-            return
+        // Serve repeats straight from the answer cache
+        if let cached = requestBuffer.withUnsafeReadableBytes({ answerCache.answer(for: view, in: $0) }) {
+            return .cached(response: ByteBuffer(bytes: cached.response), prefetch: cached.shouldPrefetch ? view : nil)
         }
         
-        // Forward to upstream DNS server
-        await forwardDNSQuery(dnsQuery, requestBuffer: requestBuffer, to: clientAddress, via: outbound, startTime: startTime)
+        // Only forwarded queries need the name as a string
+        let domain = requestBuffer.withUnsafeReadableBytes { DNSWireFormat.name(of: view, in: $0) }
+        return .forward(DNSQuery(view: view, domain: domain))
     }
     
-    private func sendBlockedResponse(
-        for query: DNSQuery,
+    private func send(
+        _ response: ByteBuffer,
         to clientAddress: SocketAddress,
         via outbound: NIOAsyncChannelOutboundWriter<AddressedEnvelope<ByteBuffer>>,
-        startTime: Date
+        startTime: Date,
+        kind: String
     ) async {
-        // Create DNS response with NXDOMAIN (domain not found)
-        let response = createDNSErrorResponse(for: query.id, errorCode: 3) // NXDOMAIN
-        
         do {
             let envelope = AddressedEnvelope(remoteAddress: clientAddress, data: response)
             try await outbound.write(envelope)
             
             let latency = Date().timeIntervalSince(startTime)
-            // Report metrics (delegate integration will be improved in later iteration)
-            logger.info("Blocked query for \(query.domain), latency: \(latency)ms")
-            
-            logger.debug("Sent blocked response for \(query.domain) to \(clientAddress), latency: \(String(format: "%.3f", latency * 1000))ms")
+            logger.debug("Sent \(kind) response to \(clientAddress), latency: \(String(format: "%.3f", latency * 1000))ms")
         } catch {
-            logger.error("Failed to send blocked DNS response: \(error)")
+            logger.error("Failed to send \(kind) DNS response: \(error)")
         }
     }
     
@@ -253,27 +291,59 @@ internal class SwiftNIODNSProxyServer {
         via outbound: NIOAsyncChannelOutboundWriter<AddressedEnvelope<ByteBuffer>>,
         startTime: Date
     ) async {
+        let response: ByteBuffer
+        do {
+            response = try await resolveUpstream(requestBuffer, domain: query.domain).response
+        } catch {
+            logger.error("Failed to forward DNS query for \(query.domain): \(error)")
+            // Send server failure response
+            response = createDNSErrorResponse(for: query, request: requestBuffer, rcode: DNSWireFormat.rcodeServerFailure)
+        }
+        
+        do {
+            // Forward response to client
+            let envelope = AddressedEnvelope(remoteAddress: clientAddress, data: response)
+            try await outbound.write(envelope)
+            
+            let latency = Date().timeIntervalSince(startTime)
+            logger.info("Forwarded query for \(query.domain), latency: \(String(format: "%.3f", latency * 1000))ms")
+        } catch {
+            logger.warning("Failed to send DNS response: \(error.localizedDescription)")
+        }
+    }
+    
+    /// Refresh a popular cached name before it expires, without a waiting client
+    private func prefetchDNSAnswer(for query: DNSQueryView, requestBuffer: ByteBuffer) {
+        let domain = requestBuffer.withUnsafeReadableBytes { DNSWireFormat.name(of: query, in: $0) }
+        Task {
+            do {
+                // An uncacheable answer leaves the old entry due for another prefetch
+                guard try await resolveUpstream(requestBuffer, domain: domain).stored else {
+                    answerCache.prefetchFailed(for: query)
+                    logger.debug("Prefetched DNS answer for \(domain) was not cacheable")
+                    return
+                }
+                logger.debug("Prefetched DNS answer for \(domain)")
+            } catch {
+                answerCache.prefetchFailed(for: query)
+                logger.debug("Prefetch failed for \(domain): \(error)")
+            }
+        }
+    }
+    
+    /// Resolve a query upstream, via DoH when enabled, and cache the answer
+    /// - Returns: The response, and whether the answer cache stored it
+    private func resolveUpstream(_ requestBuffer: ByteBuffer, domain: String) async throws -> (response: ByteBuffer, stored: Bool) {
         // Try DoH first if enabled (Requirement 4.8)
         if enableDoH, let dohClient = dohClient {
             do {
                 // Convert ByteBuffer to Data
                 let requestData = requestBuffer.withUnsafeReadableBytes { Data($0) }
                 let responseData = try await dohClient.queryRaw(requestData)
-                
-                // Convert response data to ByteBuffer
-                var responseBuffer = ByteBufferAllocator().buffer(capacity: responseData.count)
-                responseBuffer.writeBytes(responseData)
-                
-                // Send response to client
-                let envelope = AddressedEnvelope(remoteAddress: clientAddress, data: responseBuffer)
-                try await outbound.write(envelope)
-                
-                let latency = Date().timeIntervalSince(startTime)
-                logger.info("Forwarded query via DoH for \(query.domain), latency: \(String(format: "%.3f", latency * 1000))ms")
-                
-                return
+                let stored = responseData.withUnsafeBytes { answerCache.store(response: $0) }
+                return (ByteBuffer(bytes: responseData), stored)
             } catch {
-                logger.warning("DoH query failed for \(query.domain), falling back to UDP: \(error)")
+                logger.warning("DoH query failed for \(domain), falling back to UDP: \(error)")
                 // Fall through to UDP forwarding
             }
         }
@@ -281,143 +351,72 @@ internal class SwiftNIODNSProxyServer {
         // Use connection pool for UDP forwarding (Requirement 18.8)
         let upstreamServer = upstreamServers.first ?? "8.8.8.8"
         
-        do {
-            // Get connection from pool
-            let pooledConnection = try connectionPool.getConnection(host: upstreamServer, port: 53)
-            defer {
-                connectionPool.returnConnection(pooledConnection)
+        // Get connection from pool
+        let pooledConnection = try connectionPool.getConnection(host: upstreamServer, port: 53)
+        defer {
+            connectionPool.returnConnection(pooledConnection)
+        }
+        
+        pooledConnection.markUsed()
+        
+        // Create upstream channel using the pooled connection
+        let upstreamChannel = try await DatagramBootstrap(group: eventLoopGroup)
+            .connect(host: upstreamServer, port: 53) { channel in
+                return channel.eventLoop.makeCompletedFuture {
+                    return try NIOAsyncChannel<ByteBuffer, ByteBuffer>(wrappingChannelSynchronously: channel)
+                }
             }
+        
+        // Send query to upstream server and receive response
+        let response = try await upstreamChannel.executeThenClose { upstreamInbound, upstreamOutbound in
+            // Send query
+            try await upstreamOutbound.write(requestBuffer)
             
-            pooledConnection.markUsed()
-            
-            // Create upstream channel using the pooled connection
-            let upstreamChannel = try await DatagramBootstrap(group: eventLoopGroup)
-                .connect(host: upstreamServer, port: 53) { channel in
-                    return channel.eventLoop.makeCompletedFuture {
-                        return try NIOAsyncChannel<ByteBuffer, ByteBuffer>(wrappingChannelSynchronously: channel)
-                    }
-                }
+            // Wait for response with timeout
+            let timeoutTask = Task<ByteBuffer, Error> {
+                try await Task.sleep(nanoseconds: UInt64(queryTimeout * 1_000_000_000))
+                throw DNSProxyError.timeout
+            }
             
-            // Send query to upstream server and receive response
-            try await upstreamChannel.executeThenClose { upstreamInbound, upstreamOutbound in
-                // Send query
-                try await upstreamOutbound.write(requestBuffer)
-                
-                // Wait for response with timeout
-                let timeoutTask = Task<ByteBuffer, Error> {
-                    try await Task.sleep(nanoseconds: UInt64(queryTimeout * 1_000_000_000))
-                    throw DNSProxyError.timeout
-                }
-                
-                let responseTask = Task<ByteBuffer, Error> {
-                    for try await response in upstreamInbound {
-                        return response
-                    }
-                    throw DNSProxyError.noResponse
-                }
-                
-                do {
-                    let response = try await withThrowingTaskGroup(of: ByteBuffer.self) { group in
-                        group.addTask { try await responseTask.value }
-                        group.addTask { try await timeoutTask.value }
-                        
-                        let result = try await group.next()!
-                        group.cancelAll()
-                        return result
-                    }
-                    
-                    // Forward response to client
-                    let envelope = AddressedEnvelope(remoteAddress: clientAddress, data: response)
-                    try await outbound.write(envelope)
-                    
-                    let latency = Date().timeIntervalSince(startTime)
-                    logger.info("Forwarded query for \(query.domain), latency: \(String(format: "%.3f", latency * 1000))ms")
-                    
-                } catch {
-                    logger.error("Failed to forward DNS query for \(query.domain): \(error)")
-                    // Send server failure response
-                    let errorResponse = createDNSErrorResponse(for: query.id, errorCode: 2) // SERVFAIL
-                    let envelope = AddressedEnvelope(remoteAddress: clientAddress, data: errorResponse)
-                    do {
-                        try await outbound.write(envelope)
-                    } catch {
-                        logger.warning("Failed to send error response: \(error.localizedDescription)")
-                    }
+            let responseTask = Task<ByteBuffer, Error> {
+                for try await response in upstreamInbound {
+                    return response
                 }
+                throw DNSProxyError.noResponse
             }
             
-        } catch {
-            logger.error("Failed to forward DNS query for \(query.domain): \(error)")
-            // Send server failure response
-            let errorResponse = createDNSErrorResponse(for: query.id, errorCode: 2) // SERVFAIL
-            let envelope = AddressedEnvelope(remoteAddress: clientAddress, data: errorResponse)
-            do {
-                try await outbound.write(envelope)
-            } catch {
-                logger.warning("Failed to send error response: \(error.localizedDescription)")
+            return try await withThrowingTaskGroup(of: ByteBuffer.self) { group in
+                group.addTask { try await responseTask.value }
+                group.addTask { try await timeoutTask.value }
+                
+                let result = try await group.next()!
+                group.cancelAll()
+                return result
             }
         }
+        
+        let stored = response.withUnsafeReadableBytes { answerCache.store(response: $0) }
+        return (response, stored)
     }
     
     // MARK: - DNS Protocol Helpers
     
-    private func parseDNSQuery(from buffer: inout ByteBuffer) -> DNSQuery? {
-        guard buffer.readableBytes >= 12 else { return nil } // Minimum DNS header size
-        
-        let originalReaderIndex = buffer.readerIndex
-        
-        // Read DNS header
-        guard let id = buffer.readInteger(as: UInt16.self) else {
-            buffer.moveReaderIndex(to: originalReaderIndex)
-            return nil
-        }
-        
-        // Skip flags, QDCOUNT, ANCOUNT, NSCOUNT, ARCOUNT
-        buffer.moveReaderIndex(forwardBy: 10)
-        
-        // Parse domain name from question section
-        guard let domain = readDomainName(from: &buffer) else {
-            buffer.moveReaderIndex(to: originalReaderIndex)
-            return nil
+    /// Rewrite a query buffer into a response of `length` bytes in place
+    /// Grows the buffer only when the response is longer than the query.
+    private func rewriteAsResponse(_ buffer: inout ByteBuffer, length: Int, _ write: (UnsafeMutableRawBufferPointer) -> Void) {
+        let readable = buffer.readableBytes
+        if readable < length {
+            buffer.writeRepeatingByte(0, count: length - readable)
         }
-        
-        return DNSQuery(id: id, domain: domain)
+        buffer.withUnsafeMutableReadableBytes { write($0) }
+        buffer.moveWriterIndex(to: buffer.readerIndex + length)
     }
     
-    private func readDomainName(from buffer: inout ByteBuffer) -> String? {
-        var components: [String] = []
-        
-        while let labelLength = buffer.readInteger(as: UInt8.self) {
-            if labelLength == 0 {
-                break // End of domain name
-            }
-            
-            if labelLength > 63 {
-                return nil // Invalid label length
-            }
-            
-            guard let labelData = buffer.readSlice(length: Int(labelLength)),
-                  let label = labelData.getString(at: 0, length: labelData.readableBytes) else {
-                return nil
-            }
-            
-            components.append(label)
+    private func createDNSErrorResponse(for query: DNSQuery, request: ByteBuffer, rcode: UInt16) -> ByteBuffer {
+        var buffer = request
+        rewriteAsResponse(&buffer, length: query.view.questionEnd) {
+            DNSWireFormat.writeErrorResponse(into: $0, for: query.view, rcode: rcode)
         }
-        
-        return components.isEmpty ? nil : components.joined(separator: ".")
-    }
-    
-    private func createDNSErrorResponse(for queryId: UInt16, errorCode: UInt8) -> ByteBuffer {
-        var buffer = ByteBufferAllocator().buffer(capacity: 12)
-        
-        // DNS Header
-        buffer.writeInteger(queryId) // ID
-        buffer.writeInteger(UInt16(0x8000 | UInt16(errorCode))) // Flags with error code
-        buffer.writeInteger(UInt16(0)) // QDCOUNT
-        buffer.writeInteger(UInt16(0)) // ANCOUNT
-        buffer.writeInteger(UInt16(0)) // NSCOUNT
-        buffer.writeInteger(UInt16(0)) // ARCOUNT
-        
         return buffer
     }
     
@@ -427,9 +426,13 @@ internal class SwiftNIODNSProxyServer {
         return nil
     }
     
-    private func shouldBlockDomain(_ domain: String, for applicationId: String?) -> Bool {
-        // Use the correct BlocklistManager method
-        return blocklistManager.shouldBlockDomain(domain)
+    private func shouldBlockQuery(_ query: DNSQueryView, in buffer: ByteBuffer, for applicationId: String?) -> Bool {
+        // Match the canonical name straight from the packet
+        return buffer.withUnsafeReadableBytes { message in
+            DNSWireFormat.withCanonicalName(of: query, in: message) {
+                blocklistManager.shouldBlockDomain(canonicalName: $0)
+            }
+        }
     }
 }
 
@@ -35,6 +35,9 @@ public struct HookRules: Codable {
     /// Enable/disable getgid() hook
     public var getgid: Bool = false
     
+    /// Enable/disable the sysctlbyname() and IORegistryEntryCreateCFProperty() hooks
+    public var hardwareIdentifiers: Bool = false
+    
     /// Application-specific hook rules
     public var applicationRules: [String: ApplicationHookRules] = [:]
     
@@ -122,6 +125,45 @@ public struct FakeSystemInfo: Codable {
     public init() {}
 }
 
+// MARK: - Rule Resolution
+
+extension SyscallHookConfiguration {
+    
+    /// Hook rules that apply to an application, merged with the global rules
+    public func effectiveRules(for bundleId: String?) -> HookRules {
+        guard let bundleId = bundleId,
+              let appRules = hooks.applicationRules[bundleId] else {
+            return hooks
+        }
+        
+        if !appRules.inheritGlobalRules {
+            return appRules.hooks
+        }
+        
+        // Merge global and application-specific rules
+        var effectiveRules = hooks
+        
+        // Application-specific rules override global rules
+        if appRules.hooks.uname != hooks.uname {
+            effectiveRules.uname = appRules.hooks.uname
+        }
+        if appRules.hooks.gethostname != hooks.gethostname {
+            effectiveRules.gethostname = appRules.hooks.gethostname
+        }
+        if appRules.hooks.getuid != hooks.getuid {
+            effectiveRules.getuid = appRules.hooks.getuid
+        }
+        if appRules.hooks.getgid != hooks.getgid {
+            effectiveRules.getgid = appRules.hooks.getgid
+        }
+        if appRules.hooks.hardwareIdentifiers != hooks.hardwareIdentifiers {
+            effectiveRules.hardwareIdentifiers = appRules.hooks.hardwareIdentifiers
+        }
+        
+        return effectiveRules
+    }
+}
+
 // MARK: - Hook Configuration Manager
 
 /// Manages syscall hook configuration
@@ -223,35 +265,7 @@ public final class SyscallHookConfigurationManager {
     
     /// Get effective hook rules for a specific application
     public func getEffectiveRules(for bundleId: String?) throws -> HookRules {
-        let config = try loadConfiguration()
-        
-        guard let bundleId = bundleId,
-              let appRules = config.hooks.applicationRules[bundleId] else {
-            return config.hooks
-        }
-        
-        if !appRules.inheritGlobalRules {
-            return appRules.hooks
-        }
-        
-        // Merge global and application-specific rules
-        var effectiveRules = config.hooks
-        
-        // Application-specific rules override global rules
-        if appRules.hooks.uname != config.hooks.uname {
-            effectiveRules.uname = appRules.hooks.uname
-        }
-        if appRules.hooks.gethostname != config.hooks.gethostname {
-            effectiveRules.gethostname = appRules.hooks.gethostname
-        }
-        if appRules.hooks.getuid != config.hooks.getuid {
-            effectiveRules.getuid = appRules.hooks.getuid
-        }
-        if appRules.hooks.getgid != config.hooks.getgid {
-            effectiveRules.getgid = appRules.hooks.getgid
-        }
-        
-        return effectiveRules
+        return try loadConfiguration().effectiveRules(for: bundleId)
     }
     
     /// Validate configuration
@@ -2,116 +2,37 @@ import PrivarionHook
 import Foundation
 import Logging
 
-// MARK: - Global State for Hook Functions
-
-/// Thread-safe global state for hook functions to access fake data
-/// Since C function pointers cannot capture context, we need global state
-internal final class SyscallHookGlobalState {
-    static let shared = SyscallHookGlobalState()
-    
-    private let lock = NSLock()
-    private var _fakeData: FakeDataDefinitions?
-    
-    private init() {}
-    
-    func updateConfiguration(_ fakeData: FakeDataDefinitions) {
-        lock.lock()
-        defer { lock.unlock() }
-        _fakeData = fakeData
-    }
-    
-    func getFakeData() -> FakeDataDefinitions? {
-        lock.lock()
-        defer { lock.unlock() }
-        return _fakeData
-    }
-}
-
 // MARK: - C-Compatible Hook Functions
 
 /// C-compatible uname hook function
+/// Answers from the native prebuilt utsname template published by the hook library
 @_cdecl("hooked_uname")
 func hooked_uname(_ unamePtr: UnsafeMutablePointer<utsname>) -> Int32 {
-    guard let fakeData = SyscallHookGlobalState.shared.getFakeData() else {
-        // Fallback to original if no fake data available
-        return -1
-    }
-    
-    let fakeInfo = fakeData.systemInfo
-    
-    // Zero out the structure
-    memset(unamePtr, 0, MemoryLayout<utsname>.size)
-    
-    // Copy fake data to the structure
-    _ = withUnsafeMutablePointer(to: &unamePtr.pointee.sysname) { ptr in
-        fakeInfo.sysname.withCString { cStr in
-            strncpy(UnsafeMutableRawPointer(ptr).assumingMemoryBound(to: CChar.self), cStr, 255)
-        }
-    }
-    
-    _ = withUnsafeMutablePointer(to: &unamePtr.pointee.nodename) { ptr in
-        fakeInfo.nodename.withCString { cStr in
-            strncpy(UnsafeMutableRawPointer(ptr).assumingMemoryBound(to: CChar.self), cStr, 255)
-        }
-    }
-    
-    _ = withUnsafeMutablePointer(to: &unamePtr.pointee.release) { ptr in
-        fakeInfo.release.withCString { cStr in
-            strncpy(UnsafeMutableRawPointer(ptr).assumingMemoryBound(to: CChar.self), cStr, 255)
-        }
-    }
-    
-    _ = withUnsafeMutablePointer(to: &unamePtr.pointee.version) { ptr in
-        fakeInfo.version.withCString { cStr in
-            strncpy(UnsafeMutableRawPointer(ptr).assumingMemoryBound(to: CChar.self), cStr, 255)
-        }
-    }
-    
-    _ = withUnsafeMutablePointer(to: &unamePtr.pointee.machine) { ptr in
-        fakeInfo.machine.withCString { cStr in
-            strncpy(UnsafeMutableRawPointer(ptr).assumingMemoryBound(to: CChar.self), cStr, 255)
-        }
-    }
-    
-    return 0 // Success
+    return ph_spoofed_uname(unamePtr)
 }
 
 /// C-compatible gethostname hook function
+/// Answers from the native length-prefixed hostname published by the hook library
 @_cdecl("hooked_gethostname")
 func hooked_gethostname(_ buffer: UnsafeMutablePointer<CChar>, _ size: Int32) -> Int32 {
-    guard let fakeData = SyscallHookGlobalState.shared.getFakeData() else {
+    guard size > 0 else {
         return -1
     }
-    
-    let fakeHostname = fakeData.hostname
-    let maxSize = min(Int(size), fakeHostname.count + 1)
-    
-    fakeHostname.withCString { cStr in
-        strncpy(buffer, cStr, maxSize - 1)
-        buffer[maxSize - 1] = 0 // Null terminate
-    }
-    
-    return 0 // Success
+    return ph_spoofed_gethostname(buffer, Int(size))
 }
 
 /// C-compatible getuid hook function
+/// Answers from the hook library's per-thread identity cache
 @_cdecl("hooked_getuid")
 func hooked_getuid() -> uid_t {
-    guard let fakeData = SyscallHookGlobalState.shared.getFakeData() else {
-        return 0 // Fallback UID
-    }
-    
-    return uid_t(fakeData.userId)
+    return ph_spoofed_getuid(0) // Fallback UID
 }
 
 /// C-compatible getgid hook function
+/// Answers from the hook library's per-thread identity cache
 @_cdecl("hooked_getgid")
 func hooked_getgid() -> gid_t {
-    guard let fakeData = SyscallHookGlobalState.shared.getFakeData() else {
-        return 0 // Fallback GID
-    }
-    
-    return gid_t(fakeData.groupId)
+    return ph_spoofed_getgid(0) // Fallback GID
 }
 
 /// Swift wrapper for the Privarion Hook System
@@ -168,6 +89,8 @@ public final class SyscallHookManager {
         case gethostname = "gethostname"
         case getuid = "getuid"
         case getgid = "getgid"
+        case sysctlbyname = "sysctlbyname"
+        case ioRegistryProperty = "IORegistryEntryCreateCFProperty"
         
         public var description: String {
             switch self {
@@ -179,6 +102,10 @@ public final class SyscallHookManager {
                 return "User ID (getuid)"
             case .getgid:
                 return "Group ID (getgid)"
+            case .sysctlbyname:
+                return "Hardware identifiers (sysctlbyname)"
+            case .ioRegistryProperty:
+                return "Hardware identifiers (IORegistryEntryCreateCFProperty)"
             }
         }
     }
@@ -225,6 +152,9 @@ public final class SyscallHookManager {
     private let initializationLock = NSLock()
     private let configurationManager: SyscallHookConfigurationManager
     
+    /// Identifiers generated for this session, published on first use
+    private lazy var sessionIdentifiers = HardwareIdentifierEngine().makeIdentifierTable()
+    
     /// Current hook configuration (computed property)
     private var currentHookConfig: SyscallHookConfiguration? {
         return try? configurationManager.loadConfiguration()
@@ -276,20 +206,6 @@ public final class SyscallHookManager {
         logger.info("Hook system cleanup completed")
     }
     
-    /// Install a hook for a specific system call (Deprecated - use configuration-driven approach)
-    private func installHook<T>(
-        for function: SyscallFunction,
-        replacement: T
-    ) throws -> HookHandle {
-        try ensureInitialized()
-        
-        logger.debug("Installing hook for function: \(function.rawValue)")
-        
-        // NOTE: This method is deprecated due to unsafeBitCast issues with Swift function to C function pointer conversion
-        // Use configuration-driven approach instead
-        throw HookError.unsupportedOperation
-    }
-    
     /// Install hooks based on current configuration
     public func installConfiguredHooks() throws -> [String: HookHandle] {
         try ensureInitialized()
@@ -300,72 +216,10 @@ public final class SyscallHookManager {
         
         logger.info("Installing hooks based on configuration - getuid: \(hookConfig.hooks.getuid), getgid: \(hookConfig.hooks.getgid), gethostname: \(hookConfig.hooks.gethostname), uname: \(hookConfig.hooks.uname)")
         
-        var installedHooks: [String: HookHandle] = [:]
-        
-        // Prepare configuration data for C layer
-        var configData = PHookConfigData()
-        configData.user_id = uid_t(hookConfig.fakeData.userId)
-        configData.group_id = gid_t(hookConfig.fakeData.groupId)
-        
-        // Convert String to C string for hostname
-        hookConfig.fakeData.hostname.withCString { hostnamePtr in
-            strncpy(&configData.hostname.0, hostnamePtr, 255)
-            configData.hostname.255 = 0 // Ensure null termination
-        }
-        
-        // Convert system info to C strings
-        hookConfig.fakeData.systemInfo.sysname.withCString { systemPtr in
-            strncpy(&configData.system_name.0, systemPtr, 255)
-            configData.system_name.255 = 0
-        }
-        
-        hookConfig.fakeData.systemInfo.machine.withCString { machinePtr in
-            strncpy(&configData.machine.0, machinePtr, 255)
-            configData.machine.255 = 0
-        }
-        
-        hookConfig.fakeData.systemInfo.release.withCString { releasePtr in
-            strncpy(&configData.release.0, releasePtr, 255)
-            configData.release.255 = 0
-        }
-        
-        hookConfig.fakeData.systemInfo.version.withCString { versionPtr in
-            strncpy(&configData.version.0, versionPtr, 511)
-            configData.version.511 = 0
-        }
-        
-        // Install hooks based on configuration
-        if hookConfig.hooks.getuid {
-            var handle = PHookHandle()
-            let result = ph_install_getuid_hook(&configData, &handle)
-            try throwIfError(result)
-            installedHooks["getuid"] = HookHandle(rawHandle: handle)
-            logger.debug("Installed getuid hook with fake UID: \(hookConfig.fakeData.userId)")
-        }
-        
-        if hookConfig.hooks.getgid {
-            var handle = PHookHandle()
-            let result = ph_install_getgid_hook(&configData, &handle)
-            try throwIfError(result)
-            installedHooks["getgid"] = HookHandle(rawHandle: handle)
-            logger.debug("Installed getgid hook with fake GID: \(hookConfig.fakeData.groupId)")
-        }
-        
-        if hookConfig.hooks.gethostname {
-            var handle = PHookHandle()
-            let result = ph_install_gethostname_hook(&configData, &handle)
-            try throwIfError(result)
-            installedHooks["gethostname"] = HookHandle(rawHandle: handle)
-            logger.debug("Installed gethostname hook with fake hostname: \(hookConfig.fakeData.hostname)")
-        }
-        
-        if hookConfig.hooks.uname {
-            var handle = PHookHandle()
-            let result = ph_install_uname_hook(&configData, &handle)
-            try throwIfError(result)
-            installedHooks["uname"] = HookHandle(rawHandle: handle)
-            logger.debug("Installed uname hook with fake system info")
-        }
+        let installedHooks = try installBuiltinHooks(
+            enabledFunctions(in: hookConfig.hooks),
+            fakeData: hookConfig.fakeData
+        )
         
         logger.info("Hook installation completed - total hooks: \(installedHooks.count)")
         
@@ -385,6 +239,24 @@ public final class SyscallHookManager {
         logger.info("Hook removed successfully for \(handle.functionName)")
     }
     
+    /// Remove several hooks as one transaction
+    /// Nothing is removed unless every handle refers to an installed hook
+    public func removeHooks(_ handles: [HookHandle]) throws {
+        try ensureInitialized()
+        
+        guard !handles.isEmpty else { return }
+        
+        logger.debug("Removing \(handles.count) hooks as one batch")
+        
+        let rawHandles = handles.map { $0.rawHandle }
+        let result = rawHandles.withUnsafeBufferPointer { buffer in
+            ph_remove_hooks(buffer.baseAddress, buffer.count)
+        }
+        try throwIfError(result)
+        
+        logger.info("Removed \(handles.count) hooks successfully")
+    }
+    
     /// Remove all installed hooks
     public func removeAllHooks() throws {
         try ensureInitialized()
@@ -454,6 +326,122 @@ public final class SyscallHookManager {
         return ph_is_platform_supported()
     }
     
+    /// Version of the configuration snapshot currently seen by the hooks
+    public var configurationVersion: UInt64 {
+        return ph_get_config_version()
+    }
+    
+    /// Export per-hook counters and latency histograms for this process
+    /// Readable from any process through `HookStatisticsReader`
+    public func enableStatisticsExport() throws {
+        try throwIfError(ph_stats_enable())
+        logger.info("Hook statistics export enabled")
+    }
+    
+    /// Publish every hooked call of this process into its shared event region
+    /// Consumed from any process through `HookEventStream`
+    public func enableEventExport() throws {
+        try throwIfError(ph_events_enable())
+        logger.info("Hook event export enabled")
+    }
+    
+    // MARK: - Lazy Activation
+    
+    /// Environment variable that makes an injected library install lazily
+    public static let lazyActivationEnvironmentKey = PH_LAZY_ENV
+    
+    /// Cost of activating hooks in this process, cumulative since launch
+    public struct ActivationStatistics {
+        public let hooksInstalled: Int
+        /// Originals looked up so far; with lazy activation, hooks actually called
+        public let originalsResolved: Int
+        public let installTimeMs: Double
+        /// Time first calls spent resolving originals
+        public let lazyResolveTimeMs: Double
+        
+        /// Total time spent making hooks usable
+        public var activationTimeMs: Double {
+            return installTimeMs + lazyResolveTimeMs
+        }
+        
+        internal init(_ stats: PHActivationStats) {
+            self.hooksInstalled = Int(stats.hooks_installed)
+            self.originalsResolved = Int(stats.originals_resolved)
+            self.installTimeMs = Double(stats.install_ns) / 1_000_000
+            self.lazyResolveTimeMs = Double(stats.lazy_resolve_ns) / 1_000_000
+        }
+        
+        /// Statistics of this process's hook library
+        public static var current: ActivationStatistics {
+            var stats = PHActivationStats()
+            ph_get_activation_stats(&stats)
+            return ActivationStatistics(stats)
+        }
+    }
+    
+    /// Whether hooks installed from now on resolve their originals on first call
+    public var isLazyActivationEnabled: Bool {
+        return ph_is_lazy_activation_enabled()
+    }
+    
+    /// Resolve originals on first call instead of at install
+    public func setLazyActivation(enabled: Bool) {
+        ph_set_lazy_activation(enabled)
+        logger.info("Lazy hook activation \(enabled ? "enabled" : "disabled")")
+    }
+    
+    public var activationStatistics: ActivationStatistics {
+        return ActivationStatistics.current
+    }
+    
+    // MARK: - Tracing
+    
+    /// Binary trace record of one hooked call
+    public struct TraceRecord {
+        /// Monotonic timestamp in nanoseconds
+        public let timestampNanoseconds: UInt64
+        public let threadID: UInt64
+        public let returnValue: Int64
+        /// `HookHandle.id` of the hook that ran
+        public let hookID: UInt32
+        
+        internal init(_ record: PHTraceRecord) {
+            self.timestampNanoseconds = record.timestamp_ns
+            self.threadID = record.thread_id
+            self.returnValue = record.return_value
+            self.hookID = record.hook_id
+        }
+    }
+    
+    /// Whether the hook library was built with tracing support
+    public var isTracingAvailable: Bool {
+        return ph_is_tracing_available()
+    }
+    
+    /// Number of trace records dropped because a per-thread ring was full
+    public var droppedTraceRecordCount: UInt64 {
+        return ph_trace_dropped_count()
+    }
+    
+    /// Enable or disable recording of hooked calls
+    public func setTracing(enabled: Bool) {
+        ph_set_tracing_enabled(enabled)
+        logger.info("Hook tracing \(enabled ? "enabled" : "disabled")")
+    }
+    
+    /// Drain up to `maxCount` pending trace records
+    public func drainTraceRecords(maxCount: Int = 256) -> [TraceRecord] {
+        guard maxCount > 0 else {
+            return []
+        }
+        
+        var buffer = [PHTraceRecord](repeating: PHTraceRecord(), count: maxCount)
+        let count = buffer.withUnsafeMutableBufferPointer { pointer in
+            ph_trace_drain(pointer.baseAddress, pointer.count)
+        }
+        return buffer.prefix(count).map(TraceRecord.init)
+    }
+    
     // MARK: - Configuration Management
     
     /// Get current hook configuration
@@ -466,6 +454,10 @@ public final class SyscallHookManager {
         try ensureInitialized()
         try configurationManager.validateConfiguration(config)
         try configurationManager.saveConfiguration(config)
+        
+        // Installed hooks pick up the new fake data on their next call
+        var configData = config.fakeData.hookConfigData
+        try throwIfError(ph_update_config(&configData))
         logger.info("Hook configuration updated")
     }
     
@@ -476,40 +468,151 @@ public final class SyscallHookManager {
         let config = try configurationManager.loadConfiguration()
         let rules = try configurationManager.getEffectiveRules(for: bundleId)
         
-        var installedHooks: [String: HookHandle] = [:]
-        
         logger.info("Installing hooks based on configuration for bundleId: \(bundleId ?? "global") - uname: \(rules.uname), gethostname: \(rules.gethostname), getuid: \(rules.getuid), getgid: \(rules.getgid)")
         
-        // Store fake data globally for C functions to access
-        SyscallHookGlobalState.shared.updateConfiguration(config.fakeData)
+        let installedHooks = try installBuiltinHooks(enabledFunctions(in: rules), fakeData: config.fakeData)
+        
+        logger.info("Installed \(installedHooks.count) hooks successfully")
+        return installedHooks
+    }
+    
+    /// Apply the profile of a bundle from a binary profile table
+    /// This is what the injected library does in its constructor when
+    /// `HookProfileTable.pathEnvironmentKey` is set.
+    public func loadProfileTable(at url: URL, bundleId: String?) throws {
+        try ensureInitialized()
+        
+        let result = url.path.withCString { path in
+            if let bundleId = bundleId {
+                return bundleId.withCString { ph_load_profile(path, $0) }
+            }
+            return ph_load_profile(path, nil)
+        }
+        try throwIfError(result)
+        logger.info("Applied hook profile for bundleId: \(bundleId ?? "default")")
+    }
+    
+    // MARK: - Hardware Identifiers
+    
+    /// Identifiers the sysctlbyname and I/O Registry hooks answer with
+    /// Generated once per session; `applyIdentifierTable(_:)` replaces them.
+    public var identifierTable: HardwareIdentifierTable {
+        return sessionIdentifiers
+    }
+    
+    /// Publish spoofed hardware identifiers to the installed hooks
+    public func applyIdentifierTable(_ table: HardwareIdentifierTable) throws {
+        let result = table.withSpecs { specs in
+            ph_set_identifiers(specs.baseAddress, specs.count)
+        }
+        try throwIfError(result)
+        sessionIdentifiers = table
+        logger.info("Published \(table.count) hardware identifiers")
+    }
+    
+    /// Publish the identifiers of a table file
+    /// This is what the injected library does in its constructor when
+    /// `HardwareIdentifierTable.pathEnvironmentKey` is set.
+    public func loadIdentifierTable(at url: URL) throws {
+        let result = url.path.withCString { ph_load_identifiers($0) }
+        try throwIfError(result)
+        logger.info("Loaded hardware identifiers from \(url.path)")
+    }
+    
+    // MARK: - Process Inheritance
+    
+    /// Whether processes spawned from this one load the hook library too
+    public var isInheritanceEnabled: Bool {
+        return ph_is_inheritance_enabled()
+    }
+    
+    /// Make processes spawned from this one load the hook library and the
+    /// `PRIVARION_HOOK_*` variables this process was started with
+    /// The injected library does this in its constructor, so helpers of a
+    /// target launched through `DYLDInjectionManager` are covered without
+    /// launching them separately. The variables are captured on the first call.
+    /// - Parameter libraryPath: Library children load, nil for the one holding the hooks
+    public func enableInheritance(libraryPath: String? = nil) throws {
+        let result: PHResult
+        if let libraryPath = libraryPath {
+            result = libraryPath.withCString { ph_enable_inheritance($0) }
+        } else {
+            result = ph_enable_inheritance(nil)
+        }
+        try throwIfError(result)
+        logger.info("Spawned processes inherit the hook library")
+    }
+    
+    // MARK: - Batch Installation
+    
+    /// Functions enabled by a set of hook rules, in declaration order
+    private func enabledFunctions(in rules: HookRules) -> [SyscallFunction] {
+        return SyscallFunction.allCases.filter { function in
+            switch function {
+            case .uname:
+                return rules.uname
+            case .gethostname:
+                return rules.gethostname
+            case .getuid:
+                return rules.getuid
+            case .getgid:
+                return rules.getgid
+            case .sysctlbyname, .ioRegistryProperty:
+                return rules.hardwareIdentifiers
+            }
+        }
+    }
+    
+    /// Publish the fake data and install the built-in replacements for the
+    /// given functions in a single transaction: symbols are resolved and
+    /// images patched once, and a failure leaves no hook behind. A function
+    /// whose image is not loaded (IOKit in a plain CLI host) is skipped
+    /// rather than failing the identity hooks installed alongside it
+    private func installBuiltinHooks(
+        _ functions: [SyscallFunction],
+        fakeData: FakeDataDefinitions
+    ) throws -> [String: HookHandle] {
+        var configData = fakeData.hookConfigData
+        try throwIfError(ph_update_config(&configData))
         
-        // Install uname hook if enabled
-        if rules.uname {
-            let handle = try installHook(for: .uname, replacement: hooked_uname)
-            installedHooks["uname"] = handle
+        guard !functions.isEmpty else {
+            return [:]
         }
         
-        // Install gethostname hook if enabled
-        if rules.gethostname {
-            let handle = try installHook(for: .gethostname, replacement: hooked_gethostname)
-            installedHooks["gethostname"] = handle
+        // Identifier hooks pass everything through until a table exists
+        if functions.contains(where: { $0 == .sysctlbyname || $0 == .ioRegistryProperty }) && ph_get_identifier_count() == 0 {
+            try applyIdentifierTable(sessionIdentifiers)
         }
         
-        // Install getuid hook if enabled
-        if rules.getuid {
-            let handle = try installHook(for: .getuid, replacement: hooked_getuid)
-            installedHooks["getuid"] = handle
+        let names = functions.compactMap { strdup($0.rawValue) }
+        defer { names.forEach { free($0) } }
+        guard names.count == functions.count else {
+            throw HookError.memoryError
         }
         
-        // Install getgid hook if enabled
-        if rules.getgid {
-            let handle = try installHook(for: .getgid, replacement: hooked_getgid)
-            installedHooks["getgid"] = handle
+        // A nil replacement selects the library's built-in replacement
+        let specs = names.map { PHookSpec(function_name: UnsafePointer($0), replacement_function: nil) }
+        var rawHandles = [PHookHandle](repeating: PHookHandle(), count: specs.count)
+        
+        let result = specs.withUnsafeBufferPointer { specBuffer in
+            rawHandles.withUnsafeMutableBufferPointer { handleBuffer in
+                ph_install_loaded_hooks(specBuffer.baseAddress, specBuffer.count, handleBuffer.baseAddress)
+            }
         }
+        try throwIfError(result)
         
-        logger.info("Installed \(installedHooks.count) hooks successfully")
+        var installedHooks: [String: HookHandle] = [:]
+        for (function, rawHandle) in zip(functions, rawHandles) {
+            guard rawHandle.is_valid else {
+                logger.warning("Skipped \(function.rawValue) hook: symbol is not loaded")
+                continue
+            }
+            installedHooks[function.rawValue] = HookHandle(rawHandle: rawHandle)
+            logger.debug("Installed \(function.rawValue) hook")
+        }
         return installedHooks
     }
+    
      // MARK: - Mock Implementations (Deprecated - kept for reference)
 
     private func mockUname(_ unamePtr: UnsafeMutablePointer<utsname>, fakeInfo: FakeSystemInfo) -> Int32 {
@@ -591,6 +694,46 @@ public final class SyscallHookManager {
     }
 }
 
+// MARK: - C Configuration Conversion
+
+extension FakeDataDefinitions {
+    /// C configuration block consumed by the hook library
+    public var hookConfigData: PHookConfigData {
+        var configData = PHookConfigData()
+        configData.user_id = uid_t(userId)
+        configData.group_id = gid_t(groupId)
+        
+        // Convert String to C string for hostname
+        hostname.withCString { hostnamePtr in
+            strncpy(&configData.hostname.0, hostnamePtr, 255)
+            configData.hostname.255 = 0 // Ensure null termination
+        }
+        
+        // Convert system info to C strings
+        systemInfo.sysname.withCString { systemPtr in
+            strncpy(&configData.system_name.0, systemPtr, 255)
+            configData.system_name.255 = 0
+        }
+        
+        systemInfo.machine.withCString { machinePtr in
+            strncpy(&configData.machine.0, machinePtr, 255)
+            configData.machine.255 = 0
+        }
+        
+        systemInfo.release.withCString { releasePtr in
+            strncpy(&configData.release.0, releasePtr, 255)
+            configData.release.255 = 0
+        }
+        
+        systemInfo.version.withCString { versionPtr in
+            strncpy(&configData.version.0, versionPtr, 511)
+            configData.version.511 = 0
+        }
+        
+        return configData
+    }
+}
+
 // MARK: - Error Conversion
 
 private extension SyscallHookManager.HookError {
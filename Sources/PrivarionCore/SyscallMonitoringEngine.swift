@@ -275,6 +275,19 @@ public class SyscallMonitoringEngine {
     private var eventTimestamps: [Date] = []
     private let maxTimestampHistory = 1000
     
+    /// Hook trace draining
+    private var traceDrainTimer: DispatchSourceTimer?
+    private var tracedHookNames: [UInt32: String] = [:]
+    private var tracedProcessIdentity: (processID: Int32, processName: String, userID: UInt32, groupID: UInt32)?
+    private let traceDrainInterval: DispatchTimeInterval = .milliseconds(50)
+    private let traceDrainBatchSize = 256
+    
+    /// Event streams of other hooked processes, drained on a dedicated thread
+    private var eventStreams: [pid_t: HookEventStream] = [:]
+    private let eventStreamsLock = NSLock()
+    private var eventDrainThread: Thread?
+    private let maxEventDrainBackoff: TimeInterval = 0.016
+    
     /// Configuration
     private var config: SyscallMonitoringConfig {
         return configManager.getCurrentConfiguration().modules.syscallMonitoring
@@ -367,6 +380,7 @@ public class SyscallMonitoringEngine {
         if isMonitoring {
             try updateSyscallHooks()
         }
+        updateEventFilters()
         
         logger.info("Successfully added monitoring rule", metadata: ["rule_id": "\(rule.id)"])
     }
@@ -385,6 +399,7 @@ public class SyscallMonitoringEngine {
         if isMonitoring {
             try updateSyscallHooks()
         }
+        updateEventFilters()
         
         logger.info("Removed monitoring rule", metadata: ["rule_id": "\(ruleId)"])
     }
@@ -401,6 +416,7 @@ public class SyscallMonitoringEngine {
         rulesQueue.async(flags: .barrier) {
             self.rules.removeAll()
         }
+        updateEventFilters()
         
         logger.info("Cleared all monitoring rules")
     }
@@ -436,6 +452,7 @@ public class SyscallMonitoringEngine {
         rulesQueue.async(flags: .barrier) {
             self.rules[ruleId] = updatedRule
         }
+        updateEventFilters()
         
         logger.info("Updated rule enabled state", metadata: [
             "rule_id": "\(ruleId)",
@@ -443,6 +460,57 @@ public class SyscallMonitoringEngine {
         ])
     }
     
+    /// Start consuming the hook events a separately hooked process publishes
+    /// The process must have been launched with PRIVARION_HOOK_EVENTS=1 (or
+    /// have called ph_events_enable). Its events go through the same rule
+    /// evaluation as events from this process; the enabled rules are also
+    /// compiled into the process's native filter, so calls no rule can
+    /// match are never published.
+    public func attachEventStream(processID: pid_t) throws {
+        let stream = try HookEventStream(processID: processID)
+        
+        eventStreamsLock.lock()
+        defer { eventStreamsLock.unlock() }
+        applyEventFilter(to: stream)
+        eventStreams[processID] = stream
+        
+        if eventDrainThread == nil {
+            let thread = Thread { [weak self] in
+                self?.runEventDrainLoop()
+            }
+            thread.name = "privarion.monitoring.event-drain"
+            thread.qualityOfService = .userInitiated
+            eventDrainThread = thread
+            thread.start()
+        }
+        
+        logger.info("Attached hook event stream", metadata: [
+            "pid": "\(processID)",
+            "process_name": "\(stream.processName)"
+        ])
+    }
+    
+    /// Stop consuming the events of a process
+    public func detachEventStream(processID: pid_t) {
+        eventStreamsLock.lock()
+        let stream = eventStreams.removeValue(forKey: processID)
+        eventStreamsLock.unlock()
+        
+        if let stream = stream {
+            logger.info("Detached hook event stream", metadata: [
+                "pid": "\(processID)",
+                "dropped_events": "\(stream.droppedCount)"
+            ])
+        }
+    }
+    
+    /// Processes whose event streams are currently attached
+    public var attachedEventStreamProcessIDs: [pid_t] {
+        eventStreamsLock.lock()
+        defer { eventStreamsLock.unlock() }
+        return Array(eventStreams.keys)
+    }
+    
     // MARK: - Private Methods
     
     private func setupLogging() {
@@ -543,6 +611,16 @@ public class SyscallMonitoringEngine {
     }
     
     private func setupSyscallInterception() throws {
+        // Capture the real identity before the hooks are live; the drain
+        // loop must never call a hooked function itself
+        let processInfo = ProcessInfo.processInfo
+        tracedProcessIdentity = (
+            processID: processInfo.processIdentifier,
+            processName: processInfo.processName,
+            userID: getuid(),
+            groupID: getgid()
+        )
+        
         // Get all unique syscalls from enabled rules
         let monitoredSyscalls = getMonitoredSyscalls()
         
@@ -575,9 +653,13 @@ public class SyscallMonitoringEngine {
         logger.info("Configured syscall hooks for monitoring", metadata: [
             "installed_hooks": "\(installedHooks.keys.sorted())"
         ])
+        
+        startTraceDraining(for: installedHooks)
     }
     
     private func teardownSyscallInterception() {
+        stopTraceDraining()
+        
         do {
             try syscallHookManager.removeAllHooks()
             logger.debug("Removed all syscall hooks")
@@ -586,6 +668,216 @@ public class SyscallMonitoringEngine {
         }
     }
     
+    private func startTraceDraining(for installedHooks: [String: SyscallHookManager.HookHandle]) {
+        guard syscallHookManager.isTracingAvailable else {
+            logger.debug("Hook tracing not compiled in; syscall events will not be generated")
+            return
+        }
+        
+        var hookNames: [UInt32: String] = [:]
+        for (name, handle) in installedHooks {
+            hookNames[handle.id] = name
+        }
+        
+        let timer = DispatchSource.makeTimerSource(queue: monitoringQueue)
+        timer.schedule(deadline: .now() + traceDrainInterval, repeating: traceDrainInterval)
+        timer.setEventHandler { [weak self] in
+            self?.drainTraceRecords()
+        }
+        
+        monitoringQueue.sync {
+            tracedHookNames = hookNames
+            traceDrainTimer = timer
+        }
+        syscallHookManager.setTracing(enabled: true)
+        timer.resume()
+    }
+    
+    private func stopTraceDraining() {
+        syscallHookManager.setTracing(enabled: false)
+        
+        monitoringQueue.sync {
+            traceDrainTimer?.cancel()
+            traceDrainTimer = nil
+            // Deliver whatever the hooks recorded before tracing was switched off
+            drainTraceRecords()
+            tracedHookNames = [:]
+        }
+    }
+    
+    /// Convert pending hook trace records into syscall events (runs on monitoringQueue)
+    private func drainTraceRecords() {
+        guard let identity = tracedProcessIdentity else {
+            return
+        }
+        
+        var records = syscallHookManager.drainTraceRecords(maxCount: traceDrainBatchSize)
+        while !records.isEmpty {
+            for record in records {
+                guard let syscallName = tracedHookNames[record.hookID] else {
+                    continue
+                }
+                eventProcessor.send(SyscallEvent(
+                    syscallName: syscallName,
+                    processID: identity.processID,
+                    processName: identity.processName,
+                    userID: identity.userID,
+                    groupID: identity.groupID,
+                    arguments: [],
+                    returnValue: Int32(truncatingIfNeeded: record.returnValue)
+                ))
+            }
+            
+            if records.count < traceDrainBatchSize {
+                break
+            }
+            records = syscallHookManager.drainTraceRecords(maxCount: traceDrainBatchSize)
+        }
+    }
+    
+    /// Recompile the native filter of every attached stream after a rule change
+    private func updateEventFilters() {
+        eventStreamsLock.lock()
+        defer { eventStreamsLock.unlock() }
+        for stream in eventStreams.values {
+            applyEventFilter(to: stream)
+        }
+    }
+    
+    /// Install the enabled rules into a stream's native filter so its process
+    /// only publishes candidate events (eventStreamsLock held)
+    private func applyEventFilter(to stream: HookEventStream) {
+        let filterRules: [HookEventStream.FilterRule] = rulesQueue.sync {
+            rules.values
+                .filter { $0.enabled && rule($0, canMatchEventsOf: stream) }
+                .map { rule in
+                    HookEventStream.FilterRule(
+                        syscalls: Set(rule.condition.syscalls),
+                        allowedPathPrefixes: rule.condition.pathFilters?.allowedPaths ?? [],
+                        blockedPathPrefixes: rule.condition.pathFilters?.blockedPaths ?? []
+                    )
+                }
+        }
+        
+        guard filterRules.count <= HookEventStream.maxFilterRules else {
+            // Too many rules to filter natively; evaluate everything in Swift
+            stream.clearFilter()
+            return
+        }
+        
+        do {
+            try stream.setFilter(filterRules)
+        } catch {
+            stream.clearFilter()
+            logger.warning("Publishing all hooked calls, event filter not installed", metadata: [
+                "pid": "\(stream.processID)",
+                "error": "\(error.localizedDescription)"
+            ])
+        }
+    }
+    
+    /// Whether a rule can match any event of a stream's process
+    /// Process filters and exceptions only look at the process name, PID and
+    /// credentials, which never change within one stream.
+    private func rule(_ rule: MonitoringRule, canMatchEventsOf stream: HookEventStream) -> Bool {
+        if let processFilters = rule.condition.processFilters {
+            if !processFilters.allowedProcesses.isEmpty &&
+               !processFilters.allowedProcesses.contains(stream.processName) {
+                return false
+            }
+            if processFilters.blockedProcesses.contains(stream.processName) {
+                return false
+            }
+            if !processFilters.allowedUIDs.isEmpty &&
+               !processFilters.allowedUIDs.contains(stream.userID) {
+                return false
+            }
+            if processFilters.blockedUIDs.contains(stream.userID) {
+                return false
+            }
+        }
+        
+        let processEvent = SyscallEvent(
+            syscallName: "",
+            processID: stream.processID,
+            processName: stream.processName,
+            userID: stream.userID,
+            groupID: stream.groupID,
+            arguments: [],
+            returnValue: 0
+        )
+        return !rule.exceptions.contains { evaluateException($0, for: processEvent) }
+    }
+    
+    /// Body of the event drain thread; exits once no stream is attached
+    private func runEventDrainLoop() {
+        var backoff: TimeInterval = 0.001
+        
+        while true {
+            eventStreamsLock.lock()
+            let streams = Array(eventStreams.values)
+            if streams.isEmpty {
+                eventDrainThread = nil
+                eventStreamsLock.unlock()
+                return
+            }
+            eventStreamsLock.unlock()
+            
+            var drained = 0
+            for stream in streams {
+                let count = stream.drain { syscallName, record in
+                    eventProcessor.send(syscallEvent(
+                        syscallName,
+                        from: record,
+                        processID: stream.processID,
+                        processName: stream.processName,
+                        userID: stream.userID,
+                        groupID: stream.groupID
+                    ))
+                }
+                drained += count
+                
+                // The region stays mapped after the target exits; detach
+                // once it is gone and its lanes are empty
+                if count == 0 && kill(stream.processID, 0) != 0 && errno == ESRCH {
+                    detachEventStream(processID: stream.processID)
+                }
+            }
+            
+            // Keep draining while records arrive; back off while idle
+            if drained > 0 {
+                backoff = 0.001
+            } else {
+                Thread.sleep(forTimeInterval: backoff)
+                backoff = min(backoff * 2, maxEventDrainBackoff)
+            }
+        }
+    }
+    
+    /// Syscall event for a record drained from a hook event stream
+    /// A path the record carries becomes both the only argument and the
+    /// event's file path, so path rules see what the native filter saw; a
+    /// truncated path keeps its first `HookEventStream.Event.maxArgumentLength` bytes.
+    internal func syscallEvent(
+        _ syscallName: String,
+        from record: HookEventStream.Event,
+        processID: pid_t,
+        processName: String,
+        userID: UInt32,
+        groupID: UInt32
+    ) -> SyscallEvent {
+        return SyscallEvent(
+            syscallName: syscallName,
+            processID: processID,
+            processName: processName,
+            userID: userID,
+            groupID: groupID,
+            arguments: record.argument.map { [$0] } ?? [],
+            returnValue: Int32(truncatingIfNeeded: record.returnValue),
+            filePath: record.argumentIsPath ? record.argument : nil
+        )
+    }
+    
     private func updateSyscallHooks() throws {
         if isMonitoring {
             teardownSyscallInterception()
@@ -652,7 +944,7 @@ public class SyscallMonitoringEngine {
         }
     }
     
-    private func evaluateRules(for event: SyscallEvent) -> [MonitoringRule] {
+    internal func evaluateRules(for event: SyscallEvent) -> [MonitoringRule] {
         return rulesQueue.sync {
             let enabledRules = rules.values.filter { $0.enabled }
             var matchingRules: [MonitoringRule] = []
@@ -13,6 +13,9 @@ public class TelemetryDatabase {
     /// Telemetry patterns for detection
     private var patterns: [TelemetryPattern]
     
+    /// Bumped whenever `patterns` changes, so matchers know to recompile
+    private var patternRevision: UInt64 = 0
+    
     /// Thread-safe access queue
     private let queue = DispatchQueue(label: "com.privarion.telemetry-database", attributes: .concurrent)
     
@@ -210,11 +213,20 @@ public class TelemetryDatabase {
         }
     }
     
+    /// Get all telemetry patterns with the revision they belong to
+    /// - Returns: The patterns and a counter that changes whenever they do
+    internal func patternSnapshot() -> (patterns: [TelemetryPattern], revision: UInt64) {
+        return queue.sync {
+            return (patterns, patternRevision)
+        }
+    }
+    
     /// Add a telemetry pattern to the database
     /// - Parameter pattern: The pattern to add
     public func addPattern(_ pattern: TelemetryPattern) {
         queue.async(flags: .barrier) {
             self.patterns.append(pattern)
+            self.patternRevision += 1
         }
     }
     
@@ -223,6 +235,7 @@ public class TelemetryDatabase {
     public func removePattern(_ pattern: TelemetryPattern) {
         queue.async(flags: .barrier) {
             self.patterns.removeAll { $0 == pattern }
+            self.patternRevision += 1
         }
     }
     
@@ -253,6 +266,7 @@ public class TelemetryDatabase {
         queue.async(flags: .barrier) {
             self.endpoints = remoteDatabase.endpoints
             self.patterns = remoteDatabase.patterns
+            self.patternRevision += 1
         }
     }
     
@@ -283,6 +297,7 @@ public class TelemetryDatabase {
         queue.async(flags: .barrier) {
             self.endpoints = database.endpoints
             self.patterns = database.patterns
+            self.patternRevision += 1
         }
     }
 }
@@ -364,16 +379,73 @@ public struct TelemetryPattern: Codable, Equatable, Sendable {
     ///   - string: String to match against
     /// - Returns: True if string matches pattern
     private func wildcardMatch(pattern: String, string: String) -> Bool {
-        let regexPattern = pattern
-            .replacingOccurrences(of: ".", with: "\\.")
-            .replacingOccurrences(of: "*", with: ".*")
+        return WildcardPattern(pattern).matches(string)
+    }
+}
+
+// MARK: - Wildcard Pattern
+
+/// Compiled `*` glob, matched ASCII case-insensitively without regexes
+/// Literal segments between stars are found left to right, which is exact
+/// for globs whose only metacharacter is `*`.
+internal struct WildcardPattern {
+    /// Folded literal runs between stars
+    private let segments: [[UInt8]]
+    
+    init(_ pattern: String) {
+        self.segments = pattern.split(separator: "*", omittingEmptySubsequences: false).map { segment in
+            segment.utf8.map(WildcardPattern.fold)
+        }
+    }
+    
+    /// Whether the whole string matches
+    func matches(_ string: String) -> Bool {
+        var string = string
+        return string.withUTF8 { matches(bytes: $0) }
+    }
+    
+    func matches(bytes: UnsafeBufferPointer<UInt8>) -> Bool {
+        guard segments.count > 1 else {
+            return bytes.count == segments[0].count && Self.equalsFolded(bytes, at: 0, segments[0])
+        }
         
-        guard let regex = try? NSRegularExpression(pattern: "^" + regexPattern + "$", options: .caseInsensitive) else {
+        let first = segments[0]
+        let last = segments[segments.count - 1]
+        guard bytes.count >= first.count + last.count,
+              Self.equalsFolded(bytes, at: 0, first),
+              Self.equalsFolded(bytes, at: bytes.count - last.count, last) else {
             return false
         }
         
-        let range = NSRange(string.startIndex..., in: string)
-        return regex.firstMatch(in: string, options: [], range: range) != nil
+        var position = first.count
+        let end = bytes.count - last.count
+        for segment in segments[1..<(segments.count - 1)] where !segment.isEmpty {
+            guard let found = Self.find(segment, in: bytes, from: position, to: end) else {
+                return false
+            }
+            position = found + segment.count
+        }
+        return true
+    }
+    
+    private static func find(_ segment: [UInt8], in bytes: UnsafeBufferPointer<UInt8>, from start: Int, to end: Int) -> Int? {
+        guard end - start >= segment.count else { return nil }
+        for offset in start...(end - segment.count) where equalsFolded(bytes, at: offset, segment) {
+            return offset
+        }
+        return nil
+    }
+    
+    private static func equalsFolded(_ bytes: UnsafeBufferPointer<UInt8>, at offset: Int, _ segment: [UInt8]) -> Bool {
+        for index in 0..<segment.count where fold(bytes[offset + index]) != segment[index] {
+            return false
+        }
+        return true
+    }
+    
+    @inline(__always)
+    private static func fold(_ byte: UInt8) -> UInt8 {
+        return byte &- 0x41 < 26 ? byte | 0x20 : byte
     }
 }
 
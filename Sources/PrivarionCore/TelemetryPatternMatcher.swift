@@ -3,6 +3,9 @@ import Foundation
 // MARK: - Telemetry Pattern Matcher
 
 /// Matches network requests against telemetry patterns
+/// Patterns are compiled once per database revision: wildcards into literal
+/// segment matchers and every payload term into one `MultiPatternScanner`,
+/// so a payload is inspected in a single pass over its raw bytes.
 /// Requirements: 10.4-10.7
 public class TelemetryPatternMatcher {
     // MARK: - Properties
@@ -10,8 +13,11 @@ public class TelemetryPatternMatcher {
     /// Telemetry database containing patterns
     private let database: TelemetryDatabase
     
-    /// Thread-safe access queue
-    private let queue = DispatchQueue(label: "com.privarion.telemetry-pattern-matcher", attributes: .concurrent)
+    /// Patterns compiled for the latest database revision seen
+    private var compiled: CompiledTelemetryPatterns?
+    
+    /// Guards `compiled`
+    private let compileLock = NSLock()
     
     // MARK: - Initialization
     
@@ -37,17 +43,16 @@ public class TelemetryPatternMatcher {
         headers: [String: String]? = nil,
         payload: Data? = nil
     ) -> TelemetryPattern? {
-        return queue.sync {
-            let patterns = database.getAllPatterns()
-            
-            for pattern in patterns {
-                if matches(pattern: pattern, domain: domain, path: path, headers: headers, payload: payload) {
-                    return pattern
-                }
+        let compiled = compiledPatterns()
+        var request = CompiledTelemetryPatterns.Request(domain: domain, path: path, headers: headers, payload: payload)
+        
+        for index in compiled.patterns.indices {
+            if compiled.matches(index, &request) {
+                return compiled.patterns[index]
             }
-            
-            return nil
         }
+        
+        return nil
     }
     
     /// Check if a domain matches telemetry domain patterns
@@ -56,17 +61,7 @@ public class TelemetryPatternMatcher {
     /// - Parameter domain: The domain to check
     /// - Returns: True if the domain matches any telemetry domain pattern
     public func matchesTelemetryDomain(_ domain: String) -> Bool {
-        return queue.sync {
-            let patterns = database.getAllPatterns()
-            
-            for pattern in patterns {
-                if pattern.matchesDomain(domain) {
-                    return true
-                }
-            }
-            
-            return false
-        }
+        return compiledPatterns().domains.contains { $0.matches(domain) }
     }
     
     /// Check if a path matches telemetry path patterns
@@ -75,18 +70,8 @@ public class TelemetryPatternMatcher {
     /// - Parameter path: The path to check
     /// - Returns: True if the path matches any telemetry path pattern
     public func matchesTelemetryPath(_ path: String) -> Bool {
-        return queue.sync {
-            let patterns = database.getAllPatterns()
-            
-            for pattern in patterns {
-                // Only check patterns that have path patterns defined
-                if pattern.pathPattern != nil && pattern.matchesPath(path) {
-                    return true
-                }
-            }
-            
-            return false
-        }
+        // Only patterns that have path patterns defined
+        return compiledPatterns().paths.contains { $0?.matches(path) ?? false }
     }
     
     /// Inspect HTTP headers for telemetry indicators
@@ -95,61 +80,31 @@ public class TelemetryPatternMatcher {
     /// - Parameter headers: The HTTP headers to inspect
     /// - Returns: True if headers contain telemetry indicators
     public func inspectHeadersForTelemetry(_ headers: [String: String]) -> Bool {
-        return queue.sync {
-            let patterns = database.getAllPatterns()
-            
-            for pattern in patterns {
-                // Only check patterns that have header patterns defined
-                if !pattern.headerPatterns.isEmpty && pattern.matchesHeaders(headers) {
-                    return true
-                }
-            }
-            
-            // Also check for common telemetry header prefixes
-            for (key, _) in headers {
-                let lowercaseKey = key.lowercased()
-                if lowercaseKey.hasPrefix("x-analytics-") ||
-                   lowercaseKey.hasPrefix("x-tracking-") ||
-                   lowercaseKey.hasPrefix("x-telemetry-") {
-                    return true
-                }
+        let compiled = compiledPatterns()
+        
+        // Only patterns that have header patterns defined
+        for index in compiled.patterns.indices where !compiled.headers[index].isEmpty {
+            if compiled.matchesHeaders(index, headers) {
+                return true
             }
-            
-            return false
         }
+        
+        // Also check for common telemetry header prefixes
+        for (key, _) in headers where CompiledTelemetryPatterns.headerPrefixes.contains(where: { $0.matches(key) }) {
+            return true
+        }
+        
+        return false
     }
     
     /// Inspect request payload for telemetry JSON structures
+    /// The payload is never decoded: JSON keys are recognised lexically
+    /// around candidate hits, in the same pass that finds the keywords.
     /// Requirement: 10.7
     /// - Parameter payload: The request payload data
     /// - Returns: True if payload contains telemetry JSON structures
     public func inspectPayloadForTelemetry(_ payload: Data) -> Bool {
-        return queue.sync {
-            let patterns = database.getAllPatterns()
-            
-            // Check patterns with payload patterns
-            for pattern in patterns {
-                if let payloadPattern = pattern.payloadPattern {
-                    if matchesPayloadPattern(payload, pattern: payloadPattern) {
-                        return true
-                    }
-                }
-            }
-            
-            // Try to parse as JSON and check for telemetry-related keys
-            if let json = try? JSONSerialization.jsonObject(with: payload, options: []) {
-                if containsTelemetryKeys(json) {
-                    return true
-                }
-            }
-            
-            // Check for telemetry-related strings in payload
-            if let payloadString = String(data: payload, encoding: .utf8) {
-                return containsTelemetryStrings(payloadString)
-            }
-            
-            return false
-        }
+        return compiledPatterns().scanPayload(payload, stopAtFirstHit: true).isTelemetry
     }
     
     /// Get all patterns that match a given request
@@ -165,54 +120,188 @@ public class TelemetryPatternMatcher {
         headers: [String: String]? = nil,
         payload: Data? = nil
     ) -> [TelemetryPattern] {
-        return queue.sync {
-            let patterns = database.getAllPatterns()
-            
-            return patterns.filter { pattern in
-                matches(pattern: pattern, domain: domain, path: path, headers: headers, payload: payload)
+        let compiled = compiledPatterns()
+        var request = CompiledTelemetryPatterns.Request(domain: domain, path: path, headers: headers, payload: payload)
+        
+        var matching: [TelemetryPattern] = []
+        for index in compiled.patterns.indices {
+            if compiled.matches(index, &request) {
+                matching.append(compiled.patterns[index])
             }
         }
+        return matching
     }
     
     // MARK: - Private Helpers
     
-    /// Check if a pattern matches all provided request components
-    /// - Parameters:
-    ///   - pattern: The telemetry pattern to check
-    ///   - domain: The domain of the request
-    ///   - path: The path of the request (optional)
-    ///   - headers: The HTTP headers of the request (optional)
-    ///   - payload: The request payload data (optional)
-    /// - Returns: True if all components match the pattern
-    private func matches(
-        pattern: TelemetryPattern,
-        domain: String,
-        path: String?,
-        headers: [String: String]?,
-        payload: Data?
-    ) -> Bool {
+    /// Compiled form of the database's current patterns
+    private func compiledPatterns() -> CompiledTelemetryPatterns {
+        let snapshot = database.patternSnapshot()
+        
+        compileLock.lock()
+        defer { compileLock.unlock() }
+        
+        if let compiled = compiled, compiled.revision == snapshot.revision {
+            return compiled
+        }
+        let fresh = CompiledTelemetryPatterns(patterns: snapshot.patterns, revision: snapshot.revision)
+        compiled = fresh
+        return fresh
+    }
+}
+
+// MARK: - Compiled Patterns
+
+/// Immutable, pre-compiled view of one revision of the pattern database
+private final class CompiledTelemetryPatterns {
+    
+    /// Substrings of a JSON key that mark telemetry
+    static let telemetryKeys = [
+        "analytics", "tracking", "telemetry", "metrics",
+        "event", "events", "track", "collect",
+        "user_id", "session_id", "device_id",
+        "ga", "gtm", "utm", "pixel"
+    ]
+    
+    /// Substrings anywhere in a payload that mark telemetry
+    static let telemetryKeywords = [
+        "analytics", "tracking", "telemetry", "metrics",
+        "event", "track", "collect", "beacon",
+        "user_id", "session_id", "device_id",
+        "ga(", "gtm", "utm_", "_ga", "_gid"
+    ]
+    
+    /// Header names that mark telemetry whatever the patterns say
+    static let headerPrefixes = ["x-analytics-*", "x-tracking-*", "x-telemetry-*"].map(WildcardPattern.init)
+    
+    /// Meaning of each scanner literal
+    private enum Term {
+        /// A telemetry keyword; any occurrence counts
+        case keyword
+        /// A key substring; counts only inside a JSON object key
+        case key
+        /// A pattern's whole payload substring, used when it is not a valid regex
+        case payloadLiteral(pattern: Int)
+        /// A literal every match of the pattern's regex contains
+        case payloadCandidate(pattern: Int, regex: Int)
+    }
+    
+    /// Request components, with payload results computed on first use
+    struct Request {
+        let domain: String
+        let path: String?
+        let headers: [String: String]?
+        let payload: Data?
+        var payloadHits: Set<Int>?
+    }
+    
+    /// Outcome of one pass over a payload
+    struct PayloadScan {
+        /// Indices of patterns whose payload pattern matched
+        var patternHits = Set<Int>()
+        var keywordHit = false
+        
+        var isTelemetry: Bool {
+            return keywordHit || !patternHits.isEmpty
+        }
+    }
+    
+    /// Bytes searched either side of a key hit for its enclosing quotes
+    private static let keyScanLimit = 256
+    
+    let revision: UInt64
+    let patterns: [TelemetryPattern]
+    let domains: [WildcardPattern]
+    let paths: [WildcardPattern?]
+    let headers: [[(name: String, value: WildcardPattern)]]
+    
+    private let scanner: MultiPatternScanner
+    private let terms: [Term]
+    /// Payload regexes, compiled once; confirmed only after a literal hit
+    private let regexes: [(pattern: Int, regex: NSRegularExpression)]
+    /// Regexes with no required literal, which must always run
+    private let unfilteredRegexes: [Int]
+    
+    init(patterns: [TelemetryPattern], revision: UInt64) {
+        self.revision = revision
+        self.patterns = patterns
+        self.domains = patterns.map { WildcardPattern($0.domainPattern) }
+        self.paths = patterns.map { $0.pathPattern.map(WildcardPattern.init) }
+        self.headers = patterns.map { pattern in
+            pattern.headerPatterns.map { (name: $0.key, value: WildcardPattern($0.value)) }
+        }
+        
+        var literals: [[UInt8]] = []
+        var terms: [Term] = []
+        var regexes: [(pattern: Int, regex: NSRegularExpression)] = []
+        var unfiltered: [Int] = []
+        
+        for keyword in Self.telemetryKeywords {
+            literals.append(Array(keyword.utf8))
+            terms.append(.keyword)
+        }
+        // Keys containing a keyword are already found by the keyword
+        for key in Self.telemetryKeys where !Self.telemetryKeywords.contains(where: { key.contains($0) }) {
+            literals.append(Array(key.utf8))
+            terms.append(.key)
+        }
+        
+        for (index, pattern) in patterns.enumerated() {
+            guard let payloadPattern = pattern.payloadPattern else { continue }
+            
+            // Same reading as before: a regex if it compiles, else a substring
+            guard let regex = try? NSRegularExpression(pattern: payloadPattern, options: [.caseInsensitive]) else {
+                literals.append(Array(payloadPattern.utf8))
+                terms.append(.payloadLiteral(pattern: index))
+                continue
+            }
+            regexes.append((pattern: index, regex: regex))
+            if let literal = Self.requiredLiteral(ofRegex: payloadPattern) {
+                literals.append(literal)
+                terms.append(.payloadCandidate(pattern: index, regex: regexes.count - 1))
+            } else {
+                unfiltered.append(regexes.count - 1)
+            }
+        }
+        
+        self.scanner = MultiPatternScanner(patterns: literals)
+        self.terms = terms
+        self.regexes = regexes
+        self.unfilteredRegexes = unfiltered
+    }
+    
+    // MARK: - Request Matching
+    
+    /// Whether pattern `index` matches every provided request component
+    func matches(_ index: Int, _ request: inout Request) -> Bool {
         // Domain must always match
-        guard pattern.matchesDomain(domain) else {
+        guard domains[index].matches(request.domain) else {
             return false
         }
         
         // If pattern has path requirement, check it
-        if pattern.pathPattern != nil {
-            guard let path = path, pattern.matchesPath(path) else {
+        if let path = paths[index] {
+            guard let requestPath = request.path, path.matches(requestPath) else {
                 return false
             }
         }
         
         // If pattern has header requirements, check them
-        if !pattern.headerPatterns.isEmpty {
-            guard let headers = headers, pattern.matchesHeaders(headers) else {
+        if !headers[index].isEmpty {
+            guard let requestHeaders = request.headers, matchesHeaders(index, requestHeaders) else {
                 return false
             }
         }
         
-        // If pattern has payload requirement, check it
-        if let payloadPattern = pattern.payloadPattern {
-            guard let payload = payload, matchesPayloadPattern(payload, pattern: payloadPattern) else {
+        // If pattern has payload requirement, check it against one shared scan
+        if patterns[index].payloadPattern != nil {
+            guard let payload = request.payload else {
+                return false
+            }
+            if request.payloadHits == nil {
+                request.payloadHits = scanPayload(payload, stopAtFirstHit: false).patternHits
+            }
+            guard request.payloadHits?.contains(index) == true else {
                 return false
             }
         }
@@ -220,83 +309,240 @@ public class TelemetryPatternMatcher {
         return true
     }
     
-    /// Check if payload matches a pattern
-    /// - Parameters:
-    ///   - payload: The payload data
-    ///   - pattern: The pattern to match (regex or substring)
-    /// - Returns: True if payload matches pattern
-    private func matchesPayloadPattern(_ payload: Data, pattern: String) -> Bool {
-        guard let payloadString = String(data: payload, encoding: .utf8) else {
-            return false
+    func matchesHeaders(_ index: Int, _ requestHeaders: [String: String]) -> Bool {
+        for header in headers[index] {
+            guard let value = requestHeaders[header.name], header.value.matches(value) else {
+                return false
+            }
         }
+        return true
+    }
+    
+    // MARK: - Payload Scanning
+    
+    /// Find keyword and payload-pattern hits in one pass over the raw bytes
+    /// Each regex is confirmed at most once, on its first literal hit.
+    func scanPayload(_ payload: Data, stopAtFirstHit: Bool) -> PayloadScan {
+        return payload.withUnsafeBytes { bytes -> PayloadScan in
+            var result = PayloadScan()
+            var confirmed = Set<Int>()
+            var text: String?
+            
+            func regexMatches(_ regex: Int) -> Bool {
+                guard confirmed.insert(regex).inserted else { return false }
+                if text == nil {
+                    text = String(decoding: bytes, as: UTF8.self)
+                }
+                return Self.firstMatch(regexes[regex].regex, in: text ?? "")
+            }
+            
+            scanner.scan(bytes) { term, range in
+                switch terms[term] {
+                case .keyword:
+                    result.keywordHit = true
+                case .key:
+                    if Self.isInsideObjectKey(bytes, range) {
+                        result.keywordHit = true
+                    }
+                case .payloadLiteral(let pattern):
+                    result.patternHits.insert(pattern)
+                case .payloadCandidate(let pattern, let regex):
+                    if regexMatches(regex) {
+                        result.patternHits.insert(pattern)
+                    }
+                }
+                return !(stopAtFirstHit && result.isTelemetry)
+            }
+            
+            for regex in unfilteredRegexes where !(stopAtFirstHit && result.isTelemetry) {
+                if regexMatches(regex) {
+                    result.patternHits.insert(regexes[regex].pattern)
+                }
+            }
+            return result
+        }
+    }
+    
+    private static func firstMatch(_ regex: NSRegularExpression, in text: String) -> Bool {
+        let range = NSRange(text.startIndex..., in: text)
+        return regex.firstMatch(in: text, options: [], range: range) != nil
+    }
+    
+    /// Whether `range` lies inside a JSON string that is an object key
+    /// The string must open after `{` or `,` and be followed by `:`.
+    private static func isInsideObjectKey(_ bytes: UnsafeRawBufferPointer, _ range: Range<Int>) -> Bool {
+        let quote = UInt8(ascii: "\"")
         
-        // Try regex match first
-        if let regex = try? NSRegularExpression(pattern: pattern, options: [.caseInsensitive]) {
-            let range = NSRange(payloadString.startIndex..., in: payloadString)
-            return regex.firstMatch(in: payloadString, options: [], range: range) != nil
+        var open = range.lowerBound - 1
+        let lowest = max(range.lowerBound - keyScanLimit, 0)
+        while open >= lowest && (bytes[open] != quote || isEscaped(bytes, open)) {
+            open -= 1
+        }
+        guard open >= lowest,
+              let before = skipWhitespace(bytes, from: open - 1, step: -1),
+              bytes[before] == UInt8(ascii: "{") || bytes[before] == UInt8(ascii: ",") else {
+            return false
         }
         
-        // Fall back to substring match
-        return payloadString.localizedCaseInsensitiveContains(pattern)
+        var close = range.upperBound
+        let highest = min(range.upperBound + keyScanLimit, bytes.count)
+        while close < highest && (bytes[close] != quote || isEscaped(bytes, close)) {
+            close += 1
+        }
+        guard close < highest, let after = skipWhitespace(bytes, from: close + 1, step: 1) else {
+            return false
+        }
+        return bytes[after] == UInt8(ascii: ":")
     }
     
-    /// Check if JSON object contains telemetry-related keys
-    /// - Parameter json: The JSON object to check
-    /// - Returns: True if JSON contains telemetry keys
-    private func containsTelemetryKeys(_ json: Any) -> Bool {
-        let telemetryKeys = [
-            "analytics", "tracking", "telemetry", "metrics",
-            "event", "events", "track", "collect",
-            "user_id", "session_id", "device_id",
-            "ga", "gtm", "utm", "pixel"
-        ]
+    /// Whether the byte at `index` follows an odd run of backslashes
+    private static func isEscaped(_ bytes: UnsafeRawBufferPointer, _ index: Int) -> Bool {
+        var backslashes = 0
+        var cursor = index - 1
+        while cursor >= 0 && bytes[cursor] == UInt8(ascii: "\\") {
+            backslashes += 1
+            cursor -= 1
+        }
+        return backslashes % 2 == 1
+    }
+    
+    private static func skipWhitespace(_ bytes: UnsafeRawBufferPointer, from start: Int, step: Int) -> Int? {
+        var index = start
+        while index >= 0 && index < bytes.count {
+            switch bytes[index] {
+            case 0x20, 0x09, 0x0A, 0x0D:
+                index += step
+            default:
+                return index
+            }
+        }
+        return nil
+    }
+    
+    // MARK: - Literal Extraction
+    
+    /// Longest literal run every match of the regex must contain
+    /// Conservative: groups, classes and escapes break a run, a quantifier
+    /// that allows zero repeats drops the character before it, and any
+    /// top-level alternation means no literal is required.
+    /// - Returns: Lowercase literal bytes, nil if none can be proven
+    static func requiredLiteral(ofRegex pattern: String) -> [UInt8]? {
+        let characters = Array(pattern.unicodeScalars)
+        var best: [UInt8] = []
+        var run: [UInt8] = []
+        var index = 0
         
-        if let dict = json as? [String: Any] {
-            for key in dict.keys {
-                let lowercaseKey = key.lowercased()
-                for telemetryKey in telemetryKeys {
-                    if lowercaseKey.contains(telemetryKey) {
-                        return true
-                    }
+        func endRun() {
+            if run.count > best.count {
+                best = run
+            }
+            run = []
+        }
+        
+        while index < characters.count {
+            let character = characters[index]
+            switch character {
+            case "|":
+                return nil
+            case "\\":
+                guard index + 1 < characters.count else { return nil }
+                let escaped = characters[index + 1]
+                if escaped.isASCII && !escaped.properties.isAlphabetic && !("0"..."9").contains(escaped) {
+                    run.append(UInt8(escaped.value))
+                    index += 2
+                } else {
+                    // Classes, anchors, hex and back-references are not literals
+                    endRun()
+                    index = skipEscape(characters, from: index)
+                }
+                continue
+            case "(", "[":
+                endRun()
+                index = skipGroup(characters, from: index)
+                continue
+            case "*", "?", "{":
+                // The previous atom may be absent
+                if !run.isEmpty {
+                    run.removeLast()
                 }
-                
-                // Recursively check nested objects
-                if let value = dict[key] {
-                    if containsTelemetryKeys(value) {
-                        return true
+                endRun()
+                if character == "{" {
+                    while index < characters.count && characters[index] != "}" {
+                        index += 1
                     }
                 }
-            }
-        } else if let array = json as? [Any] {
-            for item in array {
-                if containsTelemetryKeys(item) {
-                    return true
+            case "+", ".", "^", "$":
+                endRun()
+            default:
+                if character.isASCII {
+                    run.append(UInt8(character.value))
+                } else {
+                    endRun()
                 }
             }
+            index += 1
         }
+        endRun()
         
-        return false
+        return best.isEmpty ? nil : best.map { $0 &- 0x41 < 26 ? $0 | 0x20 : $0 }
     }
     
-    /// Check if string contains telemetry-related keywords
-    /// - Parameter string: The string to check
-    /// - Returns: True if string contains telemetry keywords
-    private func containsTelemetryStrings(_ string: String) -> Bool {
-        let lowercaseString = string.lowercased()
-        let telemetryKeywords = [
-            "analytics", "tracking", "telemetry", "metrics",
-            "event", "track", "collect", "beacon",
-            "user_id", "session_id", "device_id",
-            "ga(", "gtm", "utm_", "_ga", "_gid"
-        ]
-        
-        for keyword in telemetryKeywords {
-            if lowercaseString.contains(keyword) {
-                return true
+    /// Index after an escape sequence starting at `start`
+    private static func skipEscape(_ characters: [Unicode.Scalar], from start: Int) -> Int {
+        var index = start + 2
+        let kind = characters[start + 1]
+        if kind == "x" || kind == "u" || kind == "p" || kind == "P" {
+            if index < characters.count && characters[index] == "{" {
+                while index < characters.count && characters[index] != "}" {
+                    index += 1
+                }
+                return index + 1
+            }
+            if kind == "x" || kind == "u" {
+                index += kind == "x" ? 2 : 4
             }
         }
-        
-        return false
+        return min(index, characters.count)
+    }
+    
+    /// Index after a group or character class starting at `start`
+    private static func skipGroup(_ characters: [Unicode.Scalar], from start: Int) -> Int {
+        var depth = 0
+        var inClass = false
+        var index = start
+        while index < characters.count {
+            let character = characters[index]
+            if character == "\\" {
+                index += 2
+                continue
+            }
+            if inClass {
+                if character == "]" {
+                    inClass = false
+                    if depth == 0 {
+                        return index + 1
+                    }
+                }
+            } else if character == "[" {
+                inClass = true
+                // A leading `]` or `^]` is a literal member
+                if index + 1 < characters.count && characters[index + 1] == "^" {
+                    index += 1
+                }
+                if index + 1 < characters.count && characters[index + 1] == "]" {
+                    index += 1
+                }
+            } else if character == "(" {
+                depth += 1
+            } else if character == ")" {
+                depth -= 1
+                if depth == 0 {
+                    return index + 1
+                }
+            }
+            index += 1
+        }
+        return index
     }
 }
 
@@ -0,0 +1,896 @@
+import Foundation
+
+// MARK: - Errors
+
+/// Time series chunk decoding errors
+internal enum TimeSeriesChunkError: Error, LocalizedError {
+    case invalidChunk(String)
+    case unsupportedVersion(UInt32)
+    case truncated(String)
+
+    var errorDescription: String? {
+        switch self {
+        case .invalidChunk(let details):
+            return "Invalid time series chunk: \(details)"
+        case .unsupportedVersion(let version):
+            return "Unsupported time series chunk version: \(version)"
+        case .truncated(let column):
+            return "Truncated time series chunk column: \(column)"
+        }
+    }
+}
+
+// MARK: - Chunk Format
+
+/// Columnar layout of a chunk of analytics events
+/// A chunk holds the events of one hour partition (or part of one, once a
+/// chunk reaches its event limit) as separate columns, so aggregations read
+/// only the columns they need and never materialize `AnalyticsEvent`s:
+/// - timestamps: milliseconds, delta-of-delta encoded into a bit stream
+/// - kinds: one byte per event, type code in the low nibble, protocol above
+/// - applications, domains: varint IDs into the chunk dictionary, 0 for none
+/// - data sizes, durations: Gorilla XOR-compressed Float64 streams
+/// - payloads: length-prefixed rows with the fields only queries return
+/// - rollups: per-bucket aggregates for each rollup interval
+///
+/// Header, little-endian: magic "PVTS", version, event count, reserved,
+/// earliest and latest timestamp in milliseconds, reserved, then offset and
+/// length of each section.
+internal enum TimeSeriesChunkFormat {
+    static let magic: UInt32 = 0x5354_5650  // "PVTS"
+    static let version: UInt32 = 1
+    static let fileExtension = "pvts"
+
+    /// Chunks are cut at hour boundaries; buckets with the same start in
+    /// different chunks are merged at query time
+    static let partitionSeconds: Int64 = 3600
+
+    enum Section: Int, CaseIterable {
+        case dictionary, kinds, timestamps, applications, domains, dataSizes, durations, payloads, rollups
+    }
+
+    static let headerSize = 40 + Section.allCases.count * 8
+
+    /// Rollup intervals a chunk maintains for the configured aggregation intervals
+    /// Intervals that divide the partition are kept; longer intervals that are
+    /// whole multiples of it are served by merging the partition rollup.
+    static func rollupIntervals(for aggregationIntervals: [TimeInterval]) -> [Int64] {
+        var intervals: Set<Int64> = [partitionSeconds]
+        for interval in aggregationIntervals where interval >= 1 && interval.rounded() == interval {
+            let seconds = Int64(interval)
+            if partitionSeconds % seconds == 0 {
+                intervals.insert(seconds)
+            }
+        }
+        return intervals.sorted()
+    }
+
+    static func partition(ofMilliseconds timestamp: Int64) -> Int64 {
+        return floorDivide(timestamp, partitionSeconds * 1000) * partitionSeconds
+    }
+
+    static func floorDivide(_ value: Int64, _ divisor: Int64) -> Int64 {
+        let quotient = value / divisor
+        return value % divisor < 0 ? quotient - 1 : quotient
+    }
+}
+
+// MARK: - Bit Streams
+
+/// MSB-first bit stream writer for the timestamp and value columns
+internal struct TimeSeriesBitWriter {
+    private(set) var bytes: [UInt8] = []
+    private var usedBits = 0
+
+    mutating func write(_ value: UInt64, bits: Int) {
+        var remaining = bits
+        while remaining > 0 {
+            if usedBits == 0 {
+                bytes.append(0)
+            }
+            let free = 8 - usedBits
+            let take = min(free, remaining)
+            let chunk = UInt8(truncatingIfNeeded: (value >> UInt64(remaining - take)) & ((1 << UInt64(take)) - 1))
+            bytes[bytes.count - 1] |= chunk << UInt8(free - take)
+            usedBits = (usedBits + take) & 7
+            remaining -= take
+        }
+    }
+}
+
+/// Reader for a `TimeSeriesBitWriter` stream
+internal struct TimeSeriesBitReader {
+    private let bytes: UnsafeRawBufferPointer
+    private let column: String
+    private var position = 0
+
+    init(_ bytes: UnsafeRawBufferPointer, column: String) {
+        self.bytes = bytes
+        self.column = column
+    }
+
+    mutating func read(bits: Int) throws -> UInt64 {
+        guard bytes.count * 8 - position >= bits else {
+            throw TimeSeriesChunkError.truncated(column)
+        }
+        var value: UInt64 = 0
+        var remaining = bits
+        while remaining > 0 {
+            let offset = position & 7
+            let available = 8 - offset
+            let take = min(available, remaining)
+            let chunk = (UInt64(bytes[position >> 3]) >> UInt64(available - take)) & ((1 << UInt64(take)) - 1)
+            value = value << UInt64(take) | chunk
+            position += take
+            remaining -= take
+        }
+        return value
+    }
+}
+
+// MARK: - Column Codecs
+
+/// Delta-of-delta timestamp encoding
+/// Regularly spaced events cost one bit each; jitter of up to two seconds
+/// costs at most sixteen.
+internal struct TimestampColumnEncoder {
+    private(set) var writer = TimeSeriesBitWriter()
+    private var previous: Int64 = 0
+    private var previousDelta: Int64 = 0
+    private var count = 0
+
+    mutating func append(_ timestamp: Int64) {
+        defer {
+            previous = timestamp
+            count += 1
+        }
+        guard count > 0 else {
+            writer.write(UInt64(bitPattern: timestamp), bits: 64)
+            return
+        }
+
+        let delta = timestamp &- previous
+        let deltaOfDelta = delta &- previousDelta
+        previousDelta = delta
+        switch deltaOfDelta {
+        case 0:
+            writer.write(0, bits: 1)
+        case -63...64:
+            writer.write(0b10, bits: 2)
+            writer.write(UInt64(deltaOfDelta + 63), bits: 7)
+        case -255...256:
+            writer.write(0b110, bits: 3)
+            writer.write(UInt64(deltaOfDelta + 255), bits: 9)
+        case -2047...2048:
+            writer.write(0b1110, bits: 4)
+            writer.write(UInt64(deltaOfDelta + 2047), bits: 12)
+        default:
+            writer.write(0b1111, bits: 4)
+            writer.write(UInt64(bitPattern: deltaOfDelta), bits: 64)
+        }
+    }
+}
+
+internal struct TimestampColumnDecoder {
+    private var reader: TimeSeriesBitReader
+    private var previous: Int64 = 0
+    private var previousDelta: Int64 = 0
+    private var count = 0
+
+    init(_ bytes: UnsafeRawBufferPointer) {
+        self.reader = TimeSeriesBitReader(bytes, column: "timestamps")
+    }
+
+    mutating func next() throws -> Int64 {
+        defer { count += 1 }
+        guard count > 0 else {
+            previous = Int64(bitPattern: try reader.read(bits: 64))
+            return previous
+        }
+
+        let deltaOfDelta: Int64
+        if try reader.read(bits: 1) == 0 {
+            deltaOfDelta = 0
+        } else if try reader.read(bits: 1) == 0 {
+            deltaOfDelta = Int64(try reader.read(bits: 7)) - 63
+        } else if try reader.read(bits: 1) == 0 {
+            deltaOfDelta = Int64(try reader.read(bits: 9)) - 255
+        } else if try reader.read(bits: 1) == 0 {
+            deltaOfDelta = Int64(try reader.read(bits: 12)) - 2047
+        } else {
+            deltaOfDelta = Int64(bitPattern: try reader.read(bits: 64))
+        }
+        previousDelta = previousDelta &+ deltaOfDelta
+        previous = previous &+ previousDelta
+        return previous
+    }
+}
+
+/// Gorilla XOR encoding of Float64 values
+/// A repeated value costs one bit; a value whose changed bits fit the
+/// previous window costs two bits plus the window.
+internal struct ValueColumnEncoder {
+    private(set) var writer = TimeSeriesBitWriter()
+    private var previous: UInt64 = 0
+    private var leading = -1
+    private var trailing = 0
+    private var count = 0
+
+    mutating func append(_ value: Double) {
+        let bits = value.bitPattern
+        defer {
+            previous = bits
+            count += 1
+        }
+        guard count > 0 else {
+            writer.write(bits, bits: 64)
+            return
+        }
+
+        let xor = bits ^ previous
+        if xor == 0 {
+            writer.write(0, bits: 1)
+            return
+        }
+        let lead = min(xor.leadingZeroBitCount, 31)
+        let trail = xor.trailingZeroBitCount
+        if leading >= 0 && lead >= leading && trail >= trailing {
+            writer.write(0b10, bits: 2)
+            writer.write(xor >> UInt64(trailing), bits: 64 - leading - trailing)
+        } else {
+            leading = lead
+            trailing = trail
+            let length = 64 - lead - trail
+            writer.write(0b11, bits: 2)
+            writer.write(UInt64(lead), bits: 5)
+            // A 64-bit window is stored as 0
+            writer.write(UInt64(length & 63), bits: 6)
+            writer.write(xor >> UInt64(trail), bits: length)
+        }
+    }
+}
+
+internal struct ValueColumnDecoder {
+    private var reader: TimeSeriesBitReader
+    private var previous: UInt64 = 0
+    private var leading = 0
+    private var trailing = 0
+    private var count = 0
+
+    init(_ bytes: UnsafeRawBufferPointer, column: String) {
+        self.reader = TimeSeriesBitReader(bytes, column: column)
+    }
+
+    mutating func next() throws -> Double {
+        defer { count += 1 }
+        guard count > 0 else {
+            previous = try reader.read(bits: 64)
+            return Double(bitPattern: previous)
+        }
+
+        if try reader.read(bits: 1) == 1 {
+            if try reader.read(bits: 1) == 1 {
+                leading = Int(try reader.read(bits: 5))
+                let length = Int(try reader.read(bits: 6))
+                trailing = 64 - leading - (length == 0 ? 64 : length)
+            }
+            let meaningful = 64 - leading - trailing
+            previous ^= try reader.read(bits: meaningful) << UInt64(trailing)
+        }
+        return Double(bitPattern: previous)
+    }
+}
+
+/// Byte-aligned reads for the dictionary, ID, payload and rollup sections
+internal struct TimeSeriesByteReader {
+    private let bytes: UnsafeRawBufferPointer
+    private let column: String
+    private(set) var offset = 0
+
+    init(_ bytes: UnsafeRawBufferPointer, column: String) {
+        self.bytes = bytes
+        self.column = column
+    }
+
+    var isAtEnd: Bool {
+        return offset >= bytes.count
+    }
+
+    mutating func readByte() throws -> UInt8 {
+        guard offset < bytes.count else {
+            throw TimeSeriesChunkError.truncated(column)
+        }
+        offset += 1
+        return bytes[offset - 1]
+    }
+
+    mutating func readVarint() throws -> UInt64 {
+        var value: UInt64 = 0
+        var shift: UInt64 = 0
+        while true {
+            let byte = try readByte()
+            value |= UInt64(byte & 0x7F) << shift
+            if byte & 0x80 == 0 {
+                return value
+            }
+            shift += 7
+            guard shift < 64 else {
+                throw TimeSeriesChunkError.invalidChunk("Overlong varint in \(column)")
+            }
+        }
+    }
+
+    mutating func readFixed<T: FixedWidthInteger>(_ type: T.Type) throws -> T {
+        let size = MemoryLayout<T>.size
+        guard bytes.count - offset >= size else {
+            throw TimeSeriesChunkError.truncated(column)
+        }
+        let value = T(littleEndian: bytes.loadUnaligned(fromByteOffset: offset, as: T.self))
+        offset += size
+        return value
+    }
+
+    mutating func readString() throws -> String {
+        let length = Int(try readVarint())
+        guard bytes.count - offset >= length else {
+            throw TimeSeriesChunkError.truncated(column)
+        }
+        let string = String(decoding: UnsafeRawBufferPointer(rebasing: bytes[offset..<offset + length]), as: UTF8.self)
+        offset += length
+        return string
+    }
+
+    /// Optional strings are stored with their length plus one, 0 for nil
+    mutating func readOptionalString() throws -> String? {
+        let length = Int(try readVarint())
+        guard length > 0 else { return nil }
+        guard bytes.count - offset >= length - 1 else {
+            throw TimeSeriesChunkError.truncated(column)
+        }
+        let string = String(decoding: UnsafeRawBufferPointer(rebasing: bytes[offset..<offset + length - 1]), as: UTF8.self)
+        offset += length - 1
+        return string
+    }
+
+    mutating func skip(_ count: Int) throws {
+        guard bytes.count - offset >= count else {
+            throw TimeSeriesChunkError.truncated(column)
+        }
+        offset += count
+    }
+}
+
+internal enum TimeSeriesBytes {
+    static func appendVarint(_ value: UInt64, to bytes: inout [UInt8]) {
+        var value = value
+        while value >= 0x80 {
+            bytes.append(UInt8(truncatingIfNeeded: value) | 0x80)
+            value >>= 7
+        }
+        bytes.append(UInt8(value))
+    }
+
+    static func appendFixed<T: FixedWidthInteger>(_ value: T, to bytes: inout [UInt8]) {
+        withUnsafeBytes(of: value.littleEndian) { bytes.append(contentsOf: $0) }
+    }
+
+    static func appendString(_ string: String, to bytes: inout [UInt8]) {
+        let utf8 = Array(string.utf8)
+        appendVarint(UInt64(utf8.count), to: &bytes)
+        bytes.append(contentsOf: utf8)
+    }
+
+    static func appendOptionalString(_ string: String?, to bytes: inout [UInt8]) {
+        guard let string = string else {
+            bytes.append(0)
+            return
+        }
+        let utf8 = Array(string.utf8)
+        appendVarint(UInt64(utf8.count) + 1, to: &bytes)
+        bytes.append(contentsOf: utf8)
+    }
+}
+
+// MARK: - Rollups
+
+/// Aggregates of one rollup bucket, with application names resolved
+internal struct TimeSeriesRollupBucket {
+    /// Bucket start in seconds since 1970
+    let start: Int64
+    let eventCount: Int
+    let totalDataSize: UInt64
+    let dnsQueryCount: Int
+    let connectionCount: Int
+    let applications: [String]
+}
+
+/// Running aggregates of a bucket, keyed by chunk dictionary ID
+private struct TimeSeriesRollupAccumulator {
+    var eventCount = 0
+    var totalDataSize: UInt64 = 0
+    var dnsQueryCount = 0
+    var connectionCount = 0
+    var applications: Set<UInt32> = []
+}
+
+// MARK: - Event Codes
+
+/// One-byte codes of the event enums; cases may only be appended
+internal enum TimeSeriesEventCodes {
+    static let types: [AnalyticsEvent.EventType] = [.connection, .dnsQuery, .dataTransfer, .connectionClosed]
+    static let protocols: [NetworkProtocol] = [.tcp, .udp, .icmp, .other]
+
+    static func kind(for event: AnalyticsEvent) -> UInt8 {
+        let type = UInt8(types.firstIndex(of: event.type) ?? 0)
+        let networkProtocol = UInt8(protocols.firstIndex(of: event.protocol) ?? protocols.count - 1)
+        return type | networkProtocol << 4
+    }
+
+    static func type(ofKind kind: UInt8) -> AnalyticsEvent.EventType? {
+        let index = Int(kind & 0x0F)
+        return index < types.count ? types[index] : nil
+    }
+
+    static func networkProtocol(ofKind kind: UInt8) -> NetworkProtocol? {
+        let index = Int(kind >> 4)
+        return index < protocols.count ? protocols[index] : nil
+    }
+}
+
+// MARK: - Chunk Builder
+
+/// Open chunk that events are appended to
+/// Columns are encoded as events arrive, and every rollup bucket is updated
+/// in place, so sealing a chunk only concatenates its sections.
+internal final class TimeSeriesChunkBuilder {
+
+    let rollupIntervals: [Int64]
+    /// Partition the chunk was opened for, in seconds since 1970
+    let partition: Int64
+
+    private(set) var count = 0
+    private(set) var minTimestamp = Int64.max
+    private(set) var maxTimestamp = Int64.min
+
+    private var dictionary: [String] = []
+    private var dictionaryIDs: [String: UInt32] = [:]
+    private var kinds: [UInt8] = []
+    private var timestamps = TimestampColumnEncoder()
+    private var applications: [UInt8] = []
+    private var domains: [UInt8] = []
+    private var dataSizes = ValueColumnEncoder()
+    private var durations = ValueColumnEncoder()
+    private var payloads: [UInt8] = []
+    private var rollups: [Int64: [Int64: TimeSeriesRollupAccumulator]] = [:]
+
+    init(partition: Int64, rollupIntervals: [Int64]) {
+        self.partition = partition
+        self.rollupIntervals = rollupIntervals
+    }
+
+    /// Bytes the encoded chunk will take, excluding rollups
+    var encodedSize: Int {
+        return TimeSeriesChunkFormat.headerSize + kinds.count + timestamps.writer.bytes.count
+            + applications.count + domains.count + dataSizes.writer.bytes.count
+            + durations.writer.bytes.count + payloads.count + dictionary.reduce(0) { $0 + $1.utf8.count + 1 }
+    }
+
+    func append(_ event: AnalyticsEvent) {
+        let timestamp = Int64((event.timestamp.timeIntervalSince1970 * 1000).rounded(.down))
+        let kind = TimeSeriesEventCodes.kind(for: event)
+        let application = dictionaryID(for: event.application)
+
+        count += 1
+        minTimestamp = min(minTimestamp, timestamp)
+        maxTimestamp = max(maxTimestamp, timestamp)
+        kinds.append(kind)
+        timestamps.append(timestamp)
+        TimeSeriesBytes.appendVarint(UInt64(application), to: &applications)
+        TimeSeriesBytes.appendVarint(UInt64(dictionaryID(for: event.destination.hostname)), to: &domains)
+        dataSizes.append(Double(event.dataSize))
+        durations.append(event.duration ?? .nan)
+        appendPayload(event)
+
+        for interval in rollupIntervals {
+            let start = TimeSeriesChunkFormat.floorDivide(timestamp, interval * 1000) * interval
+            var bucket = rollups[interval, default: [:]][start, default: TimeSeriesRollupAccumulator()]
+            bucket.eventCount += 1
+            bucket.totalDataSize &+= event.dataSize
+            if event.type == .dnsQuery {
+                bucket.dnsQueryCount += 1
+            }
+            if event.type == .connection {
+                bucket.connectionCount += 1
+            }
+            if application != 0 {
+                bucket.applications.insert(application)
+            }
+            rollups[interval, default: [:]][start] = bucket
+        }
+    }
+
+    /// Rollup buckets of one interval in time order, nil if not maintained
+    func rollupBuckets(interval: Int64) -> [TimeSeriesRollupBucket]? {
+        guard rollupIntervals.contains(interval) else { return nil }
+        return (rollups[interval] ?? [:]).sorted { $0.key < $1.key }.map { start, bucket in
+            TimeSeriesRollupBucket(
+                start: start,
+                eventCount: bucket.eventCount,
+                totalDataSize: bucket.totalDataSize,
+                dnsQueryCount: bucket.dnsQueryCount,
+                connectionCount: bucket.connectionCount,
+                applications: bucket.applications.map { dictionary[Int($0) - 1] }
+            )
+        }
+    }
+
+    /// Serialize the chunk in `TimeSeriesChunkFormat`
+    func encoded() -> Data {
+        var sections = [[UInt8]](repeating: [], count: TimeSeriesChunkFormat.Section.allCases.count)
+
+        var dictionaryBytes: [UInt8] = []
+        TimeSeriesBytes.appendVarint(UInt64(dictionary.count), to: &dictionaryBytes)
+        for string in dictionary {
+            TimeSeriesBytes.appendString(string, to: &dictionaryBytes)
+        }
+        sections[TimeSeriesChunkFormat.Section.dictionary.rawValue] = dictionaryBytes
+        sections[TimeSeriesChunkFormat.Section.kinds.rawValue] = kinds
+        sections[TimeSeriesChunkFormat.Section.timestamps.rawValue] = timestamps.writer.bytes
+        sections[TimeSeriesChunkFormat.Section.applications.rawValue] = applications
+        sections[TimeSeriesChunkFormat.Section.domains.rawValue] = domains
+        sections[TimeSeriesChunkFormat.Section.dataSizes.rawValue] = dataSizes.writer.bytes
+        sections[TimeSeriesChunkFormat.Section.durations.rawValue] = durations.writer.bytes
+        sections[TimeSeriesChunkFormat.Section.payloads.rawValue] = payloads
+        sections[TimeSeriesChunkFormat.Section.rollups.rawValue] = encodedRollups()
+
+        var header: [UInt8] = []
+        TimeSeriesBytes.appendFixed(TimeSeriesChunkFormat.magic, to: &header)
+        TimeSeriesBytes.appendFixed(TimeSeriesChunkFormat.version, to: &header)
+        TimeSeriesBytes.appendFixed(UInt32(count), to: &header)
+        TimeSeriesBytes.appendFixed(UInt32(0), to: &header)
+        TimeSeriesBytes.appendFixed(count > 0 ? minTimestamp : 0, to: &header)
+        TimeSeriesBytes.appendFixed(count > 0 ? maxTimestamp : 0, to: &header)
+        TimeSeriesBytes.appendFixed(UInt64(0), to: &header)
+        var offset = TimeSeriesChunkFormat.headerSize
+        for section in sections {
+            TimeSeriesBytes.appendFixed(UInt32(offset), to: &header)
+            TimeSeriesBytes.appendFixed(UInt32(section.count), to: &header)
+            offset += section.count
+        }
+
+        var data = Data(capacity: offset)
+        data.append(contentsOf: header)
+        for section in sections {
+            data.append(contentsOf: section)
+        }
+        return data
+    }
+
+    private func dictionaryID(for string: String?) -> UInt32 {
+        guard let string = string else { return 0 }
+        if let id = dictionaryIDs[string] {
+            return id
+        }
+        dictionary.append(string)
+        let id = UInt32(dictionary.count)
+        dictionaryIDs[string] = id
+        return id
+    }
+
+    /// Fields only returned by queries: ID, session, endpoints, metadata
+    private func appendPayload(_ event: AnalyticsEvent) {
+        var row: [UInt8] = []
+        withUnsafeBytes(of: event.id.uuid) { row.append(contentsOf: $0) }
+        if let sessionId = event.sessionId {
+            row.append(1)
+            withUnsafeBytes(of: sessionId.uuid) { row.append(contentsOf: $0) }
+        } else {
+            row.append(0)
+        }
+        TimeSeriesBytes.appendString(event.source.address, to: &row)
+        TimeSeriesBytes.appendVarint(event.source.port.map { UInt64($0) + 1 } ?? 0, to: &row)
+        TimeSeriesBytes.appendOptionalString(event.source.hostname, to: &row)
+        TimeSeriesBytes.appendString(event.destination.address, to: &row)
+        TimeSeriesBytes.appendVarint(event.destination.port.map { UInt64($0) + 1 } ?? 0, to: &row)
+        TimeSeriesBytes.appendVarint(UInt64(event.metadata.count), to: &row)
+        for (key, value) in event.metadata {
+            TimeSeriesBytes.appendString(key, to: &row)
+            TimeSeriesBytes.appendString(value, to: &row)
+        }
+
+        TimeSeriesBytes.appendVarint(UInt64(row.count), to: &payloads)
+        payloads.append(contentsOf: row)
+    }
+
+    private func encodedRollups() -> [UInt8] {
+        var bytes: [UInt8] = []
+        TimeSeriesBytes.appendVarint(UInt64(rollupIntervals.count), to: &bytes)
+        for interval in rollupIntervals {
+            let buckets = (rollups[interval] ?? [:]).sorted { $0.key < $1.key }
+            TimeSeriesBytes.appendVarint(UInt64(interval), to: &bytes)
+            TimeSeriesBytes.appendVarint(UInt64(buckets.count), to: &bytes)
+            for (start, bucket) in buckets {
+                TimeSeriesBytes.appendFixed(start, to: &bytes)
+                TimeSeriesBytes.appendVarint(UInt64(bucket.eventCount), to: &bytes)
+                TimeSeriesBytes.appendVarint(bucket.totalDataSize, to: &bytes)
+                TimeSeriesBytes.appendVarint(UInt64(bucket.dnsQueryCount), to: &bytes)
+                TimeSeriesBytes.appendVarint(UInt64(bucket.connectionCount), to: &bytes)
+                TimeSeriesBytes.appendVarint(UInt64(bucket.applications.count), to: &bytes)
+                for application in bucket.applications.sorted() {
+                    TimeSeriesBytes.appendVarint(UInt64(application), to: &bytes)
+                }
+            }
+        }
+        return bytes
+    }
+}
+
+// MARK: - Sealed Chunk
+
+/// Read-only view of an encoded chunk, usually memory-mapped from disk
+/// Only the header and dictionary are decoded up front; columns are decoded
+/// as a query walks them.
+internal struct TimeSeriesChunk {
+
+    /// Column values of one event, enough for filtering and aggregation
+    struct Row {
+        /// Milliseconds since 1970
+        let timestamp: Int64
+        let kind: UInt8
+        /// Chunk dictionary ID, 0 for none
+        let application: UInt32
+        let dataSize: UInt64
+
+        var type: AnalyticsEvent.EventType? {
+            return TimeSeriesEventCodes.type(ofKind: kind)
+        }
+    }
+
+    let data: Data
+    let eventCount: Int
+    /// Earliest and latest event, in milliseconds since 1970
+    let minTimestamp: Int64
+    let maxTimestamp: Int64
+    private let sections: [Range<Int>]
+    private let dictionary: [String]
+
+    init(data: Data) throws {
+        guard data.count >= TimeSeriesChunkFormat.headerSize else {
+            throw TimeSeriesChunkError.invalidChunk("Shorter than its header")
+        }
+
+        let parsed = try data.withUnsafeBytes { bytes -> (Int, Int64, Int64, [Range<Int>]) in
+            var header = TimeSeriesByteReader(bytes, column: "header")
+            guard try header.readFixed(UInt32.self) == TimeSeriesChunkFormat.magic else {
+                throw TimeSeriesChunkError.invalidChunk("Bad magic")
+            }
+            let version = try header.readFixed(UInt32.self)
+            guard version == TimeSeriesChunkFormat.version else {
+                throw TimeSeriesChunkError.unsupportedVersion(version)
+            }
+            let count = Int(try header.readFixed(UInt32.self))
+            try header.skip(4)
+            let minTimestamp = try header.readFixed(Int64.self)
+            let maxTimestamp = try header.readFixed(Int64.self)
+            try header.skip(8)
+
+            var sections: [Range<Int>] = []
+            for section in TimeSeriesChunkFormat.Section.allCases {
+                let offset = Int(try header.readFixed(UInt32.self))
+                let length = Int(try header.readFixed(UInt32.self))
+                guard offset >= TimeSeriesChunkFormat.headerSize, length <= bytes.count - offset else {
+                    throw TimeSeriesChunkError.invalidChunk("Section \(section) out of bounds")
+                }
+                sections.append(offset..<offset + length)
+            }
+            return (count, minTimestamp, maxTimestamp, sections)
+        }
+
+        self.data = data
+        self.eventCount = parsed.0
+        self.minTimestamp = parsed.1
+        self.maxTimestamp = parsed.2
+        self.sections = parsed.3
+
+        let dictionaryRange = parsed.3[TimeSeriesChunkFormat.Section.dictionary.rawValue]
+        self.dictionary = try data.withUnsafeBytes { bytes in
+            var reader = TimeSeriesByteReader(UnsafeRawBufferPointer(rebasing: bytes[dictionaryRange]), column: "dictionary")
+            let count = try reader.readVarint()
+            var strings: [String] = []
+            strings.reserveCapacity(Int(min(count, 1 << 16)))
+            for _ in 0..<count {
+                strings.append(try reader.readString())
+            }
+            return strings
+        }
+    }
+
+    /// Whether any event falls within the inclusive millisecond range
+    func overlaps(from start: Int64, through end: Int64) -> Bool {
+        return eventCount > 0 && minTimestamp <= end && maxTimestamp >= start
+    }
+
+    /// Name behind a dictionary ID
+    func string(for id: UInt32) -> String? {
+        return id == 0 || Int(id) > dictionary.count ? nil : dictionary[Int(id) - 1]
+    }
+
+    /// Dictionary IDs of the given names that occur in this chunk
+    func dictionaryIDs(for strings: [String]) -> Set<UInt32> {
+        var ids: Set<UInt32> = []
+        for (index, string) in dictionary.enumerated() where strings.contains(string) {
+            ids.insert(UInt32(index + 1))
+        }
+        return ids
+    }
+
+    /// Walk the aggregation columns without touching payloads
+    func forEachRow(_ body: (Row) throws -> Void) throws {
+        try data.withUnsafeBytes { bytes in
+            var columns = ColumnCursor(bytes, sections: sections)
+            for _ in 0..<eventCount {
+                try body(try columns.next())
+            }
+        }
+    }
+
+    /// Decode the events whose row passes `include`, in append order
+    func forEachEvent(where include: (Row) -> Bool, _ body: (AnalyticsEvent) -> Void) throws {
+        try data.withUnsafeBytes { bytes in
+            var columns = ColumnCursor(bytes, sections: sections)
+            var domains = TimeSeriesByteReader(UnsafeRawBufferPointer(rebasing: bytes[section(.domains)]), column: "domains")
+            var durations = ValueColumnDecoder(UnsafeRawBufferPointer(rebasing: bytes[section(.durations)]), column: "durations")
+            var payloads = TimeSeriesByteReader(UnsafeRawBufferPointer(rebasing: bytes[section(.payloads)]), column: "payloads")
+
+            for _ in 0..<eventCount {
+                let row = try columns.next()
+                let domain = UInt32(truncatingIfNeeded: try domains.readVarint())
+                let duration = try durations.next()
+                let length = Int(try payloads.readVarint())
+                guard include(row) else {
+                    try payloads.skip(length)
+                    continue
+                }
+
+                let start = payloads.offset
+                let event = try decodeEvent(row: row, domain: domain, duration: duration, payloads: &payloads)
+                guard payloads.offset == start + length else {
+                    throw TimeSeriesChunkError.invalidChunk("Payload row length mismatch")
+                }
+                body(event)
+            }
+        }
+    }
+
+    /// Rollup buckets of one interval in time order, nil if the chunk has none
+    func rollupBuckets(interval: Int64) throws -> [TimeSeriesRollupBucket]? {
+        return try data.withUnsafeBytes { bytes -> [TimeSeriesRollupBucket]? in
+            var reader = TimeSeriesByteReader(UnsafeRawBufferPointer(rebasing: bytes[section(.rollups)]), column: "rollups")
+            let intervalCount = try reader.readVarint()
+            for _ in 0..<intervalCount {
+                let bucketInterval = Int64(try reader.readVarint())
+                let bucketCount = try reader.readVarint()
+                var buckets: [TimeSeriesRollupBucket] = []
+                for _ in 0..<bucketCount {
+                    let start = try reader.readFixed(Int64.self)
+                    let eventCount = Int(try reader.readVarint())
+                    let totalDataSize = try reader.readVarint()
+                    let dnsQueryCount = Int(try reader.readVarint())
+                    let connectionCount = Int(try reader.readVarint())
+                    let applicationCount = try reader.readVarint()
+                    var applications: [String] = []
+                    for _ in 0..<applicationCount {
+                        let id = UInt32(truncatingIfNeeded: try reader.readVarint())
+                        if bucketInterval == interval, let name = string(for: id) {
+                            applications.append(name)
+                        }
+                    }
+                    if bucketInterval == interval {
+                        buckets.append(TimeSeriesRollupBucket(
+                            start: start,
+                            eventCount: eventCount,
+                            totalDataSize: totalDataSize,
+                            dnsQueryCount: dnsQueryCount,
+                            connectionCount: connectionCount,
+                            applications: applications
+                        ))
+                    }
+                }
+                if bucketInterval == interval {
+                    return buckets
+                }
+            }
+            return nil
+        }
+    }
+
+    private func section(_ section: TimeSeriesChunkFormat.Section) -> Range<Int> {
+        return sections[section.rawValue]
+    }
+
+    private func decodeEvent(row: Row, domain: UInt32, duration: Double, payloads: inout TimeSeriesByteReader) throws -> AnalyticsEvent {
+        func readUUID() throws -> UUID {
+            var uuid: uuid_t = (0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0)
+            try withUnsafeMutableBytes(of: &uuid) { target in
+                for index in 0..<16 {
+                    target[index] = try payloads.readByte()
+                }
+            }
+            return UUID(uuid: uuid)
+        }
+
+        func readPort() throws -> UInt16? {
+            let port = try payloads.readVarint()
+            return port == 0 ? nil : UInt16(truncatingIfNeeded: port - 1)
+        }
+
+        guard let type = row.type, let networkProtocol = TimeSeriesEventCodes.networkProtocol(ofKind: row.kind) else {
+            throw TimeSeriesChunkError.invalidChunk("Unknown event kind \(row.kind)")
+        }
+
+        let id = try readUUID()
+        let sessionId = try payloads.readByte() != 0 ? readUUID() : nil
+        let sourceAddress = try payloads.readString()
+        let sourcePort = try readPort()
+        let sourceHostname = try payloads.readOptionalString()
+        let destinationAddress = try payloads.readString()
+        let destinationPort = try readPort()
+        let metadataCount = try payloads.readVarint()
+        var metadata: [String: String] = [:]
+        for _ in 0..<metadataCount {
+            let key = try payloads.readString()
+            metadata[key] = try payloads.readString()
+        }
+
+        return AnalyticsEvent(
+            id: id,
+            timestamp: Date(timeIntervalSince1970: TimeInterval(row.timestamp) / 1000),
+            sessionId: sessionId,
+            type: type,
+            source: NetworkEndpoint(address: sourceAddress, port: sourcePort, hostname: sourceHostname),
+            destination: NetworkEndpoint(address: destinationAddress, port: destinationPort, hostname: string(for: domain)),
+            protocol: networkProtocol,
+            dataSize: row.dataSize,
+            duration: duration.isNaN ? nil : duration,
+            application: string(for: row.application),
+            metadata: metadata
+        )
+    }
+
+    /// Walks the kind, timestamp, application and data size columns in step
+    private struct ColumnCursor {
+        private let kinds: UnsafeRawBufferPointer
+        private var index = 0
+        private var timestamps: TimestampColumnDecoder
+        private var applications: TimeSeriesByteReader
+        private var dataSizes: ValueColumnDecoder
+
+        init(_ bytes: UnsafeRawBufferPointer, sections: [Range<Int>]) {
+            func column(_ section: TimeSeriesChunkFormat.Section) -> UnsafeRawBufferPointer {
+                return UnsafeRawBufferPointer(rebasing: bytes[sections[section.rawValue]])
+            }
+            self.kinds = column(.kinds)
+            self.timestamps = TimestampColumnDecoder(column(.timestamps))
+            self.applications = TimeSeriesByteReader(column(.applications), column: "applications")
+            self.dataSizes = ValueColumnDecoder(column(.dataSizes), column: "data sizes")
+        }
+
+        mutating func next() throws -> Row {
+            guard index < kinds.count else {
+                throw TimeSeriesChunkError.truncated("kinds")
+            }
+            let kind = kinds[index]
+            index += 1
+            let timestamp = try timestamps.next()
+            let application = UInt32(truncatingIfNeeded: try applications.readVarint())
+            // Sizes past 2^53 round; saturate rather than trap at the top
+            let dataSize = try dataSizes.next()
+            return Row(
+                timestamp: timestamp,
+                kind: kind,
+                application: application,
+                dataSize: dataSize >= 0 && dataSize < 0x1p64 ? UInt64(dataSize) : (dataSize > 0 ? .max : 0)
+            )
+        }
+    }
+}
@@ -2,7 +2,11 @@ import Foundation
 import Logging
 
 /// Time series storage for analytics data
-/// Implements efficient storage and retrieval of time-stamped analytics events
+/// Events are kept in columnar chunks (see `TimeSeriesChunkFormat`), one or
+/// more per hour partition. The open chunk is encoded as events arrive and
+/// keeps rollups for the configured aggregation intervals up to date, so
+/// aggregated queries read pre-computed buckets instead of decoding events.
+/// File system backends write sealed chunks to disk and memory-map them.
 public class TimeSeriesStorage {
     
     // MARK: - Properties
@@ -18,11 +22,20 @@ public class TimeSeriesStorage {
         return configManager.getCurrentConfiguration().modules.networkAnalytics
     }
     
-    /// In-memory storage for events
-    private var memoryStorage: [TimeSeriesEntry] = []
+    /// Sealed chunks in the order they were sealed
+    private var sealedChunks: [SealedChunk] = []
     
-    /// File system storage manager
-    private var fileSystemStorage: FileSystemStorageManager?
+    /// Chunk events are currently appended to
+    private var openChunk: TimeSeriesChunkBuilder?
+    
+    /// File the open chunk is checkpointed to, for file system backends
+    private var openChunkURL: URL?
+    
+    /// Last time the open chunk was checkpointed
+    private var lastCheckpoint = Date.distantPast
+    
+    /// Directory holding chunk files, nil when chunks stay in memory
+    private var chunkDirectory: URL?
     
     /// Storage access queue
     private let storageQueue = DispatchQueue(label: "privarion.storage.access", attributes: .concurrent)
@@ -30,8 +43,11 @@ public class TimeSeriesStorage {
     /// Storage initialization state
     private var isInitialized: Bool = false
     
-    /// Storage file URL for file system backend
-    private var storageFileURL: URL?
+    /// Events per chunk before it is sealed early
+    private static let maxEventsPerChunk = 4096
+    
+    /// Interval between checkpoints of the open chunk
+    private static let checkpointInterval: TimeInterval = 30
     
     // MARK: - Initialization
     
@@ -53,10 +69,7 @@ public class TimeSeriesStorage {
         case .inMemory:
             try initializeInMemoryStorage()
             
-        case .fileSystem:
-            try initializeFileSystemStorage()
-            
-        case .hybrid:
+        case .fileSystem, .hybrid:
             try initializeInMemoryStorage()
             try initializeFileSystemStorage()
         }
@@ -98,6 +111,8 @@ public class TimeSeriesStorage {
     }
     
     /// Get aggregated metrics for time range
+    /// Buckets are half-open and start at `timeRange.start`. When the range
+    /// and interval line up with a rollup interval, only rollups are read.
     public func getAggregatedMetrics(
         timeRange: DateInterval,
         aggregationInterval: TimeInterval
@@ -142,14 +157,27 @@ public class TimeSeriesStorage {
         }
     }
     
+    /// Write the open chunk to disk, for file system backends
+    public func flush() {
+        guard isInitialized else { return }
+        
+        storageQueue.sync(flags: .barrier) {
+            checkpointOpenChunk()
+        }
+    }
+    
     /// Get storage statistics
     public func getStorageStats() -> StorageStatistics {
         return storageQueue.sync {
+            var ranges = sealedChunks.filter { $0.chunk.eventCount > 0 }.map { ($0.chunk.minTimestamp, $0.chunk.maxTimestamp) }
+            if let builder = openChunk, builder.count > 0 {
+                ranges.append((builder.minTimestamp, builder.maxTimestamp))
+            }
             return StorageStatistics(
-                totalEvents: memoryStorage.count,
+                totalEvents: sealedChunks.reduce(0) { $0 + $1.chunk.eventCount } + (openChunk?.count ?? 0),
                 memoryUsageBytes: estimateMemoryUsage(),
-                oldestEventTimestamp: memoryStorage.first?.event.timestamp,
-                newestEventTimestamp: memoryStorage.last?.event.timestamp,
+                oldestEventTimestamp: ranges.map { $0.0 }.min().map { date(fromMilliseconds: $0) },
+                newestEventTimestamp: ranges.map { $0.1 }.max().map { date(fromMilliseconds: $0) },
                 storageBackend: config.storageBackend
             )
         }
@@ -164,8 +192,9 @@ public class TimeSeriesStorage {
     }
     
     private func initializeInMemoryStorage() throws {
-        memoryStorage.removeAll()
-        memoryStorage.reserveCapacity(config.maxEventsInMemory)
+        sealedChunks.removeAll()
+        openChunk = nil
+        openChunkURL = nil
         
         logger.debug("In-memory storage initialized", metadata: [
             "capacity": "\(config.maxEventsInMemory)"
@@ -185,174 +214,356 @@ public class TimeSeriesStorage {
             attributes: [.posixPermissions: 0o700]
         )
         
-        // Initialize file system storage manager
-        let fileURL = storageDirectory.appendingPathComponent("analytics_data.json")
-        self.storageFileURL = fileURL
-        self.fileSystemStorage = FileSystemStorageManager(fileURL: fileURL)
+        self.chunkDirectory = storageDirectory
         
-        // Load existing data if available
-        try loadExistingData()
+        // Map existing chunks, then fold in data from the JSON format
+        try loadExistingChunks()
+        migrateLegacyData(from: storageDirectory.appendingPathComponent("analytics_data.json"))
         
         logger.debug("File system storage initialized", metadata: [
-            "storage_path": "\(storageFileURL?.path ?? "unknown")"
+            "storage_path": "\(storageDirectory.path)",
+            "chunks": "\(sealedChunks.count)"
         ])
     }
     
-    private func loadExistingData() throws {
-        guard let fileURL = storageFileURL,
-              FileManager.default.fileExists(atPath: fileURL.path) else {
-            return
-        }
+    private func loadExistingChunks() throws {
+        guard let directory = chunkDirectory else { return }
         
-        let data = try Data(contentsOf: fileURL)
-        let entries = try JSONDecoder().decode([TimeSeriesEntry].self, from: data)
+        let urls = try FileManager.default.contentsOfDirectory(at: directory, includingPropertiesForKeys: nil)
+            .filter { $0.pathExtension == TimeSeriesChunkFormat.fileExtension }
+        let retention = milliseconds(from: retentionDate)
         
-        // Filter out old data based on retention policy
-        let retentionDate = Date().addingTimeInterval(-TimeInterval(config.dataRetentionDays * 24 * 3600))
-        memoryStorage = entries.filter { $0.event.timestamp >= retentionDate }
+        var chunks: [SealedChunk] = []
+        for url in urls {
+            do {
+                let chunk = try TimeSeriesChunk(data: Data(contentsOf: url, options: .alwaysMapped))
+                if chunk.maxTimestamp < retention {
+                    try? FileManager.default.removeItem(at: url)
+                } else {
+                    chunks.append(SealedChunk(chunk: chunk, url: url))
+                }
+            } catch {
+                logger.warning("Skipping unreadable analytics chunk", metadata: [
+                    "file": "\(url.lastPathComponent)",
+                    "error": "\(error)"
+                ])
+            }
+        }
+        sealedChunks = chunks.sorted { $0.chunk.minTimestamp < $1.chunk.minTimestamp }
         
-        logger.info("Loaded existing analytics data", metadata: [
-            "total_entries": "\(entries.count)",
-            "retained_entries": "\(memoryStorage.count)"
+        logger.info("Loaded existing analytics chunks", metadata: [
+            "chunks": "\(sealedChunks.count)",
+            "events": "\(sealedChunks.reduce(0) { $0 + $1.chunk.eventCount })"
         ])
     }
     
-    private func storeEventInternal(_ event: AnalyticsEvent) {
-        let entry = TimeSeriesEntry(
-            id: UUID(),
-            event: event,
-            storedAt: Date()
-        )
+    /// Re-encode data written by the JSON backend into chunks, once
+    private func migrateLegacyData(from fileURL: URL) {
+        guard FileManager.default.fileExists(atPath: fileURL.path) else { return }
         
-        // Add to memory storage
-        memoryStorage.append(entry)
-        
-        // Maintain memory limits
-        if memoryStorage.count > config.maxEventsInMemory {
-            memoryStorage.removeFirst(memoryStorage.count - config.maxEventsInMemory)
+        do {
+            let entries = try JSONDecoder().decode([TimeSeriesEntry].self, from: Data(contentsOf: fileURL))
+            let retained = entries.filter { $0.event.timestamp >= retentionDate }
+                .sorted { $0.event.timestamp < $1.event.timestamp }
+            for entry in retained {
+                appendToOpenChunk(entry.event)
+            }
+            sealOpenChunk()
+            try FileManager.default.removeItem(at: fileURL)
+            
+            logger.info("Migrated legacy analytics data", metadata: [
+                "total_entries": "\(entries.count)",
+                "retained_entries": "\(retained.count)"
+            ])
+        } catch {
+            logger.error("Failed to migrate legacy analytics data", metadata: [
+                "error": "\(error)"
+            ])
         }
+    }
+    
+    private func storeEventInternal(_ event: AnalyticsEvent) {
+        appendToOpenChunk(event)
         
-        // Persist to file system if enabled
-        if config.storageBackend == .fileSystem || config.storageBackend == .hybrid {
-            persistToFileSystem()
+        // Chunks held in memory are bounded by the event limit
+        if chunkDirectory == nil {
+            enforceMemoryLimit()
+        } else if Date().timeIntervalSince(lastCheckpoint) >= Self.checkpointInterval {
+            checkpointOpenChunk()
         }
         
         logger.debug("Analytics event stored", metadata: [
             "event_id": "\(event.id)",
             "event_type": "\(event.type)",
-            "storage_size": "\(memoryStorage.count)"
+            "open_chunk_size": "\(openChunk?.count ?? 0)"
         ])
     }
     
+    private func appendToOpenChunk(_ event: AnalyticsEvent) {
+        let partition = TimeSeriesChunkFormat.partition(ofMilliseconds: milliseconds(from: event.timestamp))
+        
+        // Late events stay in the open chunk; rollups bucket them by their own time
+        if let builder = openChunk, partition > builder.partition || builder.count >= chunkCapacity {
+            sealOpenChunk()
+        }
+        
+        if openChunk == nil {
+            openChunk = TimeSeriesChunkBuilder(
+                partition: partition,
+                rollupIntervals: TimeSeriesChunkFormat.rollupIntervals(for: config.aggregationIntervals)
+            )
+            openChunkURL = chunkDirectory?.appendingPathComponent(
+                "chunk_\(partition)_\(UUID().uuidString.prefix(8)).\(TimeSeriesChunkFormat.fileExtension)"
+            )
+        }
+        openChunk?.append(event)
+    }
+    
+    /// Chunk size limit, kept well under the event limit for in-memory storage
+    private var chunkCapacity: Int {
+        guard chunkDirectory == nil else { return Self.maxEventsPerChunk }
+        return min(Self.maxEventsPerChunk, max(64, config.maxEventsInMemory / 4))
+    }
+    
+    private func sealOpenChunk() {
+        guard let builder = openChunk else { return }
+        let url = openChunkURL
+        openChunk = nil
+        openChunkURL = nil
+        guard builder.count > 0 else { return }
+        
+        do {
+            let data = builder.encoded()
+            if let url = url {
+                try data.write(to: url, options: .atomic)
+                let mapped = try TimeSeriesChunk(data: Data(contentsOf: url, options: .alwaysMapped))
+                sealedChunks.append(SealedChunk(chunk: mapped, url: url))
+            } else {
+                sealedChunks.append(SealedChunk(chunk: try TimeSeriesChunk(data: data), url: nil))
+            }
+        } catch {
+            logger.error("Failed to seal analytics chunk", metadata: [
+                "events": "\(builder.count)",
+                "error": "\(error)"
+            ])
+        }
+    }
+    
+    /// Rewrite the open chunk's file so a crash loses at most one interval
+    private func checkpointOpenChunk() {
+        lastCheckpoint = Date()
+        guard let builder = openChunk, builder.count > 0, let url = openChunkURL else { return }
+        
+        do {
+            try builder.encoded().write(to: url, options: .atomic)
+        } catch {
+            logger.error("Failed to persist analytics data", metadata: [
+                "error": "\(error)"
+            ])
+        }
+    }
+    
+    /// Drop the oldest in-memory chunks while the rest still hold the event limit
+    private func enforceMemoryLimit() {
+        let limit = config.maxEventsInMemory
+        var total = sealedChunks.reduce(0) { $0 + $1.chunk.eventCount } + (openChunk?.count ?? 0)
+        var dropped = 0
+        while dropped < sealedChunks.count, total - sealedChunks[dropped].chunk.eventCount >= limit {
+            total -= sealedChunks[dropped].chunk.eventCount
+            dropped += 1
+        }
+        if dropped > 0 {
+            sealedChunks.removeFirst(dropped)
+        }
+    }
+    
+    /// Sealed chunks plus a snapshot of the open chunk
+    private func readableChunks() -> [TimeSeriesChunk] {
+        var chunks = sealedChunks.map { $0.chunk }
+        if let builder = openChunk, builder.count > 0 {
+            do {
+                chunks.append(try snapshot(of: builder))
+            } catch {
+                logger.error("Failed to read open analytics chunk", metadata: [
+                    "error": "\(error)"
+                ])
+            }
+        }
+        return chunks
+    }
+    
+    private func snapshot(of builder: TimeSeriesChunkBuilder) throws -> TimeSeriesChunk {
+        return try TimeSeriesChunk(data: builder.encoded())
+    }
+    
     private func queryEventsInternal(
         timeRange: DateInterval,
         eventTypes: [AnalyticsEvent.EventType]? = nil,
         applications: [String]? = nil
     ) -> [AnalyticsEvent] {
-        var results = memoryStorage.filter { entry in
-            timeRange.contains(entry.event.timestamp)
-        }
+        let start = milliseconds(from: timeRange.start)
+        let end = milliseconds(from: timeRange.end)
+        var results: [AnalyticsEvent] = []
         
-        if let eventTypes = eventTypes {
-            results = results.filter { entry in
-                eventTypes.contains(entry.event.type)
+        for chunk in readableChunks() where chunk.overlaps(from: start, through: end) {
+            let applicationIDs = applications.map { chunk.dictionaryIDs(for: $0) }
+            if let applicationIDs = applicationIDs, applicationIDs.isEmpty {
+                continue
             }
-        }
-        
-        if let applications = applications {
-            results = results.filter { entry in
-                guard let eventApp = entry.event.application else { return false }
-                return applications.contains(eventApp)
+            
+            do {
+                try chunk.forEachEvent(where: { row in
+                    guard row.timestamp >= start && row.timestamp <= end else { return false }
+                    if let eventTypes = eventTypes {
+                        guard let type = row.type, eventTypes.contains(type) else { return false }
+                    }
+                    if let applicationIDs = applicationIDs {
+                        return applicationIDs.contains(row.application)
+                    }
+                    return true
+                }) { event in
+                    results.append(event)
+                }
+            } catch {
+                logger.error("Failed to decode analytics chunk", metadata: [
+                    "error": "\(error)"
+                ])
             }
         }
         
-        return results.map { $0.event }
+        return results
     }
     
     private func getAllEventsInternal() -> [AnalyticsEvent] {
-        return memoryStorage.map { $0.event }
+        return queryEventsInternal(timeRange: DateInterval(start: .distantPast, end: .distantFuture))
     }
     
     private func aggregateMetricsInternal(
         timeRange: DateInterval,
         aggregationInterval: TimeInterval
     ) -> [AggregatedTimeSeriesMetrics] {
-        let events = queryEventsInternal(timeRange: timeRange)
-        var aggregatedMetrics: [AggregatedTimeSeriesMetrics] = []
-        
-        // Create time buckets
-        var currentTime = timeRange.start
-        while currentTime < timeRange.end {
-            let bucketEnd = min(currentTime.addingTimeInterval(aggregationInterval), timeRange.end)
-            let bucketInterval = DateInterval(start: currentTime, end: bucketEnd)
-            
-            let bucketEvents = events.filter { bucketInterval.contains($0.timestamp) }
-            _ = calculateMetricsForEvents(bucketEvents) // Calculate but don't use directly
-            
-            aggregatedMetrics.append(AggregatedTimeSeriesMetrics(
-                timestamp: currentTime,
-                interval: aggregationInterval,
-                eventCount: bucketEvents.count,
-                totalDataSize: bucketEvents.reduce(0) { $0 + $1.dataSize },
-                uniqueApplications: Set(bucketEvents.compactMap { $0.application }).count,
-                dnsQueryCount: bucketEvents.filter { $0.type == .dnsQuery }.count,
-                connectionCount: bucketEvents.filter { $0.type == .connection }.count
-            ))
-            
-            currentTime = bucketEnd
+        let start = milliseconds(from: timeRange.start)
+        let end = milliseconds(from: timeRange.end)
+        let interval = Int64((aggregationInterval * 1000).rounded())
+        guard interval > 0, end > start else { return [] }
+        
+        var buckets = [AggregationBucket](repeating: AggregationBucket(), count: Int((end - start + interval - 1) / interval))
+        let rollupInterval = self.rollupInterval(start: start, end: end, interval: interval)
+        
+        func bucketIndex(_ timestamp: Int64) -> Int? {
+            guard timestamp >= start && timestamp < end else { return nil }
+            return Int((timestamp - start) / interval)
         }
         
-        return aggregatedMetrics
-    }
-    
-    private func calculateMetricsForEvents(_ events: [AnalyticsEvent]) -> AnalyticsMetrics {
-        return AnalyticsMetrics(
-            eventCount: events.count,
-            totalDataSize: events.reduce(0) { $0 + $1.dataSize },
-            averageDataSize: events.isEmpty ? 0 : Double(events.reduce(0) { $0 + $1.dataSize }) / Double(events.count),
-            uniqueApplications: Set(events.compactMap { $0.application }).count,
-            eventTypeDistribution: Dictionary(grouping: events, by: { $0.type })
-                .mapValues { $0.count }
-        )
-    }
-    
-    private func persistToFileSystem() {
-        guard let fileURL = storageFileURL else { return }
+        func addRollups(_ rollups: [TimeSeriesRollupBucket]) {
+            for rollup in rollups {
+                guard let index = bucketIndex(rollup.start * 1000) else { continue }
+                buckets[index].eventCount += rollup.eventCount
+                buckets[index].totalDataSize &+= rollup.totalDataSize
+                buckets[index].dnsQueryCount += rollup.dnsQueryCount
+                buckets[index].connectionCount += rollup.connectionCount
+                buckets[index].applications.formUnion(rollup.applications)
+            }
+        }
+        
+        func addRows(of chunk: TimeSeriesChunk) throws {
+            try chunk.forEachRow { row in
+                guard let index = bucketIndex(row.timestamp) else { return }
+                buckets[index].eventCount += 1
+                buckets[index].totalDataSize &+= row.dataSize
+                if row.type == .dnsQuery {
+                    buckets[index].dnsQueryCount += 1
+                }
+                if row.type == .connection {
+                    buckets[index].connectionCount += 1
+                }
+                if let application = chunk.string(for: row.application) {
+                    buckets[index].applications.insert(application)
+                }
+            }
+        }
         
         do {
-            let data = try JSONEncoder().encode(memoryStorage)
-            try data.write(to: fileURL)
+            for sealed in sealedChunks where sealed.chunk.overlaps(from: start, through: end - 1) {
+                if let rollupInterval = rollupInterval, let rollups = try sealed.chunk.rollupBuckets(interval: rollupInterval) {
+                    addRollups(rollups)
+                } else {
+                    try addRows(of: sealed.chunk)
+                }
+            }
+            if let builder = openChunk, builder.count > 0,
+               builder.minTimestamp < end && builder.maxTimestamp >= start {
+                if let rollupInterval = rollupInterval, let rollups = builder.rollupBuckets(interval: rollupInterval) {
+                    addRollups(rollups)
+                } else {
+                    try addRows(of: snapshot(of: builder))
+                }
+            }
         } catch {
-            logger.error("Failed to persist analytics data", metadata: [
+            logger.error("Failed to aggregate analytics chunks", metadata: [
                 "error": "\(error)"
             ])
         }
+        
+        return buckets.enumerated().map { index, bucket in
+            AggregatedTimeSeriesMetrics(
+                timestamp: date(fromMilliseconds: start + Int64(index) * interval),
+                interval: aggregationInterval,
+                eventCount: bucket.eventCount,
+                totalDataSize: bucket.totalDataSize,
+                uniqueApplications: bucket.applications.count,
+                dnsQueryCount: bucket.dnsQueryCount,
+                connectionCount: bucket.connectionCount
+            )
+        }
+    }
+    
+    /// Coarsest rollup interval whose buckets tile every requested bucket
+    private func rollupInterval(start: Int64, end: Int64, interval: Int64) -> Int64? {
+        let candidates = TimeSeriesChunkFormat.rollupIntervals(for: config.aggregationIntervals)
+        return candidates.reversed().first { rollup in
+            let rollupMilliseconds = rollup * 1000
+            return interval % rollupMilliseconds == 0
+                && start % rollupMilliseconds == 0
+                && end % rollupMilliseconds == 0
+        }
     }
     
     private func performDataCleanup() {
-        let retentionDate = Date().addingTimeInterval(-TimeInterval(config.dataRetentionDays * 24 * 3600))
-        let initialCount = memoryStorage.count
-        
-        memoryStorage = memoryStorage.filter { $0.event.timestamp >= retentionDate }
-        
-        let removedCount = initialCount - memoryStorage.count
+        let retention = milliseconds(from: retentionDate)
+        let expired = sealedChunks.filter { $0.chunk.maxTimestamp < retention }
+        guard !expired.isEmpty else { return }
         
-        if removedCount > 0 {
-            logger.info("Data cleanup completed", metadata: [
-                "removed_events": "\(removedCount)",
-                "remaining_events": "\(memoryStorage.count)"
-            ])
-            
-            // Persist updated data
-            if config.storageBackend == .fileSystem || config.storageBackend == .hybrid {
-                persistToFileSystem()
+        sealedChunks.removeAll { $0.chunk.maxTimestamp < retention }
+        for chunk in expired {
+            if let url = chunk.url {
+                try? FileManager.default.removeItem(at: url)
             }
         }
+        
+        logger.info("Data cleanup completed", metadata: [
+            "removed_events": "\(expired.reduce(0) { $0 + $1.chunk.eventCount })",
+            "remaining_events": "\(sealedChunks.reduce(0) { $0 + $1.chunk.eventCount } + (openChunk?.count ?? 0))"
+        ])
+    }
+    
+    private var retentionDate: Date {
+        return Date().addingTimeInterval(-TimeInterval(config.dataRetentionDays * 24 * 3600))
+    }
+    
+    private func milliseconds(from date: Date) -> Int64 {
+        let value = (date.timeIntervalSince1970 * 1000).rounded(.down)
+        return Int64(max(min(value, Double(Int64.max / 2)), Double(Int64.min / 2)))
+    }
+    
+    private func date(fromMilliseconds milliseconds: Int64) -> Date {
+        return Date(timeIntervalSince1970: TimeInterval(milliseconds) / 1000)
     }
     
     private func estimateMemoryUsage() -> Int {
-        // Rough estimate: each event ~1KB in memory
-        return memoryStorage.count * 1024
+        // Mapped chunks are backed by their files and not counted
+        let resident = sealedChunks.filter { $0.url == nil }.reduce(0) { $0 + $1.chunk.data.count }
+        return resident + (openChunk?.encodedSize ?? 0)
     }
     
     private func exportAsJSON(events: [AnalyticsEvent]) throws -> Data {
@@ -394,7 +605,22 @@ public class TimeSeriesStorage {
 
 // MARK: - Supporting Types
 
-/// Time series entry for internal storage
+/// Sealed chunk and the file it is mapped from, if any
+private struct SealedChunk {
+    let chunk: TimeSeriesChunk
+    let url: URL?
+}
+
+/// Running totals for one requested aggregation bucket
+private struct AggregationBucket {
+    var eventCount = 0
+    var totalDataSize: UInt64 = 0
+    var dnsQueryCount = 0
+    var connectionCount = 0
+    var applications: Set<String> = []
+}
+
+/// Entry of the JSON storage format, read only to migrate it to chunks
 private struct TimeSeriesEntry: Codable {
     let id: UUID
     let event: AnalyticsEvent
@@ -429,22 +655,3 @@ public struct StorageStatistics {
     public let newestEventTimestamp: Date?
     public let storageBackend: AnalyticsStorageBackend
 }
-
-/// File system storage manager
-private class FileSystemStorageManager {
-    private let fileURL: URL
-    
-    init(fileURL: URL) {
-        self.fileURL = fileURL
-    }
-    
-    func save(_ entries: [TimeSeriesEntry]) throws {
-        let data = try JSONEncoder().encode(entries)
-        try data.write(to: fileURL)
-    }
-    
-    func load() throws -> [TimeSeriesEntry] {
-        let data = try Data(contentsOf: fileURL)
-        return try JSONDecoder().decode([TimeSeriesEntry].self, from: data)
-    }
-}
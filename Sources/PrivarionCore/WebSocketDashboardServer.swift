@@ -62,6 +62,7 @@ internal final class WebSocketDashboardServer: @unchecked Sendable {
         let id: String
         let channel: Channel
         let subscriptions: Set<EventSubscription>
+        let format: DashboardFrameFormat
         let connectedAt: Date
         let connectionMetrics: ConnectionMetrics
         
@@ -120,6 +121,8 @@ internal final class WebSocketDashboardServer: @unchecked Sendable {
         let maxConnections: Int
         let eventBufferSize: Int
         let heartbeatInterval: TimeInterval
+        /// Seconds between coalesced broadcasts
+        let broadcastInterval: TimeInterval
         
         static let `default` = DashboardConfig(
             host: "127.0.0.1",
@@ -127,7 +130,8 @@ internal final class WebSocketDashboardServer: @unchecked Sendable {
             maxFrameSize: 1 << 16, // 64KB frames for dashboard data
             maxConnections: 100,
             eventBufferSize: 1000,
-            heartbeatInterval: 30.0
+            heartbeatInterval: 30.0,
+            broadcastInterval: 0.1
         )
     }
     
@@ -156,6 +160,9 @@ internal final class WebSocketDashboardServer: @unchecked Sendable {
     /// WebSocket frame encoder/decoder for dashboard protocol
     private let dashboardProtocol: DashboardProtocol
     
+    /// Per-tick coalescing of broadcasts to all clients
+    private let broadcaster: DashboardBroadcastCoalescer
+    
     /// STORY-2025-014: Performance monitoring integration
     private let performanceFramework: WebSocketBenchmarkFramework
     private let allocationTracker: AllocationTracker
@@ -177,6 +184,10 @@ internal final class WebSocketDashboardServer: @unchecked Sendable {
         self.config = config
         self.logger = Logger(label: "privarion.dashboard.websocket")
         self.dashboardProtocol = DashboardProtocol()
+        self.broadcaster = DashboardBroadcastCoalescer(
+            interval: config.broadcastInterval,
+            maxPendingEvents: config.eventBufferSize
+        )
         
         // STORY-2025-014: Initialize performance monitoring components
         self.performanceFramework = WebSocketBenchmarkFramework(thresholds: .enterprise)
@@ -218,13 +229,7 @@ internal final class WebSocketDashboardServer: @unchecked Sendable {
             )
             
             // Broadcast to clients subscribed to performance metrics
-            self.clientsQueue.async {
-                for client in self.clients.values {
-                    if client.subscriptions.contains(.performanceMetrics) || client.subscriptions.contains(.all) {
-                        self.sendMessageToClient(client, message: performanceData)
-                    }
-                }
-            }
+            self.broadcaster.enqueue(performanceData, subscription: .performanceMetrics)
         }
     }
     
@@ -291,6 +296,7 @@ internal final class WebSocketDashboardServer: @unchecked Sendable {
         
         do {
             serverChannel = try await bootstrap.bind(host: config.host, port: config.port).get()
+            broadcaster.start()
             isRunning = true
             logger.info("WebSocket dashboard server started successfully")
         } catch {
@@ -305,7 +311,8 @@ internal final class WebSocketDashboardServer: @unchecked Sendable {
         
         logger.info("Stopping WebSocket dashboard server")
         
-        // Disconnect all clients gracefully
+        // Send pending broadcasts, then disconnect all clients gracefully
+        broadcaster.stop()
         await disconnectAllClients()
         
         // Close server channel
@@ -327,6 +334,8 @@ internal final class WebSocketDashboardServer: @unchecked Sendable {
     // MARK: - Advanced Dashboard Features
     
     /// Broadcast comprehensive dashboard package with visualization data
+    /// JSON clients get the latest full package once per broadcast tick;
+    /// binary clients get only the metrics and connection counts that changed.
     internal func broadcastDashboardPackage() async {
         // Collect current performance metrics
         let currentMetrics: [String: Double] = [
@@ -355,7 +364,15 @@ internal final class WebSocketDashboardServer: @unchecked Sendable {
             timestamp: Date()
         )
         
-        await broadcastMessage(dashboardMessage)
+        var stateValues: [String: Double] = [:]
+        for (metric, value) in currentMetrics {
+            stateValues["metrics.\(metric)"] = value
+        }
+        for (ip, count) in connectionData {
+            stateValues["connections.\(ip)"] = Double(count)
+        }
+        
+        broadcaster.updateState(stateValues, package: dashboardMessage)
         logger.debug("Broadcasted comprehensive dashboard package to \(clients.count) clients")
     }
     
@@ -514,28 +531,10 @@ internal final class WebSocketDashboardServer: @unchecked Sendable {
     }
     
     /// Broadcast message to all connected clients
+    /// The message is encoded once on the next broadcast tick and the same
+    /// buffer is written to every client.
     private func broadcastMessage(_ message: DashboardMessage) async {
-        let messageData: Data
-        do {
-            let encoder = JSONEncoder()
-            encoder.dateEncodingStrategy = .iso8601
-            messageData = try encoder.encode(message)
-        } catch {
-            logger.error("Failed to encode dashboard message: \(error)")
-            return
-        }
-        
-        var buffer = ByteBuffer()
-        buffer.writeBytes(messageData)
-        let textFrame = WebSocketFrame(fin: true, opcode: .text, data: buffer)
-        
-        for client in clients.values {
-            do {
-                try await client.channel.writeAndFlush(textFrame)
-            } catch {
-                logger.warning("Failed to send message to client \(client.id): \(error)")
-            }
-        }
+        broadcaster.enqueue(message)
     }
     
     private func generateHistoricalDataPoints(from startTime: Date, to endTime: Date) -> [DashboardData] {
@@ -655,6 +654,7 @@ internal final class WebSocketDashboardServer: @unchecked Sendable {
                 id: clientId,
                 channel: channel,
                 subscriptions: [.all], // Default to all events
+                format: DashboardFrameFormat(uri: request.uri),
                 connectedAt: Date(),
                 connectionMetrics: DashboardClient.ConnectionMetrics()
             )
@@ -666,7 +666,7 @@ internal final class WebSocketDashboardServer: @unchecked Sendable {
             let handler = WebSocketClientHandler(server: self, client: client)
             try channel.pipeline.syncOperations.addHandler(handler)
             
-            self.logger.info("WebSocket client connected: \(clientId)")
+            self.logger.info("WebSocket client connected: \(clientId) (\(client.format.rawValue))")
         }
     }
     
@@ -677,6 +677,12 @@ internal final class WebSocketDashboardServer: @unchecked Sendable {
         clientsQueue.async(flags: .barrier) {
             self.clients[client.id] = client
         }
+        broadcaster.register(
+            clientId: client.id,
+            channel: client.channel,
+            format: client.format,
+            subscriptions: client.subscriptions
+        )
     }
     
     /// Unregister WebSocket client
@@ -684,6 +690,12 @@ internal final class WebSocketDashboardServer: @unchecked Sendable {
         clientsQueue.async(flags: .barrier) {
             self.clients.removeValue(forKey: clientId)
         }
+        broadcaster.unregister(clientId: clientId)
+    }
+    
+    /// Record the dashboard state version a binary client has applied
+    internal func acknowledgeState(clientId: String, version: UInt64) {
+        broadcaster.acknowledge(clientId: clientId, version: version)
     }
     
     /// Send message to specific client
@@ -724,16 +736,9 @@ internal final class WebSocketDashboardServer: @unchecked Sendable {
     }
     
     /// Broadcast network event to subscribed clients
+    /// Events are coalesced per tick; subscriptions are checked when sending.
     private func broadcastNetworkEvent(_ event: SwiftNIONetworkMonitoringEngine.NetworkEvent) {
-        let dashboardEvent = DashboardMessage.networkEvent(eventType: eventTypeFromNetworkEvent(event))
-        
-        clientsQueue.async {
-            for client in self.clients.values {
-                if self.isClientSubscribedToEvent(client, event: event) {
-                    self.sendMessageToClient(client, message: dashboardEvent)
-                }
-            }
-        }
+        broadcaster.enqueue(eventTypeFromNetworkEvent(event))
     }
     
     /// Convert SwiftNIO network event to dashboard event type
@@ -754,26 +759,6 @@ internal final class WebSocketDashboardServer: @unchecked Sendable {
         }
     }
     
-    /// Check if client is subscribed to specific event type
-    private func isClientSubscribedToEvent(_ client: DashboardClient, event: SwiftNIONetworkMonitoringEngine.NetworkEvent) -> Bool {
-        if client.subscriptions.contains(.all) {
-            return true
-        }
-        
-        switch event {
-        case .connectionEstablished, .connectionClosed:
-            return client.subscriptions.contains(.connectionEvents)
-        case .dataTransferred:
-            return client.subscriptions.contains(.trafficEvents)
-        case .dnsQuery:
-            return client.subscriptions.contains(.dnsEvents)
-        case .performanceMetric:
-            return client.subscriptions.contains(.performanceMetrics)
-        case .error:
-            return client.subscriptions.contains(.errorEvents)
-        }
-    }
-    
     // MARK: - Statistics
     
     /// Get dashboard server statistics
@@ -810,6 +795,8 @@ internal final class WebSocketClientHandler: ChannelInboundHandler, @unchecked S
         switch frame.opcode {
         case .text:
             handleTextFrame(context: context, frame: frame)
+        case .binary:
+            handleBinaryFrame(context: context, frame: frame)
         case .ping:
             handlePing(context: context, frame: frame)
         case .connectionClose:
@@ -829,6 +816,15 @@ internal final class WebSocketClientHandler: ChannelInboundHandler, @unchecked S
         logger.debug("Received text frame from client \(client.id)")
     }
     
+    private func handleBinaryFrame(context: ChannelHandlerContext, frame: WebSocketFrame) {
+        // Binary clients acknowledge the state version they have applied
+        guard let version = DashboardBinaryFrame.acknowledgedVersion(in: frame.unmaskedData) else {
+            logger.warning("Unsupported binary frame from client \(client.id)")
+            return
+        }
+        server?.acknowledgeState(clientId: client.id, version: version)
+    }
+    
     private func handlePing(context: ChannelHandlerContext, frame: WebSocketFrame) {
         // Respond to ping with pong
         let pongFrame = WebSocketFrame(fin: true, opcode: .pong, data: frame.data)
@@ -0,0 +1,162 @@
+#ifndef PRIVARION_ES_FASTPATH_H
+#define PRIVARION_ES_FASTPATH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <EndpointSecurity/EndpointSecurity.h>
+
+// Endpoint Security fast path
+// AUTH_EXEC and AUTH_OPEN messages whose verdict is already known are
+// answered straight from the ES handler block out of a lock-free cache;
+// only misses are handed to the Swift SecurityEventProcessor, whose
+// decisions are then stored back into the cache.
+
+#define PES_CACHE_SLOTS 8192
+#define PES_CACHE_PROBE_LIMIT 8
+
+typedef enum {
+    PES_KIND_EXEC = 1,
+    PES_KIND_OPEN = 2
+} PESKind;
+
+typedef enum {
+    PES_VERDICT_ALLOW = 1,
+    PES_VERDICT_DENY = 2
+} PESVerdict;
+
+/**
+ * Identity a cached verdict is stored under
+ * The path is the new image for exec and the opened file for open. The
+ * code identity is always that of the acting process, the exec caller or
+ * the opener, which is the process the slow path evaluates. Its team and
+ * executable path are folded into identity_hash, so unsigned processes,
+ * which share a zero cdhash and an empty team, still get their own keys.
+ */
+typedef struct {
+    uint64_t path_hash;
+    uint64_t identity_hash; // pes_identity_hash of the acting process
+    uint8_t cdhash[20];     // Of the acting process
+    uint32_t fflag;         // Access mode of an open, 0 for exec
+    uint8_t kind;           // PESKind
+    uint8_t reserved[7];
+} PESCacheKey;
+
+/**
+ * Cache counters, cumulative since creation
+ */
+typedef struct {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t stores;
+    uint64_t stale_stores;  // Dropped because policies changed meanwhile
+    uint64_t evictions;
+    uint32_t generation;
+} PESCacheStats;
+
+typedef struct PESCache PESCache;
+
+// Cache Functions
+
+/**
+ * Create an empty verdict cache
+ * @return New cache, NULL if out of memory
+ */
+PESCache* pes_cache_create(void);
+
+/**
+ * Destroy a cache; no handler may still be using it
+ */
+void pes_cache_destroy(PESCache* cache);
+
+/**
+ * 64-bit FNV-1a hash used for cache key paths and team IDs
+ */
+uint64_t pes_hash_bytes(const void* data, size_t length);
+
+/**
+ * Identity hash of an acting process from its team ID and executable path
+ */
+uint64_t pes_identity_hash(const char* team_id, size_t team_length,
+                           const char* executable_path, size_t path_length);
+
+/**
+ * Get the current policy generation
+ * Read it before evaluating a policy and pass it to pes_cache_store, so a
+ * verdict computed against superseded policies is never cached.
+ */
+uint32_t pes_cache_generation(const PESCache* cache);
+
+/**
+ * Drop every cached verdict, e.g. after a policy change
+ * Wait-free for concurrent lookups, which simply start missing.
+ */
+void pes_cache_invalidate(PESCache* cache);
+
+/**
+ * Look up a verdict; safe from any thread without locking
+ * @return true if a current verdict was found
+ */
+bool pes_cache_lookup(const PESCache* cache, const PESCacheKey* key, PESVerdict* verdict);
+
+/**
+ * Store a verdict computed while generation was current
+ * Stores from several threads are serialised internally.
+ */
+void pes_cache_store(PESCache* cache, const PESCacheKey* key, PESVerdict verdict, uint32_t generation);
+
+/**
+ * Copy the cache counters
+ */
+void pes_cache_get_stats(const PESCache* cache, PESCacheStats* stats);
+
+// Message Functions
+
+/**
+ * Derive the cache key of an AUTH_EXEC or AUTH_OPEN message
+ * @return false for any other event type
+ */
+bool pes_key_from_message(const es_message_t* message, PESCacheKey* key);
+
+/**
+ * Look up the cached verdict of an AUTH_EXEC or AUTH_OPEN message
+ * @return true if a current verdict was found
+ */
+bool pes_cache_lookup_message(const PESCache* cache, const es_message_t* message, PESVerdict* verdict);
+
+/**
+ * Answer an AUTH message with the response call its event type requires
+ * AUTH_OPEN takes a flags result, every other AUTH event an auth result.
+ * @return true if Endpoint Security accepted the response
+ */
+bool pes_respond(es_client_t* client, const es_message_t* message, bool allow);
+
+/**
+ * Answer an AUTH message from the cache if its verdict is known
+ * Meant to be the first thing the es_new_client handler block does.
+ * @return true if the message was answered and needs no further handling
+ */
+bool pes_try_respond_cached(const PESCache* cache, es_client_t* client, const es_message_t* message);
+
+/**
+ * Store the verdict the slow path reached for a message
+ * @param generation Value of pes_cache_generation read before evaluating
+ */
+void pes_store_decision(PESCache* cache, const es_message_t* message, bool allow, uint32_t generation);
+
+/**
+ * Stop delivering the given events for targets under a path prefix
+ * @return ES_RETURN_SUCCESS on success
+ */
+es_return_t pes_mute_target_prefix(es_client_t* client, const char* prefix,
+                                   const es_event_type_t* events, size_t event_count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PRIVARION_ES_FASTPATH_H
@@ -0,0 +1,225 @@
+// Verdict Cache
+// Open-addressed table of fixed-size slots, each guarded by a sequence
+// counter: lookups copy a slot and retry nothing, treating a slot that
+// changed underneath them as a miss. Stores are rare (one per distinct
+// binary or file) and serialised by a mutex. Invalidation bumps a global
+// generation instead of touching the slots.
+
+#include "include/privarion_es_fastpath.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#define PES_CACHE_MASK (PES_CACHE_SLOTS - 1)
+#define PES_KEY_WORDS (sizeof(PESCacheKey) / sizeof(uint64_t))
+
+_Static_assert((PES_CACHE_SLOTS & PES_CACHE_MASK) == 0, "Slot count must be a power of two");
+_Static_assert(sizeof(PESCacheKey) == 48, "Cache keys are compared bytewise and must have no padding");
+
+typedef struct {
+    _Atomic uint32_t sequence;      // Odd while the slot is rewritten
+    _Atomic uint32_t generation;    // 0 while the slot is empty
+    _Atomic uint32_t verdict;
+    uint32_t reserved;
+    _Atomic uint64_t key[PES_KEY_WORDS];  // PESCacheKey, copied word by word
+} __attribute__((aligned(64))) PESCacheSlot;
+
+_Static_assert(sizeof(PESCacheSlot) == 64, "A slot should fill exactly one cache line");
+
+struct PESCache {
+    _Atomic uint32_t generation;
+    _Atomic uint64_t hits;
+    _Atomic uint64_t misses;
+    _Atomic uint64_t stores;
+    _Atomic uint64_t stale_stores;
+    _Atomic uint64_t evictions;
+    pthread_mutex_t store_lock;
+    PESCacheSlot slots[PES_CACHE_SLOTS];
+};
+
+uint64_t pes_hash_bytes(const void* data, size_t length) {
+    const uint8_t* bytes = data;
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+uint64_t pes_identity_hash(const char* team_id, size_t team_length,
+                           const char* executable_path, size_t path_length) {
+    return pes_hash_bytes(team_id, team_length) ^
+           (pes_hash_bytes(executable_path, path_length) * 0x9E3779B97F4A7C15ull);
+}
+
+static void pes_key_load(const PESCacheSlot* slot, PESCacheKey* key) {
+    uint64_t words[PES_KEY_WORDS];
+    for (size_t i = 0; i < PES_KEY_WORDS; i++) {
+        words[i] = atomic_load_explicit(&((PESCacheSlot*)slot)->key[i], memory_order_relaxed);
+    }
+    memcpy(key, words, sizeof(*key));
+}
+
+static void pes_key_save(PESCacheSlot* slot, const PESCacheKey* key) {
+    uint64_t words[PES_KEY_WORDS];
+    memcpy(words, key, sizeof(words));
+    for (size_t i = 0; i < PES_KEY_WORDS; i++) {
+        atomic_store_explicit(&slot->key[i], words[i], memory_order_relaxed);
+    }
+}
+
+static uint32_t pes_slot_index(const PESCacheKey* key) {
+    uint64_t cdhash_prefix;
+    memcpy(&cdhash_prefix, key->cdhash, sizeof(cdhash_prefix));
+    uint64_t mixed = key->path_hash ^ (key->identity_hash * 0xC2B2AE3D27D4EB4Full) ^ cdhash_prefix ^
+                     ((uint64_t)key->fflag << 8) ^ key->kind;
+    mixed ^= mixed >> 29;
+    return (uint32_t)mixed & PES_CACHE_MASK;
+}
+
+PESCache* pes_cache_create(void) {
+    PESCache* cache = calloc(1, sizeof(PESCache));
+    if (cache == NULL) {
+        return NULL;
+    }
+    atomic_init(&cache->generation, 1);
+    pthread_mutex_init(&cache->store_lock, NULL);
+    return cache;
+}
+
+void pes_cache_destroy(PESCache* cache) {
+    if (cache == NULL) {
+        return;
+    }
+    pthread_mutex_destroy(&cache->store_lock);
+    free(cache);
+}
+
+uint32_t pes_cache_generation(const PESCache* cache) {
+    return atomic_load_explicit(&((PESCache*)cache)->generation, memory_order_acquire);
+}
+
+void pes_cache_invalidate(PESCache* cache) {
+    if (cache == NULL) {
+        return;
+    }
+    // Generation 0 marks empty slots and is skipped on wrap-around
+    uint32_t previous = atomic_fetch_add_explicit(&cache->generation, 1, memory_order_acq_rel);
+    if (previous + 1 == 0) {
+        atomic_fetch_add_explicit(&cache->generation, 1, memory_order_acq_rel);
+    }
+}
+
+bool pes_cache_lookup(const PESCache* cache, const PESCacheKey* key, PESVerdict* verdict) {
+    if (cache == NULL || key == NULL || verdict == NULL) {
+        return false;
+    }
+
+    PESCache* table = (PESCache*)cache;
+    uint32_t current = atomic_load_explicit(&table->generation, memory_order_acquire);
+    uint32_t index = pes_slot_index(key);
+
+    for (uint32_t probe = 0; probe < PES_CACHE_PROBE_LIMIT; probe++) {
+        PESCacheSlot* slot = &table->slots[(index + probe) & PES_CACHE_MASK];
+        uint32_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        if (sequence & 1) {
+            continue;
+        }
+
+        uint32_t generation = atomic_load_explicit(&slot->generation, memory_order_relaxed);
+        uint32_t cached = atomic_load_explicit(&slot->verdict, memory_order_relaxed);
+        PESCacheKey slot_key;
+        pes_key_load(slot, &slot_key);
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&slot->sequence, memory_order_relaxed) != sequence) {
+            continue;
+        }
+
+        if (generation == 0) {
+            // Stores fill the first free slot, so the key is not further on
+            break;
+        }
+        if (memcmp(&slot_key, key, sizeof(slot_key)) == 0) {
+            if (generation != current) {
+                break;
+            }
+            *verdict = (PESVerdict)cached;
+            atomic_fetch_add_explicit(&table->hits, 1, memory_order_relaxed);
+            return true;
+        }
+    }
+
+    atomic_fetch_add_explicit(&table->misses, 1, memory_order_relaxed);
+    return false;
+}
+
+static void pes_slot_write(PESCacheSlot* slot, const PESCacheKey* key, PESVerdict verdict, uint32_t generation) {
+    uint32_t sequence = atomic_load_explicit(&slot->sequence, memory_order_relaxed);
+    atomic_store_explicit(&slot->sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    pes_key_save(slot, key);
+    atomic_store_explicit(&slot->verdict, (uint32_t)verdict, memory_order_relaxed);
+    atomic_store_explicit(&slot->generation, generation, memory_order_relaxed);
+    atomic_store_explicit(&slot->sequence, sequence + 2, memory_order_release);
+}
+
+void pes_cache_store(PESCache* cache, const PESCacheKey* key, PESVerdict verdict, uint32_t generation) {
+    if (cache == NULL || key == NULL || generation == 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&cache->store_lock);
+
+    uint32_t current = atomic_load_explicit(&cache->generation, memory_order_acquire);
+    if (generation != current) {
+        atomic_fetch_add_explicit(&cache->stale_stores, 1, memory_order_relaxed);
+        pthread_mutex_unlock(&cache->store_lock);
+        return;
+    }
+
+    // Prefer the key's own slot, then the first stale or free one
+    uint32_t index = pes_slot_index(key);
+    PESCacheSlot* target = NULL;
+    for (uint32_t probe = 0; probe < PES_CACHE_PROBE_LIMIT; probe++) {
+        PESCacheSlot* slot = &cache->slots[(index + probe) & PES_CACHE_MASK];
+        uint32_t slot_generation = atomic_load_explicit(&slot->generation, memory_order_relaxed);
+        PESCacheKey slot_key;
+        pes_key_load(slot, &slot_key);
+        if (slot_generation != 0 && memcmp(&slot_key, key, sizeof(*key)) == 0) {
+            target = slot;
+            break;
+        }
+        if (target == NULL && slot_generation != current) {
+            target = slot;
+        }
+        if (slot_generation == 0) {
+            break;
+        }
+    }
+
+    if (target == NULL) {
+        // Every probed slot is live; displace the one the key hashes to
+        target = &cache->slots[index];
+        atomic_fetch_add_explicit(&cache->evictions, 1, memory_order_relaxed);
+    }
+
+    pes_slot_write(target, key, verdict, current);
+    atomic_fetch_add_explicit(&cache->stores, 1, memory_order_relaxed);
+    pthread_mutex_unlock(&cache->store_lock);
+}
+
+void pes_cache_get_stats(const PESCache* cache, PESCacheStats* stats) {
+    if (cache == NULL || stats == NULL) {
+        return;
+    }
+
+    PESCache* table = (PESCache*)cache;
+    stats->hits = atomic_load_explicit(&table->hits, memory_order_relaxed);
+    stats->misses = atomic_load_explicit(&table->misses, memory_order_relaxed);
+    stats->stores = atomic_load_explicit(&table->stores, memory_order_relaxed);
+    stats->stale_stores = atomic_load_explicit(&table->stale_stores, memory_order_relaxed);
+    stats->evictions = atomic_load_explicit(&table->evictions, memory_order_relaxed);
+    stats->generation = atomic_load_explicit(&table->generation, memory_order_relaxed);
+}
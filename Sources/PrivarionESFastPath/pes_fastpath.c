@@ -0,0 +1,84 @@
+// Message Fast Path
+// Key derivation and responses for the ES handler block. Everything here
+// runs on Endpoint Security's delivery thread before any Swift code, so it
+// only reads the message, hashes a few strings and probes the cache.
+
+#include "include/privarion_es_fastpath.h"
+#include <string.h>
+
+static void pes_key_init(PESCacheKey* key, PESKind kind, const es_string_token_t* path,
+                         const es_process_t* process, uint32_t fflag) {
+    memset(key, 0, sizeof(*key));
+    key->kind = (uint8_t)kind;
+    key->fflag = fflag;
+    key->path_hash = pes_hash_bytes(path->data, path->length);
+    key->identity_hash = pes_identity_hash(process->team_id.data, process->team_id.length,
+                                           process->executable->path.data, process->executable->path.length);
+    memcpy(key->cdhash, process->cdhash, sizeof(key->cdhash));
+}
+
+bool pes_key_from_message(const es_message_t* message, PESCacheKey* key) {
+    if (message == NULL || key == NULL) {
+        return false;
+    }
+
+    // The caller's identity decides an exec, so a verdict about one caller
+    // is never replayed for another that execs the same image
+    switch (message->event_type) {
+    case ES_EVENT_TYPE_AUTH_EXEC:
+        pes_key_init(key, PES_KIND_EXEC, &message->event.exec.target->executable->path, message->process, 0);
+        return true;
+    case ES_EVENT_TYPE_AUTH_OPEN:
+        pes_key_init(key, PES_KIND_OPEN, &message->event.open.file->path, message->process,
+                     (uint32_t)message->event.open.fflag);
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool pes_cache_lookup_message(const PESCache* cache, const es_message_t* message, PESVerdict* verdict) {
+    PESCacheKey key;
+    return pes_key_from_message(message, &key) && pes_cache_lookup(cache, &key, verdict);
+}
+
+bool pes_respond(es_client_t* client, const es_message_t* message, bool allow) {
+    if (client == NULL || message == NULL || message->action_type != ES_ACTION_TYPE_AUTH) {
+        return false;
+    }
+
+    es_respond_result_t result;
+    if (message->event_type == ES_EVENT_TYPE_AUTH_OPEN) {
+        result = es_respond_flags_result(client, message, allow ? UINT32_MAX : 0, false);
+    } else {
+        result = es_respond_auth_result(client, message, allow ? ES_AUTH_RESULT_ALLOW : ES_AUTH_RESULT_DENY, false);
+    }
+    return result == ES_RESPOND_RESULT_SUCCESS;
+}
+
+bool pes_try_respond_cached(const PESCache* cache, es_client_t* client, const es_message_t* message) {
+    if (message == NULL || message->action_type != ES_ACTION_TYPE_AUTH) {
+        return false;
+    }
+
+    PESVerdict verdict;
+    if (!pes_cache_lookup_message(cache, message, &verdict)) {
+        return false;
+    }
+    return pes_respond(client, message, verdict == PES_VERDICT_ALLOW);
+}
+
+void pes_store_decision(PESCache* cache, const es_message_t* message, bool allow, uint32_t generation) {
+    PESCacheKey key;
+    if (pes_key_from_message(message, &key)) {
+        pes_cache_store(cache, &key, allow ? PES_VERDICT_ALLOW : PES_VERDICT_DENY, generation);
+    }
+}
+
+es_return_t pes_mute_target_prefix(es_client_t* client, const char* prefix,
+                                   const es_event_type_t* events, size_t event_count) {
+    if (client == NULL || prefix == NULL || events == NULL || event_count == 0) {
+        return ES_RETURN_ERROR;
+    }
+    return es_mute_path_events(client, prefix, ES_MUTE_PATH_TYPE_TARGET_PREFIX, events, event_count);
+}
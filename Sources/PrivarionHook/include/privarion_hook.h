@@ -7,7 +7,9 @@ extern "C" {
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <sys/types.h>
+#include <sys/utsname.h>
 
 // Version information
 #define PRIVARION_HOOK_VERSION_MAJOR 1
@@ -26,15 +28,6 @@ typedef enum {
     PH_ERROR_UNSUPPORTED_PLATFORM = -7
 } PHResult;
 
-// Hook entry structure
-typedef struct PHookEntry {
-    char function_name[256];
-    void* original_function;
-    void* replacement_function;
-    bool is_active;
-    struct PHookEntry* next;
-} PHookEntry;
-
 // Hook handle for managing individual hooks
 typedef struct {
     uint32_t id;
@@ -42,6 +35,12 @@ typedef struct {
     bool is_valid;
 } PHookHandle;
 
+// Hook specification for batch installation
+typedef struct {
+    const char* function_name;
+    void* replacement_function; // NULL selects the built-in replacement
+} PHookSpec;
+
 // Core Hook Management Functions
 /**
  * Initialize the hook system
@@ -74,6 +73,38 @@ PHResult ph_install_hook(const char* function_name,
  */
 PHResult ph_remove_hook(const PHookHandle* handle);
 
+/**
+ * Install several hooks as one transaction
+ * All symbols are resolved first and every loaded image is patched in a
+ * single walk. Either every hook is installed or none is.
+ * @param specs Array of hook specifications
+ * @param count Number of specifications
+ * @param handles Output array receiving one handle per specification
+ * @return PH_SUCCESS on success, error code of the first failing spec otherwise
+ */
+PHResult ph_install_hooks(const PHookSpec* specs, size_t count, PHookHandle* handles);
+
+/**
+ * Install several hooks as one transaction, skipping unloaded symbols
+ * Behaves like ph_install_hooks, except that a spec whose symbol is not
+ * loaded in the process is left out instead of failing the batch; its
+ * handle has is_valid set to false. Lazy activation never skips.
+ * @param specs Array of hook specifications
+ * @param count Number of specifications
+ * @param handles Output array receiving one handle per specification
+ * @return PH_SUCCESS when every loaded spec is installed, error code otherwise
+ */
+PHResult ph_install_loaded_hooks(const PHookSpec* specs, size_t count, PHookHandle* handles);
+
+/**
+ * Remove several hooks as one transaction
+ * Nothing is removed unless every handle refers to an installed hook.
+ * @param handles Array of hook handles
+ * @param count Number of handles
+ * @return PH_SUCCESS on success, error code on failure
+ */
+PHResult ph_remove_hooks(const PHookHandle* handles, size_t count);
+
 /**
  * Get pointer to original function
  * @param handle Handle of the hook
@@ -136,6 +167,21 @@ typedef struct {
     char version[512];
 } PHookConfigData;
 
+/**
+ * Publish a complete configuration for all hooks at once
+ * Hooked functions observe either the previous or the new configuration,
+ * never a mix of both.
+ * @param config_data Configuration data to publish
+ * @return PH_SUCCESS on success, error code on failure
+ */
+PHResult ph_update_config(const PHookConfigData* config_data);
+
+/**
+ * Get the version of the currently published configuration
+ * @return Configuration version, incremented on every publish
+ */
+uint64_t ph_get_config_version(void);
+
 /**
  * Install getuid hook with configured fake user ID
  * @param config_data Configuration data containing fake user ID
@@ -168,6 +214,265 @@ PHResult ph_install_gethostname_hook(const PHookConfigData* config_data, PHookHa
  */
 PHResult ph_install_uname_hook(const PHookConfigData* config_data, PHookHandle* handle);
 
+/**
+ * Get the configured user ID from the calling thread's cached copy
+ * Used by replacement functions defined outside the library; costs a
+ * thread-local load and a compare unless the configuration changed.
+ * @param fallback Value returned if no configuration was published
+ * @return Configured user ID
+ */
+uid_t ph_spoofed_getuid(uid_t fallback);
+
+/**
+ * Get the configured group ID from the calling thread's cached copy
+ * @param fallback Value returned if no configuration was published
+ * @return Configured group ID
+ */
+gid_t ph_spoofed_getgid(gid_t fallback);
+
+/**
+ * Fill a utsname structure from the published configuration
+ * Used by replacement functions defined outside the library so that every
+ * uname hook answers from the same prebuilt template.
+ * @param buf Output structure
+ * @return 0 on success, -1 if buf is NULL or no configuration was published
+ */
+int ph_spoofed_uname(struct utsname* buf);
+
+/**
+ * Copy the configured hostname, with gethostname() semantics
+ * @param name Output buffer
+ * @param len Size of the output buffer
+ * @return 0 on success, -1 if the buffer is too small or no configuration was published
+ */
+int ph_spoofed_gethostname(char* name, size_t len);
+
+// Hook Profiles
+// A profile table is a read-only binary file holding one record per bundle
+// identifier. Layout: PHProfileHeader, then profile_count PHProfileRecord
+// entries sorted by bundle identifier (byte order), then a string table
+// with the identifiers. A record with an empty identifier is the default.
+
+#define PH_PROFILE_PATH_ENV "PRIVARION_HOOK_PROFILE"
+#define PH_PROFILE_BUNDLE_ENV "PRIVARION_HOOK_BUNDLE_ID"
+
+#define PH_PROFILE_MAGIC 0x46504850u // "PHPF" when read as little-endian bytes
+#define PH_PROFILE_FORMAT_VERSION 1
+
+// Built-in hooks selected by PHProfileRecord.hook_mask
+#define PH_PROFILE_HOOK_GETUID      (1u << 0)
+#define PH_PROFILE_HOOK_GETGID      (1u << 1)
+#define PH_PROFILE_HOOK_GETHOSTNAME (1u << 2)
+#define PH_PROFILE_HOOK_UNAME       (1u << 3)
+#define PH_PROFILE_HOOK_SYSCTLBYNAME (1u << 4)
+#define PH_PROFILE_HOOK_IOREGISTRY  (1u << 5)
+
+typedef struct {
+    uint32_t magic;
+    uint32_t format_version;
+    uint32_t profile_count;
+    uint32_t record_size;          // sizeof(PHProfileRecord) of the writer
+    uint32_t string_table_offset;  // From the start of the file
+    uint32_t string_table_size;
+    uint32_t reserved[2];
+} PHProfileHeader;
+
+typedef struct {
+    uint32_t bundle_id_offset;     // Into the string table
+    uint32_t bundle_id_length;     // 0 for the default profile
+    uint32_t hook_mask;            // PH_PROFILE_HOOK_* bits
+    uint32_t reserved;
+    PHookConfigData config;
+} PHProfileRecord;
+
+/**
+ * Apply the profile for a bundle from a profile table file
+ * Publishes the profile's configuration and installs its built-in hooks
+ * as one batch, falling back to the default profile when the bundle has
+ * none. Called from the library constructor when PH_PROFILE_PATH_ENV is set.
+ * @param path Path of the profile table
+ * @param bundle_id Bundle identifier of the host, NULL for the default profile
+ * @return PH_SUCCESS on success, PH_ERROR_NOT_HOOKED if no profile applies
+ */
+PHResult ph_load_profile(const char* path, const char* bundle_id);
+
+// Hardware Identifiers
+// The sysctlbyname and IORegistryEntryCreateCFProperty replacements answer
+// from one sorted key-to-value table generated once per session. Keys are
+// looked up per source, so "hw.model" and the "model" registry property
+// never collide. Keys the table does not hold pass through to the original.
+// Layout of a table file: PHIdentifierHeader, then entry_count
+// PHIdentifierRecord entries in any order, then a byte table holding every
+// key and value. The library sorts the entries once when it loads them.
+
+#define PH_IDENTIFIERS_PATH_ENV "PRIVARION_HOOK_IDENTIFIERS"
+
+#define PH_IDENTIFIERS_MAGIC 0x44494850u // "PHID" when read as little-endian bytes
+#define PH_IDENTIFIERS_FORMAT_VERSION 1
+#define PH_IDENTIFIERS_MAX_ENTRIES 256
+#define PH_IDENTIFIERS_MAX_KEY_LENGTH 127
+#define PH_IDENTIFIERS_MAX_VALUE_LENGTH 4096
+
+/**
+ * API a spoofed identifier is answered from
+ */
+typedef enum {
+    PH_IDENTIFIER_SYSCTL,       // sysctlbyname() name
+    PH_IDENTIFIER_IOREGISTRY,   // IORegistryEntryCreateCFProperty() key
+    PH_IDENTIFIER_SOURCE_COUNT
+} PHIdentifierSource;
+
+/**
+ * Representation of a spoofed value
+ * Strings reach sysctl callers NUL-terminated and registry callers as a
+ * CFString; data is copied as is and becomes a CFData.
+ */
+typedef enum {
+    PH_IDENTIFIER_STRING,
+    PH_IDENTIFIER_DATA
+} PHIdentifierKind;
+
+/**
+ * One spoofed identifier, for ph_set_identifiers
+ */
+typedef struct {
+    PHIdentifierSource source;
+    PHIdentifierKind kind;
+    const char* key;
+    const void* value;      // String values without their terminator
+    size_t value_length;
+} PHIdentifierSpec;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t format_version;
+    uint32_t entry_count;
+    uint32_t record_size;          // sizeof(PHIdentifierRecord) of the writer
+    uint32_t byte_table_offset;    // From the start of the file
+    uint32_t byte_table_size;
+    uint32_t reserved[2];
+} PHIdentifierHeader;
+
+typedef struct {
+    uint32_t source;               // PHIdentifierSource
+    uint32_t kind;                 // PHIdentifierKind
+    uint32_t key_offset;           // Into the byte table
+    uint32_t key_length;
+    uint32_t value_offset;         // Into the byte table
+    uint32_t value_length;
+} PHIdentifierRecord;
+
+/**
+ * Replace the spoofed identifier table
+ * The table is copied; hooked calls see either the previous or the new
+ * table, never a mix of both.
+ * @param specs Identifiers to publish
+ * @param count Number of identifiers, 0 to clear the table
+ * @return PH_SUCCESS on success, PH_ERROR_INVALID_PARAM for oversized or duplicate keys
+ */
+PHResult ph_set_identifiers(const PHIdentifierSpec* specs, size_t count);
+
+/**
+ * Publish the identifiers of a table file
+ * Called from the library constructor when PH_IDENTIFIERS_PATH_ENV is set.
+ * @param path Path of the identifier table
+ * @return PH_SUCCESS on success, error code on failure
+ */
+PHResult ph_load_identifiers(const char* path);
+
+/**
+ * Get the number of identifiers in the published table
+ * @return Number of identifiers, 0 if none were published
+ */
+size_t ph_get_identifier_count(void);
+
+// Process Inheritance
+// Processes started by a hooked process load the library as well. The
+// posix_spawn, posix_spawnp and execve replacements put DYLD_INSERT_LIBRARIES
+// and the PRIVARION_HOOK_* variables this process was launched with back
+// into any child environment that lacks them, so helpers map the same
+// profile and identifier tables without the launcher starting them.
+// Helpers resolve the profile of the bundle identifier they inherit.
+// The library also registers pthread_atfork handlers: a forked child that
+// does not exec keeps its hooks and exports its own statistics and events.
+
+/**
+ * Make processes spawned from now on inherit the hook library
+ * Captures the inherited variables from the current environment and
+ * installs the posix_spawn, posix_spawnp and execve replacements. Called
+ * from the library constructor when the library was inserted through
+ * DYLD_INSERT_LIBRARIES; later calls keep the first capture.
+ * @param library_path Library inserted into children, NULL for the image holding this function
+ * @return PH_SUCCESS on success, error code on failure
+ */
+PHResult ph_enable_inheritance(const char* library_path);
+
+/**
+ * Check whether spawned processes inherit the hook library
+ * @return true once ph_enable_inheritance has succeeded
+ */
+bool ph_is_inheritance_enabled(void);
+
+// Lazy Activation
+// By default installing a hook resolves its original with dlsym up front.
+// With lazy activation the install only reserves the hook and patches the
+// symbol pointers; each original is resolved and cached by the first call
+// that needs it. Startup then pays for symbol resolution only for hooks the
+// process actually calls, and a function whose library is not loaded yet is
+// accepted and patched when an image importing it loads.
+
+#define PH_LAZY_ENV "PRIVARION_HOOK_LAZY"
+
+/**
+ * Cumulative cost of activating hooks in this process
+ */
+typedef struct {
+    uint32_t hooks_installed;      // Hooks installed, including removed ones
+    uint32_t originals_resolved;   // Originals looked up, at install or on first call
+    uint64_t install_ns;           // Time spent in install calls
+    uint64_t lazy_resolve_ns;      // Time first calls spent resolving originals
+} PHActivationStats;
+
+/**
+ * Enable or disable lazy activation for hooks installed from now on
+ * Also enabled by setting PH_LAZY_ENV to "1" in the environment.
+ * @param enabled true to resolve originals on first call
+ */
+void ph_set_lazy_activation(bool enabled);
+
+/**
+ * Check whether hooks are installed lazily
+ * @return true if lazy activation is enabled
+ */
+bool ph_is_lazy_activation_enabled(void);
+
+/**
+ * Get the cost of activating hooks so far
+ * @param stats Output statistics
+ */
+void ph_get_activation_stats(PHActivationStats* stats);
+
+// Hook Arena
+// Interned names and rebind journals live in one mapping reserved by
+// ph_initialize and released in bulk by ph_cleanup, so installing and
+// removing hooks never calls malloc in the target process.
+
+/**
+ * Current use of the hook arena
+ */
+typedef struct {
+    size_t reserved_bytes;       // Size of the mapping, 0 before the first ph_initialize
+    size_t name_bytes_used;      // Interned function names
+    size_t journal_bytes_used;   // Journal blocks ever carved out
+    size_t journal_bytes_live;   // Journal blocks currently held by hooks
+} PHArenaStats;
+
+/**
+ * Get the current use of the hook arena
+ * @param stats Output statistics
+ */
+void ph_get_arena_stats(PHArenaStats* stats);
+
 // Utility Functions
 /**
  * Get error message for a result code
@@ -209,6 +514,274 @@ uint32_t ph_get_active_hook_count(void);
  */
 uint32_t ph_get_active_hooks(char* buffer, size_t buffer_size);
 
+// Tracing Functions
+
+/**
+ * Binary record of one hooked call
+ */
+typedef struct {
+    uint64_t timestamp_ns;  // Monotonic clock
+    uint64_t thread_id;
+    int64_t return_value;
+    uint32_t hook_id;       // PHookHandle.id of the hook that ran
+    uint32_t reserved;
+} PHTraceRecord;
+
+/**
+ * Enable or disable tracing of hooked calls
+ * Hooked functions append records to a per-thread ring and never block;
+ * records are dropped when a ring is full.
+ * @param enabled true to record trace records
+ */
+void ph_set_tracing_enabled(bool enabled);
+
+/**
+ * Check whether tracing was compiled in
+ * @return false if the library was built with PRIVARION_HOOK_NO_TRACE
+ */
+bool ph_is_tracing_available(void);
+
+/**
+ * Move pending trace records out of the per-thread rings
+ * Safe to call from any thread; concurrent drains are serialised.
+ * @param records Output array
+ * @param capacity Number of records the output array can hold
+ * @return Number of records written
+ */
+size_t ph_trace_drain(PHTraceRecord* records, size_t capacity);
+
+/**
+ * Get the number of trace records dropped because a ring was full
+ * @return Total dropped records since the library was loaded
+ */
+uint64_t ph_trace_dropped_count(void);
+
+// Statistics Functions
+
+#define PH_STATS_ENV "PRIVARION_HOOK_STATS"
+#define PH_STATS_MAX_HOOKS 64
+#define PH_STATS_HISTOGRAM_BUCKETS 128
+
+/**
+ * Aggregated counters of one hook, as read from a statistics region
+ * Histogram bucket i counts calls whose latency was at least
+ * ph_stats_bucket_lower_bound(i) nanoseconds and below the next bound.
+ * Buckets 0-15 are one nanosecond wide; above that every power of two is
+ * split into four, so a bound is within 25% of the latencies it counts, up
+ * to 2^32 ns (about 4.3 s). The last bucket starts at 3.76 s and also holds
+ * every slower call.
+ */
+typedef struct {
+    uint32_t hook_id;
+    char function_name[64];
+    uint64_t calls;
+    uint64_t spoofed;
+    uint64_t passthrough;
+    uint64_t total_ns;
+    uint64_t histogram[PH_STATS_HISTOGRAM_BUCKETS];
+} PHHookStats;
+
+/**
+ * Read-only mapping of another (or this) process's statistics region
+ */
+typedef struct PHStatsView PHStatsView;
+
+/**
+ * Start exporting per-hook statistics for this process
+ * Creates a shared memory region named after the process ID. Hooks in
+ * registry slots below PH_STATS_MAX_HOOKS are counted. Also enabled at load
+ * time when PH_STATS_ENV=1 is set in the environment.
+ * @return PH_SUCCESS on success, error code on failure
+ */
+PHResult ph_stats_enable(void);
+
+/**
+ * Map the statistics region of a process read-only
+ * Does not interact with the target process itself.
+ * @param pid Process whose hook statistics should be read
+ * @param view Output parameter for the mapped view
+ * @return PH_SUCCESS on success, PH_ERROR_NOT_HOOKED if the process exports no statistics
+ */
+PHResult ph_stats_open(pid_t pid, PHStatsView** view);
+
+/**
+ * Aggregate the counters of one statistics slot
+ * @param view View returned by ph_stats_open
+ * @param slot Slot index below PH_STATS_MAX_HOOKS
+ * @param stats Output structure
+ * @return true if the slot holds an installed hook
+ */
+bool ph_stats_read(const PHStatsView* view, uint32_t slot, PHHookStats* stats);
+
+/**
+ * Unmap a statistics view
+ * @param view View returned by ph_stats_open
+ */
+void ph_stats_close(PHStatsView* view);
+
+/**
+ * Get the lowest latency counted by a histogram bucket
+ * @param bucket Bucket index below PH_STATS_HISTOGRAM_BUCKETS
+ * @return Lower bound in nanoseconds
+ */
+uint64_t ph_stats_bucket_lower_bound(uint32_t bucket);
+
+// Syscall Event Functions
+// A hooked process can publish one PHEventRecord per hooked call into a
+// shared memory region named after its process ID. Each of its threads
+// claims one of PH_EVENTS_LANES lanes, so every lane has a single producer;
+// one consumer process maps the region and drains all lanes.
+
+#define PH_EVENTS_ENV "PRIVARION_HOOK_EVENTS"
+#define PH_EVENTS_LANES 16
+#define PH_EVENTS_LANE_CAPACITY 1024
+#define PH_EVENTS_ARGUMENT_SIZE 96
+
+// PHEventRecord.flags
+#define PH_EVENT_ARGUMENT_IS_PATH 0x1   // argument is the path the filter saw
+#define PH_EVENT_ARGUMENT_TRUNCATED 0x2 // argument was cut to fit the record
+
+/**
+ * Binary record of one published call
+ * `argument` holds the call's path, or its first string argument, cut to
+ * PH_EVENTS_ARGUMENT_SIZE - 1 bytes and null-terminated; it is empty when
+ * the call has neither.
+ */
+typedef struct {
+    uint64_t timestamp_ns;    // Monotonic clock
+    uint64_t thread_id;
+    int64_t return_value;
+    uint32_t hook_id;         // PHookHandle.id of the hook that ran
+    uint16_t syscall;         // PHSyscallId
+    uint8_t flags;            // PH_EVENT_* bits
+    uint8_t argument_length;  // Bytes in argument, terminator excluded
+    char argument[PH_EVENTS_ARGUMENT_SIZE];
+} PHEventRecord;
+
+/**
+ * Writable mapping of another (or this) process's event region
+ */
+typedef struct PHEventView PHEventView;
+
+/**
+ * Start publishing hooked calls for this process
+ * Creates a shared memory region named after the process ID. Hooks in
+ * registry slots below PH_STATS_MAX_HOOKS are named in the region. Also
+ * enabled at load time when PRIVARION_HOOK_EVENTS=1 is set in the environment.
+ * @return PH_SUCCESS on success, error code on failure
+ */
+PHResult ph_events_enable(void);
+
+/**
+ * Map the event region of a process for draining
+ * Only one consumer may drain a region at a time.
+ * @param pid Process whose events should be drained
+ * @param view Output parameter for the mapped view
+ * @return PH_SUCCESS on success, PH_ERROR_NOT_HOOKED if the process publishes no events
+ */
+PHResult ph_events_open(pid_t pid, PHEventView** view);
+
+/**
+ * Move pending records out of every lane of the region
+ * @param view View returned by ph_events_open
+ * @param records Output array
+ * @param capacity Number of records the output array can hold
+ * @return Number of records written
+ */
+size_t ph_events_drain(PHEventView* view, PHEventRecord* records, size_t capacity);
+
+/**
+ * Resolve the function name of a hook ID found in drained records
+ * @param view View returned by ph_events_open
+ * @param hook_id PHEventRecord.hook_id
+ * @param buffer Output buffer for the null-terminated name
+ * @param buffer_size Size of the buffer
+ * @return true if the hook is still installed and its name was copied
+ */
+bool ph_events_hook_name(const PHEventView* view, uint32_t hook_id, char* buffer, size_t buffer_size);
+
+/**
+ * Get the number of records the hooked process dropped
+ * @param view View returned by ph_events_open
+ * @return Records dropped because a lane was full or no lane was free
+ */
+uint64_t ph_events_dropped_count(const PHEventView* view);
+
+/**
+ * Unmap an event view
+ * @param view View returned by ph_events_open
+ */
+void ph_events_close(PHEventView* view);
+
+// Event Filters
+// The consumer can install a filter into an event region so the hooked
+// process only publishes calls some monitoring rule may match. Conditions
+// on the process itself (PID, name, credentials) are constant for one
+// region and are resolved by the consumer before it installs the filter.
+
+#define PH_EVENTS_FILTER_MAX_RULES 64
+#define PH_EVENTS_FILTER_MAX_NODES 2048
+
+/**
+ * System calls known to event filters
+ */
+typedef enum {
+    PH_SYSCALL_GETUID,
+    PH_SYSCALL_GETGID,
+    PH_SYSCALL_GETHOSTNAME,
+    PH_SYSCALL_UNAME,
+    PH_SYSCALL_CONNECT,
+    PH_SYSCALL_BIND,
+    PH_SYSCALL_LISTEN,
+    PH_SYSCALL_OPEN,
+    PH_SYSCALL_READ,
+    PH_SYSCALL_WRITE,
+    PH_SYSCALL_SYSCTLBYNAME,
+    PH_SYSCALL_IOREGISTRY,
+    PH_SYSCALL_POSIX_SPAWN,
+    PH_SYSCALL_EXECVE,
+    PH_SYSCALL_COUNT
+} PHSyscallId;
+
+/**
+ * One rule of an event filter
+ * A call passes the rule when its syscall bit is set in syscall_mask and,
+ * for calls that carry a path, the path starts with one of the allowed
+ * prefixes (any path if there are none) and with none of the blocked ones.
+ */
+typedef struct {
+    uint64_t syscall_mask;  // Bit (1 << PHSyscallId) per matched call
+    const char* const* allowed_prefixes;
+    size_t allowed_count;
+    const char* const* blocked_prefixes;
+    size_t blocked_count;
+} PHEventFilterRule;
+
+/**
+ * Replace the region's filter; a call is published if any rule passes it
+ * An empty rule list publishes nothing.
+ * @param view View returned by ph_events_open
+ * @param rules Rules to compile
+ * @param count Number of rules, at most PH_EVENTS_FILTER_MAX_RULES
+ * @return PH_SUCCESS on success, PH_ERROR_MEMORY_ERROR if the prefixes exceed the trie capacity
+ */
+PHResult ph_events_set_filter(PHEventView* view, const PHEventFilterRule* rules, size_t count);
+
+/**
+ * Remove the region's filter so every hooked call is published
+ * @param view View returned by ph_events_open
+ */
+void ph_events_clear_filter(PHEventView* view);
+
+/**
+ * Evaluate the region's filter as the hooked process would
+ * @param view View returned by ph_events_open
+ * @param syscall Call to test
+ * @param path Path argument of the call, NULL if it has none
+ * @return true if the call would be published
+ */
+bool ph_events_filter_matches(const PHEventView* view, PHSyscallId syscall, const char* path);
+
 #ifdef __cplusplus
 }
 #endif
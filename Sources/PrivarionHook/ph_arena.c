@@ -0,0 +1,136 @@
+// Hook Arena
+// Everything the hook system allocates while hooks are installed comes from
+// one anonymous mapping made by the first ph_initialize, so hook churn never
+// calls into the target's allocator (which may itself be hooked, or not yet
+// initialized while dyld runs constructors). Pages are only committed once
+// touched. ph_cleanup releases everything in bulk by rewinding the arena and
+// handing its pages back, but keeps the address range mapped: ph_is_hooked
+// probes interned names without a lock and must never fault on one.
+// Interned names are bump-allocated and released in bulk. Rebind journals
+// come in power-of-two size classes, each with its own free list, so a
+// journal that grows or is released is reused by the next hook.
+
+#include "ph_internal.h"
+#include <string.h>
+#include <sys/mman.h>
+
+#define PH_ARENA_NAME_BYTES (PH_MAX_HOOKS * 64)
+#define PH_ARENA_JOURNAL_BYTES (8u << 20)
+#define PH_ARENA_SIZE (PH_ARENA_NAME_BYTES + PH_ARENA_JOURNAL_BYTES)
+
+// Journal classes hold 8, 16, ... 8 << (PH_ARENA_CLASS_COUNT - 1) slots
+#define PH_ARENA_MIN_SLOTS 8
+#define PH_ARENA_CLASS_COUNT 12
+
+_Static_assert(PH_ARENA_NAME_BYTES % sizeof(PHRebindSlot) == 0, "Journal blocks must stay slot aligned");
+
+// A released journal block links to the next free block of its class
+typedef struct PHArenaFreeBlock {
+    struct PHArenaFreeBlock* next;
+} PHArenaFreeBlock;
+
+static uint8_t* g_arena = NULL;
+
+// Guarded by g_hook_mutex
+static size_t g_name_used = 0;
+
+// Guarded by the rebind engine's lock
+static size_t g_journal_used = 0;
+static size_t g_journal_live = 0;
+static PHArenaFreeBlock* g_free_blocks[PH_ARENA_CLASS_COUNT];
+
+PHResult ph_arena_create(void) {
+    if (g_arena != NULL) {
+        return PH_SUCCESS;
+    }
+    void* memory = mmap(NULL, PH_ARENA_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+    if (memory == MAP_FAILED) {
+        return PH_ERROR_MEMORY_ERROR;
+    }
+    g_arena = memory;
+    g_name_used = 0;
+    g_journal_used = 0;
+    g_journal_live = 0;
+    memset(g_free_blocks, 0, sizeof(g_free_blocks));
+    return PH_SUCCESS;
+}
+
+void ph_arena_release(void) {
+    if (g_arena == NULL) {
+        return;
+    }
+#ifdef MADV_FREE
+    madvise(g_arena, PH_ARENA_SIZE, MADV_FREE);
+#else
+    madvise(g_arena, PH_ARENA_SIZE, MADV_DONTNEED);
+#endif
+    g_name_used = 0;
+    g_journal_used = 0;
+    g_journal_live = 0;
+    memset(g_free_blocks, 0, sizeof(g_free_blocks));
+}
+
+const char* ph_arena_intern(const char* name) {
+    size_t length = strlen(name) + 1;
+    if (g_arena == NULL || length > PH_ARENA_NAME_BYTES - g_name_used) {
+        return NULL;
+    }
+    char* copy = (char*)g_arena + g_name_used;
+    memcpy(copy, name, length);
+    g_name_used += length;
+    return copy;
+}
+
+static int ph_arena_class(size_t capacity) {
+    size_t slots = PH_ARENA_MIN_SLOTS;
+    for (int index = 0; index < PH_ARENA_CLASS_COUNT; index++, slots <<= 1) {
+        if (slots == capacity) {
+            return index;
+        }
+    }
+    return -1;
+}
+
+PHRebindSlot* ph_arena_journal_alloc(size_t capacity) {
+    int index = ph_arena_class(capacity);
+    if (g_arena == NULL || index < 0) {
+        return NULL;
+    }
+
+    size_t size = capacity * sizeof(PHRebindSlot);
+    PHArenaFreeBlock* block = g_free_blocks[index];
+    if (block != NULL) {
+        g_free_blocks[index] = block->next;
+    } else {
+        if (size > PH_ARENA_JOURNAL_BYTES - g_journal_used) {
+            return NULL;
+        }
+        block = (PHArenaFreeBlock*)(g_arena + PH_ARENA_NAME_BYTES + g_journal_used);
+        g_journal_used += size;
+    }
+    g_journal_live += size;
+    return (PHRebindSlot*)block;
+}
+
+void ph_arena_journal_free(PHRebindSlot* slots, size_t capacity) {
+    int index = ph_arena_class(capacity);
+    if (slots == NULL || index < 0) {
+        return;
+    }
+    PHArenaFreeBlock* block = (PHArenaFreeBlock*)slots;
+    block->next = g_free_blocks[index];
+    g_free_blocks[index] = block;
+    g_journal_live -= capacity * sizeof(PHRebindSlot);
+}
+
+void ph_get_arena_stats(PHArenaStats* stats) {
+    if (!stats) {
+        return;
+    }
+    // Read without the locks; the counters are only ever approximate
+    // while another thread installs or removes hooks
+    stats->reserved_bytes = g_arena != NULL ? PH_ARENA_SIZE : 0;
+    stats->name_bytes_used = g_name_used;
+    stats->journal_bytes_used = g_journal_used;
+    stats->journal_bytes_live = g_journal_live;
+}
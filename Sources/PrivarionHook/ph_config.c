@@ -0,0 +1,164 @@
+// Configuration Snapshots
+// The spoofed values read by the hooked functions live in immutable,
+// versioned snapshots. Writers build a new snapshot and publish it with a
+// single atomic pointer swap; readers never block. A retired snapshot is
+// freed only after a grace period in which every reader that could still
+// hold it has finished (two-phase epoch counters, as in SRCU).
+
+#include "ph_internal.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+// Reader counters live on separate cache lines so the two epochs do not
+// false-share with each other or with the snapshot pointer
+typedef struct {
+    _Atomic uint32_t count;
+    char padding[64 - sizeof(uint32_t)];
+} PHReaderCounter;
+
+static PHConfigSnapshot g_default_snapshot = {0};
+static _Atomic(PHConfigSnapshot*) g_current_snapshot = &g_default_snapshot;
+static _Atomic uint32_t g_reader_epoch = 0;
+_Atomic uint64_t g_config_generation = 0;
+static PHReaderCounter g_reader_counters[2];
+static pthread_mutex_t g_config_writer_lock = PTHREAD_MUTEX_INITIALIZER;
+
+const PHConfigSnapshot* ph_config_read_begin(uint32_t* token) {
+    uint32_t epoch = atomic_load_explicit(&g_reader_epoch, memory_order_relaxed) & 1;
+    atomic_fetch_add_explicit(&g_reader_counters[epoch].count, 1, memory_order_seq_cst);
+    *token = epoch;
+    return atomic_load_explicit(&g_current_snapshot, memory_order_seq_cst);
+}
+
+void ph_config_read_end(uint32_t token) {
+    atomic_fetch_sub_explicit(&g_reader_counters[token].count, 1, memory_order_release);
+}
+
+uint64_t ph_config_current_version(void) {
+    return atomic_load_explicit(&g_config_generation, memory_order_acquire);
+}
+
+static void ph_config_wait_for_readers(void) {
+    // Flip twice: a reader that sampled the epoch just before the first
+    // flip may register on the old counter after we started waiting on it,
+    // but it will then already see the new snapshot pointer. The second
+    // flip drains readers that entered on the other counter meanwhile.
+    for (int phase = 0; phase < 2; phase++) {
+        uint32_t old_epoch = atomic_fetch_xor_explicit(&g_reader_epoch, 1, memory_order_seq_cst) & 1;
+        while (atomic_load_explicit(&g_reader_counters[old_epoch].count, memory_order_acquire) != 0) {
+            sched_yield();
+        }
+    }
+}
+
+static void ph_config_copy_string(char* destination, const char* source, size_t size) {
+    strncpy(destination, source, size - 1);
+    destination[size - 1] = '\0';
+}
+
+static void ph_config_build_templates(PHConfigSnapshot* snapshot) {
+    const PHookConfigData* data = &snapshot->data;
+    struct utsname* uts = &snapshot->uname_template;
+
+    // Zero-filled copies keep the unused tail of every field deterministic
+    memset(uts, 0, sizeof(*uts));
+    ph_config_copy_string(uts->sysname, data->system_name, sizeof(uts->sysname));
+    ph_config_copy_string(uts->nodename, data->hostname, sizeof(uts->nodename));
+    ph_config_copy_string(uts->release, data->release, sizeof(uts->release));
+    ph_config_copy_string(uts->version, data->version, sizeof(uts->version));
+    ph_config_copy_string(uts->machine, data->machine, sizeof(uts->machine));
+
+    snapshot->hostname_length = strlen(data->hostname);
+}
+
+PHResult ph_config_publish(const PHookConfigData* config_data, uint32_t fields) {
+    if (config_data == NULL) {
+        return PH_ERROR_INVALID_PARAM;
+    }
+
+    PHConfigSnapshot* snapshot = malloc(sizeof(PHConfigSnapshot));
+    if (snapshot == NULL) {
+        return PH_ERROR_MEMORY_ERROR;
+    }
+
+    pthread_mutex_lock(&g_config_writer_lock);
+
+    PHConfigSnapshot* previous = atomic_load_explicit(&g_current_snapshot, memory_order_relaxed);
+    *snapshot = *previous;
+    snapshot->version = previous->version + 1;
+
+    PHookConfigData* data = &snapshot->data;
+    if (fields & PH_CONFIG_FIELD_USER_ID) {
+        data->user_id = config_data->user_id;
+    }
+    if (fields & PH_CONFIG_FIELD_GROUP_ID) {
+        data->group_id = config_data->group_id;
+    }
+    if (fields & PH_CONFIG_FIELD_HOSTNAME) {
+        ph_config_copy_string(data->hostname, config_data->hostname, sizeof(data->hostname));
+    }
+    if (fields & PH_CONFIG_FIELD_SYSTEM_INFO) {
+        ph_config_copy_string(data->system_name, config_data->system_name, sizeof(data->system_name));
+        ph_config_copy_string(data->machine, config_data->machine, sizeof(data->machine));
+        ph_config_copy_string(data->release, config_data->release, sizeof(data->release));
+        ph_config_copy_string(data->version, config_data->version, sizeof(data->version));
+    }
+    ph_config_build_templates(snapshot);
+
+    atomic_store_explicit(&g_current_snapshot, snapshot, memory_order_seq_cst);
+    // Advanced only after the swap, so a reader that sees the new
+    // generation always finds a snapshot at least that new
+    atomic_store_explicit(&g_config_generation, snapshot->version, memory_order_release);
+
+    if (previous != &g_default_snapshot) {
+        ph_config_wait_for_readers();
+        free(previous);
+    }
+
+    pthread_mutex_unlock(&g_config_writer_lock);
+    return PH_SUCCESS;
+}
+
+// The identifier table changes once per session, so it is published by its
+// own pointer rather than copied into every configuration snapshot; readers
+// still use the same read sections and the same grace period
+
+static _Atomic(PHIdentifierTable*) g_identifier_table = NULL;
+
+const PHIdentifierTable* ph_config_identifiers(void) {
+    return atomic_load_explicit(&g_identifier_table, memory_order_seq_cst);
+}
+
+PHIdentifierTable* ph_config_exchange_identifiers(PHIdentifierTable* table) {
+    pthread_mutex_lock(&g_config_writer_lock);
+
+    PHIdentifierTable* previous = atomic_exchange_explicit(&g_identifier_table, table, memory_order_seq_cst);
+    if (previous != NULL) {
+        ph_config_wait_for_readers();
+    }
+
+    pthread_mutex_unlock(&g_config_writer_lock);
+    return previous;
+}
+
+// Fork Safety
+// The writer lock is held across fork, so the child never inherits a
+// half-published snapshot. Threads that were inside a read section do not
+// exist in the child; their registrations would stall its first publish.
+
+void ph_config_fork_prepare(void) {
+    pthread_mutex_lock(&g_config_writer_lock);
+}
+
+void ph_config_fork_parent(void) {
+    pthread_mutex_unlock(&g_config_writer_lock);
+}
+
+void ph_config_fork_child(void) {
+    atomic_store_explicit(&g_reader_counters[0].count, 0, memory_order_relaxed);
+    atomic_store_explicit(&g_reader_counters[1].count, 0, memory_order_relaxed);
+    pthread_mutex_init(&g_config_writer_lock, NULL);
+}
@@ -0,0 +1,617 @@
+// Syscall Event Export
+// Hooked calls are published as fixed-size binary records into a POSIX
+// shared memory region named after the hooked process, so a monitoring
+// process can map it and drain events without any IPC round trip. The
+// region holds a fixed set of lanes; each thread of the hooked process
+// claims one, making every lane a single-producer/single-consumer ring.
+// Producers never block or allocate: a full lane drops the record.
+// The consumer can also compile its rules into a filter inside the region,
+// so calls no rule can match are never published at all.
+
+#include "ph_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define PH_EVENTS_MAGIC 0x50484556u // "PHEV"
+#define PH_EVENTS_LAYOUT_VERSION 5
+#define PH_EVENTS_MAX_HOOKS 64
+#define PH_EVENTS_NAME_SIZE 60
+#define PH_EVENTS_LANE_MASK (PH_EVENTS_LANE_CAPACITY - 1)
+
+_Static_assert(PH_EVENTS_MAX_HOOKS <= PH_MAX_HOOKS, "Event hook slots are indexed by registry slot");
+_Static_assert((PH_EVENTS_LANE_CAPACITY & PH_EVENTS_LANE_MASK) == 0, "Lane capacity must be a power of two");
+_Static_assert(PH_SYSCALL_COUNT <= 64, "Syscall masks are 64 bits wide");
+_Static_assert(PH_EVENTS_FILTER_MAX_RULES <= 64, "Rule masks are 64 bits wide");
+_Static_assert(sizeof(PHEventRecord) == 128, "Event records must fill two cache lines");
+_Static_assert(PH_EVENTS_ARGUMENT_SIZE <= 256, "Argument lengths are stored in one byte");
+
+typedef struct {
+    // Producer and consumer indices on separate cache lines; both sides
+    // live in different processes, so only lock-free 64-bit atomics work
+    _Atomic uint64_t head;
+    char head_padding[64 - sizeof(uint64_t)];
+    _Atomic uint64_t tail;
+    char tail_padding[64 - sizeof(uint64_t)];
+
+    _Atomic uint64_t dropped;
+    _Atomic uint32_t in_use;
+    char state_padding[64 - sizeof(uint64_t) - sizeof(uint32_t)];
+    PHEventRecord records[PH_EVENTS_LANE_CAPACITY];
+} __attribute__((aligned(64))) PHEventLane;
+
+// Same publication protocol as the statistics hook table: hook_id is
+// cleared while the name is rewritten
+typedef struct {
+    _Atomic uint32_t hook_id;
+    char function_name[PH_EVENTS_NAME_SIZE];
+} PHEventHookInfo;
+
+_Static_assert(sizeof(PHEventHookInfo) == 64, "Hook info must occupy one cache line");
+
+// Path-prefix trie node; the rule masks name the rules whose allowed or
+// blocked prefix ends here, and the children are edges[first_edge...]
+// sorted by byte
+typedef struct {
+    uint64_t allowed_rules;
+    uint64_t blocked_rules;
+    uint32_t first_edge;
+    uint32_t edge_count;
+} PHEventFilterNode;
+
+typedef struct {
+    uint32_t child;
+    uint8_t byte;
+    uint8_t padding[3];
+} PHEventFilterEdge;
+
+// Written only by the consumer. `sequence` is odd while the trie is being
+// rewritten; a producer that sees it change publishes the call rather than
+// trusting a torn read. Calls without a path only need syscall_mask.
+typedef struct {
+    _Atomic uint32_t sequence;
+    _Atomic uint32_t active;
+    _Atomic uint64_t syscall_mask;
+    uint64_t syscall_rules[PH_SYSCALL_COUNT];
+    uint64_t unrestricted_rules;
+    uint32_t node_count;
+    uint32_t reserved;
+    PHEventFilterNode nodes[PH_EVENTS_FILTER_MAX_NODES];
+    PHEventFilterEdge edges[PH_EVENTS_FILTER_MAX_NODES];
+} PHEventFilter;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t layout_version;
+    uint32_t lane_count;
+    uint32_t lane_capacity;
+    uint32_t record_size;
+    uint32_t max_hooks;
+    int32_t pid;
+    uint32_t reserved;
+    // Records from threads that found every lane taken
+    _Atomic uint64_t unlaned_dropped;
+    char header_padding[24];
+    PHEventHookInfo hooks[PH_EVENTS_MAX_HOOKS];
+    PHEventFilter filter __attribute__((aligned(64)));
+    PHEventLane lanes[PH_EVENTS_LANES];
+} PHEventRegion;
+
+_Static_assert(offsetof(PHEventRegion, hooks) == 64, "Header must occupy one cache line");
+_Static_assert(offsetof(PHEventRegion, lanes) % 64 == 0, "Lanes must start on a cache line");
+
+struct PHEventView {
+    PHEventRegion* region;
+};
+
+_Atomic bool g_events_enabled = false;
+
+static PHEventRegion* g_event_region = NULL;
+static char g_event_region_name[32];
+static __thread PHEventLane* t_event_lane = NULL;
+static __thread uint64_t t_event_thread_id = 0;
+static pthread_key_t g_event_lane_key;
+static pthread_once_t g_event_key_once = PTHREAD_ONCE_INIT;
+
+static void ph_events_region_name(pid_t pid, char* buffer, size_t size) {
+    // Darwin limits shared memory names to 31 characters
+    snprintf(buffer, size, "/privarion.ev.%d", (int)pid);
+}
+
+static void ph_events_thread_exit(void* lane) {
+    atomic_store_explicit(&((PHEventLane*)lane)->in_use, 0, memory_order_release);
+}
+
+static void ph_events_create_key(void) {
+    pthread_key_create(&g_event_lane_key, ph_events_thread_exit);
+}
+
+PHResult ph_events_create_region(void) {
+    if (g_event_region != NULL) {
+        return PH_SUCCESS;
+    }
+
+    pid_t pid = getpid();
+    ph_events_region_name(pid, g_event_region_name, sizeof(g_event_region_name));
+
+    // A region left by an earlier process with the same PID is stale
+    shm_unlink(g_event_region_name);
+    int fd = shm_open(g_event_region_name, O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+    if (fd < 0) {
+        return PH_ERROR_PERMISSION_DENIED;
+    }
+    if (ftruncate(fd, (off_t)sizeof(PHEventRegion)) != 0) {
+        close(fd);
+        shm_unlink(g_event_region_name);
+        return PH_ERROR_MEMORY_ERROR;
+    }
+
+    void* memory = mmap(NULL, sizeof(PHEventRegion), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        shm_unlink(g_event_region_name);
+        return PH_ERROR_MEMORY_ERROR;
+    }
+
+    // The mapping starts zero-filled; only the header needs writing
+    PHEventRegion* region = memory;
+    region->layout_version = PH_EVENTS_LAYOUT_VERSION;
+    region->lane_count = PH_EVENTS_LANES;
+    region->lane_capacity = PH_EVENTS_LANE_CAPACITY;
+    region->record_size = sizeof(PHEventRecord);
+    region->max_hooks = PH_EVENTS_MAX_HOOKS;
+    region->pid = (int32_t)pid;
+    atomic_thread_fence(memory_order_release);
+    region->magic = PH_EVENTS_MAGIC;
+
+    pthread_once(&g_event_key_once, ph_events_create_key);
+    g_event_region = region;
+    atomic_store_explicit(&g_events_enabled, true, memory_order_release);
+    return PH_SUCCESS;
+}
+
+void ph_events_hook_activated(const PHookEntry* entry) {
+    uint32_t index = entry->id & ((1u << PH_HOOK_INDEX_BITS) - 1);
+    if (g_event_region == NULL || index >= PH_EVENTS_MAX_HOOKS) {
+        return;
+    }
+
+    PHEventHookInfo* info = &g_event_region->hooks[index];
+    atomic_store_explicit(&info->hook_id, 0, memory_order_release);
+    strncpy(info->function_name, entry->function_name, sizeof(info->function_name) - 1);
+    info->function_name[sizeof(info->function_name) - 1] = '\0';
+    atomic_store_explicit(&info->hook_id, entry->id, memory_order_release);
+}
+
+void ph_events_hook_released(const PHookEntry* entry) {
+    uint32_t index = entry->id & ((1u << PH_HOOK_INDEX_BITS) - 1);
+    if (g_event_region == NULL || index >= PH_EVENTS_MAX_HOOKS) {
+        return;
+    }
+    atomic_store_explicit(&g_event_region->hooks[index].hook_id, 0, memory_order_release);
+}
+
+static PHEventLane* ph_events_claim_lane(PHEventRegion* region) {
+    for (uint32_t i = 0; i < PH_EVENTS_LANES; i++) {
+        PHEventLane* lane = &region->lanes[i];
+        uint32_t expected = 0;
+        if (atomic_load_explicit(&lane->in_use, memory_order_relaxed) == 0 &&
+            atomic_compare_exchange_strong(&lane->in_use, &expected, 1)) {
+            pthread_setspecific(g_event_lane_key, lane);
+            t_event_thread_id = ph_current_thread_id();
+            return lane;
+        }
+    }
+    return NULL;
+}
+
+static bool ph_events_filter_path(const PHEventFilter* filter, uint64_t candidates, const char* path) {
+    uint32_t node_count = filter->node_count;
+    if (node_count == 0 || node_count > PH_EVENTS_FILTER_MAX_NODES) {
+        return true;
+    }
+
+    // Collect the rules of every prefix the path runs through
+    const PHEventFilterNode* node = &filter->nodes[0];
+    uint64_t allowed = node->allowed_rules;
+    uint64_t blocked = node->blocked_rules;
+    for (const unsigned char* cursor = (const unsigned char*)path; *cursor != '\0'; cursor++) {
+        uint32_t low = node->first_edge;
+        uint32_t high = low + node->edge_count;
+        if (high > PH_EVENTS_FILTER_MAX_NODES) {
+            return true;
+        }
+        while (low < high) {
+            uint32_t middle = low + (high - low) / 2;
+            if (filter->edges[middle].byte < *cursor) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        if (low == node->first_edge + node->edge_count || filter->edges[low].byte != *cursor ||
+            filter->edges[low].child >= node_count) {
+            break;
+        }
+        node = &filter->nodes[filter->edges[low].child];
+        allowed |= node->allowed_rules;
+        blocked |= node->blocked_rules;
+    }
+
+    return (candidates & (filter->unrestricted_rules | allowed) & ~blocked) != 0;
+}
+
+// Only the argument bytes are written; the terminator bounds what the
+// consumer reads of a reused slot
+static void ph_events_copy_argument(PHEventRecord* record, const char* argument, bool is_path) {
+    record->flags = 0;
+    if (argument == NULL) {
+        record->argument_length = 0;
+        record->argument[0] = '\0';
+        return;
+    }
+
+    size_t length = strnlen(argument, PH_EVENTS_ARGUMENT_SIZE);
+    if (length == PH_EVENTS_ARGUMENT_SIZE) {
+        length = PH_EVENTS_ARGUMENT_SIZE - 1;
+        record->flags |= PH_EVENT_ARGUMENT_TRUNCATED;
+    }
+    if (is_path) {
+        record->flags |= PH_EVENT_ARGUMENT_IS_PATH;
+    }
+    memcpy(record->argument, argument, length);
+    record->argument[length] = '\0';
+    record->argument_length = (uint8_t)length;
+}
+
+static bool ph_events_filter_accepts(const PHEventFilter* filter, PHSyscallId syscall, const char* path) {
+    if (atomic_load_explicit(&filter->active, memory_order_acquire) == 0 || (unsigned)syscall >= PH_SYSCALL_COUNT) {
+        return true;
+    }
+    if ((atomic_load_explicit(&filter->syscall_mask, memory_order_relaxed) & (1ull << syscall)) == 0) {
+        return false;
+    }
+    if (path == NULL) {
+        return true;
+    }
+
+    uint32_t sequence = atomic_load_explicit(&filter->sequence, memory_order_acquire);
+    if (sequence & 1) {
+        return true;
+    }
+    bool accepted = ph_events_filter_path(filter, filter->syscall_rules[syscall], path);
+    atomic_thread_fence(memory_order_acquire);
+    return accepted || atomic_load_explicit(&filter->sequence, memory_order_relaxed) != sequence;
+}
+
+void ph_events_emit(PHSyscallId syscall, uint32_t hook_id, const char* path, const char* argument,
+                    int64_t return_value) {
+    if (hook_id == 0) {
+        return;
+    }
+    PHEventRegion* region = g_event_region;
+    if (region == NULL || !ph_events_filter_accepts(&region->filter, syscall, path)) {
+        return;
+    }
+
+    PHEventLane* lane = t_event_lane;
+    if (lane == NULL) {
+        // Threads without a lane retry on every call, so they pick one up
+        // as soon as another thread exits
+        lane = t_event_lane = ph_events_claim_lane(region);
+        if (lane == NULL) {
+            atomic_fetch_add_explicit(&region->unlaned_dropped, 1, memory_order_relaxed);
+            return;
+        }
+    }
+
+    uint64_t head = atomic_load_explicit(&lane->head, memory_order_relaxed);
+    uint64_t tail = atomic_load_explicit(&lane->tail, memory_order_acquire);
+    if (head - tail >= PH_EVENTS_LANE_CAPACITY) {
+        atomic_fetch_add_explicit(&lane->dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    PHEventRecord* record = &lane->records[head & PH_EVENTS_LANE_MASK];
+    record->timestamp_ns = ph_now_ns();
+    record->thread_id = t_event_thread_id;
+    record->return_value = return_value;
+    record->hook_id = hook_id;
+    record->syscall = (uint16_t)syscall;
+    ph_events_copy_argument(record, path != NULL ? path : argument, path != NULL);
+    atomic_store_explicit(&lane->head, head + 1, memory_order_release);
+}
+
+// Injected processes opt in through the environment set by the launcher
+__attribute__((constructor))
+static void ph_events_load(void) {
+    const char* flag = getenv(PH_EVENTS_ENV);
+    if (flag != NULL && strcmp(flag, "1") == 0) {
+        ph_events_enable();
+    }
+}
+
+// The region name is derived from the PID, so it must not outlive the
+// process; a consumer that already mapped it keeps draining its copy
+__attribute__((destructor))
+static void ph_events_destroy_region(void) {
+    if (g_event_region != NULL) {
+        shm_unlink(g_event_region_name);
+    }
+}
+
+// The child of a fork starts an empty region under its own PID; the
+// consumer's filter stays with the parent. The caller republishes the
+// live hooks (g_hook_mutex held).
+void ph_events_fork_child(void) {
+    if (g_event_region == NULL) {
+        return;
+    }
+    atomic_store_explicit(&g_events_enabled, false, memory_order_relaxed);
+    munmap(g_event_region, sizeof(PHEventRegion));
+    g_event_region = NULL;
+    t_event_lane = NULL;
+    ph_events_create_region();
+}
+
+// Consumer Interface
+
+PHResult ph_events_open(pid_t pid, PHEventView** view) {
+    if (view == NULL || pid <= 0) {
+        return PH_ERROR_INVALID_PARAM;
+    }
+
+    char name[32];
+    ph_events_region_name(pid, name, sizeof(name));
+    int fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0) {
+        return PH_ERROR_NOT_HOOKED;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(PHEventRegion)) {
+        close(fd);
+        return PH_ERROR_NOT_HOOKED;
+    }
+
+    // The consumer owns the tail indices, so the mapping is writable
+    void* memory = mmap(NULL, sizeof(PHEventRegion), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        return PH_ERROR_PERMISSION_DENIED;
+    }
+
+    PHEventRegion* region = memory;
+    if (region->magic != PH_EVENTS_MAGIC || region->layout_version != PH_EVENTS_LAYOUT_VERSION ||
+        region->lane_count != PH_EVENTS_LANES || region->lane_capacity != PH_EVENTS_LANE_CAPACITY ||
+        region->record_size != sizeof(PHEventRecord) || region->max_hooks != PH_EVENTS_MAX_HOOKS) {
+        munmap(memory, sizeof(PHEventRegion));
+        return PH_ERROR_UNSUPPORTED_PLATFORM;
+    }
+    atomic_thread_fence(memory_order_acquire);
+
+    PHEventView* result = malloc(sizeof(PHEventView));
+    if (result == NULL) {
+        munmap(memory, sizeof(PHEventRegion));
+        return PH_ERROR_MEMORY_ERROR;
+    }
+    result->region = region;
+    *view = result;
+    return PH_SUCCESS;
+}
+
+size_t ph_events_drain(PHEventView* view, PHEventRecord* records, size_t capacity) {
+    if (view == NULL || records == NULL || capacity == 0) {
+        return 0;
+    }
+
+    size_t drained = 0;
+    PHEventRegion* region = view->region;
+    for (uint32_t i = 0; i < PH_EVENTS_LANES && drained < capacity; i++) {
+        PHEventLane* lane = &region->lanes[i];
+        uint64_t tail = atomic_load_explicit(&lane->tail, memory_order_relaxed);
+        uint64_t head = atomic_load_explicit(&lane->head, memory_order_acquire);
+        if (tail == head) {
+            continue;
+        }
+
+        // Copy in at most two contiguous runs instead of record by record
+        uint64_t available = head - tail;
+        size_t count = available < capacity - drained ? (size_t)available : capacity - drained;
+        size_t start = (size_t)(tail & PH_EVENTS_LANE_MASK);
+        size_t first = count < PH_EVENTS_LANE_CAPACITY - start ? count : PH_EVENTS_LANE_CAPACITY - start;
+        memcpy(&records[drained], &lane->records[start], first * sizeof(PHEventRecord));
+        memcpy(&records[drained + first], &lane->records[0], (count - first) * sizeof(PHEventRecord));
+        drained += count;
+        atomic_store_explicit(&lane->tail, tail + count, memory_order_release);
+    }
+    return drained;
+}
+
+bool ph_events_hook_name(const PHEventView* view, uint32_t hook_id, char* buffer, size_t buffer_size) {
+    uint32_t index = hook_id & ((1u << PH_HOOK_INDEX_BITS) - 1);
+    if (view == NULL || buffer == NULL || buffer_size == 0 || hook_id == 0 || index >= PH_EVENTS_MAX_HOOKS) {
+        return false;
+    }
+
+    PHEventHookInfo* info = &view->region->hooks[index];
+    if (atomic_load_explicit(&info->hook_id, memory_order_acquire) != hook_id) {
+        return false;
+    }
+
+    size_t length = strnlen(info->function_name, sizeof(info->function_name));
+    if (length >= buffer_size) {
+        length = buffer_size - 1;
+    }
+    memcpy(buffer, info->function_name, length);
+    buffer[length] = '\0';
+
+    // The slot was reassigned while we copied the name
+    return atomic_load_explicit(&info->hook_id, memory_order_acquire) == hook_id;
+}
+
+uint64_t ph_events_dropped_count(const PHEventView* view) {
+    if (view == NULL) {
+        return 0;
+    }
+
+    PHEventRegion* region = view->region;
+    uint64_t dropped = atomic_load_explicit(&region->unlaned_dropped, memory_order_relaxed);
+    for (uint32_t i = 0; i < PH_EVENTS_LANES; i++) {
+        dropped += atomic_load_explicit(&region->lanes[i].dropped, memory_order_relaxed);
+    }
+    return dropped;
+}
+
+// Filter Compilation
+
+// Build-time trie node; children form a sorted sibling list
+typedef struct {
+    uint64_t allowed_rules;
+    uint64_t blocked_rules;
+    uint32_t first_child;
+    uint32_t next_sibling;
+    uint8_t byte;
+} PHFilterBuildNode;
+
+#define PH_FILTER_NO_NODE UINT32_MAX
+
+typedef struct {
+    PHFilterBuildNode nodes[PH_EVENTS_FILTER_MAX_NODES];
+    uint32_t count;
+} PHFilterBuilder;
+
+static bool ph_filter_insert(PHFilterBuilder* builder, const char* prefix, uint64_t rule_bit, bool blocked) {
+    uint32_t node = 0;
+    for (const unsigned char* cursor = (const unsigned char*)prefix; *cursor != '\0'; cursor++) {
+        uint32_t* link = &builder->nodes[node].first_child;
+        while (*link != PH_FILTER_NO_NODE && builder->nodes[*link].byte < *cursor) {
+            link = &builder->nodes[*link].next_sibling;
+        }
+        if (*link == PH_FILTER_NO_NODE || builder->nodes[*link].byte != *cursor) {
+            if (builder->count == PH_EVENTS_FILTER_MAX_NODES) {
+                return false;
+            }
+            uint32_t created = builder->count++;
+            builder->nodes[created] = (PHFilterBuildNode){
+                .first_child = PH_FILTER_NO_NODE,
+                .next_sibling = *link,
+                .byte = *cursor,
+            };
+            *link = created;
+        }
+        node = *link;
+    }
+
+    if (blocked) {
+        builder->nodes[node].blocked_rules |= rule_bit;
+    } else {
+        builder->nodes[node].allowed_rules |= rule_bit;
+    }
+    return true;
+}
+
+// Lay the trie out breadth-first so every node's children are contiguous
+static void ph_filter_flatten(const PHFilterBuilder* builder, PHEventFilter* filter) {
+    uint32_t order[PH_EVENTS_FILTER_MAX_NODES];
+    uint32_t placed = 1;
+    uint32_t edges = 0;
+    order[0] = 0;
+
+    for (uint32_t index = 0; index < placed; index++) {
+        const PHFilterBuildNode* source = &builder->nodes[order[index]];
+        PHEventFilterNode* target = &filter->nodes[index];
+        target->allowed_rules = source->allowed_rules;
+        target->blocked_rules = source->blocked_rules;
+        target->first_edge = edges;
+        target->edge_count = 0;
+        for (uint32_t child = source->first_child; child != PH_FILTER_NO_NODE; child = builder->nodes[child].next_sibling) {
+            filter->edges[edges].byte = builder->nodes[child].byte;
+            filter->edges[edges].child = placed;
+            order[placed++] = child;
+            edges++;
+            target->edge_count++;
+        }
+    }
+    filter->node_count = placed;
+}
+
+PHResult ph_events_set_filter(PHEventView* view, const PHEventFilterRule* rules, size_t count) {
+    if (view == NULL || (rules == NULL && count > 0) || count > PH_EVENTS_FILTER_MAX_RULES) {
+        return PH_ERROR_INVALID_PARAM;
+    }
+
+    PHFilterBuilder* builder = malloc(sizeof(PHFilterBuilder));
+    if (builder == NULL) {
+        return PH_ERROR_MEMORY_ERROR;
+    }
+    builder->nodes[0] = (PHFilterBuildNode){ .first_child = PH_FILTER_NO_NODE, .next_sibling = PH_FILTER_NO_NODE };
+    builder->count = 1;
+
+    uint64_t syscall_mask = 0;
+    uint64_t unrestricted_rules = 0;
+    uint64_t syscall_rules[PH_SYSCALL_COUNT] = { 0 };
+    for (size_t i = 0; i < count; i++) {
+        const PHEventFilterRule* rule = &rules[i];
+        uint64_t rule_bit = 1ull << i;
+        for (uint32_t syscall = 0; syscall < PH_SYSCALL_COUNT; syscall++) {
+            if (rule->syscall_mask & (1ull << syscall)) {
+                syscall_rules[syscall] |= rule_bit;
+                syscall_mask |= 1ull << syscall;
+            }
+        }
+        if (rule->allowed_count == 0) {
+            unrestricted_rules |= rule_bit;
+        }
+        for (size_t j = 0; j < rule->allowed_count; j++) {
+            if (rule->allowed_prefixes[j] != NULL && !ph_filter_insert(builder, rule->allowed_prefixes[j], rule_bit, false)) {
+                free(builder);
+                return PH_ERROR_MEMORY_ERROR;
+            }
+        }
+        for (size_t j = 0; j < rule->blocked_count; j++) {
+            if (rule->blocked_prefixes[j] != NULL && !ph_filter_insert(builder, rule->blocked_prefixes[j], rule_bit, true)) {
+                free(builder);
+                return PH_ERROR_MEMORY_ERROR;
+            }
+        }
+    }
+
+    PHEventFilter* filter = &view->region->filter;
+    uint32_t sequence = atomic_load_explicit(&filter->sequence, memory_order_relaxed);
+    atomic_store_explicit(&filter->sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    ph_filter_flatten(builder, filter);
+    memcpy(filter->syscall_rules, syscall_rules, sizeof(syscall_rules));
+    filter->unrestricted_rules = unrestricted_rules;
+    atomic_store_explicit(&filter->syscall_mask, syscall_mask, memory_order_relaxed);
+    atomic_store_explicit(&filter->active, 1, memory_order_relaxed);
+    atomic_store_explicit(&filter->sequence, sequence + 2, memory_order_release);
+
+    free(builder);
+    return PH_SUCCESS;
+}
+
+void ph_events_clear_filter(PHEventView* view) {
+    if (view != NULL) {
+        atomic_store_explicit(&view->region->filter.active, 0, memory_order_release);
+    }
+}
+
+bool ph_events_filter_matches(const PHEventView* view, PHSyscallId syscall, const char* path) {
+    return view != NULL && ph_events_filter_accepts(&view->region->filter, syscall, path);
+}
+
+void ph_events_close(PHEventView* view) {
+    if (view == NULL) {
+        return;
+    }
+    munmap(view->region, sizeof(PHEventRegion));
+    free(view);
+}
@@ -0,0 +1,344 @@
+// Hardware Identifiers
+// Fingerprinting code reads machine identifiers through sysctlbyname() and
+// the I/O Registry. The launcher generates one set of spoofed values per
+// session and the library keeps them in a table sorted by key hash, so a
+// hooked call costs a length-mask test, one hash and a binary search; keys
+// of a length the table does not hold pass through after the mask test.
+
+#include "ph_internal.h"
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __APPLE__
+#include <CoreFoundation/CoreFoundation.h>
+#endif
+
+_Atomic uint64_t g_identifier_length_masks[PH_IDENTIFIER_SOURCE_COUNT];
+
+// Serialises publishers so the length masks follow the table they describe
+static pthread_mutex_t g_identifier_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Identifier with an explicit key length; file keys are not terminated
+typedef struct {
+    uint32_t source;
+    uint32_t kind;
+    const char* key;
+    size_t key_length;
+    const void* value;
+    size_t value_length;
+} PHIdentifierInput;
+
+uint32_t ph_identifier_hash(const char* key, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)key[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static int ph_identifier_compare(uint32_t source, uint32_t hash, const char* key, size_t length,
+                                 const PHIdentifierEntry* entry) {
+    if (source != entry->source) {
+        return source < entry->source ? -1 : 1;
+    }
+    if (hash != entry->key_hash) {
+        return hash < entry->key_hash ? -1 : 1;
+    }
+    size_t shorter = length < entry->key_length ? length : entry->key_length;
+    int order = memcmp(key, entry->key, shorter);
+    if (order == 0) {
+        order = (length > entry->key_length) - (length < entry->key_length);
+    }
+    return order;
+}
+
+static int ph_identifier_entry_order(const void* left, const void* right) {
+    const PHIdentifierEntry* entry = left;
+    return ph_identifier_compare(entry->source, entry->key_hash, entry->key, entry->key_length, right);
+}
+
+const PHIdentifierEntry* ph_identifiers_find(const PHIdentifierTable* table, PHIdentifierSource source,
+                                             const char* key, size_t length) {
+    if (table == NULL) {
+        return NULL;
+    }
+
+    uint32_t hash = ph_identifier_hash(key, length);
+    size_t low = 0;
+    size_t high = table->count;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        int order = ph_identifier_compare(source, hash, key, length, &table->entries[middle]);
+        if (order == 0) {
+            return &table->entries[middle];
+        }
+        if (order < 0) {
+            high = middle;
+        } else {
+            low = middle + 1;
+        }
+    }
+    return NULL;
+}
+
+static void ph_identifiers_free(PHIdentifierTable* table) {
+    if (table == NULL) {
+        return;
+    }
+#ifdef __APPLE__
+    for (size_t i = 0; i < table->count; i++) {
+        if (table->entries[i].object != NULL) {
+            CFRelease(table->entries[i].object);
+        }
+    }
+#endif
+    free(table);
+}
+
+// Registry callers receive a retained reference to a prebuilt object, so
+// spoofed properties are never converted on the hot path
+static bool ph_identifiers_build_object(PHIdentifierEntry* entry) {
+#ifdef __APPLE__
+    if (entry->source != PH_IDENTIFIER_IOREGISTRY) {
+        return true;
+    }
+    if (entry->kind == PH_IDENTIFIER_STRING) {
+        entry->object = CFStringCreateWithBytes(kCFAllocatorDefault, entry->value, (CFIndex)entry->value_length - 1,
+                                                kCFStringEncodingUTF8, false);
+    } else {
+        entry->object = CFDataCreate(kCFAllocatorDefault, entry->value, (CFIndex)entry->value_length);
+    }
+    return entry->object != NULL;
+#else
+    (void)entry;
+    return true;
+#endif
+}
+
+static PHResult ph_identifiers_build(const PHIdentifierInput* inputs, size_t count, PHIdentifierTable** output) {
+    // Keys and values share one allocation with the entries; every copy is
+    // terminated so string values can be handed out as is
+    size_t bytes = 0;
+    for (size_t i = 0; i < count; i++) {
+        const PHIdentifierInput* input = &inputs[i];
+        if (input->source >= PH_IDENTIFIER_SOURCE_COUNT ||
+            (input->kind != PH_IDENTIFIER_STRING && input->kind != PH_IDENTIFIER_DATA) ||
+            input->key == NULL || input->key_length == 0 || input->key_length > PH_IDENTIFIERS_MAX_KEY_LENGTH ||
+            (input->value == NULL && input->value_length > 0) || input->value_length > PH_IDENTIFIERS_MAX_VALUE_LENGTH) {
+            return PH_ERROR_INVALID_PARAM;
+        }
+        bytes += input->key_length + 1 + input->value_length + 1;
+    }
+
+    size_t header_size = sizeof(PHIdentifierTable) + count * sizeof(PHIdentifierEntry);
+    PHIdentifierTable* table = calloc(1, header_size + bytes);
+    if (table == NULL) {
+        return PH_ERROR_MEMORY_ERROR;
+    }
+
+    char* cursor = (char*)table + header_size;
+    for (size_t i = 0; i < count; i++) {
+        const PHIdentifierInput* input = &inputs[i];
+        PHIdentifierEntry* entry = &table->entries[i];
+
+        memcpy(cursor, input->key, input->key_length);
+        entry->key = cursor;
+        cursor += input->key_length + 1;
+        if (input->value_length > 0) {
+            memcpy(cursor, input->value, input->value_length);
+        }
+        entry->value = cursor;
+        cursor += input->value_length + 1;
+
+        entry->source = (uint16_t)input->source;
+        entry->kind = (uint16_t)input->kind;
+        entry->key_length = (uint32_t)input->key_length;
+        entry->value_length = (uint32_t)input->value_length + (input->kind == PH_IDENTIFIER_STRING ? 1 : 0);
+        entry->key_hash = ph_identifier_hash(entry->key, entry->key_length);
+        table->count = i + 1;
+
+        if (!ph_identifiers_build_object(entry)) {
+            ph_identifiers_free(table);
+            return PH_ERROR_MEMORY_ERROR;
+        }
+
+        size_t length = entry->key_length < 63 ? entry->key_length : 63;
+        table->length_masks[entry->source] |= 1ull << length;
+    }
+
+    qsort(table->entries, count, sizeof(PHIdentifierEntry), ph_identifier_entry_order);
+    for (size_t i = 1; i < count; i++) {
+        if (ph_identifier_entry_order(&table->entries[i - 1], &table->entries[i]) == 0) {
+            ph_identifiers_free(table);
+            return PH_ERROR_INVALID_PARAM;
+        }
+    }
+
+    *output = table;
+    return PH_SUCCESS;
+}
+
+static PHResult ph_identifiers_publish(const PHIdentifierInput* inputs, size_t count) {
+    if (count > PH_IDENTIFIERS_MAX_ENTRIES) {
+        return PH_ERROR_INVALID_PARAM;
+    }
+
+    PHIdentifierTable* table = NULL;
+    if (count > 0) {
+        PHResult result = ph_identifiers_build(inputs, count, &table);
+        if (result != PH_SUCCESS) {
+            return result;
+        }
+    }
+
+    pthread_mutex_lock(&g_identifier_lock);
+
+    // Widen the masks before the swap and narrow them after it; a call
+    // racing the publish at worst passes through once
+    for (int source = 0; source < PH_IDENTIFIER_SOURCE_COUNT; source++) {
+        uint64_t mask = table != NULL ? table->length_masks[source] : 0;
+        atomic_fetch_or_explicit(&g_identifier_length_masks[source], mask, memory_order_relaxed);
+    }
+    PHIdentifierTable* previous = ph_config_exchange_identifiers(table);
+    for (int source = 0; source < PH_IDENTIFIER_SOURCE_COUNT; source++) {
+        uint64_t mask = table != NULL ? table->length_masks[source] : 0;
+        atomic_store_explicit(&g_identifier_length_masks[source], mask, memory_order_relaxed);
+    }
+
+    pthread_mutex_unlock(&g_identifier_lock);
+
+    ph_identifiers_free(previous);
+    return PH_SUCCESS;
+}
+
+PHResult ph_set_identifiers(const PHIdentifierSpec* specs, size_t count) {
+    if ((specs == NULL && count > 0) || count > PH_IDENTIFIERS_MAX_ENTRIES) {
+        return PH_ERROR_INVALID_PARAM;
+    }
+
+    PHIdentifierInput inputs[count > 0 ? count : 1];
+    for (size_t i = 0; i < count; i++) {
+        inputs[i] = (PHIdentifierInput){
+            .source = (uint32_t)specs[i].source,
+            .kind = (uint32_t)specs[i].kind,
+            .key = specs[i].key,
+            .key_length = specs[i].key != NULL ? strnlen(specs[i].key, PH_IDENTIFIERS_MAX_KEY_LENGTH + 1) : 0,
+            .value = specs[i].value,
+            .value_length = specs[i].value_length
+        };
+    }
+    return ph_identifiers_publish(inputs, count);
+}
+
+size_t ph_get_identifier_count(void) {
+    uint32_t token;
+    ph_config_read_begin(&token);
+    const PHIdentifierTable* table = ph_config_identifiers();
+    size_t count = table != NULL ? table->count : 0;
+    ph_config_read_end(token);
+    return count;
+}
+
+static bool ph_identifiers_validate(const uint8_t* base, size_t size) {
+    if (size < sizeof(PHIdentifierHeader)) {
+        return false;
+    }
+
+    const PHIdentifierHeader* header = (const PHIdentifierHeader*)base;
+    if (header->magic != PH_IDENTIFIERS_MAGIC || header->format_version != PH_IDENTIFIERS_FORMAT_VERSION ||
+        header->record_size != sizeof(PHIdentifierRecord) || header->entry_count > PH_IDENTIFIERS_MAX_ENTRIES) {
+        return false;
+    }
+
+    uint64_t records_end = sizeof(PHIdentifierHeader) + (uint64_t)header->entry_count * sizeof(PHIdentifierRecord);
+    uint64_t bytes_end = (uint64_t)header->byte_table_offset + header->byte_table_size;
+    if (records_end > header->byte_table_offset || bytes_end > size) {
+        return false;
+    }
+
+    // Every key and value must lie inside the byte table
+    const PHIdentifierRecord* records = (const PHIdentifierRecord*)(base + sizeof(PHIdentifierHeader));
+    for (uint32_t i = 0; i < header->entry_count; i++) {
+        if ((uint64_t)records[i].key_offset + records[i].key_length > header->byte_table_size ||
+            (uint64_t)records[i].value_offset + records[i].value_length > header->byte_table_size) {
+            return false;
+        }
+    }
+    return true;
+}
+
+PHResult ph_load_identifiers(const char* path) {
+    if (path == NULL) {
+        return PH_ERROR_INVALID_PARAM;
+    }
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return PH_ERROR_PERMISSION_DENIED;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close(fd);
+        return PH_ERROR_INVALID_PARAM;
+    }
+
+    size_t size = (size_t)info.st_size;
+    void* memory = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        return PH_ERROR_MEMORY_ERROR;
+    }
+
+    PHResult result = PH_ERROR_INVALID_PARAM;
+    const uint8_t* base = memory;
+    if (ph_identifiers_validate(base, size)) {
+        const PHIdentifierHeader* header = (const PHIdentifierHeader*)base;
+        const PHIdentifierRecord* records = (const PHIdentifierRecord*)(base + sizeof(PHIdentifierHeader));
+        const uint8_t* bytes = base + header->byte_table_offset;
+
+        // The table copies everything, so the mapping can go right after
+        PHIdentifierInput inputs[header->entry_count > 0 ? header->entry_count : 1];
+        for (uint32_t i = 0; i < header->entry_count; i++) {
+            inputs[i] = (PHIdentifierInput){
+                .source = records[i].source,
+                .kind = records[i].kind,
+                .key = (const char*)bytes + records[i].key_offset,
+                .key_length = records[i].key_length,
+                .value = bytes + records[i].value_offset,
+                .value_length = records[i].value_length
+            };
+        }
+        result = ph_identifiers_publish(inputs, header->entry_count);
+    }
+    munmap(memory, size);
+    return result;
+}
+
+// Injected processes find their identifier table through the environment
+__attribute__((constructor))
+static void ph_identifiers_load_from_environment(void) {
+    const char* path = getenv(PH_IDENTIFIERS_PATH_ENV);
+    if (path != NULL && *path != '\0') {
+        ph_load_identifiers(path);
+    }
+}
+
+// Fork Safety
+
+void ph_identifiers_fork_prepare(void) {
+    pthread_mutex_lock(&g_identifier_lock);
+}
+
+void ph_identifiers_fork_parent(void) {
+    pthread_mutex_unlock(&g_identifier_lock);
+}
+
+void ph_identifiers_fork_child(void) {
+    pthread_mutex_init(&g_identifier_lock, NULL);
+}
@@ -0,0 +1,489 @@
+#ifndef PRIVARION_HOOK_INTERNAL_H
+#define PRIVARION_HOOK_INTERNAL_H
+
+// Internal declarations shared between the PrivarionHook translation units.
+// Nothing in this header is part of the public Swift-visible interface.
+
+#include "include/privarion_hook.h"
+#include <stddef.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <sys/utsname.h>
+
+// Symbol Rebinding Engine (ph_rebind.c)
+
+/**
+ * A single pointer slot that has been redirected to a replacement.
+ * `previous` is the value the slot held before patching and is written
+ * back when the rebinding is detached.
+ */
+typedef struct {
+    void** address;
+    void* previous;
+    const void* image;
+    bool read_only;
+    bool authenticated;
+} PHRebindSlot;
+
+/**
+ * Rebinding request for one symbol.
+ * `name` is the C symbol name without the Mach-O leading underscore.
+ * The slot journal is owned by the rebinding engine, allocated from the
+ * hook arena, and must only be touched through the ph_rebind_* functions.
+ */
+typedef struct {
+    const char* name;
+    void* replacement;
+    PHRebindSlot* slots;
+    size_t slot_count;
+    size_t slot_capacity;
+} PHRebinding;
+
+/**
+ * Activate rebindings and patch every currently loaded image in one walk.
+ * Images loaded afterwards are patched from the dyld add-image callback.
+ * @param rebindings Rebindings to activate (caller keeps ownership)
+ * @param count Number of rebindings
+ * @return PH_SUCCESS on success, error code on failure
+ */
+PHResult ph_rebind_attach(PHRebinding* const* rebindings, size_t count);
+
+/**
+ * Restore every slot patched for the given rebindings and deactivate them.
+ * @param rebindings Rebindings previously passed to ph_rebind_attach
+ * @param count Number of rebindings
+ */
+void ph_rebind_detach(PHRebinding* const* rebindings, size_t count);
+
+// Configuration Snapshots (ph_config.c)
+
+/**
+ * Immutable, versioned copy of the spoofing configuration.
+ * A published snapshot is never modified; it is replaced as a whole.
+ * The response templates are prebuilt at publish time so the hooked
+ * functions answer with a single bounded memcpy.
+ */
+typedef struct {
+    uint64_t version;
+    PHookConfigData data;
+    struct utsname uname_template;
+    size_t hostname_length;
+} PHConfigSnapshot;
+
+// Field selectors for ph_config_publish
+#define PH_CONFIG_FIELD_USER_ID     (1u << 0)
+#define PH_CONFIG_FIELD_GROUP_ID    (1u << 1)
+#define PH_CONFIG_FIELD_HOSTNAME    (1u << 2)
+#define PH_CONFIG_FIELD_SYSTEM_INFO (1u << 3)
+#define PH_CONFIG_FIELD_ALL         (PH_CONFIG_FIELD_USER_ID | PH_CONFIG_FIELD_GROUP_ID | \
+                                     PH_CONFIG_FIELD_HOSTNAME | PH_CONFIG_FIELD_SYSTEM_INFO)
+
+/**
+ * Enter a read-side critical section and return the current snapshot.
+ * Wait-free; the snapshot stays valid until ph_config_read_end.
+ * @param token Output token that must be passed to ph_config_read_end
+ * @return Current snapshot, never NULL
+ */
+const PHConfigSnapshot* ph_config_read_begin(uint32_t* token);
+
+/**
+ * Leave a read-side critical section
+ * @param token Token returned by ph_config_read_begin
+ */
+void ph_config_read_end(uint32_t token);
+
+/**
+ * Publish a new snapshot derived from the current one
+ * Copies the selected fields from config_data, swaps the snapshot pointer
+ * and frees the previous snapshot after a grace period.
+ * @param config_data Source of the new values
+ * @param fields Bitmask of PH_CONFIG_FIELD_* values to take from config_data
+ * @return PH_SUCCESS on success, error code on failure
+ */
+PHResult ph_config_publish(const PHookConfigData* config_data, uint32_t fields);
+
+/**
+ * Version of the currently published snapshot (0 before the first publish)
+ */
+uint64_t ph_config_current_version(void);
+
+// Version of the newest published snapshot, for readers that cache values
+// per thread and only need to know whether their copy is stale
+extern _Atomic uint64_t g_config_generation;
+
+// Hardware Identifiers (ph_identifiers.c, ph_config.c)
+
+/**
+ * One entry of a published identifier table.
+ * Keys and values point into the table's own allocation; `object` is the
+ * prebuilt CFString or CFData answered to registry callers.
+ */
+typedef struct {
+    uint32_t key_hash;
+    uint16_t source;
+    uint16_t kind;
+    uint32_t key_length;
+    uint32_t value_length;   // Includes the terminator of string values
+    const char* key;
+    const void* value;
+    const void* object;
+} PHIdentifierEntry;
+
+/**
+ * Immutable identifier table, entries sorted by (source, key_hash, key)
+ */
+typedef struct {
+    size_t count;
+    uint64_t length_masks[PH_IDENTIFIER_SOURCE_COUNT];
+    PHIdentifierEntry entries[];
+} PHIdentifierTable;
+
+// Per source, bit min(length, 63) is set for every key length the
+// published table holds; callers test it before entering a read section
+extern _Atomic uint64_t g_identifier_length_masks[PH_IDENTIFIER_SOURCE_COUNT];
+
+/**
+ * Whether a key of this length may be in the published table
+ */
+static inline bool ph_identifiers_may_contain(PHIdentifierSource source, size_t length) {
+    uint64_t mask = atomic_load_explicit(&g_identifier_length_masks[source], memory_order_relaxed);
+    return (mask >> (length < 63 ? length : 63)) & 1;
+}
+
+/**
+ * Hash used to order identifier keys; FNV-1a, like ph_hash_name
+ */
+uint32_t ph_identifier_hash(const char* key, size_t length);
+
+/**
+ * Find an entry in a table, NULL if absent
+ * @param table Table read inside a configuration read section, may be NULL
+ */
+const PHIdentifierEntry* ph_identifiers_find(const PHIdentifierTable* table, PHIdentifierSource source,
+                                             const char* key, size_t length);
+
+/**
+ * Published identifier table, NULL if none
+ * Only valid between ph_config_read_begin and ph_config_read_end.
+ */
+const PHIdentifierTable* ph_config_identifiers(void);
+
+/**
+ * Swap in a new identifier table and wait until no reader can hold the old one
+ * @param table New table, NULL to clear
+ * @return The previous table, now unreachable, for the caller to free
+ */
+PHIdentifierTable* ph_config_exchange_identifiers(PHIdentifierTable* table);
+
+// Hook Registry (ph_registry.c)
+// Unless noted otherwise, registry functions must be called with
+// g_hook_mutex held.
+
+#define PH_MAX_HOOKS 1024
+#define PH_HOOK_INDEX_BITS 10
+
+/**
+ * Registry entry for an installed hook, sized to one cache line.
+ * `id` carries the entry's slot in its low PH_HOOK_INDEX_BITS bits and a
+ * reuse generation above them, so stale handles never match a reused slot.
+ * The rebinding journal is kept out of line because only install and
+ * remove touch it.
+ */
+typedef struct PHookEntry {
+    const char* function_name;
+    void* original_function;
+    void* replacement_function;
+    PHRebinding* rebinding;
+    uint32_t id;
+    uint32_t name_hash;
+    bool is_active;
+} __attribute__((aligned(64))) PHookEntry;
+
+/**
+ * FNV-1a hash used for interned function names
+ */
+uint32_t ph_hash_name(const char* name);
+
+/**
+ * Reserve an entry for a function, interning its name
+ * The entry is not visible to lookups until ph_registry_activate.
+ * @return Reserved entry, NULL if the registry or name table is full
+ */
+PHookEntry* ph_registry_acquire(const char* function_name);
+
+/**
+ * Make a reserved entry visible to lookups by name and ID
+ */
+void ph_registry_activate(PHookEntry* entry);
+
+/**
+ * Return an entry to the free list, deactivating it if needed
+ * The caller must have detached its rebinding first.
+ */
+void ph_registry_release(PHookEntry* entry);
+
+/**
+ * Find the active entry for a function name, NULL if not hooked
+ */
+PHookEntry* ph_registry_find(const char* function_name);
+
+/**
+ * Find the active entry with the given handle ID, NULL if none
+ */
+PHookEntry* ph_registry_find_by_id(uint32_t id);
+
+/**
+ * Check whether a function is hooked without taking g_hook_mutex
+ */
+bool ph_registry_contains(const char* function_name);
+
+/**
+ * Drop every entry and interned name
+ * The caller must have detached all rebindings first.
+ */
+void ph_registry_reset(void);
+
+/**
+ * Number of active entries
+ */
+uint32_t ph_registry_active_count(void);
+
+/**
+ * Number of entry slots ever handed out; bounds enumeration
+ */
+uint32_t ph_registry_capacity_used(void);
+
+/**
+ * Entry at a dense index below ph_registry_capacity_used(), active or not
+ */
+PHookEntry* ph_registry_entry_at(uint32_t index);
+
+// Hook Arena (ph_arena.c)
+// Names are interned with g_hook_mutex held; journal blocks are allocated
+// and released with the rebind engine's lock held.
+
+/**
+ * Map the arena if it is not mapped yet
+ * @return PH_SUCCESS on success, PH_ERROR_MEMORY_ERROR if mapping failed
+ */
+PHResult ph_arena_create(void);
+
+/**
+ * Release every name and journal at once and return the pages to the system
+ * The range stays mapped. The caller must have reset the registry and
+ * detached all rebindings.
+ */
+void ph_arena_release(void);
+
+/**
+ * Copy a name into the arena; it stays valid until ph_arena_release
+ * @return The copy, NULL if the name pool is full
+ */
+const char* ph_arena_intern(const char* name);
+
+/**
+ * Take a journal block of `capacity` slots from its size class
+ * @param capacity Power of two, at least 8
+ * @return Uninitialized block, NULL if the class or the arena is exhausted
+ */
+PHRebindSlot* ph_arena_journal_alloc(size_t capacity);
+
+/**
+ * Return a block from ph_arena_journal_alloc to its class's free list
+ */
+void ph_arena_journal_free(PHRebindSlot* slots, size_t capacity);
+
+// Hook Profiles (ph_profile.c, privarion_hook.c)
+
+/**
+ * Publish a profile's configuration and install its built-in hooks
+ * Initializes the hook system if needed; takes g_hook_mutex itself.
+ * @return PH_SUCCESS on success, error code on failure
+ */
+PHResult ph_apply_profile(const PHProfileRecord* profile);
+
+// Tracing (ph_trace.c)
+
+/**
+ * Monotonic timestamp in nanoseconds
+ */
+static inline uint64_t ph_now_ns(void) {
+#ifdef __APPLE__
+    return clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+#endif
+}
+
+/**
+ * System-wide ID of the calling thread, as reported in trace records
+ */
+uint64_t ph_current_thread_id(void);
+
+extern _Atomic bool g_trace_enabled;
+
+/**
+ * Append a record to the calling thread's trace ring
+ * Never blocks; the record is counted as dropped if the ring is full.
+ */
+void ph_trace_emit(uint32_t hook_id, int64_t return_value);
+
+// Record a hook invocation. With PRIVARION_HOOK_NO_TRACE the call sites
+// compile away entirely; otherwise the arguments are only evaluated once
+// the relaxed gate load says tracing is on.
+#ifdef PRIVARION_HOOK_NO_TRACE
+#define PH_TRACE(hook_id, return_value) ((void)0)
+#else
+#define PH_TRACE(hook_id, return_value) \
+    do { \
+        if (__builtin_expect(atomic_load_explicit(&g_trace_enabled, memory_order_relaxed), 0)) { \
+            ph_trace_emit((hook_id), (int64_t)(return_value)); \
+        } \
+    } while (0)
+#endif
+
+// Statistics (ph_stats.c)
+
+typedef enum {
+    PH_STATS_OUTCOME_SPOOFED,
+    PH_STATS_OUTCOME_PASSTHROUGH
+} PHStatsOutcome;
+
+extern _Atomic bool g_stats_enabled;
+
+/**
+ * Create and map this process's statistics region (g_hook_mutex held)
+ * @return PH_SUCCESS on success or if the region already exists
+ */
+PHResult ph_stats_create_region(void);
+
+/**
+ * Publish a newly activated hook in its statistics slot (g_hook_mutex held)
+ */
+void ph_stats_hook_activated(const PHookEntry* entry);
+
+/**
+ * Retire the statistics slot of a removed hook (g_hook_mutex held)
+ */
+void ph_stats_hook_released(const PHookEntry* entry);
+
+/**
+ * Count one hooked call that started at start_ns
+ */
+void ph_stats_record(uint32_t hook_id, PHStatsOutcome outcome, uint64_t start_ns);
+
+// Timestamp a hooked call for statistics; 0 while statistics are off
+#define PH_STATS_START() \
+    (atomic_load_explicit(&g_stats_enabled, memory_order_acquire) ? ph_now_ns() : 0)
+
+#define PH_STATS_RECORD(hook_id, outcome, start_ns) \
+    do { \
+        if ((start_ns) != 0) { \
+            ph_stats_record((hook_id), (outcome), (start_ns)); \
+        } \
+    } while (0)
+
+// Syscall Events (ph_events.c)
+
+extern _Atomic bool g_events_enabled;
+
+/**
+ * Create and map this process's event region (g_hook_mutex held)
+ * @return PH_SUCCESS on success or if the region already exists
+ */
+PHResult ph_events_create_region(void);
+
+/**
+ * Name a newly activated hook in the event region (g_hook_mutex held)
+ */
+void ph_events_hook_activated(const PHookEntry* entry);
+
+/**
+ * Retire the event region name of a removed hook (g_hook_mutex held)
+ */
+void ph_events_hook_released(const PHookEntry* entry);
+
+/**
+ * Append a record to the calling thread's event lane
+ * Never blocks; the record is skipped if the consumer's filter rejects it
+ * and counted as dropped if the lane is full.
+ * @param path Path argument of the call, NULL if it has none; filtered and recorded
+ * @param argument First string argument of a call without a path, recorded only
+ */
+void ph_events_emit(PHSyscallId syscall, uint32_t hook_id, const char* path, const char* argument,
+                    int64_t return_value);
+
+// Publish a hooked call; only the gate load runs while events are off
+#define PH_EVENT(syscall, hook_id, path, argument, return_value) \
+    do { \
+        if (__builtin_expect(atomic_load_explicit(&g_events_enabled, memory_order_relaxed), 0)) { \
+            ph_events_emit((syscall), (hook_id), (path), (argument), (int64_t)(return_value)); \
+        } \
+    } while (0)
+
+// Process Inheritance (ph_spawn.c, privarion_hook.c)
+
+extern _Atomic bool g_spawn_inherit_enabled;
+
+/**
+ * Capture the library path and inherited variables, once per process
+ * @param library_path Library inserted into children, NULL for this image
+ * @return PH_SUCCESS on success or if already captured, error code on failure
+ */
+PHResult ph_spawn_capture(const char* library_path);
+
+// Stack storage a replacement may reserve for a rebuilt environment; a
+// larger environment is passed to the child unchanged
+#define PH_SPAWN_MAX_SLOTS 1024
+#define PH_SPAWN_MAX_MERGE 4096
+
+/**
+ * Storage needed to rebuild a child environment, for stack allocation
+ * Never more than PH_SPAWN_MAX_SLOTS slots or PH_SPAWN_MAX_MERGE bytes; an
+ * environment that would need more gets one slot and no merge buffer, which
+ * makes ph_spawn_environment return it unchanged.
+ * @param envp Environment passed by the caller, may be NULL
+ * @param merge_size Output: bytes needed for a merged DYLD_INSERT_LIBRARIES entry
+ * @return Number of slots, terminator included
+ */
+size_t ph_spawn_environment_size(char* const* envp, size_t* merge_size);
+
+/**
+ * Child environment with every inherited variable it lacks added
+ * Never allocates: entries are copied into the caller's slots.
+ * @return envp itself if nothing is missing, otherwise slots
+ */
+char* const* ph_spawn_environment(char* const* envp, char** slots, size_t slot_count,
+                                  char* merge_buffer, size_t merge_size);
+
+// Fork Safety
+// Registered with pthread_atfork by privarion_hook.c, which holds
+// g_hook_mutex across the fork and calls the handlers below inside it.
+
+void ph_config_fork_prepare(void);
+void ph_config_fork_parent(void);
+void ph_config_fork_child(void);
+
+void ph_identifiers_fork_prepare(void);
+void ph_identifiers_fork_parent(void);
+void ph_identifiers_fork_child(void);
+
+void ph_trace_fork_prepare(void);
+void ph_trace_fork_parent(void);
+void ph_trace_fork_child(void);
+
+void ph_rebind_fork_child(void);
+
+/**
+ * Move the child's statistics to a region of its own (g_hook_mutex held)
+ */
+void ph_stats_fork_child(void);
+
+/**
+ * Move the child's events to a region of its own (g_hook_mutex held)
+ */
+void ph_events_fork_child(void);
+
+#endif // PRIVARION_HOOK_INTERNAL_H
@@ -0,0 +1,130 @@
+// Hook Profiles
+// The launcher resolves every bundle's effective hook rules ahead of time
+// and writes them as a fixed-layout binary table. The injected library maps
+// that table in its constructor, binary-searches the host bundle and
+// installs its hooks directly: no JSON parsing and no IPC before main().
+
+#include "ph_internal.h"
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const PHProfileRecord* ph_profile_find(const uint8_t* base,
+                                              const PHProfileHeader* header,
+                                              const char* bundle_id) {
+    const PHProfileRecord* records = (const PHProfileRecord*)(base + sizeof(PHProfileHeader));
+    const char* strings = (const char*)(base + header->string_table_offset);
+
+    if (bundle_id != NULL && *bundle_id != '\0') {
+        size_t length = strlen(bundle_id);
+        uint32_t low = 0;
+        uint32_t high = header->profile_count;
+        while (low < high) {
+            uint32_t middle = low + (high - low) / 2;
+            const PHProfileRecord* record = &records[middle];
+            size_t record_length = record->bundle_id_length;
+            int order = memcmp(strings + record->bundle_id_offset, bundle_id,
+                               record_length < length ? record_length : length);
+            if (order == 0) {
+                order = (record_length > length) - (record_length < length);
+            }
+            if (order == 0) {
+                return record;
+            }
+            if (order < 0) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+    }
+
+    // The empty identifier sorts first
+    if (header->profile_count > 0 && records[0].bundle_id_length == 0) {
+        return &records[0];
+    }
+    return NULL;
+}
+
+static bool ph_profile_validate(const uint8_t* base, size_t size) {
+    if (size < sizeof(PHProfileHeader)) {
+        return false;
+    }
+
+    const PHProfileHeader* header = (const PHProfileHeader*)base;
+    if (header->magic != PH_PROFILE_MAGIC || header->format_version != PH_PROFILE_FORMAT_VERSION ||
+        header->record_size != sizeof(PHProfileRecord)) {
+        return false;
+    }
+
+    uint64_t records_end = sizeof(PHProfileHeader) + (uint64_t)header->profile_count * sizeof(PHProfileRecord);
+    uint64_t strings_end = (uint64_t)header->string_table_offset + header->string_table_size;
+    if (records_end > header->string_table_offset || strings_end > size) {
+        return false;
+    }
+
+    // Every identifier must lie inside the string table
+    const PHProfileRecord* records = (const PHProfileRecord*)(base + sizeof(PHProfileHeader));
+    for (uint32_t i = 0; i < header->profile_count; i++) {
+        if ((uint64_t)records[i].bundle_id_offset + records[i].bundle_id_length > header->string_table_size) {
+            return false;
+        }
+    }
+    return true;
+}
+
+PHResult ph_load_profile(const char* path, const char* bundle_id) {
+    if (path == NULL) {
+        return PH_ERROR_INVALID_PARAM;
+    }
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return PH_ERROR_PERMISSION_DENIED;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close(fd);
+        return PH_ERROR_INVALID_PARAM;
+    }
+
+    size_t size = (size_t)info.st_size;
+    void* memory = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        return PH_ERROR_MEMORY_ERROR;
+    }
+
+    PHResult result = PH_ERROR_NOT_HOOKED;
+    PHProfileRecord profile;
+    const uint8_t* base = memory;
+
+    if (!ph_profile_validate(base, size)) {
+        result = PH_ERROR_INVALID_PARAM;
+    } else {
+        const PHProfileRecord* record = ph_profile_find(base, (const PHProfileHeader*)base, bundle_id);
+        if (record != NULL) {
+            profile = *record;
+            result = PH_SUCCESS;
+        }
+    }
+    munmap(memory, size);
+
+    if (result != PH_SUCCESS) {
+        return result;
+    }
+    return ph_apply_profile(&profile);
+}
+
+// Injected processes find their profile table through the environment
+__attribute__((constructor))
+static void ph_profile_load_from_environment(void) {
+    const char* path = getenv(PH_PROFILE_PATH_ENV);
+    if (path != NULL && *path != '\0') {
+        ph_load_profile(path, getenv(PH_PROFILE_BUNDLE_ENV));
+    }
+}
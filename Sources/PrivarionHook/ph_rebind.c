@@ -0,0 +1,345 @@
+// Symbol Rebinding Engine
+// Redirects calls to hooked functions by rewriting the lazy and non-lazy
+// symbol pointer slots (__la_symbol_ptr, __got, __auth_got) of every
+// loaded Mach-O image. A patched slot dispatches with a single indirect
+// call, exactly like the unhooked code path.
+
+#include "ph_internal.h"
+#include <string.h>
+#include <pthread.h>
+
+#ifdef __APPLE__
+
+#include <mach/mach.h>
+#include <mach-o/dyld.h>
+#include <mach-o/loader.h>
+#include <mach-o/nlist.h>
+
+#if defined(__has_feature)
+#if __has_feature(ptrauth_calls)
+#include <ptrauth.h>
+#define PH_HAS_PTRAUTH 1
+#endif
+#endif
+
+// Active rebindings, consulted by the dyld add-image callback.
+// g_rebind_lock guards this set and every slot journal. It is never held
+// while calling into dyld, so the callback (which runs under dyld's own
+// lock) cannot deadlock against an install in progress. Every rebinding
+// belongs to a registry entry, so the set never outgrows PH_MAX_HOOKS.
+static pthread_mutex_t g_rebind_lock = PTHREAD_MUTEX_INITIALIZER;
+static PHRebinding* g_active_rebindings[PH_MAX_HOOKS];
+static size_t g_active_count = 0;
+static pthread_once_t g_callbacks_once = PTHREAD_ONCE_INIT;
+
+// Internal helper functions
+static bool ph_rebind_image(const struct mach_header* header, intptr_t slide,
+                            PHRebinding* const* rebindings, size_t count);
+static void ph_rebind_on_add_image(const struct mach_header* header, intptr_t slide);
+static void ph_rebind_on_remove_image(const struct mach_header* header, intptr_t slide);
+static void ph_rebind_register_callbacks(void);
+
+static void* ph_rebind_sign(void* value, void** slot, bool authenticated) {
+#ifdef PH_HAS_PTRAUTH
+    value = ptrauth_strip(value, ptrauth_key_function_pointer);
+    if (authenticated) {
+        // __auth_got entries are signed with the slot address as discriminator
+        return ptrauth_sign_unauthenticated(value, ptrauth_key_function_pointer, slot);
+    }
+    return ptrauth_sign_unauthenticated(value, ptrauth_key_function_pointer, 0);
+#else
+    (void)slot;
+    (void)authenticated;
+    return value;
+#endif
+}
+
+static bool ph_rebind_write(void** slot, void* value, bool read_only) {
+    if (!read_only) {
+        *slot = value;
+        return true;
+    }
+
+    // __DATA_CONST is remapped read-only once dyld finishes binding;
+    // make a private writable copy of the page for the duration of the write
+    kern_return_t kr = vm_protect(mach_task_self(), (vm_address_t)slot, sizeof(void*), false,
+                                  VM_PROT_READ | VM_PROT_WRITE | VM_PROT_COPY);
+    if (kr != KERN_SUCCESS) {
+        return false;
+    }
+    *slot = value;
+    vm_protect(mach_task_self(), (vm_address_t)slot, sizeof(void*), false, VM_PROT_READ);
+    return true;
+}
+
+static bool ph_rebind_journal_append(PHRebinding* rebinding, const PHRebindSlot* slot) {
+    if (rebinding->slot_count == rebinding->slot_capacity) {
+        size_t capacity = rebinding->slot_capacity ? rebinding->slot_capacity * 2 : 8;
+        PHRebindSlot* slots = ph_arena_journal_alloc(capacity);
+        if (!slots) {
+            return false;
+        }
+        if (rebinding->slots) {
+            memcpy(slots, rebinding->slots, rebinding->slot_count * sizeof(PHRebindSlot));
+            ph_arena_journal_free(rebinding->slots, rebinding->slot_capacity);
+        }
+        rebinding->slots = slots;
+        rebinding->slot_capacity = capacity;
+    }
+    rebinding->slots[rebinding->slot_count++] = *slot;
+    return true;
+}
+
+static bool ph_rebind_section(const struct section_64* section, intptr_t slide,
+                              const struct mach_header* header,
+                              const struct nlist_64* symtab, uint32_t nsyms,
+                              const char* strtab, const uint32_t* indirect_symtab,
+                              PHRebinding* const* rebindings, size_t count) {
+    bool read_only = strncmp(section->segname, "__DATA_CONST", sizeof(section->segname)) == 0 ||
+                     strncmp(section->segname, "__AUTH_CONST", sizeof(section->segname)) == 0;
+    bool authenticated = strncmp(section->sectname, "__auth_", 7) == 0;
+    const uint32_t* indices = indirect_symtab + section->reserved1;
+    void** slots = (void**)((uintptr_t)slide + section->addr);
+    size_t slot_count = section->size / sizeof(void*);
+
+    for (size_t i = 0; i < slot_count; i++) {
+        uint32_t symbol_index = indices[i];
+        if (symbol_index & (INDIRECT_SYMBOL_LOCAL | INDIRECT_SYMBOL_ABS) || symbol_index >= nsyms) {
+            continue;
+        }
+
+        const char* symbol_name = strtab + symtab[symbol_index].n_un.n_strx;
+        if (symbol_name[0] != '_') {
+            continue;
+        }
+
+        for (size_t r = 0; r < count; r++) {
+            PHRebinding* rebinding = rebindings[r];
+            if (strcmp(symbol_name + 1, rebinding->name) != 0) {
+                continue;
+            }
+
+            void* patched = ph_rebind_sign(rebinding->replacement, &slots[i], authenticated);
+            if (slots[i] == patched) {
+                break;
+            }
+
+            PHRebindSlot record = {
+                .address = &slots[i],
+                .previous = slots[i],
+                .image = header,
+                .read_only = read_only,
+                .authenticated = authenticated
+            };
+            if (!ph_rebind_journal_append(rebinding, &record)) {
+                return false;
+            }
+            if (!ph_rebind_write(&slots[i], patched, read_only)) {
+                rebinding->slot_count--;
+            }
+            break;
+        }
+    }
+    return true;
+}
+
+static bool ph_rebind_image(const struct mach_header* header, intptr_t slide,
+                            PHRebinding* const* rebindings, size_t count) {
+    const struct mach_header_64* mh = (const struct mach_header_64*)header;
+    if (mh == NULL || mh->magic != MH_MAGIC_64 || count == 0) {
+        return true;
+    }
+
+    const struct segment_command_64* linkedit = NULL;
+    const struct symtab_command* symtab_cmd = NULL;
+    const struct dysymtab_command* dysymtab_cmd = NULL;
+
+    uintptr_t cursor = (uintptr_t)mh + sizeof(struct mach_header_64);
+    for (uint32_t i = 0; i < mh->ncmds; i++) {
+        const struct load_command* lc = (const struct load_command*)cursor;
+        if (lc->cmd == LC_SEGMENT_64) {
+            const struct segment_command_64* segment = (const struct segment_command_64*)lc;
+            if (strncmp(segment->segname, SEG_LINKEDIT, sizeof(segment->segname)) == 0) {
+                linkedit = segment;
+            }
+        } else if (lc->cmd == LC_SYMTAB) {
+            symtab_cmd = (const struct symtab_command*)lc;
+        } else if (lc->cmd == LC_DYSYMTAB) {
+            dysymtab_cmd = (const struct dysymtab_command*)lc;
+        }
+        cursor += lc->cmdsize;
+    }
+
+    if (!linkedit || !symtab_cmd || !dysymtab_cmd || dysymtab_cmd->nindirectsyms == 0) {
+        return true;
+    }
+
+    uintptr_t linkedit_base = (uintptr_t)slide + linkedit->vmaddr - linkedit->fileoff;
+    const struct nlist_64* symtab = (const struct nlist_64*)(linkedit_base + symtab_cmd->symoff);
+    const char* strtab = (const char*)(linkedit_base + symtab_cmd->stroff);
+    const uint32_t* indirect_symtab = (const uint32_t*)(linkedit_base + dysymtab_cmd->indirectsymoff);
+
+    cursor = (uintptr_t)mh + sizeof(struct mach_header_64);
+    for (uint32_t i = 0; i < mh->ncmds; i++) {
+        const struct load_command* lc = (const struct load_command*)cursor;
+        cursor += lc->cmdsize;
+        if (lc->cmd != LC_SEGMENT_64) {
+            continue;
+        }
+
+        const struct segment_command_64* segment = (const struct segment_command_64*)lc;
+        if (strncmp(segment->segname, SEG_DATA, sizeof(segment->segname)) != 0 &&
+            strncmp(segment->segname, "__DATA_CONST", sizeof(segment->segname)) != 0 &&
+            strncmp(segment->segname, "__AUTH", sizeof(segment->segname)) != 0 &&
+            strncmp(segment->segname, "__AUTH_CONST", sizeof(segment->segname)) != 0) {
+            continue;
+        }
+
+        const struct section_64* sections = (const struct section_64*)(segment + 1);
+        for (uint32_t s = 0; s < segment->nsects; s++) {
+            uint32_t type = sections[s].flags & SECTION_TYPE;
+            if (type != S_LAZY_SYMBOL_POINTERS && type != S_NON_LAZY_SYMBOL_POINTERS) {
+                continue;
+            }
+            if (!ph_rebind_section(&sections[s], slide, header, symtab, symtab_cmd->nsyms,
+                                   strtab, indirect_symtab, rebindings, count)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static void ph_rebind_on_add_image(const struct mach_header* header, intptr_t slide) {
+    pthread_mutex_lock(&g_rebind_lock);
+    // A journal allocation failure here leaves the new image partially
+    // unpatched; slots that were patched are still recorded and restorable
+    ph_rebind_image(header, slide, g_active_rebindings, g_active_count);
+    pthread_mutex_unlock(&g_rebind_lock);
+}
+
+static void ph_rebind_on_remove_image(const struct mach_header* header, intptr_t slide) {
+    (void)slide;
+    pthread_mutex_lock(&g_rebind_lock);
+    // Forget slots that belong to the unloaded image so detach never
+    // writes into unmapped memory
+    for (size_t r = 0; r < g_active_count; r++) {
+        PHRebinding* rebinding = g_active_rebindings[r];
+        size_t kept = 0;
+        for (size_t i = 0; i < rebinding->slot_count; i++) {
+            if (rebinding->slots[i].image != header) {
+                rebinding->slots[kept++] = rebinding->slots[i];
+            }
+        }
+        rebinding->slot_count = kept;
+    }
+    pthread_mutex_unlock(&g_rebind_lock);
+}
+
+static void ph_rebind_register_callbacks(void) {
+    // Registration replays the add callback for every loaded image; the
+    // active set is still empty at this point so the replay is a no-op
+    _dyld_register_func_for_add_image(ph_rebind_on_add_image);
+    _dyld_register_func_for_remove_image(ph_rebind_on_remove_image);
+}
+
+static void ph_rebind_restore_locked(PHRebinding* rebinding) {
+    for (size_t i = rebinding->slot_count; i > 0; i--) {
+        PHRebindSlot* slot = &rebinding->slots[i - 1];
+        // Leave the slot alone if somebody else re-patched it after us
+        void* patched = ph_rebind_sign(rebinding->replacement, slot->address, slot->authenticated);
+        if (*slot->address == patched) {
+            ph_rebind_write(slot->address, slot->previous, slot->read_only);
+        }
+    }
+    ph_arena_journal_free(rebinding->slots, rebinding->slot_capacity);
+    rebinding->slots = NULL;
+    rebinding->slot_count = 0;
+    rebinding->slot_capacity = 0;
+}
+
+static void ph_rebind_deactivate_locked(PHRebinding* rebinding) {
+    for (size_t r = 0; r < g_active_count; r++) {
+        if (g_active_rebindings[r] == rebinding) {
+            g_active_rebindings[r] = g_active_rebindings[--g_active_count];
+            return;
+        }
+    }
+}
+
+PHResult ph_rebind_attach(PHRebinding* const* rebindings, size_t count) {
+    if (!rebindings || count == 0) {
+        return PH_ERROR_INVALID_PARAM;
+    }
+
+    pthread_once(&g_callbacks_once, ph_rebind_register_callbacks);
+
+    pthread_mutex_lock(&g_rebind_lock);
+    if (g_active_count + count > PH_MAX_HOOKS) {
+        pthread_mutex_unlock(&g_rebind_lock);
+        return PH_ERROR_MEMORY_ERROR;
+    }
+    for (size_t r = 0; r < count; r++) {
+        g_active_rebindings[g_active_count++] = rebindings[r];
+    }
+    pthread_mutex_unlock(&g_rebind_lock);
+
+    // One walk over the loaded images patches every requested symbol
+    bool ok = true;
+    uint32_t image_count = _dyld_image_count();
+    for (uint32_t i = 0; i < image_count && ok; i++) {
+        const struct mach_header* header = _dyld_get_image_header(i);
+        intptr_t slide = _dyld_get_image_vmaddr_slide(i);
+        if (header == NULL) {
+            continue;
+        }
+        pthread_mutex_lock(&g_rebind_lock);
+        ok = ph_rebind_image(header, slide, rebindings, count);
+        pthread_mutex_unlock(&g_rebind_lock);
+    }
+
+    if (!ok) {
+        ph_rebind_detach(rebindings, count);
+        return PH_ERROR_MEMORY_ERROR;
+    }
+    return PH_SUCCESS;
+}
+
+void ph_rebind_detach(PHRebinding* const* rebindings, size_t count) {
+    if (!rebindings) {
+        return;
+    }
+
+    pthread_mutex_lock(&g_rebind_lock);
+    for (size_t r = 0; r < count; r++) {
+        ph_rebind_deactivate_locked(rebindings[r]);
+        ph_rebind_restore_locked(rebindings[r]);
+    }
+    pthread_mutex_unlock(&g_rebind_lock);
+}
+
+void ph_rebind_fork_child(void) {
+    // Not taken across fork: the add-image callback holds dyld's lock while
+    // waiting for g_rebind_lock, and fork takes dyld's lock after the
+    // prepare handlers. A journal append it interrupted only leaves a slot
+    // unrecorded, which the child then never restores.
+    pthread_mutex_init(&g_rebind_lock, NULL);
+}
+
+#else // !__APPLE__
+
+PHResult ph_rebind_attach(PHRebinding* const* rebindings, size_t count) {
+    (void)rebindings;
+    (void)count;
+    return PH_ERROR_UNSUPPORTED_PLATFORM;
+}
+
+void ph_rebind_detach(PHRebinding* const* rebindings, size_t count) {
+    (void)rebindings;
+    (void)count;
+}
+
+void ph_rebind_fork_child(void) {
+}
+
+#endif // __APPLE__
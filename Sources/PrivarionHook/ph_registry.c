@@ -0,0 +1,191 @@
+// Hook Registry
+// Installed hooks live in a dense, fixed-capacity entry array indexed by
+// the low bits of their handle ID. Function names are interned once in an
+// open-addressing table that maps each name to the slot of its active hook,
+// so every lookup is a hash probe instead of a list walk. The name strings
+// are copied into the hook arena.
+
+#include "ph_internal.h"
+#include <string.h>
+#include <stdatomic.h>
+
+#define PH_HOOK_INDEX_MASK ((1u << PH_HOOK_INDEX_BITS) - 1)
+#define PH_INTERN_CAPACITY (PH_MAX_HOOKS * 2)
+#define PH_INTERN_MASK (PH_INTERN_CAPACITY - 1)
+#define PH_NO_ENTRY (-1)
+
+_Static_assert((PH_MAX_HOOKS & (PH_MAX_HOOKS - 1)) == 0, "PH_MAX_HOOKS must be a power of two");
+_Static_assert(PH_MAX_HOOKS == (1u << PH_HOOK_INDEX_BITS), "PH_HOOK_INDEX_BITS must cover PH_MAX_HOOKS");
+_Static_assert(sizeof(PHookEntry) == 64, "PHookEntry must occupy exactly one cache line");
+
+// Interned names are never removed while the registry is alive, so the
+// table needs no tombstones and readers can probe it without the lock
+typedef struct {
+    _Atomic(const char*) name;
+    uint32_t hash;
+    _Atomic int32_t entry_index;
+} PHInternSlot;
+
+static PHookEntry g_entries[PH_MAX_HOOKS];
+static PHRebinding g_rebindings[PH_MAX_HOOKS];
+static PHInternSlot g_intern_table[PH_INTERN_CAPACITY];
+static uint32_t g_intern_count = 0;
+
+// Free entry slots, used as a stack; g_high_water bounds enumeration
+static uint16_t g_free_slots[PH_MAX_HOOKS];
+static uint32_t g_free_count = 0;
+static uint32_t g_high_water = 0;
+static uint32_t g_active_count = 0;
+
+uint32_t ph_hash_name(const char* name) {
+    // FNV-1a; symbol names are short and this keeps probing branch-free
+    uint32_t hash = 2166136261u;
+    for (const unsigned char* p = (const unsigned char*)name; *p; p++) {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static PHInternSlot* ph_intern_find(const char* name, uint32_t hash) {
+    for (uint32_t probe = 0; probe < PH_INTERN_CAPACITY; probe++) {
+        PHInternSlot* slot = &g_intern_table[(hash + probe) & PH_INTERN_MASK];
+        const char* interned = atomic_load_explicit(&slot->name, memory_order_acquire);
+        if (interned == NULL) {
+            return NULL;
+        }
+        if (slot->hash == hash && strcmp(interned, name) == 0) {
+            return slot;
+        }
+    }
+    return NULL;
+}
+
+static PHInternSlot* ph_intern_insert(const char* name, uint32_t hash) {
+    PHInternSlot* existing = ph_intern_find(name, hash);
+    if (existing) {
+        return existing;
+    }
+    // Keep the load factor at or below one half
+    if (g_intern_count >= PH_INTERN_CAPACITY / 2) {
+        return NULL;
+    }
+
+    for (uint32_t probe = 0; probe < PH_INTERN_CAPACITY; probe++) {
+        PHInternSlot* slot = &g_intern_table[(hash + probe) & PH_INTERN_MASK];
+        if (atomic_load_explicit(&slot->name, memory_order_relaxed) != NULL) {
+            continue;
+        }
+        const char* copy = ph_arena_intern(name);
+        if (!copy) {
+            return NULL;
+        }
+        slot->hash = hash;
+        atomic_store_explicit(&slot->entry_index, PH_NO_ENTRY, memory_order_relaxed);
+        atomic_store_explicit(&slot->name, copy, memory_order_release);
+        g_intern_count++;
+        return slot;
+    }
+    return NULL;
+}
+
+void ph_registry_reset(void) {
+    // The names themselves live in the hook arena and go with it
+    for (uint32_t i = 0; i < PH_INTERN_CAPACITY; i++) {
+        atomic_store_explicit(&g_intern_table[i].name, NULL, memory_order_release);
+    }
+    g_intern_count = 0;
+
+    // Entry IDs keep their generation so handles from before the reset
+    // can never alias a hook installed afterwards
+    for (uint32_t i = 0; i < PH_MAX_HOOKS; i++) {
+        g_entries[i].is_active = false;
+        g_entries[i].function_name = NULL;
+        memset(&g_rebindings[i], 0, sizeof(PHRebinding));
+    }
+    g_free_count = 0;
+    g_high_water = 0;
+    g_active_count = 0;
+}
+
+PHookEntry* ph_registry_find(const char* function_name) {
+    PHInternSlot* slot = ph_intern_find(function_name, ph_hash_name(function_name));
+    if (!slot) {
+        return NULL;
+    }
+    int32_t index = atomic_load_explicit(&slot->entry_index, memory_order_acquire);
+    return index == PH_NO_ENTRY ? NULL : &g_entries[index];
+}
+
+bool ph_registry_contains(const char* function_name) {
+    PHInternSlot* slot = ph_intern_find(function_name, ph_hash_name(function_name));
+    return slot && atomic_load_explicit(&slot->entry_index, memory_order_acquire) != PH_NO_ENTRY;
+}
+
+PHookEntry* ph_registry_find_by_id(uint32_t id) {
+    PHookEntry* entry = &g_entries[id & PH_HOOK_INDEX_MASK];
+    return (entry->is_active && entry->id == id) ? entry : NULL;
+}
+
+PHookEntry* ph_registry_acquire(const char* function_name) {
+    uint32_t hash = ph_hash_name(function_name);
+    PHInternSlot* slot = ph_intern_insert(function_name, hash);
+    if (!slot) {
+        return NULL;
+    }
+
+    uint32_t index;
+    if (g_free_count > 0) {
+        index = g_free_slots[--g_free_count];
+    } else if (g_high_water < PH_MAX_HOOKS) {
+        index = g_high_water++;
+    } else {
+        return NULL;
+    }
+
+    PHookEntry* entry = &g_entries[index];
+    uint32_t generation = (entry->id >> PH_HOOK_INDEX_BITS) + 1;
+    if (generation >= (1u << (32 - PH_HOOK_INDEX_BITS))) {
+        generation = 1;
+    }
+
+    entry->function_name = atomic_load_explicit(&slot->name, memory_order_relaxed);
+    entry->original_function = NULL;
+    entry->replacement_function = NULL;
+    entry->rebinding = &g_rebindings[index];
+    entry->id = (generation << PH_HOOK_INDEX_BITS) | index;
+    entry->name_hash = hash;
+    entry->is_active = false;
+    memset(entry->rebinding, 0, sizeof(PHRebinding));
+    entry->rebinding->name = entry->function_name;
+    return entry;
+}
+
+void ph_registry_activate(PHookEntry* entry) {
+    PHInternSlot* slot = ph_intern_find(entry->function_name, entry->name_hash);
+    entry->is_active = true;
+    g_active_count++;
+    atomic_store_explicit(&slot->entry_index, (int32_t)(entry->id & PH_HOOK_INDEX_MASK), memory_order_release);
+}
+
+void ph_registry_release(PHookEntry* entry) {
+    if (entry->is_active) {
+        PHInternSlot* slot = ph_intern_find(entry->function_name, entry->name_hash);
+        atomic_store_explicit(&slot->entry_index, PH_NO_ENTRY, memory_order_release);
+        entry->is_active = false;
+        g_active_count--;
+    }
+    g_free_slots[g_free_count++] = (uint16_t)(entry->id & PH_HOOK_INDEX_MASK);
+}
+
+uint32_t ph_registry_active_count(void) {
+    return g_active_count;
+}
+
+uint32_t ph_registry_capacity_used(void) {
+    return g_high_water;
+}
+
+PHookEntry* ph_registry_entry_at(uint32_t index) {
+    return index < g_high_water ? &g_entries[index] : NULL;
+}
@@ -0,0 +1,274 @@
+// Process Inheritance
+// An injected process passes the hook library on to every process it
+// starts. The posix_spawn, posix_spawnp and execve replacements add
+// DYLD_INSERT_LIBRARIES and the launcher's PRIVARION_* variables to a
+// child environment that dropped them, so helpers load the library and
+// map the same profile and identifier tables from their own constructors.
+// Nothing here allocates after capture: execve may run in a forked child
+// of a multithreaded process, so the environment is rebuilt in caller
+// provided stack storage.
+
+#include "ph_internal.h"
+#include <stdlib.h>
+#include <string.h>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define PH_SPAWN_INSERT_ENV "DYLD_INSERT_LIBRARIES"
+#define PH_SPAWN_INSERT_PREFIX_LENGTH (sizeof(PH_SPAWN_INSERT_ENV "=") - 1)
+
+// Variables set by the launcher that a child needs to find its tables
+static const char* const g_inherited_names[] = {
+    PH_PROFILE_PATH_ENV,
+    PH_PROFILE_BUNDLE_ENV,
+    PH_IDENTIFIERS_PATH_ENV,
+    PH_STATS_ENV,
+    PH_EVENTS_ENV,
+    PH_LAZY_ENV,
+};
+
+#define PH_SPAWN_INHERITED_MAX (sizeof(g_inherited_names) / sizeof(g_inherited_names[0]))
+
+_Static_assert(PH_SPAWN_INHERITED_MAX < 32, "Present variables are tracked in a 32-bit mask");
+
+typedef struct {
+    size_t name_length;    // Up to and including '='
+    char* entry;           // "NAME=value", NULL if this process has none
+} PHInheritedVariable;
+
+// Written once under g_spawn_lock, then read by the replacements after an
+// acquire load of g_spawn_inherit_enabled
+_Atomic bool g_spawn_inherit_enabled = false;
+static pthread_mutex_t g_spawn_lock = PTHREAD_MUTEX_INITIALIZER;
+static PHInheritedVariable g_inherited[PH_SPAWN_INHERITED_MAX];
+static char* g_insert_entry = NULL;       // "DYLD_INSERT_LIBRARIES=<library>"
+static const char* g_library_path = NULL; // Points into g_insert_entry
+static size_t g_library_path_length = 0;
+
+static char* ph_spawn_make_entry(const char* name, const char* value) {
+    size_t name_length = strlen(name);
+    size_t value_length = strlen(value);
+    char* entry = malloc(name_length + value_length + 2);
+    if (entry != NULL) {
+        memcpy(entry, name, name_length);
+        entry[name_length] = '=';
+        memcpy(entry + name_length + 1, value, value_length + 1);
+    }
+    return entry;
+}
+
+// Whether a colon-separated list holds path as one of its elements
+static bool ph_spawn_list_contains(const char* list, const char* path, size_t path_length) {
+    const char* element = list;
+    while (*element != '\0') {
+        const char* end = strchr(element, ':');
+        size_t length = end != NULL ? (size_t)(end - element) : strlen(element);
+        if (length == path_length && memcmp(element, path, length) == 0) {
+            return true;
+        }
+        if (end == NULL) {
+            break;
+        }
+        element = end + 1;
+    }
+    return false;
+}
+
+PHResult ph_spawn_capture(const char* library_path) {
+    Dl_info info;
+    if (library_path == NULL) {
+        if (dladdr((const void*)ph_spawn_capture, &info) == 0 || info.dli_fname == NULL) {
+            return PH_ERROR_FUNCTION_NOT_FOUND;
+        }
+        library_path = info.dli_fname;
+    }
+    if (*library_path == '\0' || strchr(library_path, ':') != NULL) {
+        return PH_ERROR_INVALID_PARAM;
+    }
+
+    pthread_mutex_lock(&g_spawn_lock);
+
+    // Replacements may be reading the captured entries, so they are never
+    // replaced; the first capture wins
+    if (atomic_load_explicit(&g_spawn_inherit_enabled, memory_order_relaxed)) {
+        pthread_mutex_unlock(&g_spawn_lock);
+        return PH_SUCCESS;
+    }
+
+    char* insert_entry = ph_spawn_make_entry(PH_SPAWN_INSERT_ENV, library_path);
+    if (insert_entry == NULL) {
+        pthread_mutex_unlock(&g_spawn_lock);
+        return PH_ERROR_MEMORY_ERROR;
+    }
+
+    PHInheritedVariable inherited[PH_SPAWN_INHERITED_MAX] = {0};
+    for (size_t i = 0; i < PH_SPAWN_INHERITED_MAX; i++) {
+        inherited[i].name_length = strlen(g_inherited_names[i]) + 1;
+        const char* value = getenv(g_inherited_names[i]);
+        if (value == NULL) {
+            continue;
+        }
+        inherited[i].entry = ph_spawn_make_entry(g_inherited_names[i], value);
+        if (inherited[i].entry == NULL) {
+            for (size_t j = 0; j < i; j++) {
+                free(inherited[j].entry);
+            }
+            free(insert_entry);
+            pthread_mutex_unlock(&g_spawn_lock);
+            return PH_ERROR_MEMORY_ERROR;
+        }
+    }
+
+    memcpy(g_inherited, inherited, sizeof(g_inherited));
+    g_insert_entry = insert_entry;
+    g_library_path = insert_entry + PH_SPAWN_INSERT_PREFIX_LENGTH;
+    g_library_path_length = strlen(g_library_path);
+    atomic_store_explicit(&g_spawn_inherit_enabled, true, memory_order_release);
+
+    pthread_mutex_unlock(&g_spawn_lock);
+    return PH_SUCCESS;
+}
+
+// Bit i set for every inherited variable envp already defines
+static uint32_t ph_spawn_present_variables(char* const* envp, const char** insert_list) {
+    uint32_t present = 0;
+    *insert_list = NULL;
+    for (char* const* entry = envp; *entry != NULL; entry++) {
+        const char* variable = *entry;
+        // Every variable of interest starts with 'P' or 'D'; most do not
+        if (variable[0] != 'P' && variable[0] != 'D') {
+            continue;
+        }
+        if (strncmp(variable, PH_SPAWN_INSERT_ENV "=", PH_SPAWN_INSERT_PREFIX_LENGTH) == 0) {
+            *insert_list = variable + PH_SPAWN_INSERT_PREFIX_LENGTH;
+            continue;
+        }
+        for (size_t i = 0; i < PH_SPAWN_INHERITED_MAX; i++) {
+            size_t name_length = g_inherited[i].name_length;
+            if (strncmp(variable, g_inherited_names[i], name_length - 1) == 0 && variable[name_length - 1] == '=') {
+                present |= 1u << i;
+                break;
+            }
+        }
+    }
+    return present;
+}
+
+size_t ph_spawn_environment_size(char* const* envp, size_t* merge_size) {
+    *merge_size = 0;
+    if (!atomic_load_explicit(&g_spawn_inherit_enabled, memory_order_acquire)) {
+        return 1;
+    }
+
+    size_t count = 0;
+    const char* insert_list = NULL;
+    if (envp != NULL) {
+        for (; envp[count] != NULL; count++) {
+        }
+        ph_spawn_present_variables(envp, &insert_list);
+    }
+
+    // An existing insert list that lacks the library is extended in place
+    if (insert_list != NULL && *insert_list != '\0' &&
+        !ph_spawn_list_contains(insert_list, g_library_path, g_library_path_length)) {
+        *merge_size = PH_SPAWN_INSERT_PREFIX_LENGTH + strlen(insert_list) + 1 + g_library_path_length + 1;
+    }
+
+    // Too large for the stack: the undersized storage makes
+    // ph_spawn_environment pass envp through
+    size_t slot_count = count + PH_SPAWN_INHERITED_MAX + 2;
+    if (slot_count > PH_SPAWN_MAX_SLOTS || *merge_size > PH_SPAWN_MAX_MERGE) {
+        *merge_size = 0;
+        return 1;
+    }
+    return slot_count;
+}
+
+char* const* ph_spawn_environment(char* const* envp, char** slots, size_t slot_count,
+                                  char* merge_buffer, size_t merge_size) {
+    if (!atomic_load_explicit(&g_spawn_inherit_enabled, memory_order_acquire)) {
+        return envp;
+    }
+
+    static char* const empty_environment[] = { NULL };
+    char* const* source = envp != NULL ? envp : empty_environment;
+
+    const char* insert_list = NULL;
+    uint32_t present = ph_spawn_present_variables(source, &insert_list);
+    uint32_t missing = 0;
+    for (size_t i = 0; i < PH_SPAWN_INHERITED_MAX; i++) {
+        if (g_inherited[i].entry != NULL && !(present & (1u << i))) {
+            missing |= 1u << i;
+        }
+    }
+
+    bool needs_insert = insert_list == NULL || *insert_list == '\0';
+    bool needs_merge = !needs_insert &&
+        !ph_spawn_list_contains(insert_list, g_library_path, g_library_path_length);
+    if (missing == 0 && !needs_insert && !needs_merge) {
+        return envp;
+    }
+
+    // The sizes were computed from this same envp; a mismatch means the
+    // caller changed it in between, so the child keeps it unmodified
+    size_t count = 0;
+    for (; source[count] != NULL; count++) {
+    }
+    size_t list_length = needs_merge ? strlen(insert_list) : 0;
+    size_t required_merge = needs_merge
+        ? PH_SPAWN_INSERT_PREFIX_LENGTH + list_length + 1 + g_library_path_length + 1
+        : 0;
+    if (count + PH_SPAWN_INHERITED_MAX + 2 > slot_count || required_merge > merge_size) {
+        return envp;
+    }
+
+    char* merged = NULL;
+    if (needs_merge) {
+        merged = merge_buffer;
+        memcpy(merged, PH_SPAWN_INSERT_ENV "=", PH_SPAWN_INSERT_PREFIX_LENGTH);
+        memcpy(merged + PH_SPAWN_INSERT_PREFIX_LENGTH, insert_list, list_length);
+        merged[PH_SPAWN_INSERT_PREFIX_LENGTH + list_length] = ':';
+        memcpy(merged + PH_SPAWN_INSERT_PREFIX_LENGTH + list_length + 1, g_library_path, g_library_path_length + 1);
+    }
+
+    size_t used = 0;
+    for (size_t i = 0; i < count; i++) {
+        const char* variable = source[i];
+        if (strncmp(variable, PH_SPAWN_INSERT_ENV "=", PH_SPAWN_INSERT_PREFIX_LENGTH) == 0) {
+            // An empty list is dropped and replaced below
+            if (needs_insert) {
+                continue;
+            }
+            if (merged != NULL) {
+                slots[used++] = merged;
+                continue;
+            }
+        }
+        slots[used++] = source[i];
+    }
+    if (needs_insert) {
+        slots[used++] = g_insert_entry;
+    }
+    for (size_t i = 0; i < PH_SPAWN_INHERITED_MAX; i++) {
+        if (missing & (1u << i)) {
+            slots[used++] = g_inherited[i].entry;
+        }
+    }
+    slots[used] = NULL;
+    return slots;
+}
+
+// Only a library that was itself inserted passes itself on; a host that
+// links the library directly opts in through ph_enable_inheritance
+__attribute__((constructor))
+static void ph_spawn_load(void) {
+    const char* inserted = getenv(PH_SPAWN_INSERT_ENV);
+    Dl_info info;
+    if (inserted == NULL || dladdr((const void*)ph_spawn_load, &info) == 0 || info.dli_fname == NULL) {
+        return;
+    }
+    if (ph_spawn_list_contains(inserted, info.dli_fname, strlen(info.dli_fname))) {
+        ph_enable_inheritance(info.dli_fname);
+    }
+}
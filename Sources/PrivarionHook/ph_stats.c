@@ -0,0 +1,316 @@
+// Hook Statistics
+// Per-hook call counters and latency histograms live in a POSIX shared
+// memory region named after the hooked process, so monitoring tools can
+// map it read-only and aggregate the numbers without calling into the
+// target. Writers spread over a fixed set of cache-line-aligned shards
+// picked per thread, so concurrent hooked calls rarely share a line.
+
+#include "ph_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define PH_STATS_MAGIC 0x50485354u // "PHST"
+#define PH_STATS_LAYOUT_VERSION 2
+#define PH_STATS_SHARDS 8
+#define PH_STATS_LINEAR_BUCKETS 16
+#define PH_STATS_SUB_BUCKET_BITS 2
+#define PH_STATS_NAME_SIZE 60
+
+_Static_assert(PH_STATS_MAX_HOOKS <= PH_MAX_HOOKS, "Stats slots are indexed by registry slot");
+_Static_assert((PH_STATS_LINEAR_BUCKETS & (PH_STATS_LINEAR_BUCKETS - 1)) == 0, "Linear range must be a power of two");
+_Static_assert((PH_STATS_HISTOGRAM_BUCKETS - PH_STATS_LINEAR_BUCKETS) % (1 << PH_STATS_SUB_BUCKET_BITS) == 0,
+               "Log-linear buckets must cover whole octaves");
+
+typedef struct {
+    _Atomic uint64_t calls;
+    _Atomic uint64_t spoofed;
+    _Atomic uint64_t passthrough;
+    _Atomic uint64_t total_ns;
+    _Atomic uint64_t histogram[PH_STATS_HISTOGRAM_BUCKETS];
+} __attribute__((aligned(64))) PHStatsShard;
+
+// hook_id is cleared while the name is rewritten, so a reader that sees
+// the same non-zero ID before and after copying the name got a clean copy
+typedef struct {
+    _Atomic uint32_t hook_id;
+    char function_name[PH_STATS_NAME_SIZE];
+} PHStatsHookInfo;
+
+_Static_assert(sizeof(PHStatsHookInfo) == 64, "Hook info must occupy one cache line");
+
+typedef struct {
+    uint32_t magic;
+    uint32_t layout_version;
+    uint32_t max_hooks;
+    uint32_t shard_count;
+    uint32_t bucket_count;
+    int32_t pid;
+    char header_padding[40];
+    PHStatsHookInfo hooks[PH_STATS_MAX_HOOKS];
+    PHStatsShard shards[PH_STATS_MAX_HOOKS][PH_STATS_SHARDS];
+} PHStatsRegion;
+
+_Static_assert(offsetof(PHStatsRegion, hooks) == 64, "Header must occupy one cache line");
+
+struct PHStatsView {
+    const PHStatsRegion* region;
+};
+
+_Atomic bool g_stats_enabled = false;
+
+static PHStatsRegion* g_stats_region = NULL;
+static char g_stats_region_name[32];
+static _Atomic uint32_t g_next_stats_shard = 0;
+static __thread uint32_t t_stats_shard = UINT32_MAX;
+
+static void ph_stats_region_name(pid_t pid, char* buffer, size_t size) {
+    // Darwin limits shared memory names to 31 characters
+    snprintf(buffer, size, "/privarion.%d", (int)pid);
+}
+
+static uint32_t ph_stats_bucket(uint64_t ns) {
+    if (ns < PH_STATS_LINEAR_BUCKETS) {
+        return (uint32_t)ns;
+    }
+    // Log-linear: each power of two is split into 2^PH_STATS_SUB_BUCKET_BITS
+    // buckets, which bounds the relative error like an HDR histogram
+    uint32_t exponent = 63 - (uint32_t)__builtin_clzll(ns);
+    uint32_t sub_bucket = (uint32_t)(ns >> (exponent - PH_STATS_SUB_BUCKET_BITS)) & ((1u << PH_STATS_SUB_BUCKET_BITS) - 1);
+    uint32_t linear_exponent = (uint32_t)__builtin_ctz(PH_STATS_LINEAR_BUCKETS);
+    uint32_t bucket = PH_STATS_LINEAR_BUCKETS + ((exponent - linear_exponent) << PH_STATS_SUB_BUCKET_BITS) + sub_bucket;
+    return bucket < PH_STATS_HISTOGRAM_BUCKETS ? bucket : PH_STATS_HISTOGRAM_BUCKETS - 1;
+}
+
+uint64_t ph_stats_bucket_lower_bound(uint32_t bucket) {
+    if (bucket < PH_STATS_LINEAR_BUCKETS) {
+        return bucket;
+    }
+    if (bucket >= PH_STATS_HISTOGRAM_BUCKETS) {
+        bucket = PH_STATS_HISTOGRAM_BUCKETS - 1;
+    }
+    uint32_t offset = bucket - PH_STATS_LINEAR_BUCKETS;
+    uint32_t exponent = (uint32_t)__builtin_ctz(PH_STATS_LINEAR_BUCKETS) + (offset >> PH_STATS_SUB_BUCKET_BITS);
+    uint64_t mantissa = (1u << PH_STATS_SUB_BUCKET_BITS) + (offset & ((1u << PH_STATS_SUB_BUCKET_BITS) - 1));
+    return mantissa << (exponent - PH_STATS_SUB_BUCKET_BITS);
+}
+
+PHResult ph_stats_create_region(void) {
+    if (g_stats_region != NULL) {
+        return PH_SUCCESS;
+    }
+
+    pid_t pid = getpid();
+    ph_stats_region_name(pid, g_stats_region_name, sizeof(g_stats_region_name));
+
+    // A region left by an earlier process with the same PID is stale
+    shm_unlink(g_stats_region_name);
+    int fd = shm_open(g_stats_region_name, O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+    if (fd < 0) {
+        return PH_ERROR_PERMISSION_DENIED;
+    }
+    if (ftruncate(fd, (off_t)sizeof(PHStatsRegion)) != 0) {
+        close(fd);
+        shm_unlink(g_stats_region_name);
+        return PH_ERROR_MEMORY_ERROR;
+    }
+
+    void* memory = mmap(NULL, sizeof(PHStatsRegion), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        shm_unlink(g_stats_region_name);
+        return PH_ERROR_MEMORY_ERROR;
+    }
+
+    // The mapping starts zero-filled; only the header needs writing
+    PHStatsRegion* region = memory;
+    region->layout_version = PH_STATS_LAYOUT_VERSION;
+    region->max_hooks = PH_STATS_MAX_HOOKS;
+    region->shard_count = PH_STATS_SHARDS;
+    region->bucket_count = PH_STATS_HISTOGRAM_BUCKETS;
+    region->pid = (int32_t)pid;
+    atomic_thread_fence(memory_order_release);
+    region->magic = PH_STATS_MAGIC;
+
+    g_stats_region = region;
+    atomic_store_explicit(&g_stats_enabled, true, memory_order_release);
+    return PH_SUCCESS;
+}
+
+void ph_stats_hook_activated(const PHookEntry* entry) {
+    uint32_t index = entry->id & ((1u << PH_HOOK_INDEX_BITS) - 1);
+    if (g_stats_region == NULL || index >= PH_STATS_MAX_HOOKS) {
+        return;
+    }
+
+    PHStatsHookInfo* info = &g_stats_region->hooks[index];
+    atomic_store_explicit(&info->hook_id, 0, memory_order_release);
+    strncpy(info->function_name, entry->function_name, sizeof(info->function_name) - 1);
+    info->function_name[sizeof(info->function_name) - 1] = '\0';
+
+    // The slot may have counted a previous hook; start from zero
+    for (uint32_t shard = 0; shard < PH_STATS_SHARDS; shard++) {
+        PHStatsShard* counters = &g_stats_region->shards[index][shard];
+        atomic_store_explicit(&counters->calls, 0, memory_order_relaxed);
+        atomic_store_explicit(&counters->spoofed, 0, memory_order_relaxed);
+        atomic_store_explicit(&counters->passthrough, 0, memory_order_relaxed);
+        atomic_store_explicit(&counters->total_ns, 0, memory_order_relaxed);
+        for (uint32_t bucket = 0; bucket < PH_STATS_HISTOGRAM_BUCKETS; bucket++) {
+            atomic_store_explicit(&counters->histogram[bucket], 0, memory_order_relaxed);
+        }
+    }
+
+    atomic_store_explicit(&info->hook_id, entry->id, memory_order_release);
+}
+
+void ph_stats_hook_released(const PHookEntry* entry) {
+    uint32_t index = entry->id & ((1u << PH_HOOK_INDEX_BITS) - 1);
+    if (g_stats_region == NULL || index >= PH_STATS_MAX_HOOKS) {
+        return;
+    }
+    atomic_store_explicit(&g_stats_region->hooks[index].hook_id, 0, memory_order_release);
+}
+
+void ph_stats_record(uint32_t hook_id, PHStatsOutcome outcome, uint64_t start_ns) {
+    uint32_t index = hook_id & ((1u << PH_HOOK_INDEX_BITS) - 1);
+    if (hook_id == 0 || index >= PH_STATS_MAX_HOOKS) {
+        return;
+    }
+    PHStatsRegion* region = g_stats_region;
+    if (region == NULL || atomic_load_explicit(&region->hooks[index].hook_id, memory_order_relaxed) != hook_id) {
+        return;
+    }
+
+    uint32_t shard = t_stats_shard;
+    if (shard == UINT32_MAX) {
+        shard = t_stats_shard = atomic_fetch_add_explicit(&g_next_stats_shard, 1, memory_order_relaxed) % PH_STATS_SHARDS;
+    }
+
+    uint64_t elapsed = ph_now_ns() - start_ns;
+    PHStatsShard* counters = &region->shards[index][shard];
+    atomic_fetch_add_explicit(&counters->calls, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(outcome == PH_STATS_OUTCOME_SPOOFED ? &counters->spoofed : &counters->passthrough,
+                              1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&counters->total_ns, elapsed, memory_order_relaxed);
+    atomic_fetch_add_explicit(&counters->histogram[ph_stats_bucket(elapsed)], 1, memory_order_relaxed);
+}
+
+// Injected processes opt in through the environment set by the launcher
+__attribute__((constructor))
+static void ph_stats_load(void) {
+    const char* flag = getenv(PH_STATS_ENV);
+    if (flag != NULL && strcmp(flag, "1") == 0) {
+        ph_stats_enable();
+    }
+}
+
+// The region name is derived from the PID, so it must not outlive the process
+__attribute__((destructor))
+static void ph_stats_destroy_region(void) {
+    if (g_stats_region != NULL) {
+        shm_unlink(g_stats_region_name);
+    }
+}
+
+// The child of a fork shares its parent's mapping; it must neither count
+// into it nor unlink it on exit, so it gets a region under its own PID.
+// The caller republishes the live hooks (g_hook_mutex held).
+void ph_stats_fork_child(void) {
+    if (g_stats_region == NULL) {
+        return;
+    }
+    atomic_store_explicit(&g_stats_enabled, false, memory_order_relaxed);
+    munmap(g_stats_region, sizeof(PHStatsRegion));
+    g_stats_region = NULL;
+    ph_stats_create_region();
+}
+
+// Reader Interface
+
+PHResult ph_stats_open(pid_t pid, PHStatsView** view) {
+    if (view == NULL || pid <= 0) {
+        return PH_ERROR_INVALID_PARAM;
+    }
+
+    char name[32];
+    ph_stats_region_name(pid, name, sizeof(name));
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        return PH_ERROR_NOT_HOOKED;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(PHStatsRegion)) {
+        close(fd);
+        return PH_ERROR_NOT_HOOKED;
+    }
+
+    void* memory = mmap(NULL, sizeof(PHStatsRegion), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        return PH_ERROR_PERMISSION_DENIED;
+    }
+
+    const PHStatsRegion* region = memory;
+    if (region->magic != PH_STATS_MAGIC || region->layout_version != PH_STATS_LAYOUT_VERSION ||
+        region->max_hooks != PH_STATS_MAX_HOOKS || region->shard_count != PH_STATS_SHARDS ||
+        region->bucket_count != PH_STATS_HISTOGRAM_BUCKETS) {
+        munmap(memory, sizeof(PHStatsRegion));
+        return PH_ERROR_UNSUPPORTED_PLATFORM;
+    }
+    atomic_thread_fence(memory_order_acquire);
+
+    PHStatsView* result = malloc(sizeof(PHStatsView));
+    if (result == NULL) {
+        munmap(memory, sizeof(PHStatsRegion));
+        return PH_ERROR_MEMORY_ERROR;
+    }
+    result->region = region;
+    *view = result;
+    return PH_SUCCESS;
+}
+
+bool ph_stats_read(const PHStatsView* view, uint32_t slot, PHHookStats* stats) {
+    if (view == NULL || stats == NULL || slot >= PH_STATS_MAX_HOOKS) {
+        return false;
+    }
+
+    const PHStatsRegion* region = view->region;
+    const PHStatsHookInfo* info = &region->hooks[slot];
+    uint32_t hook_id = atomic_load_explicit((_Atomic uint32_t*)&info->hook_id, memory_order_acquire);
+    if (hook_id == 0) {
+        return false;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+    memcpy(stats->function_name, info->function_name, sizeof(info->function_name));
+    stats->function_name[sizeof(stats->function_name) - 1] = '\0';
+    stats->hook_id = hook_id;
+
+    for (uint32_t shard = 0; shard < PH_STATS_SHARDS; shard++) {
+        PHStatsShard* counters = (PHStatsShard*)&region->shards[slot][shard];
+        stats->calls += atomic_load_explicit(&counters->calls, memory_order_relaxed);
+        stats->spoofed += atomic_load_explicit(&counters->spoofed, memory_order_relaxed);
+        stats->passthrough += atomic_load_explicit(&counters->passthrough, memory_order_relaxed);
+        stats->total_ns += atomic_load_explicit(&counters->total_ns, memory_order_relaxed);
+        for (uint32_t bucket = 0; bucket < PH_STATS_HISTOGRAM_BUCKETS; bucket++) {
+            stats->histogram[bucket] += atomic_load_explicit(&counters->histogram[bucket], memory_order_relaxed);
+        }
+    }
+
+    // The slot was reassigned while we copied it
+    return atomic_load_explicit((_Atomic uint32_t*)&info->hook_id, memory_order_acquire) == hook_id;
+}
+
+void ph_stats_close(PHStatsView* view) {
+    if (view == NULL) {
+        return;
+    }
+    munmap((void*)view->region, sizeof(PHStatsRegion));
+    free(view);
+}
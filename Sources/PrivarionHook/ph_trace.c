@@ -0,0 +1,192 @@
+// Hook Tracing
+// Hooked functions record binary trace records into a ring owned by the
+// calling thread. Each ring has exactly one producer (its thread) and one
+// consumer (ph_trace_drain), so recording is a handful of plain stores and
+// one release store; a full ring drops the record instead of blocking.
+
+#include "ph_internal.h"
+#include <string.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#define PH_TRACE_RING_CAPACITY 256
+#define PH_TRACE_RING_MASK (PH_TRACE_RING_CAPACITY - 1)
+
+_Static_assert((PH_TRACE_RING_CAPACITY & PH_TRACE_RING_MASK) == 0, "Ring capacity must be a power of two");
+
+typedef struct PHTraceRing {
+    // Producer and consumer indices on separate cache lines
+    _Atomic uint64_t head;
+    char head_padding[64 - sizeof(uint64_t)];
+    _Atomic uint64_t tail;
+    char tail_padding[64 - sizeof(uint64_t)];
+
+    _Atomic uint64_t dropped;
+    _Atomic bool in_use;
+    uint64_t thread_id;
+    struct PHTraceRing* next;
+    PHTraceRecord records[PH_TRACE_RING_CAPACITY];
+} PHTraceRing;
+
+_Atomic bool g_trace_enabled = false;
+
+// Rings are never unmapped: a ring whose thread exited is handed to the
+// next thread that starts tracing
+static _Atomic(PHTraceRing*) g_trace_rings = NULL;
+static __thread PHTraceRing* t_trace_ring = NULL;
+static pthread_key_t g_trace_ring_key;
+static pthread_once_t g_trace_key_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t g_trace_consumer_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void ph_trace_thread_exit(void* ring) {
+    atomic_store_explicit(&((PHTraceRing*)ring)->in_use, false, memory_order_release);
+}
+
+static void ph_trace_create_key(void) {
+    pthread_key_create(&g_trace_ring_key, ph_trace_thread_exit);
+}
+
+uint64_t ph_current_thread_id(void) {
+#ifdef __APPLE__
+    uint64_t thread_id = 0;
+    pthread_threadid_np(NULL, &thread_id);
+    return thread_id;
+#else
+    return (uint64_t)pthread_self();
+#endif
+}
+
+static PHTraceRing* ph_trace_claim_ring(void) {
+    pthread_once(&g_trace_key_once, ph_trace_create_key);
+
+    // Reuse a ring left behind by an exited thread before mapping a new one
+    PHTraceRing* ring = atomic_load_explicit(&g_trace_rings, memory_order_acquire);
+    for (; ring != NULL; ring = ring->next) {
+        bool expected = false;
+        if (atomic_compare_exchange_strong(&ring->in_use, &expected, true)) {
+            break;
+        }
+    }
+
+    if (ring == NULL) {
+        // mmap keeps tracing independent of the target's malloc
+        void* memory = mmap(NULL, sizeof(PHTraceRing), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+        if (memory == MAP_FAILED) {
+            return NULL;
+        }
+        ring = memory;
+        atomic_store_explicit(&ring->in_use, true, memory_order_relaxed);
+        PHTraceRing* head = atomic_load_explicit(&g_trace_rings, memory_order_relaxed);
+        do {
+            ring->next = head;
+        } while (!atomic_compare_exchange_weak_explicit(&g_trace_rings, &head, ring,
+                                                        memory_order_release, memory_order_relaxed));
+    }
+
+    ring->thread_id = ph_current_thread_id();
+    pthread_setspecific(g_trace_ring_key, ring);
+    return ring;
+}
+
+void ph_trace_emit(uint32_t hook_id, int64_t return_value) {
+    // Handle IDs are never 0; a call with no installed handle is not traced
+    if (hook_id == 0) {
+        return;
+    }
+
+    PHTraceRing* ring = t_trace_ring;
+    if (ring == NULL) {
+        ring = t_trace_ring = ph_trace_claim_ring();
+        if (ring == NULL) {
+            return;
+        }
+    }
+
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail >= PH_TRACE_RING_CAPACITY) {
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    PHTraceRecord* record = &ring->records[head & PH_TRACE_RING_MASK];
+    record->timestamp_ns = ph_now_ns();
+    record->thread_id = ring->thread_id;
+    record->return_value = return_value;
+    record->hook_id = hook_id;
+    record->reserved = 0;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+void ph_set_tracing_enabled(bool enabled) {
+    atomic_store_explicit(&g_trace_enabled, enabled, memory_order_relaxed);
+}
+
+bool ph_is_tracing_available(void) {
+#ifdef PRIVARION_HOOK_NO_TRACE
+    return false;
+#else
+    return true;
+#endif
+}
+
+size_t ph_trace_drain(PHTraceRecord* records, size_t capacity) {
+    if (records == NULL || capacity == 0) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&g_trace_consumer_lock);
+
+    size_t drained = 0;
+    PHTraceRing* ring = atomic_load_explicit(&g_trace_rings, memory_order_acquire);
+    for (; ring != NULL && drained < capacity; ring = ring->next) {
+        uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        while (tail < head && drained < capacity) {
+            records[drained++] = ring->records[tail & PH_TRACE_RING_MASK];
+            tail++;
+        }
+        atomic_store_explicit(&ring->tail, tail, memory_order_release);
+    }
+
+    pthread_mutex_unlock(&g_trace_consumer_lock);
+    return drained;
+}
+
+uint64_t ph_trace_dropped_count(void) {
+    uint64_t dropped = 0;
+    PHTraceRing* ring = atomic_load_explicit(&g_trace_rings, memory_order_acquire);
+    for (; ring != NULL; ring = ring->next) {
+        dropped += atomic_load_explicit(&ring->dropped, memory_order_relaxed);
+    }
+    return dropped;
+}
+
+// Fork Safety
+// Only the forking thread survives in the child; the other rings are
+// handed back for reuse and every ring starts empty, so the child never
+// drains records its parent produced.
+
+void ph_trace_fork_prepare(void) {
+    pthread_mutex_lock(&g_trace_consumer_lock);
+}
+
+void ph_trace_fork_parent(void) {
+    pthread_mutex_unlock(&g_trace_consumer_lock);
+}
+
+void ph_trace_fork_child(void) {
+    PHTraceRing* ring = atomic_load_explicit(&g_trace_rings, memory_order_acquire);
+    for (; ring != NULL; ring = ring->next) {
+        atomic_store_explicit(&ring->tail, atomic_load_explicit(&ring->head, memory_order_relaxed), memory_order_relaxed);
+        atomic_store_explicit(&ring->dropped, 0, memory_order_relaxed);
+        if (ring != t_trace_ring) {
+            ring->thread_id = 0;
+            atomic_store_explicit(&ring->in_use, false, memory_order_relaxed);
+        }
+    }
+    if (t_trace_ring != NULL) {
+        t_trace_ring->thread_id = ph_current_thread_id();
+    }
+    pthread_mutex_init(&g_trace_consumer_lock, NULL);
+}
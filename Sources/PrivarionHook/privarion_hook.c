@@ -1,4 +1,5 @@
 #include "include/privarion_hook.h"
+#include "ph_internal.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -7,80 +8,530 @@
 #include <sys/utsname.h>
 #include <unistd.h>
 #include <pthread.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <spawn.h>
+#ifdef __APPLE__
+#include <CoreFoundation/CoreFoundation.h>
+#endif
 
 // Global state management
 static bool g_hook_system_initialized = false;
-static bool g_debug_logging_enabled = false;
-static PHookEntry* g_hook_list_head = NULL;
+static _Atomic bool g_debug_logging_enabled = false;
 static pthread_mutex_t g_hook_mutex = PTHREAD_MUTEX_INITIALIZER;
-static uint32_t g_next_hook_id = 1;
-
-// Global configuration data for hooks
-static PHookConfigData g_config_data = {0};
 
 // Internal helper functions
-static void ph_log_debug(const char* format, ...);
-static PHookEntry* ph_find_hook_by_name(const char* function_name);
-static PHookEntry* ph_find_hook_by_id(uint32_t id);
+static void ph_log_debug_write(const char* format, ...) __attribute__((format(printf, 1, 2)));
 static void ph_free_hook_entry(PHookEntry* entry);
 
+// Debug logging is for install and remove paths only; the arguments are
+// not evaluated unless logging is enabled. Hooked functions use PH_TRACE.
+#define ph_log_debug(...) \
+    do { \
+        if (atomic_load_explicit(&g_debug_logging_enabled, memory_order_relaxed)) { \
+            ph_log_debug_write(__VA_ARGS__); \
+        } \
+    } while (0)
+
+// Built-in replacements selected by a NULL PHookSpec.replacement_function
+enum {
+    PH_BUILTIN_GETUID,
+    PH_BUILTIN_GETGID,
+    PH_BUILTIN_GETHOSTNAME,
+    PH_BUILTIN_UNAME,
+    PH_BUILTIN_SYSCTLBYNAME,
+    PH_BUILTIN_IOREGISTRY,
+    PH_BUILTIN_PROFILE_COUNT,
+    // Inheritance replacements, only installed by ph_enable_inheritance
+    PH_BUILTIN_POSIX_SPAWN = PH_BUILTIN_PROFILE_COUNT,
+    PH_BUILTIN_POSIX_SPAWNP,
+    PH_BUILTIN_EXECVE,
+    PH_BUILTIN_COUNT
+};
+
+_Static_assert(PH_PROFILE_HOOK_GETUID == (1u << PH_BUILTIN_GETUID) &&
+               PH_PROFILE_HOOK_GETGID == (1u << PH_BUILTIN_GETGID) &&
+               PH_PROFILE_HOOK_GETHOSTNAME == (1u << PH_BUILTIN_GETHOSTNAME) &&
+               PH_PROFILE_HOOK_UNAME == (1u << PH_BUILTIN_UNAME) &&
+               PH_PROFILE_HOOK_SYSCTLBYNAME == (1u << PH_BUILTIN_SYSCTLBYNAME) &&
+               PH_PROFILE_HOOK_IOREGISTRY == (1u << PH_BUILTIN_IOREGISTRY),
+               "Profile hook bits must follow the built-in order");
+
+// Handle IDs and originals of the installed built-in replacements, so
+// trace records and statistics carry the ID the caller got back and the
+// replacement can pass through; zero while not installed
+static struct {
+    _Atomic uint32_t hook_id;
+    _Atomic(void*) original_function;
+} g_builtin_hooks[PH_BUILTIN_COUNT];
+
+#define PH_HOOK_BEGIN(builtin, syscall) \
+    const PHSyscallId ph_hook_syscall = (syscall); \
+    const uint32_t ph_hook_id = atomic_load_explicit(&g_builtin_hooks[builtin].hook_id, memory_order_relaxed); \
+    const uint64_t ph_hook_start = PH_STATS_START()
+
+#define PH_HOOK_END(outcome, return_value) PH_HOOK_END_EVENT(outcome, NULL, NULL, return_value)
+#define PH_HOOK_END_PATH(outcome, path, return_value) PH_HOOK_END_EVENT(outcome, path, NULL, return_value)
+#define PH_HOOK_END_ARGUMENT(outcome, argument, return_value) PH_HOOK_END_EVENT(outcome, NULL, argument, return_value)
+
+#define PH_HOOK_END_EVENT(outcome, path, argument, return_value) \
+    do { \
+        PH_TRACE(ph_hook_id, return_value); \
+        PH_EVENT(ph_hook_syscall, ph_hook_id, path, argument, return_value); \
+        PH_STATS_RECORD(ph_hook_id, outcome, ph_hook_start); \
+    } while (0)
+
+// Lazy Activation
+// With lazy activation an install reserves the entry and patches the
+// symbol pointers, but the original is only looked up with dlsym when a
+// replacement or ph_get_original first needs it. Hooks the process never
+// calls never pay for symbol resolution, and a function whose library is
+// not loaded yet is patched once an image importing it loads.
+
+static pthread_once_t g_lazy_activation_once = PTHREAD_ONCE_INIT;
+static _Atomic bool g_lazy_activation = false;
+
+static struct {
+    _Atomic uint32_t hooks_installed;
+    _Atomic uint32_t originals_resolved;
+    _Atomic uint64_t install_ns;
+    _Atomic uint64_t lazy_resolve_ns;
+} g_activation_stats;
+
+static void* ph_resolve_builtin(size_t builtin) __attribute__((noinline, cold));
+
+// The resolver only runs on the first call through a lazily installed
+// built-in; afterwards this is the same single load as an eager install
+static inline void* ph_builtin_original(size_t builtin) {
+    void* original = atomic_load_explicit(&g_builtin_hooks[builtin].original_function, memory_order_relaxed);
+    if (__builtin_expect(original == NULL, 0)) {
+        original = ph_resolve_builtin(builtin);
+    }
+    return original;
+}
+
+#define PH_HOOK_ORIGINAL(builtin) ph_builtin_original(builtin)
+
 // Pre-defined replacement functions
+// These run on the hot path of the hooked process: they only touch the
+// published configuration snapshot and never take g_hook_mutex. Until a
+// configuration is published they pass through to the original.
+
+// Identity values are read in tight loops by some runtimes, so each thread
+// keeps its own copy and only visits the snapshot when the generation moves
+typedef struct {
+    uint64_t generation;
+    uid_t user_id;
+    gid_t group_id;
+} PHIdentityCache;
+
+static __thread PHIdentityCache t_identity_cache;
+
+static __attribute__((noinline)) void ph_refresh_identity_cache(PHIdentityCache* cache) {
+    uint32_t token;
+    const PHConfigSnapshot* config = ph_config_read_begin(&token);
+    cache->user_id = config->data.user_id;
+    cache->group_id = config->data.group_id;
+    cache->generation = config->version;
+    ph_config_read_end(token);
+}
+
+// Returns the calling thread's cache, or NULL before any configuration
+static inline const PHIdentityCache* ph_identity_cache(void) {
+    uint64_t generation = atomic_load_explicit(&g_config_generation, memory_order_acquire);
+    if (__builtin_expect(generation == 0, 0)) {
+        return NULL;
+    }
+    PHIdentityCache* cache = &t_identity_cache;
+    if (__builtin_expect(cache->generation != generation, 0)) {
+        ph_refresh_identity_cache(cache);
+    }
+    return cache;
+}
 
 static uid_t hooked_getuid(void) {
-    ph_log_debug("getuid() called, returning fake user ID: %d", g_config_data.user_id);
-    return g_config_data.user_id;
+    PH_HOOK_BEGIN(PH_BUILTIN_GETUID, PH_SYSCALL_GETUID);
+    const PHIdentityCache* cache = ph_identity_cache();
+    
+    uid_t (*original)(void) = PH_HOOK_ORIGINAL(PH_BUILTIN_GETUID);
+    if (cache == NULL && original) {
+        uid_t user_id = original();
+        PH_HOOK_END(PH_STATS_OUTCOME_PASSTHROUGH, user_id);
+        return user_id;
+    }
+    uid_t user_id = cache ? cache->user_id : 0;
+    PH_HOOK_END(PH_STATS_OUTCOME_SPOOFED, user_id);
+    return user_id;
 }
 
 static gid_t hooked_getgid(void) {
-    ph_log_debug("getgid() called, returning fake group ID: %d", g_config_data.group_id);
-    return g_config_data.group_id;
+    PH_HOOK_BEGIN(PH_BUILTIN_GETGID, PH_SYSCALL_GETGID);
+    const PHIdentityCache* cache = ph_identity_cache();
+    
+    gid_t (*original)(void) = PH_HOOK_ORIGINAL(PH_BUILTIN_GETGID);
+    if (cache == NULL && original) {
+        gid_t group_id = original();
+        PH_HOOK_END(PH_STATS_OUTCOME_PASSTHROUGH, group_id);
+        return group_id;
+    }
+    gid_t group_id = cache ? cache->group_id : 0;
+    PH_HOOK_END(PH_STATS_OUTCOME_SPOOFED, group_id);
+    return group_id;
 }
 
 static int hooked_gethostname(char* name, size_t len) {
-    ph_log_debug("gethostname() called, returning fake hostname: %s", g_config_data.hostname);
-    size_t hostname_len = strlen(g_config_data.hostname);
+    PH_HOOK_BEGIN(PH_BUILTIN_GETHOSTNAME, PH_SYSCALL_GETHOSTNAME);
+    uint32_t token;
+    const PHConfigSnapshot* config = ph_config_read_begin(&token);
+    
+    int (*original)(char*, size_t) = PH_HOOK_ORIGINAL(PH_BUILTIN_GETHOSTNAME);
+    if (config->version == 0 && original) {
+        ph_config_read_end(token);
+        int result = original(name, len);
+        PH_HOOK_END(PH_STATS_OUTCOME_PASSTHROUGH, result);
+        return result;
+    }
+    
+    size_t hostname_len = config->hostname_length;
     if (len <= hostname_len) {
+        ph_config_read_end(token);
+        PH_HOOK_END(PH_STATS_OUTCOME_SPOOFED, -1);
         return -1; // ENAMETOOLONG
     }
-    // Use strncpy with explicit null termination to prevent buffer overflow
-    strncpy(name, g_config_data.hostname, len - 1);
-    name[len - 1] = '\0';
+    memcpy(name, config->data.hostname, hostname_len + 1);
+    ph_config_read_end(token);
+    PH_HOOK_END(PH_STATS_OUTCOME_SPOOFED, 0);
     return 0;
 }
 
 static int hooked_uname(struct utsname* buf) {
-    ph_log_debug("uname() called, returning fake system information");
+    PH_HOOK_BEGIN(PH_BUILTIN_UNAME, PH_SYSCALL_UNAME);
     if (buf == NULL) {
+        PH_HOOK_END(PH_STATS_OUTCOME_SPOOFED, -1);
         return -1;
     }
     
-    strncpy(buf->sysname, g_config_data.system_name, sizeof(buf->sysname) - 1);
-    strncpy(buf->machine, g_config_data.machine, sizeof(buf->machine) - 1);
-    strncpy(buf->release, g_config_data.release, sizeof(buf->release) - 1);
-    strncpy(buf->version, g_config_data.version, sizeof(buf->version) - 1);
-    strncpy(buf->nodename, g_config_data.hostname, sizeof(buf->nodename) - 1);
+    uint32_t token;
+    const PHConfigSnapshot* config = ph_config_read_begin(&token);
     
-    // Ensure null termination
-    buf->sysname[sizeof(buf->sysname) - 1] = '\0';
-    buf->machine[sizeof(buf->machine) - 1] = '\0';
-    buf->release[sizeof(buf->release) - 1] = '\0';
-    buf->version[sizeof(buf->version) - 1] = '\0';
-    buf->nodename[sizeof(buf->nodename) - 1] = '\0';
+    int (*original)(struct utsname*) = PH_HOOK_ORIGINAL(PH_BUILTIN_UNAME);
+    if (config->version == 0 && original) {
+        ph_config_read_end(token);
+        int result = original(buf);
+        PH_HOOK_END(PH_STATS_OUTCOME_PASSTHROUGH, result);
+        return result;
+    }
     
+    memcpy(buf, &config->uname_template, sizeof(struct utsname));
+    ph_config_read_end(token);
+    PH_HOOK_END(PH_STATS_OUTCOME_SPOOFED, 0);
     return 0;
 }
 
+// Identifier lookups. The length mask is tested before anything else, so
+// names the table cannot hold pass through without a read section.
+
+static int hooked_sysctlbyname(const char* name, void* oldp, size_t* oldlenp, void* newp, size_t newlen) {
+    PH_HOOK_BEGIN(PH_BUILTIN_SYSCTLBYNAME, PH_SYSCALL_SYSCTLBYNAME);
+    int (*original)(const char*, void*, size_t*, void*, size_t) = PH_HOOK_ORIGINAL(PH_BUILTIN_SYSCTLBYNAME);
+    
+    // Writes always reach the kernel
+    size_t length = name != NULL && newp == NULL ? strnlen(name, PH_IDENTIFIERS_MAX_KEY_LENGTH + 1) : 0;
+    if (length > 0 && ph_identifiers_may_contain(PH_IDENTIFIER_SYSCTL, length)) {
+        uint32_t token;
+        ph_config_read_begin(&token);
+        const PHIdentifierEntry* entry = ph_identifiers_find(ph_config_identifiers(), PH_IDENTIFIER_SYSCTL, name, length);
+        if (entry != NULL) {
+            // Same contract as the kernel: a NULL buffer asks for the size,
+            // a short one gets a truncated copy and ENOMEM
+            int result = 0;
+            if (oldlenp == NULL) {
+                errno = EINVAL;
+                result = -1;
+            } else if (oldp == NULL) {
+                *oldlenp = entry->value_length;
+            } else {
+                size_t copied = *oldlenp < entry->value_length ? *oldlenp : entry->value_length;
+                memcpy(oldp, entry->value, copied);
+                *oldlenp = copied;
+                if (copied < entry->value_length) {
+                    errno = ENOMEM;
+                    result = -1;
+                }
+            }
+            ph_config_read_end(token);
+            PH_HOOK_END_ARGUMENT(PH_STATS_OUTCOME_SPOOFED, name, result);
+            return result;
+        }
+        ph_config_read_end(token);
+    }
+    
+    int result = original ? original(name, oldp, oldlenp, newp, newlen) : -1;
+    PH_HOOK_END_ARGUMENT(PH_STATS_OUTCOME_PASSTHROUGH, name, result);
+    return result;
+}
+
+#ifdef __APPLE__
+// io_registry_entry_t and IOOptionBits are both 32-bit, which keeps IOKit
+// out of this library; the original is only ever reached through dlsym
+static CFTypeRef hooked_IORegistryEntryCreateCFProperty(uint32_t entry_port, CFStringRef key,
+                                                        CFAllocatorRef allocator, uint32_t options) {
+    PH_HOOK_BEGIN(PH_BUILTIN_IOREGISTRY, PH_SYSCALL_IOREGISTRY);
+    CFTypeRef (*original)(uint32_t, CFStringRef, CFAllocatorRef, uint32_t) = PH_HOOK_ORIGINAL(PH_BUILTIN_IOREGISTRY);
+    
+    // Registry keys are ASCII, so the UTF-16 length is the byte length
+    CFIndex key_length = key != NULL ? CFStringGetLength(key) : 0;
+    if (key_length > 0 && ph_identifiers_may_contain(PH_IDENTIFIER_IOREGISTRY, (size_t)key_length)) {
+        char buffer[PH_IDENTIFIERS_MAX_KEY_LENGTH + 1];
+        const char* name = CFStringGetCStringPtr(key, kCFStringEncodingUTF8);
+        if (name == NULL && CFStringGetCString(key, buffer, sizeof(buffer), kCFStringEncodingUTF8)) {
+            name = buffer;
+        }
+        if (name != NULL) {
+            uint32_t token;
+            ph_config_read_begin(&token);
+            const PHIdentifierEntry* spoofed = ph_identifiers_find(ph_config_identifiers(), PH_IDENTIFIER_IOREGISTRY,
+                                                                   name, strlen(name));
+            CFTypeRef value = spoofed != NULL ? CFRetain(spoofed->object) : NULL;
+            ph_config_read_end(token);
+            if (value != NULL) {
+                PH_HOOK_END(PH_STATS_OUTCOME_SPOOFED, 1);
+                return value;
+            }
+        }
+    }
+    
+    CFTypeRef value = original ? original(entry_port, key, allocator, options) : NULL;
+    PH_HOOK_END(PH_STATS_OUTCOME_PASSTHROUGH, value != NULL);
+    return value;
+}
+#endif
+
+// Process inheritance. The child environment is rebuilt on the stack, so
+// execve stays safe in the child of a fork; ph_spawn_environment_size caps
+// the storage, and an environment too large for it is passed through. A
+// call whose environment already carries everything is counted as
+// passthrough.
+
+typedef int (*PHSpawnFunction)(pid_t*, const char*, const posix_spawn_file_actions_t*,
+                               const posix_spawnattr_t*, char* const[], char* const[]);
+
+static int hooked_posix_spawn(pid_t* pid, const char* path, const posix_spawn_file_actions_t* file_actions,
+                              const posix_spawnattr_t* attributes, char* const argv[], char* const envp[]) {
+    PH_HOOK_BEGIN(PH_BUILTIN_POSIX_SPAWN, PH_SYSCALL_POSIX_SPAWN);
+    PHSpawnFunction original = PH_HOOK_ORIGINAL(PH_BUILTIN_POSIX_SPAWN);
+    
+    size_t merge_size;
+    size_t slot_count = ph_spawn_environment_size(envp, &merge_size);
+    char* slots[slot_count];
+    char merge_buffer[merge_size + 1];
+    char* const* environment = ph_spawn_environment(envp, slots, slot_count, merge_buffer, merge_size);
+    
+    int result = original ? original(pid, path, file_actions, attributes, argv, environment) : ENOSYS;
+    PH_HOOK_END_PATH(environment == envp ? PH_STATS_OUTCOME_PASSTHROUGH : PH_STATS_OUTCOME_SPOOFED, path, result);
+    return result;
+}
+
+static int hooked_posix_spawnp(pid_t* pid, const char* file, const posix_spawn_file_actions_t* file_actions,
+                               const posix_spawnattr_t* attributes, char* const argv[], char* const envp[]) {
+    PH_HOOK_BEGIN(PH_BUILTIN_POSIX_SPAWNP, PH_SYSCALL_POSIX_SPAWN);
+    PHSpawnFunction original = PH_HOOK_ORIGINAL(PH_BUILTIN_POSIX_SPAWNP);
+    
+    size_t merge_size;
+    size_t slot_count = ph_spawn_environment_size(envp, &merge_size);
+    char* slots[slot_count];
+    char merge_buffer[merge_size + 1];
+    char* const* environment = ph_spawn_environment(envp, slots, slot_count, merge_buffer, merge_size);
+    
+    int result = original ? original(pid, file, file_actions, attributes, argv, environment) : ENOSYS;
+    PH_HOOK_END_PATH(environment == envp ? PH_STATS_OUTCOME_PASSTHROUGH : PH_STATS_OUTCOME_SPOOFED, file, result);
+    return result;
+}
+
+static int hooked_execve(const char* path, char* const argv[], char* const envp[]) {
+    PH_HOOK_BEGIN(PH_BUILTIN_EXECVE, PH_SYSCALL_EXECVE);
+    int (*original)(const char*, char* const[], char* const[]) = PH_HOOK_ORIGINAL(PH_BUILTIN_EXECVE);
+    
+    size_t merge_size;
+    size_t slot_count = ph_spawn_environment_size(envp, &merge_size);
+    char* slots[slot_count];
+    char merge_buffer[merge_size + 1];
+    char* const* environment = ph_spawn_environment(envp, slots, slot_count, merge_buffer, merge_size);
+    
+    // A successful execve never returns, so the call is recorded up front
+    PH_HOOK_END_PATH(environment == envp ? PH_STATS_OUTCOME_PASSTHROUGH : PH_STATS_OUTCOME_SPOOFED, path, 0);
+    if (original == NULL) {
+        errno = ENOSYS;
+        return -1;
+    }
+    return original(path, argv, environment);
+}
+
+uid_t ph_spoofed_getuid(uid_t fallback) {
+    const PHIdentityCache* cache = ph_identity_cache();
+    return cache ? cache->user_id : fallback;
+}
+
+gid_t ph_spoofed_getgid(gid_t fallback) {
+    const PHIdentityCache* cache = ph_identity_cache();
+    return cache ? cache->group_id : fallback;
+}
+
+int ph_spoofed_uname(struct utsname* buf) {
+    if (ph_config_current_version() == 0) {
+        return -1;
+    }
+    return hooked_uname(buf);
+}
+
+int ph_spoofed_gethostname(char* name, size_t len) {
+    if (name == NULL || ph_config_current_version() == 0) {
+        return -1;
+    }
+    return hooked_gethostname(name, len);
+}
+
+static const struct {
+    const char* function_name;
+    void* replacement_function;
+} g_builtin_replacements[PH_BUILTIN_COUNT] = {
+    [PH_BUILTIN_GETUID] = { "getuid", (void*)hooked_getuid },
+    [PH_BUILTIN_GETGID] = { "getgid", (void*)hooked_getgid },
+    [PH_BUILTIN_GETHOSTNAME] = { "gethostname", (void*)hooked_gethostname },
+    [PH_BUILTIN_UNAME] = { "uname", (void*)hooked_uname },
+    [PH_BUILTIN_SYSCTLBYNAME] = { "sysctlbyname", (void*)hooked_sysctlbyname },
+#ifdef __APPLE__
+    [PH_BUILTIN_IOREGISTRY] = { "IORegistryEntryCreateCFProperty", (void*)hooked_IORegistryEntryCreateCFProperty },
+#else
+    [PH_BUILTIN_IOREGISTRY] = { "IORegistryEntryCreateCFProperty", NULL },
+#endif
+    [PH_BUILTIN_POSIX_SPAWN] = { "posix_spawn", (void*)hooked_posix_spawn },
+    [PH_BUILTIN_POSIX_SPAWNP] = { "posix_spawnp", (void*)hooked_posix_spawnp },
+    [PH_BUILTIN_EXECVE] = { "execve", (void*)hooked_execve },
+};
+
+static void ph_activation_record_resolution(uint64_t start_ns) {
+    atomic_fetch_add_explicit(&g_activation_stats.originals_resolved, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&g_activation_stats.lazy_resolve_ns, ph_now_ns() - start_ns, memory_order_relaxed);
+}
+
+static void ph_activation_record_install(size_t count, size_t resolved, uint64_t start_ns) {
+    atomic_fetch_add_explicit(&g_activation_stats.hooks_installed, (uint32_t)count, memory_order_relaxed);
+    atomic_fetch_add_explicit(&g_activation_stats.originals_resolved, (uint32_t)resolved, memory_order_relaxed);
+    atomic_fetch_add_explicit(&g_activation_stats.install_ns, ph_now_ns() - start_ns, memory_order_relaxed);
+}
+
+// Racing first calls may both resolve; dlsym answers the same for both
+static void* ph_resolve_builtin(size_t builtin) {
+    // A replacement called without its hook installed has nothing to cache
+    if (atomic_load_explicit(&g_builtin_hooks[builtin].hook_id, memory_order_relaxed) == 0) {
+        return NULL;
+    }
+    
+    uint64_t start = ph_now_ns();
+    void* original = dlsym(RTLD_DEFAULT, g_builtin_replacements[builtin].function_name);
+    void* expected = NULL;
+    if (original != NULL &&
+        atomic_compare_exchange_strong_explicit(&g_builtin_hooks[builtin].original_function, &expected, original,
+                                                memory_order_relaxed, memory_order_relaxed)) {
+        ph_activation_record_resolution(start);
+    }
+    return original;
+}
+
+static void ph_lazy_activation_load(void) {
+    const char* flag = getenv(PH_LAZY_ENV);
+    if (flag != NULL && strcmp(flag, "1") == 0) {
+        atomic_store_explicit(&g_lazy_activation, true, memory_order_relaxed);
+    }
+}
+
+void ph_set_lazy_activation(bool enabled) {
+    pthread_once(&g_lazy_activation_once, ph_lazy_activation_load);
+    atomic_store_explicit(&g_lazy_activation, enabled, memory_order_relaxed);
+}
+
+// Read on first use rather than from a constructor, which might run after
+// the profile constructor that installs the first hooks
+bool ph_is_lazy_activation_enabled(void) {
+    pthread_once(&g_lazy_activation_once, ph_lazy_activation_load);
+    return atomic_load_explicit(&g_lazy_activation, memory_order_relaxed);
+}
+
+void ph_get_activation_stats(PHActivationStats* stats) {
+    if (stats == NULL) {
+        return;
+    }
+    stats->hooks_installed = atomic_load_explicit(&g_activation_stats.hooks_installed, memory_order_relaxed);
+    stats->originals_resolved = atomic_load_explicit(&g_activation_stats.originals_resolved, memory_order_relaxed);
+    stats->install_ns = atomic_load_explicit(&g_activation_stats.install_ns, memory_order_relaxed);
+    stats->lazy_resolve_ns = atomic_load_explicit(&g_activation_stats.lazy_resolve_ns, memory_order_relaxed);
+}
+
+static PHResult ph_install_hook_batch(const PHookSpec* specs, size_t count, PHookHandle* handles,
+                                      bool lazy, bool skip_unloaded);
+
+static void* ph_builtin_replacement(const char* function_name) {
+    for (size_t i = 0; i < PH_BUILTIN_COUNT; i++) {
+        if (strcmp(g_builtin_replacements[i].function_name, function_name) == 0) {
+            return g_builtin_replacements[i].replacement_function;
+        }
+    }
+    return NULL;
+}
+
+// Bookkeeping shared by every install path once an entry is live
+static void ph_hook_activated(PHookEntry* entry) {
+    ph_registry_activate(entry);
+    ph_stats_hook_activated(entry);
+    ph_events_hook_activated(entry);
+    for (size_t i = 0; i < PH_BUILTIN_COUNT; i++) {
+        if (g_builtin_replacements[i].replacement_function == entry->replacement_function) {
+            atomic_store_explicit(&g_builtin_hooks[i].original_function, entry->original_function, memory_order_relaxed);
+            atomic_store_explicit(&g_builtin_hooks[i].hook_id, entry->id, memory_order_relaxed);
+            break;
+        }
+    }
+}
+
+// Counterpart of ph_hook_activated; the rebinding must already be detached
+static void ph_hook_deactivated(PHookEntry* entry) {
+    for (size_t i = 0; i < PH_BUILTIN_COUNT; i++) {
+        if (atomic_load_explicit(&g_builtin_hooks[i].hook_id, memory_order_relaxed) == entry->id) {
+            atomic_store_explicit(&g_builtin_hooks[i].hook_id, 0, memory_order_relaxed);
+            atomic_store_explicit(&g_builtin_hooks[i].original_function, NULL, memory_order_relaxed);
+            break;
+        }
+    }
+    ph_stats_hook_released(entry);
+    ph_events_hook_released(entry);
+    ph_registry_release(entry);
+}
+
 // Configuration-driven hook installation functions
 
+PHResult ph_update_config(const PHookConfigData* config_data) {
+    if (config_data == NULL) {
+        return PH_ERROR_INVALID_PARAM;
+    }
+    
+    ph_log_debug("Publishing configuration snapshot");
+    return ph_config_publish(config_data, PH_CONFIG_FIELD_ALL);
+}
+
+uint64_t ph_get_config_version(void) {
+    return ph_config_current_version();
+}
+
 PHResult ph_install_getuid_hook(const PHookConfigData* config_data, PHookHandle* handle) {
     if (config_data == NULL || handle == NULL) {
         return PH_ERROR_INVALID_PARAM;
     }
     
-    // Thread-safe update of global configuration
-    pthread_mutex_lock(&g_hook_mutex);
-    g_config_data.user_id = config_data->user_id;
-    pthread_mutex_unlock(&g_hook_mutex);
+    PHResult result = ph_config_publish(config_data, PH_CONFIG_FIELD_USER_ID);
+    if (result != PH_SUCCESS) {
+        return result;
+    }
     
     ph_log_debug("Installing getuid hook with fake user ID: %d", config_data->user_id);
     
@@ -92,10 +543,10 @@ PHResult ph_install_getgid_hook(const PHookConfigData* config_data, PHookHandle*
         return PH_ERROR_INVALID_PARAM;
     }
     
-    // Thread-safe update of global configuration
-    pthread_mutex_lock(&g_hook_mutex);
-    g_config_data.group_id = config_data->group_id;
-    pthread_mutex_unlock(&g_hook_mutex);
+    PHResult result = ph_config_publish(config_data, PH_CONFIG_FIELD_GROUP_ID);
+    if (result != PH_SUCCESS) {
+        return result;
+    }
     
     ph_log_debug("Installing getgid hook with fake group ID: %d", config_data->group_id);
     
@@ -107,9 +558,11 @@ PHResult ph_install_gethostname_hook(const PHookConfigData* config_data, PHookHa
         return PH_ERROR_INVALID_PARAM;
     }
     
-    // Update global configuration
-    strncpy(g_config_data.hostname, config_data->hostname, sizeof(g_config_data.hostname) - 1);
-    g_config_data.hostname[sizeof(g_config_data.hostname) - 1] = '\0';
+    PHResult result = ph_config_publish(config_data, PH_CONFIG_FIELD_HOSTNAME);
+    if (result != PH_SUCCESS) {
+        return result;
+    }
+    
     ph_log_debug("Installing gethostname hook with fake hostname: %s", config_data->hostname);
     
     return ph_install_hook("gethostname", (void*)hooked_gethostname, handle);
@@ -120,25 +573,133 @@ PHResult ph_install_uname_hook(const PHookConfigData* config_data, PHookHandle*
         return PH_ERROR_INVALID_PARAM;
     }
     
-    // Update global configuration
-    strncpy(g_config_data.system_name, config_data->system_name, sizeof(g_config_data.system_name) - 1);
-    strncpy(g_config_data.machine, config_data->machine, sizeof(g_config_data.machine) - 1);
-    strncpy(g_config_data.release, config_data->release, sizeof(g_config_data.release) - 1);
-    strncpy(g_config_data.version, config_data->version, sizeof(g_config_data.version) - 1);
-    strncpy(g_config_data.hostname, config_data->hostname, sizeof(g_config_data.hostname) - 1);
-    
-    // Ensure null termination
-    g_config_data.system_name[sizeof(g_config_data.system_name) - 1] = '\0';
-    g_config_data.machine[sizeof(g_config_data.machine) - 1] = '\0';
-    g_config_data.release[sizeof(g_config_data.release) - 1] = '\0';
-    g_config_data.version[sizeof(g_config_data.version) - 1] = '\0';
-    g_config_data.hostname[sizeof(g_config_data.hostname) - 1] = '\0';
+    // uname() reports the hostname as nodename, so both are published together
+    PHResult result = ph_config_publish(config_data, PH_CONFIG_FIELD_SYSTEM_INFO | PH_CONFIG_FIELD_HOSTNAME);
+    if (result != PH_SUCCESS) {
+        return result;
+    }
     
     ph_log_debug("Installing uname hook with fake system: %s", config_data->system_name);
     
     return ph_install_hook("uname", (void*)hooked_uname, handle);
 }
 
+PHResult ph_apply_profile(const PHProfileRecord* profile) {
+    if (profile == NULL) {
+        return PH_ERROR_INVALID_PARAM;
+    }
+    
+    PHResult result = ph_initialize();
+    if (result != PH_SUCCESS) {
+        return result;
+    }
+    
+    result = ph_config_publish(&profile->config, PH_CONFIG_FIELD_ALL);
+    if (result != PH_SUCCESS) {
+        return result;
+    }
+    
+    PHookSpec specs[PH_BUILTIN_PROFILE_COUNT];
+    PHookHandle handles[PH_BUILTIN_PROFILE_COUNT];
+    size_t count = 0;
+    for (size_t i = 0; i < PH_BUILTIN_PROFILE_COUNT; i++) {
+        if (profile->hook_mask & (1u << i)) {
+            specs[count].function_name = g_builtin_replacements[i].function_name;
+            specs[count].replacement_function = NULL;
+            count++;
+        }
+    }
+    
+    // A host that never loaded IOKit has no registry calls to answer;
+    // a lazy install is kept and patches IOKit's callers once it loads
+    ph_log_debug("Applying hook profile with %zu hooks", count);
+    return count > 0 ? ph_install_loaded_hooks(specs, count, handles) : PH_SUCCESS;
+}
+
+PHResult ph_enable_inheritance(const char* library_path) {
+    PHResult result = ph_initialize();
+    if (result != PH_SUCCESS) {
+        return result;
+    }
+    
+    result = ph_spawn_capture(library_path);
+    if (result != PH_SUCCESS) {
+        return result;
+    }
+    
+    // A host that already hooks one of these keeps its own replacement
+    PHookSpec specs[PH_BUILTIN_COUNT - PH_BUILTIN_PROFILE_COUNT];
+    PHookHandle handles[PH_BUILTIN_COUNT - PH_BUILTIN_PROFILE_COUNT];
+    size_t count = 0;
+    for (size_t i = PH_BUILTIN_PROFILE_COUNT; i < PH_BUILTIN_COUNT; i++) {
+        if (!ph_registry_contains(g_builtin_replacements[i].function_name)) {
+            specs[count].function_name = g_builtin_replacements[i].function_name;
+            specs[count].replacement_function = NULL;
+            count++;
+        }
+    }
+    
+    // Always resolved up front: execve may run in a forked child, where a
+    // first-call dlsym is best avoided
+    ph_log_debug("Enabling process inheritance with %zu hooks", count);
+    result = count > 0 ? ph_install_hook_batch(specs, count, handles, false, false) : PH_SUCCESS;
+    
+    // A concurrent call installed them first
+    return result == PH_ERROR_ALREADY_HOOKED ? PH_SUCCESS : result;
+}
+
+bool ph_is_inheritance_enabled(void) {
+    return atomic_load_explicit(&g_spawn_inherit_enabled, memory_order_acquire) &&
+           atomic_load_explicit(&g_builtin_hooks[PH_BUILTIN_POSIX_SPAWN].hook_id, memory_order_relaxed) != 0;
+}
+
+// Fork Safety
+// Every lock an install path or a publisher can hold is taken before fork
+// and released again on both sides, g_hook_mutex first as in the install
+// paths, so the child starts from a consistent registry and configuration.
+// The child re-initializes the locks rather than unlocking them: the
+// thread the parent recorded as their owner does not exist there.
+
+static void ph_fork_prepare(void) {
+    pthread_mutex_lock(&g_hook_mutex);
+    ph_identifiers_fork_prepare();
+    ph_config_fork_prepare();
+    ph_trace_fork_prepare();
+}
+
+static void ph_fork_parent(void) {
+    ph_trace_fork_parent();
+    ph_config_fork_parent();
+    ph_identifiers_fork_parent();
+    pthread_mutex_unlock(&g_hook_mutex);
+}
+
+static void ph_fork_child(void) {
+    ph_trace_fork_child();
+    ph_config_fork_child();
+    ph_identifiers_fork_child();
+    ph_rebind_fork_child();
+    
+    // A child that never execs stays observable under its own PID
+    ph_stats_fork_child();
+    ph_events_fork_child();
+    uint32_t used = ph_registry_capacity_used();
+    for (uint32_t i = 0; i < used; i++) {
+        PHookEntry* entry = ph_registry_entry_at(i);
+        if (entry->is_active) {
+            ph_stats_hook_activated(entry);
+            ph_events_hook_activated(entry);
+        }
+    }
+    
+    pthread_mutex_init(&g_hook_mutex, NULL);
+}
+
+__attribute__((constructor))
+static void ph_register_fork_handlers(void) {
+    pthread_atfork(ph_fork_prepare, ph_fork_parent, ph_fork_child);
+}
+
 // Core Implementation
 
 PHResult ph_initialize(void) {
@@ -157,9 +718,15 @@ PHResult ph_initialize(void) {
         return PH_ERROR_UNSUPPORTED_PLATFORM;
     }
     
-    // Initialize hook list
-    g_hook_list_head = NULL;
-    g_next_hook_id = 1;
+    // Reserve the arena every hook allocation comes from
+    PHResult result = ph_arena_create();
+    if (result != PH_SUCCESS) {
+        pthread_mutex_unlock(&g_hook_mutex);
+        return result;
+    }
+    
+    // Initialize hook registry
+    ph_registry_reset();
     g_hook_system_initialized = true;
     
     ph_log_debug("Hook system initialized successfully");
@@ -178,14 +745,16 @@ void ph_cleanup(void) {
     ph_log_debug("Cleaning up hook system");
     
     // Remove all hooks and free memory
-    PHookEntry* current = g_hook_list_head;
-    while (current != NULL) {
-        PHookEntry* next = current->next;
-        ph_free_hook_entry(current);
-        current = next;
+    uint32_t used = ph_registry_capacity_used();
+    for (uint32_t i = 0; i < used; i++) {
+        PHookEntry* entry = ph_registry_entry_at(i);
+        if (entry->is_active) {
+            ph_free_hook_entry(entry);
+        }
     }
     
-    g_hook_list_head = NULL;
+    ph_registry_reset();
+    ph_arena_release();
     g_hook_system_initialized = false;
     
     ph_log_debug("Hook system cleanup completed");
@@ -207,41 +776,51 @@ PHResult ph_install_hook(const char* function_name,
     }
     
     // Check if already hooked
-    if (ph_find_hook_by_name(function_name) != NULL) {
+    if (ph_registry_find(function_name) != NULL) {
         pthread_mutex_unlock(&g_hook_mutex);
         return PH_ERROR_ALREADY_HOOKED;
     }
     
     ph_log_debug("Installing hook for function: %s", function_name);
+    uint64_t start = ph_now_ns();
     
-    // Get original function pointer
-    void* original_function = dlsym(RTLD_DEFAULT, function_name);
-    if (!original_function) {
-        ph_log_debug("Function not found: %s", function_name);
-        pthread_mutex_unlock(&g_hook_mutex);
-        return PH_ERROR_FUNCTION_NOT_FOUND;
+    // Get original function pointer, unless the first call resolves it
+    void* original_function = NULL;
+    if (!ph_is_lazy_activation_enabled()) {
+        original_function = dlsym(RTLD_DEFAULT, function_name);
+        if (!original_function) {
+            ph_log_debug("Function not found: %s", function_name);
+            pthread_mutex_unlock(&g_hook_mutex);
+            return PH_ERROR_FUNCTION_NOT_FOUND;
+        }
     }
     
-    // Create new hook entry
-    PHookEntry* new_hook = malloc(sizeof(PHookEntry));
+    // Reserve a registry entry
+    PHookEntry* new_hook = ph_registry_acquire(function_name);
     if (!new_hook) {
         pthread_mutex_unlock(&g_hook_mutex);
         return PH_ERROR_MEMORY_ERROR;
     }
     
     // Initialize hook entry
-    strncpy(new_hook->function_name, function_name, sizeof(new_hook->function_name) - 1);
-    new_hook->function_name[sizeof(new_hook->function_name) - 1] = '\0';
     new_hook->original_function = original_function;
     new_hook->replacement_function = replacement_function;
-    new_hook->is_active = true;
-    new_hook->next = g_hook_list_head;
+    new_hook->rebinding->replacement = replacement_function;
+    
+    // Redirect the symbol in every loaded image
+    PHResult result = ph_rebind_attach(&new_hook->rebinding, 1);
+    if (result != PH_SUCCESS) {
+        ph_log_debug("Failed to rebind %s: %s", function_name, ph_get_error_message(result));
+        ph_registry_release(new_hook);
+        pthread_mutex_unlock(&g_hook_mutex);
+        return result;
+    }
     
-    // Add to hook list
-    g_hook_list_head = new_hook;
+    ph_hook_activated(new_hook);
+    ph_activation_record_install(1, original_function != NULL, start);
     
     // Setup handle
-    handle->id = g_next_hook_id++;
+    handle->id = new_hook->id;
     strncpy(handle->function_name, function_name, sizeof(handle->function_name) - 1);
     handle->function_name[sizeof(handle->function_name) - 1] = '\0';
     handle->is_valid = true;
@@ -265,31 +844,178 @@ PHResult ph_remove_hook(const PHookHandle* handle) {
     
     ph_log_debug("Removing hook for function: %s (ID: %u)", handle->function_name, handle->id);
     
-    // Find and remove hook from list
-    PHookEntry* current = g_hook_list_head;
-    PHookEntry* previous = NULL;
+    // The ID locates the entry directly; the name guards against handles
+    // that were forged or belong to a different hook
+    PHookEntry* entry = ph_registry_find_by_id(handle->id);
+    if (entry == NULL || strncmp(entry->function_name, handle->function_name, sizeof(handle->function_name)) != 0) {
+        pthread_mutex_unlock(&g_hook_mutex);
+        return PH_ERROR_NOT_HOOKED;
+    }
     
-    while (current != NULL) {
-        if (strcmp(current->function_name, handle->function_name) == 0) {
-            // Remove from list
-            if (previous) {
-                previous->next = current->next;
-            } else {
-                g_hook_list_head = current->next;
+    ph_free_hook_entry(entry);
+    ph_log_debug("Hook removed successfully for function: %s", handle->function_name);
+    pthread_mutex_unlock(&g_hook_mutex);
+    return PH_SUCCESS;
+}
+
+PHResult ph_install_hooks(const PHookSpec* specs, size_t count, PHookHandle* handles) {
+    return ph_install_hook_batch(specs, count, handles, ph_is_lazy_activation_enabled(), false);
+}
+
+PHResult ph_install_loaded_hooks(const PHookSpec* specs, size_t count, PHookHandle* handles) {
+    return ph_install_hook_batch(specs, count, handles, ph_is_lazy_activation_enabled(), true);
+}
+
+static PHResult ph_install_hook_batch(const PHookSpec* specs, size_t count, PHookHandle* handles,
+                                      bool lazy, bool skip_unloaded) {
+    if (!specs || !handles || count == 0 || count > PH_MAX_HOOKS) {
+        return PH_ERROR_INVALID_PARAM;
+    }
+    
+    pthread_mutex_lock(&g_hook_mutex);
+    
+    if (!g_hook_system_initialized) {
+        pthread_mutex_unlock(&g_hook_mutex);
+        return PH_ERROR_INVALID_PARAM;
+    }
+    
+    ph_log_debug("Installing %zu hooks as one batch%s", count, lazy ? " (lazy)" : "");
+    uint64_t start = ph_now_ns();
+    
+    // Resolve every symbol and reserve every entry before touching any image;
+    // entry_spec maps each reserved entry back to its spec and handle
+    PHookEntry* entries[count];
+    PHRebinding* rebindings[count];
+    size_t entry_spec[count];
+    PHResult result = PH_SUCCESS;
+    size_t reserved = 0;
+    
+    for (size_t index = 0; index < count; index++) {
+        const PHookSpec* spec = &specs[index];
+        memset(&handles[index], 0, sizeof(handles[index]));
+        if (!spec->function_name) {
+            result = PH_ERROR_INVALID_PARAM;
+            break;
+        }
+        void* replacement = spec->replacement_function ? spec->replacement_function
+                                                       : ph_builtin_replacement(spec->function_name);
+        if (!replacement) {
+            result = PH_ERROR_INVALID_PARAM;
+            break;
+        }
+        
+        // Reserved entries are not visible yet, so duplicates within the
+        // batch are caught by the name comparison below
+        if (ph_registry_find(spec->function_name) != NULL) {
+            result = PH_ERROR_ALREADY_HOOKED;
+            break;
+        }
+        for (size_t i = 0; i < reserved && result == PH_SUCCESS; i++) {
+            if (strcmp(entries[i]->function_name, spec->function_name) == 0) {
+                result = PH_ERROR_ALREADY_HOOKED;
             }
-            
-            ph_free_hook_entry(current);
-            ph_log_debug("Hook removed successfully for function: %s", handle->function_name);
-            pthread_mutex_unlock(&g_hook_mutex);
-            return PH_SUCCESS;
+        }
+        if (result != PH_SUCCESS) {
+            break;
+        }
+        
+        void* original_function = lazy ? NULL : dlsym(RTLD_DEFAULT, spec->function_name);
+        if (!original_function && !lazy) {
+            // Its image may simply not be loaded in this host; the handle
+            // stays invalid and the rest of the batch goes ahead
+            if (skip_unloaded) {
+                ph_log_debug("Skipping hook for unloaded %s", spec->function_name);
+                continue;
+            }
+            ph_log_debug("Function not found: %s", spec->function_name);
+            result = PH_ERROR_FUNCTION_NOT_FOUND;
+            break;
         }
         
-        previous = current;
-        current = current->next;
+        PHookEntry* entry = ph_registry_acquire(spec->function_name);
+        if (!entry) {
+            result = PH_ERROR_MEMORY_ERROR;
+            break;
+        }
+        entry->original_function = original_function;
+        entry->replacement_function = replacement;
+        entry->rebinding->replacement = replacement;
+        entries[reserved] = entry;
+        rebindings[reserved] = entry->rebinding;
+        entry_spec[reserved] = index;
+        reserved++;
+    }
+    
+    // One image walk patches the whole batch and rolls itself back on failure
+    if (result == PH_SUCCESS && reserved > 0) {
+        result = ph_rebind_attach(rebindings, reserved);
+    }
+    
+    if (result != PH_SUCCESS) {
+        for (size_t i = 0; i < reserved; i++) {
+            ph_registry_release(entries[i]);
+        }
+        ph_log_debug("Batch install failed: %s", ph_get_error_message(result));
+        pthread_mutex_unlock(&g_hook_mutex);
+        return result;
     }
     
+    for (size_t i = 0; i < reserved; i++) {
+        PHookHandle* handle = &handles[entry_spec[i]];
+        ph_hook_activated(entries[i]);
+        handle->id = entries[i]->id;
+        strncpy(handle->function_name, specs[entry_spec[i]].function_name, sizeof(handle->function_name) - 1);
+        handle->function_name[sizeof(handle->function_name) - 1] = '\0';
+        handle->is_valid = true;
+    }
+    
+    if (reserved > 0) {
+        ph_activation_record_install(reserved, lazy ? 0 : reserved, start);
+    }
+    ph_log_debug("Batch of %zu of %zu hooks installed successfully", reserved, count);
     pthread_mutex_unlock(&g_hook_mutex);
-    return PH_ERROR_NOT_HOOKED;
+    return PH_SUCCESS;
+}
+
+PHResult ph_remove_hooks(const PHookHandle* handles, size_t count) {
+    if (!handles || count == 0 || count > PH_MAX_HOOKS) {
+        return PH_ERROR_INVALID_PARAM;
+    }
+    
+    pthread_mutex_lock(&g_hook_mutex);
+    
+    if (!g_hook_system_initialized) {
+        pthread_mutex_unlock(&g_hook_mutex);
+        return PH_ERROR_INVALID_PARAM;
+    }
+    
+    // Validate the whole batch before restoring anything
+    PHookEntry* entries[count];
+    PHRebinding* rebindings[count];
+    for (size_t i = 0; i < count; i++) {
+        PHookEntry* entry = handles[i].is_valid ? ph_registry_find_by_id(handles[i].id) : NULL;
+        if (entry == NULL || strncmp(entry->function_name, handles[i].function_name, sizeof(handles[i].function_name)) != 0) {
+            pthread_mutex_unlock(&g_hook_mutex);
+            return PH_ERROR_NOT_HOOKED;
+        }
+        for (size_t j = 0; j < i; j++) {
+            if (entries[j] == entry) {
+                pthread_mutex_unlock(&g_hook_mutex);
+                return PH_ERROR_INVALID_PARAM;
+            }
+        }
+        entries[i] = entry;
+        rebindings[i] = entry->rebinding;
+    }
+    
+    ph_rebind_detach(rebindings, count);
+    for (size_t i = 0; i < count; i++) {
+        ph_hook_deactivated(entries[i]);
+    }
+    
+    ph_log_debug("Batch of %zu hooks removed successfully", count);
+    pthread_mutex_unlock(&g_hook_mutex);
+    return PH_SUCCESS;
 }
 
 void* ph_get_original(const PHookHandle* handle) {
@@ -299,9 +1025,25 @@ void* ph_get_original(const PHookHandle* handle) {
     
     pthread_mutex_lock(&g_hook_mutex);
     
-    PHookEntry* hook = ph_find_hook_by_name(handle->function_name);
+    PHookEntry* hook = ph_registry_find_by_id(handle->id);
     void* original = hook ? hook->original_function : NULL;
     
+    // Lazily installed: built-ins share the replacement's cached copy
+    if (hook != NULL && original == NULL) {
+        for (size_t i = 0; i < PH_BUILTIN_COUNT && original == NULL; i++) {
+            if (g_builtin_replacements[i].replacement_function == hook->replacement_function) {
+                original = ph_builtin_original(i);
+            }
+        }
+        if (original == NULL) {
+            uint64_t start = ph_now_ns();
+            original = hook->original_function = dlsym(RTLD_DEFAULT, hook->function_name);
+            if (original != NULL) {
+                ph_activation_record_resolution(start);
+            }
+        }
+    }
+    
     pthread_mutex_unlock(&g_hook_mutex);
     return original;
 }
@@ -311,11 +1053,8 @@ bool ph_is_hooked(const char* function_name) {
         return false;
     }
     
-    pthread_mutex_lock(&g_hook_mutex);
-    bool hooked = (ph_find_hook_by_name(function_name) != NULL);
-    pthread_mutex_unlock(&g_hook_mutex);
-    
-    return hooked;
+    // Lock-free probe of the interned name table
+    return ph_registry_contains(function_name);
 }
 
 // System Call Specific Implementations
@@ -379,21 +1118,50 @@ bool ph_is_platform_supported(void) {
 }
 
 void ph_set_debug_logging(bool enabled) {
-    g_debug_logging_enabled = enabled;
+    atomic_store_explicit(&g_debug_logging_enabled, enabled, memory_order_relaxed);
 }
 
-uint32_t ph_get_active_hook_count(void) {
+PHResult ph_stats_enable(void) {
     pthread_mutex_lock(&g_hook_mutex);
     
-    uint32_t count = 0;
-    PHookEntry* current = g_hook_list_head;
-    while (current != NULL) {
-        if (current->is_active) {
-            count++;
+    PHResult result = ph_stats_create_region();
+    if (result == PH_SUCCESS) {
+        // Hooks installed before the region existed get their slots now
+        uint32_t used = ph_registry_capacity_used();
+        for (uint32_t i = 0; i < used; i++) {
+            PHookEntry* entry = ph_registry_entry_at(i);
+            if (entry->is_active) {
+                ph_stats_hook_activated(entry);
+            }
+        }
+    }
+    
+    pthread_mutex_unlock(&g_hook_mutex);
+    return result;
+}
+
+PHResult ph_events_enable(void) {
+    pthread_mutex_lock(&g_hook_mutex);
+    
+    PHResult result = ph_events_create_region();
+    if (result == PH_SUCCESS) {
+        // Hooks installed before the region existed are named now
+        uint32_t used = ph_registry_capacity_used();
+        for (uint32_t i = 0; i < used; i++) {
+            PHookEntry* entry = ph_registry_entry_at(i);
+            if (entry->is_active) {
+                ph_events_hook_activated(entry);
+            }
         }
-        current = current->next;
     }
     
+    pthread_mutex_unlock(&g_hook_mutex);
+    return result;
+}
+
+uint32_t ph_get_active_hook_count(void) {
+    pthread_mutex_lock(&g_hook_mutex);
+    uint32_t count = ph_registry_active_count();
     pthread_mutex_unlock(&g_hook_mutex);
     return count;
 }
@@ -407,20 +1175,20 @@ uint32_t ph_get_active_hooks(char* buffer, size_t buffer_size) {
     
     uint32_t count = 0;
     size_t offset = 0;
-    PHookEntry* current = g_hook_list_head;
+    uint32_t used = ph_registry_capacity_used();
     
-    while (current != NULL && offset < buffer_size - 1) {
+    for (uint32_t i = 0; i < used && offset < buffer_size - 1; i++) {
+        PHookEntry* current = ph_registry_entry_at(i);
         if (current->is_active) {
             size_t name_len = strlen(current->function_name);
             if (offset + name_len + 1 < buffer_size) {
-                strcpy(buffer + offset, current->function_name);
+                memcpy(buffer + offset, current->function_name, name_len + 1);
                 offset += name_len + 1;
                 count++;
             } else {
                 break;
             }
         }
-        current = current->next;
     }
     
     pthread_mutex_unlock(&g_hook_mutex);
@@ -429,39 +1197,35 @@ uint32_t ph_get_active_hooks(char* buffer, size_t buffer_size) {
 
 // Internal Helper Functions
 
-static void ph_log_debug(const char* format, ...) {
-    if (!g_debug_logging_enabled) {
-        return;
-    }
+static void ph_log_debug_write(const char* format, ...) {
+    // Format the whole line first so it reaches stderr in one write
+    char line[512];
+    int prefix = snprintf(line, sizeof(line), "[PrivarionHook] ");
     
     va_list args;
     va_start(args, format);
-    fprintf(stderr, "[PrivarionHook] ");
-    vfprintf(stderr, format, args);
-    fprintf(stderr, "\n");
+    int length = vsnprintf(line + prefix, sizeof(line) - (size_t)prefix - 1, format, args);
     va_end(args);
-}
-
-static PHookEntry* ph_find_hook_by_name(const char* function_name) {
-    PHookEntry* current = g_hook_list_head;
-    while (current != NULL) {
-        if (strcmp(current->function_name, function_name) == 0) {
-            return current;
-        }
-        current = current->next;
+    
+    if (length < 0) {
+        return;
     }
-    return NULL;
-}
-
-static PHookEntry* ph_find_hook_by_id(uint32_t id) {
-    // Note: This function could be enhanced to store ID in PHookEntry
-    // For now, search by name is sufficient
-    return NULL;
+    size_t total = (size_t)prefix + (size_t)length;
+    if (total > sizeof(line) - 2) {
+        total = sizeof(line) - 2;
+    }
+    line[total] = '\n';
+    write(STDERR_FILENO, line, total + 1);
 }
 
 static void ph_free_hook_entry(PHookEntry* entry) {
     if (entry) {
-        // Note: In a full implementation, would need to restore original function
-        free(entry);
+        if (entry->is_active) {
+            // Write the original pointers back into every patched slot
+            ph_rebind_detach(&entry->rebinding, 1);
+            ph_hook_deactivated(entry);
+        } else {
+            ph_registry_release(entry);
+        }
     }
 }
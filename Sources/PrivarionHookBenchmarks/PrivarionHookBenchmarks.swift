@@ -0,0 +1,311 @@
+// Native hook microbenchmarks
+// Measures the cost of the C hook layer itself - hooked versus raw system
+// calls, install/remove churn and registry lookups under contention - and
+// reports it through BenchmarkFramework so the usual baseline and
+// regression tooling can gate on it.
+
+import Foundation
+import ArgumentParser
+import PrivarionHook
+import PrivarionCore
+
+@main
+struct PrivarionHookBenchmarks: ParsableCommand {
+
+    static let configuration = CommandConfiguration(
+        commandName: "privarion-hook-benchmarks",
+        abstract: "Measure native hook overhead and emit BenchmarkResult JSON"
+    )
+
+    @Option(name: .long, parsing: .upToNextOption, help: "Thread counts to measure")
+    var threads: [Int] = [1, 4, 8]
+
+    @Option(name: .long, help: "Calls per thread for each measurement")
+    var iterations: Int = 1_000_000
+
+    @Option(name: .long, help: "Install/remove cycles per thread for the churn benchmark")
+    var churnIterations: Int = 2_000
+
+    @Option(name: .long, help: "Write the JSON report to this file instead of standard output")
+    var output: String?
+
+    @Flag(name: .long, help: "Store these results as the new baselines")
+    var saveBaseline = false
+
+    @Flag(name: .long, help: "Exit with a failure status if any result regresses against its baseline")
+    var checkRegressions = false
+
+    func validate() throws {
+        guard !threads.isEmpty, threads.allSatisfy({ $0 > 0 }) else {
+            throw ValidationError("Thread counts must be positive")
+        }
+        guard iterations > 0, churnIterations > 0 else {
+            throw ValidationError("Iteration counts must be positive")
+        }
+    }
+
+    func run() throws {
+        guard ph_is_platform_supported() else {
+            throw ValidationError("The hook library does not support this platform")
+        }
+        try check(ph_initialize())
+        defer { ph_cleanup() }
+
+        // Publish a configuration so hooked calls take the spoofing path
+        var config = FakeDataDefinitions().hookConfigData
+        try check(ph_update_config(&config))
+        try SyscallHookManager.shared.applyIdentifierTable(HardwareIdentifierEngine().makeIdentifierTable())
+
+        let framework = BenchmarkFramework.shared
+        let runner = HookBenchmarkRunner()
+
+        for threadCount in threads {
+            for syscall in HookedSyscall.allCases {
+                framework.recordResult(runner.measure("\(syscall.rawValue).raw", threads: threadCount, iterations: iterations, body: syscall.call))
+
+                var handle = PHookHandle()
+                try check(syscall.install(&handle))
+                framework.recordResult(runner.measure("\(syscall.rawValue).hooked", threads: threadCount, iterations: iterations, body: syscall.call))
+                try check(ph_remove_hook(&handle))
+            }
+
+            framework.recordResult(try runner.measureChurn(threads: threadCount, iterations: churnIterations))
+            framework.recordResult(try runner.measureLookupContention(threads: threadCount, iterations: iterations))
+        }
+
+        try report(framework)
+    }
+
+    private func report(_ framework: BenchmarkFramework) throws {
+        let regressions = framework.checkForRegressions().filter { $0.hasRegression }
+        if saveBaseline {
+            framework.saveCurrentAsBaseline()
+        }
+
+        guard let data = framework.exportResults() else {
+            throw ValidationError("Failed to encode benchmark results")
+        }
+        if let output = output {
+            try data.write(to: URL(fileURLWithPath: output), options: .atomic)
+        } else {
+            FileHandle.standardOutput.write(data)
+            FileHandle.standardOutput.write(Data("\n".utf8))
+        }
+
+        if checkRegressions && !regressions.isEmpty {
+            let names = regressions.map { $0.testName }.joined(separator: ", ")
+            FileHandle.standardError.write(Data("Regressions detected: \(names)\n".utf8))
+            throw ExitCode.failure
+        }
+    }
+}
+
+// MARK: - Hooked System Calls
+
+enum HookedSyscall: String, CaseIterable {
+    case getuid
+    case gethostname
+    case uname
+    case sysctlSpoofed = "sysctlbyname.spoofed"
+    case sysctlPassthrough = "sysctlbyname.passthrough"
+
+    /// One call through this image's (possibly patched) symbol pointer
+    func call() -> Int {
+        switch self {
+        case .getuid:
+            return Int(Darwin.getuid())
+        case .gethostname:
+            var buffer = [CChar](repeating: 0, count: 256)
+            return Int(Darwin.gethostname(&buffer, buffer.count))
+        case .uname:
+            var info = utsname()
+            return Int(Darwin.uname(&info))
+        case .sysctlSpoofed:
+            var buffer = [CChar](repeating: 0, count: 64)
+            var size = buffer.count
+            return Int(Darwin.sysctlbyname("hw.model", &buffer, &size, nil, 0))
+        case .sysctlPassthrough:
+            // Not in the identifier table, so only the length mask is paid
+            var value: Int32 = 0
+            var size = MemoryLayout<Int32>.size
+            return Int(Darwin.sysctlbyname("hw.ncpu", &value, &size, nil, 0))
+        }
+    }
+
+    func install(_ handle: inout PHookHandle) -> PHResult {
+        var config = FakeDataDefinitions().hookConfigData
+        switch self {
+        case .getuid:
+            return ph_install_getuid_hook(&config, &handle)
+        case .gethostname:
+            return ph_install_gethostname_hook(&config, &handle)
+        case .uname:
+            return ph_install_uname_hook(&config, &handle)
+        case .sysctlSpoofed, .sysctlPassthrough:
+            // A nil replacement selects the built-in one
+            return "sysctlbyname".withCString { name in
+                var spec = PHookSpec(function_name: name, replacement_function: nil)
+                return ph_install_hooks(&spec, 1, &handle)
+            }
+        }
+    }
+}
+
+private func check(_ result: PHResult) throws {
+    guard result == PH_SUCCESS else {
+        throw ValidationError("Hook library call failed: \(String(cString: ph_get_error_message(result)))")
+    }
+}
+
+// MARK: - Runner
+
+/// Keeps results alive so the optimizer cannot drop the measured calls
+@inline(never)
+private func blackHole(_ value: Int) {
+    if value == Int.min {
+        FileHandle.standardError.write(Data())
+    }
+}
+
+final class HookBenchmarkRunner {
+
+    private let monitor = PerformanceMonitor()
+
+    // Libc functions with an int-sized return value and no side effects,
+    // used as churn targets so the benchmark never hooks what it measures
+    private let churnSymbols = ["getppid", "getpgrp", "geteuid", "getegid"]
+    private let churnReplacement: @convention(c) () -> Int32 = { 0 }
+
+    /// Run `body` on `threads` threads, `iterations` times each, and report
+    /// the mean cost of one call in milliseconds
+    func measure(_ name: String, threads: Int, iterations: Int, body: @escaping () -> Int) -> BenchmarkResult {
+        let nanoseconds = timeThreads(threads) { _ in
+            var sink = 0
+            for _ in 0..<iterations {
+                sink &+= body()
+            }
+            blackHole(sink)
+            return iterations
+        }
+        return makeResult(name: "\(name).t\(threads)", nanosecondsPerCall: nanoseconds, calls: threads * iterations)
+    }
+
+    /// Install and remove hooks as fast as possible, one symbol per thread
+    func measureChurn(threads: Int, iterations: Int) throws -> BenchmarkResult {
+        let threadCount = min(threads, churnSymbols.count)
+        let replacement = unsafeBitCast(churnReplacement, to: UnsafeMutableRawPointer.self)
+        let failures = ManagedAtomicCounter()
+
+        let nanoseconds = timeThreads(threadCount) { index in
+            let symbol = self.churnSymbols[index]
+            var handle = PHookHandle()
+            for _ in 0..<iterations {
+                guard ph_install_hook(symbol, replacement, &handle) == PH_SUCCESS,
+                      ph_remove_hook(&handle) == PH_SUCCESS else {
+                    failures.increment()
+                    return 0
+                }
+            }
+            return iterations
+        }
+
+        let status: BenchmarkResult.BenchmarkStatus = failures.value == 0 ? .passed : .failed
+        return makeResult(name: "install_remove_churn.t\(threadCount)", nanosecondsPerCall: nanoseconds,
+                          calls: threadCount * iterations, status: status)
+    }
+
+    /// Look up hooked and unhooked names concurrently while a hook is installed
+    func measureLookupContention(threads: Int, iterations: Int) throws -> BenchmarkResult {
+        var handle = PHookHandle()
+        try check(HookedSyscall.getuid.install(&handle))
+        defer { _ = ph_remove_hook(&handle) }
+
+        let nanoseconds = timeThreads(threads) { index in
+            var sink = 0
+            let name = index % 2 == 0 ? "getuid" : "getpgrp"
+            name.withCString { cName in
+                for _ in 0..<iterations {
+                    sink &+= ph_is_hooked(cName) ? 1 : 0
+                }
+            }
+            blackHole(sink)
+            return iterations
+        }
+        return makeResult(name: "is_hooked_contention.t\(threads)", nanosecondsPerCall: nanoseconds, calls: threads * iterations)
+    }
+
+    /// Start all threads together and return the mean nanoseconds per
+    /// operation across them; `work` returns the operations it completed
+    private func timeThreads(_ threads: Int, work: @escaping (Int) -> Int) -> Double {
+        let start = DispatchSemaphore(value: 0)
+        let group = DispatchGroup()
+        let lock = NSLock()
+        var totalNanoseconds: UInt64 = 0
+        var totalOperations = 0
+
+        for index in 0..<threads {
+            group.enter()
+            let thread = Thread {
+                start.wait()
+                let began = DispatchTime.now().uptimeNanoseconds
+                let operations = work(index)
+                let elapsed = DispatchTime.now().uptimeNanoseconds - began
+
+                lock.lock()
+                totalNanoseconds += elapsed
+                totalOperations += operations
+                lock.unlock()
+                group.leave()
+            }
+            thread.qualityOfService = .userInitiated
+            thread.start()
+        }
+
+        for _ in 0..<threads {
+            start.signal()
+        }
+        group.wait()
+
+        return totalOperations > 0 ? Double(totalNanoseconds) / Double(totalOperations) : 0
+    }
+
+    private func makeResult(
+        name: String,
+        nanosecondsPerCall: Double,
+        calls: Int,
+        status: BenchmarkResult.BenchmarkStatus = .passed
+    ) -> BenchmarkResult {
+        let metrics = PerformanceMetrics(
+            cpuUsage: monitor.getCurrentCPUUsage(),
+            memoryUsageMB: monitor.getCurrentMemoryUsage(),
+            renderTimeMs: nanosecondsPerCall / 1_000_000,
+            operationName: name,
+            interactive: false
+        )
+        return BenchmarkResult(
+            testName: "native_hook.\(name)",
+            duration: nanosecondsPerCall / 1_000_000,
+            metrics: metrics,
+            status: status,
+            iterations: calls
+        )
+    }
+}
+
+/// Failure counter shared by benchmark threads
+final class ManagedAtomicCounter {
+    private let lock = NSLock()
+    private var count = 0
+
+    func increment() {
+        lock.lock()
+        count += 1
+        lock.unlock()
+    }
+
+    var value: Int {
+        lock.lock()
+        defer { lock.unlock() }
+        return count
+    }
+}
@@ -5,6 +5,7 @@
 import Foundation
 import Logging
 import PrivarionSharedModels
+import PrivarionCore
 
 /// DNS filter for processing queries and applying privacy protection rules
 /// Blocks tracking domains and returns fake responses for fingerprinting domains
@@ -342,6 +343,15 @@ internal class BlocklistManager {
     /// Domain blocklist
     private var blockedDomains: Set<String> = []
     
+    /// Blocked addresses, CIDR prefixes and ranges
+    private var blockedAddresses: Set<String> = []
+    
+    /// Prefix tree compiled from `blockedAddresses`
+    private var addressRules = IPPrefixTree()
+    
+    /// Bumped on every rule change so cached verdicts can be discarded
+    private var ruleGeneration: UInt64 = 0
+    
     /// Access queue for thread safety
     private let queue = DispatchQueue(label: "privarion.blocklist", attributes: .concurrent)
     
@@ -378,11 +388,25 @@ internal class BlocklistManager {
         }
     }
     
+    /// Check if an address in binary form should be blocked
+    /// - Parameter address: Destination address
+    /// - Returns: True if a blocked address or range covers it
+    internal func shouldBlockAddress(_ address: IPPrefixTree.Address) -> Bool {
+        let rules = queue.sync { addressRules }
+        return rules.contains(address)
+    }
+    
+    /// Generation of the current rules; changes whenever a rule is added or removed
+    internal var generation: UInt64 {
+        return queue.sync { ruleGeneration }
+    }
+    
     /// Add domain to blocklist
     /// - Parameter domain: Domain to block
     internal func addBlockedDomain(_ domain: String) {
         queue.async(flags: .barrier) {
             self.blockedDomains.insert(domain.lowercased())
+            self.ruleGeneration &+= 1
         }
     }
     
@@ -391,6 +415,27 @@ internal class BlocklistManager {
     internal func removeBlockedDomain(_ domain: String) {
         queue.async(flags: .barrier) {
             self.blockedDomains.remove(domain.lowercased())
+            self.ruleGeneration &+= 1
+        }
+    }
+    
+    /// Add an address, CIDR prefix or range to the blocklist
+    /// - Parameter rule: Address rule, e.g. "203.0.113.0/24"
+    internal func addBlockedAddress(_ rule: String) {
+        queue.async(flags: .barrier) {
+            self.blockedAddresses.insert(rule)
+            self.addressRules = IPPrefixTree(rules: self.blockedAddresses)
+            self.ruleGeneration &+= 1
+        }
+    }
+    
+    /// Remove an address rule from the blocklist
+    /// - Parameter rule: Address rule as it was added
+    internal func removeBlockedAddress(_ rule: String) {
+        queue.async(flags: .barrier) {
+            self.blockedAddresses.remove(rule)
+            self.addressRules = IPPrefixTree(rules: self.blockedAddresses)
+            self.ruleGeneration &+= 1
         }
     }
     
@@ -416,6 +461,7 @@ internal class BlocklistManager {
         
         queue.async(flags: .barrier) {
             self.blockedDomains = Set(defaultBlockedDomains.map { $0.lowercased() })
+            self.ruleGeneration &+= 1
         }
     }
 }
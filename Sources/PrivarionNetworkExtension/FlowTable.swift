@@ -0,0 +1,237 @@
+// FlowTable.swift
+// Per-flow verdict cache for the packet filter
+// Requirements: 3.6-3.8, 18.2
+
+import Foundation
+import PrivarionCore
+
+/// Filtering decision for a flow, applied to every packet of the flow
+internal enum FlowVerdict: UInt8 {
+    case allow
+    case drop
+    case modify
+}
+
+/// 5-tuple identifying a flow, in fixed-size binary form
+/// IPv4 addresses are stored IPv4-mapped, as in `IPPrefixTree`.
+internal struct FlowKey: Hashable {
+    let source: IPPrefixTree.Address
+    let destination: IPPrefixTree.Address
+    let sourcePort: UInt16
+    let destinationPort: UInt16
+    let protocolNumber: UInt8
+
+    static let zero = FlowKey(
+        source: IPPrefixTree.Address(high: 0, low: 0),
+        destination: IPPrefixTree.Address(high: 0, low: 0),
+        sourcePort: 0,
+        destinationPort: 0,
+        protocolNumber: 0
+    )
+
+    /// Parse the flow key from an IPv4 or IPv6 header
+    /// Ports are read for TCP and UDP only, and not from IPv4 fragments
+    /// after the first, which carry no transport header.
+    init?(packet: Data) {
+        guard let key = packet.withUnsafeBytes({ FlowKey(header: $0) }) else {
+            return nil
+        }
+        self = key
+    }
+
+    init(
+        source: IPPrefixTree.Address,
+        destination: IPPrefixTree.Address,
+        sourcePort: UInt16,
+        destinationPort: UInt16,
+        protocolNumber: UInt8
+    ) {
+        self.source = source
+        self.destination = destination
+        self.sourcePort = sourcePort
+        self.destinationPort = destinationPort
+        self.protocolNumber = protocolNumber
+    }
+
+    private init?(header bytes: UnsafeRawBufferPointer) {
+        guard bytes.count >= 20 else { return nil }
+
+        func word32(_ offset: Int) -> UInt32 {
+            return UInt32(bigEndian: bytes.loadUnaligned(fromByteOffset: offset, as: UInt32.self))
+        }
+        func word64(_ offset: Int) -> UInt64 {
+            return UInt64(bigEndian: bytes.loadUnaligned(fromByteOffset: offset, as: UInt64.self))
+        }
+        func ports(at offset: Int, protocolNumber: UInt8) -> (UInt16, UInt16) {
+            guard protocolNumber == 6 || protocolNumber == 17, bytes.count >= offset + 4 else {
+                return (0, 0)
+            }
+            let ports = word32(offset)
+            return (UInt16(truncatingIfNeeded: ports >> 16), UInt16(truncatingIfNeeded: ports))
+        }
+
+        switch bytes[0] >> 4 {
+        case 4:
+            let headerLength = Int(bytes[0] & 0x0F) * 4
+            let protocolNumber = bytes[9]
+            let fragmentOffset = UInt16(bytes[6] & 0x1F) << 8 | UInt16(bytes[7])
+            let (sourcePort, destinationPort) = fragmentOffset == 0 && headerLength >= 20
+                ? ports(at: headerLength, protocolNumber: protocolNumber)
+                : (0, 0)
+            self.init(
+                source: IPPrefixTree.Address(ipv4: word32(12)),
+                destination: IPPrefixTree.Address(ipv4: word32(16)),
+                sourcePort: sourcePort,
+                destinationPort: destinationPort,
+                protocolNumber: protocolNumber
+            )
+
+        case 6:
+            guard bytes.count >= 40 else { return nil }
+            let protocolNumber = bytes[6]
+            let (sourcePort, destinationPort) = ports(at: 40, protocolNumber: protocolNumber)
+            self.init(
+                source: IPPrefixTree.Address(high: word64(8), low: word64(16)),
+                destination: IPPrefixTree.Address(high: word64(24), low: word64(32)),
+                sourcePort: sourcePort,
+                destinationPort: destinationPort,
+                protocolNumber: protocolNumber
+            )
+
+        default:
+            return nil
+        }
+    }
+
+    /// Mixed hash of the key words, for slot selection
+    fileprivate var slotHash: UInt64 {
+        var hash = (source.high ^ 0x9E37_79B9_7F4A_7C15) &* 0xBF58_476D_1CE4_E5B9
+        hash = (hash ^ source.low) &* 0x94D0_49BB_1331_11EB
+        hash = (hash ^ destination.high) &* 0xBF58_476D_1CE4_E5B9
+        hash = (hash ^ destination.low) &* 0x94D0_49BB_1331_11EB
+        let ports = UInt64(sourcePort) << 24 | UInt64(destinationPort) << 8 | UInt64(protocolNumber)
+        hash = (hash ^ ports) &* 0xBF58_476D_1CE4_E5B9
+        return hash ^ (hash >> 31)
+    }
+}
+
+/// Open-addressed table of flow verdicts
+/// Slots live in one preallocated block and are probed linearly within a
+/// short window. Nothing is ever deleted: a full window evicts its least
+/// recently used slot, and verdicts computed under older blocklist rules
+/// are treated as empty. Callers look up and insert whole packet batches,
+/// so the lock is taken twice per wakeup rather than per packet.
+internal final class FlowTable {
+
+    private struct Slot {
+        var key: FlowKey
+        var generation: UInt64
+        var lastUsed: UInt64
+        var verdict: FlowVerdict
+        var isOccupied: Bool
+
+        static let empty = Slot(key: .zero, generation: 0, lastUsed: 0, verdict: .allow, isOccupied: false)
+    }
+
+    /// Slots probed before a lookup gives up or an insert evicts
+    private static let probeLimit = 8
+
+    private let slots: UnsafeMutablePointer<Slot>
+    private let mask: Int
+    private let lock = NSLock()
+
+    /// Advances once per batch; orders slots for eviction
+    private var clock: UInt64 = 0
+    private var occupiedCount = 0
+
+    let capacity: Int
+
+    /// - Parameter capacity: Slot count, rounded up to a power of two
+    init(capacity: Int = 8192) {
+        var size = max(Self.probeLimit, 1)
+        while size < capacity {
+            size <<= 1
+        }
+        self.capacity = size
+        self.mask = size - 1
+        self.slots = UnsafeMutablePointer<Slot>.allocate(capacity: size)
+        slots.initialize(repeating: .empty, count: size)
+    }
+
+    deinit {
+        slots.deinitialize(count: capacity)
+        slots.deallocate()
+    }
+
+    /// Number of occupied slots, including ones left by older rules
+    var count: Int {
+        lock.lock()
+        defer { lock.unlock() }
+        return occupiedCount
+    }
+
+    /// Look up every key of a batch
+    /// - Parameters:
+    ///   - keys: Flow keys, nil for packets that could not be parsed
+    ///   - generation: Current blocklist generation
+    /// - Returns: Cached verdict per key, nil on a miss
+    func lookup(_ keys: [FlowKey?], generation: UInt64) -> [FlowVerdict?] {
+        lock.lock()
+        defer { lock.unlock() }
+        clock &+= 1
+
+        return keys.map { key in
+            guard let key = key else { return nil }
+            var index = Int(truncatingIfNeeded: key.slotHash) & mask
+            for _ in 0..<Self.probeLimit {
+                guard slots[index].isOccupied else { return nil }
+                if slots[index].key == key {
+                    guard slots[index].generation == generation else { return nil }
+                    slots[index].lastUsed = clock
+                    return slots[index].verdict
+                }
+                index = (index + 1) & mask
+            }
+            return nil
+        }
+    }
+
+    /// Record the verdicts evaluated for a batch
+    func insert<S: Sequence>(_ entries: S, generation: UInt64) where S.Element == (key: FlowKey, verdict: FlowVerdict) {
+        lock.lock()
+        defer { lock.unlock() }
+
+        for (key, verdict) in entries {
+            let start = Int(truncatingIfNeeded: key.slotHash) & mask
+            var target = start
+            var index = start
+            for probe in 0..<Self.probeLimit {
+                let slot = slots[index]
+                if !slot.isOccupied || slot.key == key {
+                    target = index
+                    break
+                }
+                // Prefer a slot from older rules, then the least recently used
+                let targetSlot = slots[target]
+                if probe == 0 || (targetSlot.generation == generation
+                    && (slot.generation != generation || slot.lastUsed < targetSlot.lastUsed)) {
+                    target = index
+                }
+                index = (index + 1) & mask
+            }
+
+            if !slots[target].isOccupied {
+                occupiedCount += 1
+            }
+            slots[target] = Slot(key: key, generation: generation, lastUsed: clock, verdict: verdict, isOccupied: true)
+        }
+    }
+
+    /// Drop every cached verdict
+    func removeAll() {
+        lock.lock()
+        defer { lock.unlock() }
+        slots.update(repeating: .empty, count: capacity)
+        occupiedCount = 0
+    }
+}
@@ -40,12 +40,8 @@ public class PacketFilter {
     /// DNS filter for domain resolution
     private let dnsFilter: DNSFilter
     
-    /// Cache for recently evaluated destinations (performance optimization)
-    private var destinationCache: [String: FilterResult] = [:]
-    private let cacheQueue = DispatchQueue(label: "com.privarion.packet-filter.cache", attributes: .concurrent)
-    
-    /// Maximum cache size
-    private let maxCacheSize = 1000
+    /// Verdicts of recently seen flows; only a flow's first packet is evaluated
+    private let flowTable: FlowTable
     
     // MARK: - Initialization
     
@@ -54,14 +50,17 @@ public class PacketFilter {
     ///   - policyEngine: Protection policy engine for policy evaluation
     ///   - blocklistManager: Blocklist manager for domain/IP blocking
     ///   - dnsFilter: DNS filter for domain resolution
+    ///   - flowTableCapacity: Number of flows whose verdicts are cached
     internal init(
         policyEngine: ProtectionPolicyEngine,
         blocklistManager: BlocklistManager,
-        dnsFilter: DNSFilter
+        dnsFilter: DNSFilter,
+        flowTableCapacity: Int = 8192
     ) {
         self.policyEngine = policyEngine
         self.blocklistManager = blocklistManager
         self.dnsFilter = dnsFilter
+        self.flowTable = FlowTable(capacity: flowTableCapacity)
         
         logger.info("PacketFilter initialized")
     }
@@ -88,27 +87,45 @@ public class PacketFilter {
     /// - Returns: FilterResult indicating whether to allow, drop, or modify the packet
     /// - Requirement: 3.6, 3.7, 3.8
     public func filterPacket(_ packet: Data, protocol: Int) async -> FilterResult {
-        // Extract destination from packet
-        guard let destination = extractDestination(packet) else {
-            // If we can't parse the packet, allow it to avoid breaking connectivity
-            logger.debug("Could not extract destination from packet, allowing through")
-            return .allow(packet)
-        }
+        return filterPackets([packet])[0]
+    }
+    
+    /// Filter a batch of packets, such as one read from the packet flow
+    /// Headers are parsed into binary flow keys and looked up together, so
+    /// only the first packet of a flow is evaluated against policy.
+    /// - Parameter packets: Raw packet data
+    /// - Returns: One FilterResult per packet, in order
+    /// - Requirement: 3.6, 3.7, 3.8, 18.2
+    public func filterPackets(_ packets: [Data]) -> [FilterResult] {
+        let keys = packets.map { FlowKey(packet: $0) }
+        let generation = blocklistManager.generation
+        var verdicts = flowTable.lookup(keys, generation: generation)
         
-        // Check cache first for performance
-        let cacheKey = "\(destination.ip):\(destination.port)"
-        if let cachedResult = getCachedResult(for: cacheKey) {
-            logger.debug("Cache hit for destination", metadata: ["destination": "\(cacheKey)"])
-            return cachedResult
+        // Evaluate each new flow once, even if it repeats within the batch
+        var evaluated: [FlowKey: FlowVerdict] = [:]
+        for index in packets.indices where verdicts[index] == nil {
+            guard let key = keys[index] else { continue }
+            if let verdict = evaluated[key] {
+                verdicts[index] = verdict
+                continue
+            }
+            guard let destination = extractDestination(packets[index]) else { continue }
+            let verdict = evaluateFlow(to: destination)
+            evaluated[key] = verdict
+            verdicts[index] = verdict
+        }
+        if !evaluated.isEmpty {
+            flowTable.insert(evaluated.lazy.map { (key: $0.key, verdict: $0.value) }, generation: generation)
         }
         
-        // Evaluate packet against filtering rules
-        let result = await evaluatePacket(packet, destination: destination)
-        
-        // Cache the result
-        cacheResult(result, for: cacheKey)
-        
-        return result
+        return packets.indices.map { index in
+            guard let verdict = verdicts[index] else {
+                // If we can't parse the packet, allow it to avoid breaking connectivity
+                logger.debug("Could not extract destination from packet, allowing through")
+                return .allow(packets[index])
+            }
+            return apply(verdict, to: packets[index])
+        }
     }
     
     /// Extract destination IP and port from packet
@@ -134,25 +151,35 @@ public class PacketFilter {
         return nil
     }
     
-    /// Clear the destination cache
+    /// Clear the flow verdict cache
     public func clearCache() {
-        cacheQueue.async(flags: .barrier) {
-            self.destinationCache.removeAll()
-        }
+        flowTable.removeAll()
         logger.debug("Packet filter cache cleared")
     }
     
+    /// Number of flows with a cached verdict
+    internal var cachedFlowCount: Int {
+        return flowTable.count
+    }
+    
     // MARK: - Private Methods
     
-    /// Evaluate packet against protection policies and blocklists
-    /// - Parameters:
-    ///   - packet: Raw packet data
-    ///   - destination: Extracted network destination
-    /// - Returns: FilterResult indicating filtering decision
+    /// Evaluate a new flow against protection policies and blocklists
+    /// - Parameter destination: Destination of the flow's first packet
+    /// - Returns: Verdict for every packet of the flow
     /// - Requirement: 3.6, 3.7, 3.8
-    private func evaluatePacket(_ packet: Data, destination: NetworkDestination) async -> FilterResult {
+    private func evaluateFlow(to destination: NetworkDestination) -> FlowVerdict {
+        // Blocked addresses and ranges need no domain resolution
+        if let address = destination.address, blocklistManager.shouldBlockAddress(address) {
+            logger.info("Dropping packet to blocked address", metadata: [
+                "ip": "\(destination.ip)",
+                "port": "\(destination.port)"
+            ])
+            return .drop
+        }
+        
         // Try to resolve domain from IP (reverse DNS lookup or DNS cache)
-        if let domain = await resolveDomain(for: destination.ip) {
+        if let domain = resolveDomain(for: destination.ip) {
             // Check if domain is a tracking domain
             if blocklistManager.shouldBlockDomain(domain) {
                 logger.info("Dropping packet to tracking domain", metadata: [
@@ -171,9 +198,7 @@ public class PacketFilter {
                     "port": "\(destination.port)"
                 ])
                 
-                // Modify packet by injecting fake data or redirecting
-                let modifiedPacket = modifyPacketForFingerprinting(packet, destination: destination)
-                return .modify(modifiedPacket) // Requirement 3.8
+                return .modify // Requirement 3.8
             }
         }
         
@@ -182,12 +207,32 @@ public class PacketFilter {
         // For now, we apply general filtering rules
         
         // Allow packet through
-        logger.debug("Allowing packet", metadata: [
+        logger.debug("Allowing flow", metadata: [
             "ip": "\(destination.ip)",
             "port": "\(destination.port)",
             "protocol": "\(destination.networkProtocol)"
         ])
-        return .allow(packet)
+        return .allow
+    }
+    
+    /// Apply a flow's verdict to one of its packets
+    /// - Parameters:
+    ///   - verdict: Cached or freshly evaluated flow verdict
+    ///   - packet: Raw packet data
+    /// - Returns: FilterResult for this packet
+    private func apply(_ verdict: FlowVerdict, to packet: Data) -> FilterResult {
+        switch verdict {
+        case .allow:
+            return .allow(packet)
+        case .drop:
+            return .drop
+        case .modify:
+            // Modify packet by injecting fake data or redirecting
+            guard let destination = extractDestination(packet) else {
+                return .allow(packet)
+            }
+            return .modify(modifyPacketForFingerprinting(packet, destination: destination))
+        }
     }
     
     /// Extract destination from IPv4 packet
@@ -223,7 +268,12 @@ public class PacketFilter {
         default: protocolType = .tcp // Default to TCP for unknown protocols
         }
         
-        return NetworkDestination(ip: destIP, port: Int(port), protocol: protocolType)
+        return NetworkDestination(
+            ip: destIP,
+            port: Int(port),
+            protocol: protocolType,
+            address: IPPrefixTree.Address(bytes: destIPBytes)
+        )
     }
     
     /// Extract destination from IPv6 packet
@@ -264,14 +314,19 @@ public class PacketFilter {
         default: protocolType = .tcp
         }
         
-        return NetworkDestination(ip: destIP, port: Int(port), protocol: protocolType)
+        return NetworkDestination(
+            ip: destIP,
+            port: Int(port),
+            protocol: protocolType,
+            address: IPPrefixTree.Address(bytes: destIPBytes)
+        )
     }
     
     /// Resolve domain name from IP address
     /// Uses DNS cache or performs reverse DNS lookup
     /// - Parameter ip: IP address to resolve
     /// - Returns: Domain name if found, nil otherwise
-    private func resolveDomain(for ip: String) async -> String? {
+    private func resolveDomain(for ip: String) -> String? {
         // In a full implementation, this would:
         // 1. Check DNS cache for recent queries to this IP
         // 2. Perform reverse DNS lookup if needed
@@ -300,34 +355,6 @@ public class PacketFilter {
         // deep packet inspection and payload modification
         return packet
     }
-    
-    /// Get cached filter result for destination
-    /// - Parameter key: Cache key (ip:port)
-    /// - Returns: Cached FilterResult or nil
-    private func getCachedResult(for key: String) -> FilterResult? {
-        return cacheQueue.sync {
-            destinationCache[key]
-        }
-    }
-    
-    /// Cache filter result for destination
-    /// - Parameters:
-    ///   - result: FilterResult to cache
-    ///   - key: Cache key (ip:port)
-    private func cacheResult(_ result: FilterResult, for key: String) {
-        cacheQueue.async(flags: .barrier) {
-            // Evict oldest entries if cache is full
-            if self.destinationCache.count >= self.maxCacheSize {
-                // Simple eviction: remove first entry
-                // In production, use LRU cache
-                if let firstKey = self.destinationCache.keys.first {
-                    self.destinationCache.removeValue(forKey: firstKey)
-                }
-            }
-            
-            self.destinationCache[key] = result
-        }
-    }
 }
 
 /// Network destination information extracted from packet
@@ -336,9 +363,19 @@ public struct NetworkDestination {
     public let port: Int
     public let networkProtocol: PrivarionSharedModels.NetworkProtocol
     
-    public init(ip: String, port: Int, protocol: PrivarionSharedModels.NetworkProtocol) {
+    /// Destination address in binary form, for prefix matching
+    public let address: IPPrefixTree.Address?
+    
+    /// - Parameter address: Binary address; parsed from `ip` when omitted
+    public init(
+        ip: String,
+        port: Int,
+        protocol: PrivarionSharedModels.NetworkProtocol,
+        address: IPPrefixTree.Address? = nil
+    ) {
         self.ip = ip
         self.port = port
         self.networkProtocol = `protocol`
+        self.address = address ?? IPPrefixTree.Address(ip)
     }
 }
@@ -0,0 +1,170 @@
+// PrivarionSystemExtension - Auth Decision Cache
+// Swift side of the native AUTH_EXEC/AUTH_OPEN verdict cache
+// Requirements: 2.5-2.8
+
+import Foundation
+import CEndpointSecurity
+import PrivarionESFastPath
+
+/// Verdicts the ES handler block answers without entering Swift
+/// Keys are the exec target or opened file's path plus the acting process's
+/// code directory hash, team ID and executable path, and for opens the
+/// access mode. The acting process is the one policies are evaluated for,
+/// so a verdict is never replayed for a different caller. Lookups are
+/// lock-free and safe from Endpoint Security's delivery thread.
+public final class AuthDecisionCache: @unchecked Sendable {
+
+    /// Events the cache can answer
+    public enum Kind {
+        case exec
+        case open
+
+        fileprivate var cValue: PESKind {
+            switch self {
+            case .exec: return PES_KIND_EXEC
+            case .open: return PES_KIND_OPEN
+            }
+        }
+    }
+
+    /// Cumulative cache counters
+    public struct Statistics {
+        public let hits: UInt64
+        public let misses: UInt64
+        public let stores: UInt64
+        /// Verdicts dropped because policies changed while they were computed
+        public let staleStores: UInt64
+        public let evictions: UInt64
+        public let generation: UInt32
+    }
+
+    private let cache: OpaquePointer
+
+    /// Allocate an empty cache
+    /// Fails if the slot table cannot be allocated; callers then run
+    /// without the fast path.
+    public init?() {
+        guard let cache = pes_cache_create() else {
+            return nil
+        }
+        self.cache = cache
+    }
+
+    deinit {
+        pes_cache_destroy(cache)
+    }
+
+    /// Current policy generation; read it before evaluating a policy
+    public var generation: UInt32 {
+        return pes_cache_generation(cache)
+    }
+
+    /// Forget every cached verdict
+    public func invalidate() {
+        pes_cache_invalidate(cache)
+    }
+
+    public var statistics: Statistics {
+        var stats = PESCacheStats()
+        pes_cache_get_stats(cache, &stats)
+        return Statistics(
+            hits: stats.hits,
+            misses: stats.misses,
+            stores: stats.stores,
+            staleStores: stats.stale_stores,
+            evictions: stats.evictions,
+            generation: stats.generation
+        )
+    }
+
+    // MARK: - Messages
+
+    /// Answer an AUTH message if its verdict is cached
+    /// - Returns: True if the message was answered
+    public func respondIfCached(client: OpaquePointer, message: UnsafePointer<es_message_t>) -> Bool {
+        return pes_try_respond_cached(cache, client, message)
+    }
+
+    /// Look up the verdict cached for a message without responding
+    /// - Returns: True for allow, false for deny, nil if not cached
+    public func verdict(for message: UnsafePointer<es_message_t>) -> Bool? {
+        var verdict = PES_VERDICT_ALLOW
+        guard pes_cache_lookup_message(cache, message, &verdict) else {
+            return nil
+        }
+        return verdict == PES_VERDICT_ALLOW
+    }
+
+    /// Remember the verdict reached for a message
+    /// - Parameter generation: Value of `generation` read before evaluating
+    public func store(message: UnsafePointer<es_message_t>, allow: Bool, generation: UInt32) {
+        pes_store_decision(cache, message, allow, generation)
+    }
+
+    // MARK: - Identities
+
+    /// Look up a verdict by identity, e.g. to inspect a decision
+    /// - Parameters:
+    ///   - path: Exec target or opened file
+    ///   - cdhash: Code directory hash of the acting process
+    ///   - teamID: Team ID of the acting process
+    ///   - processPath: Executable path of the acting process
+    ///   - fflag: Access mode of an open
+    /// - Returns: True for allow, false for deny, nil if not cached
+    public func verdict(
+        for kind: Kind,
+        path: String,
+        cdhash: [UInt8],
+        teamID: String,
+        processPath: String = "",
+        fflag: Int32 = 0
+    ) -> Bool? {
+        var key = Self.key(kind: kind, path: path, cdhash: cdhash, teamID: teamID, processPath: processPath, fflag: fflag)
+        var verdict = PES_VERDICT_ALLOW
+        guard pes_cache_lookup(cache, &key, &verdict) else {
+            return nil
+        }
+        return verdict == PES_VERDICT_ALLOW
+    }
+
+    /// Store a verdict by identity, e.g. to seed decisions known in advance
+    public func store(
+        _ kind: Kind,
+        path: String,
+        cdhash: [UInt8],
+        teamID: String,
+        processPath: String = "",
+        fflag: Int32 = 0,
+        allow: Bool,
+        generation: UInt32
+    ) {
+        var key = Self.key(kind: kind, path: path, cdhash: cdhash, teamID: teamID, processPath: processPath, fflag: fflag)
+        pes_cache_store(cache, &key, allow ? PES_VERDICT_ALLOW : PES_VERDICT_DENY, generation)
+    }
+
+    /// Build a key the way the handler block derives it from a message
+    private static func key(
+        kind: Kind,
+        path: String,
+        cdhash: [UInt8],
+        teamID: String,
+        processPath: String,
+        fflag: Int32
+    ) -> PESCacheKey {
+        var key = PESCacheKey()
+        key.kind = UInt8(kind.cValue.rawValue)
+        key.fflag = kind == .open ? UInt32(bitPattern: fflag) : 0
+        key.path_hash = path.utf8CString.withUnsafeBufferPointer { pes_hash_bytes($0.baseAddress, $0.count - 1) }
+        key.identity_hash = teamID.utf8CString.withUnsafeBufferPointer { team in
+            processPath.utf8CString.withUnsafeBufferPointer { executable in
+                pes_identity_hash(team.baseAddress, team.count - 1, executable.baseAddress, executable.count - 1)
+            }
+        }
+        withUnsafeMutableBytes(of: &key.cdhash) { bytes in
+            for (index, byte) in cdhash.prefix(bytes.count).enumerated() {
+                bytes[index] = byte
+            }
+        }
+        return key
+    }
+}
@@ -0,0 +1,247 @@
+// PrivarionSystemExtension - ES Event Dispatcher
+// Shards retained Endpoint Security messages across parallel workers
+// Requirements: 2.5-2.8
+
+import Foundation
+import CEndpointSecurity
+import Collections
+
+/// Fans cache-missing ES messages out to a fixed set of shard workers
+/// Each shard drains its AUTH queue before touching NOTIFY bookkeeping, so
+/// a burst of NOTIFY_WRITE never sits in front of an exec authorization.
+/// Messages are retained on the delivery thread and released once the
+/// processor has responded.
+public final class ESEventDispatcher: @unchecked Sendable {
+
+    /// How messages are assigned to shards
+    public enum ShardingKey {
+        /// Same process, same shard; keeps per-process ordering
+        case processID
+        /// Same event type, same shard
+        case eventType
+    }
+
+    /// Cumulative dispatch counters
+    public struct Statistics {
+        public let authDispatched: UInt64
+        public let notifyDispatched: UInt64
+        /// NOTIFY messages dropped because their shard backlog was full
+        public let notifyDropped: UInt64
+    }
+
+    /// Retained message as queued for a worker
+    private struct Item: @unchecked Sendable {
+        let client: OpaquePointer
+        let message: UnsafePointer<es_message_t>
+    }
+
+    /// NOTIFY backlog per shard before new NOTIFY messages are dropped
+    public static let defaultNotifyBacklog = 4096
+
+    public let shardCount: Int
+    public let shardingKey: ShardingKey
+
+    private let shards: [PriorityShardQueue<Item>]
+    /// Entered by each worker until its shard is closed and drained
+    private let workers = DispatchGroup()
+    private let statsLock = NSLock()
+    private var stopped = false
+    private var authDispatched: UInt64 = 0
+    private var notifyDispatched: UInt64 = 0
+    private var notifyDropped: UInt64 = 0
+
+    /// Create a dispatcher and start its workers
+    /// - Parameters:
+    ///   - processor: Processor every shard evaluates messages with
+    ///   - shardCount: Number of shards (defaults to the active core count)
+    ///   - shardingKey: How messages are assigned to shards
+    ///   - notifyBacklog: NOTIFY messages a shard holds before dropping new ones
+    public init(
+        processor: SecurityEventProcessor,
+        shardCount: Int = ProcessInfo.processInfo.activeProcessorCount,
+        shardingKey: ShardingKey = .processID,
+        notifyBacklog: Int = ESEventDispatcher.defaultNotifyBacklog
+    ) {
+        self.shardCount = max(shardCount, 1)
+        self.shardingKey = shardingKey
+        self.shards = (0..<self.shardCount).map { _ in PriorityShardQueue<Item>(backlogLimit: notifyBacklog) }
+
+        let workers = self.workers
+        for shard in shards {
+            workers.enter()
+            Task.detached(priority: .high) {
+                while let item = await shard.next() {
+                    await processor.processEvent(client: item.client, message: item.message)
+                    es_release_message(item.message)
+                }
+                workers.leave()
+            }
+        }
+    }
+
+    deinit {
+        stop()
+    }
+
+    /// Queue a message for its shard; called on the ES delivery thread
+    /// - Parameters:
+    ///   - client: ES client the message arrived on
+    ///   - message: Message to process; retained until it has been handled
+    public func dispatch(client: OpaquePointer, message: UnsafePointer<es_message_t>) {
+        let isAuth = message.pointee.action_type == ES_ACTION_TYPE_AUTH
+        let index = Self.shardIndex(
+            processID: audit_token_to_pid(message.pointee.process.pointee.audit_token),
+            eventType: message.pointee.event_type,
+            key: shardingKey,
+            shardCount: shardCount
+        )
+
+        es_retain_message(message)
+        let accepted = shards[index].enqueue(Item(client: client, message: message), urgent: isAuth)
+        if !accepted {
+            es_release_message(message)
+        }
+
+        statsLock.lock()
+        if isAuth {
+            authDispatched += accepted ? 1 : 0
+        } else if accepted {
+            notifyDispatched += 1
+        } else {
+            notifyDropped += 1
+        }
+        statsLock.unlock()
+    }
+
+    /// Let the workers finish what is queued, then exit
+    /// Messages dispatched afterwards are released without being handled.
+    public func stop() {
+        statsLock.lock()
+        stopped = true
+        statsLock.unlock()
+        shards.forEach { $0.close() }
+    }
+
+    /// Stop, then block until every queued message has been handled and released
+    /// Call before deleting the ES client, since workers respond on it.
+    public func stopAndDrain() {
+        stop()
+        workers.wait()
+    }
+
+    /// Whether `stop` has been called
+    public var isStopped: Bool {
+        statsLock.lock()
+        defer { statsLock.unlock() }
+        return stopped
+    }
+
+    public var statistics: Statistics {
+        statsLock.lock()
+        defer { statsLock.unlock() }
+        return Statistics(
+            authDispatched: authDispatched,
+            notifyDispatched: notifyDispatched,
+            notifyDropped: notifyDropped
+        )
+    }
+
+    /// Shard a message belongs to
+    static func shardIndex(processID: pid_t, eventType: es_event_type_t, key: ShardingKey, shardCount: Int) -> Int {
+        switch key {
+        case .processID:
+            return Int(UInt32(bitPattern: processID) % UInt32(shardCount))
+        case .eventType:
+            return Int(eventType.rawValue % UInt32(shardCount))
+        }
+    }
+}
+
+// MARK: - Priority Shard Queue
+
+/// Two-level FIFO consumed by a single worker; urgent items always go first
+/// Urgent items are never dropped while the queue is open, since an
+/// unanswered AUTH message stalls the process waiting on it. Normal items
+/// beyond the backlog limit are.
+final class PriorityShardQueue<Element>: @unchecked Sendable {
+    private let lock = NSLock()
+    private var urgent = Deque<Element>()
+    private var normal = Deque<Element>()
+    private var waiter: CheckedContinuation<Void, Never>?
+    private var closed = false
+    private let backlogLimit: Int
+
+    init(backlogLimit: Int) {
+        self.backlogLimit = backlogLimit
+    }
+
+    /// Queue an item; returns false if it was dropped
+    /// Normal items beyond the backlog limit are dropped, and once the queue
+    /// is closed every item is, since no worker will take it.
+    @discardableResult
+    func enqueue(_ element: Element, urgent isUrgent: Bool) -> Bool {
+        lock.lock()
+        if closed {
+            lock.unlock()
+            return false
+        } else if isUrgent {
+            urgent.append(element)
+        } else if normal.count < backlogLimit {
+            normal.append(element)
+        } else {
+            lock.unlock()
+            return false
+        }
+        let waiting = waiter
+        waiter = nil
+        lock.unlock()
+
+        waiting?.resume()
+        return true
+    }
+
+    /// Next item to process, or nil once closed and empty
+    func next() async -> Element? {
+        while true {
+            lock.lock()
+            if let element = urgent.popFirst() ?? normal.popFirst() {
+                lock.unlock()
+                return element
+            }
+            if closed {
+                lock.unlock()
+                return nil
+            }
+            lock.unlock()
+
+            await withCheckedContinuation { (continuation: CheckedContinuation<Void, Never>) in
+                lock.lock()
+                if !urgent.isEmpty || !normal.isEmpty || closed {
+                    lock.unlock()
+                    continuation.resume()
+                } else {
+                    waiter = continuation
+                    lock.unlock()
+                }
+            }
+        }
+    }
+
+    /// Wake the worker and make `next` return nil once drained
+    func close() {
+        lock.lock()
+        closed = true
+        let waiting = waiter
+        waiter = nil
+        lock.unlock()
+
+        waiting?.resume()
+    }
+
+    /// Items currently queued
+    var count: Int {
+        lock.lock()
+        defer { lock.unlock() }
+        return urgent.count + normal.count
+    }
+}
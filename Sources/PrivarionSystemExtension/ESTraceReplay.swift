@@ -0,0 +1,238 @@
+// PrivarionSystemExtension - ES Trace Replay
+// Replays recorded Endpoint Security events through the AUTH decision path
+// Requirements: 2.5-2.8, 18.1
+
+import Foundation
+import CEndpointSecurity
+import PrivarionCore
+
+// MARK: - Trace Record
+
+/// The fields of an ES message the decision path and verdict cache read
+/// Recorded from live messages and rebuilt into `es_message_t` for replay.
+/// `teamID` and `cdhash` are the acting process's, the exec caller or the
+/// opener; an exec target's signing info is recorded separately.
+public struct ESTraceRecord: Codable, Equatable {
+    public let eventType: UInt32
+    public let pid: Int32
+    public let ppid: Int32
+    public let executablePath: String
+    public let teamID: String
+    /// Code directory hash of the acting process as lowercase hex
+    public let cdhash: String
+    /// Executable of an exec target, or the opened file
+    public let targetPath: String
+    public let targetTeamID: String
+    /// Code directory hash of an exec target as lowercase hex
+    public let targetCdhash: String
+    /// Access mode of an open
+    public let fflag: Int32
+
+    public init(
+        eventType: es_event_type_t,
+        pid: Int32,
+        ppid: Int32,
+        executablePath: String,
+        teamID: String = "",
+        cdhash: String = "",
+        targetPath: String,
+        targetTeamID: String = "",
+        targetCdhash: String = "",
+        fflag: Int32 = 0
+    ) {
+        self.eventType = eventType.rawValue
+        self.pid = pid
+        self.ppid = ppid
+        self.executablePath = executablePath
+        self.teamID = teamID
+        self.cdhash = cdhash
+        self.targetPath = targetPath
+        self.targetTeamID = targetTeamID
+        self.targetCdhash = targetCdhash
+        self.fflag = fflag
+    }
+
+    /// Record a live message
+    public init(message: UnsafePointer<es_message_t>) {
+        let process = UnsafePointer(message.pointee.process)
+        var target: UnsafePointer<es_process_t>?
+        var targetPath = ""
+        var fflag: Int32 = 0
+        switch message.pointee.event_type {
+        case ES_EVENT_TYPE_AUTH_EXEC:
+            let exec = UnsafePointer(message.pointee.event.exec.target)
+            target = exec
+            targetPath = Self.string(exec.pointee.executable.pointee.path)
+        case ES_EVENT_TYPE_AUTH_OPEN:
+            targetPath = Self.string(message.pointee.event.open.file.pointee.path)
+            fflag = message.pointee.event.open.fflag
+        default:
+            break
+        }
+
+        self.init(
+            eventType: message.pointee.event_type,
+            pid: audit_token_to_pid(process.pointee.audit_token),
+            ppid: process.pointee.ppid,
+            executablePath: Self.string(process.pointee.executable.pointee.path),
+            teamID: Self.string(process.pointee.team_id),
+            cdhash: Self.hex(process.pointee.cdhash),
+            targetPath: targetPath,
+            targetTeamID: target.map { Self.string($0.pointee.team_id) } ?? "",
+            targetCdhash: target.map { Self.hex($0.pointee.cdhash) } ?? "",
+            fflag: fflag
+        )
+    }
+
+    /// Load a trace written as a JSON array of records
+    public static func load(from url: URL) throws -> [ESTraceRecord] {
+        return try JSONDecoder().decode([ESTraceRecord].self, from: Data(contentsOf: url))
+    }
+
+    var isAuth: Bool {
+        switch es_event_type_t(eventType) {
+        case ES_EVENT_TYPE_AUTH_EXEC, ES_EVENT_TYPE_AUTH_OPEN:
+            return true
+        default:
+            return false
+        }
+    }
+
+    static func bytes(fromHex hex: String) -> [UInt8] {
+        var bytes: [UInt8] = []
+        var index = hex.startIndex
+        while let next = hex.index(index, offsetBy: 2, limitedBy: hex.endIndex), index != next {
+            guard let byte = UInt8(hex[index..<next], radix: 16) else { break }
+            bytes.append(byte)
+            index = next
+        }
+        return bytes
+    }
+
+    private static func hex(_ cdhash: es_cdhash_t) -> String {
+        var cdhash = cdhash
+        return withUnsafeBytes(of: &cdhash) { bytes in
+            bytes.map { String(format: "%02x", $0) }.joined()
+        }
+    }
+
+    private static func string(_ token: es_string_token_t) -> String {
+        guard token.length > 0 else { return "" }
+        return String(decoding: UnsafeRawBufferPointer(start: token.data, count: token.length), as: UTF8.self)
+    }
+}
+
+// MARK: - Replay Workload
+
+/// Replays a trace through `SecurityEventProcessor` as the ES handler would
+/// Each rebuilt message is probed against the verdict cache with the key
+/// the handler block derives; misses go through `decide`, the processor's
+/// own evaluate-and-store step. Responses are not sent, so no ES client
+/// is needed.
+public final class ESTraceReplayWorkload: LoadWorkload, @unchecked Sendable {
+    public let name: String
+    private let processor: SecurityEventProcessor
+    private var messages: [UnsafeMutablePointer<es_message_t>] = []
+    private var allocations: [UnsafeMutableRawPointer] = []
+
+    public init(name: String = "es_auth", records: [ESTraceRecord], processor: SecurityEventProcessor) {
+        self.name = name
+        self.processor = processor
+        self.messages = records.map { makeMessage($0) }
+    }
+
+    deinit {
+        allocations.forEach { $0.deallocate() }
+    }
+
+    public var operationCount: Int {
+        return messages.count
+    }
+
+    public func perform(_ index: Int) async {
+        let message = UnsafePointer(messages[index])
+        if message.pointee.action_type == ES_ACTION_TYPE_AUTH,
+           processor.decisionCache?.verdict(for: message) != nil {
+            return
+        }
+        _ = await processor.decide(message)
+    }
+
+    // MARK: - Message Construction
+
+    private func makeMessage(_ record: ESTraceRecord) -> UnsafeMutablePointer<es_message_t> {
+        let message = allocateZeroed(es_message_t.self)
+        message.pointee.version = 1
+        message.pointee.event_type = es_event_type_t(record.eventType)
+        message.pointee.action_type = record.isAuth ? ES_ACTION_TYPE_AUTH : ES_ACTION_TYPE_NOTIFY
+        message.pointee.process = makeProcess(
+            record,
+            executablePath: record.executablePath,
+            teamID: record.teamID,
+            cdhash: ESTraceRecord.bytes(fromHex: record.cdhash)
+        )
+
+        switch es_event_type_t(record.eventType) {
+        case ES_EVENT_TYPE_AUTH_EXEC:
+            message.pointee.event.exec.target = makeProcess(
+                record,
+                executablePath: record.targetPath,
+                teamID: record.targetTeamID,
+                cdhash: ESTraceRecord.bytes(fromHex: record.targetCdhash)
+            )
+        case ES_EVENT_TYPE_AUTH_OPEN:
+            message.pointee.event.open.file = makeFile(record.targetPath)
+            message.pointee.event.open.fflag = record.fflag
+        default:
+            break
+        }
+        return message
+    }
+
+    private func makeProcess(
+        _ record: ESTraceRecord,
+        executablePath: String,
+        teamID: String,
+        cdhash: [UInt8]
+    ) -> UnsafeMutablePointer<es_process_t> {
+        let process = allocateZeroed(es_process_t.self)
+        process.pointee.audit_token.val.5 = UInt32(bitPattern: record.pid)
+        process.pointee.parent_audit_token.val.5 = UInt32(bitPattern: record.ppid)
+        process.pointee.ppid = record.ppid
+        process.pointee.original_ppid = record.ppid
+        process.pointee.team_id = makeString(teamID)
+        process.pointee.signing_id = makeString("")
+        process.pointee.executable = makeFile(executablePath)
+        withUnsafeMutableBytes(of: &process.pointee.cdhash) { bytes in
+            for (index, byte) in cdhash.prefix(bytes.count).enumerated() {
+                bytes[index] = byte
+            }
+        }
+        return process
+    }
+
+    private func makeFile(_ path: String) -> UnsafeMutablePointer<es_file_t> {
+        let file = allocateZeroed(es_file_t.self)
+        file.pointee.path = makeString(path)
+        return file
+    }
+
+    private func makeString(_ value: String) -> es_string_token_t {
+        let utf8 = Array(value.utf8)
+        let storage = UnsafeMutableRawPointer.allocate(byteCount: utf8.count + 1, alignment: 1)
+        allocations.append(storage)
+        let characters = storage.initializeMemory(as: CChar.self, repeating: 0, count: utf8.count + 1)
+        for (index, byte) in utf8.enumerated() {
+            characters[index] = CChar(bitPattern: byte)
+        }
+        return es_string_token_t(length: utf8.count, data: UnsafePointer(characters))
+    }
+
+    /// ES structs hold non-null pointers, so they are built in zeroed memory
+    private func allocateZeroed<T>(_ type: T.Type) -> UnsafeMutablePointer<T> {
+        let raw = UnsafeMutableRawPointer.allocate(byteCount: MemoryLayout<T>.stride, alignment: MemoryLayout<T>.alignment)
+        raw.initializeMemory(as: UInt8.self, repeating: 0, count: MemoryLayout<T>.stride)
+        allocations.append(raw)
+        return raw.bindMemory(to: T.self, capacity: 1)
+    }
+}
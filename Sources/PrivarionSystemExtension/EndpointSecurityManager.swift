@@ -4,6 +4,7 @@
 
 import Foundation
 import CEndpointSecurity
+import PrivarionESFastPath
 import Logging
 import PrivarionSharedModels
 import PrivarionCore
@@ -31,6 +32,23 @@ public class EndpointSecurityManager {
     /// Flag indicating if client is active
     private var isActive: Bool = false
     
+    /// Cached verdicts answered on the delivery thread
+    /// Nil if the cache could not be allocated; every event is then dispatched.
+    private let decisionCache: AuthDecisionCache?
+    
+    /// Shards cache misses across parallel workers
+    /// Replaced with a fresh one when a client is created after `unsubscribe`.
+    private var dispatcher: ESEventDispatcher
+    
+    /// Prefixes of files on the read-only system volume or in Apple's own
+    /// libraries, whose opens are never worth evaluating
+    public static let knownSafeOpenPrefixes = [
+        "/System/",
+        "/usr/lib/",
+        "/usr/share/",
+        "/Library/Apple/"
+    ]
+    
     // MARK: - Initialization
     
     /// Initialize the Endpoint Security Manager
@@ -38,10 +56,24 @@ public class EndpointSecurityManager {
     ///   - policyEngine: Protection policy engine for policy evaluation
     ///   - logger: Optional logger instance (creates default if not provided)
     ///   - eventProcessor: Optional event processor (creates default if not provided)
-    public init(policyEngine: ProtectionPolicyEngine, logger: Logger? = nil, eventProcessor: SecurityEventProcessor? = nil) {
+    ///   - shardCount: Number of dispatch shards (defaults to the active core count)
+    ///   - shardingKey: How events are assigned to shards
+    public init(
+        policyEngine: ProtectionPolicyEngine,
+        logger: Logger? = nil,
+        eventProcessor: SecurityEventProcessor? = nil,
+        shardCount: Int = ProcessInfo.processInfo.activeProcessorCount,
+        shardingKey: ESEventDispatcher.ShardingKey = .processID
+    ) {
         self.policyEngine = policyEngine
         self.logger = logger ?? Logger(label: "com.privarion.endpointsecurity")
         self.eventProcessor = eventProcessor ?? SecurityEventProcessor(policyEngine: policyEngine, logger: self.logger)
+        self.decisionCache = self.eventProcessor.decisionCache
+        self.dispatcher = ESEventDispatcher(
+            processor: self.eventProcessor,
+            shardCount: shardCount,
+            shardingKey: shardingKey
+        )
     }
     
     // MARK: - Public Methods
@@ -60,11 +92,26 @@ public class EndpointSecurityManager {
             
             logger.info("Initializing Endpoint Security client")
             
+            // The previous client's dispatcher was drained and stopped
+            if dispatcher.isStopped {
+                dispatcher = ESEventDispatcher(
+                    processor: eventProcessor,
+                    shardCount: dispatcher.shardCount,
+                    shardingKey: dispatcher.shardingKey
+                )
+            }
+            
             // Create ES client with event handler
+            // Known verdicts are answered right here; only misses reach Swift
+            let decisionCache = self.decisionCache
+            if decisionCache == nil {
+                logger.warning("Running without the AUTH fast path: decision cache unavailable")
+            }
             var newClient: OpaquePointer?
             let result = es_new_client(&newClient) { [weak self] client, message in
-                // Event handler callback - will be implemented in SecurityEventProcessor
-                // For now, just log that we received an event
+                if let cache = decisionCache, cache.respondIfCached(client: client, message: message) {
+                    return
+                }
                 self?.handleEvent(client: client, message: message)
             }
             
@@ -155,6 +202,10 @@ public class EndpointSecurityManager {
                 logger.warning("Failed to unsubscribe from events: \(unsubscribeResult.rawValue)")
             }
             
+            // Workers respond on the client, so let them answer and release
+            // every queued message before it goes away
+            dispatcher.stopAndDrain()
+            
             // Delete the client
             let deleteResult = es_delete_client(client)
             
@@ -169,6 +220,49 @@ public class EndpointSecurityManager {
         }
     }
     
+    /// Stop delivering events whose target lies under one of the prefixes
+    /// Muted events never reach the handler block, so only prefixes no
+    /// policy or handler needs to see should be passed.
+    /// - Parameters:
+    ///   - prefixes: Target path prefixes to mute
+    ///   - events: Event types to mute for those targets
+    /// - Throws: EndpointSecurityError if muting fails
+    public func muteTargetPrefixes(_ prefixes: [String], events: [es_event_type_t]) throws {
+        try queue.sync(flags: .barrier) {
+            guard let client = self.client, isActive else {
+                logger.error("Cannot mute paths: ES client not active")
+                throw EndpointSecurityError.clientDisconnected
+            }
+            
+            for prefix in prefixes {
+                guard pes_mute_target_prefix(client, prefix, events, events.count) == ES_RETURN_SUCCESS else {
+                    logger.error("Failed to mute target prefix: \(prefix)")
+                    throw EndpointSecurityError.subscriptionFailed(events.first?.rawValue ?? 0)
+                }
+            }
+            logger.info("Muted \(prefixes.count) target prefixes for \(events.count) event types")
+        }
+    }
+    
+    /// Mute AUTH_OPEN for files under `knownSafeOpenPrefixes`
+    /// - Throws: EndpointSecurityError if muting fails
+    public func muteKnownSafePrefixes() throws {
+        try muteTargetPrefixes(Self.knownSafeOpenPrefixes, events: [ES_EVENT_TYPE_AUTH_OPEN])
+    }
+    
+    /// Dispatch statistics
+    /// - Returns: AUTH and NOTIFY messages dispatched and dropped so far
+    public func dispatchStatistics() -> ESEventDispatcher.Statistics {
+        return dispatcher.statistics
+    }
+    
+    /// Verdict cache statistics
+    /// - Returns: Hits, misses and stores since the manager was created,
+    ///   or nil when running without the fast path
+    public func decisionCacheStatistics() -> AuthDecisionCache.Statistics? {
+        return decisionCache?.statistics
+    }
+    
     /// Get the event processor for registering handlers
     /// - Returns: Security event processor instance
     public func getEventProcessor() -> SecurityEventProcessor {
@@ -185,8 +279,8 @@ public class EndpointSecurityManager {
     
     // MARK: - Private Methods
     
-    /// Handle incoming ES events
-    /// Delegates to SecurityEventProcessor for async processing
+    /// Handle incoming ES events that missed the verdict cache
+    /// Hands the message to its dispatch shard for async processing
     /// - Parameters:
     ///   - client: ES client pointer
     ///   - message: ES message pointer
@@ -197,10 +291,8 @@ public class EndpointSecurityManager {
         
         logger.debug("Received ES event: type=\(eventType), pid=\(processID)")
         
-        // Process event asynchronously using SecurityEventProcessor
-        Task {
-            await eventProcessor.processEvent(client: client, message: message)
-        }
+        // The dispatcher retains the message until its shard has handled it
+        dispatcher.dispatch(client: client, message: message)
     }
     
     // MARK: - Deinitialization
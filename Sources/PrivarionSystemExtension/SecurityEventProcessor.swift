@@ -4,12 +4,15 @@
 
 import Foundation
 import CEndpointSecurity
+import PrivarionESFastPath
 import Logging
 import PrivarionSharedModels
 import PrivarionCore
 
 /// Processes incoming Endpoint Security events with thread-safe concurrent handling
 /// Responds to AUTH events within 100ms to avoid system slowdown
+/// Event processing is nonisolated so dispatch shards evaluate in parallel;
+/// only handler registration goes through the actor.
 public actor SecurityEventProcessor {
     // MARK: - Properties
     
@@ -22,22 +25,37 @@ public actor SecurityEventProcessor {
     /// Event processing timeout (100ms as per requirements)
     private let processingTimeout: TimeInterval = 0.1
     
-    /// Event handler for extensibility
-    private var eventHandlers: [SecurityEventHandler] = []
+    /// Event handlers for extensibility, readable from any shard
+    private let eventHandlers = HandlerList()
     
     /// Protection policy engine for policy evaluation
     private let policyEngine: ProtectionPolicyEngine
     
+    /// Verdicts answered natively before events reach this actor
+    /// Nil if the cache could not be allocated; every event is then evaluated.
+    public nonisolated let decisionCache: AuthDecisionCache?
+    
     // MARK: - Initialization
     
     /// Initialize the Security Event Processor
     /// - Parameters:
     ///   - policyEngine: Protection policy engine for policy evaluation
     ///   - logger: Optional logger instance
-    public init(policyEngine: ProtectionPolicyEngine, logger: Logger? = nil) {
+    ///   - decisionCache: Optional verdict cache (creates one if not provided)
+    public init(policyEngine: ProtectionPolicyEngine, logger: Logger? = nil, decisionCache: AuthDecisionCache? = nil) {
         self.policyEngine = policyEngine
         self.logger = logger ?? Logger(label: "com.privarion.eventprocessor")
         self.fileLogger = FileLogger(logFilePath: "/var/log/privarion/system-extension.log")
+        
+        let cache = decisionCache ?? AuthDecisionCache()
+        self.decisionCache = cache
+        if let cache = cache {
+            policyEngine.addChangeObserver { [weak cache] in
+                cache?.invalidate()
+            }
+        } else {
+            self.logger.warning("AUTH decision cache unavailable; evaluating every event")
+        }
     }
     
     // MARK: - Public Methods
@@ -46,6 +64,8 @@ public actor SecurityEventProcessor {
     /// - Parameter handler: Event handler to register
     public func registerHandler(_ handler: SecurityEventHandler) {
         eventHandlers.append(handler)
+        // Verdicts cached so far never consulted this handler
+        decisionCache?.invalidate()
         logger.info("Registered event handler: \(type(of: handler))")
     }
     
@@ -54,7 +74,7 @@ public actor SecurityEventProcessor {
     /// - Parameters:
     ///   - client: ES client pointer
     ///   - message: ES message pointer
-    public func processEvent(client: OpaquePointer, message: UnsafePointer<es_message_t>) async {
+    public nonisolated func processEvent(client: OpaquePointer, message: UnsafePointer<es_message_t>) async {
         let startTime = Date()
         let eventType = message.pointee.event_type
         let actionType = message.pointee.action_type
@@ -65,31 +85,15 @@ public actor SecurityEventProcessor {
         
         logger.debug("Processing event: type=\(eventType), action=\(actionType)")
         
-        // Process based on event type
-        let result: ESAuthResult
-        
-        switch eventType {
-        case ES_EVENT_TYPE_AUTH_EXEC:
-            result = await handleProcessExecution(message)
-            
-        case ES_EVENT_TYPE_AUTH_OPEN:
-            result = await handleFileAccess(message)
-            
-        case ES_EVENT_TYPE_NOTIFY_WRITE, ES_EVENT_TYPE_NOTIFY_EXIT:
-            // NOTIFY events don't require response
-            await handleNotifyEvent(message)
+        // NOTIFY events don't require response
+        guard let result = await decide(message) else {
             return
-            
-        default:
-            // Default to allow for unknown event types
-            logger.warning("Unknown event type: \(eventType.rawValue)")
-            result = .allow
         }
         
         // Respond to AUTH events
         if actionType == ES_ACTION_TYPE_AUTH {
-            let esResult = result.toESAuthResult()
-            _ = es_respond_auth_result(client, message, esResult, false)
+            // AUTH_OPEN takes a flags result, AUTH_EXEC an auth result
+            _ = pes_respond(client, message, result != .deny)
             
             // Log the event with comprehensive details (Requirement 2.10, 17.4)
             logSecurityEvent(
@@ -109,10 +113,54 @@ public actor SecurityEventProcessor {
         }
     }
     
+    /// Reach a verdict for a cache-missing event and cache it, without responding
+    /// This is everything `processEvent` does before `es_respond`, so
+    /// recorded traces replay through the same evaluate-and-store path.
+    /// - Parameter message: ES message pointer
+    /// - Returns: Authorization result, or nil for NOTIFY events
+    public nonisolated func decide(_ message: UnsafePointer<es_message_t>) async -> ESAuthResult? {
+        // Read before evaluating so a verdict racing a policy change is not cached
+        let generation = decisionCache?.generation
+        guard let result = await evaluate(message) else {
+            return nil
+        }
+        
+        let eventType = message.pointee.event_type
+        if let cache = decisionCache, let generation = generation,
+           message.pointee.action_type == ES_ACTION_TYPE_AUTH,
+           result != .allowWithModification, isCacheable(eventType) {
+            cache.store(message: message, allow: result == .allow, generation: generation)
+        }
+        return result
+    }
+    
+    /// Reach a verdict for an event without responding to or caching it
+    /// - Parameter message: ES message pointer
+    /// - Returns: Authorization result, or nil for NOTIFY events
+    public nonisolated func evaluate(_ message: UnsafePointer<es_message_t>) async -> ESAuthResult? {
+        let eventType = message.pointee.event_type
+        switch eventType {
+        case ES_EVENT_TYPE_AUTH_EXEC:
+            return await handleProcessExecution(message)
+            
+        case ES_EVENT_TYPE_AUTH_OPEN:
+            return await handleFileAccess(message)
+            
+        case ES_EVENT_TYPE_NOTIFY_WRITE, ES_EVENT_TYPE_NOTIFY_EXIT:
+            await handleNotifyEvent(message)
+            return nil
+            
+        default:
+            // Default to allow for unknown event types
+            logger.warning("Unknown event type: \(eventType.rawValue)")
+            return .allow
+        }
+    }
+    
     /// Handle process execution events (ES_EVENT_TYPE_AUTH_EXEC)
     /// - Parameter message: ES message pointer
     /// - Returns: Authorization result
-    public func handleProcessExecution(_ message: UnsafePointer<es_message_t>) async -> ESAuthResult {
+    public nonisolated func handleProcessExecution(_ message: UnsafePointer<es_message_t>) async -> ESAuthResult {
         // Extract process information
         let process = message.pointee.process
         let processID = audit_token_to_pid(process.pointee.audit_token)
@@ -154,7 +202,7 @@ public actor SecurityEventProcessor {
         logPolicyDecision(policy: policy, event: event, result: result)
         
         // Check registered handlers
-        for handler in eventHandlers {
+        for handler in eventHandlers.snapshot {
             if handler.canHandle(.processExecution) {
                 let handlerResult = await handler.handleProcessExecution(event)
                 if handlerResult != .allow {
@@ -172,7 +220,7 @@ public actor SecurityEventProcessor {
     ///   - policy: Protection policy to apply
     ///   - event: Process execution event
     /// - Returns: Authorization result based on policy
-    private func applyProtectionPolicy(_ policy: ProtectionPolicy, for event: ProcessExecutionEvent) -> ESAuthResult {
+    private nonisolated func applyProtectionPolicy(_ policy: ProtectionPolicy, for event: ProcessExecutionEvent) -> ESAuthResult {
         // Check if VM isolation is required
         if policy.requiresVMIsolation {
             logger.info("VM isolation required for: \(event.executablePath)")
@@ -219,7 +267,7 @@ public actor SecurityEventProcessor {
     ///   - policy: Applied protection policy
     ///   - event: Process execution event
     ///   - result: Authorization result
-    private func logPolicyDecision(policy: ProtectionPolicy, event: ProcessExecutionEvent, result: ESAuthResult) {
+    private nonisolated func logPolicyDecision(policy: ProtectionPolicy, event: ProcessExecutionEvent, result: ESAuthResult) {
         let action = result == .allow ? "ALLOW" : "DENY"
         logger.info("""
             Policy Decision: \(action)
@@ -235,7 +283,7 @@ public actor SecurityEventProcessor {
     /// Handle file access events (ES_EVENT_TYPE_AUTH_OPEN)
     /// - Parameter message: ES message pointer
     /// - Returns: Authorization result
-    public func handleFileAccess(_ message: UnsafePointer<es_message_t>) async -> ESAuthResult {
+    public nonisolated func handleFileAccess(_ message: UnsafePointer<es_message_t>) async -> ESAuthResult {
         // Extract process information
         let process = message.pointee.process
         let processID = audit_token_to_pid(process.pointee.audit_token)
@@ -259,7 +307,7 @@ public actor SecurityEventProcessor {
         logger.debug("File access: pid=\(processID), path=\(filePath), type=\(accessType)")
         
         // Check registered handlers
-        for handler in eventHandlers {
+        for handler in eventHandlers.snapshot {
             if handler.canHandle(.fileAccess) {
                 let result = await handler.handleFileAccess(event)
                 if result != .allow {
@@ -276,7 +324,7 @@ public actor SecurityEventProcessor {
     /// Handle network events (placeholder for future network event support)
     /// - Parameter message: ES message pointer
     /// - Returns: Authorization result
-    public func handleNetworkEvent(_ message: UnsafePointer<es_message_t>) async -> ESAuthResult {
+    public nonisolated func handleNetworkEvent(_ message: UnsafePointer<es_message_t>) async -> ESAuthResult {
         // Network events are not directly supported by Endpoint Security Framework
         // This is a placeholder for future integration with Network Extension
         logger.debug("Network event handling not yet implemented")
@@ -285,9 +333,25 @@ public actor SecurityEventProcessor {
     
     // MARK: - Private Methods
     
+    /// Whether a verdict for this event type depends only on the cache key
+    /// Handlers see arguments and other per-event details the key omits, so
+    /// event types a registered handler claims are always evaluated.
+    private nonisolated func isCacheable(_ eventType: es_event_type_t) -> Bool {
+        let securityEventType: SecurityEventType
+        switch eventType {
+        case ES_EVENT_TYPE_AUTH_EXEC:
+            securityEventType = .processExecution
+        case ES_EVENT_TYPE_AUTH_OPEN:
+            securityEventType = .fileAccess
+        default:
+            return false
+        }
+        return !eventHandlers.snapshot.contains { $0.canHandle(securityEventType) }
+    }
+    
     /// Handle NOTIFY events (no response required)
     /// - Parameter message: ES message pointer
-    private func handleNotifyEvent(_ message: UnsafePointer<es_message_t>) async {
+    private nonisolated func handleNotifyEvent(_ message: UnsafePointer<es_message_t>) async {
         let eventType = message.pointee.event_type
         let process = message.pointee.process
         let processID = audit_token_to_pid(process.pointee.audit_token)
@@ -319,7 +383,7 @@ public actor SecurityEventProcessor {
     ///   - processID: The process ID
     ///   - action: The action taken (allow/deny)
     ///   - message: The ES message pointer for extracting additional details
-    private func logSecurityEvent(
+    private nonisolated func logSecurityEvent(
         eventType: es_event_type_t,
         processID: pid_t,
         action: ESAuthResult,
@@ -374,7 +438,7 @@ public actor SecurityEventProcessor {
     /// Extract executable path from process
     /// - Parameter process: ES process pointer
     /// - Returns: Executable path string or nil
-    private func extractExecutablePath(from process: UnsafePointer<es_process_t>) -> String? {
+    private nonisolated func extractExecutablePath(from process: UnsafePointer<es_process_t>) -> String? {
         let executable = process.pointee.executable
         let path = executable.pointee.path
         
@@ -384,7 +448,7 @@ public actor SecurityEventProcessor {
     /// Extract arguments from exec event
     /// - Parameter message: ES message pointer
     /// - Returns: Array of argument strings
-    private func extractArguments(from message: UnsafePointer<es_message_t>) -> [String] {
+    private nonisolated func extractArguments(from message: UnsafePointer<es_message_t>) -> [String] {
         guard message.pointee.event_type == ES_EVENT_TYPE_AUTH_EXEC else {
             return []
         }
@@ -397,7 +461,7 @@ public actor SecurityEventProcessor {
     /// Extract parent process ID
     /// - Parameter process: ES process pointer
     /// - Returns: Parent process ID
-    private func extractParentProcessID(from process: UnsafePointer<es_process_t>) -> pid_t {
+    private nonisolated func extractParentProcessID(from process: UnsafePointer<es_process_t>) -> pid_t {
         // Access parent audit token directly
         let parent = process.pointee.parent_audit_token
         return audit_token_to_pid(parent)
@@ -406,7 +470,7 @@ public actor SecurityEventProcessor {
     /// Extract file path from AUTH_OPEN event
     /// - Parameter message: ES message pointer
     /// - Returns: File path string or nil
-    private func extractFilePath(from message: UnsafePointer<es_message_t>) -> String? {
+    private nonisolated func extractFilePath(from message: UnsafePointer<es_message_t>) -> String? {
         guard message.pointee.event_type == ES_EVENT_TYPE_AUTH_OPEN else {
             return nil
         }
@@ -419,7 +483,7 @@ public actor SecurityEventProcessor {
     /// Extract access type from AUTH_OPEN event
     /// - Parameter message: ES message pointer
     /// - Returns: File access type
-    private func extractAccessType(from message: UnsafePointer<es_message_t>) -> FileAccessType {
+    private nonisolated func extractAccessType(from message: UnsafePointer<es_message_t>) -> FileAccessType {
         guard message.pointee.event_type == ES_EVENT_TYPE_AUTH_OPEN else {
             return .read
         }
@@ -430,6 +494,27 @@ public actor SecurityEventProcessor {
     }
 }
 
+// MARK: - Handler List
+
+/// Registered handlers behind a lock, so nonisolated processing can read
+/// them without hopping onto the actor
+private final class HandlerList: @unchecked Sendable {
+    private let lock = NSLock()
+    private var handlers: [SecurityEventHandler] = []
+    
+    func append(_ handler: SecurityEventHandler) {
+        lock.lock()
+        handlers.append(handler)
+        lock.unlock()
+    }
+    
+    var snapshot: [SecurityEventHandler] {
+        lock.lock()
+        defer { lock.unlock() }
+        return handlers
+    }
+}
+
 // MARK: - Security Event Handler Protocol
 
 /// Protocol for handling security events
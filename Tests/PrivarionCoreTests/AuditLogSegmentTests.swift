@@ -0,0 +1,254 @@
+import XCTest
+@testable import PrivarionCore
+
+final class AuditLogSegmentTests: XCTestCase {
+
+    private typealias Event = AuditLogger.AuditEvent
+
+    private var directory: URL!
+
+    override func setUp() {
+        super.setUp()
+        directory = FileManager.default.temporaryDirectory
+            .appendingPathComponent("privarion_audit_segments_\(UUID().uuidString)")
+        XCTAssertNoThrow(try FileManager.default.createDirectory(at: directory, withIntermediateDirectories: true))
+    }
+
+    override func tearDown() {
+        XCTAssertNoThrow(try FileManager.default.removeItem(at: directory))
+        super.tearDown()
+    }
+
+    // MARK: - Helpers
+
+    private func makeEvent(
+        type: Event.EventType = .systemCall,
+        severity: Event.Severity = .info,
+        source: String = "syscall_monitor",
+        at timestamp: Date = Date(),
+        correlationId: String? = nil
+    ) -> Event {
+        return Event(
+            id: UUID(),
+            timestamp: timestamp,
+            eventType: type,
+            severity: severity,
+            source: source,
+            action: "open",
+            resource: "/etc/hosts",
+            user: Event.UserContext(uid: 501, gid: 20, username: "tester"),
+            process: Event.ProcessContext(pid: 42, ppid: 1, name: "probe", arguments: ["-v", "a,b"],
+                                          environment: ["LANG": "C"]),
+            network: Event.NetworkContext(localAddress: "10.0.0.2", remoteAddress: "1.1.1.1",
+                                          localPort: 50000, remotePort: 443, networkProtocol: "tcp"),
+            outcome: .blocked,
+            details: ["reason": "policy", "note": "line\nbreak"],
+            correlationId: correlationId
+        )
+    }
+
+    private func segments() throws -> [URL] {
+        return try FileManager.default.contentsOfDirectory(at: directory, includingPropertiesForKeys: nil)
+            .filter { $0.pathExtension == AuditSegmentFormat.fileExtension }
+            .sorted { $0.lastPathComponent < $1.lastPathComponent }
+    }
+
+    private func readAll(_ url: URL, _ query: AuditSegmentQuery) throws -> [Event] {
+        var events: [Event] = []
+        let segment = try AuditSegmentReader(contentsOf: url)
+        segment.forEachEvent(matching: query) { event in
+            events.append(event)
+            return true
+        }
+        return events
+    }
+
+    private var everything: AuditSegmentQuery {
+        return AuditSegmentQuery(from: .distantPast, to: .distantFuture)
+    }
+
+    // MARK: - Round Trip
+
+    func testCommittedEventsDecodeWithEveryField() throws {
+        let writer = try AuditSegmentWriter(directory: directory, maxSegmentBytes: 1 << 20)
+        let event = makeEvent(correlationId: "session-7")
+        writer.append(event)
+        writer.append(makeEvent(type: .networkActivity))
+        try writer.sync()
+
+        let url = try XCTUnwrap(writer.currentSegmentURL)
+        let segment = try AuditSegmentReader(contentsOf: url)
+        XCTAssertFalse(segment.hasUnindexedRecords, "A commit should leave the header index current")
+        XCTAssertEqual(segment.index.recordCount, 2)
+
+        let decoded = try XCTUnwrap(try readAll(url, everything).first)
+        XCTAssertEqual(decoded.id, event.id)
+        XCTAssertEqual(decoded.timestamp, event.timestamp)
+        XCTAssertEqual(decoded.eventType, .systemCall)
+        XCTAssertEqual(decoded.severity, .info)
+        XCTAssertEqual(decoded.outcome, .blocked)
+        XCTAssertEqual(decoded.resource, "/etc/hosts")
+        XCTAssertEqual(decoded.user?.username, "tester")
+        XCTAssertNil(decoded.user?.sessionId)
+        XCTAssertEqual(decoded.process?.arguments, ["-v", "a,b"])
+        XCTAssertEqual(decoded.process?.environment ?? [:], ["LANG": "C"])
+        XCTAssertNil(decoded.process?.path)
+        XCTAssertEqual(decoded.network?.remotePort, 443)
+        XCTAssertNil(decoded.network?.dataSize)
+        XCTAssertEqual(decoded.details, event.details)
+        XCTAssertEqual(decoded.correlationId, "session-7")
+
+        writer.close()
+    }
+
+    func testFullQueueBlocksProducersWithoutLosingEvents() throws {
+        let writer = try AuditSegmentWriter(directory: directory, maxSegmentBytes: 1 << 20, queueCapacity: 4)
+        DispatchQueue.concurrentPerform(iterations: 4) { worker in
+            for index in 0..<100 {
+                writer.append(makeEvent(source: "worker_\(worker)_\(index)"))
+            }
+        }
+        writer.close()
+
+        let url = try XCTUnwrap(try segments().first)
+        XCTAssertEqual(try readAll(url, everything).count, 400)
+        XCTAssertFalse(writer.append(makeEvent()), "A closed writer should refuse events")
+    }
+
+    func testSyncReportsEventsDroppedByAFailedCommit() throws {
+        let writer = try AuditSegmentWriter(directory: directory, maxSegmentBytes: 1 << 20)
+        // Without its directory the writer cannot open a new segment
+        try FileManager.default.removeItem(at: directory)
+        writer.rotate()
+        writer.append(makeEvent())
+        writer.append(makeEvent())
+        XCTAssertThrowsError(try writer.sync(), "Dropped events should not be reported as committed")
+        XCTAssertNoThrow(try writer.sync(), "A drop should be reported once")
+
+        try FileManager.default.createDirectory(at: directory, withIntermediateDirectories: true)
+        writer.close()
+    }
+
+    func testSegmentNamesSortInRotationOrder() throws {
+        let writer = try AuditSegmentWriter(directory: directory, maxSegmentBytes: 1 << 20)
+        // Several rotations land within the same second
+        for round in 0..<3 {
+            writer.append(makeEvent(source: "round_\(round)"))
+            try writer.sync()
+            writer.rotate()
+        }
+        writer.close()
+
+        // A writer reopening the directory continues the numbering
+        let reopened = try AuditSegmentWriter(directory: directory, maxSegmentBytes: 1 << 20)
+        reopened.append(makeEvent(source: "round_3"))
+        reopened.close()
+
+        let names = try segments().map { $0.lastPathComponent }
+        XCTAssertEqual(names.compactMap(AuditSegmentFormat.sequence(ofSegmentNamed:)), [0, 1, 2, 3, 4])
+        XCTAssertTrue(names.allSatisfy { $0.hasPrefix("audit_0000000000") && $0.contains("Z.") }, "\(names)")
+        let sources = try segments().flatMap { try readAll($0, everything) }.map { $0.source }
+        XCTAssertEqual(sources, ["round_0", "round_1", "round_2", "round_3"])
+    }
+
+    // MARK: - Index
+
+    func testIndexRulesOutSegmentsByTypeAndTime() throws {
+        let writer = try AuditSegmentWriter(directory: directory, maxSegmentBytes: 1 << 20)
+        let hourAgo = Date().addingTimeInterval(-3600)
+        writer.append(makeEvent(type: .networkActivity, at: hourAgo))
+        try writer.sync()
+        writer.rotate()
+        writer.append(makeEvent(type: .systemCall, severity: .critical))
+        writer.close()
+
+        let urls = try segments()
+        XCTAssertEqual(urls.count, 2, "Rotation should seal the first segment")
+        let older = try AuditSegmentReader(contentsOf: urls[0])
+        let newer = try AuditSegmentReader(contentsOf: urls[1])
+
+        let syscalls = AuditSegmentQuery(from: .distantPast, to: .distantFuture, eventTypes: [.systemCall])
+        XCTAssertFalse(older.mayContain(syscalls))
+        XCTAssertTrue(newer.mayContain(syscalls))
+
+        let recent = AuditSegmentQuery(from: Date().addingTimeInterval(-60), to: .distantFuture)
+        XCTAssertFalse(older.mayContain(recent))
+
+        let warnings = AuditSegmentQuery(from: .distantPast, to: .distantFuture, severities: [.warning])
+        XCTAssertFalse(newer.mayContain(warnings))
+    }
+
+    func testRecordsPastTheIndexAreStillScanned() throws {
+        let writer = try AuditSegmentWriter(directory: directory, maxSegmentBytes: 1 << 20)
+        writer.append(makeEvent(type: .networkActivity))
+        writer.close()
+        let url = try XCTUnwrap(try segments().first)
+
+        // A record appended without a header update, then a torn one
+        var tail: [UInt8] = []
+        AuditRecordCodec.appendRecord(makeEvent(type: .systemCall), to: &tail)
+        AuditRecordCodec.appendRecord(makeEvent(type: .systemCall), to: &tail)
+        let handle = try FileHandle(forWritingTo: url)
+        handle.seekToEndOfFile()
+        handle.write(Data(tail.dropLast(5)))
+        handle.closeFile()
+
+        let segment = try AuditSegmentReader(contentsOf: url)
+        XCTAssertTrue(segment.hasUnindexedRecords)
+        let syscalls = AuditSegmentQuery(from: .distantPast, to: .distantFuture, eventTypes: [.systemCall])
+        XCTAssertTrue(segment.mayContain(syscalls), "An unindexed tail cannot be ruled out")
+        XCTAssertEqual(try readAll(url, syscalls).count, 1, "The torn record should end the scan")
+        XCTAssertEqual(try readAll(url, everything).count, 2)
+    }
+
+    func testCorruptRecordKeepsEarlierMatches() throws {
+        let writer = try AuditSegmentWriter(directory: directory, maxSegmentBytes: 1 << 20)
+        writer.append(makeEvent(source: "first"))
+        writer.append(makeEvent(source: "second"))
+        writer.append(makeEvent(source: "third"))
+        writer.close()
+        let url = try XCTUnwrap(try segments().first)
+
+        // Give the second record an outcome code no decoder knows
+        var bytes = [UInt8](try Data(contentsOf: url))
+        let first = AuditSegmentFormat.headerSize
+        let firstLength = bytes[first..<first + 4].reversed().reduce(0) { $0 << 8 | Int($1) }
+        let secondPayload = first + 4 + firstLength + 4
+        bytes[secondPayload + 10] = 0xFF
+        try Data(bytes).write(to: url)
+
+        let events = try readAll(url, everything)
+        XCTAssertEqual(events.map { $0.source }, ["first"], "The scan should stop at the corrupt record and keep what it read")
+    }
+
+    func testQueryFiltersOnSourceAndCorrelation() throws {
+        let writer = try AuditSegmentWriter(directory: directory, maxSegmentBytes: 1 << 20)
+        writer.append(makeEvent(source: "network_filter", correlationId: "a"))
+        writer.append(makeEvent(source: "sandbox_manager", correlationId: "a"))
+        writer.append(makeEvent(source: "network_filter", correlationId: "b"))
+        writer.close()
+        let url = try XCTUnwrap(try segments().first)
+
+        let query = AuditSegmentQuery(from: .distantPast, to: .distantFuture,
+                                      sources: ["network_filter"], correlationId: "a")
+        let matches = try readAll(url, query)
+        XCTAssertEqual(matches.count, 1)
+        XCTAssertEqual(matches.first?.source, "network_filter")
+        XCTAssertEqual(matches.first?.correlationId, "a")
+    }
+
+    // MARK: - Export
+
+    func testExportRendersJSONAndEscapedCSV() throws {
+        let events = [makeEvent(), makeEvent(type: .networkActivity)]
+
+        let json = try AuditEventExporter.export(events, format: .json)
+        let array = try XCTUnwrap(try JSONSerialization.jsonObject(with: json) as? [[String: Any]])
+        XCTAssertEqual(array.count, 2)
+        XCTAssertEqual(array.first?["eventType"] as? String, "SYSTEM_CALL")
+
+        let csv = String(decoding: try AuditEventExporter.export(events, format: .csv), as: UTF8.self)
+        XCTAssertTrue(csv.hasPrefix("id,timestamp,eventType"))
+        XCTAssertTrue(csv.contains("\"note=line\nbreak;reason=policy\""), "Fields with line breaks should be quoted")
+    }
+}
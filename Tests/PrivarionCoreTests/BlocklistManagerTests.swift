@@ -158,6 +158,24 @@ final class BlocklistManagerTests: XCTestCase {
         XCTAssertTrue(blocklistManager.shouldBlockIP(testIP))
     }
     
+    func testAddBlockedIPRanges() {
+        blocklistManager.addBlockedIP("10.20.0.0/16")
+        blocklistManager.addBlockedIP("2001:db8::/32")
+        blocklistManager.addBlockedIP("198.51.100.10-198.51.100.20")
+        blocklistManager.addBlockedIP("not-an-address")
+        
+        // Wait for async operation
+        Thread.sleep(forTimeInterval: 0.1)
+        
+        XCTAssertTrue(blocklistManager.shouldBlockIP("10.20.255.1"))
+        XCTAssertFalse(blocklistManager.shouldBlockIP("10.21.0.1"))
+        XCTAssertTrue(blocklistManager.shouldBlockIP("2001:db8:abcd::1"))
+        XCTAssertFalse(blocklistManager.shouldBlockIP("2001:db9::1"))
+        XCTAssertTrue(blocklistManager.shouldBlockIP("198.51.100.15"))
+        XCTAssertFalse(blocklistManager.shouldBlockIP("198.51.100.21"))
+        XCTAssertTrue(blocklistManager.shouldBlockAddress(IPPrefixTree.Address(ipv4: 0x0A14_0001)))
+    }
+    
     // MARK: - Whitelist Tests
     
     func testWhitelistedDomain() {
@@ -251,4 +269,228 @@ final class BlocklistManagerTests: XCTestCase {
         XCTAssertTrue(blocklistManager.shouldBlockDomain("UPPERCASE-DOMAIN.COM"))
         XCTAssertTrue(blocklistManager.shouldBlockDomain("  uppercase-domain.com  "))
     }
+    
+    // MARK: - Compiled Rule Tests
+    
+    func testCompiledRulesMatchEachRuleShape() {
+        let trie = DomainRuleTrie(rules: [
+            (pattern: "example.com", tag: 3),
+            (pattern: "*.ads.example.org", tag: 2),
+            (pattern: "*.metrics.*", tag: 4),
+            (pattern: "cdn-*.net", tag: 5)
+        ])
+        
+        // Domain rules match the domain and its subdomains, not lookalikes
+        XCTAssertEqual(trie.match("example.com"), 3)
+        XCTAssertEqual(trie.match("a.b.Example.COM"), 3)
+        XCTAssertEqual(trie.match("notexample.com"), DomainRuleTrie.noMatch)
+        
+        // Leading wildcards match subdomains only
+        XCTAssertEqual(trie.match("x.ads.example.org"), 2)
+        XCTAssertEqual(trie.match("ads.example.org"), DomainRuleTrie.noMatch)
+        
+        // Infix wildcards need a label on either side
+        XCTAssertEqual(trie.match("eu.metrics.vendor.io"), 4)
+        XCTAssertEqual(trie.match("metrics.vendor.io"), DomainRuleTrie.noMatch)
+        XCTAssertEqual(trie.match("eu.metrics"), DomainRuleTrie.noMatch)
+        
+        // Anything else is a glob over the whole name
+        XCTAssertEqual(trie.match("cdn-eu1.net"), 5)
+        XCTAssertEqual(trie.match("cdn.net"), DomainRuleTrie.noMatch)
+    }
+    
+    func testCompiledRulesReportLowestMatchingTag() {
+        let trie = DomainRuleTrie(rules: [
+            (pattern: "tracker.example.com", tag: 7),
+            (pattern: "example.com", tag: 1),
+            (pattern: "*.example.*", tag: 0)
+        ])
+        
+        XCTAssertEqual(trie.match("tracker.example.com"), 0)
+        XCTAssertEqual(trie.match("example.com"), 1)
+        XCTAssertTrue(trie.contains("deep.tracker.example.com"))
+        XCTAssertFalse(DomainRuleTrie().contains("example.com"))
+    }
+    
+    func testCategoryTagsRoundTrip() {
+        let tags = BlocklistCategory.allCases.map { CompiledBlocklist.tag(for: $0) }
+        XCTAssertEqual(Set(tags).count, tags.count, "Each category needs its own tag")
+        XCTAssertFalse(tags.contains(CompiledBlocklist.domainBlocklistTag))
+        for category in BlocklistCategory.allCases {
+            XCTAssertEqual(CompiledBlocklist.category(for: CompiledBlocklist.tag(for: category)), category)
+        }
+        XCTAssertNil(CompiledBlocklist.category(for: CompiledBlocklist.domainBlocklistTag))
+        XCTAssertNil(CompiledBlocklist.category(for: 255))
+    }
+    
+    func testCompiledRuleLookupPerformance() {
+        let domains = (0..<200_000).map { "host\($0).tracker\($0 % 997).com" }
+        let trie = DomainRuleTrie(rules: domains.map { (pattern: $0, tag: UInt8(1)) })
+        XCTAssertEqual(trie.ruleCount, domains.count)
+        
+        measure {
+            var hits = 0
+            for index in stride(from: 0, to: domains.count, by: 20) {
+                if trie.contains("www.\(domains[index])") {
+                    hits += 1
+                }
+            }
+            XCTAssertEqual(hits, domains.count / 20)
+        }
+    }
+    
+    // MARK: - Blocklist Image Tests
+    
+    func testFeedParserAcceptsDomainAndHostsLines() {
+        let feed = """
+        # Comment line
+        tracker.example.com
+        0.0.0.0 Ads.Vendor.CO.UK   # inline comment
+        127.0.0.1\tmetrics.example.org
+        localhost
+        bad_domain.com
+        win10.ms telemetry.microsoft.com
+        -leading.example.com
+        fqdn.example.net.
+        """
+        
+        XCTAssertEqual(BlocklistFeedParser.domains(in: Data(feed.utf8)), [
+            "tracker.example.com",
+            "ads.vendor.co.uk",
+            "metrics.example.org",
+            "fqdn.example.net"
+        ])
+    }
+    
+    func testBlocklistImageRoundTripsThroughFile() throws {
+        let rules = [
+            DomainRuleTrie.Rule(pattern: "example.com", tag: 3),
+            DomainRuleTrie.Rule(pattern: "*.ads.example.org", tag: 2),
+            DomainRuleTrie.Rule(pattern: "*.metrics.*", tag: 4),
+            DomainRuleTrie.Rule(pattern: "cdn-*.net", tag: 5)
+        ]
+        let url = tempDirectory.appendingPathComponent("rules.pvbl")
+        let compiled = try BlocklistImageCompiler.compile(rules, to: url)
+        let mapped = try DomainRuleTrie(contentsOf: url)
+        
+        XCTAssertEqual(mapped.imageChecksum, compiled.imageChecksum)
+        XCTAssertEqual(mapped.ruleCount, rules.count)
+        for domain in ["a.example.com", "x.ads.example.org", "ads.example.org", "eu.metrics.vendor.io", "cdn-eu1.net", "cdn.net"] {
+            XCTAssertEqual(mapped.match(domain), compiled.match(domain), domain)
+        }
+        XCTAssertEqual(mapped.match("a.example.com"), 3)
+        
+        // A corrupted image is rejected rather than mapped
+        var bytes = try Data(contentsOf: url)
+        bytes[bytes.count - 1] ^= 0xFF
+        try bytes.write(to: url)
+        XCTAssertThrowsError(try DomainRuleTrie(contentsOf: url))
+    }
+    
+    func testBlocklistPatchAddsAndRemovesRules() throws {
+        let old = [
+            DomainRuleTrie.Rule(pattern: "tracker.com", tag: 1),
+            DomainRuleTrie.Rule(pattern: "*.tracker.com", tag: 1),
+            DomainRuleTrie.Rule(pattern: "stale.net", tag: 2)
+        ]
+        let new = [
+            DomainRuleTrie.Rule(pattern: "*.tracker.com", tag: 1),
+            DomainRuleTrie.Rule(pattern: "fresh.net", tag: 2)
+        ]
+        let base = DomainRuleTrie(rules: old.map { (pattern: $0.pattern, tag: $0.tag) })
+        let patch = BlocklistPatch.diff(from: old, to: new, baseChecksum: base.imageChecksum)
+        
+        let url = tempDirectory.appendingPathComponent("update.pvbp")
+        try patch.write(to: url)
+        let patched = try base.applying(BlocklistPatch(contentsOf: url))
+        
+        XCTAssertEqual(patched.ruleCount, new.count)
+        XCTAssertEqual(patched.match("tracker.com"), DomainRuleTrie.noMatch)
+        XCTAssertEqual(patched.match("www.tracker.com"), 1)
+        XCTAssertEqual(patched.match("stale.net"), DomainRuleTrie.noMatch)
+        XCTAssertEqual(patched.match("cdn.fresh.net"), 2)
+        
+        // The base image is left untouched
+        XCTAssertEqual(base.match("stale.net"), 2)
+    }
+    
+    func testBlocklistPatchRejectsOtherImage() {
+        let base = DomainRuleTrie(rules: [(pattern: "tracker.com", tag: UInt8(1))])
+        let patch = BlocklistPatch(
+            baseChecksum: base.imageChecksum &+ 1,
+            added: [DomainRuleTrie.Rule(pattern: "other.com", tag: 1)],
+            removed: []
+        )
+        
+        XCTAssertThrowsError(try base.applying(patch)) { error in
+            guard case BlocklistImageError.patchMismatch = error else {
+                return XCTFail("Unexpected error: \(error)")
+            }
+        }
+        XCTAssertThrowsError(try BlocklistPatch(serialized: Data("PVBP".utf8)))
+    }
+    
+    func testLoadBlocklistImageBlocksFeedDomains() throws {
+        let feed = tempDirectory.appendingPathComponent("tracking-domains.txt")
+        try "# feed\nfeed-tracker.example\n".write(to: feed, atomically: true, encoding: .utf8)
+        let image = tempDirectory.appendingPathComponent("feeds.pvbl")
+        try BlocklistImageCompiler.compile(feeds: BlocklistImageCompiler.feeds(in: tempDirectory), to: image)
+        
+        XCTAssertFalse(blocklistManager.shouldBlockDomain("cdn.feed-tracker.example"))
+        try blocklistManager.loadBlocklistImage(at: image)
+        XCTAssertTrue(blocklistManager.shouldBlockDomain("cdn.feed-tracker.example"))
+        XCTAssertEqual(blocklistManager.getStatistics().categoryBlocks[.tracking], 1)
+    }
+    
+    // MARK: - IP Prefix Tree Tests
+    
+    func testIPPrefixTreeReturnsLongestPrefixMatch() {
+        let rules: [(String, UInt8)] = [
+            ("10.0.0.0/8", 1),
+            ("10.1.0.0/16", 2),
+            ("10.1.2.3", 3),
+            ("::/0", 4),
+            ("2001:db8::/32", 5)
+        ]
+        let tree = IPPrefixTree(prefixes: rules.map { (prefix: IPPrefixTree.Prefix.parse($0.0)![0], tag: $0.1) })
+        
+        XCTAssertEqual(tree.prefixCount, 5)
+        XCTAssertEqual(tree.match("10.200.0.1"), 1)
+        XCTAssertEqual(tree.match("10.1.200.1"), 2)
+        XCTAssertEqual(tree.match("10.1.2.3"), 3)
+        XCTAssertEqual(tree.match("2001:db8::1"), 5)
+        XCTAssertEqual(tree.match("fe80::1"), 4)
+        // IPv4 is mapped into IPv6, so the default route covers it too
+        XCTAssertEqual(tree.match("192.0.2.1"), 4)
+        XCTAssertEqual(tree.match("bogus"), IPPrefixTree.noMatch)
+        XCTAssertEqual(IPPrefixTree().match(ipv4: 0x0A01_0203), IPPrefixTree.noMatch)
+    }
+    
+    func testIPPrefixRangesBecomeCoveringPrefixes() {
+        let prefixes = IPPrefixTree.Prefix.parse("192.0.2.1-192.0.2.6")
+        XCTAssertEqual(prefixes?.map { $0.length - 96 }, [32, 31, 31, 32])
+        
+        XCTAssertEqual(IPPrefixTree.Prefix.parse("0.0.0.0-255.255.255.255")?.map { $0.length }, [96])
+        XCTAssertNil(IPPrefixTree.Prefix.parse("10.0.0.0/33"))
+        XCTAssertNil(IPPrefixTree.Prefix.parse("192.0.2.9-192.0.2.1"))
+        XCTAssertNil(IPPrefixTree.Prefix.parse("192.0.2.1-2001:db8::1"))
+    }
+    
+    func testIPPrefixTreeLookupPerformance() {
+        let prefixes = (0..<200_000).map { index in
+            (prefix: IPPrefixTree.Prefix(address: IPPrefixTree.Address(ipv4: UInt32(index) << 8), length: 96 + 24), tag: UInt8(0))
+        }
+        let tree = IPPrefixTree(prefixes: prefixes)
+        XCTAssertEqual(tree.prefixCount, prefixes.count)
+        
+        measure {
+            var hits = 0
+            for index in stride(from: 0, to: prefixes.count, by: 4) {
+                if tree.contains(IPPrefixTree.Address(ipv4: UInt32(index) << 8 | 0x7F)) {
+                    hits += 1
+                }
+            }
+            XCTAssertEqual(hits, prefixes.count / 4)
+        }
+    }
 }
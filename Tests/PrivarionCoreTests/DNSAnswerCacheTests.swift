@@ -0,0 +1,191 @@
+import XCTest
+@testable import PrivarionCore
+
+final class DNSAnswerCacheTests: XCTestCase {
+
+    /// Monotonic test clock in nanoseconds
+    private var now: UInt64 = 1_000_000_000
+
+    private func makeCache(capacityBytes: Int = 64 * 1024, maximumTTL: UInt32 = 3600, shardCount: Int = 4) -> DNSAnswerCache {
+        return DNSAnswerCache(capacityBytes: capacityBytes, maximumTTL: maximumTTL, shardCount: shardCount) { [unowned self] in
+            self.now
+        }
+    }
+
+    private func advance(seconds: UInt64) {
+        now += seconds * 1_000_000_000
+    }
+
+    // MARK: - Helpers
+
+    private func question(_ name: String, type: UInt16) -> [UInt8] {
+        var bytes: [UInt8] = []
+        for label in name.split(separator: ".") {
+            bytes.append(UInt8(label.utf8.count))
+            bytes.append(contentsOf: label.utf8)
+        }
+        return bytes + [0x00, UInt8(type >> 8), UInt8(type & 0xFF), 0x00, 0x01]
+    }
+
+    private func makeQuery(_ name: String, id: UInt16, type: UInt16 = 1) -> [UInt8] {
+        return [UInt8(id >> 8), UInt8(id & 0xFF), 0x01, 0x00, 0x00, 0x01, 0, 0, 0, 0, 0, 0] + question(name, type: type)
+    }
+
+    private func ttlBytes(_ ttl: UInt32) -> [UInt8] {
+        return [UInt8(ttl >> 24), UInt8(ttl >> 16 & 0xFF), UInt8(ttl >> 8 & 0xFF), UInt8(ttl & 0xFF)]
+    }
+
+    /// A response with one A record
+    private func makeAddressResponse(_ name: String, id: UInt16 = 0x1234, ttl: UInt32, flags: UInt16 = 0x8180) -> [UInt8] {
+        let header: [UInt8] = [UInt8(id >> 8), UInt8(id & 0xFF), UInt8(flags >> 8), UInt8(flags & 0xFF), 0x00, 0x01, 0x00, 0x01, 0, 0, 0, 0]
+        let answer: [UInt8] = [0xC0, 0x0C, 0x00, 0x01, 0x00, 0x01] + ttlBytes(ttl) + [0x00, 0x04, 93, 184, 216, 34]
+        return header + question(name, type: 1) + answer
+    }
+
+    /// An NXDOMAIN response, with an SOA authority record when `soa` is given
+    private func makeNameErrorResponse(_ name: String, soa: (ttl: UInt32, minimum: UInt32)?) -> [UInt8] {
+        let header: [UInt8] = [0x12, 0x34, 0x81, 0x83, 0x00, 0x01, 0x00, 0x00, 0x00, soa == nil ? 0 : 1, 0, 0]
+        var message = header + question(name, type: 1)
+        if let soa = soa {
+            // Owner is the root; MNAME and RNAME are root too, then five counters
+            var rdata: [UInt8] = [0x00, 0x00]
+            rdata += ttlBytes(1) + ttlBytes(7200) + ttlBytes(900) + ttlBytes(1_209_600) + ttlBytes(soa.minimum)
+            message += [0x00, 0x00, 0x06, 0x00, 0x01] + ttlBytes(soa.ttl) + [0x00, UInt8(rdata.count)] + rdata
+        }
+        return message
+    }
+
+    /// An OPT pseudo-record advertising 4096 bytes, with the given extended flags
+    private func optRecord(flags: UInt32) -> [UInt8] {
+        return [0x00, 0x00, 0x29, 0x10, 0x00] + ttlBytes(flags) + [0x00, 0x00]
+    }
+
+    /// Append `record` to the additional section of `message`
+    private func addingAdditional(_ record: [UInt8], to message: [UInt8]) -> [UInt8] {
+        var extended = message + record
+        extended[11] += 1
+        return extended
+    }
+
+    private func lookup(_ cache: DNSAnswerCache, _ query: [UInt8]) -> DNSAnswerCache.Answer? {
+        return query.withUnsafeBytes { message in
+            DNSWireFormat.parseQuery(message).flatMap { cache.answer(for: $0, in: message) }
+        }
+    }
+
+    @discardableResult
+    private func store(_ cache: DNSAnswerCache, _ response: [UInt8]) -> Bool {
+        return response.withUnsafeBytes { cache.store(response: $0) }
+    }
+
+    private func ttl(of response: [UInt8], at offset: Int) -> UInt32 {
+        return response[offset..<offset + 4].reduce(UInt32(0)) { $0 << 8 | UInt32($1) }
+    }
+
+    // MARK: - Tests
+
+    func testHitRewritesIDAndAgesTTL() throws {
+        let cache = makeCache()
+        let response = makeAddressResponse("www.example.com", ttl: 300)
+        XCTAssertTrue(store(cache, response))
+
+        advance(seconds: 100)
+        let answer = try XCTUnwrap(lookup(cache, makeQuery("WWW.Example.com", id: 0xAAAA)))
+        XCTAssertEqual(answer.response[0...1], [0xAA, 0xAA])
+        XCTAssertEqual(ttl(of: answer.response, at: response.count - 10), 200)
+        XCTAssertFalse(answer.isNegative)
+
+        // Other types are separate entries
+        XCTAssertNil(lookup(cache, makeQuery("www.example.com", id: 1, type: 28)))
+    }
+
+    func testEntriesExpireAndTTLIsCapped() {
+        let cache = makeCache(maximumTTL: 60)
+        store(cache, makeAddressResponse("capped.example.com", ttl: 86400))
+
+        advance(seconds: 59)
+        let answer = lookup(cache, makeQuery("capped.example.com", id: 1))
+        XCTAssertEqual(answer.map { ttl(of: $0.response, at: $0.response.count - 10) }, 1)
+
+        advance(seconds: 1)
+        XCTAssertNil(lookup(cache, makeQuery("capped.example.com", id: 1)))
+        XCTAssertEqual(cache.statistics.entryCount, 0)
+    }
+
+    func testNegativeAnswersUseSOAMinimum() throws {
+        let cache = makeCache()
+        XCTAssertFalse(store(cache, makeNameErrorResponse("nosoa.example.com", soa: nil)), "RFC 2308: no SOA, no caching")
+        XCTAssertTrue(store(cache, makeNameErrorResponse("missing.example.com", soa: (ttl: 3600, minimum: 30))))
+
+        let answer = try XCTUnwrap(lookup(cache, makeQuery("missing.example.com", id: 7)))
+        XCTAssertTrue(answer.isNegative)
+        XCTAssertEqual(answer.response[3] & 0x0F, 3)
+
+        advance(seconds: 30)
+        XCTAssertNil(lookup(cache, makeQuery("missing.example.com", id: 7)))
+    }
+
+    func testUncacheableResponsesAreIgnored() {
+        let cache = makeCache()
+        XCTAssertFalse(store(cache, makeAddressResponse("tc.example.com", ttl: 300, flags: 0x8380)), "Truncated")
+        XCTAssertFalse(store(cache, makeAddressResponse("fail.example.com", ttl: 300, flags: 0x8182)), "SERVFAIL")
+        XCTAssertFalse(store(cache, makeAddressResponse("zero.example.com", ttl: 0)))
+        XCTAssertFalse(store(cache, makeQuery("query.example.com", id: 1)), "Queries are not answers")
+    }
+
+    func testEDNSAnswersAreOnlyServedToEDNSQueries() throws {
+        let cache = makeCache()
+        let signed = addingAdditional(optRecord(flags: 0x8000), to: makeAddressResponse("dnssec.example.com", ttl: 300))
+        XCTAssertTrue(store(cache, signed))
+
+        // A plain client must not receive the OPT record, nor DNSSEC data
+        XCTAssertNil(lookup(cache, makeQuery("dnssec.example.com", id: 3)))
+        XCTAssertNil(lookup(cache, addingAdditional(optRecord(flags: 0), to: makeQuery("dnssec.example.com", id: 3))))
+        var checkingDisabled = addingAdditional(optRecord(flags: 0x8000), to: makeQuery("dnssec.example.com", id: 3))
+        checkingDisabled[3] |= 0x10
+        XCTAssertNil(lookup(cache, checkingDisabled))
+
+        let answer = try XCTUnwrap(lookup(cache, addingAdditional(optRecord(flags: 0x8000), to: makeQuery("dnssec.example.com", id: 3))))
+        XCTAssertEqual(answer.response.count, signed.count)
+
+        // The plain exchange is cached beside it
+        XCTAssertTrue(store(cache, makeAddressResponse("dnssec.example.com", ttl: 300)))
+        let plain = try XCTUnwrap(lookup(cache, makeQuery("dnssec.example.com", id: 4)))
+        XCTAssertEqual(plain.response[10...11], [0x00, 0x00], "The plain answer carries no OPT record")
+        XCTAssertEqual(cache.statistics.entryCount, 2)
+    }
+
+    func testPopularNamesArePrefetchedOnceNearExpiry() {
+        let cache = makeCache()
+        store(cache, makeAddressResponse("hot.example.com", ttl: 100))
+        let query = makeQuery("hot.example.com", id: 2)
+
+        XCTAssertEqual(lookup(cache, query)?.shouldPrefetch, false)
+        advance(seconds: 95)
+        XCTAssertEqual(lookup(cache, query)?.shouldPrefetch, true)
+        XCTAssertEqual(lookup(cache, query)?.shouldPrefetch, false, "One refresh at a time")
+
+        // A refreshed answer starts a new lifetime
+        store(cache, makeAddressResponse("hot.example.com", ttl: 100))
+        advance(seconds: 50)
+        XCTAssertNotNil(lookup(cache, query))
+        XCTAssertEqual(cache.statistics.prefetches, 1)
+    }
+
+    func testScanDoesNotEvictRepeatedlyUsedName() {
+        // One shard so every name competes for the same budget
+        let cache = makeCache(capacityBytes: 4096, shardCount: 1)
+        store(cache, makeAddressResponse("keep.example.com", ttl: 3600))
+        _ = lookup(cache, makeQuery("keep.example.com", id: 1))
+
+        for index in 0..<200 {
+            store(cache, makeAddressResponse("scan\(index).example.com", ttl: 3600))
+        }
+
+        XCTAssertNotNil(lookup(cache, makeQuery("keep.example.com", id: 1)))
+        XCTAssertNil(lookup(cache, makeQuery("scan0.example.com", id: 1)))
+        let statistics = cache.statistics
+        XCTAssertLessThanOrEqual(statistics.byteCount, 4096)
+        XCTAssertGreaterThan(statistics.evictions, 0)
+    }
+}
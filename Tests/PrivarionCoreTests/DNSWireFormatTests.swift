@@ -0,0 +1,142 @@
+import XCTest
+@testable import PrivarionCore
+
+final class DNSWireFormatTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    /// Query for `name` with RD set and an optional EDNS(0) OPT record
+    private func makeQuery(_ name: String, type: UInt16 = 1, edns: Bool = false) -> [UInt8] {
+        var message: [UInt8] = [0xBE, 0xEF, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, edns ? 0x01 : 0x00]
+        for label in name.split(separator: ".") {
+            message.append(UInt8(label.utf8.count))
+            message.append(contentsOf: label.utf8)
+        }
+        message += [0x00, UInt8(type >> 8), UInt8(type & 0xFF), 0x00, 0x01]
+        if edns {
+            // Root owner, OPT, 1232-byte payload, DO bit, one 4-byte option
+            message += [0x00, 0x00, 0x29, 0x04, 0xD0, 0x00, 0x00, 0x80, 0x00, 0x00, 0x04, 0x00, 0x0A, 0x00, 0x00]
+        }
+        return message
+    }
+
+    private func parse(_ message: [UInt8]) -> DNSQueryView? {
+        return message.withUnsafeBytes { DNSWireFormat.parseQuery($0) }
+    }
+
+    private func name(of query: DNSQueryView, in message: [UInt8]) -> String {
+        return message.withUnsafeBytes { DNSWireFormat.name(of: query, in: $0) }
+    }
+
+    // MARK: - Parsing Tests
+
+    func testParseQueryReadsQuestionInPlace() throws {
+        let message = makeQuery("Tracker.Example.COM", type: 28)
+        let query = try XCTUnwrap(parse(message))
+
+        XCTAssertEqual(query.id, 0xBEEF)
+        XCTAssertEqual(query.queryType, DNSWireFormat.typeAAAA)
+        XCTAssertEqual(query.queryClass, DNSWireFormat.classIN)
+        XCTAssertEqual(query.labelCount, 3)
+        XCTAssertEqual(query.nameLength, 19)
+        XCTAssertEqual(query.questionEnd, message.count)
+        XCTAssertEqual(name(of: query, in: message), "tracker.example.com")
+        XCTAssertEqual(query.nameHash, DNSWireFormat.nameHash("tracker.example.com"))
+        XCTAssertEqual(query.nameHash, DNSWireFormat.nameHash("TRACKER.example.com"))
+        XCTAssertNil(query.ednsPayloadSize)
+    }
+
+    func testParseQueryFollowsBackwardPointersOnly() throws {
+        // "example.com" at 12, then a second name "ads" + pointer to it
+        var message = makeQuery("example.com")
+        message[5] = 0x02
+        message += [0x03] + Array("ads".utf8) + [0xC0, 0x0C, 0x00, 0x01, 0x00, 0x01]
+        let first = try XCTUnwrap(parse(message))
+        XCTAssertEqual(name(of: first, in: message), "example.com")
+
+        // A name that points at itself is rejected
+        var looping = makeQuery("a.b")
+        looping[12] = 0xC0
+        looping[13] = 0x0C
+        XCTAssertNil(parse(looping))
+    }
+
+    func testParseQueryRejectsMalformedMessages() {
+        XCTAssertNil(parse([0x00, 0x01, 0x01]))
+
+        var response = makeQuery("example.com")
+        response[2] |= 0x80
+        XCTAssertNil(parse(response), "Responses are not queries")
+
+        let truncated = Array(makeQuery("example.com").dropLast(3))
+        XCTAssertNil(parse(truncated))
+
+        var badLabel = makeQuery("example.com")
+        badLabel[12] = 0x47
+        XCTAssertNil(parse(badLabel), "0x40 label types are not supported")
+    }
+
+    func testParseQueryFindsEDNSRecord() throws {
+        let query = try XCTUnwrap(parse(makeQuery("example.com", edns: true)))
+        XCTAssertEqual(query.ednsPayloadSize, 1232)
+        XCTAssertEqual(query.ednsFlags & 0x8000, 0x8000)
+    }
+
+    // MARK: - Response Tests
+
+    func testNameErrorResponseRewritesQueryInPlace() throws {
+        var message = makeQuery("ads.example.com", edns: true)
+        let query = try XCTUnwrap(parse(message))
+        let length = message.withUnsafeMutableBytes {
+            DNSWireFormat.writeBlockedResponse(into: $0, for: query, answer: .nameError)
+        }
+
+        // The response never outgrows a query that carried EDNS
+        XCTAssertLessThanOrEqual(length, message.count)
+        let response = Array(message[0..<length])
+        XCTAssertEqual(response[0...1], [0xBE, 0xEF])
+        XCTAssertEqual(UInt16(response[2]) << 8 | UInt16(response[3]), 0x8183)
+        XCTAssertEqual(response[4...11], [0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01])
+        XCTAssertEqual(Array(response[12..<query.questionEnd]), Array(makeQuery("ads.example.com")[12...]))
+
+        // OPT echoed with the DO bit and no options
+        XCTAssertEqual(Array(response[query.questionEnd...]), [0x00, 0x00, 0x29, 0x04, 0xD0, 0x00, 0x00, 0x80, 0x00, 0x00, 0x00])
+    }
+
+    func testSinkholeResponseAnswersAddressQueries() throws {
+        var data = Data(makeQuery("ads.example.com", type: 1))
+        let query = try XCTUnwrap(data.withUnsafeBytes { DNSWireFormat.parseQuery($0) })
+        DNSWireFormat.makeBlockedResponse(&data, for: query, answer: .sinkhole(ttl: 300))
+
+        let response = [UInt8](data)
+        XCTAssertEqual(response.count, query.questionEnd + 16)
+        XCTAssertEqual(response[3] & 0x0F, 0, "Sinkhole answers are NOERROR")
+        XCTAssertEqual(response[7], 1)
+        XCTAssertEqual(Array(response[query.questionEnd...]), [0xC0, 0x0C, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x01, 0x2C, 0x00, 0x04, 0, 0, 0, 0])
+
+        // Other types get an empty answer
+        var txt = Data(makeQuery("ads.example.com", type: 16))
+        let txtQuery = try XCTUnwrap(txt.withUnsafeBytes { DNSWireFormat.parseQuery($0) })
+        DNSWireFormat.makeBlockedResponse(&txt, for: txtQuery, answer: .sinkhole(ttl: 300))
+        XCTAssertEqual(txt.count, txtQuery.questionEnd)
+        XCTAssertEqual(txt[7], 0)
+    }
+
+    func testCanonicalNameMatchesBlocklist() throws {
+        let manager = BlocklistManager()
+        manager.addBlockedDomain("ads.wire-format-test.example")
+        
+        // Wait for the rules to be rebuilt
+        Thread.sleep(forTimeInterval: 0.2)
+
+        let blocked = makeQuery("Ads.WIRE-FORMAT-TEST.example")
+        let allowed = makeQuery("www.wire-format-test.example")
+        for (message, expected) in [(blocked, true), (allowed, false)] {
+            let query = try XCTUnwrap(parse(message))
+            let result = message.withUnsafeBytes { bytes in
+                DNSWireFormat.withCanonicalName(of: query, in: bytes) { manager.shouldBlockDomain(canonicalName: $0) }
+            }
+            XCTAssertEqual(result, expected)
+        }
+    }
+}
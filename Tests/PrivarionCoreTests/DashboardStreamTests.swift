@@ -0,0 +1,119 @@
+import XCTest
+import NIOCore
+@testable import PrivarionCore
+
+final class DashboardStreamTests: XCTestCase {
+
+    // MARK: - Frame Format
+
+    func testFormatIsNegotiatedFromUpgradeQuery() {
+        XCTAssertEqual(DashboardFrameFormat(uri: "/dashboard"), .json)
+        XCTAssertEqual(DashboardFrameFormat(uri: "/dashboard?format=binary"), .binary)
+        XCTAssertEqual(DashboardFrameFormat(uri: "/dashboard?token=abc&format=binary"), .binary)
+        XCTAssertEqual(DashboardFrameFormat(uri: "/dashboard?format=json"), .json)
+    }
+
+    // MARK: - State Table
+
+    func testDeltaCarriesOnlyChangesSinceBase() {
+        var table = DashboardStateTable()
+        XCTAssertTrue(table.replace(with: ["metrics.latency": 12, "metrics.connections": 3, "connections.a": 1]))
+        let first = table.version
+
+        XCTAssertFalse(table.replace(with: ["metrics.latency": 12, "metrics.connections": 3, "connections.a": 1]),
+                       "Unchanged state should not advance the version")
+        XCTAssertEqual(table.version, first)
+
+        table.replace(with: ["metrics.latency": 15, "metrics.connections": 3, "connections.b": 2])
+        let delta = table.delta(since: first)
+        XCTAssertFalse(delta.isSnapshot)
+        XCTAssertEqual(delta.baseVersion, first)
+        XCTAssertEqual(delta.version, table.version)
+        XCTAssertEqual(delta.changes.map { $0.key }, ["connections.b", "metrics.latency"])
+        XCTAssertEqual(delta.removals, ["connections.a"])
+        XCTAssertTrue(table.delta(since: table.version).isEmpty)
+    }
+
+    func testUnknownOrForgottenBaseGetsSnapshot() {
+        var table = DashboardStateTable(maxRemovals: 1)
+        table.replace(with: ["a": 1, "b": 2, "c": 3])
+        let base = table.version
+        table.replace(with: ["b": 2, "c": 3])
+        table.replace(with: ["c": 3])
+
+        XCTAssertTrue(table.delta(since: 0).isSnapshot)
+        XCTAssertTrue(table.delta(since: table.version + 5).isSnapshot)
+
+        let stale = table.delta(since: base)
+        XCTAssertTrue(stale.isSnapshot, "Removal of a was forgotten, so a patch would leave it behind")
+        XCTAssertEqual(stale.changes, [DashboardStateTable.Delta.Change(key: "c", value: 3)])
+    }
+
+    // MARK: - Binary Frames
+
+    func testStateDeltaRoundTrips() throws {
+        var table = DashboardStateTable()
+        table.replace(with: ["metrics.latency": 4.25, "connections.client_7": 2])
+        let base = table.version
+        table.replace(with: ["metrics.latency": -0.5, "metrics.throughput": .infinity])
+
+        for delta in [table.delta(since: 0), table.delta(since: base)] {
+            let decoded = try XCTUnwrap(DashboardBinaryFrame.decodeStateDelta(DashboardBinaryFrame.stateDelta(delta)))
+            XCTAssertEqual(decoded, delta)
+        }
+    }
+
+    func testPatchingFromAcknowledgedVersionReproducesState() throws {
+        var table = DashboardStateTable()
+        var client: [String: Double] = [:]
+        var acknowledged: UInt64 = 0
+
+        let states: [[String: Double]] = [
+            ["a": 1, "b": 2],
+            ["a": 1, "b": 3, "c": 4],
+            ["b": 3, "c": 5],
+            ["d": 6]
+        ]
+        for (index, state) in states.enumerated() {
+            table.replace(with: state)
+            // The client only applies and acknowledges every other update
+            guard index % 2 == 1 || index == states.count - 1 else { continue }
+
+            let frame = DashboardBinaryFrame.stateDelta(table.delta(since: acknowledged))
+            let delta = try XCTUnwrap(DashboardBinaryFrame.decodeStateDelta(frame))
+            if delta.isSnapshot {
+                client.removeAll()
+            }
+            delta.removals.forEach { client.removeValue(forKey: $0) }
+            delta.changes.forEach { client[$0.key] = $0.value }
+
+            let ack = DashboardBinaryFrame.acknowledge(version: delta.version)
+            acknowledged = try XCTUnwrap(DashboardBinaryFrame.acknowledgedVersion(in: ack))
+            XCTAssertEqual(client, state)
+        }
+    }
+
+    func testNetworkEventsFrameCarriesCounts() throws {
+        let frame = DashboardBinaryFrame.networkEvents(
+            [(eventType: .connectionEstablished, count: 40), (eventType: .dnsQuery, count: 3)],
+            timestamp: Date()
+        )
+        XCTAssertEqual(frame.readableBytes, 2 + 8 + 1 + 2 * 5)
+
+        let counts = try XCTUnwrap(DashboardBinaryFrame.decodeNetworkEvents(frame))
+        XCTAssertEqual(counts, [.connectionEstablished: 40, .dnsQuery: 3])
+        XCTAssertNil(DashboardBinaryFrame.acknowledgedVersion(in: frame))
+        XCTAssertNil(DashboardBinaryFrame.decodeStateDelta(frame))
+    }
+
+    func testTruncatedFramesAreRejected() {
+        var table = DashboardStateTable()
+        table.replace(with: ["metrics.latency": 1])
+        let frame = DashboardBinaryFrame.stateDelta(table.delta(since: 0))
+
+        for length in 0..<frame.readableBytes {
+            let truncated = frame.getSlice(at: frame.readerIndex, length: length) ?? ByteBuffer()
+            XCTAssertNil(DashboardBinaryFrame.decodeStateDelta(truncated), "length \(length)")
+        }
+    }
+}
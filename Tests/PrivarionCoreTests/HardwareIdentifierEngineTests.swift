@@ -208,6 +208,30 @@ final class HardwareIdentifierEngineTests: XCTestCase {
         print("Random serial generated: '\(serial)'")
     }
     
+    // MARK: - Identifier Table Tests
+    
+    func testIdentifierTableReportsOneConsistentMachine() throws {
+        let table = engine.makeIdentifierTable(strategy: .realistic)
+        
+        guard case .string(let uuid)? = table.value(for: "kern.uuid", source: .sysctl) else {
+            return XCTFail("Table should spoof kern.uuid")
+        }
+        XCTAssertEqual(table.value(for: "IOPlatformUUID", source: .ioRegistry), .string(uuid), "Both APIs should report the same platform UUID")
+        XCTAssertNotNil(UUID(uuidString: uuid))
+        
+        guard case .string(let model)? = table.value(for: "hw.model", source: .sysctl) else {
+            return XCTFail("Table should spoof hw.model")
+        }
+        XCTAssertEqual(table.value(for: "model", source: .ioRegistry), .data(Array(model.utf8) + [0]))
+        
+        guard case .data(let mac)? = table.value(for: "IOMACAddress", source: .ioRegistry) else {
+            return XCTFail("Table should spoof the MAC address")
+        }
+        XCTAssertEqual(mac.count, 6)
+        XCTAssertNotNil(table.value(for: "IOPlatformSerialNumber", source: .ioRegistry))
+        XCTAssertNil(table.value(for: "IOPlatformSerialNumber", source: .sysctl), "Keys are looked up per source")
+    }
+    
     // MARK: - Validation Tests
     
     func testMACAddressValidation() {
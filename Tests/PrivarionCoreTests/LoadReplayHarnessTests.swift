@@ -0,0 +1,132 @@
+import XCTest
+import NIOCore
+@testable import PrivarionCore
+
+final class LoadReplayHarnessTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    /// Counts operations and optionally holds a shared lock while working
+    private final class SyntheticWorkload: LoadWorkload, @unchecked Sendable {
+        let name: String
+        let operationCount: Int
+        private let lock = NSLock()
+        private let serviceTime: useconds_t
+        private let asyncDelayNanoseconds: UInt64
+        private var performed = 0
+
+        init(name: String = "synthetic", operationCount: Int = 64, serviceTime: useconds_t = 0, asyncDelayNanoseconds: UInt64 = 0) {
+            self.name = name
+            self.operationCount = operationCount
+            self.serviceTime = serviceTime
+            self.asyncDelayNanoseconds = asyncDelayNanoseconds
+        }
+
+        var performedCount: Int {
+            lock.lock()
+            defer { lock.unlock() }
+            return performed
+        }
+
+        func perform(_ index: Int) async {
+            if asyncDelayNanoseconds > 0 {
+                do {
+                    try await Task.sleep(nanoseconds: asyncDelayNanoseconds)
+                } catch {
+                    return
+                }
+            }
+            lock.lock()
+            if serviceTime > 0 {
+                usleep(serviceTime)
+            }
+            performed += 1
+            lock.unlock()
+        }
+    }
+
+    // MARK: - Scheduling
+
+    func testEveryScheduledOperationCompletes() async {
+        let workload = SyntheticWorkload()
+        let harness = LoadReplayHarness()
+        let report = await harness.run(workload, profile: LoadProfile(requestsPerSecond: 5000, operations: 500, warmupOperations: 10))
+
+        XCTAssertEqual(report.completedOperations, 500)
+        XCTAssertEqual(report.shedOperations, 0)
+        XCTAssertEqual(workload.performedCount, 510)
+        XCTAssertLessThanOrEqual(report.p50LatencyMs, report.p99LatencyMs)
+        XCTAssertLessThanOrEqual(report.p99LatencyMs, report.p999LatencyMs)
+        XCTAssertLessThanOrEqual(report.p999LatencyMs, report.maxLatencyMs * 1.01)
+        XCTAssertGreaterThan(report.achievedRate, 0)
+    }
+
+    func testQueueingBehindSlowOperationsCountsTowardsLatency() async {
+        // 1ms per operation offered at 2000/s: the backlog grows for the whole run
+        let workload = SyntheticWorkload(serviceTime: 1000)
+        let harness = LoadReplayHarness()
+        let report = await harness.run(workload, profile: LoadProfile(requestsPerSecond: 2000, operations: 200, warmupOperations: 0))
+
+        XCTAssertEqual(report.completedOperations, 200)
+        XCTAssertGreaterThan(report.p99LatencyMs, 20,
+                             "Latency is measured from the scheduled arrival, so waiting behind earlier operations counts")
+    }
+
+    func testArrivalsBeyondInFlightLimitAreShed() async {
+        let workload = SyntheticWorkload(asyncDelayNanoseconds: 100_000_000)
+        let harness = LoadReplayHarness()
+        let report = await harness.run(workload, profile: LoadProfile(requestsPerSecond: 1000, operations: 20, warmupOperations: 0, maxInFlight: 1))
+
+        XCTAssertGreaterThan(report.shedOperations, 0)
+        XCTAssertEqual(report.completedOperations + report.shedOperations, 20)
+        XCTAssertEqual(report.benchmarkResult.status, .failed)
+    }
+
+    // MARK: - Reporting
+
+    func testBenchmarkResultGatesOnTailPercentiles() async {
+        let harness = LoadReplayHarness()
+        let report = await harness.run(SyntheticWorkload(name: "tail"), profile: LoadProfile(requestsPerSecond: 2000, operations: 100, warmupOperations: 0))
+        let result = report.benchmarkResult
+
+        XCTAssertEqual(result.testName, "load_tail")
+        XCTAssertEqual(result.duration, report.p99LatencyMs)
+        XCTAssertEqual(result.metrics.tailLatencyMs, report.p999LatencyMs)
+        XCTAssertNil(result.metrics.renderTimeMs)
+        XCTAssertEqual(result.iterations, 100)
+        XCTAssertEqual(result.status, .passed)
+    }
+
+    // MARK: - DNS Replay
+
+    func testCaptureRoundTripsQueries() throws {
+        let queries = ["example.com", "ads.tracker.example", "a.b.c.d.example"].enumerated().map {
+            DNSQueryCapture.query(for: $0.element, id: UInt16($0.offset))
+        }
+        let capture = DNSQueryCapture.serialize(queries)
+        XCTAssertEqual(try DNSQueryCapture.parse(capture), queries)
+        XCTAssertThrowsError(try DNSQueryCapture.parse(capture.dropLast()))
+    }
+
+    func testCapturedQueriesReplayThroughLocalDecisionPath() throws {
+        let server = SwiftNIODNSProxyServer(port: Int.random(in: 20000...30000), upstreamServers: ["1.1.1.1"], queryTimeout: 1.0)
+        let query = ByteBuffer(bytes: DNSQueryCapture.query(for: "www.example.com", id: 7))
+
+        guard case .forward(let parsed) = server.resolveLocally(query, applicationId: nil) else {
+            return XCTFail("An unblocked, uncached query should be forwarded")
+        }
+        XCTAssertEqual(parsed.domain, "www.example.com")
+        guard case .malformed = server.resolveLocally(ByteBuffer(bytes: [0x00, 0x01]), applicationId: nil) else {
+            return XCTFail("A truncated query should be rejected")
+        }
+    }
+
+    func testDomainSetReplaysThroughBlocklist() async {
+        let manager = BlocklistManager()
+        let workload = DomainSetReplayWorkload(domains: ["www.example.com", "cdn.example.net"], blocklistManager: manager)
+        let report = await LoadReplayHarness().run(workload, profile: LoadProfile(requestsPerSecond: 5000, operations: 200, warmupOperations: 20))
+
+        XCTAssertEqual(report.workload, "blocklist")
+        XCTAssertEqual(report.completedOperations, 200)
+    }
+}
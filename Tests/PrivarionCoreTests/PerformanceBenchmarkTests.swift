@@ -210,7 +210,28 @@ final class PerformanceBenchmarkTests: XCTestCase {
         print("🔍 Regression detection result: \(hasRegression)")
         print("📊 Baseline duration: \(baseline.duration)ms, Current: \(current.duration)ms")
     }
-    
+
+    func testTailLatencyRegression() throws {
+        func latencyResult(p99: Double, p999: Double) -> BenchmarkResult {
+            return BenchmarkResult(
+                testName: "tail_regression",
+                duration: p99,
+                metrics: PerformanceMetrics(cpuUsage: 0, memoryUsageMB: 0, operationName: "tail", interactive: false, tailLatencyMs: p999),
+                status: .passed,
+                iterations: 1000
+            )
+        }
+        let baseline = latencyResult(p99: 1.0, p999: 2.0)
+        let slowerTail = latencyResult(p99: 1.0, p999: 3.0)
+
+        // Without a tail threshold only the p99 duration is compared
+        XCTAssertFalse(RegressionDetector().detectRegression(baseline: baseline, current: slowerTail))
+
+        let tailDetector = RegressionDetector(thresholds: .init(maxTailLatencyIncreasePercent: 20.0))
+        XCTAssertTrue(tailDetector.detectRegression(baseline: baseline, current: slowerTail))
+        XCTAssertFalse(tailDetector.detectRegression(baseline: baseline, current: latencyResult(p99: 1.1, p999: 2.2)))
+    }
+
     // MARK: - Performance Baseline Verification
     
     func testPerformanceBaselines() throws {
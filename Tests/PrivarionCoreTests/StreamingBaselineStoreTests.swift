@@ -0,0 +1,147 @@
+import XCTest
+@testable import PrivarionCore
+
+final class StreamingBaselineStoreTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    private func makePoint(_ value: Double, source: String = "proc.1", metric: String = "syscalls") -> AnomalyDetectionEngine.DataPoint {
+        return AnomalyDetectionEngine.DataPoint(
+            source: source,
+            category: .process,
+            metric: metric,
+            value: value
+        )
+    }
+
+    /// Deterministic pseudo-random values in 0..<1
+    private func makeValues(count: Int, seed: UInt64 = 0x2545_F491_4F6C_DD1D) -> [Double] {
+        var state = seed
+        return (0..<count).map { _ in
+            state = state &* 6364136223846793005 &+ 1442695040888963407
+            return Double(state >> 11) / Double(1 << 53)
+        }
+    }
+
+    // MARK: - Estimators
+
+    func testRunningMomentsMatchTwoPassComputation() throws {
+        let values = makeValues(count: 1000).map { 1_000_000 + $0 * 250 }
+        let store = StreamingBaselineStore()
+        for start in stride(from: 0, to: values.count, by: 37) {
+            let batch = values[start..<min(start + 37, values.count)]
+            _ = store.scoreAndUpdate(batch.map { makePoint($0) })
+        }
+
+        let mean = values.reduce(0, +) / Double(values.count)
+        let variance = values.reduce(0) { $0 + ($1 - mean) * ($1 - mean) } / Double(values.count - 1)
+
+        let snapshot = try XCTUnwrap(store.snapshot(source: "proc.1", metric: "syscalls"))
+        XCTAssertEqual(snapshot.sampleCount, values.count)
+        XCTAssertEqual(snapshot.mean, mean, accuracy: 1e-6)
+        XCTAssertEqual(snapshot.standardDeviation, variance.squareRoot(), accuracy: 1e-6)
+        XCTAssertEqual(snapshot.minimum, values.min())
+        XCTAssertEqual(snapshot.maximum, values.max())
+    }
+
+    func testQuantilesStayWithinRelativeAccuracy() throws {
+        let values = makeValues(count: 20_000).map { exp($0 * 8) - 0.5 }
+        var sketch = QuantileSketch(relativeAccuracy: 0.01)
+        values.forEach { sketch.add($0) }
+        let sorted = values.sorted()
+
+        for q in [0.01, 0.25, 0.5, 0.9, 0.99] {
+            let exact = sorted[Int(q * Double(sorted.count - 1))]
+            let estimate = try XCTUnwrap(sketch.quantile(q))
+            XCTAssertEqual(estimate, exact, accuracy: abs(exact) * 0.011, "q=\(q)")
+        }
+        XCTAssertNil(QuantileSketch().quantile(0.5))
+    }
+
+    func testCollapsedSketchKeepsUpperQuantiles() throws {
+        var sketch = QuantileSketch(relativeAccuracy: 0.01, maxBuckets: 64)
+        let values = (1...5000).map { Double($0) }
+        values.forEach { sketch.add($0) }
+
+        let upper = try XCTUnwrap(sketch.quantile(0.99))
+        XCTAssertEqual(upper, 4950, accuracy: 4950 * 0.011)
+    }
+
+    // MARK: - Scoring
+
+    func testBatchIsScoredAgainstPriorBaseline() {
+        let store = StreamingBaselineStore()
+        _ = store.scoreAndUpdate((0..<10).map { makePoint(Double($0 % 2) * 10) })
+
+        let forward = store.scoreAndUpdate([makePoint(5), makePoint(500)])
+        XCTAssertEqual(forward[0].sampleCount, 10)
+        XCTAssertEqual(forward[1].sampleCount, 10, "Points in one batch should not see each other")
+        XCTAssertEqual(forward[0].zScore, 0, accuracy: 1e-9)
+        XCTAssertGreaterThan(forward[1].zScore, 80)
+    }
+
+    func testLanesScoreEachSeriesIndependently() {
+        let store = StreamingBaselineStore()
+        let sources = ["a", "b", "c", "d", "e"]
+        for round in 0..<50 {
+            _ = store.scoreAndUpdate(sources.enumerated().map { index, source in
+                makePoint(Double(index * 100) + Double(round % 5), source: source)
+            })
+        }
+
+        let scores = store.scoreAndUpdate(sources.enumerated().map { index, source in
+            makePoint(Double(index * 100) + 2, source: source)
+        } + [makePoint(-1, source: "new")])
+
+        XCTAssertEqual(scores.count, 6)
+        for score in scores.prefix(5) {
+            XCTAssertEqual(score.sampleCount, 50)
+            XCTAssertLessThan(score.zScore, 0.1)
+        }
+        XCTAssertEqual(scores[5].sampleCount, 0)
+        XCTAssertEqual(scores[5].zScore, 0, "A series without history cannot deviate")
+    }
+
+    func testConstantSeriesScoresFinitely() {
+        let store = StreamingBaselineStore()
+        _ = store.scoreAndUpdate(Array(repeating: makePoint(50), count: 40))
+
+        let scores = store.scoreAndUpdate([makePoint(50), makePoint(51)])
+        XCTAssertEqual(scores[0].zScore, 0)
+        XCTAssertTrue(scores[1].zScore.isFinite)
+        XCTAssertGreaterThan(scores[1].zScore, 3)
+    }
+
+    func testLeastRecentlyUsedSeriesIsReplacedAtCapacity() {
+        let store = StreamingBaselineStore(maxSeries: 2)
+        _ = store.scoreAndUpdate([makePoint(1, source: "old", metric: "m")])
+        _ = store.scoreAndUpdate([makePoint(1, source: "recent", metric: "m")])
+        _ = store.scoreAndUpdate([makePoint(1, source: "newest", metric: "m")])
+
+        XCTAssertEqual(store.seriesCount, 2)
+        XCTAssertNil(store.snapshot(source: "old", metric: "m"))
+        XCTAssertNotNil(store.snapshot(source: "recent", metric: "m"))
+        XCTAssertEqual(store.snapshot(source: "newest", metric: "m")?.sampleCount, 1)
+    }
+
+    func testSeenSeriesMovesAheadOfEviction() {
+        let store = StreamingBaselineStore(maxSeries: 2)
+        _ = store.scoreAndUpdate([makePoint(1, source: "first", metric: "m")])
+        _ = store.scoreAndUpdate([makePoint(1, source: "second", metric: "m")])
+        _ = store.scoreAndUpdate([makePoint(1, source: "first", metric: "m")])
+        _ = store.scoreAndUpdate([makePoint(1, source: "third", metric: "m")])
+
+        XCTAssertEqual(store.snapshot(source: "first", metric: "m")?.sampleCount, 2)
+        XCTAssertNil(store.snapshot(source: "second", metric: "m"))
+    }
+
+    func testBatchWiderThanCapacityKeepsSeriesApart() {
+        let store = StreamingBaselineStore(maxSeries: 2)
+        let scores = store.scoreAndUpdate(["a", "b", "c", "a"].map { makePoint(7, source: $0, metric: "m") })
+
+        XCTAssertEqual(scores.count, 4)
+        XCTAssertEqual(store.seriesCount, 2)
+        XCTAssertEqual(store.snapshot(source: "c", metric: "m")?.sampleCount, 1,
+                       "A replaced slot should not receive points of the series it replaced")
+    }
+}
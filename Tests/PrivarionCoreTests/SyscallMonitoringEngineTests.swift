@@ -354,6 +354,48 @@ final class SyscallMonitoringEngineTests: XCTestCase {
         XCTAssertEqual(event.triggeredRules.count, 0)
     }
     
+    func testPathRuleMatchesDrainedHookEvent() throws {
+        let rule = SyscallMonitoringEngine.MonitoringRule(
+            id: "spawn-from-tmp",
+            name: "Spawn from /tmp",
+            description: "Detects binaries started from /tmp",
+            condition: SyscallMonitoringEngine.RuleCondition(
+                syscalls: ["posix_spawn"],
+                pathFilters: SyscallMonitoringEngine.RuleCondition.PathFilters(
+                    blockedPaths: ["/tmp/trusted"],
+                    pathPatterns: ["/tmp/*"]
+                )
+            ),
+            output: "Spawned %fd.name",
+            priority: .warning,
+            enabled: true,
+            exceptions: []
+        )
+        try monitoringEngine.addRule(rule)
+        
+        func drained(_ path: String) -> SyscallMonitoringEngine.SyscallEvent {
+            let record = HookEventStream.Event(returnValue: 0, hookID: 1, argument: path, argumentIsPath: true)
+            return monitoringEngine.syscallEvent("posix_spawn", from: record, processID: 42,
+                                                 processName: "probe", userID: 501, groupID: 20)
+        }
+        
+        let event = drained("/tmp/payload")
+        XCTAssertEqual(event.arguments, ["/tmp/payload"])
+        XCTAssertEqual(event.filePath, "/tmp/payload")
+        XCTAssertEqual(monitoringEngine.evaluateRules(for: event).map { $0.id }, ["spawn-from-tmp"])
+        XCTAssertTrue(monitoringEngine.evaluateRules(for: drained("/tmp/trusted/tool")).isEmpty,
+                      "A blocked path prefix should apply to the drained path")
+        
+        // A first argument that is not a path is kept, but path rules ignore it
+        let sysctl = monitoringEngine.syscallEvent(
+            "sysctlbyname",
+            from: HookEventStream.Event(returnValue: 0, hookID: 2, argument: "kern.hostname", argumentIsPath: false),
+            processID: 42, processName: "probe", userID: 501, groupID: 20
+        )
+        XCTAssertEqual(sysctl.arguments, ["kern.hostname"])
+        XCTAssertNil(sysctl.filePath)
+    }
+    
     // MARK: - MonitoringRule Priority Tests
     
     func testMonitoringRulePriority_AllCases_ShouldExist() {
@@ -569,4 +569,61 @@ final class TelemetryPatternMatcherTests: XCTestCase {
         // Should still check for string patterns
         XCTAssertFalse(matcher.inspectPayloadForTelemetry(invalidJSON))
     }
+    
+    // MARK: - Single-Pass Scanning Tests
+    
+    func testInspectPayloadForTelemetry_KeySubstringOnlyCountsInKeys() {
+        // "ga" marks telemetry in a key, not in a value
+        let language = #"{"language": "en"}"#.data(using: .utf8)!
+        let galician = #"{"lang": "galego", "note": "a \"ga\": b"}"#.data(using: .utf8)!
+        XCTAssertTrue(matcher.inspectPayloadForTelemetry(language))
+        XCTAssertFalse(matcher.inspectPayloadForTelemetry(galician))
+    }
+    
+    func testInspectPayloadForTelemetry_RecompilesAfterPatternChange() {
+        let payload = "checksum=fingerprint-v2".data(using: .utf8)!
+        XCTAssertFalse(matcher.inspectPayloadForTelemetry(payload))
+        
+        database.addPattern(TelemetryPattern(type: .tracking, domainPattern: "*", payloadPattern: "finger(print)?-v\\d"))
+        XCTAssertTrue(matcher.inspectPayloadForTelemetry(payload))
+        XCTAssertEqual(matcher.getAllMatchingPatterns(domain: "cdn.example.com", payload: payload).count, 1)
+    }
+    
+    func testMultiPatternScannerReportsOverlappingMatches() {
+        let scanner = MultiPatternScanner(literals: ["he", "she", "his", "hers"])
+        var matches: [String] = []
+        Array("uSHErs".utf8).withUnsafeBytes { bytes in
+            scanner.scan(bytes) { pattern, range in
+                matches.append("\(pattern)@\(range.lowerBound)..<\(range.upperBound)")
+                return true
+            }
+        }
+        XCTAssertEqual(matches, ["1@1..<4", "0@2..<4", "3@2..<6"])
+    }
+    
+    func testMultiPatternScannerFindsMatchesAcrossPrefilterChunks() {
+        var bytes = [UInt8](repeating: UInt8(ascii: "-"), count: 1000)
+        bytes.replaceSubrange(14..<19, with: Array("BEAC0".utf8))
+        bytes.replaceSubrange(994..<1000, with: Array("beacon".utf8))
+        let scanner = MultiPatternScanner(literals: ["beac0", "beacon"])
+        
+        var ends: [Int] = []
+        bytes.withUnsafeBytes { buffer in
+            scanner.scan(buffer) { _, range in
+                ends.append(range.upperBound)
+                return true
+            }
+        }
+        XCTAssertEqual(ends, [19, 1000])
+    }
+    
+    func testInspectLargePayloadPerformance() {
+        // 4 MB upload body with a single hit at the very end
+        var body = Data(repeating: UInt8(ascii: "x"), count: 4 * 1024 * 1024)
+        body.append(contentsOf: Array(#"{"beacon": 1}"#.utf8))
+        
+        measure {
+            XCTAssertTrue(matcher.inspectPayloadForTelemetry(body))
+        }
+    }
 }
@@ -0,0 +1,197 @@
+import XCTest
+@testable import PrivarionCore
+
+final class TimeSeriesChunkTests: XCTestCase {
+
+    /// An hour boundary, so every rollup bucket lines up with it
+    private let base = Date(timeIntervalSince1970: 1_760_000_400)
+
+    // MARK: - Helpers
+
+    private func makeEvent(
+        at offset: TimeInterval,
+        type: AnalyticsEvent.EventType = .connection,
+        dataSize: UInt64 = 1024,
+        duration: TimeInterval? = 0.25,
+        application: String? = "com.example.browser",
+        hostname: String? = "example.com"
+    ) -> AnalyticsEvent {
+        return AnalyticsEvent(
+            id: UUID(),
+            timestamp: base.addingTimeInterval(offset),
+            sessionId: UUID(),
+            type: type,
+            source: NetworkEndpoint(address: "192.168.1.20", port: 51000, hostname: nil),
+            destination: NetworkEndpoint(address: "93.184.216.34", port: 443, hostname: hostname),
+            protocol: .tcp,
+            dataSize: dataSize,
+            duration: duration,
+            application: application,
+            metadata: ["request_id": "req_\(Int(offset))"]
+        )
+    }
+
+    private func makeBuilder(intervals: [TimeInterval] = [60, 300, 3600, 86400]) -> TimeSeriesChunkBuilder {
+        return TimeSeriesChunkBuilder(
+            partition: Int64(base.timeIntervalSince1970),
+            rollupIntervals: TimeSeriesChunkFormat.rollupIntervals(for: intervals)
+        )
+    }
+
+    private func decodeAll(_ chunk: TimeSeriesChunk) throws -> [AnalyticsEvent] {
+        var events: [AnalyticsEvent] = []
+        try chunk.forEachEvent(where: { _ in true }) { events.append($0) }
+        return events
+    }
+
+    // MARK: - Round Trip
+
+    func testSealedChunkDecodesEveryField() throws {
+        let builder = makeBuilder()
+        let event = makeEvent(at: 12.345)
+        builder.append(event)
+        builder.append(makeEvent(at: 13, type: .dnsQuery, duration: nil, application: nil, hostname: nil))
+
+        let chunk = try TimeSeriesChunk(data: builder.encoded())
+        XCTAssertEqual(chunk.eventCount, 2)
+
+        let decoded = try decodeAll(chunk)
+        XCTAssertEqual(decoded.count, 2)
+        let first = try XCTUnwrap(decoded.first)
+        XCTAssertEqual(first.id, event.id)
+        XCTAssertEqual(first.sessionId, event.sessionId)
+        XCTAssertEqual(first.timestamp.timeIntervalSince1970, event.timestamp.timeIntervalSince1970, accuracy: 0.001)
+        XCTAssertEqual(first.type, .connection)
+        XCTAssertEqual(first.protocol, .tcp)
+        XCTAssertEqual(first.source.address, "192.168.1.20")
+        XCTAssertEqual(first.source.port, 51000)
+        XCTAssertNil(first.source.hostname)
+        XCTAssertEqual(first.destination.address, "93.184.216.34")
+        XCTAssertEqual(first.destination.hostname, "example.com")
+        XCTAssertEqual(first.dataSize, 1024)
+        XCTAssertEqual(first.duration, 0.25)
+        XCTAssertEqual(first.application, "com.example.browser")
+        XCTAssertEqual(first.metadata, ["request_id": "req_12"])
+
+        let second = try XCTUnwrap(decoded.last)
+        XCTAssertEqual(second.type, .dnsQuery)
+        XCTAssertNil(second.duration)
+        XCTAssertNil(second.application)
+        XCTAssertNil(second.destination.hostname)
+    }
+
+    func testFilteredRowsSkipPayloadDecoding() throws {
+        let builder = makeBuilder()
+        for index in 0..<50 {
+            builder.append(makeEvent(at: TimeInterval(index), type: index % 5 == 0 ? .dnsQuery : .dataTransfer))
+        }
+        let chunk = try TimeSeriesChunk(data: builder.encoded())
+
+        var events: [AnalyticsEvent] = []
+        try chunk.forEachEvent(where: { $0.type == .dnsQuery }) { events.append($0) }
+        XCTAssertEqual(events.count, 10)
+        XCTAssertEqual(events.map { $0.metadata["request_id"] }, (0..<10).map { "req_\($0 * 5)" })
+    }
+
+    // MARK: - Column Encoding
+
+    func testRegularTimestampsCostOneBitEach() throws {
+        var encoder = TimestampColumnEncoder()
+        var expected: [Int64] = []
+        for index in 0..<1000 {
+            let timestamp = 1_760_000_400_000 + Int64(index) * 1000
+            encoder.append(timestamp)
+            expected.append(timestamp)
+        }
+        // 64 bits for the first, 16 for the first delta, then one per event
+        XCTAssertLessThanOrEqual(encoder.writer.bytes.count, 8 + 2 + 125)
+
+        let decoded = try encoder.writer.bytes.withUnsafeBytes { bytes -> [Int64] in
+            var decoder = TimestampColumnDecoder(bytes)
+            return try (0..<1000).map { _ in try decoder.next() }
+        }
+        XCTAssertEqual(decoded, expected)
+    }
+
+    func testIrregularTimestampsAndValuesRoundTrip() throws {
+        let timestamps: [Int64] = [0, 5, 5, 4_000, 3_999, 90_000_000, -12, Int64.max / 4]
+        let values: [Double] = [0, 1, 1, 1500, 1_048_576, .nan, 0.125, 9_007_199_254_740_992, 0]
+
+        var timestampEncoder = TimestampColumnEncoder()
+        timestamps.forEach { timestampEncoder.append($0) }
+        var valueEncoder = ValueColumnEncoder()
+        values.forEach { valueEncoder.append($0) }
+
+        let decodedTimestamps = try timestampEncoder.writer.bytes.withUnsafeBytes { bytes -> [Int64] in
+            var decoder = TimestampColumnDecoder(bytes)
+            return try timestamps.map { _ in try decoder.next() }
+        }
+        XCTAssertEqual(decodedTimestamps, timestamps)
+
+        let decodedValues = try valueEncoder.writer.bytes.withUnsafeBytes { bytes -> [UInt64] in
+            var decoder = ValueColumnDecoder(bytes, column: "values")
+            return try values.map { _ in try decoder.next().bitPattern }
+        }
+        XCTAssertEqual(decodedValues, values.map { $0.bitPattern })
+    }
+
+    func testTruncatedChunkIsRejected() throws {
+        let builder = makeBuilder()
+        builder.append(makeEvent(at: 0))
+        let data = builder.encoded()
+
+        XCTAssertThrowsError(try TimeSeriesChunk(data: data.prefix(TimeSeriesChunkFormat.headerSize - 1)))
+        XCTAssertThrowsError(try TimeSeriesChunk(data: data.prefix(data.count - 4)),
+                             "Sections past the end of the data should be rejected")
+    }
+
+    // MARK: - Rollups
+
+    func testRollupIntervalsFollowConfiguration() {
+        XCTAssertEqual(TimeSeriesChunkFormat.rollupIntervals(for: [60, 300, 3600, 86400]), [60, 300, 3600])
+        XCTAssertEqual(TimeSeriesChunkFormat.rollupIntervals(for: [420, 0.5]), [3600],
+                       "Intervals that do not divide an hour fall back to the hourly rollup")
+    }
+
+    func testRollupsMatchRowAggregation() throws {
+        let builder = makeBuilder()
+        let applications = ["com.example.browser", "com.example.mail", nil]
+        for index in 0..<600 {
+            builder.append(makeEvent(
+                at: TimeInterval(index) * 5.5,
+                type: index % 3 == 0 ? .dnsQuery : .connection,
+                dataSize: UInt64(index * 37),
+                application: applications[index % applications.count]
+            ))
+        }
+        let chunk = try TimeSeriesChunk(data: builder.encoded())
+
+        for interval: Int64 in [60, 300, 3600] {
+            var expected: [Int64: (events: Int, bytes: UInt64, dns: Int, apps: Set<String>)] = [:]
+            try chunk.forEachRow { row in
+                let start = TimeSeriesChunkFormat.floorDivide(row.timestamp, interval * 1000) * interval
+                var bucket = expected[start] ?? (0, 0, 0, [])
+                bucket.events += 1
+                bucket.bytes += row.dataSize
+                bucket.dns += row.type == .dnsQuery ? 1 : 0
+                if let application = chunk.string(for: row.application) {
+                    bucket.apps.insert(application)
+                }
+                expected[start] = bucket
+            }
+
+            let sealed = try XCTUnwrap(try chunk.rollupBuckets(interval: interval))
+            let open = try XCTUnwrap(builder.rollupBuckets(interval: interval))
+            XCTAssertEqual(sealed.count, expected.count)
+            XCTAssertEqual(open.map { $0.start }, sealed.map { $0.start })
+            for bucket in sealed {
+                let totals = try XCTUnwrap(expected[bucket.start])
+                XCTAssertEqual(bucket.eventCount, totals.events)
+                XCTAssertEqual(bucket.totalDataSize, totals.bytes)
+                XCTAssertEqual(bucket.dnsQueryCount, totals.dns)
+                XCTAssertEqual(Set(bucket.applications), totals.apps)
+            }
+        }
+        XCTAssertNil(try chunk.rollupBuckets(interval: 86400), "Daily buckets are merged from hourly ones")
+    }
+}
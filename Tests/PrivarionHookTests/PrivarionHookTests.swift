@@ -1,4 +1,5 @@
 import XCTest
+import IOKit
 @testable import PrivarionHook
 @testable import PrivarionCore
 
@@ -158,6 +159,449 @@ final class PrivarionHookTests: XCTestCase {
         }
     }
     
+    func testInstalledHookRedirectsCalls() throws {
+        try hookManager.initialize()
+        
+        let realUserId = getuid()
+        let fakeUserId: UInt32 = realUserId == 4242 ? 4243 : 4242
+        
+        var config = SyscallHookConfiguration()
+        config.hooks.getuid = true
+        config.fakeData.userId = fakeUserId
+        try hookManager.updateConfiguration(config)
+        
+        let installedHooks = try hookManager.installConfiguredHooks()
+        let handle = try XCTUnwrap(installedHooks["getuid"])
+        
+        // Calls through this image's symbol pointers now reach the replacement
+        XCTAssertEqual(getuid(), uid_t(fakeUserId), "getuid should return the configured fake ID")
+        
+        // The original stays reachable through the handle
+        typealias GetuidFunction = @convention(c) () -> uid_t
+        let original = try XCTUnwrap(hookManager.getOriginalFunction(handle, as: GetuidFunction.self))
+        XCTAssertEqual(original(), realUserId, "Original getuid should return the real ID")
+        
+        // Removal writes the original pointers back
+        try hookManager.removeHook(handle)
+        XCTAssertEqual(getuid(), realUserId, "getuid should be restored after removal")
+    }
+    
+    func testLazyActivationResolvesOriginalsOnFirstCall() throws {
+        try hookManager.initialize()
+        hookManager.setLazyActivation(enabled: true)
+        defer { hookManager.setLazyActivation(enabled: false) }
+        
+        let realGroupId = getgid()
+        var config = SyscallHookConfiguration()
+        config.hooks.getuid = true
+        config.hooks.getgid = true
+        config.fakeData.userId = 4242
+        try hookManager.updateConfiguration(config)
+        
+        let before = hookManager.activationStatistics
+        let installedHooks = try hookManager.installConfiguredHooks()
+        defer { XCTAssertNoThrow(try hookManager.removeHooks(Array(installedHooks.values))) }
+        let installed = hookManager.activationStatistics
+        XCTAssertEqual(installed.hooksInstalled - before.hooksInstalled, 2)
+        XCTAssertEqual(installed.originalsResolved, before.originalsResolved, "A lazy install should resolve nothing")
+        
+        XCTAssertEqual(getuid(), 4242, "A lazily installed hook should be patched in already")
+        XCTAssertGreaterThanOrEqual(hookManager.activationStatistics.originalsResolved - before.originalsResolved, 1,
+                                    "The first call should resolve its original")
+        
+        // Asking for an original resolves it as well
+        typealias GetgidFunction = @convention(c) () -> gid_t
+        let handle = try XCTUnwrap(installedHooks["getgid"])
+        let original = try XCTUnwrap(hookManager.getOriginalFunction(handle, as: GetgidFunction.self))
+        XCTAssertEqual(original(), realGroupId)
+        XCTAssertEqual(hookManager.activationStatistics.originalsResolved - before.originalsResolved, 2)
+    }
+
+    func testIdentityHooksFollowConfigurationUpdates() throws {
+        try hookManager.initialize()
+        
+        var config = SyscallHookConfiguration()
+        config.hooks.getuid = true
+        config.hooks.getgid = true
+        config.fakeData.userId = 4242
+        config.fakeData.groupId = 4242
+        try hookManager.updateConfiguration(config)
+        
+        let installedHooks = try hookManager.installConfiguredHooks()
+        defer { XCTAssertNoThrow(try hookManager.removeHooks(Array(installedHooks.values))) }
+        
+        // The first calls fill this thread's cache
+        XCTAssertEqual(getuid(), 4242)
+        XCTAssertEqual(getgid(), 4242)
+        
+        // A new publish must invalidate the cached copy on the same thread
+        config.fakeData.userId = 4343
+        config.fakeData.groupId = 4343
+        try hookManager.updateConfiguration(config)
+        XCTAssertEqual(getuid(), 4343, "Cached user ID should refresh after a configuration update")
+        XCTAssertEqual(getgid(), 4343, "Cached group ID should refresh after a configuration update")
+    }
+    
+    func testProfileTableSelectsBundleProfile() throws {
+        try hookManager.initialize()
+        
+        var config = SyscallHookConfiguration()
+        config.fakeData.userId = 4545
+        var appHooks = HookRules()
+        appHooks.getuid = true
+        config.hooks.applicationRules["com.example.profiled"] = ApplicationHookRules(
+            bundleId: "com.example.profiled",
+            hooks: appHooks,
+            inheritGlobalRules: false
+        )
+        
+        let table = HookProfileTable(configuration: config)
+        XCTAssertEqual(table.count, 2, "Table should hold the default and the application profile")
+        
+        let url = FileManager.default.temporaryDirectory.appendingPathComponent("privarion-profile-test-\(UUID().uuidString).bin")
+        try table.write(to: url)
+        defer { XCTAssertNoThrow(try FileManager.default.removeItem(at: url)) }
+        
+        // The default profile enables no hooks
+        try hookManager.loadProfileTable(at: url, bundleId: "com.example.unknown")
+        XCTAssertFalse(hookManager.isHooked(.getuid), "Unknown bundles should fall back to the default profile")
+        
+        try hookManager.loadProfileTable(at: url, bundleId: "com.example.profiled")
+        XCTAssertTrue(hookManager.isHooked(.getuid), "The bundle's profile should install its hooks")
+        XCTAssertEqual(getuid(), 4545, "Hooks installed from a profile should use its fake data")
+    }
+    
+    func testConfigurationPublishAdvancesVersion() throws {
+        try hookManager.initialize()
+        
+        let initialVersion = hookManager.configurationVersion
+        
+        var config = SyscallHookConfiguration()
+        config.hooks.getuid = true
+        config.fakeData.userId = 1001
+        try hookManager.updateConfiguration(config)
+        
+        let installedHooks = try hookManager.installConfiguredHooks()
+        XCTAssertGreaterThan(hookManager.configurationVersion, initialVersion, "Installing a configured hook should publish a new snapshot")
+        
+        for (_, handle) in installedHooks {
+            try hookManager.removeHook(handle)
+        }
+    }
+    
+    func testHostnameAndUnameHooksAnswerFromTemplates() throws {
+        try hookManager.initialize()
+        
+        var config = SyscallHookConfiguration()
+        config.hooks.uname = true
+        config.hooks.gethostname = true
+        config.fakeData.hostname = "template-host"
+        config.fakeData.systemInfo.machine = "arm64"
+        try hookManager.updateConfiguration(config)
+        
+        let installedHooks = try hookManager.installConfiguredHooks()
+        
+        var info = utsname()
+        XCTAssertEqual(uname(&info), 0, "Hooked uname should succeed")
+        let machine = withUnsafePointer(to: &info.machine) { ptr in
+            String(cString: UnsafeRawPointer(ptr).assumingMemoryBound(to: CChar.self))
+        }
+        let nodename = withUnsafePointer(to: &info.nodename) { ptr in
+            String(cString: UnsafeRawPointer(ptr).assumingMemoryBound(to: CChar.self))
+        }
+        XCTAssertEqual(machine, "arm64", "uname should report the configured machine")
+        XCTAssertEqual(nodename, "template-host", "uname should report the configured hostname as nodename")
+        
+        var buffer = [CChar](repeating: 0, count: 256)
+        XCTAssertEqual(gethostname(&buffer, buffer.count), 0, "Hooked gethostname should succeed")
+        XCTAssertEqual(String(cString: buffer), "template-host", "gethostname should report the configured hostname")
+        
+        var smallBuffer = [CChar](repeating: 0, count: 4)
+        XCTAssertEqual(gethostname(&smallBuffer, smallBuffer.count), -1, "Too small a buffer should be rejected")
+        
+        try hookManager.removeHooks(Array(installedHooks.values))
+    }
+    
+    func testIdentifierHooksAnswerFromTable() throws {
+        try hookManager.initialize()
+        
+        var realCPUCount: Int32 = 0
+        var size = MemoryLayout<Int32>.size
+        XCTAssertEqual(sysctlbyname("hw.ncpu", &realCPUCount, &size, nil, 0), 0)
+        
+        let table = HardwareIdentifierTable(entries: [
+            .init(source: .sysctl, key: "hw.model", value: .string("Macmini9,1")),
+            .init(source: .ioRegistry, key: "IOPlatformSerialNumber", value: .string("C02TEST0TABLE"))
+        ])
+        let url = FileManager.default.temporaryDirectory.appendingPathComponent("privarion-identifiers-test-\(UUID().uuidString).bin")
+        try table.write(to: url)
+        defer { XCTAssertNoThrow(try FileManager.default.removeItem(at: url)) }
+        try hookManager.loadIdentifierTable(at: url)
+        
+        var config = SyscallHookConfiguration()
+        config.hooks.hardwareIdentifiers = true
+        try hookManager.updateConfiguration(config)
+        let installedHooks = try hookManager.installConfiguredHooks()
+        defer { XCTAssertNoThrow(try hookManager.removeHooks(Array(installedHooks.values))) }
+        XCTAssertTrue(hookManager.isHooked(.sysctlbyname))
+        
+        // A NULL buffer asks for the size, terminator included
+        size = 0
+        XCTAssertEqual(sysctlbyname("hw.model", nil, &size, nil, 0), 0)
+        XCTAssertEqual(size, 11)
+        var model = [CChar](repeating: 0, count: size)
+        XCTAssertEqual(sysctlbyname("hw.model", &model, &size, nil, 0), 0)
+        XCTAssertEqual(String(cString: model), "Macmini9,1")
+        
+        var shortBuffer = [CChar](repeating: 0, count: 4)
+        size = shortBuffer.count
+        XCTAssertEqual(sysctlbyname("hw.model", &shortBuffer, &size, nil, 0), -1, "A short buffer should be rejected")
+        XCTAssertEqual(errno, ENOMEM)
+        
+        // Names the table does not hold reach the kernel
+        var cpuCount: Int32 = 0
+        size = MemoryLayout<Int32>.size
+        XCTAssertEqual(sysctlbyname("hw.ncpu", &cpuCount, &size, nil, 0), 0)
+        XCTAssertEqual(cpuCount, realCPUCount)
+        
+        let platformExpert = IOServiceGetMatchingService(kIOMainPortDefault, IOServiceMatching("IOPlatformExpertDevice"))
+        defer { IOObjectRelease(platformExpert) }
+        let serial = IORegistryEntryCreateCFProperty(platformExpert, "IOPlatformSerialNumber" as CFString, kCFAllocatorDefault, 0)?
+            .takeRetainedValue() as? String
+        XCTAssertEqual(serial, "C02TEST0TABLE", "Registry lookups should answer from the table")
+    }
+    
+    func testTracingRecordsHookedCalls() throws {
+        try XCTSkipUnless(hookManager.isTracingAvailable, "Hook library built without tracing")
+        try hookManager.initialize()
+        
+        var config = SyscallHookConfiguration()
+        config.hooks.getuid = true
+        config.fakeData.userId = 4242
+        try hookManager.updateConfiguration(config)
+        
+        let installedHooks = try hookManager.installConfiguredHooks()
+        let handle = try XCTUnwrap(installedHooks["getuid"])
+        _ = hookManager.drainTraceRecords()
+        
+        hookManager.setTracing(enabled: true)
+        defer { hookManager.setTracing(enabled: false) }
+        _ = getuid()
+        
+        let records = hookManager.drainTraceRecords().filter { $0.hookID == handle.id }
+        XCTAssertEqual(records.count, 1, "One traced call should produce one record")
+        XCTAssertEqual(records.first?.returnValue, 4242, "Trace record should carry the spoofed return value")
+        
+        try hookManager.removeHook(handle)
+    }
+    
+    func testStatisticsExportCountsHookedCalls() throws {
+        try hookManager.initialize()
+        try hookManager.enableStatisticsExport()
+        
+        var config = SyscallHookConfiguration()
+        config.hooks.getuid = true
+        config.fakeData.userId = 4242
+        try hookManager.updateConfiguration(config)
+        
+        let installedHooks = try hookManager.installConfiguredHooks()
+        let handle = try XCTUnwrap(installedHooks["getuid"])
+        defer { XCTAssertNoThrow(try hookManager.removeHook(handle)) }
+        
+        for _ in 0..<100 {
+            _ = getuid()
+        }
+        
+        // Read back through the shared region, as an external monitor would
+        let reader = try HookStatisticsReader(processID: getpid())
+        let stats = try XCTUnwrap(reader.readAll().first { $0.hookID == handle.id })
+        XCTAssertEqual(stats.functionName, "getuid")
+        XCTAssertEqual(stats.calls, 100, "Every hooked call should be counted")
+        XCTAssertEqual(stats.spoofedCalls, 100, "Calls with a published configuration are spoofed")
+        XCTAssertEqual(stats.latencyHistogram.reduce(0) { $0 + $1.count }, 100, "Every call should land in a latency bucket")
+    }
+    
+    func testLatencyHistogramReachesSeconds() {
+        let bounds = (0..<UInt32(PH_STATS_HISTOGRAM_BUCKETS)).map { ph_stats_bucket_lower_bound($0) }
+        XCTAssertEqual(bounds[0..<16], ArraySlice((0..<16).map { UInt64($0) }))
+        XCTAssertTrue(zip(bounds, bounds.dropFirst()).allSatisfy { $0 < $1 }, "Bounds should strictly increase")
+        // Slow calls spread over buckets instead of piling into the last
+        XCTAssertEqual(bounds.last, 7 << 29, "The last bucket should start at 3.76 s")
+        XCTAssertEqual(bounds.filter { $0 >= 65_536 }.count, 64)
+    }
+    
+    func testEventStreamDeliversHookedCalls() throws {
+        try hookManager.initialize()
+        try hookManager.enableEventExport()
+        
+        var config = SyscallHookConfiguration()
+        config.hooks.getuid = true
+        config.fakeData.userId = 4242
+        try hookManager.updateConfiguration(config)
+        
+        let installedHooks = try hookManager.installConfiguredHooks()
+        let handle = try XCTUnwrap(installedHooks["getuid"])
+        defer { XCTAssertNoThrow(try hookManager.removeHook(handle)) }
+        
+        // Map our own region, as the monitoring engine would for a target
+        let stream = try HookEventStream(processID: getpid())
+        while stream.drain({ _, _ in }) > 0 {}
+        
+        for _ in 0..<100 {
+            _ = getuid()
+        }
+        
+        var names: [String] = []
+        var returnValues: [Int64] = []
+        while stream.drain({ name, record in
+            names.append(name)
+            returnValues.append(record.returnValue)
+        }) > 0 {}
+        
+        XCTAssertEqual(names.count, 100, "Every hooked call should be published")
+        XCTAssertTrue(names.allSatisfy { $0 == "getuid" })
+        XCTAssertTrue(returnValues.allSatisfy { $0 == 4242 }, "Records should carry the spoofed return value")
+        XCTAssertEqual(stream.droppedCount, 0)
+    }
+    
+    func testEventFilterDropsUnmatchedCalls() throws {
+        try hookManager.initialize()
+        try hookManager.enableEventExport()
+        
+        var config = SyscallHookConfiguration()
+        config.hooks.getuid = true
+        config.hooks.getgid = true
+        try hookManager.updateConfiguration(config)
+        
+        let installedHooks = try hookManager.installConfiguredHooks()
+        defer { XCTAssertNoThrow(try hookManager.removeAllHooks()) }
+        XCTAssertEqual(installedHooks.count, 2)
+        
+        let stream = try HookEventStream(processID: getpid())
+        defer { stream.clearFilter() }
+        try stream.setFilter([
+            HookEventStream.FilterRule(syscalls: ["getuid", "open"], allowedPathPrefixes: ["/Users"], blockedPathPrefixes: ["/Users/Shared"])
+        ])
+        while stream.drain({ _, _ in }) > 0 {}
+        
+        for _ in 0..<10 {
+            _ = getuid()
+            _ = getgid()
+        }
+        
+        var names: [String] = []
+        while stream.drain({ name, _ in names.append(name) }) > 0 {}
+        XCTAssertEqual(names, Array(repeating: "getuid", count: 10), "Calls no rule matches should not be published")
+        
+        XCTAssertTrue(stream.filterMatches(syscall: "open", path: "/Users/me/file"))
+        XCTAssertFalse(stream.filterMatches(syscall: "open", path: "/Users/Shared/file"))
+        XCTAssertFalse(stream.filterMatches(syscall: "open", path: "/etc/hosts"))
+        XCTAssertFalse(stream.filterMatches(syscall: "getgid"))
+        
+        stream.clearFilter()
+        XCTAssertTrue(stream.filterMatches(syscall: "getgid"))
+    }
+    
+    func testEventRecordsCarryTheCallPath() throws {
+        try hookManager.initialize()
+        try hookManager.enableEventExport()
+        try hookManager.enableInheritance(libraryPath: "/usr/lib/libSystem.B.dylib")
+        
+        let stream = try HookEventStream(processID: getpid())
+        while stream.drain({ _, _ in }) > 0 {}
+        
+        // Neither binary exists, so the spawns fail after being published
+        let shortPath = "/nonexistent/privarion-event-probe"
+        let longPath = "/nonexistent/" + String(repeating: "p", count: 200)
+        for path in [shortPath, longPath] {
+            var pid: pid_t = 0
+            let arguments = [strdup(path), nil]
+            defer { arguments.forEach { free($0) } }
+            XCTAssertNotEqual(posix_spawn(&pid, path, nil, nil, arguments, environ), 0)
+        }
+        
+        var events: [HookEventStream.Event] = []
+        while stream.drain({ name, event in
+            if name == "posix_spawn" {
+                events.append(event)
+            }
+        }) > 0 {}
+        
+        XCTAssertEqual(events.count, 2)
+        XCTAssertEqual(events.first?.argument, shortPath)
+        XCTAssertEqual(events.first?.argumentIsPath, true)
+        XCTAssertEqual(events.first?.argumentTruncated, false)
+        XCTAssertEqual(events.last?.argument, String(longPath.prefix(HookEventStream.Event.maxArgumentLength)))
+        XCTAssertEqual(events.last?.argumentTruncated, true, "A path longer than the record should be cut, not dropped")
+    }
+    
+    func testSpawnedProcessesInheritHookEnvironment() throws {
+        // The variables are captured once per process, so set them first;
+        // libSystem is always loaded, which makes it a harmless insert
+        let profilePath = FileManager.default.temporaryDirectory.appendingPathComponent("privarion-inherited-profiles.bin").path
+        setenv(HookProfileTable.pathEnvironmentKey, profilePath, 1)
+        try hookManager.enableInheritance(libraryPath: "/usr/lib/libSystem.B.dylib")
+        XCTAssertTrue(hookManager.isInheritanceEnabled)
+        
+        var descriptors: [Int32] = [0, 0]
+        XCTAssertEqual(pipe(&descriptors), 0)
+        var actions: posix_spawn_file_actions_t?
+        posix_spawn_file_actions_init(&actions)
+        defer { posix_spawn_file_actions_destroy(&actions) }
+        posix_spawn_file_actions_adddup2(&actions, descriptors[1], STDOUT_FILENO)
+        posix_spawn_file_actions_addclose(&actions, descriptors[0])
+        
+        // An explicit environment without any hook variables, as a helper
+        // launcher that builds its own would pass
+        let arguments = [strdup("/usr/bin/env"), nil]
+        let environment = [strdup("PRIVARION_TEST=1"), nil]
+        defer { (arguments + environment).forEach { free($0) } }
+        var pid: pid_t = 0
+        XCTAssertEqual(posix_spawn(&pid, "/usr/bin/env", &actions, nil, arguments, environment), 0)
+        close(descriptors[1])
+        
+        let output = FileHandle(fileDescriptor: descriptors[0], closeOnDealloc: true).readDataToEndOfFile()
+        var status: Int32 = 0
+        waitpid(pid, &status, 0)
+        
+        // A protected binary has DYLD_* removed by dyld, so only the
+        // PRIVARION_HOOK_* variables are visible to it
+        let variables = Set(String(decoding: output, as: UTF8.self).split(separator: "\n").map(String.init))
+        XCTAssertTrue(variables.contains("PRIVARION_TEST=1"), "The caller's variables should be kept")
+        XCTAssertTrue(variables.contains("\(HookProfileTable.pathEnvironmentKey)=\(profilePath)"),
+                      "The child should find the same profile table")
+    }
+
+    func testOversizedEnvironmentIsPassedThroughUnchanged() throws {
+        let profilePath = FileManager.default.temporaryDirectory.appendingPathComponent("privarion-inherited-profiles.bin").path
+        setenv(HookProfileTable.pathEnvironmentKey, profilePath, 1)
+        try hookManager.enableInheritance(libraryPath: "/usr/lib/libSystem.B.dylib")
+        
+        var descriptors: [Int32] = [0, 0]
+        XCTAssertEqual(pipe(&descriptors), 0)
+        var actions: posix_spawn_file_actions_t?
+        posix_spawn_file_actions_init(&actions)
+        defer { posix_spawn_file_actions_destroy(&actions) }
+        posix_spawn_file_actions_adddup2(&actions, descriptors[1], STDOUT_FILENO)
+        posix_spawn_file_actions_addclose(&actions, descriptors[0])
+        
+        // More variables than the replacement rebuilds on its stack
+        let arguments = [strdup("/usr/bin/env"), nil]
+        let environment = (0..<2000).map { strdup("PRIVARION_TEST_\($0)=1") } + [nil]
+        defer { (arguments + environment).forEach { free($0) } }
+        var pid: pid_t = 0
+        XCTAssertEqual(posix_spawn(&pid, "/usr/bin/env", &actions, nil, arguments, environment), 0)
+        close(descriptors[1])
+        
+        let output = FileHandle(fileDescriptor: descriptors[0], closeOnDealloc: true).readDataToEndOfFile()
+        var status: Int32 = 0
+        waitpid(pid, &status, 0)
+        
+        let variables = String(decoding: output, as: UTF8.self).split(separator: "\n").map(String.init)
+        XCTAssertEqual(variables.count, 2000, "The caller's environment should reach the child as passed")
+        XCTAssertFalse(variables.contains("\(HookProfileTable.pathEnvironmentKey)=\(profilePath)"))
+    }
+
     // MARK: - Hook Removal Tests
     
     func testHookRemoval() throws {
@@ -185,6 +629,91 @@ final class PrivarionHookTests: XCTestCase {
         XCTAssertEqual(activeHooks.count, 0, "Should report no active hooks")
     }
     
+    func testBatchHookRemoval() throws {
+        try hookManager.initialize()
+        
+        var config = SyscallHookConfiguration()
+        config.hooks.getuid = true
+        config.hooks.getgid = true
+        config.hooks.gethostname = true
+        try hookManager.updateConfiguration(config)
+        
+        let installedHooks = try hookManager.installConfiguredHooks()
+        XCTAssertEqual(hookManager.activeHookCount, 3, "Batch install should activate every configured hook")
+        
+        // A batch containing an unknown handle must not remove anything
+        var mockRawHandle = PHookHandle()
+        mockRawHandle.id = 99999
+        mockRawHandle.is_valid = true
+        strncpy(&mockRawHandle.function_name.0, "nonexistent", 255)
+        let invalidHandle = SyscallHookManager.HookHandle(rawHandle: mockRawHandle)
+        
+        XCTAssertThrowsError(try hookManager.removeHooks(Array(installedHooks.values) + [invalidHandle]))
+        XCTAssertEqual(hookManager.activeHookCount, 3, "Failed batch removal should leave all hooks installed")
+        
+        try hookManager.removeHooks(Array(installedHooks.values))
+        XCTAssertEqual(hookManager.activeHookCount, 0, "Batch removal should remove every hook")
+    }
+    
+    func testBatchSkipsUnloadedSymbols() throws {
+        try hookManager.initialize()
+        
+        // Stands in for IOKit's registry call in a host that never loaded it
+        typealias GetuidFunction = @convention(c) () -> uid_t
+        let replacement: GetuidFunction = { 0 }
+        let names = [strdup("getuid"), strdup("ph_test_unloaded_symbol")]
+        defer { names.forEach { free($0) } }
+        let specs = [
+            PHookSpec(function_name: UnsafePointer(names[0]), replacement_function: nil),
+            PHookSpec(function_name: UnsafePointer(names[1]),
+                      replacement_function: unsafeBitCast(replacement, to: UnsafeMutableRawPointer.self))
+        ]
+        var handles = [PHookHandle](repeating: PHookHandle(), count: specs.count)
+        
+        // The all-or-nothing batch rolls back the resolvable hook with it
+        XCTAssertEqual(ph_install_hooks(specs, specs.count, &handles), PH_ERROR_FUNCTION_NOT_FOUND)
+        XCTAssertFalse(ph_is_hooked("getuid"))
+        
+        XCTAssertEqual(ph_install_loaded_hooks(specs, specs.count, &handles), PH_SUCCESS)
+        XCTAssertTrue(handles[0].is_valid)
+        XCTAssertFalse(handles[1].is_valid, "The unloaded symbol should be left out")
+        XCTAssertTrue(ph_is_hooked("getuid"))
+        XCTAssertFalse(ph_is_hooked("ph_test_unloaded_symbol"))
+        XCTAssertEqual(ph_remove_hook(&handles[0]), PH_SUCCESS)
+    }
+    
+    func testHookChurnReusesArenaStorage() throws {
+        try hookManager.initialize()
+        
+        var config = SyscallHookConfiguration()
+        config.hooks.getuid = true
+        config.hooks.getgid = true
+        try hookManager.updateConfiguration(config)
+        
+        // The first round interns the names and carves out the journals
+        try hookManager.removeHooks(Array(hookManager.installConfiguredHooks().values))
+        var settled = PHArenaStats()
+        ph_get_arena_stats(&settled)
+        XCTAssertGreaterThan(settled.reserved_bytes, 0)
+        XCTAssertEqual(settled.journal_bytes_live, 0, "Removed hooks should hand their journals back")
+        
+        for _ in 0..<20 {
+            try hookManager.removeHooks(Array(hookManager.installConfiguredHooks().values))
+        }
+        var churned = PHArenaStats()
+        ph_get_arena_stats(&churned)
+        XCTAssertEqual(churned.name_bytes_used, settled.name_bytes_used, "Reinstalled hooks should reuse their interned names")
+        XCTAssertEqual(churned.journal_bytes_used, settled.journal_bytes_used, "Reinstalled hooks should reuse freed journals")
+        XCTAssertEqual(churned.journal_bytes_live, 0)
+        
+        // Cleanup releases the whole arena at once
+        hookManager.cleanup()
+        var released = PHArenaStats()
+        ph_get_arena_stats(&released)
+        XCTAssertEqual(released.name_bytes_used, 0)
+        XCTAssertEqual(released.journal_bytes_used, 0)
+    }
+    
     func testInvalidHookRemoval() throws {
         try hookManager.initialize()
         
@@ -208,6 +737,76 @@ final class PrivarionHookTests: XCTestCase {
         }
     }
     
+    // MARK: - Registry Tests
+    
+    /// Slot index carried in the low bits of a hook ID
+    private func slot(of handle: PHookHandle) -> UInt32 {
+        return handle.id & 0x3FF
+    }
+    
+    /// Install built-in replacements straight through the C batch API
+    private func installBuiltins(_ names: [String]) throws -> [PHookHandle] {
+        let cNames = names.compactMap { strdup($0) }
+        defer { cNames.forEach { free($0) } }
+        let specs = cNames.map { PHookSpec(function_name: UnsafePointer($0), replacement_function: nil) }
+        var handles = [PHookHandle](repeating: PHookHandle(), count: specs.count)
+        XCTAssertEqual(ph_install_hooks(specs, specs.count, &handles), PH_SUCCESS)
+        return handles
+    }
+    
+    func testHandleFindsItsHookByID() throws {
+        try hookManager.initialize()
+        var handle = try XCTUnwrap(try installBuiltins(["getuid"]).first)
+        defer { XCTAssertEqual(ph_remove_hook(&handle), PH_SUCCESS) }
+        
+        XCTAssertNotNil(ph_get_original(&handle), "The handle's ID should locate the entry")
+        
+        // The right name in another slot, or the right slot under another generation, finds nothing
+        var otherSlot = handle
+        otherSlot.id = (handle.id & ~0x3FF) | ((slot(of: handle) + 1) & 0x3FF)
+        var otherGeneration = handle
+        otherGeneration.id = handle.id &+ 0x400
+        for var forged in [otherSlot, otherGeneration] {
+            XCTAssertNil(ph_get_original(&forged))
+            XCTAssertEqual(ph_remove_hook(&forged), PH_ERROR_NOT_HOOKED)
+        }
+        XCTAssertTrue(ph_is_hooked("getuid"))
+    }
+    
+    func testStaleHandleIsRejectedAfterReinstall() throws {
+        try hookManager.initialize()
+        var stale = try XCTUnwrap(try installBuiltins(["getuid"]).first)
+        XCTAssertEqual(ph_remove_hook(&stale), PH_SUCCESS)
+        
+        var current = try XCTUnwrap(try installBuiltins(["getuid"]).first)
+        XCTAssertEqual(slot(of: current), slot(of: stale), "A freed slot should be reused")
+        XCTAssertNotEqual(current.id, stale.id, "A reused slot should carry a new generation")
+        
+        XCTAssertNil(ph_get_original(&stale))
+        XCTAssertEqual(ph_remove_hook(&stale), PH_ERROR_NOT_HOOKED, "A stale handle must not remove the new hook")
+        XCTAssertTrue(ph_is_hooked("getuid"))
+        XCTAssertEqual(ph_remove_hook(&current), PH_SUCCESS)
+        XCTAssertFalse(ph_is_hooked("getuid"))
+    }
+    
+    func testRegistryStaysConsistentAcrossChurn() throws {
+        try hookManager.initialize()
+        var slots = Set<UInt32>()
+        var ids = Set<UInt32>()
+        
+        for _ in 0..<500 {
+            var handles = try installBuiltins(["getuid", "getgid", "gethostname"])
+            XCTAssertTrue(ph_is_hooked("getuid") && ph_is_hooked("getgid") && ph_is_hooked("gethostname"))
+            handles.forEach { slots.insert(slot(of: $0)); ids.insert($0.id) }
+            XCTAssertEqual(ph_remove_hooks(&handles, handles.count), PH_SUCCESS)
+            XCTAssertFalse(ph_is_hooked("getuid") || ph_is_hooked("getgid") || ph_is_hooked("gethostname"))
+        }
+        
+        XCTAssertLessThanOrEqual(slots.count, 3, "Churn should keep reusing the same slots")
+        XCTAssertEqual(ids.count, 1500, "Every install should mint a fresh ID")
+        XCTAssertFalse(ph_is_hooked("uname"), "Names never installed should stay unhooked")
+    }
+    
     // MARK: - Error Handling Tests
     
     func testUninitializedSystemError() {
@@ -57,6 +57,7 @@ final class PacketFilterTests: XCTestCase {
         XCTAssertEqual(destination?.ip, "192.168.1.100")
         XCTAssertEqual(destination?.port, 443)
         XCTAssertEqual(destination?.networkProtocol, .tcp)
+        XCTAssertEqual(destination?.address, IPPrefixTree.Address(ipv4: 0xC0A8_0164))
     }
     
     /// Test extracting destination from valid IPv6 packet
@@ -264,6 +265,131 @@ final class PacketFilterTests: XCTestCase {
         }
     }
     
+    /// Test that a cached flow verdict is applied to the packet being filtered
+    /// Requirement: 3.6, 18.2
+    func testCachedVerdictForwardsCurrentPacket() async {
+        var first = makeTCPPacket(destination: [1, 1, 1, 1], sourcePort: 50000)
+        first[39] = 0xAA
+        var second = first
+        second[39] = 0xBB
+        
+        _ = await packetFilter.filterPacket(first, protocol: 4)
+        let result = await packetFilter.filterPacket(second, protocol: 4)
+        
+        guard case .allow(let data) = result else {
+            return XCTFail("Should allow packet through")
+        }
+        XCTAssertEqual(data, second, "A cache hit should forward the packet being filtered")
+    }
+    
+    /// Test that a batch evaluates each flow once
+    /// Requirement: 18.2
+    func testBatchEvaluatesEachFlowOnce() {
+        let packets = (0..<12).map { index in
+            makeTCPPacket(destination: [1, 1, 1, 1], sourcePort: 50000 + UInt16(index % 3))
+        }
+        
+        let results = packetFilter.filterPackets(packets)
+        
+        XCTAssertEqual(results.count, packets.count)
+        XCTAssertEqual(packetFilter.cachedFlowCount, 3, "Each 5-tuple should be cached once")
+        for (packet, result) in zip(packets, results) {
+            guard case .allow(let data) = result else {
+                return XCTFail("Should allow packet through")
+            }
+            XCTAssertEqual(data, packet)
+        }
+        
+        packetFilter.clearCache()
+        XCTAssertEqual(packetFilter.cachedFlowCount, 0)
+    }
+    
+    /// Test that blocklist changes invalidate cached verdicts
+    /// Requirement: 3.7
+    func testBlocklistChangeInvalidatesCachedVerdict() {
+        let blocklistManager = PrivarionNetworkExtension.BlocklistManager()
+        let filter = PacketFilter(
+            policyEngine: ProtectionPolicyEngine(),
+            blocklistManager: blocklistManager,
+            dnsFilter: DNSFilter()
+        )
+        let packet = makeTCPPacket(destination: [203, 0, 113, 7], sourcePort: 50000)
+        
+        guard case .allow = filter.filterPackets([packet])[0] else {
+            return XCTFail("Should allow packet before the range is blocked")
+        }
+        
+        blocklistManager.addBlockedAddress("203.0.113.0/24")
+        guard case .drop = filter.filterPackets([packet])[0] else {
+            return XCTFail("Should drop packet once its range is blocked")
+        }
+        
+        blocklistManager.removeBlockedAddress("203.0.113.0/24")
+        guard case .allow = filter.filterPackets([packet])[0] else {
+            return XCTFail("Should allow packet again once the range is removed")
+        }
+    }
+    
+    /// Test binary flow key parsing
+    func testFlowKeyParsing() throws {
+        var packet = makeTCPPacket(destination: [192, 168, 1, 100], sourcePort: 50000)
+        packet[12] = 10
+        packet[13] = 0
+        packet[14] = 0
+        packet[15] = 2
+        
+        let key = try XCTUnwrap(FlowKey(packet: packet))
+        XCTAssertEqual(key.source, IPPrefixTree.Address("10.0.0.2"))
+        XCTAssertEqual(key.destination, IPPrefixTree.Address("192.168.1.100"))
+        XCTAssertEqual(key.sourcePort, 50000)
+        XCTAssertEqual(key.destinationPort, 443)
+        XCTAssertEqual(key.protocolNumber, 6)
+        
+        // A later fragment carries payload where the ports would be
+        packet[6] = 0x00
+        packet[7] = 0xB9
+        let fragment = try XCTUnwrap(FlowKey(packet: packet))
+        XCTAssertEqual(fragment.sourcePort, 0)
+        XCTAssertEqual(fragment.destinationPort, 0)
+        
+        var ipv6 = Data(count: 60)
+        ipv6[0] = 0x60
+        ipv6[6] = 17
+        ipv6[24] = 0x20
+        ipv6[25] = 0x01
+        ipv6[39] = 0x01
+        ipv6[42] = 0x00
+        ipv6[43] = 0x35
+        let ipv6Key = try XCTUnwrap(FlowKey(packet: ipv6))
+        XCTAssertEqual(ipv6Key.destination, IPPrefixTree.Address("2001::1"))
+        XCTAssertEqual(ipv6Key.destinationPort, 53)
+        XCTAssertEqual(ipv6Key.protocolNumber, 17)
+        
+        XCTAssertNil(FlowKey(packet: Data(count: 10)))
+    }
+    
+    /// Test that a full flow table evicts instead of growing
+    func testFlowTableEvictsWithinCapacity() throws {
+        let table = FlowTable(capacity: 16)
+        let keys = (0..<64).map { index in
+            FlowKey(
+                source: IPPrefixTree.Address(ipv4: 0x0A00_0002),
+                destination: IPPrefixTree.Address(ipv4: 0x0101_0101),
+                sourcePort: UInt16(40000 + index),
+                destinationPort: 443,
+                protocolNumber: 6
+            )
+        }
+        for key in keys {
+            _ = table.lookup([key], generation: 1)
+            table.insert([(key: key, verdict: .drop)], generation: 1)
+        }
+        
+        XCTAssertLessThanOrEqual(table.count, table.capacity)
+        XCTAssertEqual(table.lookup([keys.last], generation: 1), [.drop], "The newest flow should survive eviction")
+        XCTAssertEqual(table.lookup([keys.last], generation: 2), [nil], "Verdicts from older rules should miss")
+    }
+    
     /// Test filtering performance
     /// Requirement: 18.2 (packet processing latency <10ms)
     func testFilteringPerformance() async {
@@ -315,6 +441,23 @@ final class PacketFilterTests: XCTestCase {
         XCTAssertNotNil(destination)
     }
     
+    // MARK: - Helpers
+    
+    /// Build a 40-byte IPv4/TCP packet
+    private func makeTCPPacket(destination: [UInt8], sourcePort: UInt16) -> Data {
+        var packet = Data(count: 40)
+        packet[0] = 0x45
+        packet[9] = 6
+        for (index, byte) in destination.enumerated() {
+            packet[16 + index] = byte
+        }
+        packet[20] = UInt8(sourcePort >> 8)
+        packet[21] = UInt8(sourcePort & 0xFF)
+        packet[22] = 0x01
+        packet[23] = 0xBB // Port 443
+        return packet
+    }
+    
     // MARK: - NetworkDestination Tests
     
     /// Test NetworkDestination initialization
@@ -328,5 +471,6 @@ final class PacketFilterTests: XCTestCase {
         XCTAssertEqual(destination.ip, "192.168.1.1")
         XCTAssertEqual(destination.port, 443)
         XCTAssertEqual(destination.networkProtocol, .tcp)
+        XCTAssertEqual(destination.address, IPPrefixTree.Address("192.168.1.1"))
     }
 }
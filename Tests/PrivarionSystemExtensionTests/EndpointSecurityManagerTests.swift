@@ -317,6 +317,87 @@ final class ESAuthResultExtensionTests: XCTestCase {
     }
 }
 
+// MARK: - Event Dispatcher Tests
+
+final class ESEventDispatcherTests: XCTestCase {
+    
+    func testShardIndexKeepsProcessOnOneShard() {
+        // Test that every event of a process lands on the same shard
+        let exec = ESEventDispatcher.shardIndex(processID: 4242, eventType: ES_EVENT_TYPE_AUTH_EXEC, key: .processID, shardCount: 8)
+        let write = ESEventDispatcher.shardIndex(processID: 4242, eventType: ES_EVENT_TYPE_NOTIFY_WRITE, key: .processID, shardCount: 8)
+        XCTAssertEqual(exec, write)
+        XCTAssertEqual(exec, 4242 % 8)
+        
+        // Keyed by event type, the process no longer matters
+        let first = ESEventDispatcher.shardIndex(processID: 1, eventType: ES_EVENT_TYPE_AUTH_EXEC, key: .eventType, shardCount: 8)
+        let second = ESEventDispatcher.shardIndex(processID: 2, eventType: ES_EVENT_TYPE_AUTH_EXEC, key: .eventType, shardCount: 8)
+        XCTAssertEqual(first, second)
+        XCTAssertLessThan(first, 8)
+    }
+    
+    func testShardQueueServesAuthBeforeNotify() async {
+        // Test that a NOTIFY backlog never delays a later AUTH item
+        let queue = PriorityShardQueue<Int>(backlogLimit: 100)
+        for value in 1...5 {
+            queue.enqueue(value, urgent: false)
+        }
+        queue.enqueue(100, urgent: true)
+        queue.close()
+        
+        var order: [Int] = []
+        while let value = await queue.next() {
+            order.append(value)
+        }
+        XCTAssertEqual(order, [100, 1, 2, 3, 4, 5])
+    }
+    
+    func testShardQueueDropsNotifyBeyondBacklog() {
+        // Test that only NOTIFY items are subject to the backlog limit
+        let queue = PriorityShardQueue<Int>(backlogLimit: 2)
+        XCTAssertTrue(queue.enqueue(1, urgent: false))
+        XCTAssertTrue(queue.enqueue(2, urgent: false))
+        XCTAssertFalse(queue.enqueue(3, urgent: false))
+        XCTAssertTrue(queue.enqueue(4, urgent: true))
+        XCTAssertEqual(queue.count, 3)
+    }
+    
+    func testShardQueueWakesWaitingWorker() async {
+        // Test that a worker suspended on an empty queue is resumed
+        let queue = PriorityShardQueue<Int>(backlogLimit: 10)
+        let worker = Task { await queue.next() }
+        
+        try? await Task.sleep(nanoseconds: 10_000_000)
+        queue.enqueue(7, urgent: true)
+        
+        let value = await worker.value
+        XCTAssertEqual(value, 7)
+    }
+
+    func testClosedShardQueueRejectsNewItems() async {
+        // Test that nothing is queued where no worker will take it
+        let queue = PriorityShardQueue<Int>(backlogLimit: 10)
+        XCTAssertTrue(queue.enqueue(1, urgent: true))
+        queue.close()
+        XCTAssertFalse(queue.enqueue(2, urgent: true))
+        XCTAssertFalse(queue.enqueue(3, urgent: false))
+
+        let drained = await queue.next()
+        XCTAssertEqual(drained, 1)
+        let end = await queue.next()
+        XCTAssertNil(end)
+    }
+
+    func testStopAndDrainWaitsForWorkers() {
+        // Test that draining returns once every shard worker has exited
+        let processor = SecurityEventProcessor(policyEngine: ProtectionPolicyEngine())
+        let dispatcher = ESEventDispatcher(processor: processor, shardCount: 4)
+        XCTAssertFalse(dispatcher.isStopped)
+
+        dispatcher.stopAndDrain()
+        XCTAssertTrue(dispatcher.isStopped)
+    }
+}
+
 // MARK: - Integration Tests for EndpointSecurityManager
 
 final class EndpointSecurityManagerIntegrationTests: XCTestCase {
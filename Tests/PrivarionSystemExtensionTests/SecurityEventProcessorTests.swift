@@ -204,6 +204,168 @@ final class SecurityEventProcessorTests: XCTestCase {
         // Then - should initialize without error
         XCTAssertNotNil(processor, "Processor should initialize with custom logger")
     }
+    
+    // MARK: - Decision Cache Tests
+    
+    func testDecisionCacheStoresAndInvalidatesVerdicts() throws {
+        // Given
+        let cache = try XCTUnwrap(AuthDecisionCache())
+        let cdhash = [UInt8](repeating: 0xAB, count: 20)
+        let generation = cache.generation
+        
+        // When
+        cache.store(.exec, path: "/usr/bin/make", cdhash: cdhash, teamID: "", allow: true, generation: generation)
+        cache.store(.open, path: "/etc/hosts", cdhash: cdhash, teamID: "TEAM123", allow: false, generation: generation)
+        
+        // Then - verdicts are keyed on kind, path, cdhash and team
+        XCTAssertEqual(cache.verdict(for: .exec, path: "/usr/bin/make", cdhash: cdhash, teamID: ""), true)
+        XCTAssertEqual(cache.verdict(for: .open, path: "/etc/hosts", cdhash: cdhash, teamID: "TEAM123"), false)
+        XCTAssertNil(cache.verdict(for: .open, path: "/usr/bin/make", cdhash: cdhash, teamID: ""))
+        XCTAssertNil(cache.verdict(for: .exec, path: "/usr/bin/make", cdhash: [UInt8](repeating: 0, count: 20), teamID: ""))
+        
+        // When - policies change
+        cache.invalidate()
+        
+        // Then - nothing is answered and late verdicts are dropped
+        XCTAssertNil(cache.verdict(for: .exec, path: "/usr/bin/make", cdhash: cdhash, teamID: ""))
+        cache.store(.exec, path: "/usr/bin/make", cdhash: cdhash, teamID: "", allow: true, generation: generation)
+        XCTAssertNil(cache.verdict(for: .exec, path: "/usr/bin/make", cdhash: cdhash, teamID: ""))
+        
+        let stats = cache.statistics
+        XCTAssertEqual(stats.stores, 2)
+        XCTAssertEqual(stats.staleStores, 1)
+        XCTAssertEqual(stats.hits, 2)
+    }
+    
+    func testDecisionCacheKeysOnActingProcessAndAccessMode() throws {
+        // Given - unsigned processes share a zero cdhash and an empty team
+        let cache = try XCTUnwrap(AuthDecisionCache())
+        let unsigned = [UInt8](repeating: 0, count: 20)
+        let readOnly: Int32 = 0x1   // FREAD
+        let readWrite: Int32 = 0x3  // FREAD | FWRITE
+        let generation = cache.generation
+
+        // When
+        cache.store(.exec, path: "/bin/ls", cdhash: unsigned, teamID: "", processPath: "/usr/local/bin/blocked",
+                    allow: false, generation: generation)
+        cache.store(.open, path: "/etc/hosts", cdhash: unsigned, teamID: "", processPath: "/usr/local/bin/reader",
+                    fflag: readOnly, allow: true, generation: generation)
+
+        // Then - another caller or another access mode is a different key
+        XCTAssertEqual(cache.verdict(for: .exec, path: "/bin/ls", cdhash: unsigned, teamID: "", processPath: "/usr/local/bin/blocked"), false)
+        XCTAssertNil(cache.verdict(for: .exec, path: "/bin/ls", cdhash: unsigned, teamID: "", processPath: "/usr/bin/env"))
+        XCTAssertEqual(cache.verdict(for: .open, path: "/etc/hosts", cdhash: unsigned, teamID: "", processPath: "/usr/local/bin/reader", fflag: readOnly), true)
+        XCTAssertNil(cache.verdict(for: .open, path: "/etc/hosts", cdhash: unsigned, teamID: "", processPath: "/usr/local/bin/reader", fflag: readWrite))
+        XCTAssertNil(cache.verdict(for: .open, path: "/etc/hosts", cdhash: unsigned, teamID: "", processPath: "/usr/local/bin/other", fflag: readOnly))
+    }
+
+    func testPolicyChangeInvalidatesDecisionCache() async throws {
+        // Given
+        let cache = try XCTUnwrap(processor.decisionCache)
+        let generation = cache.generation
+        let cdhash = [UInt8](repeating: 0x01, count: 20)
+        cache.store(.exec, path: "/Applications/Test.app/Contents/MacOS/Test", cdhash: cdhash, teamID: "", allow: true, generation: generation)
+        
+        // When
+        policyEngine.addPolicy(ProtectionPolicy(
+            identifier: "/Applications/Test.app",
+            protectionLevel: .paranoid,
+            networkFiltering: NetworkFilteringRules(action: .block, allowedDomains: [], blockedDomains: []),
+            dnsFiltering: DNSFilteringRules(),
+            hardwareSpoofing: .none,
+            requiresVMIsolation: false
+        ))
+        _ = policyEngine.getAllPolicies() // Waits for the update barrier
+        
+        // Then
+        XCTAssertNotEqual(cache.generation, generation)
+        XCTAssertNil(cache.verdict(for: .exec, path: "/Applications/Test.app/Contents/MacOS/Test", cdhash: cdhash, teamID: ""))
+        
+        // Registering a handler also drops verdicts reached without it
+        let afterPolicy = cache.generation
+        await processor.registerHandler(MockSecurityEventHandler())
+        XCTAssertNotEqual(cache.generation, afterPolicy)
+    }
+
+    // MARK: - Trace Replay Tests
+
+    private func addParanoidTestAppPolicy() {
+        policyEngine.addPolicy(ProtectionPolicy(
+            identifier: "/Applications/Test.app",
+            protectionLevel: .paranoid,
+            networkFiltering: NetworkFilteringRules(action: .block, allowedDomains: [], blockedDomains: []),
+            dnsFiltering: DNSFilteringRules(),
+            hardwareSpoofing: .none,
+            requiresVMIsolation: false
+        ))
+        _ = policyEngine.getAllPolicies() // Waits for the update barrier
+    }
+
+    func testCallersOfSameTargetGetTheirOwnVerdicts() async throws {
+        // Given - a blocked and an unrestricted caller exec the same binary
+        addParanoidTestAppPolicy()
+        let blocked = "/Applications/Test.app/Contents/MacOS/Test"
+        let allowed = "/usr/bin/env"
+        let records = [blocked, allowed, blocked, allowed].enumerated().map { index, caller in
+            ESTraceRecord(eventType: ES_EVENT_TYPE_AUTH_EXEC, pid: Int32(100 + index), ppid: 1,
+                          executablePath: caller, targetPath: "/bin/ls")
+        }
+        let workload = ESTraceReplayWorkload(records: records, processor: processor)
+        let unsigned = [UInt8](repeating: 0, count: 20)
+
+        // When
+        for index in 0..<workload.operationCount {
+            await workload.perform(index)
+        }
+
+        // Then - the second caller is evaluated, not answered with the first's verdict
+        let cache = try XCTUnwrap(processor.decisionCache)
+        XCTAssertEqual(cache.verdict(for: .exec, path: "/bin/ls", cdhash: unsigned, teamID: "", processPath: blocked), false)
+        XCTAssertEqual(cache.verdict(for: .exec, path: "/bin/ls", cdhash: unsigned, teamID: "", processPath: allowed), true)
+        XCTAssertEqual(cache.statistics.stores, 2)
+    }
+
+    func testTraceReplayEvaluatesThenAnswersFromCache() async throws {
+        // Given
+        addParanoidTestAppPolicy()
+        let executable = "/Applications/Test.app/Contents/MacOS/Test"
+        let cdhash = String(repeating: "ab", count: 20)
+        let readOnly: Int32 = 0x1 // FREAD
+        let records = [
+            ESTraceRecord(eventType: ES_EVENT_TYPE_AUTH_EXEC, pid: 4242, ppid: 1, executablePath: executable,
+                          teamID: "TEAM123", cdhash: cdhash, targetPath: "/usr/bin/make", targetCdhash: cdhash),
+            ESTraceRecord(eventType: ES_EVENT_TYPE_AUTH_OPEN, pid: 4242, ppid: 1, executablePath: executable,
+                          teamID: "TEAM123", cdhash: cdhash, targetPath: "/etc/hosts", fflag: readOnly),
+            ESTraceRecord(eventType: ES_EVENT_TYPE_NOTIFY_EXIT, pid: 4242, ppid: 1, executablePath: executable,
+                          targetPath: "")
+        ]
+        let workload = ESTraceReplayWorkload(records: records, processor: processor)
+        let bytes = [UInt8](repeating: 0xAB, count: 20)
+
+        // When
+        for index in 0..<workload.operationCount {
+            await workload.perform(index)
+        }
+
+        // Then - AUTH verdicts are cached under the keys the native handler derives
+        let cache = try XCTUnwrap(processor.decisionCache)
+        XCTAssertEqual(cache.verdict(for: .exec, path: "/usr/bin/make", cdhash: bytes, teamID: "TEAM123", processPath: executable), false)
+        XCTAssertEqual(cache.verdict(for: .open, path: "/etc/hosts", cdhash: bytes, teamID: "TEAM123", processPath: executable, fflag: readOnly), true)
+        XCTAssertEqual(cache.statistics.stores, 2)
+
+        // When - replayed at load, repeats are answered from the cache
+        let report = await LoadReplayHarness().run(workload, profile: LoadProfile(requestsPerSecond: 2000, operations: 60, warmupOperations: 0))
+        XCTAssertEqual(report.completedOperations, 60)
+        XCTAssertEqual(cache.statistics.stores, 2)
+    }
+
+    func testTraceRecordRoundTripsThroughJSON() throws {
+        let record = ESTraceRecord(eventType: ES_EVENT_TYPE_AUTH_EXEC, pid: 7, ppid: 1, executablePath: "/bin/sh",
+                                   cdhash: "00ff10", targetPath: "/usr/bin/make", targetTeamID: "TEAM123")
+        let data = try JSONEncoder().encode([record])
+        XCTAssertEqual(try JSONDecoder().decode([ESTraceRecord].self, from: data), [record])
+        XCTAssertEqual(ESTraceRecord.bytes(fromHex: record.cdhash), [0x00, 0xFF, 0x10])
+    }
 }
 
 // MARK: - Mock Security Event Handler